@@ -78,6 +78,7 @@ typedef struct __DRIdri2ExtensionRec		__DRIdri2Extension;
 typedef struct __DRIdri2LoaderExtensionRec	__DRIdri2LoaderExtension;
 typedef struct __DRI2flushExtensionRec	__DRI2flushExtension;
 typedef struct __DRI2throttleExtensionRec	__DRI2throttleExtension;
+typedef struct __DRI2bufferDamageExtensionRec	__DRI2bufferDamageExtension;
 typedef struct __DRI2fenceExtensionRec          __DRI2fenceExtension;
 typedef struct __DRI2interopExtensionRec	__DRI2interopExtension;
 
@@ -335,6 +336,35 @@ struct __DRI2throttleExtensionRec {
 };
 
 
+/**
+ * Extension for passing the damage accumulated by the application to the
+ * driver, so that a swap only has to present the dirty region of a
+ * drawable instead of its full area.
+ */
+
+#define __DRI2_BUFFER_DAMAGE "DRI2_BufferDamage"
+#define __DRI2_BUFFER_DAMAGE_VERSION 1
+
+struct __DRI2bufferDamageExtensionRec {
+   __DRIextension base;
+
+   /**
+    * Set the damage region for the next swap of \c drawable.
+    *
+    * \param drawable affected drawable
+    * \param nrects   number of rectangles provided
+    * \param rects    the rectangles, as an array of nrects (x, y, width,
+    *                 height) quads with a bottom-left origin, following
+    *                 the convention of EGL_KHR_swap_buffers_with_damage
+    *
+    * The region is consumed by the next buffer swap; passing zero
+    * rectangles restores full-drawable damage.
+    */
+   void (*set_damage_region)(__DRIdrawable *drawable, unsigned int nrects,
+                             int *rects);
+};
+
+
 /**
  * Extension for fences / synchronization objects.
  */
@@ -49,7 +49,7 @@ struct YYLTYPE;
  */
 class ast_node {
 public:
-   DECLARE_RALLOC_CXX_OPERATORS(ast_node);
+   DECLARE_LINEAR_ZALLOC_CXX_OPERATORS(ast_node);
 
    /**
     * Print an AST node in something approximating the original GLSL code
@@ -458,7 +458,7 @@ enum {
 };
 
 struct ast_type_qualifier {
-   DECLARE_RALLOC_CXX_OPERATORS(ast_type_qualifier);
+   DECLARE_LINEAR_ZALLOC_CXX_OPERATORS(ast_type_qualifier);
 
    union {
       struct {
@@ -57,11 +57,20 @@
 #include <stdio.h>
 #include "main/core.h" /* for struct gl_shader */
 #include "main/shaderobj.h"
+#include "util/u_atomic.h"
 #include "ir_builder.h"
+#include "ir_serialize.h"
+#include "shader_cache.h"
 #include "glsl_parser_extras.h"
 #include "program/prog_instruction.h"
 #include <math.h>
 
+#ifndef _WIN32
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #define M_PIf   ((float) M_PI)
 #define M_PI_2f ((float) M_PI_2)
 #define M_PI_4f ((float) M_PI_4)
@@ -528,6 +537,80 @@ barrier_supported(const _mesa_glsl_parse_state *state)
           state->stage == MESA_SHADER_TESS_CTRL;
 }
 
+/**
+ * Every availability predicate above, in one table.
+ *
+ * A serialized image of the built-in shader refers to each signature's
+ * predicate by its index in this table, since function pointers cannot be
+ * stored on disk.  The order may change freely between builds - images are
+ * keyed by the build that wrote them - but must not change at runtime.
+ */
+static const builtin_available_predicate builtin_avail_predicates[] = {
+   always_available,
+   compatibility_vs_only,
+   fs_only,
+   gs_only,
+   v110,
+   v110_fs_only,
+   v120,
+   v130,
+   v130_fs_only,
+   v140_or_es3,
+   v400_fs_only,
+   texture_rectangle,
+   texture_external,
+   lod_exists_in_stage,
+   v110_lod,
+   texture_buffer,
+   shader_texture_lod,
+   shader_texture_lod_and_rect,
+   shader_bit_encoding,
+   shader_integer_mix,
+   shader_packing_or_es3,
+   shader_packing_or_es3_or_gpu_shader5,
+   gpu_shader5,
+   gpu_shader5_es,
+   es31_not_gs5,
+   gpu_shader5_or_es31,
+   shader_packing_or_es31_or_gpu_shader5,
+   fs_interpolate_at,
+   texture_array_lod,
+   fs_texture_array,
+   texture_array,
+   texture_multisample,
+   texture_multisample_array,
+   texture_samples_identical,
+   texture_samples_identical_array,
+   fs_texture_cube_map_array,
+   texture_cube_map_array,
+   texture_query_levels,
+   texture_query_lod,
+   texture_gather,
+   texture_gather_or_es31,
+   texture_gather_only_or_es31,
+   fs_oes_derivatives,
+   fs_derivative_control,
+   tex1d_lod,
+   tex3d,
+   fs_tex3d,
+   tex3d_lod,
+   shader_atomic_counters,
+   shader_atomic_counter_ops,
+   shader_clock,
+   shader_storage_buffer_object,
+   shader_trinary_minmax,
+   shader_image_load_store,
+   shader_image_atomic,
+   shader_image_atomic_exchange_float,
+   shader_image_size,
+   shader_samples,
+   gs_streams,
+   fp64,
+   compute_shader,
+   buffer_atomics_supported,
+   barrier_supported,
+};
+
 /** @} */
 
 /******************************************************************************/
@@ -568,9 +651,23 @@ private:
    ir_variable *gl_Vertex;
 
    void create_shader();
+   void create_builtin_variables();
    void create_intrinsics();
    void create_builtins();
 
+   /**
+    * On-disk image of the built-in shader:
+    *
+    * Building every built-in signature takes a measurable slice of the
+    * first compile in each process, so the finished IR is serialized to
+    * the cache directory and later processes of the same build read it
+    * back instead of reconstructing it.
+    */
+   /*@{*/
+   bool load_cached_image();
+   void save_cached_image();
+   /*@}*/
+
    /**
     * IR builder helpers:
     *
@@ -927,8 +1024,17 @@ builtin_builder::initialize()
 
    mem_ctx = ralloc_context(NULL);
    create_shader();
+
+   /* Reading a serialized image of the built-in shader is much cheaper
+    * than building every signature's IR, so try that first.
+    */
+   if (load_cached_image())
+      return;
+
+   create_builtin_variables();
    create_intrinsics();
    create_builtins();
+   save_cached_image();
 }
 
 void
@@ -950,18 +1056,248 @@ builtin_builder::create_shader()
     */
    shader = _mesa_new_shader(NULL, 0, GL_VERTEX_SHADER);
    shader->symbols = new(mem_ctx) glsl_symbol_table;
+   shader->ir = new(mem_ctx) exec_list;
+}
 
+void
+builtin_builder::create_builtin_variables()
+{
    gl_ModelViewProjectionMatrix =
       new(mem_ctx) ir_variable(glsl_type::mat4_type,
                                "gl_ModelViewProjectionMatrix",
                                ir_var_uniform);
 
+   shader->ir->push_tail(gl_ModelViewProjectionMatrix);
    shader->symbols->add_variable(gl_ModelViewProjectionMatrix);
 
    gl_Vertex = in_var(glsl_type::vec4_type, "gl_Vertex");
+   shader->ir->push_tail(gl_Vertex);
    shader->symbols->add_variable(gl_Vertex);
 }
 
+#ifdef _WIN32
+
+/* The image cache requires POSIX file handling; always rebuild the
+ * built-ins from scratch on other platforms.
+ */
+bool
+builtin_builder::load_cached_image()
+{
+   return false;
+}
+
+void
+builtin_builder::save_cached_image()
+{
+}
+
+#else
+
+#define BUILTIN_CACHE_MAGIC   0x4e544c42  /* 'BLTN' */
+#define BUILTIN_CACHE_VERSION 1
+
+/** Predicate table index written for a signature with no predicate. */
+#define BUILTIN_AVAIL_NONE    0xffffffffu
+
+#ifdef PACKAGE_VERSION
+static const char builtin_cache_build_id[] = "builtin_ir_v1 " PACKAGE_VERSION;
+#else
+static const char builtin_cache_build_id[] = "builtin_ir_v1";
+#endif
+
+static bool
+builtin_cache_path(char *path, size_t size)
+{
+   char dir[PATH_MAX];
+
+   if (getenv("MESA_GLSL_CACHE_DISABLE") != NULL)
+      return false;
+
+   if (!shader_cache_get_dir(dir, sizeof(dir)))
+      return false;
+
+   mkdir(dir, 0755);
+
+   /* One fixed name suffices: the build id stored in the image catches a
+    * stale file from another build, which is then simply rewritten.
+    */
+   return snprintf(path, size, "%s/builtins.bin", dir) < (int) size;
+}
+
+static uint32_t
+builtin_avail_index(builtin_available_predicate avail)
+{
+   if (avail == NULL)
+      return BUILTIN_AVAIL_NONE;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(builtin_avail_predicates); i++) {
+      if (builtin_avail_predicates[i] == avail)
+         return i;
+   }
+
+   assert(!"predicate missing from builtin_avail_predicates");
+   return BUILTIN_AVAIL_NONE;
+}
+
+/**
+ * Try to populate the built-in shader from a serialized image written by an
+ * earlier process of this build.
+ *
+ * The symbol table and member variables are only touched once the whole
+ * image has deserialized and validated, so a failure here leaves the
+ * builder ready for the ordinary create_*() path.
+ */
+bool
+builtin_builder::load_cached_image()
+{
+   char path[PATH_MAX];
+   struct blob_reader blob;
+   uint8_t *data;
+   long size;
+   FILE *f;
+   bool success = false;
+
+   if (!builtin_cache_path(path, sizeof(path)))
+      return false;
+
+   f = fopen(path, "rb");
+   if (f == NULL)
+      return false;
+
+   if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) <= 0 ||
+       fseek(f, 0, SEEK_SET) != 0) {
+      fclose(f);
+      return false;
+   }
+
+   data = (uint8_t *) malloc(size);
+   if (data == NULL || fread(data, 1, size, f) != (size_t) size) {
+      free(data);
+      fclose(f);
+      return false;
+   }
+   fclose(f);
+
+   blob_reader_init(&blob, data, size);
+
+   if (blob_read_uint32(&blob) == BUILTIN_CACHE_MAGIC &&
+       blob_read_uint32(&blob) == BUILTIN_CACHE_VERSION) {
+      char *build_id = blob_read_string(&blob);
+      exec_list ir;
+
+      if (build_id != NULL &&
+          strcmp(build_id, builtin_cache_build_id) == 0 &&
+          deserialize_glsl_ir(&blob, &ir, mem_ctx)) {
+         bool valid = true;
+
+         /* The serializer cannot store the availability predicates, so
+          * each signature's index into builtin_avail_predicates[] follows
+          * the instruction stream, in the same traversal order.
+          */
+         foreach_in_list(ir_instruction, inst, &ir) {
+            ir_function *const func = inst->as_function();
+
+            if (func == NULL)
+               continue;
+
+            foreach_in_list(ir_function_signature, sig, &func->signatures) {
+               uint32_t idx = blob_read_uint32(&blob);
+
+               if (idx == BUILTIN_AVAIL_NONE)
+                  continue;
+
+               if (idx >= ARRAY_SIZE(builtin_avail_predicates)) {
+                  valid = false;
+                  break;
+               }
+               sig->set_builtin_availability(builtin_avail_predicates[idx]);
+            }
+
+            if (!valid)
+               break;
+         }
+
+         if (valid && blob.current == blob.end && !blob.overrun) {
+            foreach_in_list(ir_instruction, inst, &ir) {
+               ir_variable *const var = inst->as_variable();
+               ir_function *const func = inst->as_function();
+
+               if (var != NULL) {
+                  shader->symbols->add_variable(var);
+                  if (strcmp(var->name, "gl_ModelViewProjectionMatrix") == 0)
+                     gl_ModelViewProjectionMatrix = var;
+                  else if (strcmp(var->name, "gl_Vertex") == 0)
+                     gl_Vertex = var;
+               } else if (func != NULL) {
+                  shader->symbols->add_function(func);
+               }
+            }
+            ir.move_nodes_to(shader->ir);
+            success = true;
+         }
+      }
+   }
+
+   free(data);
+   return success;
+}
+
+/**
+ * Serialize the finished built-in shader to the cache directory.
+ */
+void
+builtin_builder::save_cached_image()
+{
+   char path[PATH_MAX];
+   char tmp_path[PATH_MAX];
+
+   if (!builtin_cache_path(path, sizeof(path)))
+      return;
+
+   struct blob *blob = blob_create(NULL);
+   if (blob == NULL)
+      return;
+
+   blob_write_uint32(blob, BUILTIN_CACHE_MAGIC);
+   blob_write_uint32(blob, BUILTIN_CACHE_VERSION);
+   blob_write_string(blob, builtin_cache_build_id);
+
+   serialize_glsl_ir(blob, shader->ir);
+
+   foreach_in_list(ir_instruction, inst, shader->ir) {
+      ir_function *const func = inst->as_function();
+
+      if (func == NULL)
+         continue;
+
+      foreach_in_list(ir_function_signature, sig, &func->signatures) {
+         blob_write_uint32(blob,
+                           builtin_avail_index(sig->get_builtin_availability()));
+      }
+   }
+
+   /* Write to a temporary in the same directory and rename it into place
+    * so that concurrent processes never observe a partial image.
+    */
+   if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.%d",
+                path, (int) getpid()) < (int) sizeof(tmp_path)) {
+      FILE *f = fopen(tmp_path, "wb");
+      if (f != NULL) {
+         if (fwrite(blob->data, 1, blob->size, f) == blob->size) {
+            fclose(f);
+            rename(tmp_path, path);
+         } else {
+            fclose(f);
+            unlink(tmp_path);
+         }
+      }
+   }
+
+   ralloc_free(blob);
+}
+
+#endif /* !_WIN32 */
+
 /** @} */
 
 /**
@@ -2965,6 +3301,7 @@ builtin_builder::add_function(const char *name, ...)
    }
    va_end(ap);
 
+   shader->ir->push_tail(f);
    shader->symbols->add_function(f);
 }
 
@@ -3022,6 +3359,7 @@ builtin_builder::add_image_function(const char *name,
                                  num_arguments, flags));
    }
 
+   shader->ir->push_tail(f);
    shader->symbols->add_function(f);
 }
 
@@ -5584,6 +5922,12 @@ builtin_builder::_shader_clock(builtin_available_predicate avail,
 static builtin_builder builtins;
 static mtx_t builtins_lock = _MTX_INITIALIZER_NP;
 
+/* Set (with the lock held) once \c builtins is completely constructed, so
+ * that the common case - every built-in lookup in every compile - can skip
+ * the lock entirely.  The module is immutable once built.
+ */
+static int builtins_initialized;
+
 /**
  * External API (exposing the built-in module to the rest of the compiler):
  *  @{
@@ -5591,8 +5935,16 @@ static mtx_t builtins_lock = _MTX_INITIALIZER_NP;
 void
 _mesa_glsl_initialize_builtin_functions()
 {
+   /* Lock-free fast path: construction happens at most once per process
+    * and never concurrently with lookups, so an acquire of the flag is
+    * enough to make the module visible to this thread.
+    */
+   if (p_atomic_read(&builtins_initialized))
+      return;
+
    mtx_lock(&builtins_lock);
    builtins.initialize();
+   p_atomic_set(&builtins_initialized, 1);
    mtx_unlock(&builtins_lock);
 }
 
@@ -5600,6 +5952,7 @@ void
 _mesa_glsl_release_builtin_functions()
 {
    mtx_lock(&builtins_lock);
+   p_atomic_set(&builtins_initialized, 0);
    builtins.release();
    mtx_unlock(&builtins_lock);
 }
@@ -5608,21 +5961,19 @@ ir_function_signature *
 _mesa_glsl_find_builtin_function(_mesa_glsl_parse_state *state,
                                  const char *name, exec_list *actual_parameters)
 {
-   ir_function_signature * s;
-   mtx_lock(&builtins_lock);
-   s = builtins.find(state, name, actual_parameters);
-   mtx_unlock(&builtins_lock);
-   return s;
+   /* The built-in module is immutable once constructed, and every caller
+    * initializes it before looking anything up, so no lock is needed here.
+    * Releasing the module while a compile is in flight was never safe -
+    * the signatures handed out point into the module - and remains the
+    * caller's responsibility.
+    */
+   return builtins.find(state, name, actual_parameters);
 }
 
 ir_function *
 _mesa_glsl_find_builtin_function_by_name(const char *name)
 {
-   ir_function *f;
-   mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
-   mtx_unlock(&builtins_lock);
-   return f;
+   return builtins.shader->symbols->get_function(name);
 }
 
 gl_shader *
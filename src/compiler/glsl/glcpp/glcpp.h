@@ -173,6 +173,13 @@ typedef struct active_list {
 
 struct glcpp_parser {
 	yyscan_t scanner;
+
+	/* Linear allocator arena for tokens, token lists, macros and the
+	 * strings they carry.  Everything in it lives exactly as long as
+	 * the parser and is never freed individually, which keeps macro
+	 * expansion free of per-token heap traffic.
+	 */
+	void *linalloc;
 	struct hash_table *defines;
 	active_list_t *active;
 	int lexing_directive;
@@ -65,6 +65,8 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    this->translation_unit.make_empty();
    this->symbols = new(mem_ctx) glsl_symbol_table;
 
+   this->linalloc = linear_alloc_parent(this, 0);
+
    this->info_log = ralloc_strdup(mem_ctx, "");
    this->error = false;
    this->loop_nesting_ast = NULL;
@@ -260,12 +262,12 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    if (ctx->Const.ForceGLSLExtensionsWarn)
       _mesa_glsl_process_extension("all", NULL, "warn", NULL, this);
 
-   this->default_uniform_qualifier = new(this) ast_type_qualifier();
+   this->default_uniform_qualifier = new(this->linalloc) ast_type_qualifier();
    this->default_uniform_qualifier->flags.q.shared = 1;
    this->default_uniform_qualifier->flags.q.column_major = 1;
    this->default_uniform_qualifier->is_default_qualifier = true;
 
-   this->default_shader_storage_qualifier = new(this) ast_type_qualifier();
+   this->default_shader_storage_qualifier = new(this->linalloc) ast_type_qualifier();
    this->default_shader_storage_qualifier->flags.q.shared = 1;
    this->default_shader_storage_qualifier->flags.q.column_major = 1;
    this->default_shader_storage_qualifier->is_default_qualifier = true;
@@ -279,8 +281,8 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    this->gs_input_prim_type_specified = false;
    this->tcs_output_vertices_specified = false;
    this->gs_input_size = 0;
-   this->in_qualifier = new(this) ast_type_qualifier();
-   this->out_qualifier = new(this) ast_type_qualifier();
+   this->in_qualifier = new(this->linalloc) ast_type_qualifier();
+   this->out_qualifier = new(this->linalloc) ast_type_qualifier();
    this->fs_early_fragment_tests = false;
    memset(this->atomic_counter_offsets, 0,
           sizeof(this->atomic_counter_offsets));
@@ -1827,11 +1829,12 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
       assign_subroutine_indexes(shader, state);
       lower_subroutine(shader->ir, state);
       /* Do some optimization at compile time to reduce shader IR size
-       * and reduce later work if the same shader is linked multiple times
+       * and reduce later work if the same shader is linked multiple times.
+       * do_common_optimization iterates internally until it stops making
+       * progress.
        */
-      while (do_common_optimization(shader->ir, false, false, options,
-                                    ctx->Const.NativeIntegers))
-         ;
+      do_common_optimization(shader->ir, false, false, options,
+                             ctx->Const.NativeIntegers);
 
       validate_ir_tree(shader->ir);
 
@@ -1931,77 +1934,123 @@ do_common_optimization(exec_list *ir, bool linked,
                        bool native_integers)
 {
    const bool debug = false;
-   GLboolean progress = GL_FALSE;
+   bool any_progress = false;
+   bool progress;
+
+   /* The pass list below is iterated until it stops making progress.  To
+    * avoid re-walking the whole IR with every pass on every iteration, each
+    * pass records the value the generation counter had when it last ran.
+    * The counter is bumped whenever any pass changes the IR, so a pass is
+    * re-run only if some pass (possibly itself) has made progress since its
+    * last run.  With per-pass dependencies this could be tightened further,
+    * but "anything changed" already collapses the tail iterations where
+    * only one or two passes are still converging.
+    */
+   unsigned generation = 1;
+   unsigned last_ran[32];
+   unsigned pass_num;
+
+   memset(last_ran, 0, sizeof(last_ran));
 
 #define OPT(PASS, ...) do {                                             \
-      if (debug) {                                                      \
-         fprintf(stderr, "START GLSL optimization %s\n", #PASS);        \
-         const bool opt_progress = PASS(__VA_ARGS__);                   \
-         progress = opt_progress || progress;                           \
-         if (opt_progress)                                              \
-            _mesa_print_ir(stderr, ir, NULL);                           \
-         fprintf(stderr, "GLSL optimization %s: %s progress\n",         \
-                 #PASS, opt_progress ? "made" : "no");                  \
-      } else {                                                          \
-         progress = PASS(__VA_ARGS__) || progress;                      \
+      assert(pass_num < ARRAY_SIZE(last_ran));                          \
+      if (last_ran[pass_num] != generation) {                           \
+         last_ran[pass_num] = generation;                               \
+         if (debug) {                                                   \
+            fprintf(stderr, "START GLSL optimization %s\n", #PASS);     \
+            const bool opt_progress = PASS(__VA_ARGS__);                \
+            if (opt_progress) {                                         \
+               progress = true;                                         \
+               generation++;                                            \
+               _mesa_print_ir(stderr, ir, NULL);                        \
+            }                                                           \
+            fprintf(stderr, "GLSL optimization %s: %s progress\n",      \
+                    #PASS, opt_progress ? "made" : "no");               \
+         } else {                                                       \
+            if (PASS(__VA_ARGS__)) {                                    \
+               progress = true;                                         \
+               generation++;                                            \
+            }                                                           \
+         }                                                              \
       }                                                                 \
+      pass_num++;                                                       \
    } while (false)
 
-   OPT(lower_instructions, ir, SUB_TO_ADD_NEG);
+   do {
+      progress = false;
+      pass_num = 0;
 
-   if (linked) {
-      OPT(do_function_inlining, ir);
-      OPT(do_dead_functions, ir);
-      OPT(do_structure_splitting, ir);
-   }
-   propagate_invariance(ir);
-   OPT(do_if_simplification, ir);
-   OPT(opt_flatten_nested_if_blocks, ir);
-   OPT(opt_conditional_discard, ir);
-   OPT(do_copy_propagation, ir);
-   OPT(do_copy_propagation_elements, ir);
-
-   if (options->OptimizeForAOS && !linked)
-      OPT(opt_flip_matrices, ir);
-
-   if (linked && options->OptimizeForAOS) {
-      OPT(do_vectorize, ir);
-   }
+      OPT(lower_instructions, ir, SUB_TO_ADD_NEG);
 
-   if (linked)
-      OPT(do_dead_code, ir, uniform_locations_assigned);
-   else
-      OPT(do_dead_code_unlinked, ir);
-   OPT(do_dead_code_local, ir);
-   OPT(do_tree_grafting, ir);
-   OPT(do_constant_propagation, ir);
-   if (linked)
-      OPT(do_constant_variable, ir);
-   else
-      OPT(do_constant_variable_unlinked, ir);
-   OPT(do_constant_folding, ir);
-   OPT(do_minmax_prune, ir);
-   OPT(do_rebalance_tree, ir);
-   OPT(do_algebraic, ir, native_integers, options);
-   OPT(do_lower_jumps, ir);
-   OPT(do_vec_index_to_swizzle, ir);
-   OPT(lower_vector_insert, ir, false);
-   OPT(do_swizzle_swizzle, ir);
-   OPT(do_noop_swizzle, ir);
-
-   OPT(optimize_split_arrays, ir, linked);
-   OPT(optimize_redundant_jumps, ir);
-
-   loop_state *ls = analyze_loop_variables(ir);
-   if (ls->loop_found) {
-      OPT(set_loop_controls, ir, ls);
-      OPT(unroll_loops, ir, ls, options);
-   }
-   delete ls;
+      if (linked) {
+         OPT(do_function_inlining, ir);
+         OPT(do_dead_functions, ir);
+         OPT(do_structure_splitting, ir);
+      }
+      propagate_invariance(ir);
+      OPT(do_if_simplification, ir);
+      OPT(opt_flatten_nested_if_blocks, ir);
+      OPT(opt_conditional_discard, ir);
+      OPT(do_copy_propagation, ir);
+      OPT(do_copy_propagation_elements, ir);
+
+      if (options->OptimizeForAOS && !linked)
+         OPT(opt_flip_matrices, ir);
+
+      if (linked && options->OptimizeForAOS) {
+         OPT(do_vectorize, ir);
+      }
+
+      if (linked)
+         OPT(do_dead_code, ir, uniform_locations_assigned);
+      else
+         OPT(do_dead_code_unlinked, ir);
+      OPT(do_dead_code_local, ir);
+      OPT(do_tree_grafting, ir);
+      OPT(do_constant_propagation, ir);
+      if (linked)
+         OPT(do_constant_variable, ir);
+      else
+         OPT(do_constant_variable_unlinked, ir);
+      OPT(do_constant_folding, ir);
+      OPT(do_minmax_prune, ir);
+      OPT(do_rebalance_tree, ir);
+      OPT(do_algebraic, ir, native_integers, options);
+      OPT(do_lower_jumps, ir);
+      OPT(do_vec_index_to_swizzle, ir);
+      OPT(lower_vector_insert, ir, false);
+      OPT(do_swizzle_swizzle, ir);
+      OPT(do_noop_swizzle, ir);
+
+      OPT(optimize_split_arrays, ir, linked);
+      OPT(optimize_redundant_jumps, ir);
+
+      /* The loop analysis is not itself a transformation, so it shares one
+       * generation slot with the two passes that consume its results.
+       */
+      assert(pass_num < ARRAY_SIZE(last_ran));
+      if (last_ran[pass_num] != generation) {
+         last_ran[pass_num] = generation;
+         pass_num++;
+
+         loop_state *ls = analyze_loop_variables(ir);
+         if (ls->loop_found) {
+            OPT(set_loop_controls, ir, ls);
+            OPT(unroll_loops, ir, ls, options);
+         } else {
+            pass_num += 2;
+         }
+         delete ls;
+      } else {
+         pass_num += 3;
+      }
+
+      any_progress = any_progress || progress;
+   } while (progress);
 
 #undef OPT
 
-   return progress;
+   return any_progress;
 }
 
 extern "C" {
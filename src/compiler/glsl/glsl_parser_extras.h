@@ -275,6 +275,13 @@ struct _mesa_glsl_parse_state {
 
    struct gl_context *const ctx;
    void *scanner;
+
+   /**
+    * Linear allocator context for the AST and other small allocations that
+    * live exactly as long as this parse state and are never freed
+    * individually.  Freed automatically with the parse state.
+    */
+   void *linalloc;
    exec_list translation_unit;
    glsl_symbol_table *symbols;
 
@@ -1091,6 +1091,24 @@ public:
    /** Whether or not a built-in is available for this shader. */
    bool is_builtin_available(const _mesa_glsl_parse_state *state) const;
 
+   /**
+    * Attach the availability predicate of a built-in signature.
+    *
+    * Normally the predicate is supplied to the constructor; this exists so
+    * that built-in signatures read back from a serialized image of the
+    * built-in shader can have theirs restored.
+    */
+   void set_builtin_availability(builtin_available_predicate avail)
+   {
+      this->builtin_avail = avail;
+   }
+
+   /** Get the availability predicate, for serializing built-in signatures. */
+   builtin_available_predicate get_builtin_availability() const
+   {
+      return this->builtin_avail;
+   }
+
    /** Body of instructions in the function. */
    struct exec_list body;
 
@@ -0,0 +1,1176 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file ir_serialize.cpp
+ *
+ * Writes a GLSL IR instruction stream to a blob and reads it back.
+ *
+ * Variables are referred to by the order in which their declarations are
+ * written, which works because valid IR declares every variable before its
+ * first use.  Function signatures may be called before the function that
+ * defines them appears in the stream, so a directory of all functions
+ * (names, return types and parameter lists, but not bodies) is written
+ * ahead of the instructions and the reader materializes the empty
+ * signatures from it first.
+ *
+ * Enum values, ir_variable::data and ir_constant::value are written
+ * verbatim, so images can only be read back by the build that wrote them.
+ */
+
+#include "ir_serialize.h"
+#include "program/hash_table.h"
+
+/* Special values used in place of an ir_node_type tag. */
+#define IR_TAG_END_OF_LIST  0xffffffffu
+#define IR_TAG_NULL_RVALUE  0xfffffffeu
+
+void
+serialize_glsl_type(struct blob *blob, const struct glsl_type *type)
+{
+   blob_write_uint32(blob, type->base_type);
+
+   switch (type->base_type) {
+   case GLSL_TYPE_UINT:
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_FLOAT:
+   case GLSL_TYPE_DOUBLE:
+   case GLSL_TYPE_BOOL:
+      blob_write_uint32(blob, type->vector_elements);
+      blob_write_uint32(blob, type->matrix_columns);
+      break;
+   case GLSL_TYPE_SAMPLER:
+      blob_write_uint32(blob, type->sampler_dimensionality);
+      blob_write_uint32(blob, type->sampler_shadow);
+      blob_write_uint32(blob, type->sampler_array);
+      blob_write_uint32(blob, type->sampled_type);
+      break;
+   case GLSL_TYPE_IMAGE:
+      blob_write_uint32(blob, type->sampler_dimensionality);
+      blob_write_uint32(blob, type->sampler_array);
+      blob_write_uint32(blob, type->sampled_type);
+      break;
+   case GLSL_TYPE_ATOMIC_UINT:
+   case GLSL_TYPE_VOID:
+   case GLSL_TYPE_ERROR:
+      break;
+   case GLSL_TYPE_ARRAY:
+      serialize_glsl_type(blob, type->fields.array);
+      blob_write_uint32(blob, type->length);
+      break;
+   case GLSL_TYPE_SUBROUTINE:
+      blob_write_string(blob, type->name);
+      break;
+   case GLSL_TYPE_STRUCT:
+   case GLSL_TYPE_INTERFACE:
+      blob_write_string(blob, type->name);
+      blob_write_uint32(blob, type->length);
+      if (type->base_type == GLSL_TYPE_INTERFACE)
+         blob_write_uint32(blob, type->interface_packing);
+      for (unsigned i = 0; i < type->length; i++) {
+         const struct glsl_struct_field *field = &type->fields.structure[i];
+
+         serialize_glsl_type(blob, field->type);
+         blob_write_string(blob, field->name);
+         blob_write_uint32(blob, field->location);
+         blob_write_uint32(blob, field->offset);
+         blob_write_uint32(blob, field->xfb_buffer);
+         blob_write_uint32(blob, field->xfb_stride);
+         blob_write_uint32(blob,
+                           field->interpolation
+                           | field->centroid << 2
+                           | field->sample << 3
+                           | field->matrix_layout << 4
+                           | field->patch << 6
+                           | field->precision << 7
+                           | field->image_read_only << 9
+                           | field->image_write_only << 10
+                           | field->image_coherent << 11
+                           | field->image_volatile << 12
+                           | field->image_restrict << 13
+                           | field->explicit_xfb_buffer << 14);
+      }
+      break;
+   default:
+      assert(!"Unsupported type in serialize_glsl_type");
+      break;
+   }
+}
+
+const struct glsl_type *
+deserialize_glsl_type(struct blob_reader *blob)
+{
+   uint32_t base_type = blob_read_uint32(blob);
+
+   switch (base_type) {
+   case GLSL_TYPE_UINT:
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_FLOAT:
+   case GLSL_TYPE_DOUBLE:
+   case GLSL_TYPE_BOOL: {
+      uint32_t rows = blob_read_uint32(blob);
+      uint32_t columns = blob_read_uint32(blob);
+      return glsl_type::get_instance(base_type, rows, columns);
+   }
+   case GLSL_TYPE_SAMPLER: {
+      uint32_t dim = blob_read_uint32(blob);
+      uint32_t shadow = blob_read_uint32(blob);
+      uint32_t array = blob_read_uint32(blob);
+      uint32_t sampled = blob_read_uint32(blob);
+      return glsl_type::get_sampler_instance((enum glsl_sampler_dim) dim,
+                                             shadow, array,
+                                             (glsl_base_type) sampled);
+   }
+   case GLSL_TYPE_IMAGE: {
+      uint32_t dim = blob_read_uint32(blob);
+      uint32_t array = blob_read_uint32(blob);
+      uint32_t sampled = blob_read_uint32(blob);
+      return glsl_type::get_image_instance((enum glsl_sampler_dim) dim,
+                                           array, (glsl_base_type) sampled);
+   }
+   case GLSL_TYPE_ATOMIC_UINT:
+      return glsl_type::atomic_uint_type;
+   case GLSL_TYPE_VOID:
+      return glsl_type::void_type;
+   case GLSL_TYPE_ERROR:
+      return glsl_type::error_type;
+   case GLSL_TYPE_ARRAY: {
+      const glsl_type *element = deserialize_glsl_type(blob);
+      uint32_t length = blob_read_uint32(blob);
+
+      if (element == NULL)
+         return NULL;
+      return glsl_type::get_array_instance(element, length);
+   }
+   case GLSL_TYPE_SUBROUTINE: {
+      char *name = blob_read_string(blob);
+
+      if (name == NULL)
+         return NULL;
+      return glsl_type::get_subroutine_instance(name);
+   }
+   case GLSL_TYPE_STRUCT:
+   case GLSL_TYPE_INTERFACE: {
+      char *name = blob_read_string(blob);
+      uint32_t length = blob_read_uint32(blob);
+      uint32_t packing = 0;
+
+      if (base_type == GLSL_TYPE_INTERFACE)
+         packing = blob_read_uint32(blob);
+
+      if (name == NULL || blob->overrun)
+         return NULL;
+
+      glsl_struct_field *fields =
+         ralloc_array(NULL, glsl_struct_field, length);
+      const glsl_type *t = NULL;
+      for (unsigned i = 0; i < length; i++) {
+         glsl_struct_field *field = &fields[i];
+
+         field->type = deserialize_glsl_type(blob);
+         field->name = blob_read_string(blob);
+         field->location = blob_read_uint32(blob);
+         field->offset = blob_read_uint32(blob);
+         field->xfb_buffer = blob_read_uint32(blob);
+         field->xfb_stride = blob_read_uint32(blob);
+
+         uint32_t bits = blob_read_uint32(blob);
+         field->interpolation = bits & 0x3;
+         field->centroid = (bits >> 2) & 0x1;
+         field->sample = (bits >> 3) & 0x1;
+         field->matrix_layout = (bits >> 4) & 0x3;
+         field->patch = (bits >> 6) & 0x1;
+         field->precision = (bits >> 7) & 0x3;
+         field->image_read_only = (bits >> 9) & 0x1;
+         field->image_write_only = (bits >> 10) & 0x1;
+         field->image_coherent = (bits >> 11) & 0x1;
+         field->image_volatile = (bits >> 12) & 0x1;
+         field->image_restrict = (bits >> 13) & 0x1;
+         field->explicit_xfb_buffer = (bits >> 14) & 0x1;
+
+         if (field->type == NULL || field->name == NULL)
+            goto struct_fail;
+      }
+
+      if (base_type == GLSL_TYPE_STRUCT)
+         t = glsl_type::get_record_instance(fields, length, name);
+      else
+         t = glsl_type::get_interface_instance(fields, length,
+                                               (enum glsl_interface_packing)
+                                               packing, name);
+   struct_fail:
+      ralloc_free(fields);
+      return t;
+   }
+   default:
+      return NULL;
+   }
+}
+
+namespace {
+
+class ir_serializer {
+public:
+   ir_serializer(struct blob *blob)
+      : blob(blob), next_var_id(1), next_sig_id(1)
+   {
+      this->var_ids = hash_table_ctor(0, hash_table_pointer_hash,
+                                      hash_table_pointer_compare);
+      this->sig_ids = hash_table_ctor(0, hash_table_pointer_hash,
+                                      hash_table_pointer_compare);
+   }
+
+   ~ir_serializer()
+   {
+      hash_table_dtor(this->var_ids);
+      hash_table_dtor(this->sig_ids);
+   }
+
+   void run(exec_list *ir);
+
+private:
+   void write_function_directory(exec_list *ir);
+   void write_variable(ir_variable *var);
+   void write_constant(ir_constant *c);
+   void write_rvalue(ir_rvalue *ir);
+   void write_instruction(ir_instruction *ir);
+   void write_ir_list(exec_list *list);
+   uint32_t variable_id(ir_variable *var);
+
+   struct blob *blob;
+   struct hash_table *var_ids;
+   struct hash_table *sig_ids;
+   unsigned next_var_id;
+   unsigned next_sig_id;
+};
+
+uint32_t
+ir_serializer::variable_id(ir_variable *var)
+{
+   uint32_t id = (uint32_t) (intptr_t)
+      hash_table_find(this->var_ids, var);
+
+   /* Valid IR declares every variable before its first use, so the
+    * declaration must already have been written.
+    */
+   assert(id != 0);
+   return id;
+}
+
+void
+ir_serializer::write_variable(ir_variable *var)
+{
+   hash_table_insert(this->var_ids, (void *) (intptr_t) this->next_var_id++,
+                     var);
+
+   blob_write_uint32(this->blob, var->name != NULL);
+   if (var->name != NULL)
+      blob_write_string(this->blob, var->name);
+
+   serialize_glsl_type(this->blob, var->type);
+   blob_write_bytes(this->blob, &var->data, sizeof(var->data));
+
+   const glsl_type *ifc_type = var->get_interface_type();
+   blob_write_uint32(this->blob, ifc_type != NULL);
+   if (ifc_type != NULL)
+      serialize_glsl_type(this->blob, ifc_type);
+
+   if (var->is_interface_instance()) {
+      blob_write_bytes(this->blob, var->get_max_ifc_array_access(),
+                       ifc_type->length * sizeof(int));
+   } else {
+      unsigned num_slots = var->get_num_state_slots();
+      blob_write_uint32(this->blob, num_slots);
+      if (num_slots > 0) {
+         blob_write_bytes(this->blob, var->get_state_slots(),
+                          num_slots * sizeof(ir_state_slot));
+      }
+   }
+
+   blob_write_uint32(this->blob, var->constant_value != NULL);
+   if (var->constant_value != NULL)
+      write_constant(var->constant_value);
+
+   blob_write_uint32(this->blob, var->constant_initializer != NULL);
+   if (var->constant_initializer != NULL)
+      write_constant(var->constant_initializer);
+}
+
+void
+ir_serializer::write_constant(ir_constant *c)
+{
+   serialize_glsl_type(this->blob, c->type);
+
+   if (c->type->is_array()) {
+      for (unsigned i = 0; i < c->type->length; i++)
+         write_constant(c->array_elements[i]);
+   } else if (c->type->is_record()) {
+      foreach_in_list(ir_constant, elem, &c->components)
+         write_constant(elem);
+   } else {
+      blob_write_bytes(this->blob, &c->value, sizeof(c->value));
+   }
+}
+
+void
+ir_serializer::write_rvalue(ir_rvalue *ir)
+{
+   if (ir == NULL) {
+      blob_write_uint32(this->blob, IR_TAG_NULL_RVALUE);
+      return;
+   }
+
+   blob_write_uint32(this->blob, ir->ir_type);
+
+   switch (ir->ir_type) {
+   case ir_type_dereference_variable:
+      blob_write_uint32(this->blob,
+                        variable_id(ir->as_dereference_variable()->var));
+      break;
+
+   case ir_type_dereference_array: {
+      ir_dereference_array *const deref = ir->as_dereference_array();
+      write_rvalue(deref->array);
+      write_rvalue(deref->array_index);
+      break;
+   }
+
+   case ir_type_dereference_record: {
+      ir_dereference_record *const deref = ir->as_dereference_record();
+      write_rvalue(deref->record);
+      blob_write_string(this->blob, deref->field);
+      break;
+   }
+
+   case ir_type_constant:
+      write_constant(ir->as_constant());
+      break;
+
+   case ir_type_expression: {
+      ir_expression *const expr = ir->as_expression();
+      serialize_glsl_type(this->blob, expr->type);
+      blob_write_uint32(this->blob, expr->operation);
+      blob_write_uint32(this->blob, expr->get_num_operands());
+      for (unsigned i = 0; i < expr->get_num_operands(); i++)
+         write_rvalue(expr->operands[i]);
+      break;
+   }
+
+   case ir_type_swizzle: {
+      ir_swizzle *const swiz = ir->as_swizzle();
+      write_rvalue(swiz->val);
+      blob_write_uint32(this->blob,
+                        swiz->mask.x
+                        | swiz->mask.y << 2
+                        | swiz->mask.z << 4
+                        | swiz->mask.w << 6
+                        | swiz->mask.num_components << 8);
+      break;
+   }
+
+   case ir_type_texture: {
+      ir_texture *const tex = (ir_texture *) ir;
+      blob_write_uint32(this->blob, tex->op);
+      serialize_glsl_type(this->blob, tex->type);
+      write_rvalue(tex->sampler);
+      write_rvalue(tex->coordinate);
+      write_rvalue(tex->projector);
+      write_rvalue(tex->shadow_comparitor);
+      write_rvalue(tex->offset);
+
+      switch (tex->op) {
+      case ir_txb:
+         write_rvalue(tex->lod_info.bias);
+         break;
+      case ir_txl:
+      case ir_txf:
+      case ir_txs:
+         write_rvalue(tex->lod_info.lod);
+         break;
+      case ir_txf_ms:
+         write_rvalue(tex->lod_info.sample_index);
+         break;
+      case ir_txd:
+         write_rvalue(tex->lod_info.grad.dPdx);
+         write_rvalue(tex->lod_info.grad.dPdy);
+         break;
+      case ir_tg4:
+         write_rvalue(tex->lod_info.component);
+         break;
+      default:
+         break;
+      }
+      break;
+   }
+
+   default:
+      assert(!"Unsupported rvalue in ir_serializer");
+      break;
+   }
+}
+
+void
+ir_serializer::write_instruction(ir_instruction *ir)
+{
+   blob_write_uint32(this->blob, ir->ir_type);
+
+   switch (ir->ir_type) {
+   case ir_type_variable:
+      write_variable((ir_variable *) ir);
+      break;
+
+   case ir_type_function: {
+      ir_function *const f = (ir_function *) ir;
+      unsigned num_sigs = 0;
+
+      blob_write_string(this->blob, f->name);
+      foreach_in_list(ir_function_signature, sig, &f->signatures)
+         num_sigs++;
+      blob_write_uint32(this->blob, num_sigs);
+
+      foreach_in_list(ir_function_signature, sig, &f->signatures) {
+         uint32_t id = (uint32_t) (intptr_t)
+            hash_table_find(this->sig_ids, sig);
+         assert(id != 0);
+         blob_write_uint32(this->blob, id);
+         blob_write_uint32(this->blob, sig->is_defined);
+         write_ir_list(&sig->body);
+      }
+      break;
+   }
+
+   case ir_type_if: {
+      ir_if *const inst = (ir_if *) ir;
+      write_rvalue(inst->condition);
+      write_ir_list(&inst->then_instructions);
+      write_ir_list(&inst->else_instructions);
+      break;
+   }
+
+   case ir_type_loop:
+      write_ir_list(&((ir_loop *) ir)->body_instructions);
+      break;
+
+   case ir_type_loop_jump:
+      blob_write_uint32(this->blob, ((ir_loop_jump *) ir)->mode);
+      break;
+
+   case ir_type_return:
+      write_rvalue(((ir_return *) ir)->value);
+      break;
+
+   case ir_type_discard:
+      write_rvalue(((ir_discard *) ir)->condition);
+      break;
+
+   case ir_type_assignment: {
+      ir_assignment *const assign = (ir_assignment *) ir;
+      blob_write_uint32(this->blob, assign->write_mask);
+      write_rvalue(assign->lhs);
+      write_rvalue(assign->rhs);
+      write_rvalue(assign->condition);
+      break;
+   }
+
+   case ir_type_call: {
+      ir_call *const call = (ir_call *) ir;
+      uint32_t sig_id = (uint32_t) (intptr_t)
+         hash_table_find(this->sig_ids, call->callee);
+      unsigned num_params = 0;
+
+      assert(sig_id != 0);
+      blob_write_uint32(this->blob, sig_id);
+      blob_write_uint32(this->blob, call->use_builtin);
+      write_rvalue(call->return_deref);
+
+      foreach_in_list(ir_rvalue, param, &call->actual_parameters)
+         num_params++;
+      blob_write_uint32(this->blob, num_params);
+      foreach_in_list(ir_rvalue, param, &call->actual_parameters)
+         write_rvalue(param);
+
+      blob_write_uint32(this->blob, call->sub_var != NULL);
+      if (call->sub_var != NULL)
+         blob_write_uint32(this->blob, variable_id(call->sub_var));
+      write_rvalue(call->array_idx);
+      break;
+   }
+
+   case ir_type_emit_vertex:
+      write_rvalue(((ir_emit_vertex *) ir)->stream);
+      break;
+
+   case ir_type_end_primitive:
+      write_rvalue(((ir_end_primitive *) ir)->stream);
+      break;
+
+   case ir_type_barrier:
+      break;
+
+   default:
+      /* The remaining rvalue types never appear as statements in a linked
+       * shader.
+       */
+      assert(!"Unsupported instruction in ir_serializer");
+      break;
+   }
+}
+
+void
+ir_serializer::write_ir_list(exec_list *list)
+{
+   foreach_in_list(ir_instruction, ir, list)
+      write_instruction(ir);
+
+   blob_write_uint32(this->blob, IR_TAG_END_OF_LIST);
+}
+
+/**
+ * Write the directory of function prototypes.
+ *
+ * Bodies are written with the instruction stream; only enough is recorded
+ * here for the reader to construct every signature up front so that calls
+ * can be resolved no matter where the callee's definition appears.
+ */
+void
+ir_serializer::write_function_directory(exec_list *ir)
+{
+   unsigned num_functions = 0;
+
+   foreach_in_list(ir_instruction, inst, ir) {
+      if (inst->as_function() != NULL)
+         num_functions++;
+   }
+   blob_write_uint32(this->blob, num_functions);
+
+   foreach_in_list(ir_instruction, inst, ir) {
+      ir_function *const f = inst->as_function();
+      unsigned num_sigs = 0;
+
+      if (f == NULL)
+         continue;
+
+      blob_write_string(this->blob, f->name);
+      blob_write_uint32(this->blob, f->is_subroutine);
+      blob_write_uint32(this->blob, f->num_subroutine_types);
+      for (int i = 0; i < f->num_subroutine_types; i++)
+         serialize_glsl_type(this->blob, f->subroutine_types[i]);
+      blob_write_uint32(this->blob, f->subroutine_index);
+
+      foreach_in_list(ir_function_signature, sig, &f->signatures)
+         num_sigs++;
+      blob_write_uint32(this->blob, num_sigs);
+
+      foreach_in_list(ir_function_signature, sig, &f->signatures) {
+         hash_table_insert(this->sig_ids,
+                           (void *) (intptr_t) this->next_sig_id++, sig);
+
+         serialize_glsl_type(this->blob, sig->return_type);
+         blob_write_uint32(this->blob, sig->is_defined);
+         blob_write_uint32(this->blob, sig->is_intrinsic);
+
+         unsigned num_params = 0;
+         foreach_in_list(ir_variable, param, &sig->parameters)
+            num_params++;
+         blob_write_uint32(this->blob, num_params);
+         foreach_in_list(ir_variable, param, &sig->parameters)
+            write_variable(param);
+      }
+   }
+}
+
+void
+ir_serializer::run(exec_list *ir)
+{
+   write_function_directory(ir);
+   write_ir_list(ir);
+}
+
+class ir_deserializer {
+public:
+   ir_deserializer(struct blob_reader *blob, void *mem_ctx)
+      : blob(blob), mem_ctx(mem_ctx), error(false),
+        vars(NULL), num_vars(0), sigs(NULL), num_sigs(0)
+   {
+      this->functions = hash_table_ctor(0, hash_table_string_hash,
+                                        hash_table_string_compare);
+   }
+
+   ~ir_deserializer()
+   {
+      hash_table_dtor(this->functions);
+      ralloc_free(this->vars);
+      ralloc_free(this->sigs);
+   }
+
+   bool run(exec_list *ir);
+
+private:
+   bool read_function_directory();
+   ir_variable *read_variable();
+   ir_constant *read_constant();
+   ir_rvalue *read_rvalue();
+   ir_instruction *read_instruction(uint32_t tag);
+   bool read_ir_list(exec_list *list);
+   ir_variable *lookup_variable(uint32_t id);
+   ir_function_signature *lookup_signature(uint32_t id);
+
+   struct blob_reader *blob;
+   void *mem_ctx;
+   bool error;
+
+   ir_variable **vars;
+   unsigned num_vars;
+   ir_function_signature **sigs;
+   unsigned num_sigs;
+   struct hash_table *functions;
+};
+
+ir_variable *
+ir_deserializer::lookup_variable(uint32_t id)
+{
+   if (id == 0 || id > this->num_vars) {
+      this->error = true;
+      return NULL;
+   }
+   return this->vars[id - 1];
+}
+
+ir_function_signature *
+ir_deserializer::lookup_signature(uint32_t id)
+{
+   if (id == 0 || id > this->num_sigs) {
+      this->error = true;
+      return NULL;
+   }
+   return this->sigs[id - 1];
+}
+
+ir_variable *
+ir_deserializer::read_variable()
+{
+   char *name = NULL;
+
+   if (blob_read_uint32(this->blob))
+      name = blob_read_string(this->blob);
+
+   const glsl_type *type = deserialize_glsl_type(this->blob);
+   if (type == NULL) {
+      this->error = true;
+      return NULL;
+   }
+
+   ir_variable *var =
+      new(this->mem_ctx) ir_variable(type, name, ir_var_auto);
+
+   /* This also restores data.warn_extension_index, which is an index into
+    * a table that is fixed at compile time and therefore stable across
+    * processes of the same build.
+    */
+   blob_copy_bytes(this->blob, (uint8_t *) &var->data, sizeof(var->data));
+
+   if (blob_read_uint32(this->blob)) {
+      const glsl_type *ifc_type = deserialize_glsl_type(this->blob);
+      if (ifc_type == NULL) {
+         this->error = true;
+         return NULL;
+      }
+      var->init_interface_type(ifc_type);
+   }
+
+   if (var->is_interface_instance()) {
+      blob_copy_bytes(this->blob,
+                      (uint8_t *) var->get_max_ifc_array_access(),
+                      var->get_interface_type()->length * sizeof(int));
+   } else {
+      uint32_t num_slots = blob_read_uint32(this->blob);
+      if (num_slots > 0) {
+         ir_state_slot *slots = var->allocate_state_slots(num_slots);
+         if (slots == NULL) {
+            this->error = true;
+            return NULL;
+         }
+         blob_copy_bytes(this->blob, (uint8_t *) slots,
+                         num_slots * sizeof(ir_state_slot));
+      }
+   }
+
+   if (blob_read_uint32(this->blob))
+      var->constant_value = read_constant();
+
+   if (blob_read_uint32(this->blob))
+      var->constant_initializer = read_constant();
+
+   if (this->error || this->blob->overrun)
+      return NULL;
+
+   this->vars = reralloc(NULL, this->vars, ir_variable *,
+                         this->num_vars + 1);
+   this->vars[this->num_vars++] = var;
+
+   return var;
+}
+
+ir_constant *
+ir_deserializer::read_constant()
+{
+   const glsl_type *type = deserialize_glsl_type(this->blob);
+
+   if (type == NULL) {
+      this->error = true;
+      return NULL;
+   }
+
+   if (type->is_array() || type->is_record()) {
+      exec_list elements;
+      unsigned length = type->length;
+
+      for (unsigned i = 0; i < length; i++) {
+         ir_constant *elem = read_constant();
+         if (elem == NULL)
+            return NULL;
+         elements.push_tail(elem);
+      }
+      return new(this->mem_ctx) ir_constant(type, &elements);
+   }
+
+   ir_constant_data data;
+   blob_copy_bytes(this->blob, (uint8_t *) &data, sizeof(data));
+   if (this->blob->overrun) {
+      this->error = true;
+      return NULL;
+   }
+   return new(this->mem_ctx) ir_constant(type, &data);
+}
+
+ir_rvalue *
+ir_deserializer::read_rvalue()
+{
+   uint32_t tag = blob_read_uint32(this->blob);
+
+   if (tag == IR_TAG_NULL_RVALUE)
+      return NULL;
+
+   if (this->error || this->blob->overrun) {
+      this->error = true;
+      return NULL;
+   }
+
+   switch (tag) {
+   case ir_type_dereference_variable: {
+      ir_variable *var = lookup_variable(blob_read_uint32(this->blob));
+      if (var == NULL)
+         return NULL;
+      return new(this->mem_ctx) ir_dereference_variable(var);
+   }
+
+   case ir_type_dereference_array: {
+      ir_rvalue *array = read_rvalue();
+      ir_rvalue *index = read_rvalue();
+      if (array == NULL || index == NULL) {
+         this->error = true;
+         return NULL;
+      }
+      return new(this->mem_ctx) ir_dereference_array(array, index);
+   }
+
+   case ir_type_dereference_record: {
+      ir_rvalue *record = read_rvalue();
+      char *field = blob_read_string(this->blob);
+      if (record == NULL || field == NULL) {
+         this->error = true;
+         return NULL;
+      }
+      return new(this->mem_ctx) ir_dereference_record(record, field);
+   }
+
+   case ir_type_constant:
+      return read_constant();
+
+   case ir_type_expression: {
+      const glsl_type *type = deserialize_glsl_type(this->blob);
+      uint32_t op = blob_read_uint32(this->blob);
+      uint32_t num_operands = blob_read_uint32(this->blob);
+      ir_rvalue *ops[4] = { NULL, NULL, NULL, NULL };
+
+      if (type == NULL || num_operands > 4) {
+         this->error = true;
+         return NULL;
+      }
+
+      for (unsigned i = 0; i < num_operands; i++) {
+         ops[i] = read_rvalue();
+         if (ops[i] == NULL) {
+            this->error = true;
+            return NULL;
+         }
+      }
+      return new(this->mem_ctx) ir_expression(op, type, ops[0], ops[1],
+                                              ops[2], ops[3]);
+   }
+
+   case ir_type_swizzle: {
+      ir_rvalue *val = read_rvalue();
+      uint32_t mask = blob_read_uint32(this->blob);
+
+      if (val == NULL) {
+         this->error = true;
+         return NULL;
+      }
+      return new(this->mem_ctx) ir_swizzle(val,
+                                           mask & 0x3,
+                                           (mask >> 2) & 0x3,
+                                           (mask >> 4) & 0x3,
+                                           (mask >> 6) & 0x3,
+                                           (mask >> 8) & 0x7);
+   }
+
+   case ir_type_texture: {
+      uint32_t op = blob_read_uint32(this->blob);
+      const glsl_type *type = deserialize_glsl_type(this->blob);
+
+      if (type == NULL || op > ir_samples_identical) {
+         this->error = true;
+         return NULL;
+      }
+
+      ir_texture *tex =
+         new(this->mem_ctx) ir_texture((enum ir_texture_opcode) op);
+
+      ir_rvalue *sampler = read_rvalue();
+      if (sampler == NULL || sampler->as_dereference() == NULL) {
+         this->error = true;
+         return NULL;
+      }
+      tex->set_sampler(sampler->as_dereference(), type);
+
+      tex->coordinate = read_rvalue();
+      tex->projector = read_rvalue();
+      tex->shadow_comparitor = read_rvalue();
+      tex->offset = read_rvalue();
+
+      switch (tex->op) {
+      case ir_txb:
+         tex->lod_info.bias = read_rvalue();
+         break;
+      case ir_txl:
+      case ir_txf:
+      case ir_txs:
+         tex->lod_info.lod = read_rvalue();
+         break;
+      case ir_txf_ms:
+         tex->lod_info.sample_index = read_rvalue();
+         break;
+      case ir_txd:
+         tex->lod_info.grad.dPdx = read_rvalue();
+         tex->lod_info.grad.dPdy = read_rvalue();
+         break;
+      case ir_tg4:
+         tex->lod_info.component = read_rvalue();
+         break;
+      default:
+         break;
+      }
+      return tex;
+   }
+
+   default:
+      this->error = true;
+      return NULL;
+   }
+}
+
+ir_instruction *
+ir_deserializer::read_instruction(uint32_t tag)
+{
+   switch (tag) {
+   case ir_type_variable:
+      return read_variable();
+
+   case ir_type_function: {
+      char *name = blob_read_string(this->blob);
+      if (name == NULL) {
+         this->error = true;
+         return NULL;
+      }
+
+      ir_function *f =
+         (ir_function *) hash_table_find(this->functions, name);
+      if (f == NULL) {
+         this->error = true;
+         return NULL;
+      }
+
+      uint32_t num_sigs = blob_read_uint32(this->blob);
+      for (unsigned i = 0; i < num_sigs; i++) {
+         ir_function_signature *sig =
+            lookup_signature(blob_read_uint32(this->blob));
+         uint32_t is_defined = blob_read_uint32(this->blob);
+
+         if (sig == NULL || !read_ir_list(&sig->body))
+            return NULL;
+         sig->is_defined = is_defined;
+      }
+      return f;
+   }
+
+   case ir_type_if: {
+      ir_rvalue *condition = read_rvalue();
+      if (condition == NULL) {
+         this->error = true;
+         return NULL;
+      }
+
+      ir_if *inst = new(this->mem_ctx) ir_if(condition);
+      if (!read_ir_list(&inst->then_instructions) ||
+          !read_ir_list(&inst->else_instructions))
+         return NULL;
+      return inst;
+   }
+
+   case ir_type_loop: {
+      ir_loop *loop = new(this->mem_ctx) ir_loop();
+      if (!read_ir_list(&loop->body_instructions))
+         return NULL;
+      return loop;
+   }
+
+   case ir_type_loop_jump: {
+      uint32_t mode = blob_read_uint32(this->blob);
+      if (mode != ir_loop_jump::jump_break &&
+          mode != ir_loop_jump::jump_continue) {
+         this->error = true;
+         return NULL;
+      }
+      return new(this->mem_ctx)
+         ir_loop_jump((ir_loop_jump::jump_mode) mode);
+   }
+
+   case ir_type_return: {
+      ir_rvalue *value = read_rvalue();
+      if (this->error)
+         return NULL;
+      return value != NULL ? new(this->mem_ctx) ir_return(value)
+                           : new(this->mem_ctx) ir_return();
+   }
+
+   case ir_type_discard: {
+      ir_rvalue *condition = read_rvalue();
+      if (this->error)
+         return NULL;
+      return new(this->mem_ctx) ir_discard(condition);
+   }
+
+   case ir_type_assignment: {
+      uint32_t write_mask = blob_read_uint32(this->blob);
+      ir_rvalue *lhs = read_rvalue();
+      ir_rvalue *rhs = read_rvalue();
+      ir_rvalue *condition = read_rvalue();
+
+      if (lhs == NULL || lhs->as_dereference() == NULL || rhs == NULL) {
+         this->error = true;
+         return NULL;
+      }
+      return new(this->mem_ctx) ir_assignment(lhs->as_dereference(), rhs,
+                                              condition, write_mask);
+   }
+
+   case ir_type_call: {
+      ir_function_signature *callee =
+         lookup_signature(blob_read_uint32(this->blob));
+      uint32_t use_builtin = blob_read_uint32(this->blob);
+      ir_rvalue *return_deref = read_rvalue();
+
+      if (callee == NULL ||
+          (return_deref != NULL &&
+           return_deref->as_dereference_variable() == NULL)) {
+         this->error = true;
+         return NULL;
+      }
+
+      exec_list params;
+      uint32_t num_params = blob_read_uint32(this->blob);
+      for (unsigned i = 0; i < num_params; i++) {
+         ir_rvalue *param = read_rvalue();
+         if (param == NULL) {
+            this->error = true;
+            return NULL;
+         }
+         params.push_tail(param);
+      }
+
+      ir_variable *sub_var = NULL;
+      if (blob_read_uint32(this->blob)) {
+         sub_var = lookup_variable(blob_read_uint32(this->blob));
+         if (sub_var == NULL)
+            return NULL;
+      }
+      ir_rvalue *array_idx = read_rvalue();
+
+      ir_dereference_variable *ret_deref = return_deref != NULL
+         ? return_deref->as_dereference_variable() : NULL;
+      ir_call *call = sub_var != NULL
+         ? new(this->mem_ctx) ir_call(callee, ret_deref, &params,
+                                      sub_var, array_idx)
+         : new(this->mem_ctx) ir_call(callee, ret_deref, &params);
+
+      /* The signature directory cannot preserve built-in availability
+       * predicates, so restore the flag the linker computed from them.
+       */
+      call->use_builtin = use_builtin;
+      return call;
+   }
+
+   case ir_type_emit_vertex: {
+      ir_rvalue *stream = read_rvalue();
+      if (stream == NULL) {
+         this->error = true;
+         return NULL;
+      }
+      return new(this->mem_ctx) ir_emit_vertex(stream);
+   }
+
+   case ir_type_end_primitive: {
+      ir_rvalue *stream = read_rvalue();
+      if (stream == NULL) {
+         this->error = true;
+         return NULL;
+      }
+      return new(this->mem_ctx) ir_end_primitive(stream);
+   }
+
+   case ir_type_barrier:
+      return new(this->mem_ctx) ir_barrier();
+
+   default:
+      this->error = true;
+      return NULL;
+   }
+}
+
+bool
+ir_deserializer::read_ir_list(exec_list *list)
+{
+   for (;;) {
+      uint32_t tag = blob_read_uint32(this->blob);
+
+      if (tag == IR_TAG_END_OF_LIST)
+         break;
+
+      if (this->error || this->blob->overrun) {
+         this->error = true;
+         return false;
+      }
+
+      ir_instruction *ir = read_instruction(tag);
+      if (ir == NULL) {
+         this->error = true;
+         return false;
+      }
+      list->push_tail(ir);
+   }
+   return !this->error;
+}
+
+bool
+ir_deserializer::read_function_directory()
+{
+   uint32_t num_functions = blob_read_uint32(this->blob);
+
+   for (unsigned i = 0; i < num_functions; i++) {
+      char *name = blob_read_string(this->blob);
+      if (name == NULL)
+         return false;
+
+      ir_function *f = new(this->mem_ctx) ir_function(name);
+      f->is_subroutine = blob_read_uint32(this->blob);
+      f->num_subroutine_types = blob_read_uint32(this->blob);
+      if (f->num_subroutine_types > 0) {
+         f->subroutine_types = ralloc_array(this->mem_ctx,
+                                            const struct glsl_type *,
+                                            f->num_subroutine_types);
+         for (int j = 0; j < f->num_subroutine_types; j++) {
+            f->subroutine_types[j] = deserialize_glsl_type(this->blob);
+            if (f->subroutine_types[j] == NULL)
+               return false;
+         }
+      }
+      f->subroutine_index = blob_read_uint32(this->blob);
+      hash_table_insert(this->functions, f, f->name);
+
+      uint32_t num_sigs = blob_read_uint32(this->blob);
+      for (unsigned j = 0; j < num_sigs; j++) {
+         const glsl_type *return_type = deserialize_glsl_type(this->blob);
+         if (return_type == NULL)
+            return false;
+
+         ir_function_signature *sig =
+            new(this->mem_ctx) ir_function_signature(return_type);
+         sig->is_defined = blob_read_uint32(this->blob);
+         sig->is_intrinsic = blob_read_uint32(this->blob);
+
+         uint32_t num_params = blob_read_uint32(this->blob);
+         for (unsigned k = 0; k < num_params; k++) {
+            ir_variable *param = read_variable();
+            if (param == NULL)
+               return false;
+            sig->parameters.push_tail(param);
+         }
+
+         f->add_signature(sig);
+
+         this->sigs = reralloc(NULL, this->sigs, ir_function_signature *,
+                               this->num_sigs + 1);
+         this->sigs[this->num_sigs++] = sig;
+      }
+   }
+   return !this->blob->overrun;
+}
+
+bool
+ir_deserializer::run(exec_list *ir)
+{
+   if (!read_function_directory())
+      return false;
+
+   if (!read_ir_list(ir))
+      return false;
+
+   return !this->blob->overrun;
+}
+
+} /* anonymous namespace */
+
+void
+serialize_glsl_ir(struct blob *blob, exec_list *ir)
+{
+   ir_serializer s(blob);
+   s.run(ir);
+}
+
+bool
+deserialize_glsl_ir(struct blob_reader *blob, exec_list *ir, void *mem_ctx)
+{
+   ir_deserializer d(blob, mem_ctx);
+   return d.run(ir);
+}
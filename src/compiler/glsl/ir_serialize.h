@@ -0,0 +1,53 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef IR_SERIALIZE_H
+#define IR_SERIALIZE_H
+
+#include "ir.h"
+#include "blob.h"
+
+/**
+ * \file ir_serialize.h
+ *
+ * Binary serialization of a linked GLSL IR instruction stream.
+ *
+ * The format is only intended to be read back by the very same build of
+ * Mesa that produced it (enum values and struct layouts are written
+ * verbatim), so any consumer must key stored images with a build
+ * identifier.  See shader_cache.cpp.
+ */
+
+void
+serialize_glsl_ir(struct blob *blob, exec_list *ir);
+
+bool
+deserialize_glsl_ir(struct blob_reader *blob, exec_list *ir, void *mem_ctx);
+
+const struct glsl_type *
+deserialize_glsl_type(struct blob_reader *blob);
+
+void
+serialize_glsl_type(struct blob *blob, const struct glsl_type *type);
+
+#endif /* IR_SERIALIZE_H */
@@ -67,6 +67,14 @@ struct gl_uniform_driver_storage {
     * Pointer to the base of the data.
     */
    void *data;
+
+   /**
+    * Parameter list whose dirty state should be updated when this storage
+    * is written, or NULL.  \c param_index is the ParameterValues[] slot
+    * that \c data points at.
+    */
+   struct gl_program_parameter_list *params;
+   unsigned param_index;
 };
 
 struct gl_opaque_uniform_index {
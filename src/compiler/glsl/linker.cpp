@@ -77,6 +77,8 @@
 #include "ir_optimization.h"
 #include "ir_rvalue_visitor.h"
 #include "ir_uniform.h"
+#include "shader_cache.h"
+#include "util/u_queue.h"
 
 #include "main/shaderobj.h"
 #include "main/enums.h"
@@ -518,17 +520,24 @@ private:
 
 } /* anonymous namespace */
 
+/* Serializes appends to the program info log so that per-stage link jobs
+ * running on different threads can report errors concurrently.
+ */
+static mtx_t info_log_mutex = _MTX_INITIALIZER_NP;
+
 void
 linker_error(gl_shader_program *prog, const char *fmt, ...)
 {
    va_list ap;
 
+   mtx_lock(&info_log_mutex);
    ralloc_strcat(&prog->InfoLog, "error: ");
    va_start(ap, fmt);
    ralloc_vasprintf_append(&prog->InfoLog, fmt, ap);
    va_end(ap);
 
    prog->LinkStatus = false;
+   mtx_unlock(&info_log_mutex);
 }
 
 
@@ -537,11 +546,12 @@ linker_warning(gl_shader_program *prog, const char *fmt, ...)
 {
    va_list ap;
 
+   mtx_lock(&info_log_mutex);
    ralloc_strcat(&prog->InfoLog, "warning: ");
    va_start(ap, fmt);
    ralloc_vasprintf_append(&prog->InfoLog, fmt, ap);
    va_end(ap);
-
+   mtx_unlock(&info_log_mutex);
 }
 
 
@@ -4425,6 +4435,32 @@ disable_varying_optimizations_for_sso(struct gl_shader_program *prog)
    }
 }
 
+/**
+ * Per-stage payload for running link_intrastage_shaders on a linker thread.
+ *
+ * Each job allocates into its own ralloc context so that concurrent stages
+ * never touch the same ralloc parent; the contexts are stolen back into the
+ * linker's mem_ctx once every stage has been joined.
+ */
+struct intrastage_link_job {
+   struct gl_context *ctx;
+   struct gl_shader_program *prog;
+   struct gl_shader **shader_list;
+   unsigned num_shaders;
+   void *mem_ctx;
+   struct gl_shader *linked;
+   struct util_queue_fence fence;
+};
+
+static void
+execute_intrastage_link_job(void *data, int thread_index)
+{
+   struct intrastage_link_job *job = (struct intrastage_link_job *) data;
+
+   job->linked = link_intrastage_shaders(job->mem_ctx, job->ctx, job->prog,
+                                         job->shader_list, job->num_shaders);
+}
+
 void
 link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
 {
@@ -4565,18 +4601,85 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
       prog->_LinkedShaders[i] = NULL;
    }
 
-   /* Link all shaders for a particular stage and validate the result.
+   /* Check the on-disk cache before doing the expensive per-stage link.  On
+    * a hit the restored shaders only need their symbol tables rebuilt; the
+    * inter-stage phase below still runs because it depends on GL state
+    * (attribute bindings, transform feedback, SSO) not covered by the key.
     */
-   for (int stage = 0; stage < MESA_SHADER_STAGES; stage++) {
-      if (num_shaders[stage] > 0) {
-         gl_shader *const sh =
-            link_intrastage_shaders(mem_ctx, ctx, prog, shader_list[stage],
-                                    num_shaders[stage]);
+   if (shader_cache_read_program(ctx, prog)) {
+      for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+         if (prog->_LinkedShaders[i] != NULL)
+            populate_symbol_table(prog->_LinkedShaders[i]);
+      }
+   } else {
+      struct intrastage_link_job jobs[MESA_SHADER_STAGES];
+      struct util_queue link_queue;
+      unsigned num_stages = 0;
+
+      for (int stage = 0; stage < MESA_SHADER_STAGES; stage++) {
+         if (num_shaders[stage] > 0)
+            num_stages++;
+      }
+
+      /* Link all shaders for a particular stage.  The stages are independent
+       * of each other until the inter-stage phase below, so when more than
+       * one stage is present they are linked on a thread pool and joined
+       * before validation.  Writes to the info log are serialized inside
+       * linker_error(), and each job allocates into its own ralloc context.
+       */
+      const bool threaded = num_stages > 1 &&
+         util_queue_init(&link_queue, "glsl_link", MESA_SHADER_STAGES,
+                         num_stages, 0);
+
+      for (int stage = 0; stage < MESA_SHADER_STAGES; stage++) {
+         struct intrastage_link_job *const job = &jobs[stage];
+
+         job->linked = NULL;
+         if (num_shaders[stage] == 0)
+            continue;
+
+         job->ctx = ctx;
+         job->prog = prog;
+         job->shader_list = shader_list[stage];
+         job->num_shaders = num_shaders[stage];
+         job->mem_ctx = ralloc_context(NULL);
+
+         if (threaded) {
+            util_queue_fence_init(&job->fence);
+            util_queue_add_job(&link_queue, job, &job->fence,
+                               execute_intrastage_link_job, NULL);
+         } else {
+            execute_intrastage_link_job(job, 0);
+         }
+      }
+
+      if (threaded) {
+         for (int stage = 0; stage < MESA_SHADER_STAGES; stage++) {
+            if (num_shaders[stage] > 0) {
+               util_queue_fence_wait(&jobs[stage].fence);
+               util_queue_fence_destroy(&jobs[stage].fence);
+            }
+         }
+         util_queue_destroy(&link_queue);
+      }
+
+      /* Validate the results and hand the surviving shaders to the program.
+       * This runs on the application thread because the validators write
+       * cross-stage state (clip distance array sizes and the like).  Every
+       * stage is visited even after a failure so that the remaining linked
+       * shaders and ralloc contexts are reclaimed.
+       */
+      for (int stage = 0; stage < MESA_SHADER_STAGES; stage++) {
+         if (num_shaders[stage] == 0)
+            continue;
+
+         gl_shader *const sh = jobs[stage].linked;
+         ralloc_steal(mem_ctx, jobs[stage].mem_ctx);
 
          if (!prog->LinkStatus) {
             if (sh)
                _mesa_delete_shader(ctx, sh);
-            goto done;
+            continue;
          }
 
          switch (stage) {
@@ -4599,11 +4702,16 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
          if (!prog->LinkStatus) {
             if (sh)
                _mesa_delete_shader(ctx, sh);
-            goto done;
+            continue;
          }
 
          _mesa_reference_shader(ctx, &prog->_LinkedShaders[stage], sh);
       }
+
+      if (!prog->LinkStatus)
+         goto done;
+
+      shader_cache_write_program(ctx, prog);
    }
 
    if (num_shaders[MESA_SHADER_GEOMETRY] > 0) {
@@ -4727,10 +4835,9 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
          lower_tess_level(prog->_LinkedShaders[i]);
       }
 
-      while (do_common_optimization(prog->_LinkedShaders[i]->ir, true, false,
-                                    &ctx->Const.ShaderCompilerOptions[i],
-                                    ctx->Const.NativeIntegers))
-	 ;
+      do_common_optimization(prog->_LinkedShaders[i]->ir, true, false,
+                             &ctx->Const.ShaderCompilerOptions[i],
+                             ctx->Const.NativeIntegers);
 
       lower_const_arrays_to_uniforms(prog->_LinkedShaders[i]->ir);
    }
@@ -30,6 +30,13 @@
  * This should reduce the number of MOV instructions in the generated
  * programs unless copy propagation is also done on the LIR, and may
  * help anyway by triggering other optimizations that live in the HIR.
+ *
+ * The walk also performs a limited form of local dead code elimination:
+ * once every use of a copy has been rewritten to read the source
+ * variable instead, the copy itself is removed as soon as an
+ * unconditional whole-variable write to the same destination is seen,
+ * rather than leaving the now-dead assignment for a separate dead-code
+ * walk over the whole IR.
  */
 
 #include "ir.h"
@@ -68,6 +75,31 @@ public:
    ir_variable *var;
 };
 
+/**
+ * A copy whose destination has not been read since the copy was made.
+ *
+ * If the destination is overwritten before any read is seen, the copy is
+ * dead and can be removed during this same walk.
+ */
+class dead_copy_entry : public exec_node
+{
+public:
+   dead_copy_entry(ir_variable *lhs, ir_assignment *ir, unsigned depth)
+   {
+      assert(lhs);
+      assert(ir);
+      this->lhs = lhs;
+      this->ir = ir;
+      this->depth = depth;
+   }
+
+   ir_variable *lhs;
+   ir_assignment *ir;
+
+   /** Nesting depth at which the copy was made. */
+   unsigned depth;
+};
+
 class ir_copy_propagation_visitor : public ir_hierarchical_visitor {
 public:
    ir_copy_propagation_visitor()
@@ -76,6 +108,8 @@ public:
       mem_ctx = ralloc_context(0);
       this->acp = new(mem_ctx) exec_list;
       this->kills = new(mem_ctx) exec_list;
+      this->dead_copies = new(mem_ctx) exec_list;
+      this->depth = 0;
    }
    ~ir_copy_propagation_visitor()
    {
@@ -83,15 +117,18 @@ public:
    }
 
    virtual ir_visitor_status visit(class ir_dereference_variable *);
+   virtual ir_visitor_status visit(class ir_loop_jump *);
    virtual ir_visitor_status visit_enter(class ir_loop *);
    virtual ir_visitor_status visit_enter(class ir_function_signature *);
    virtual ir_visitor_status visit_enter(class ir_function *);
    virtual ir_visitor_status visit_leave(class ir_assignment *);
    virtual ir_visitor_status visit_enter(class ir_call *);
    virtual ir_visitor_status visit_enter(class ir_if *);
+   virtual ir_visitor_status visit_enter(class ir_return *);
 
    void add_copy(ir_assignment *ir);
    void kill(ir_variable *ir);
+   void forget_dead_copies(ir_variable *var);
    void handle_if_block(exec_list *instructions);
 
    /** List of acp_entry: The available copies to propagate */
@@ -102,6 +139,15 @@ public:
     */
    exec_list *kills;
 
+   /**
+    * List of dead_copy_entry: Copies that have not been read since they
+    * were made.
+    */
+   exec_list *dead_copies;
+
+   /** Current control-flow nesting depth. */
+   unsigned depth;
+
    bool progress;
 
    bool killed_all;
@@ -120,19 +166,26 @@ ir_copy_propagation_visitor::visit_enter(ir_function_signature *ir)
     */
    exec_list *orig_acp = this->acp;
    exec_list *orig_kills = this->kills;
+   exec_list *orig_dead_copies = this->dead_copies;
+   unsigned orig_depth = this->depth;
    bool orig_killed_all = this->killed_all;
 
    this->acp = new(mem_ctx) exec_list;
    this->kills = new(mem_ctx) exec_list;
+   this->dead_copies = new(mem_ctx) exec_list;
+   this->depth = 0;
    this->killed_all = false;
 
    visit_list_elements(this, &ir->body);
 
    ralloc_free(this->acp);
    ralloc_free(this->kills);
+   ralloc_free(this->dead_copies);
 
    this->kills = orig_kills;
    this->acp = orig_acp;
+   this->dead_copies = orig_dead_copies;
+   this->depth = orig_depth;
    this->killed_all = orig_killed_all;
 
    return visit_continue_with_parent;
@@ -141,7 +194,24 @@ ir_copy_propagation_visitor::visit_enter(ir_function_signature *ir)
 ir_visitor_status
 ir_copy_propagation_visitor::visit_leave(ir_assignment *ir)
 {
-   kill(ir->lhs->variable_referenced());
+   ir_variable *lhs_var = ir->lhs->variable_referenced();
+
+   /* An unconditional whole-variable write makes any copy of the same
+    * variable at this nesting level that has not been read since it was
+    * made dead: remove it now instead of leaving it for a separate
+    * dead-code walk over the whole IR.
+    */
+   if (ir->condition == NULL && ir->whole_variable_written() != NULL) {
+      foreach_in_list_safe(dead_copy_entry, entry, this->dead_copies) {
+         if (entry->lhs == lhs_var && entry->depth == this->depth) {
+            entry->ir->remove();
+            entry->remove();
+            this->progress = true;
+         }
+      }
+   }
+
+   kill(lhs_var);
 
    add_copy(ir);
 
@@ -165,8 +235,19 @@ ir_copy_propagation_visitor::visit_enter(ir_function *ir)
 ir_visitor_status
 ir_copy_propagation_visitor::visit(ir_dereference_variable *ir)
 {
-   if (this->in_assignee)
+   if (this->in_assignee) {
+      /* The deref that is the entire LHS of a plain assignment is a write,
+       * not a read.  Any other deref under an assignee (an array index, the
+       * base of a partial write) may observe the variable.
+       */
+      ir_assignment *const assign =
+         this->base_ir ? this->base_ir->as_assignment() : NULL;
+
+      if (assign == NULL || assign->lhs != ir)
+         forget_dead_copies(ir->var);
+
       return visit_continue;
+   }
 
    ir_variable *var = ir->var;
 
@@ -178,6 +259,11 @@ ir_copy_propagation_visitor::visit(ir_dereference_variable *ir)
       }
    }
 
+   /* Whichever variable this deref ended up reading is no longer a dead
+    * copy candidate.
+    */
+   forget_dead_copies(ir->var);
+
    return visit_continue;
 }
 
@@ -197,14 +283,39 @@ ir_copy_propagation_visitor::visit_enter(ir_call *ir)
    }
 
    /* Since we're unlinked, we don't (necessarily) know the side effects of
-    * this call.  So kill all copies.
+    * this call.  So kill all copies, and assume the callee may read any
+    * variable.
     */
    acp->make_empty();
+   forget_dead_copies(NULL);
    this->killed_all = true;
 
    return visit_continue_with_parent;
 }
 
+ir_visitor_status
+ir_copy_propagation_visitor::visit(ir_loop_jump *ir)
+{
+   (void) ir;
+
+   /* Control may leave the straight-line path between a copy and a later
+    * overwrite, so none of the pending copies can be proven dead.
+    */
+   forget_dead_copies(NULL);
+
+   return visit_continue;
+}
+
+ir_visitor_status
+ir_copy_propagation_visitor::visit_enter(ir_return *ir)
+{
+   (void) ir;
+
+   forget_dead_copies(NULL);
+
+   return visit_continue;
+}
+
 void
 ir_copy_propagation_visitor::handle_if_block(exec_list *instructions)
 {
@@ -221,7 +332,9 @@ ir_copy_propagation_visitor::handle_if_block(exec_list *instructions)
       this->acp->push_tail(new(this->acp) acp_entry(a->lhs, a->rhs));
    }
 
+   this->depth++;
    visit_list_elements(this, instructions);
+   this->depth--;
 
    if (this->killed_all) {
       orig_acp->make_empty();
@@ -267,7 +380,9 @@ ir_copy_propagation_visitor::visit_enter(ir_loop *ir)
    this->kills = new(mem_ctx) exec_list;
    this->killed_all = false;
 
+   this->depth++;
    visit_list_elements(this, &ir->body_instructions);
+   this->depth--;
 
    if (this->killed_all) {
       orig_acp->make_empty();
@@ -301,11 +416,29 @@ ir_copy_propagation_visitor::kill(ir_variable *var)
       }
    }
 
+   /* A partial or conditional write leaves the old value of the variable
+    * partially live, so the earlier copy is not dead.
+    */
+   forget_dead_copies(var);
+
    /* Add the LHS variable to the list of killed variables in this block.
     */
    this->kills->push_tail(new(this->kills) kill_entry(var));
 }
 
+/**
+ * Drop the dead-copy candidates for \p var, or all of them if \p var is
+ * \c NULL, without removing the copies from the IR.
+ */
+void
+ir_copy_propagation_visitor::forget_dead_copies(ir_variable *var)
+{
+   foreach_in_list_safe(dead_copy_entry, entry, this->dead_copies) {
+      if (var == NULL || entry->lhs == var)
+         entry->remove();
+   }
+}
+
 /**
  * Adds an entry to the available copy list if it's a plain assignment
  * of a variable to a variable.
@@ -335,6 +468,19 @@ ir_copy_propagation_visitor::add_copy(ir_assignment *ir)
                  lhs_var->data.precise == rhs_var->data.precise) {
 	 entry = new(this->acp) acp_entry(lhs_var, rhs_var);
 	 this->acp->push_tail(entry);
+
+         /* Locals that are never read again before being completely
+          * rewritten are dead; track the copy so it can be removed in this
+          * same walk.  Variables with other modes may be observed without
+          * an explicit read in this function (outputs by vertex emission,
+          * globals by other functions), so leave those alone.
+          */
+         if (lhs_var->data.mode == ir_var_auto ||
+             lhs_var->data.mode == ir_var_temporary) {
+            this->dead_copies->push_tail(
+               new(this->dead_copies) dead_copy_entry(lhs_var, ir,
+                                                      this->depth));
+         }
       }
    }
 }
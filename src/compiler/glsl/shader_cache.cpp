@@ -0,0 +1,682 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file shader_cache.cpp
+ *
+ * On-disk cache of linked per-stage GLSL IR.
+ *
+ * The expensive part of glLinkProgram is the per-stage intrastage link:
+ * cross-validating the compilation units, cloning the IR into the linked
+ * shader, resolving calls and laying out uniform blocks.  This cache
+ * stores the result of that phase - the \c gl_shader in
+ * \c gl_shader_program::_LinkedShaders for each stage, including its IR
+ * stream - keyed by a hash of the attached shader sources and the link
+ * state that feeds it.  On a hit the linker skips straight to the
+ * inter-stage phase, which is cheap by comparison and depends on GL state
+ * (attribute bindings, transform feedback varyings) that would otherwise
+ * have to be part of the key.
+ *
+ * Cached images are written by serialize_glsl_ir() and friends, which
+ * store enum values and structs verbatim, so the key includes the Mesa
+ * version string; an image written by any other build simply misses.
+ *
+ * The cache lives in $MESA_GLSL_CACHE_DIR, $XDG_CACHE_HOME/mesa_glsl_cache
+ * or ~/.cache/mesa_glsl_cache, and can be disabled entirely with
+ * MESA_GLSL_CACHE_DISABLE.  Its size is capped at a tenth of the
+ * filesystem it lives on (or $MESA_GLSL_CACHE_MAX_SIZE bytes, with an
+ * optional K, M or G suffix); past the cap each write evicts random
+ * entries until the cache fits again.
+ */
+
+#include "main/core.h"
+#include "main/shaderobj.h"
+#include "shader_cache.h"
+
+#ifdef _WIN32
+
+/* The cache requires POSIX file and directory handling; quietly miss on
+ * other platforms.
+ */
+bool
+shader_cache_read_program(struct gl_context *ctx,
+                          struct gl_shader_program *prog)
+{
+   return false;
+}
+
+void
+shader_cache_write_program(struct gl_context *ctx,
+                           struct gl_shader_program *prog)
+{
+}
+
+#else
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "util/mesa-sha1.h"
+#include "util/u_atomic.h"
+#include "ir.h"
+#include "ir_serialize.h"
+#include "blob.h"
+
+#define CACHE_MAGIC   0x4c534c47  /* 'GLSL' */
+#define CACHE_VERSION 1
+
+bool
+shader_cache_get_dir(char *path, size_t size)
+{
+   const char *env;
+
+   if ((env = getenv("MESA_GLSL_CACHE_DIR")) != NULL) {
+      if (snprintf(path, size, "%s", env) >= (int) size)
+         return false;
+      return true;
+   }
+
+   if ((env = getenv("XDG_CACHE_HOME")) != NULL && env[0] == '/') {
+      if (snprintf(path, size, "%s/mesa_glsl_cache", env) >= (int) size)
+         return false;
+      return true;
+   }
+
+   if ((env = getenv("HOME")) != NULL && env[0] == '/') {
+      if (snprintf(path, size, "%s/.cache", env) >= (int) size)
+         return false;
+      mkdir(path, 0755);
+      if (snprintf(path, size, "%s/.cache/mesa_glsl_cache", env) >=
+          (int) size)
+         return false;
+      return true;
+   }
+
+   return false;
+}
+
+/**
+ * Compute the cache key for \c prog and format it as 40 hex characters.
+ *
+ * The key covers everything the intrastage link result depends on: the
+ * source (and stage) of every attached shader, the constants, extension
+ * enables and API of the context that compiled them, and the program
+ * state consumed before the inter-stage phase.  The Mesa version string
+ * salts the key because the payload is only readable by the build that
+ * wrote it, and the renderer string keeps images from different drivers
+ * sharing one build apart.
+ */
+static bool
+shader_cache_compute_key(struct gl_context *ctx,
+                         struct gl_shader_program *prog,
+                         char sha1_hex[41])
+{
+   struct mesa_sha1 *sha1_ctx;
+   unsigned char sha1[20];
+#ifdef PACKAGE_VERSION
+   static const char build_id[] = "glsl_cache_v1 " PACKAGE_VERSION;
+#else
+   static const char build_id[] = "glsl_cache_v1";
+#endif
+
+   sha1_ctx = _mesa_sha1_init();
+   if (sha1_ctx == NULL)
+      return false;
+
+   _mesa_sha1_update(sha1_ctx, build_id, sizeof(build_id));
+
+   const uint32_t context_state[] = {
+      (uint32_t) ctx->API,
+      ctx->Const.GLSLVersion,
+      ctx->Const.NativeIntegers,
+      ctx->Const.VertexID_is_zero_based,
+      ctx->Const.UniformBufferOffsetAlignment,
+      (uint32_t) ctx->Const.MaxPatchVertices,
+      prog->SeparateShader,
+      prog->TransformFeedback.BufferMode,
+      prog->TransformFeedback.NumVarying,
+   };
+   _mesa_sha1_update(sha1_ctx, context_state, sizeof(context_state));
+
+   /* The extension enables decide what the front end accepts and which
+    * built-ins exist, and they differ per driver and per device on the
+    * same Mesa build.  Hash the block of booleans only; the struct's
+    * String member is a pointer.
+    */
+   _mesa_sha1_update(sha1_ctx, &ctx->Extensions,
+                     offsetof(struct gl_extensions, extension_sentinel));
+
+   if (ctx->Driver.GetString != NULL) {
+      const GLubyte *renderer = ctx->Driver.GetString(ctx, GL_RENDERER);
+      if (renderer != NULL)
+         _mesa_sha1_update(sha1_ctx, renderer,
+                           strlen((const char *) renderer) + 1);
+   }
+
+   _mesa_sha1_update(sha1_ctx, prog->TransformFeedback.BufferStride,
+                     sizeof(prog->TransformFeedback.BufferStride));
+
+   for (unsigned i = 0; i < prog->TransformFeedback.NumVarying; i++) {
+      const char *name = prog->TransformFeedback.VaryingNames[i];
+      _mesa_sha1_update(sha1_ctx, name, strlen(name) + 1);
+   }
+
+   for (unsigned i = 0; i < prog->NumShaders; i++) {
+      struct gl_shader *sh = prog->Shaders[i];
+      uint32_t stage = sh->Stage;
+
+      if (sh->Source == NULL) {
+         free(sha1_ctx);
+         return false;
+      }
+      _mesa_sha1_update(sha1_ctx, &stage, sizeof(stage));
+      _mesa_sha1_update(sha1_ctx, sh->Source, strlen(sh->Source) + 1);
+   }
+
+   if (!_mesa_sha1_final(sha1_ctx, sha1))
+      return false;
+
+   _mesa_sha1_format(sha1_hex, sha1);
+   return true;
+}
+
+static bool
+shader_cache_get_item_path(struct gl_context *ctx,
+                           struct gl_shader_program *prog,
+                           char *path, size_t size, bool create_dirs)
+{
+   char dir[PATH_MAX];
+   char sha1_hex[41];
+
+   if (getenv("MESA_GLSL_CACHE_DISABLE") != NULL)
+      return false;
+
+   if (!shader_cache_get_dir(dir, sizeof(dir)))
+      return false;
+
+   if (!shader_cache_compute_key(ctx, prog, sha1_hex))
+      return false;
+
+   if (create_dirs) {
+      mkdir(dir, 0755);
+
+      char subdir[PATH_MAX];
+      if (snprintf(subdir, sizeof(subdir), "%s/%c%c",
+                   dir, sha1_hex[0], sha1_hex[1]) >= (int) sizeof(subdir))
+         return false;
+      mkdir(subdir, 0755);
+   }
+
+   if (snprintf(path, size, "%s/%c%c/%s.bin",
+                dir, sha1_hex[0], sha1_hex[1], sha1_hex + 2) >= (int) size)
+      return false;
+
+   return true;
+}
+
+static void
+write_shader_metadata(struct blob *blob, struct gl_shader *sh)
+{
+   blob_write_uint32(blob, sh->Type);
+   blob_write_uint32(blob, sh->Version);
+   blob_write_uint32(blob,
+                     sh->uses_builtin_functions
+                     | sh->uses_gl_fragcoord << 1
+                     | sh->redeclares_gl_fragcoord << 2
+                     | sh->ARB_fragment_coord_conventions_enable << 3
+                     | sh->origin_upper_left << 4
+                     | sh->pixel_center_integer << 5
+                     | sh->EarlyFragmentTests << 6);
+   blob_write_bytes(blob, &sh->TransformFeedback,
+                    sizeof(sh->TransformFeedback));
+   blob_write_bytes(blob, &sh->TessCtrl, sizeof(sh->TessCtrl));
+   blob_write_bytes(blob, &sh->TessEval, sizeof(sh->TessEval));
+   blob_write_bytes(blob, &sh->Geom, sizeof(sh->Geom));
+   blob_write_bytes(blob, &sh->Comp, sizeof(sh->Comp));
+}
+
+static void
+read_shader_metadata(struct blob_reader *blob, struct gl_shader *sh)
+{
+   sh->Version = blob_read_uint32(blob);
+
+   uint32_t flags = blob_read_uint32(blob);
+   sh->uses_builtin_functions = flags & 0x1;
+   sh->uses_gl_fragcoord = (flags >> 1) & 0x1;
+   sh->redeclares_gl_fragcoord = (flags >> 2) & 0x1;
+   sh->ARB_fragment_coord_conventions_enable = (flags >> 3) & 0x1;
+   sh->origin_upper_left = (flags >> 4) & 0x1;
+   sh->pixel_center_integer = (flags >> 5) & 0x1;
+   sh->EarlyFragmentTests = (flags >> 6) & 0x1;
+
+   blob_copy_bytes(blob, (uint8_t *) &sh->TransformFeedback,
+                   sizeof(sh->TransformFeedback));
+   blob_copy_bytes(blob, (uint8_t *) &sh->TessCtrl, sizeof(sh->TessCtrl));
+   blob_copy_bytes(blob, (uint8_t *) &sh->TessEval, sizeof(sh->TessEval));
+   blob_copy_bytes(blob, (uint8_t *) &sh->Geom, sizeof(sh->Geom));
+   blob_copy_bytes(blob, (uint8_t *) &sh->Comp, sizeof(sh->Comp));
+}
+
+static void
+write_uniform_blocks(struct blob *blob, struct gl_uniform_block **blocks,
+                     unsigned num_blocks)
+{
+   blob_write_uint32(blob, num_blocks);
+
+   for (unsigned i = 0; i < num_blocks; i++) {
+      struct gl_uniform_block *block = blocks[i];
+
+      blob_write_string(blob, block->Name);
+      blob_write_uint32(blob, block->Binding);
+      blob_write_uint32(blob, block->UniformBufferSize);
+      blob_write_uint32(blob, block->stageref);
+      blob_write_uint32(blob, block->_Packing);
+
+      blob_write_uint32(blob, block->NumUniforms);
+      for (unsigned j = 0; j < block->NumUniforms; j++) {
+         struct gl_uniform_buffer_variable *ubo_var = &block->Uniforms[j];
+
+         blob_write_string(blob, ubo_var->Name);
+         blob_write_string(blob, ubo_var->IndexName);
+         serialize_glsl_type(blob, ubo_var->Type);
+         blob_write_uint32(blob, ubo_var->Offset);
+         blob_write_uint32(blob, ubo_var->RowMajor);
+      }
+   }
+}
+
+static bool
+read_uniform_blocks(struct blob_reader *blob, struct gl_shader *sh,
+                    struct gl_uniform_block ***out_blocks,
+                    unsigned *out_num_blocks)
+{
+   unsigned num_blocks = blob_read_uint32(blob);
+
+   struct gl_uniform_block **block_ptrs =
+      ralloc_array(sh, struct gl_uniform_block *, num_blocks);
+   struct gl_uniform_block *blocks =
+      rzalloc_array(sh, struct gl_uniform_block, num_blocks);
+
+   for (unsigned i = 0; i < num_blocks; i++) {
+      struct gl_uniform_block *block = &blocks[i];
+      char *name = blob_read_string(blob);
+
+      if (name == NULL || blob->overrun)
+         return false;
+
+      block->Name = ralloc_strdup(blocks, name);
+      block->Binding = blob_read_uint32(blob);
+      block->UniformBufferSize = blob_read_uint32(blob);
+      block->stageref = blob_read_uint32(blob);
+      block->_Packing =
+         (enum gl_uniform_block_packing) blob_read_uint32(blob);
+
+      block->NumUniforms = blob_read_uint32(blob);
+      block->Uniforms = rzalloc_array(blocks,
+                                      struct gl_uniform_buffer_variable,
+                                      block->NumUniforms);
+      for (unsigned j = 0; j < block->NumUniforms; j++) {
+         struct gl_uniform_buffer_variable *ubo_var = &block->Uniforms[j];
+         char *var_name = blob_read_string(blob);
+         char *index_name = blob_read_string(blob);
+
+         if (var_name == NULL || index_name == NULL)
+            return false;
+
+         ubo_var->Name = ralloc_strdup(block->Uniforms, var_name);
+         ubo_var->IndexName = ralloc_strdup(block->Uniforms, index_name);
+         ubo_var->Type = deserialize_glsl_type(blob);
+         ubo_var->Offset = blob_read_uint32(blob);
+         ubo_var->RowMajor = blob_read_uint32(blob);
+
+         if (ubo_var->Type == NULL)
+            return false;
+      }
+
+      block_ptrs[i] = block;
+   }
+
+   *out_blocks = block_ptrs;
+   *out_num_blocks = num_blocks;
+   return !blob->overrun;
+}
+
+static uint64_t
+shader_cache_max_size(const char *dir)
+{
+   const char *env;
+   struct statvfs vfs;
+
+   if ((env = getenv("MESA_GLSL_CACHE_MAX_SIZE")) != NULL) {
+      char *end;
+      uint64_t size = strtoull(env, &end, 10);
+
+      switch (*end) {
+      case 'K': case 'k':
+         size *= 1024;
+         break;
+      case 'M': case 'm':
+         size *= 1024 * 1024;
+         break;
+      case 'G': case 'g':
+         size *= 1024 * 1024 * 1024ull;
+         break;
+      default:
+         break;
+      }
+      if (size > 0)
+         return size;
+   }
+
+   /* Default to a tenth of the filesystem holding the cache. */
+   if (statvfs(dir, &vfs) == 0)
+      return (uint64_t) vfs.f_blocks * vfs.f_frsize / 10;
+
+   return 1024 * 1024 * 1024ull;
+}
+
+/**
+ * Map the shared running total of cached bytes kept in <dir>/size.
+ *
+ * Every process using the cache updates the same mapping with atomic
+ * adds, so no lock is needed and the total survives across runs without
+ * ever walking the directory tree.
+ */
+static uint64_t *
+shader_cache_open_size(const char *dir, int *fd_out)
+{
+   char size_path[PATH_MAX];
+   struct stat sb;
+   uint64_t *size;
+   int fd;
+
+   if (snprintf(size_path, sizeof(size_path), "%s/size",
+                dir) >= (int) sizeof(size_path))
+      return NULL;
+
+   fd = open(size_path, O_RDWR | O_CREAT, 0644);
+   if (fd < 0)
+      return NULL;
+
+   if (fstat(fd, &sb) != 0 ||
+       (sb.st_size < (off_t) sizeof(*size) &&
+        ftruncate(fd, sizeof(*size)) != 0)) {
+      close(fd);
+      return NULL;
+   }
+
+   size = (uint64_t *) mmap(NULL, sizeof(*size), PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+   if (size == MAP_FAILED) {
+      close(fd);
+      return NULL;
+   }
+
+   *fd_out = fd;
+   return size;
+}
+
+/**
+ * Unlink one cache entry chosen uniformly at random.
+ *
+ * The SHA-1 key spreads entries uniformly over the two-character prefix
+ * directories, so deleting any file from a random prefix is a uniform
+ * random eviction without enumerating the whole cache.
+ */
+static void
+shader_cache_evict_random_item(const char *dir, uint64_t *size)
+{
+   char subdir[PATH_MAX];
+   char path[PATH_MAX];
+   struct dirent *entry;
+   struct stat sb;
+   DIR *d;
+
+   if (snprintf(subdir, sizeof(subdir), "%s/%02x",
+                dir, rand() & 0xff) >= (int) sizeof(subdir))
+      return;
+
+   d = opendir(subdir);
+   if (d == NULL)
+      return;
+
+   while ((entry = readdir(d)) != NULL) {
+      if (entry->d_name[0] == '.')
+         continue;
+
+      if (snprintf(path, sizeof(path), "%s/%s",
+                   subdir, entry->d_name) >= (int) sizeof(path))
+         continue;
+
+      if (stat(path, &sb) == 0 && S_ISREG(sb.st_mode) &&
+          unlink(path) == 0) {
+         p_atomic_add(size, -(int64_t) sb.st_size);
+         break;
+      }
+   }
+
+   closedir(d);
+}
+
+/**
+ * Charge \c written bytes against the cache and evict random entries
+ * while it exceeds its size limit.
+ *
+ * The total is approximate - rewriting an entry under an existing key
+ * charges it twice - but eviction pulls the directory back toward the
+ * limit regardless, so the error never compounds.
+ */
+static void
+shader_cache_trim(uint64_t written)
+{
+   char dir[PATH_MAX];
+   uint64_t *size;
+   int fd;
+
+   if (!shader_cache_get_dir(dir, sizeof(dir)))
+      return;
+
+   size = shader_cache_open_size(dir, &fd);
+   if (size == NULL)
+      return;
+
+   p_atomic_add(size, written);
+
+   const uint64_t max_size = shader_cache_max_size(dir);
+   for (unsigned i = 0; *size > max_size && i < 8; i++)
+      shader_cache_evict_random_item(dir, size);
+
+   munmap(size, sizeof(*size));
+   close(fd);
+}
+
+void
+shader_cache_write_program(struct gl_context *ctx,
+                           struct gl_shader_program *prog)
+{
+   char path[PATH_MAX];
+   char tmp_path[PATH_MAX];
+
+   if (!shader_cache_get_item_path(ctx, prog, path, sizeof(path), true))
+      return;
+
+   struct blob *blob = blob_create(NULL);
+   if (blob == NULL)
+      return;
+
+   blob_write_uint32(blob, CACHE_MAGIC);
+   blob_write_uint32(blob, CACHE_VERSION);
+
+   blob_write_bytes(blob, &prog->TessCtrl, sizeof(prog->TessCtrl));
+   blob_write_bytes(blob, &prog->TessEval, sizeof(prog->TessEval));
+   blob_write_bytes(blob, &prog->Geom, sizeof(prog->Geom));
+   blob_write_bytes(blob, &prog->Vert, sizeof(prog->Vert));
+   blob_write_bytes(blob, &prog->Comp, sizeof(prog->Comp));
+   blob_write_uint32(blob, prog->FragDepthLayout);
+
+   uint32_t stage_mask = 0;
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] != NULL)
+         stage_mask |= 1u << i;
+   }
+   blob_write_uint32(blob, stage_mask);
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      struct gl_shader *sh = prog->_LinkedShaders[i];
+
+      if (sh == NULL)
+         continue;
+
+      write_shader_metadata(blob, sh);
+      write_uniform_blocks(blob, sh->UniformBlocks, sh->NumUniformBlocks);
+      write_uniform_blocks(blob, sh->ShaderStorageBlocks,
+                           sh->NumShaderStorageBlocks);
+      serialize_glsl_ir(blob, sh->ir);
+   }
+
+   /* Write to a temporary in the same directory and rename it into place
+    * so that concurrent linkers never observe a partial entry.
+    */
+   if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.%d",
+                path, (int) getpid()) < (int) sizeof(tmp_path)) {
+      FILE *f = fopen(tmp_path, "wb");
+      if (f != NULL) {
+         if (fwrite(blob->data, 1, blob->size, f) == blob->size) {
+            fclose(f);
+            if (rename(tmp_path, path) == 0)
+               shader_cache_trim(blob->size);
+         } else {
+            fclose(f);
+            unlink(tmp_path);
+         }
+      }
+   }
+
+   ralloc_free(blob);
+}
+
+bool
+shader_cache_read_program(struct gl_context *ctx,
+                          struct gl_shader_program *prog)
+{
+   char path[PATH_MAX];
+   struct blob_reader blob;
+   uint8_t *data;
+   long size;
+   FILE *f;
+   bool success = false;
+
+   if (!shader_cache_get_item_path(ctx, prog, path, sizeof(path), false))
+      return false;
+
+   f = fopen(path, "rb");
+   if (f == NULL)
+      return false;
+
+   if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) <= 0 ||
+       fseek(f, 0, SEEK_SET) != 0) {
+      fclose(f);
+      return false;
+   }
+
+   data = (uint8_t *) malloc(size);
+   if (data == NULL || fread(data, 1, size, f) != (size_t) size) {
+      free(data);
+      fclose(f);
+      return false;
+   }
+   fclose(f);
+
+   blob_reader_init(&blob, data, size);
+
+   if (blob_read_uint32(&blob) != CACHE_MAGIC ||
+       blob_read_uint32(&blob) != CACHE_VERSION)
+      goto fail;
+
+   blob_copy_bytes(&blob, (uint8_t *) &prog->TessCtrl,
+                   sizeof(prog->TessCtrl));
+   blob_copy_bytes(&blob, (uint8_t *) &prog->TessEval,
+                   sizeof(prog->TessEval));
+   blob_copy_bytes(&blob, (uint8_t *) &prog->Geom, sizeof(prog->Geom));
+   blob_copy_bytes(&blob, (uint8_t *) &prog->Vert, sizeof(prog->Vert));
+   blob_copy_bytes(&blob, (uint8_t *) &prog->Comp, sizeof(prog->Comp));
+   prog->FragDepthLayout =
+      (enum gl_frag_depth_layout) blob_read_uint32(&blob);
+
+   {
+      uint32_t stage_mask = blob_read_uint32(&blob);
+
+      if (blob.overrun)
+         goto fail;
+
+      for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+         if (!(stage_mask & (1u << i)))
+            continue;
+
+         uint32_t type = blob_read_uint32(&blob);
+         struct gl_shader *sh = ctx->Driver.NewShader(NULL, 0, type);
+         if (sh == NULL)
+            goto fail;
+
+         read_shader_metadata(&blob, sh);
+
+         if (!read_uniform_blocks(&blob, sh, &sh->UniformBlocks,
+                                  &sh->NumUniformBlocks) ||
+             !read_uniform_blocks(&blob, sh, &sh->ShaderStorageBlocks,
+                                  &sh->NumShaderStorageBlocks)) {
+            _mesa_delete_shader(ctx, sh);
+            goto fail;
+         }
+
+         sh->ir = new(sh) exec_list;
+         if (!deserialize_glsl_ir(&blob, sh->ir, sh)) {
+            _mesa_delete_shader(ctx, sh);
+            goto fail;
+         }
+
+         _mesa_reference_shader(ctx, &prog->_LinkedShaders[i], sh);
+      }
+   }
+
+   success = blob.current == blob.end && !blob.overrun;
+
+fail:
+   if (!success) {
+      for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+         if (prog->_LinkedShaders[i] != NULL)
+            _mesa_reference_shader(ctx, &prog->_LinkedShaders[i], NULL);
+      }
+   }
+   free(data);
+   return success;
+}
+
+#endif /* !_WIN32 */
@@ -0,0 +1,58 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+struct gl_context;
+struct gl_shader_program;
+
+/**
+ * \file shader_cache.h
+ *
+ * On-disk cache of linked per-stage GLSL IR, keyed by a hash of the
+ * attached shader sources and the state that feeds the linker.  See
+ * shader_cache.cpp for the key and payload details.
+ */
+
+bool
+shader_cache_read_program(struct gl_context *ctx,
+                          struct gl_shader_program *prog);
+
+void
+shader_cache_write_program(struct gl_context *ctx,
+                           struct gl_shader_program *prog);
+
+#ifndef _WIN32
+/**
+ * Resolve the cache directory ($MESA_GLSL_CACHE_DIR and friends), for other
+ * consumers of the cache directory such as the built-in function image.
+ */
+bool
+shader_cache_get_dir(char *path, size_t size);
+#endif
+
+#endif /* SHADER_CACHE_H */
@@ -25,15 +25,21 @@
 #include "main/macros.h"
 #include "compiler/glsl/glsl_parser_extras.h"
 #include "glsl_types.h"
+#include "glsl/blob.h"
 #include "util/hash_table.h"
 
 
 mtx_t glsl_type::mutex = _MTX_INITIALIZER_NP;
 hash_table *glsl_type::array_types = NULL;
+mtx_t glsl_type::array_types_mutex = _MTX_INITIALIZER_NP;
 hash_table *glsl_type::record_types = NULL;
+mtx_t glsl_type::record_types_mutex = _MTX_INITIALIZER_NP;
 hash_table *glsl_type::interface_types = NULL;
+mtx_t glsl_type::interface_types_mutex = _MTX_INITIALIZER_NP;
 hash_table *glsl_type::function_types = NULL;
+mtx_t glsl_type::function_types_mutex = _MTX_INITIALIZER_NP;
 hash_table *glsl_type::subroutine_types = NULL;
+mtx_t glsl_type::subroutine_types_mutex = _MTX_INITIALIZER_NP;
 void *glsl_type::mem_ctx = NULL;
 
 void
@@ -234,6 +240,19 @@ glsl_type::glsl_type(const char *subroutine_name) :
    mtx_unlock(&glsl_type::mutex);
 }
 
+glsl_type::glsl_type(glsl_base_type base_type,
+                     const glsl_struct_field *fields, unsigned num_fields,
+                     enum glsl_interface_packing packing, const char *name) :
+   gl_type(0),
+   base_type(base_type),
+   sampler_dimensionality(0), sampler_shadow(0), sampler_array(0),
+   sampled_type(0), interface_packing((unsigned) packing),
+   vector_elements(0), matrix_columns(0),
+   length(num_fields), name(name)
+{
+   this->fields.structure = (glsl_struct_field *) fields;
+}
+
 bool
 glsl_type::contains_sampler() const
 {
@@ -827,7 +846,7 @@ glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
    char key[128];
    snprintf(key, sizeof(key), "%p[%u]", (void *) base, array_size);
 
-   mtx_lock(&glsl_type::mutex);
+   mtx_lock(&glsl_type::array_types_mutex);
 
    if (array_types == NULL) {
       array_types = _mesa_hash_table_create(NULL, _mesa_key_hash_string,
@@ -836,20 +855,26 @@ glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
 
    const struct hash_entry *entry = _mesa_hash_table_search(array_types, key);
    if (entry == NULL) {
-      mtx_unlock(&glsl_type::mutex);
+      mtx_unlock(&glsl_type::array_types_mutex);
       const glsl_type *t = new glsl_type(base, array_size);
-      mtx_lock(&glsl_type::mutex);
+      mtx_lock(&glsl_type::array_types_mutex);
 
-      entry = _mesa_hash_table_insert(array_types,
-                                      ralloc_strdup(mem_ctx, key),
-                                      (void *) t);
+      /* Another thread may have created the same type while the cache was
+       * unlocked; keep the instance that got inserted first.
+       */
+      entry = _mesa_hash_table_search(array_types, key);
+      if (entry == NULL) {
+         entry = _mesa_hash_table_insert(array_types,
+                                         ralloc_strdup(array_types, key),
+                                         (void *) t);
+      }
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_ARRAY);
    assert(((glsl_type *) entry->data)->length == array_size);
    assert(((glsl_type *) entry->data)->fields.array == base);
 
-   mtx_unlock(&glsl_type::mutex);
+   mtx_unlock(&glsl_type::array_types_mutex);
 
    return (glsl_type *) entry->data;
 }
@@ -958,6 +983,8 @@ glsl_type::record_key_hash(const void *a)
    uintptr_t hash = key->length;
    unsigned retval;
 
+   hash = (hash * 13) + _mesa_hash_string(key->name);
+
    for (unsigned i = 0; i < key->length; i++) {
       /* casting pointer to uintptr_t */
       hash = (hash * 13 ) + (uintptr_t) key->fields.structure[i].type;
@@ -977,9 +1004,10 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
                                unsigned num_fields,
                                const char *name)
 {
-   const glsl_type key(fields, num_fields, name);
+   const glsl_type key(GLSL_TYPE_STRUCT, fields, num_fields,
+                       (enum glsl_interface_packing) 0, name);
 
-   mtx_lock(&glsl_type::mutex);
+   mtx_lock(&glsl_type::record_types_mutex);
 
    if (record_types == NULL) {
       record_types = _mesa_hash_table_create(NULL, record_key_hash,
@@ -989,18 +1017,20 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
    const struct hash_entry *entry = _mesa_hash_table_search(record_types,
                                                             &key);
    if (entry == NULL) {
-      mtx_unlock(&glsl_type::mutex);
+      mtx_unlock(&glsl_type::record_types_mutex);
       const glsl_type *t = new glsl_type(fields, num_fields, name);
-      mtx_lock(&glsl_type::mutex);
+      mtx_lock(&glsl_type::record_types_mutex);
 
-      entry = _mesa_hash_table_insert(record_types, t, (void *) t);
+      entry = _mesa_hash_table_search(record_types, &key);
+      if (entry == NULL)
+         entry = _mesa_hash_table_insert(record_types, t, (void *) t);
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_STRUCT);
    assert(((glsl_type *) entry->data)->length == num_fields);
    assert(strcmp(((glsl_type *) entry->data)->name, name) == 0);
 
-   mtx_unlock(&glsl_type::mutex);
+   mtx_unlock(&glsl_type::record_types_mutex);
 
    return (glsl_type *) entry->data;
 }
@@ -1012,9 +1042,10 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
                                   enum glsl_interface_packing packing,
                                   const char *block_name)
 {
-   const glsl_type key(fields, num_fields, packing, block_name);
+   const glsl_type key(GLSL_TYPE_INTERFACE, fields, num_fields,
+                       packing, block_name);
 
-   mtx_lock(&glsl_type::mutex);
+   mtx_lock(&glsl_type::interface_types_mutex);
 
    if (interface_types == NULL) {
       interface_types = _mesa_hash_table_create(NULL, record_key_hash,
@@ -1024,19 +1055,21 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
    const struct hash_entry *entry = _mesa_hash_table_search(interface_types,
                                                             &key);
    if (entry == NULL) {
-      mtx_unlock(&glsl_type::mutex);
+      mtx_unlock(&glsl_type::interface_types_mutex);
       const glsl_type *t = new glsl_type(fields, num_fields,
                                          packing, block_name);
-      mtx_lock(&glsl_type::mutex);
+      mtx_lock(&glsl_type::interface_types_mutex);
 
-      entry = _mesa_hash_table_insert(interface_types, t, (void *) t);
+      entry = _mesa_hash_table_search(interface_types, &key);
+      if (entry == NULL)
+         entry = _mesa_hash_table_insert(interface_types, t, (void *) t);
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_INTERFACE);
    assert(((glsl_type *) entry->data)->length == num_fields);
    assert(strcmp(((glsl_type *) entry->data)->name, block_name) == 0);
 
-   mtx_unlock(&glsl_type::mutex);
+   mtx_unlock(&glsl_type::interface_types_mutex);
 
    return (glsl_type *) entry->data;
 }
@@ -1044,9 +1077,10 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
 const glsl_type *
 glsl_type::get_subroutine_instance(const char *subroutine_name)
 {
-   const glsl_type key(subroutine_name);
+   const glsl_type key(GLSL_TYPE_SUBROUTINE, NULL, 0,
+                       (enum glsl_interface_packing) 0, subroutine_name);
 
-   mtx_lock(&glsl_type::mutex);
+   mtx_lock(&glsl_type::subroutine_types_mutex);
 
    if (subroutine_types == NULL) {
       subroutine_types = _mesa_hash_table_create(NULL, record_key_hash,
@@ -1056,17 +1090,19 @@ glsl_type::get_subroutine_instance(const char *subroutine_name)
    const struct hash_entry *entry = _mesa_hash_table_search(subroutine_types,
                                                             &key);
    if (entry == NULL) {
-      mtx_unlock(&glsl_type::mutex);
+      mtx_unlock(&glsl_type::subroutine_types_mutex);
       const glsl_type *t = new glsl_type(subroutine_name);
-      mtx_lock(&glsl_type::mutex);
+      mtx_lock(&glsl_type::subroutine_types_mutex);
 
-      entry = _mesa_hash_table_insert(subroutine_types, t, (void *) t);
+      entry = _mesa_hash_table_search(subroutine_types, &key);
+      if (entry == NULL)
+         entry = _mesa_hash_table_insert(subroutine_types, t, (void *) t);
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_SUBROUTINE);
    assert(strcmp(((glsl_type *) entry->data)->name, subroutine_name) == 0);
 
-   mtx_unlock(&glsl_type::mutex);
+   mtx_unlock(&glsl_type::subroutine_types_mutex);
 
    return (glsl_type *) entry->data;
 }
@@ -1113,7 +1149,7 @@ glsl_type::get_function_instance(const glsl_type *return_type,
 {
    const glsl_type key(return_type, params, num_params);
 
-   mtx_lock(&glsl_type::mutex);
+   mtx_lock(&glsl_type::function_types_mutex);
 
    if (function_types == NULL) {
       function_types = _mesa_hash_table_create(NULL, function_key_hash,
@@ -1122,11 +1158,13 @@ glsl_type::get_function_instance(const glsl_type *return_type,
 
    struct hash_entry *entry = _mesa_hash_table_search(function_types, &key);
    if (entry == NULL) {
-      mtx_unlock(&glsl_type::mutex);
+      mtx_unlock(&glsl_type::function_types_mutex);
       const glsl_type *t = new glsl_type(return_type, params, num_params);
-      mtx_lock(&glsl_type::mutex);
+      mtx_lock(&glsl_type::function_types_mutex);
 
-      entry = _mesa_hash_table_insert(function_types, t, (void *) t);
+      entry = _mesa_hash_table_search(function_types, &key);
+      if (entry == NULL)
+         entry = _mesa_hash_table_insert(function_types, t, (void *) t);
    }
 
    const glsl_type *t = (const glsl_type *)entry->data;
@@ -1134,7 +1172,7 @@ glsl_type::get_function_instance(const glsl_type *return_type,
    assert(t->base_type == GLSL_TYPE_FUNCTION);
    assert(t->length == num_params);
 
-   mtx_unlock(&glsl_type::mutex);
+   mtx_unlock(&glsl_type::function_types_mutex);
 
    return t;
 }
@@ -2014,3 +2052,174 @@ glsl_type::coordinate_components() const
 
 #include "compiler/builtin_type_macros.h"
 /** @} */
+
+void
+encode_type_to_blob(struct blob *blob, const glsl_type *type)
+{
+   if (!type) {
+      blob_write_uint32(blob, 0);
+      return;
+   }
+
+   blob_write_uint32(blob, (uint32_t) type->base_type + 1);
+
+   switch (type->base_type) {
+   case GLSL_TYPE_UINT:
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_FLOAT:
+   case GLSL_TYPE_DOUBLE:
+   case GLSL_TYPE_BOOL:
+      blob_write_uint32(blob, type->vector_elements);
+      blob_write_uint32(blob, type->matrix_columns);
+      break;
+   case GLSL_TYPE_SAMPLER:
+      blob_write_uint32(blob, type->sampler_dimensionality);
+      blob_write_uint32(blob, type->sampler_shadow);
+      blob_write_uint32(blob, type->sampler_array);
+      blob_write_uint32(blob, type->sampled_type);
+      break;
+   case GLSL_TYPE_IMAGE:
+      blob_write_uint32(blob, type->sampler_dimensionality);
+      blob_write_uint32(blob, type->sampler_array);
+      blob_write_uint32(blob, type->sampled_type);
+      break;
+   case GLSL_TYPE_SUBROUTINE:
+      blob_write_string(blob, type->name);
+      break;
+   case GLSL_TYPE_ATOMIC_UINT:
+   case GLSL_TYPE_VOID:
+   case GLSL_TYPE_ERROR:
+      break;
+   case GLSL_TYPE_ARRAY:
+      blob_write_uint32(blob, type->length);
+      encode_type_to_blob(blob, type->fields.array);
+      break;
+   case GLSL_TYPE_STRUCT:
+   case GLSL_TYPE_INTERFACE:
+      blob_write_string(blob, type->name);
+      blob_write_uint32(blob, type->length);
+      for (unsigned i = 0; i < type->length; i++) {
+         const glsl_struct_field *field = &type->fields.structure[i];
+         encode_type_to_blob(blob, field->type);
+         blob_write_string(blob, field->name);
+         blob_write_uint32(blob, field->location);
+         blob_write_uint32(blob, field->offset);
+         blob_write_uint32(blob, field->xfb_buffer);
+         blob_write_uint32(blob, field->xfb_stride);
+         blob_write_uint32(blob,
+                           field->interpolation |
+                           field->centroid << 2 |
+                           field->sample << 3 |
+                           field->matrix_layout << 4 |
+                           field->patch << 6 |
+                           field->precision << 7 |
+                           field->image_read_only << 9 |
+                           field->image_write_only << 10 |
+                           field->image_coherent << 11 |
+                           field->image_volatile << 12 |
+                           field->image_restrict << 13 |
+                           field->explicit_xfb_buffer << 14);
+      }
+      if (type->base_type == GLSL_TYPE_INTERFACE)
+         blob_write_uint32(blob, type->interface_packing);
+      break;
+   default:
+      unreachable("Cannot encode type!");
+   }
+}
+
+const glsl_type *
+decode_type_from_blob(struct blob_reader *blob)
+{
+   uint32_t u = blob_read_uint32(blob);
+
+   if (u == 0)
+      return NULL;
+
+   glsl_base_type base_type = (glsl_base_type) (u - 1);
+
+   switch (base_type) {
+   case GLSL_TYPE_UINT:
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_FLOAT:
+   case GLSL_TYPE_DOUBLE:
+   case GLSL_TYPE_BOOL: {
+      unsigned rows = blob_read_uint32(blob);
+      unsigned cols = blob_read_uint32(blob);
+      return glsl_type::get_instance(base_type, rows, cols);
+   }
+   case GLSL_TYPE_SAMPLER: {
+      enum glsl_sampler_dim dim =
+         (enum glsl_sampler_dim) blob_read_uint32(blob);
+      bool shadow = blob_read_uint32(blob);
+      bool array = blob_read_uint32(blob);
+      glsl_base_type sampled = (glsl_base_type) blob_read_uint32(blob);
+      return glsl_type::get_sampler_instance(dim, shadow, array, sampled);
+   }
+   case GLSL_TYPE_IMAGE: {
+      enum glsl_sampler_dim dim =
+         (enum glsl_sampler_dim) blob_read_uint32(blob);
+      bool array = blob_read_uint32(blob);
+      glsl_base_type sampled = (glsl_base_type) blob_read_uint32(blob);
+      return glsl_type::get_image_instance(dim, array, sampled);
+   }
+   case GLSL_TYPE_SUBROUTINE:
+      return glsl_type::get_subroutine_instance(blob_read_string(blob));
+   case GLSL_TYPE_ATOMIC_UINT:
+      return glsl_type::atomic_uint_type;
+   case GLSL_TYPE_VOID:
+      return glsl_type::void_type;
+   case GLSL_TYPE_ERROR:
+      return glsl_type::error_type;
+   case GLSL_TYPE_ARRAY: {
+      unsigned length = blob_read_uint32(blob);
+      return glsl_type::get_array_instance(decode_type_from_blob(blob),
+                                           length);
+   }
+   case GLSL_TYPE_STRUCT:
+   case GLSL_TYPE_INTERFACE: {
+      char *name = blob_read_string(blob);
+      unsigned num_fields = blob_read_uint32(blob);
+
+      glsl_struct_field *fields =
+         (glsl_struct_field *) malloc(num_fields * sizeof(glsl_struct_field));
+      for (unsigned i = 0; i < num_fields; i++) {
+         fields[i].type = decode_type_from_blob(blob);
+         fields[i].name = blob_read_string(blob);
+         fields[i].location = blob_read_uint32(blob);
+         fields[i].offset = blob_read_uint32(blob);
+         fields[i].xfb_buffer = blob_read_uint32(blob);
+         fields[i].xfb_stride = blob_read_uint32(blob);
+
+         uint32_t qual = blob_read_uint32(blob);
+         fields[i].interpolation = qual & 0x3;
+         fields[i].centroid = (qual >> 2) & 0x1;
+         fields[i].sample = (qual >> 3) & 0x1;
+         fields[i].matrix_layout = (qual >> 4) & 0x3;
+         fields[i].patch = (qual >> 6) & 0x1;
+         fields[i].precision = (qual >> 7) & 0x3;
+         fields[i].image_read_only = (qual >> 9) & 0x1;
+         fields[i].image_write_only = (qual >> 10) & 0x1;
+         fields[i].image_coherent = (qual >> 11) & 0x1;
+         fields[i].image_volatile = (qual >> 12) & 0x1;
+         fields[i].image_restrict = (qual >> 13) & 0x1;
+         fields[i].explicit_xfb_buffer = (qual >> 14) & 0x1;
+      }
+
+      const glsl_type *type;
+      if (base_type == GLSL_TYPE_INTERFACE) {
+         enum glsl_interface_packing packing =
+            (enum glsl_interface_packing) blob_read_uint32(blob);
+         type = glsl_type::get_interface_instance(fields, num_fields,
+                                                  packing, name);
+      } else {
+         type = glsl_type::get_record_instance(fields, num_fields, name);
+      }
+
+      free(fields);
+      return type;
+   }
+   default:
+      unreachable("Cannot decode type!");
+   }
+}
@@ -35,6 +35,9 @@ extern "C" {
 
 struct _mesa_glsl_parse_state;
 struct glsl_symbol_table;
+struct blob;
+struct blob_reader;
+struct glsl_type;
 
 extern void
 _mesa_glsl_initialize_types(struct _mesa_glsl_parse_state *state);
@@ -42,6 +45,10 @@ _mesa_glsl_initialize_types(struct _mesa_glsl_parse_state *state);
 extern void
 _mesa_glsl_release_types(void);
 
+void encode_type_to_blob(struct blob *blob, const struct glsl_type *type);
+
+const struct glsl_type *decode_type_from_blob(struct blob_reader *blob);
+
 #ifdef __cplusplus
 }
 #endif
@@ -747,6 +754,11 @@ struct glsl_type {
 
 private:
 
+   /**
+    * Protects the shared \c mem_ctx against concurrent allocation.  Held
+    * only while a type is being constructed; the instance caches below are
+    * guarded by their own per-cache mutexes.
+    */
    static mtx_t mutex;
 
    /**
@@ -786,20 +798,37 @@ private:
    /** Constructor for subroutine types */
    glsl_type(const char *name);
 
+   /**
+    * Shallow constructor for instance cache lookup keys
+    *
+    * Aliases the caller's field array and name instead of copying them, so
+    * building a key performs no allocation and takes no lock.  Only the
+    * members examined by \c record_key_hash and \c record_key_compare are
+    * meaningful.
+    */
+   glsl_type(glsl_base_type base_type, const glsl_struct_field *fields,
+             unsigned num_fields, enum glsl_interface_packing packing,
+             const char *name);
+
    /** Hash table containing the known array types. */
    static struct hash_table *array_types;
+   static mtx_t array_types_mutex;
 
    /** Hash table containing the known record types. */
    static struct hash_table *record_types;
+   static mtx_t record_types_mutex;
 
    /** Hash table containing the known interface types. */
    static struct hash_table *interface_types;
+   static mtx_t interface_types_mutex;
 
    /** Hash table containing the known subroutine types. */
    static struct hash_table *subroutine_types;
+   static mtx_t subroutine_types_mutex;
 
    /** Hash table containing the known function types. */
    static struct hash_table *function_types;
+   static mtx_t function_types_mutex;
 
    static bool record_key_compare(const void *a, const void *b);
    static unsigned record_key_hash(const void *key);
@@ -57,6 +57,8 @@ nir_shader_create(void *mem_ctx,
 
    shader->stage = stage;
 
+   shader->instr_pool = ralloc_pool_context(shader);
+
    return shader;
 }
 
@@ -283,6 +285,9 @@ nir_function_impl_create_bare(nir_shader *shader)
    impl->reg_alloc = 0;
    impl->ssa_alloc = 0;
    impl->valid_metadata = nir_metadata_none;
+   impl->dirty_blocks = NULL;
+   impl->live_ssa_alloc = 0;
+   impl->live_ssa_defs = 0;
 
    /* create start & end blocks */
    nir_block *start_block = nir_block_create(shader);
@@ -442,12 +447,23 @@ alu_src_init(nir_alu_src *src)
    src->swizzle[3] = 3;
 }
 
+/* All instructions are carved out of the shader's instruction pool so that
+ * they end up tightly packed in allocation (i.e. program) order, which makes
+ * walking them in the optimization loops far friendlier to the cache than
+ * individual heap allocations.
+ */
+static void *
+instr_alloc(nir_shader *shader, size_t size)
+{
+   return rzalloc_pool_size(shader->instr_pool, size);
+}
+
 nir_alu_instr *
 nir_alu_instr_create(nir_shader *shader, nir_op op)
 {
    unsigned num_srcs = nir_op_infos[op].num_inputs;
    nir_alu_instr *instr =
-      ralloc_size(shader,
+      instr_alloc(shader,
                   sizeof(nir_alu_instr) + num_srcs * sizeof(nir_alu_src));
 
    instr_init(&instr->instr, nir_instr_type_alu);
@@ -462,7 +478,7 @@ nir_alu_instr_create(nir_shader *shader, nir_op op)
 nir_jump_instr *
 nir_jump_instr_create(nir_shader *shader, nir_jump_type type)
 {
-   nir_jump_instr *instr = ralloc(shader, nir_jump_instr);
+   nir_jump_instr *instr = instr_alloc(shader, sizeof(nir_jump_instr));
    instr_init(&instr->instr, nir_instr_type_jump);
    instr->type = type;
    return instr;
@@ -472,7 +488,7 @@ nir_load_const_instr *
 nir_load_const_instr_create(nir_shader *shader, unsigned num_components,
                             unsigned bit_size)
 {
-   nir_load_const_instr *instr = ralloc(shader, nir_load_const_instr);
+   nir_load_const_instr *instr = instr_alloc(shader, sizeof(nir_load_const_instr));
    instr_init(&instr->instr, nir_instr_type_load_const);
 
    nir_ssa_def_init(&instr->instr, &instr->def, num_components, bit_size, NULL);
@@ -485,7 +501,7 @@ nir_intrinsic_instr_create(nir_shader *shader, nir_intrinsic_op op)
 {
    unsigned num_srcs = nir_intrinsic_infos[op].num_srcs;
    nir_intrinsic_instr *instr =
-      ralloc_size(shader,
+      instr_alloc(shader,
                   sizeof(nir_intrinsic_instr) + num_srcs * sizeof(nir_src));
 
    instr_init(&instr->instr, nir_instr_type_intrinsic);
@@ -503,7 +519,7 @@ nir_intrinsic_instr_create(nir_shader *shader, nir_intrinsic_op op)
 nir_call_instr *
 nir_call_instr_create(nir_shader *shader, nir_function *callee)
 {
-   nir_call_instr *instr = ralloc(shader, nir_call_instr);
+   nir_call_instr *instr = instr_alloc(shader, sizeof(nir_call_instr));
    instr_init(&instr->instr, nir_instr_type_call);
 
    instr->callee = callee;
@@ -517,7 +533,7 @@ nir_call_instr_create(nir_shader *shader, nir_function *callee)
 nir_tex_instr *
 nir_tex_instr_create(nir_shader *shader, unsigned num_srcs)
 {
-   nir_tex_instr *instr = rzalloc(shader, nir_tex_instr);
+   nir_tex_instr *instr = instr_alloc(shader, sizeof(nir_tex_instr));
    instr_init(&instr->instr, nir_instr_type_tex);
 
    dest_init(&instr->dest);
@@ -539,7 +555,7 @@ nir_tex_instr_create(nir_shader *shader, unsigned num_srcs)
 nir_phi_instr *
 nir_phi_instr_create(nir_shader *shader)
 {
-   nir_phi_instr *instr = ralloc(shader, nir_phi_instr);
+   nir_phi_instr *instr = instr_alloc(shader, sizeof(nir_phi_instr));
    instr_init(&instr->instr, nir_instr_type_phi);
 
    dest_init(&instr->dest);
@@ -550,7 +566,7 @@ nir_phi_instr_create(nir_shader *shader)
 nir_parallel_copy_instr *
 nir_parallel_copy_instr_create(nir_shader *shader)
 {
-   nir_parallel_copy_instr *instr = ralloc(shader, nir_parallel_copy_instr);
+   nir_parallel_copy_instr *instr = instr_alloc(shader, sizeof(nir_parallel_copy_instr));
    instr_init(&instr->instr, nir_instr_type_parallel_copy);
 
    exec_list_make_empty(&instr->entries);
@@ -563,7 +579,7 @@ nir_ssa_undef_instr_create(nir_shader *shader,
                            unsigned num_components,
                            unsigned bit_size)
 {
-   nir_ssa_undef_instr *instr = ralloc(shader, nir_ssa_undef_instr);
+   nir_ssa_undef_instr *instr = instr_alloc(shader, sizeof(nir_ssa_undef_instr));
    instr_init(&instr->instr, nir_instr_type_ssa_undef);
 
    nir_ssa_def_init(&instr->instr, &instr->def, num_components, bit_size, NULL);
@@ -1550,6 +1550,19 @@ typedef struct {
    unsigned num_blocks;
 
    nir_metadata valid_metadata;
+
+   /** Set of blocks whose instructions have changed since the metadata was
+    * last computed; filled in by nir_metadata_dirty_block() and consumed by
+    * nir_metadata_repair().  NULL when no blocks have been marked dirty.
+    */
+   struct set *dirty_blocks;
+
+   /* Snapshots of the SSA def index space taken by the last full liveness
+    * computation; they let nir_live_ssa_defs_update_impl() tell defs created
+    * since then apart from ones the existing live sets already cover.
+    */
+   unsigned live_ssa_alloc;
+   unsigned live_ssa_defs;
 } nir_function_impl;
 
 ATTRIBUTE_RETURNS_NONNULL static inline nir_block *
@@ -1827,6 +1840,16 @@ typedef struct nir_shader {
 
    /** The shader stage, such as MESA_SHADER_VERTEX. */
    gl_shader_stage stage;
+
+   /** Pool that instructions are bump-allocated from.
+    *
+    * Instructions are carved out of slabs owned by this context so that the
+    * instructions of a function are contiguous in program order instead of
+    * scattered across the heap, and so that they are all torn down in one go
+    * with the shader.  Note that as a consequence, removing an instruction
+    * only returns its slab space to the system once the shader is freed.
+    */
+   void *instr_pool;
 } nir_shader;
 
 static inline nir_function *
@@ -1891,6 +1914,10 @@ nir_function_impl *nir_cf_node_get_function(nir_cf_node *node);
 void nir_metadata_require(nir_function_impl *impl, nir_metadata required);
 /** dirties all but the preserved metadata */
 void nir_metadata_preserve(nir_function_impl *impl, nir_metadata preserved);
+/** records that the instructions of the given block have changed */
+void nir_metadata_dirty_block(nir_function_impl *impl, nir_block *block);
+/** repairs analyses after a pass that changed instructions but not the CFG */
+void nir_metadata_repair(nir_function_impl *impl);
 
 /** creates an instruction with default swizzle/writemask/etc. with NULL registers */
 nir_alu_instr *nir_alu_instr_create(nir_shader *shader, nir_op op);
@@ -2213,6 +2240,8 @@ unsigned nir_index_instrs(nir_function_impl *impl);
 
 void nir_index_blocks(nir_function_impl *impl);
 
+uint64_t nir_shader_hash(nir_shader *shader);
+
 void nir_print_shader(nir_shader *shader, FILE *fp);
 void nir_print_shader_annotated(nir_shader *shader, FILE *fp, struct hash_table *errors);
 void nir_print_instr(const nir_instr *instr, FILE *fp);
@@ -2244,6 +2273,11 @@ static inline void nir_metadata_check_validation_flag(nir_shader *shader) { (voi
 static inline bool should_clone_nir(void) { return false; }
 #endif /* DEBUG */
 
+/** Per-pass statistics, enabled with NIR_PASS_STATS (see nir_pass_stats.c) */
+bool nir_pass_stats_enabled(void);
+void nir_pass_stats_begin(nir_shader *shader);
+void nir_pass_stats_end(nir_shader *shader, const char *pass_name);
+
 #define _PASS(nir, do_pass) do {                                     \
    do_pass                                                           \
    nir_validate_shader(nir);                                         \
@@ -2256,14 +2290,18 @@ static inline bool should_clone_nir(void) { return false; }
 
 #define NIR_PASS(progress, nir, pass, ...) _PASS(nir,                \
    nir_metadata_set_validation_flag(nir);                            \
+   nir_pass_stats_begin(nir);                                        \
    if (pass(nir, ##__VA_ARGS__)) {                                   \
       progress = true;                                               \
       nir_metadata_check_validation_flag(nir);                       \
    }                                                                 \
+   nir_pass_stats_end(nir, #pass);                                   \
 )
 
 #define NIR_PASS_V(nir, pass, ...) _PASS(nir,                        \
+   nir_pass_stats_begin(nir);                                        \
    pass(nir, ##__VA_ARGS__);                                         \
+   nir_pass_stats_end(nir, #pass);                                   \
 )
 
 void nir_calc_dominance_impl(nir_function_impl *impl);
@@ -2461,6 +2499,7 @@ void nir_lower_double_pack(nir_shader *shader);
 bool nir_normalize_cubemap_coords(nir_shader *shader);
 
 void nir_live_ssa_defs_impl(nir_function_impl *impl);
+void nir_live_ssa_defs_update_impl(nir_function_impl *impl);
 bool nir_ssa_defs_interfere(nir_ssa_def *a, nir_ssa_def *b);
 
 void nir_convert_to_ssa_impl(nir_function_impl *impl);
@@ -2487,6 +2526,8 @@ bool nir_opt_cse(nir_shader *shader);
 
 bool nir_opt_dce(nir_shader *shader);
 
+bool nir_opt_dce_cse(nir_shader *shader);
+
 bool nir_opt_dead_cf(nir_shader *shader);
 
 void nir_opt_gcm(nir_shader *shader);
@@ -2498,6 +2539,7 @@ bool nir_opt_remove_phis(nir_shader *shader);
 bool nir_opt_undef(nir_shader *shader);
 
 void nir_sweep(nir_shader *shader);
+void nir_compact(nir_shader *shader);
 
 nir_intrinsic_op nir_intrinsic_from_system_value(gl_system_value val);
 gl_system_value nir_system_value_from_intrinsic(nir_intrinsic_op intrin);
@@ -490,7 +490,164 @@ class SearchAndReplace(object):
 
       BitSizeValidator(varset).validate(self.search, self.replace)
 
+class TreeAutomaton(object):
+   """Computes a bottom-up tree automaton for pre-filtering the transforms.
+
+   Interpreting the nir_search expression trees at runtime means matching
+   every ALU instruction against every pattern for its opcode, recursing
+   into the sources each time.  Instead, we precompute a tree automaton in
+   the style of Hoffmann and O'Donnell's "Pattern Matching in Trees": every
+   SSA def is assigned a state summarizing the set of search subexpressions
+   it could be the root of, and the state of an ALU def is a pure function
+   of its opcode and the states of its sources, looked up from a table.
+   The expensive recursive matcher then only runs on instructions whose
+   state says some pattern can possibly apply.
+
+   The automaton only looks at opcodes and source structure; constant
+   values, bit sizes, exactness and repeated-variable constraints are still
+   checked by nir_replace_instr(), so states may only ever over-approximate
+   the set of matching patterns, never miss one.
+
+   Items are the structurally-distinct subexpressions of all the search
+   patterns, plus two terminals: a wildcard that matches any value and a
+   constant that matches any load_const (and hence any "#"-qualified
+   variable).  A state is a set of items; since everything matches the
+   wildcard, it is left implicit.  States are found as the least fixed
+   point of the transition function, and per-opcode filters collapse states
+   that the opcode cannot tell apart so the transition tables stay small.
+   """
+
+   WILDCARD = 0
+   CONSTANT = 1
+
+   def __init__(self, transforms):
+      self.transforms = transforms
+
+      self._item_keys = {}
+      self._items = []
+      self._get_item(('__wildcard',))
+      self._get_item(('__constant',))
+
+      self._root_items = [self._add_pattern(t.search) for t in transforms]
+
+      # opcode -> list of ids of items rooted in that opcode
+      self._ops = {}
+      for item_id, key in enumerate(self._items):
+         if not key[0].startswith('__'):
+            self._ops.setdefault(key[0], []).append(item_id)
+
+      self._build_states()
+      self._build_tables()
+
+   def _get_item(self, key):
+      if key not in self._item_keys:
+         self._item_keys[key] = len(self._items)
+         self._items.append(key)
+      return self._item_keys[key]
+
+   def _add_pattern(self, val):
+      if isinstance(val, Constant):
+         return self.CONSTANT
+      elif isinstance(val, Variable):
+         return self.CONSTANT if val.is_constant else self.WILDCARD
+      else:
+         assert isinstance(val, Expression)
+         children = tuple(self._add_pattern(src) for src in val.sources)
+         return self._get_item((val.opcode,) + children)
+
+   def _matches(self, item, state_proj):
+      return item == self.WILDCARD or item in state_proj
+
+   def _children_match(self, opcode, children, state_projs):
+      if all(self._matches(c, p) for c, p in zip(children, state_projs)):
+         return True
+
+      # nir_search tries both source orders for commutative instructions,
+      # so the automaton has to as well.
+      if len(children) == 2 and \
+         'commutative' in opcodes[opcode].algebraic_properties:
+         return self._matches(children[0], state_projs[1]) and \
+                self._matches(children[1], state_projs[0])
+
+      return False
+
+   def _op_filter(self, opcode, states):
+      """Project the given states onto the set of items the opcode can
+      distinguish, returning a per-state class index and the list of
+      distinct projections.
+      """
+      relevant = set()
+      for item_id in self._ops[opcode]:
+         relevant.update(self._items[item_id][1:])
+
+      proj_ids = {}
+      projs = []
+      filter = []
+      for state in states:
+         proj = frozenset(state & relevant)
+         if proj not in proj_ids:
+            proj_ids[proj] = len(projs)
+            projs.append(proj)
+         filter.append(proj_ids[proj])
+
+      return filter, projs
+
+   def _transition(self, opcode, state_projs):
+      result = set()
+      for item_id in self._ops[opcode]:
+         if self._children_match(opcode, self._items[item_id][1:],
+                                 state_projs):
+            result.add(item_id)
+      return frozenset(result)
+
+   def _build_states(self):
+      # State 0 matches nothing but the wildcard; state 1 is the state of
+      # every load_const.  The runtime depends on those two indices.
+      self.states = [frozenset(), frozenset([self.CONSTANT])]
+      self._state_ids = {self.states[0]: 0, self.states[1]: 1}
+
+      changed = True
+      while changed:
+         changed = False
+         for opcode, op_items in self._ops.iteritems():
+            num_srcs = len(self._items[op_items[0]]) - 1
+            _, projs = self._op_filter(opcode, self.states)
+
+            for srcs in itertools.product(projs, repeat=num_srcs):
+               state = self._transition(opcode, srcs)
+               if state not in self._state_ids:
+                  self._state_ids[state] = len(self.states)
+                  self.states.append(state)
+                  changed = True
+
+      # The runtime uses uint16_t states with 0xffff as a sentinel.
+      assert len(self.states) < 0xffff
+
+   def _build_tables(self):
+      self.opcode_tables = {}
+      for opcode, op_items in sorted(self._ops.iteritems()):
+         num_srcs = len(self._items[op_items[0]]) - 1
+         filter, projs = self._op_filter(opcode, self.states)
+
+         table = []
+         for srcs in itertools.product(projs, repeat=num_srcs):
+            table.append(self._state_ids[self._transition(opcode, srcs)])
+
+         self.opcode_tables[opcode] = (filter, len(projs), table)
+
+      # All the expression items in a state share an opcode (they matched
+      # the same instruction), so dispatching on the state subsumes the old
+      # per-opcode dispatch.  Keep the transforms of each state in their
+      # original declaration order, since earlier patterns take priority.
+      self.state_xforms = []
+      for state in self.states:
+         self.state_xforms.append([xform for xform, root in
+                                   zip(self.transforms, self._root_items)
+                                   if root in state])
+
 _algebraic_pass_template = mako.template.Template("""
+#include <string.h>
+
 #include "nir.h"
 #include "nir_search.h"
 
@@ -503,24 +660,124 @@ struct transform {
    unsigned condition_offset;
 };
 
+/* The generated pattern-matching automaton.  Every SSA def is assigned a
+ * state summarizing the set of search subexpressions it could be the root
+ * of; the state of an ALU def is a function of its opcode and the states
+ * of its sources, looked up from these tables.  State 0 matches nothing,
+ * state 1 is the state of every load_const.  States only filter: the
+ * recursive matcher still verifies constant values, bit sizes and friends.
+ */
+struct per_op_table {
+   /* Maps a state to its filtered index, collapsing states this opcode
+    * cannot tell apart; NULL if no search expression uses the opcode.
+    */
+   const uint16_t *filter;
+   unsigned num_filtered_states;
+   /* Maps the filtered states of the sources to the resulting state. */
+   const uint16_t *table;
+};
+
+struct states {
+   void *mem_ctx;
+   uint16_t *arr; /* per SSA def index; 0xffff is not-yet-computed */
+   unsigned count;
+};
+
 #endif
 
-% for (opcode, xform_list) in xform_dict.iteritems():
-% for xform in xform_list:
+% for xform in xforms:
    ${xform.search.render()}
    ${xform.replace.render()}
 % endfor
 
-static const struct transform ${pass_name}_${opcode}_xforms[] = {
-% for xform in xform_list:
+% for i, state_xforms in enumerate(automaton.state_xforms):
+% if state_xforms:
+static const struct transform ${pass_name}_state${i}_xforms[] = {
+% for xform in state_xforms:
    { &${xform.search.name}, ${xform.replace.c_ptr}, ${xform.condition_index} },
 % endfor
 };
+% endif
 % endfor
 
+% for opcode, (filter, num_filtered, table) in sorted(automaton.opcode_tables.iteritems()):
+static const uint16_t ${pass_name}_${opcode}_filter[] = {
+   ${', '.join(str(i) for i in filter)}
+};
+
+static const uint16_t ${pass_name}_${opcode}_table[] = {
+   ${', '.join(str(i) for i in table)}
+};
+
+% endfor
+static const struct per_op_table ${pass_name}_automaton[nir_num_opcodes] = {
+% for opcode, (filter, num_filtered, table) in sorted(automaton.opcode_tables.iteritems()):
+   [nir_op_${opcode}] = {
+      ${pass_name}_${opcode}_filter,
+      ${num_filtered},
+      ${pass_name}_${opcode}_table,
+   },
+% endfor
+};
+
+static uint16_t
+${pass_name}_get_state(struct states *states, nir_ssa_def *def);
+
+static uint16_t
+${pass_name}_compute_state(struct states *states, nir_instr *instr)
+{
+   switch (instr->type) {
+   case nir_instr_type_load_const:
+      return 1;
+
+   case nir_instr_type_alu: {
+      nir_alu_instr *alu = nir_instr_as_alu(instr);
+      const struct per_op_table *tbl = &${pass_name}_automaton[alu->op];
+      if (tbl->filter == NULL)
+         return 0;
+
+      unsigned index = 0;
+      for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+         uint16_t src_state = alu->src[i].src.is_ssa ?
+            ${pass_name}_get_state(states, alu->src[i].src.ssa) : 0;
+         index = index * tbl->num_filtered_states + tbl->filter[src_state];
+      }
+      return tbl->table[index];
+   }
+
+   default:
+      return 0;
+   }
+}
+
+static uint16_t
+${pass_name}_get_state(struct states *states, nir_ssa_def *def)
+{
+   if (def->index >= states->count) {
+      /* The def was created by a replacement after the initial bottom-up
+       * walk; grow the array and compute its state on demand.
+       */
+      unsigned new_count = states->count * 2;
+      while (def->index >= new_count)
+         new_count *= 2;
+
+      states->arr = reralloc(states->mem_ctx, states->arr, uint16_t,
+                             new_count);
+      memset(states->arr + states->count, 0xff,
+             (new_count - states->count) * sizeof(uint16_t));
+      states->count = new_count;
+   }
+
+   if (states->arr[def->index] == 0xffff)
+      states->arr[def->index] =
+         ${pass_name}_compute_state(states, def->parent_instr);
+
+   return states->arr[def->index];
+}
+
 static bool
-${pass_name}_block(nir_block *block, const bool *condition_flags,
-                   void *mem_ctx)
+${pass_name}_block(nir_block *block, struct states *states,
+                   const bool *condition_flags, void *mem_ctx)
 {
    bool progress = false;
 
@@ -532,11 +789,12 @@ ${pass_name}_block(nir_block *block, const bool *condition_flags,
       if (!alu->dest.dest.is_ssa)
          continue;
 
-      switch (alu->op) {
-      % for opcode in xform_dict.keys():
-      case nir_op_${opcode}:
-         for (unsigned i = 0; i < ARRAY_SIZE(${pass_name}_${opcode}_xforms); i++) {
-            const struct transform *xform = &${pass_name}_${opcode}_xforms[i];
+      switch (${pass_name}_get_state(states, &alu->dest.dest.ssa)) {
+      % for i, state_xforms in enumerate(automaton.state_xforms):
+      % if state_xforms:
+      case ${i}:
+         for (unsigned i = 0; i < ARRAY_SIZE(${pass_name}_state${i}_xforms); i++) {
+            const struct transform *xform = &${pass_name}_state${i}_xforms[i];
             if (condition_flags[xform->condition_offset] &&
                 nir_replace_instr(alu, xform->search, xform->replace,
                                   mem_ctx)) {
@@ -545,6 +803,7 @@ ${pass_name}_block(nir_block *block, const bool *condition_flags,
             }
          }
          break;
+      % endif
       % endfor
       default:
          break;
@@ -560,10 +819,36 @@ ${pass_name}_impl(nir_function_impl *impl, const bool *condition_flags)
    void *mem_ctx = ralloc_parent(impl);
    bool progress = false;
 
+   nir_index_ssa_defs(impl);
+
+   struct states states;
+   states.mem_ctx = ralloc_context(NULL);
+   states.count = impl->ssa_alloc ? impl->ssa_alloc : 1;
+   states.arr = ralloc_array(states.mem_ctx, uint16_t, states.count);
+   memset(states.arr, 0xff, states.count * sizeof(uint16_t));
+
+   /* Assign the ALU defs their states bottom-up; everything else gets the
+    * "matches nothing" state lazily in ${pass_name}_get_state().
+    */
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block) {
+         if (instr->type == nir_instr_type_alu) {
+            nir_alu_instr *alu = nir_instr_as_alu(instr);
+            if (alu->dest.dest.is_ssa) {
+               states.arr[alu->dest.dest.ssa.index] =
+                  ${pass_name}_compute_state(&states, instr);
+            }
+         }
+      }
+   }
+
    nir_foreach_block_reverse(block, impl) {
-      progress |= ${pass_name}_block(block, condition_flags, mem_ctx);
+      progress |= ${pass_name}_block(block, &states, condition_flags,
+                                     mem_ctx);
    }
 
+   ralloc_free(states.mem_ctx);
+
    if (progress)
       nir_metadata_preserve(impl, nir_metadata_block_index |
                                   nir_metadata_dominance);
@@ -595,7 +880,7 @@ ${pass_name}(nir_shader *shader)
 
 class AlgebraicPass(object):
    def __init__(self, pass_name, transforms):
-      self.xform_dict = {}
+      self.xforms = []
       self.pass_name = pass_name
 
       error = False
@@ -612,15 +897,15 @@ class AlgebraicPass(object):
                error = True
                continue
 
-         if xform.search.opcode not in self.xform_dict:
-            self.xform_dict[xform.search.opcode] = []
-
-         self.xform_dict[xform.search.opcode].append(xform)
+         self.xforms.append(xform)
 
       if error:
          sys.exit(1)
 
+      self.automaton = TreeAutomaton(self.xforms)
+
    def render(self):
       return _algebraic_pass_template.render(pass_name=self.pass_name,
-                                             xform_dict=self.xform_dict,
+                                             xforms=self.xforms,
+                                             automaton=self.automaton,
                                              condition_list=condition_list)
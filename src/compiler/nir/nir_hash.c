@@ -0,0 +1,336 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir.h"
+#include "util/u_hash64.h"
+
+/*
+ * Hashes the instruction stream of a shader directly, without serializing
+ * it first, for use as an in-memory program cache key.  Pointers are never
+ * hashed; values are identified by their SSA/register/block indices and
+ * variables by their assigned metadata, so two structurally identical
+ * shaders produce the same hash.  As with any non-cryptographic hash,
+ * callers are expected to do a full compare on a hit.
+ *
+ * glsl_type instances are flyweights, so type identity is hashed by
+ * pointer value; the resulting keys are only meaningful within a single
+ * process, which is all an in-memory cache needs.
+ */
+
+static void
+hash_u32(struct util_hash64_state *h, uint32_t v)
+{
+   util_hash64_update(h, &v, sizeof(v));
+}
+
+static void
+hash_type(struct util_hash64_state *h, const struct glsl_type *type)
+{
+   uintptr_t v = (uintptr_t) type;
+   util_hash64_update(h, &v, sizeof(v));
+}
+
+static void
+hash_var(struct util_hash64_state *h, const nir_variable *var)
+{
+   hash_u32(h, var->data.mode);
+   hash_u32(h, var->data.location);
+   hash_u32(h, var->data.driver_location);
+   hash_u32(h, var->data.binding);
+   hash_type(h, var->type);
+}
+
+static void
+hash_deref(struct util_hash64_state *h, const nir_deref_var *deref);
+
+static void
+hash_src(struct util_hash64_state *h, const nir_src *src)
+{
+   if (src->is_ssa) {
+      hash_u32(h, 0x55530000 /* 'SS' */);
+      hash_u32(h, src->ssa->index);
+   } else {
+      hash_u32(h, 0x52450000 /* 'RE' */);
+      hash_u32(h, src->reg.reg->index);
+      hash_u32(h, src->reg.base_offset);
+      if (src->reg.indirect)
+         hash_src(h, src->reg.indirect);
+   }
+}
+
+static void
+hash_dest(struct util_hash64_state *h, const nir_dest *dest)
+{
+   if (dest->is_ssa) {
+      hash_u32(h, dest->ssa.index);
+      hash_u32(h, dest->ssa.num_components);
+      hash_u32(h, dest->ssa.bit_size);
+   } else {
+      hash_u32(h, dest->reg.reg->index);
+      hash_u32(h, dest->reg.base_offset);
+      if (dest->reg.indirect)
+         hash_src(h, dest->reg.indirect);
+   }
+}
+
+static void
+hash_deref(struct util_hash64_state *h, const nir_deref_var *deref)
+{
+   hash_var(h, deref->var);
+
+   for (const nir_deref *tail = deref->deref.child; tail; tail = tail->child) {
+      hash_u32(h, tail->deref_type);
+      switch (tail->deref_type) {
+      case nir_deref_type_array: {
+         const nir_deref_array *arr = nir_deref_as_array(tail);
+         hash_u32(h, arr->deref_array_type);
+         hash_u32(h, arr->base_offset);
+         if (arr->deref_array_type == nir_deref_array_type_indirect)
+            hash_src(h, &arr->indirect);
+         break;
+      }
+      case nir_deref_type_struct:
+         hash_u32(h, nir_deref_as_struct(tail)->index);
+         break;
+      default:
+         break;
+      }
+   }
+}
+
+static void
+hash_alu(struct util_hash64_state *h, const nir_alu_instr *alu)
+{
+   hash_u32(h, alu->op);
+   hash_u32(h, alu->exact);
+   hash_dest(h, &alu->dest.dest);
+   hash_u32(h, alu->dest.saturate | (alu->dest.write_mask << 1));
+
+   for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+      hash_src(h, &alu->src[i].src);
+      hash_u32(h, alu->src[i].negate | (alu->src[i].abs << 1));
+      util_hash64_update(h, alu->src[i].swizzle, sizeof(alu->src[i].swizzle));
+   }
+}
+
+static void
+hash_intrinsic(struct util_hash64_state *h, const nir_intrinsic_instr *intrin)
+{
+   const nir_intrinsic_info *info = &nir_intrinsic_infos[intrin->intrinsic];
+
+   hash_u32(h, intrin->intrinsic);
+   hash_u32(h, intrin->num_components);
+
+   if (info->has_dest)
+      hash_dest(h, &intrin->dest);
+
+   for (unsigned i = 0; i < info->num_srcs; i++)
+      hash_src(h, &intrin->src[i]);
+
+   for (unsigned i = 0; i < info->num_variables; i++)
+      hash_deref(h, intrin->variables[i]);
+
+   for (unsigned i = 0; i < info->num_indices; i++)
+      hash_u32(h, intrin->const_index[i]);
+}
+
+static void
+hash_tex(struct util_hash64_state *h, const nir_tex_instr *tex)
+{
+   hash_u32(h, tex->op);
+   hash_dest(h, &tex->dest);
+   hash_u32(h, tex->sampler_dim);
+   hash_u32(h, tex->dest_type);
+   hash_u32(h, tex->coord_components);
+   hash_u32(h, tex->is_array |
+               (tex->is_shadow << 1) |
+               (tex->is_new_style_shadow << 2) |
+               (tex->component << 3));
+   hash_u32(h, tex->texture_index);
+   hash_u32(h, tex->texture_array_size);
+   hash_u32(h, tex->sampler_index);
+
+   for (unsigned i = 0; i < tex->num_srcs; i++) {
+      hash_u32(h, tex->src[i].src_type);
+      hash_src(h, &tex->src[i].src);
+   }
+
+   if (tex->texture)
+      hash_deref(h, tex->texture);
+   if (tex->sampler)
+      hash_deref(h, tex->sampler);
+}
+
+static void
+hash_instr(struct util_hash64_state *h, const nir_instr *instr)
+{
+   hash_u32(h, instr->type);
+
+   switch (instr->type) {
+   case nir_instr_type_alu:
+      hash_alu(h, nir_instr_as_alu(instr));
+      break;
+
+   case nir_instr_type_intrinsic:
+      hash_intrinsic(h, nir_instr_as_intrinsic(instr));
+      break;
+
+   case nir_instr_type_tex:
+      hash_tex(h, nir_instr_as_tex(instr));
+      break;
+
+   case nir_instr_type_load_const: {
+      const nir_load_const_instr *load = nir_instr_as_load_const(instr);
+      hash_u32(h, load->def.index);
+      hash_u32(h, load->def.num_components);
+      hash_u32(h, load->def.bit_size);
+      util_hash64_update(h, load->value.u32,
+                         load->def.num_components * load->def.bit_size / 8);
+      break;
+   }
+
+   case nir_instr_type_ssa_undef: {
+      const nir_ssa_undef_instr *undef = nir_instr_as_ssa_undef(instr);
+      hash_u32(h, undef->def.index);
+      hash_u32(h, undef->def.num_components);
+      hash_u32(h, undef->def.bit_size);
+      break;
+   }
+
+   case nir_instr_type_phi: {
+      const nir_phi_instr *phi = nir_instr_as_phi(instr);
+      hash_dest(h, &phi->dest);
+      nir_foreach_phi_src(src, phi) {
+         hash_u32(h, src->pred->index);
+         hash_src(h, &src->src);
+      }
+      break;
+   }
+
+   case nir_instr_type_jump:
+      hash_u32(h, nir_instr_as_jump(instr)->type);
+      break;
+
+   case nir_instr_type_call: {
+      const nir_call_instr *call = nir_instr_as_call(instr);
+      util_hash64_update(h, call->callee->name, strlen(call->callee->name));
+      for (unsigned i = 0; i < call->num_params; i++)
+         hash_deref(h, call->params[i]);
+      if (call->return_deref)
+         hash_deref(h, call->return_deref);
+      break;
+   }
+
+   case nir_instr_type_parallel_copy: {
+      nir_parallel_copy_instr *pc =
+         nir_instr_as_parallel_copy((nir_instr *) instr);
+      nir_foreach_parallel_copy_entry(entry, pc) {
+         hash_src(h, &entry->src);
+         hash_dest(h, &entry->dest);
+      }
+      break;
+   }
+
+   default:
+      break;
+   }
+}
+
+static void
+hash_cf_list(struct util_hash64_state *h, struct exec_list *cf_list);
+
+static void
+hash_cf_node(struct util_hash64_state *h, nir_cf_node *node)
+{
+   /* The control-flow structure has to feed into the hash so that, e.g.,
+    * moving an instruction across a loop boundary changes the key.
+    */
+   hash_u32(h, node->type);
+
+   switch (node->type) {
+   case nir_cf_node_block: {
+      nir_block *block = nir_cf_node_as_block(node);
+      hash_u32(h, block->index);
+      nir_foreach_instr(instr, block)
+         hash_instr(h, instr);
+      break;
+   }
+
+   case nir_cf_node_if: {
+      nir_if *if_stmt = nir_cf_node_as_if(node);
+      hash_src(h, &if_stmt->condition);
+      hash_cf_list(h, &if_stmt->then_list);
+      hash_cf_list(h, &if_stmt->else_list);
+      break;
+   }
+
+   case nir_cf_node_loop:
+      hash_cf_list(h, &nir_cf_node_as_loop(node)->body);
+      break;
+
+   default:
+      unreachable("unsupported CF node type");
+   }
+}
+
+static void
+hash_cf_list(struct util_hash64_state *h, struct exec_list *cf_list)
+{
+   foreach_list_typed(nir_cf_node, node, node, cf_list) {
+      hash_cf_node(h, node);
+   }
+}
+
+static void
+hash_function_impl(struct util_hash64_state *h, nir_function_impl *impl)
+{
+   nir_index_blocks(impl);
+   nir_index_ssa_defs(impl);
+   nir_index_local_regs(impl);
+
+   hash_u32(h, impl->num_params);
+   for (unsigned i = 0; i < impl->num_params; i++)
+      hash_var(h, impl->params[i]);
+   if (impl->return_var)
+      hash_var(h, impl->return_var);
+
+   hash_cf_list(h, &impl->body);
+}
+
+uint64_t
+nir_shader_hash(nir_shader *shader)
+{
+   struct util_hash64_state h;
+
+   util_hash64_init(&h, shader->stage);
+
+   nir_index_global_regs(shader);
+
+   nir_foreach_function(function, shader) {
+      util_hash64_update(&h, function->name, strlen(function->name));
+      if (function->impl)
+         hash_function_impl(&h, function->impl);
+   }
+
+   return util_hash64_final(&h);
+}
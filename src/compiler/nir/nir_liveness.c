@@ -146,12 +146,55 @@ propagate_across_edge(nir_block *pred, nir_block *succ,
       }
    }
 
-   BITSET_WORD progress = 0;
-   for (unsigned i = 0; i < state->bitset_words; ++i) {
-      progress |= live[i] & ~pred->live_out[i];
-      pred->live_out[i] |= live[i];
+   return __bitset_or_changed(pred->live_out, live, state->bitset_words);
+}
+
+/* Works through the worklist and updates the liveness sets of each of the
+ * blocks until the information stops changing.  As long as we keep the
+ * worklist up-to-date as we go, everything the seeded blocks can affect
+ * will get covered.
+ */
+static void
+live_ssa_defs_solve(struct live_ssa_defs_state *state)
+{
+   while (!nir_block_worklist_is_empty(&state->worklist)) {
+      /* We pop them off in the reverse order we pushed them on.  This way
+       * the first walk of the instructions is backwards so we only walk
+       * once in the case of no control flow.
+       */
+      nir_block *block = nir_block_worklist_pop_head(&state->worklist);
+
+      memcpy(block->live_in, block->live_out,
+             state->bitset_words * sizeof(BITSET_WORD));
+
+      nir_if *following_if = nir_block_get_following_if(block);
+      if (following_if)
+         set_src_live(&following_if->condition, block->live_in);
+
+      nir_foreach_instr_reverse(instr, block) {
+         /* Phi nodes are handled seperately so we want to skip them.  Since
+          * we are going backwards and they are at the beginning, we can just
+          * break as soon as we see one.
+          */
+         if (instr->type == nir_instr_type_phi)
+            break;
+
+         nir_foreach_ssa_def(instr, set_ssa_def_dead, block->live_in);
+         nir_foreach_src(instr, set_src_live, block->live_in);
+      }
+
+      /* Walk over all of the predecessors of the current block updating
+       * their live in with the live out of this one.  If anything has
+       * changed, add the predecessor to the work list so that we ensure
+       * that the new information is used.
+       */
+      struct set_entry *entry;
+      set_foreach(block->predecessors, entry) {
+         nir_block *pred = (nir_block *)entry->key;
+         if (propagate_across_edge(pred, block, state))
+            nir_block_worklist_push_tail(&state->worklist, pred);
+      }
    }
-   return progress != 0;
 }
 
 void
@@ -180,52 +223,104 @@ nir_live_ssa_defs_impl(nir_function_impl *impl)
       init_liveness_block(block, &state);
    }
 
+   live_ssa_defs_solve(&state);
 
-   /* We're now ready to work through the worklist and update the liveness
-    * sets of each of the blocks.  By the time we get to this point, every
-    * block in the function implementation has been pushed onto the
-    * worklist in reverse order.  As long as we keep the worklist
-    * up-to-date as we go, everything will get covered.
+   nir_block_worklist_fini(&state.worklist);
+
+   /* Record the index space so nir_live_ssa_defs_update_impl() can tell
+    * defs created later apart from ones these sets already cover, and drop
+    * any dirty-block records this computation just subsumed.
     */
-   while (!nir_block_worklist_is_empty(&state.worklist)) {
-      /* We pop them off in the reverse order we pushed them on.  This way
-       * the first walk of the instructions is backwards so we only walk
-       * once in the case of no control flow.
-       */
-      nir_block *block = nir_block_worklist_pop_head(&state.worklist);
+   impl->live_ssa_defs = state.num_ssa_defs;
+   impl->live_ssa_alloc = impl->ssa_alloc;
+   if (impl->dirty_blocks) {
+      _mesa_set_destroy(impl->dirty_blocks, NULL);
+      impl->dirty_blocks = NULL;
+   }
+}
 
-      memcpy(block->live_in, block->live_out,
-             state.bitset_words * sizeof(BITSET_WORD));
+static bool
+index_new_ssa_def(nir_ssa_def *def, void *void_impl)
+{
+   nir_function_impl *impl = void_impl;
 
-      nir_if *following_if = nir_block_get_following_if(block);
-      if (following_if)
-         set_src_live(&following_if->condition, block->live_in);
+   /* Defs indexed by the last full computation keep their index so that
+    * the bits of the existing live sets keep their meaning.
+    */
+   if (def->index < impl->live_ssa_alloc)
+      return true;
 
-      nir_foreach_instr_reverse(instr, block) {
-         /* Phi nodes are handled seperately so we want to skip them.  Since
-          * we are going backwards and they are at the beginning, we can just
-          * break as soon as we see one.
-          */
-         if (instr->type == nir_instr_type_phi)
-            break;
+   if (def->parent_instr->type == nir_instr_type_ssa_undef)
+      def->live_index = 0;
+   else
+      def->live_index = impl->live_ssa_defs++;
 
-         nir_foreach_ssa_def(instr, set_ssa_def_dead, block->live_in);
-         nir_foreach_src(instr, set_src_live, block->live_in);
-      }
+   return true;
+}
 
-      /* Walk over all of the predecessors of the current block updating
-       * their live in with the live out of this one.  If anything has
-       * changed, add the predecessor to the work list so that we ensure
-       * that the new information is used.
-       */
-      struct set_entry *entry;
-      set_foreach(block->predecessors, entry) {
-         nir_block *pred = (nir_block *)entry->key;
-         if (propagate_across_edge(pred, block, &state))
-            nir_block_worklist_push_tail(&state.worklist, pred);
+/** Incrementally updates the live SSA def information.
+ *
+ * The caller (normally nir_metadata_repair()) guarantees that the CFG is
+ * unchanged since the last full computation and that every block whose
+ * instructions have changed is in impl->dirty_blocks.  Defs created since
+ * then get fresh indices at the end of the index space and the dataflow
+ * fixed point is re-run seeded with only the dirty blocks, so the cost is
+ * proportional to the neighborhood the changes can actually affect.
+ *
+ * Note that removing instructions can leave the result a conservative
+ * over-approximation: a def may stay in live sets it no longer needs to be
+ * in.  That is safe for every consumer of this information --
+ * nir_ssa_defs_interfere() merely errs on the side of caution -- and the
+ * next full computation tightens it up again.
+ */
+void
+nir_live_ssa_defs_update_impl(nir_function_impl *impl)
+{
+   struct live_ssa_defs_state state;
+   struct set_entry *entry;
+
+   assert(impl->dirty_blocks != NULL);
+
+   unsigned old_words = BITSET_WORDS(impl->live_ssa_defs);
+
+   /* Index the defs added since the last full computation.  They can only
+    * live in dirty blocks, since inserting an instruction dirties its
+    * block.
+    */
+   set_foreach(impl->dirty_blocks, entry) {
+      nir_block *block = (nir_block *) entry->key;
+      nir_foreach_instr(instr, block)
+         nir_foreach_ssa_def(instr, index_new_ssa_def, impl);
+   }
+   impl->live_ssa_alloc = impl->ssa_alloc;
+
+   state.num_ssa_defs = impl->live_ssa_defs;
+   state.bitset_words = BITSET_WORDS(state.num_ssa_defs);
+
+   /* If the index space outgrew the existing bitsets, widen them all.  The
+    * old words are left untouched, so no information is lost.
+    */
+   if (state.bitset_words > old_words) {
+      nir_foreach_block(block, impl) {
+         block->live_in = reralloc(block, block->live_in, BITSET_WORD,
+                                   state.bitset_words);
+         memset(block->live_in + old_words, 0,
+                (state.bitset_words - old_words) * sizeof(BITSET_WORD));
+
+         block->live_out = reralloc(block, block->live_out, BITSET_WORD,
+                                    state.bitset_words);
+         memset(block->live_out + old_words, 0,
+                (state.bitset_words - old_words) * sizeof(BITSET_WORD));
       }
    }
 
+   nir_block_worklist_init(&state.worklist, impl->num_blocks, NULL);
+
+   set_foreach(impl->dirty_blocks, entry)
+      nir_block_worklist_push_head(&state.worklist, (nir_block *) entry->key);
+
+   live_ssa_defs_solve(&state);
+
    nir_block_worklist_fini(&state.worklist);
 }
 
@@ -63,15 +63,14 @@ lower_instr(nir_intrinsic_instr *instr,
        instr->variables[0]->var->data.mode != nir_var_shared)
       return; /* atomics passed as function arguments can't be lowered */
 
-   void *mem_ctx = ralloc_parent(instr);
    unsigned uniform_loc = instr->variables[0]->var->data.location;
 
-   nir_intrinsic_instr *new_instr = nir_intrinsic_instr_create(mem_ctx, op);
+   nir_intrinsic_instr *new_instr = nir_intrinsic_instr_create(shader, op);
    nir_intrinsic_set_base(new_instr,
       shader_program->UniformStorage[uniform_loc].opaque[shader->stage].index);
 
    nir_load_const_instr *offset_const =
-      nir_load_const_instr_create(mem_ctx, 1, 32);
+      nir_load_const_instr_create(shader, 1, 32);
    offset_const->value.u32[0] = instr->variables[0]->var->data.offset;
 
    nir_instr_insert_before(&instr->instr, &offset_const->instr);
@@ -92,11 +91,11 @@ lower_instr(nir_intrinsic_instr *instr,
 
       if (deref_array->deref_array_type == nir_deref_array_type_indirect) {
          nir_load_const_instr *atomic_counter_size =
-            nir_load_const_instr_create(mem_ctx, 1, 32);
+            nir_load_const_instr_create(shader, 1, 32);
          atomic_counter_size->value.u32[0] = child_array_elements * ATOMIC_COUNTER_SIZE;
          nir_instr_insert_before(&instr->instr, &atomic_counter_size->instr);
 
-         nir_alu_instr *mul = nir_alu_instr_create(mem_ctx, nir_op_imul);
+         nir_alu_instr *mul = nir_alu_instr_create(shader, nir_op_imul);
          nir_ssa_dest_init(&mul->instr, &mul->dest.dest, 1, 32, NULL);
          mul->dest.write_mask = 0x1;
          nir_src_copy(&mul->src[0].src, &deref_array->indirect, mul);
@@ -104,7 +103,7 @@ lower_instr(nir_intrinsic_instr *instr,
          mul->src[1].src.ssa = &atomic_counter_size->def;
          nir_instr_insert_before(&instr->instr, &mul->instr);
 
-         nir_alu_instr *add = nir_alu_instr_create(mem_ctx, nir_op_iadd);
+         nir_alu_instr *add = nir_alu_instr_create(shader, nir_op_iadd);
          nir_ssa_dest_init(&add->instr, &add->dest.dest, 1, 32, NULL);
          add->dest.write_mask = 0x1;
          add->src[0].src.is_ssa = true;
@@ -126,7 +125,7 @@ lower_instr(nir_intrinsic_instr *instr,
       nir_ssa_def_rewrite_uses(&instr->dest.ssa,
                                nir_src_for_ssa(&new_instr->dest.ssa));
    } else {
-      nir_dest_copy(&new_instr->dest, &instr->dest, mem_ctx);
+      nir_dest_copy(&new_instr->dest, &instr->dest, &new_instr->instr);
    }
 
    nir_instr_insert_before(&instr->instr, &new_instr->instr);
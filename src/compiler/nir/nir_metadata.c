@@ -47,10 +47,66 @@ nir_metadata_require(nir_function_impl *impl, nir_metadata required)
    impl->valid_metadata |= required;
 }
 
+static void
+discard_dirty_blocks(nir_function_impl *impl)
+{
+   if (impl->dirty_blocks) {
+      _mesa_set_destroy(impl->dirty_blocks, NULL);
+      impl->dirty_blocks = NULL;
+   }
+}
+
 void
 nir_metadata_preserve(nir_function_impl *impl, nir_metadata preserved)
 {
    impl->valid_metadata &= preserved;
+
+   /* Any dirty-block records refer to analysis results that are now being
+    * thrown away, so there is nothing left to repair.
+    */
+   if (!(preserved & nir_metadata_live_ssa_defs))
+      discard_dirty_blocks(impl);
+}
+
+/**
+ * Records that the instructions of the given block have changed.
+ *
+ * Passes that leave the CFG intact can call this for every block they touch
+ * and then finish with nir_metadata_repair(), which repairs the more
+ * expensive analyses locally instead of throwing them away to be recomputed
+ * from scratch.
+ */
+void
+nir_metadata_dirty_block(nir_function_impl *impl, nir_block *block)
+{
+   if (impl->dirty_blocks == NULL) {
+      impl->dirty_blocks = _mesa_set_create(impl, _mesa_hash_pointer,
+                                            _mesa_key_pointer_equal);
+   }
+
+   _mesa_set_add(impl->dirty_blocks, block);
+}
+
+/**
+ * Repairs analyses after a pass that changed instructions but not the CFG.
+ *
+ * This is the counterpart of nir_metadata_preserve() for passes that have
+ * marked every block they touched with nir_metadata_dirty_block().  Block
+ * indices and dominance depend only on the CFG, so they remain valid as-is;
+ * live SSA def information is repaired by re-running the dataflow fixed
+ * point seeded with just the dirty blocks, which typically converges after
+ * visiting a small neighborhood of the changes.
+ */
+void
+nir_metadata_repair(nir_function_impl *impl)
+{
+   if (impl->dirty_blocks == NULL)
+      return;
+
+   if (impl->valid_metadata & nir_metadata_live_ssa_defs)
+      nir_live_ssa_defs_update_impl(impl);
+
+   discard_dirty_blocks(impl);
 }
 
 #ifdef DEBUG
@@ -150,15 +150,23 @@ nir_opt_dce_impl(nir_function_impl *impl)
    nir_foreach_block(block, impl) {
       nir_foreach_instr_safe(instr, block) {
          if (!instr->pass_flags) {
+            nir_metadata_dirty_block(impl, block);
             nir_instr_remove(instr);
             progress = true;
          }
       }
    }
 
-   if (progress)
+   /* DCE doesn't touch the CFG and only ever removes instructions, so
+    * liveness stays a safe over-approximation and can be repaired from the
+    * dirty blocks instead of being recomputed from scratch.
+    */
+   if (progress) {
       nir_metadata_preserve(impl, nir_metadata_block_index |
-                                  nir_metadata_dominance);
+                                  nir_metadata_dominance |
+                                  nir_metadata_live_ssa_defs);
+      nir_metadata_repair(impl);
+   }
 
    return progress;
 }
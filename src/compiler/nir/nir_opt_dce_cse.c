@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir_instr_set.h"
+
+/*
+ * Fused CSE + worklist-driven DCE.
+ *
+ * The usual do-while-progress loops in the drivers re-run nir_opt_cse and
+ * nir_opt_dce over the whole shader every iteration, even when the previous
+ * iteration only changed a handful of instructions.  This pass makes a
+ * single CSE walk over the dominance tree and, instead of leaving the
+ * newly-unused operands of the merged instructions for a later full DCE
+ * sweep, seeds a dead-code worklist with them.  The worklist is then drained
+ * to a fixed point, so the cleanup cost is proportional to the number of
+ * instructions CSE actually touched rather than to the shader size.
+ */
+
+typedef struct {
+   struct exec_node node;
+   nir_instr *instr;
+} worklist_elem;
+
+static void
+worklist_push(struct exec_list *worklist, nir_instr *instr)
+{
+   /* pass_flags doubles as a marker: 0 is untouched, 1 is queued and 2 is
+    * already removed.  Only untouched instructions may be queued, so there
+    * is never more than one worklist entry per instruction and removed
+    * instructions are never resurrected.
+    */
+   if (instr->pass_flags)
+      return;
+
+   worklist_elem *elem = ralloc(worklist, worklist_elem);
+   elem->instr = instr;
+   instr->pass_flags = 1;
+   exec_list_push_tail(worklist, &elem->node);
+}
+
+static nir_instr *
+worklist_pop(struct exec_list *worklist)
+{
+   struct exec_node *node = exec_list_pop_head(worklist);
+   worklist_elem *elem = exec_node_data(worklist_elem, node, node);
+   return elem->instr;
+}
+
+static bool
+push_src_instr_cb(nir_src *src, void *_worklist)
+{
+   struct exec_list *worklist = (struct exec_list *) _worklist;
+
+   if (src->is_ssa)
+      worklist_push(worklist, src->ssa->parent_instr);
+
+   return true;
+}
+
+static bool
+def_is_unused_cb(nir_ssa_def *def, void *_state)
+{
+   bool *unused = (bool *) _state;
+
+   if (!list_empty(&def->uses) || !list_empty(&def->if_uses))
+      *unused = false;
+
+   return true;
+}
+
+/* Mirrors the liveness rules in nir_opt_dce.c's init_instr(), except that
+ * here we can simply look at the use lists because we only ever consider
+ * instructions whose consumers have already been dealt with.
+ */
+static bool
+instr_is_dead(nir_instr *instr)
+{
+   switch (instr->type) {
+   case nir_instr_type_call:
+   case nir_instr_type_jump:
+   case nir_instr_type_parallel_copy:
+      return false;
+
+   case nir_instr_type_alu:
+      if (!nir_instr_as_alu(instr)->dest.dest.is_ssa)
+         return false;
+      break;
+
+   case nir_instr_type_intrinsic: {
+      nir_intrinsic_instr *intrin = nir_instr_as_intrinsic(instr);
+      if (!(nir_intrinsic_infos[intrin->intrinsic].flags &
+            NIR_INTRINSIC_CAN_ELIMINATE))
+         return false;
+      if (nir_intrinsic_infos[intrin->intrinsic].has_dest &&
+          !intrin->dest.is_ssa)
+         return false;
+      break;
+   }
+
+   case nir_instr_type_tex:
+      if (!nir_instr_as_tex(instr)->dest.is_ssa)
+         return false;
+      break;
+
+   default:
+      break;
+   }
+
+   bool unused = true;
+   nir_foreach_ssa_def(instr, def_is_unused_cb, &unused);
+   return unused;
+}
+
+/*
+ * Visits and CSE's the given block and all its descendants in the dominance
+ * tree recursively, queueing the operands of every merged instruction on the
+ * dead-code worklist.  Note that the instr_set is guaranteed to only ever
+ * contain instructions that dominate the current block.
+ */
+static bool
+cse_block(nir_block *block, struct set *instr_set,
+          struct exec_list *worklist)
+{
+   bool progress = false;
+
+   nir_foreach_instr_safe(instr, block) {
+      if (nir_instr_set_add_or_rewrite(instr_set, instr)) {
+         progress = true;
+         nir_foreach_src(instr, push_src_instr_cb, worklist);
+         nir_instr_remove(instr);
+         instr->pass_flags = 2;
+      }
+   }
+
+   for (unsigned i = 0; i < block->num_dom_children; i++) {
+      nir_block *child = block->dom_children[i];
+      progress |= cse_block(child, instr_set, worklist);
+   }
+
+   nir_foreach_instr(instr, block)
+      nir_instr_set_remove(instr_set, instr);
+
+   return progress;
+}
+
+static bool
+nir_opt_dce_cse_impl(nir_function_impl *impl)
+{
+   struct set *instr_set = nir_instr_set_create(NULL);
+   struct exec_list *worklist = ralloc(NULL, struct exec_list);
+   exec_list_make_empty(worklist);
+
+   nir_metadata_require(impl, nir_metadata_dominance);
+
+   /* The worklist uses pass_flags as its dedup marker, so it has to start
+    * out clear everywhere.
+    */
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         instr->pass_flags = 0;
+   }
+
+   bool progress = cse_block(nir_start_block(impl), instr_set, worklist);
+
+   /* Drain the worklist: remove whatever became dead and requeue its
+    * operands, so entire dead expression trees fall over without another
+    * walk of the shader.
+    */
+   while (!exec_list_is_empty(worklist)) {
+      nir_instr *instr = worklist_pop(worklist);
+
+      /* The instruction may have been CSE'd away after it was queued. */
+      if (instr->pass_flags == 2)
+         continue;
+      instr->pass_flags = 0;
+
+      if (!instr_is_dead(instr))
+         continue;
+
+      nir_foreach_src(instr, push_src_instr_cb, worklist);
+      nir_instr_remove(instr);
+      instr->pass_flags = 2;
+      progress = true;
+   }
+
+   if (progress)
+      nir_metadata_preserve(impl, nir_metadata_block_index |
+                                  nir_metadata_dominance);
+
+   ralloc_free(worklist);
+   nir_instr_set_destroy(instr_set);
+   return progress;
+}
+
+bool
+nir_opt_dce_cse(nir_shader *shader)
+{
+   bool progress = false;
+
+   nir_foreach_function(function, shader) {
+      if (function->impl)
+         progress |= nir_opt_dce_cse_impl(function->impl);
+   }
+
+   return progress;
+}
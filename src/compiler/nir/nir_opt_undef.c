@@ -52,12 +52,15 @@ opt_undef_csel(nir_alu_instr *instr)
          continue;
 
       /* We can't just use nir_alu_src_copy, because we need the def/use
-       * updated.
+       * updated.  Parent any indirect copies to the instruction itself,
+       * not ralloc_parent(instr): pooled instructions are children of
+       * the pool, and allocations hung off the pool context would die
+       * with it in nir_compact().
        */
       nir_instr_rewrite_src(&instr->instr, &instr->src[0].src,
                             instr->src[i == 1 ? 2 : 1].src);
       nir_alu_src_copy(&instr->src[0], &instr->src[i == 1 ? 2 : 1],
-                       ralloc_parent(instr));
+                       instr);
 
       nir_src empty_src;
       memset(&empty_src, 0, sizeof(empty_src));
@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nir.h"
+#include "util/debug.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+/*
+ * Per-pass compile statistics, for finding compile-time regressions.
+ *
+ * When the NIR_PASS_STATS environment variable is set, every pass run
+ * through NIR_PASS/NIR_PASS_V emits one machine-readable line to stderr:
+ *
+ *    NIR-PASS-STATS: shader=<name> pass=<pass> time_us=<n>
+ *       instrs_before=<n> instrs_after=<n> maxrss_kb=<n>
+ *
+ * ralloc does no allocation accounting, so the process' maxrss is
+ * reported as the memory high-water mark instead.
+ *
+ * The begin/end state is global: like NIR_TEST_CLONE this is debug-only
+ * instrumentation and makes no attempt to be thread-safe.
+ */
+
+static int64_t pass_start_time;
+static unsigned pass_start_instrs;
+
+bool
+nir_pass_stats_enabled(void)
+{
+#ifndef _WIN32
+   static int enabled = -1;
+   if (enabled < 0)
+      enabled = env_var_as_boolean("NIR_PASS_STATS", false);
+   return enabled;
+#else
+   return false;
+#endif
+}
+
+#ifndef _WIN32
+
+static int64_t
+get_time_us(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000ll + tv.tv_usec;
+}
+
+static long
+get_maxrss_kb(void)
+{
+   struct rusage ru;
+   getrusage(RUSAGE_SELF, &ru);
+   return ru.ru_maxrss;
+}
+
+static unsigned
+count_instrs(nir_shader *shader)
+{
+   unsigned count = 0;
+
+   nir_foreach_function(function, shader) {
+      if (function->impl)
+         count += nir_index_instrs(function->impl);
+   }
+
+   return count;
+}
+
+void
+nir_pass_stats_begin(nir_shader *shader)
+{
+   if (!nir_pass_stats_enabled())
+      return;
+
+   pass_start_instrs = count_instrs(shader);
+   pass_start_time = get_time_us();
+}
+
+void
+nir_pass_stats_end(nir_shader *shader, const char *pass_name)
+{
+   int64_t time_us;
+
+   if (!nir_pass_stats_enabled())
+      return;
+
+   time_us = get_time_us() - pass_start_time;
+
+   fprintf(stderr, "NIR-PASS-STATS: shader=%s pass=%s time_us=%" PRIi64
+           " instrs_before=%u instrs_after=%u maxrss_kb=%ld\n",
+           shader->info.name ? shader->info.name : "(unnamed)",
+           pass_name, time_us, pass_start_instrs, count_instrs(shader),
+           get_maxrss_kb());
+}
+
+#else
+
+void
+nir_pass_stats_begin(nir_shader *shader)
+{
+   (void) shader;
+}
+
+void
+nir_pass_stats_end(nir_shader *shader, const char *pass_name)
+{
+   (void) shader;
+   (void) pass_name;
+}
+
+#endif /* _WIN32 */
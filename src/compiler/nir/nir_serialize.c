@@ -0,0 +1,1155 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir_serialize.h"
+#include "nir_control_flow.h"
+
+/* The serialized format is a flat stream of the same objects that
+ * nir_clone.c walks, in the same order.  Every object that can be referenced
+ * by a later object (variables, registers, SSA defs, blocks and functions)
+ * is assigned a small integer index in the order in which it is written;
+ * references are serialized as that index.  The reader re-creates objects in
+ * exactly the same order, so the index-to-pointer mapping is just an append
+ * only array on the read side.
+ *
+ * Like in nir_clone.c, phi sources are the one place where a forward
+ * reference can occur (both to an SSA def and to a predecessor block), so on
+ * the write side all blocks and SSA defs of a function are pre-indexed
+ * before the body is written, and on the read side phi sources are stashed
+ * on a list and fixed up once the whole function has been read.
+ */
+
+typedef struct {
+   const nir_shader *nir;
+
+   struct blob *blob;
+
+   /* maps pointer to index */
+   struct hash_table *remap_table;
+
+   /* the next index to assign to a NIR in-memory object */
+   uint32_t next_idx;
+
+   /* blob offset of the object count, overwritten once it is known */
+   size_t idx_count_offset;
+} write_ctx;
+
+typedef struct {
+   nir_shader *nir;
+
+   struct blob_reader *blob;
+
+   /* the index to associate with the next object read */
+   uint32_t next_idx;
+
+   /* maps index to pointer */
+   uintptr_t *idx_table;
+   uint32_t idx_table_len;
+
+   /* List of phi sources. */
+   struct list_head phi_srcs;
+} read_ctx;
+
+static void
+write_add_object(write_ctx *ctx, const void *obj)
+{
+   uint32_t index = ctx->next_idx++;
+   _mesa_hash_table_insert(ctx->remap_table, obj,
+                           (void *) (uintptr_t) index);
+}
+
+static uint32_t
+write_lookup_object(write_ctx *ctx, const void *obj)
+{
+   struct hash_entry *entry = _mesa_hash_table_search(ctx->remap_table, obj);
+   assert(entry);
+   return (uint32_t) (uintptr_t) entry->data;
+}
+
+static void
+write_object(write_ctx *ctx, const void *obj)
+{
+   blob_write_uint32(ctx->blob, write_lookup_object(ctx, obj));
+}
+
+static void
+read_add_object(read_ctx *ctx, void *obj)
+{
+   assert(ctx->next_idx < ctx->idx_table_len);
+   ctx->idx_table[ctx->next_idx++] = (uintptr_t) obj;
+}
+
+static void *
+read_lookup_object(read_ctx *ctx, uint32_t idx)
+{
+   assert(idx < ctx->idx_table_len);
+   return (void *) ctx->idx_table[idx];
+}
+
+static void *
+read_object(read_ctx *ctx)
+{
+   return read_lookup_object(ctx, blob_read_uint32(ctx->blob));
+}
+
+static void
+write_constant(write_ctx *ctx, const nir_constant *c)
+{
+   blob_write_bytes(ctx->blob, (uint8_t *) &c->value, sizeof(c->value));
+   blob_write_uint32(ctx->blob, c->num_elements);
+   for (unsigned i = 0; i < c->num_elements; i++)
+      write_constant(ctx, c->elements[i]);
+}
+
+static nir_constant *
+read_constant(read_ctx *ctx, nir_variable *nvar)
+{
+   nir_constant *c = ralloc(nvar, nir_constant);
+
+   blob_copy_bytes(ctx->blob, (uint8_t *) &c->value, sizeof(c->value));
+   c->num_elements = blob_read_uint32(ctx->blob);
+   c->elements = ralloc_array(nvar, nir_constant *, c->num_elements);
+   for (unsigned i = 0; i < c->num_elements; i++)
+      c->elements[i] = read_constant(ctx, nvar);
+
+   return c;
+}
+
+static void
+write_variable(write_ctx *ctx, const nir_variable *var)
+{
+   write_add_object(ctx, var);
+   encode_type_to_blob(ctx->blob, var->type);
+   blob_write_uint32(ctx->blob, !!(var->name));
+   if (var->name)
+      blob_write_string(ctx->blob, var->name);
+   blob_write_bytes(ctx->blob, (uint8_t *) &var->data, sizeof(var->data));
+   blob_write_uint32(ctx->blob, var->num_state_slots);
+   blob_write_bytes(ctx->blob, (uint8_t *) var->state_slots,
+                    var->num_state_slots * sizeof(nir_state_slot));
+   blob_write_uint32(ctx->blob, !!(var->constant_initializer));
+   if (var->constant_initializer)
+      write_constant(ctx, var->constant_initializer);
+   blob_write_uint32(ctx->blob, !!(var->interface_type));
+   if (var->interface_type)
+      encode_type_to_blob(ctx->blob, var->interface_type);
+}
+
+static nir_variable *
+read_variable(read_ctx *ctx)
+{
+   nir_variable *var = rzalloc(ctx->nir, nir_variable);
+   read_add_object(ctx, var);
+
+   var->type = decode_type_from_blob(ctx->blob);
+   bool has_name = blob_read_uint32(ctx->blob);
+   if (has_name) {
+      const char *name = blob_read_string(ctx->blob);
+      var->name = ralloc_strdup(var, name);
+   } else {
+      var->name = NULL;
+   }
+   blob_copy_bytes(ctx->blob, (uint8_t *) &var->data, sizeof(var->data));
+   var->num_state_slots = blob_read_uint32(ctx->blob);
+   var->state_slots = ralloc_array(var, nir_state_slot, var->num_state_slots);
+   blob_copy_bytes(ctx->blob, (uint8_t *) var->state_slots,
+                   var->num_state_slots * sizeof(nir_state_slot));
+   bool has_const_initializer = blob_read_uint32(ctx->blob);
+   if (has_const_initializer)
+      var->constant_initializer = read_constant(ctx, var);
+   else
+      var->constant_initializer = NULL;
+   bool has_interface_type = blob_read_uint32(ctx->blob);
+   if (has_interface_type)
+      var->interface_type = decode_type_from_blob(ctx->blob);
+   else
+      var->interface_type = NULL;
+
+   return var;
+}
+
+static void
+write_var_list(write_ctx *ctx, const struct exec_list *src)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(src));
+   foreach_list_typed(nir_variable, var, node, src) {
+      write_variable(ctx, var);
+   }
+}
+
+static void
+read_var_list(read_ctx *ctx, struct exec_list *dst)
+{
+   exec_list_make_empty(dst);
+   unsigned num_vars = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_vars; i++) {
+      nir_variable *var = read_variable(ctx);
+      exec_list_push_tail(dst, &var->node);
+   }
+}
+
+static void
+write_register(write_ctx *ctx, const nir_register *reg)
+{
+   write_add_object(ctx, reg);
+   blob_write_uint32(ctx->blob, reg->num_components);
+   blob_write_uint32(ctx->blob, reg->bit_size);
+   blob_write_uint32(ctx->blob, reg->num_array_elems);
+   blob_write_uint32(ctx->blob, reg->index);
+   blob_write_uint32(ctx->blob, !!(reg->name));
+   if (reg->name)
+      blob_write_string(ctx->blob, reg->name);
+   blob_write_uint32(ctx->blob, reg->is_global << 1 | reg->is_packed);
+}
+
+static nir_register *
+read_register(read_ctx *ctx)
+{
+   nir_register *reg = ralloc(ctx->nir, nir_register);
+   read_add_object(ctx, reg);
+   reg->num_components = blob_read_uint32(ctx->blob);
+   reg->bit_size = blob_read_uint32(ctx->blob);
+   reg->num_array_elems = blob_read_uint32(ctx->blob);
+   reg->index = blob_read_uint32(ctx->blob);
+   bool has_name = blob_read_uint32(ctx->blob);
+   if (has_name) {
+      const char *name = blob_read_string(ctx->blob);
+      reg->name = ralloc_strdup(reg, name);
+   } else {
+      reg->name = NULL;
+   }
+   unsigned flags = blob_read_uint32(ctx->blob);
+   reg->is_global = flags & 0x2;
+   reg->is_packed = flags & 0x1;
+
+   list_inithead(&reg->uses);
+   list_inithead(&reg->defs);
+   list_inithead(&reg->if_uses);
+
+   return reg;
+}
+
+static void
+write_reg_list(write_ctx *ctx, const struct exec_list *src)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(src));
+   foreach_list_typed(nir_register, reg, node, src)
+      write_register(ctx, reg);
+}
+
+static void
+read_reg_list(read_ctx *ctx, struct exec_list *dst)
+{
+   exec_list_make_empty(dst);
+   unsigned num_regs = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_regs; i++) {
+      nir_register *reg = read_register(ctx);
+      exec_list_push_tail(dst, &reg->node);
+   }
+}
+
+static void
+write_src(write_ctx *ctx, const nir_src *src)
+{
+   blob_write_uint32(ctx->blob, src->is_ssa);
+   if (src->is_ssa) {
+      write_object(ctx, src->ssa);
+   } else {
+      write_object(ctx, src->reg.reg);
+      blob_write_uint32(ctx->blob, src->reg.base_offset);
+      blob_write_uint32(ctx->blob, !!(src->reg.indirect));
+      if (src->reg.indirect)
+         write_src(ctx, src->reg.indirect);
+   }
+}
+
+static void
+read_src(read_ctx *ctx, nir_src *src, void *mem_ctx)
+{
+   src->is_ssa = blob_read_uint32(ctx->blob);
+   if (src->is_ssa) {
+      src->ssa = read_object(ctx);
+   } else {
+      src->reg.reg = read_object(ctx);
+      src->reg.base_offset = blob_read_uint32(ctx->blob);
+      bool has_indirect = blob_read_uint32(ctx->blob);
+      if (has_indirect) {
+         src->reg.indirect = ralloc(mem_ctx, nir_src);
+         read_src(ctx, src->reg.indirect, mem_ctx);
+      } else {
+         src->reg.indirect = NULL;
+      }
+   }
+}
+
+static void
+write_dest(write_ctx *ctx, const nir_dest *dst)
+{
+   blob_write_uint32(ctx->blob, dst->is_ssa);
+   if (dst->is_ssa) {
+      blob_write_uint32(ctx->blob, dst->ssa.num_components);
+      blob_write_uint32(ctx->blob, dst->ssa.bit_size);
+   } else {
+      write_object(ctx, dst->reg.reg);
+      blob_write_uint32(ctx->blob, dst->reg.base_offset);
+      blob_write_uint32(ctx->blob, !!(dst->reg.indirect));
+      if (dst->reg.indirect)
+         write_src(ctx, dst->reg.indirect);
+   }
+}
+
+static void
+read_dest(read_ctx *ctx, nir_dest *dst, nir_instr *instr)
+{
+   bool is_ssa = blob_read_uint32(ctx->blob);
+   if (is_ssa) {
+      unsigned num_components = blob_read_uint32(ctx->blob);
+      unsigned bit_size = blob_read_uint32(ctx->blob);
+      nir_ssa_dest_init(instr, dst, num_components, bit_size, NULL);
+      read_add_object(ctx, &dst->ssa);
+   } else {
+      dst->reg.reg = read_object(ctx);
+      dst->reg.base_offset = blob_read_uint32(ctx->blob);
+      bool has_indirect = blob_read_uint32(ctx->blob);
+      if (has_indirect) {
+         dst->reg.indirect = ralloc(instr, nir_src);
+         read_src(ctx, dst->reg.indirect, instr);
+      } else {
+         dst->reg.indirect = NULL;
+      }
+   }
+}
+
+static void
+write_deref_chain(write_ctx *ctx, const nir_deref_var *dvar)
+{
+   write_object(ctx, dvar->var);
+
+   for (const nir_deref *d = dvar->deref.child; d; d = d->child) {
+      blob_write_uint32(ctx->blob, d->deref_type);
+      encode_type_to_blob(ctx->blob, d->type);
+      switch (d->deref_type) {
+      case nir_deref_type_array: {
+         const nir_deref_array *darr = nir_deref_as_array((nir_deref *) d);
+         blob_write_uint32(ctx->blob, darr->deref_array_type);
+         blob_write_uint32(ctx->blob, darr->base_offset);
+         if (darr->deref_array_type == nir_deref_array_type_indirect)
+            write_src(ctx, &darr->indirect);
+         break;
+      }
+      case nir_deref_type_struct: {
+         const nir_deref_struct *dstr = nir_deref_as_struct((nir_deref *) d);
+         blob_write_uint32(ctx->blob, dstr->index);
+         break;
+      }
+      default:
+         unreachable("bad deref type");
+      }
+   }
+
+   blob_write_uint32(ctx->blob, ~0); /* end of chain */
+}
+
+static nir_deref_var *
+read_deref_chain(read_ctx *ctx, nir_instr *ninstr)
+{
+   nir_variable *var = read_object(ctx);
+   nir_deref_var *dvar = nir_deref_var_create(ninstr, var);
+
+   nir_deref *parent = &dvar->deref;
+   for (;;) {
+      unsigned deref_type = blob_read_uint32(ctx->blob);
+      if (deref_type == ~0u)
+         break;
+
+      const struct glsl_type *type = decode_type_from_blob(ctx->blob);
+      switch (deref_type) {
+      case nir_deref_type_array: {
+         nir_deref_array *darr = nir_deref_array_create(parent);
+         darr->deref.type = type;
+         darr->deref_array_type = blob_read_uint32(ctx->blob);
+         darr->base_offset = blob_read_uint32(ctx->blob);
+         if (darr->deref_array_type == nir_deref_array_type_indirect)
+            read_src(ctx, &darr->indirect, ninstr);
+         parent->child = &darr->deref;
+         parent = &darr->deref;
+         break;
+      }
+      case nir_deref_type_struct: {
+         unsigned index = blob_read_uint32(ctx->blob);
+         nir_deref_struct *dstr = nir_deref_struct_create(parent, index);
+         dstr->deref.type = type;
+         parent->child = &dstr->deref;
+         parent = &dstr->deref;
+         break;
+      }
+      default:
+         unreachable("bad deref type");
+      }
+   }
+
+   return dvar;
+}
+
+static void
+write_alu(write_ctx *ctx, const nir_alu_instr *alu)
+{
+   blob_write_uint32(ctx->blob, alu->op);
+   uint32_t flags = alu->exact;
+   flags |= alu->dest.saturate << 1;
+   flags |= alu->dest.write_mask << 2;
+   blob_write_uint32(ctx->blob, flags);
+
+   write_dest(ctx, &alu->dest.dest);
+
+   for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+      write_src(ctx, &alu->src[i].src);
+      flags = alu->src[i].negate;
+      flags |= alu->src[i].abs << 1;
+      for (unsigned j = 0; j < 4; j++)
+         flags |= alu->src[i].swizzle[j] << (2 + 2 * j);
+      blob_write_uint32(ctx->blob, flags);
+   }
+}
+
+static nir_alu_instr *
+read_alu(read_ctx *ctx)
+{
+   nir_op op = blob_read_uint32(ctx->blob);
+   nir_alu_instr *alu = nir_alu_instr_create(ctx->nir, op);
+
+   uint32_t flags = blob_read_uint32(ctx->blob);
+   alu->exact = flags & 1;
+   alu->dest.saturate = (flags >> 1) & 1;
+   alu->dest.write_mask = flags >> 2;
+
+   read_dest(ctx, &alu->dest.dest, &alu->instr);
+
+   for (unsigned i = 0; i < nir_op_infos[op].num_inputs; i++) {
+      read_src(ctx, &alu->src[i].src, &alu->instr);
+      flags = blob_read_uint32(ctx->blob);
+      alu->src[i].negate = flags & 1;
+      alu->src[i].abs = (flags >> 1) & 1;
+      for (unsigned j = 0; j < 4; j++)
+         alu->src[i].swizzle[j] = (flags >> (2 + 2 * j)) & 3;
+   }
+
+   return alu;
+}
+
+static void
+write_intrinsic(write_ctx *ctx, const nir_intrinsic_instr *intrin)
+{
+   blob_write_uint32(ctx->blob, intrin->intrinsic);
+
+   unsigned num_variables = nir_intrinsic_infos[intrin->intrinsic].num_variables;
+   unsigned num_srcs = nir_intrinsic_infos[intrin->intrinsic].num_srcs;
+
+   if (nir_intrinsic_infos[intrin->intrinsic].has_dest)
+      write_dest(ctx, &intrin->dest);
+
+   blob_write_uint32(ctx->blob, intrin->num_components);
+
+   for (unsigned i = 0; i < NIR_INTRINSIC_MAX_CONST_INDEX; i++)
+      blob_write_uint32(ctx->blob, intrin->const_index[i]);
+
+   for (unsigned i = 0; i < num_variables; i++)
+      write_deref_chain(ctx, intrin->variables[i]);
+
+   for (unsigned i = 0; i < num_srcs; i++)
+      write_src(ctx, &intrin->src[i]);
+}
+
+static nir_intrinsic_instr *
+read_intrinsic(read_ctx *ctx)
+{
+   nir_intrinsic_op op = blob_read_uint32(ctx->blob);
+
+   nir_intrinsic_instr *intrin = nir_intrinsic_instr_create(ctx->nir, op);
+
+   unsigned num_variables = nir_intrinsic_infos[op].num_variables;
+   unsigned num_srcs = nir_intrinsic_infos[op].num_srcs;
+
+   if (nir_intrinsic_infos[op].has_dest)
+      read_dest(ctx, &intrin->dest, &intrin->instr);
+
+   intrin->num_components = blob_read_uint32(ctx->blob);
+
+   for (unsigned i = 0; i < NIR_INTRINSIC_MAX_CONST_INDEX; i++)
+      intrin->const_index[i] = blob_read_uint32(ctx->blob);
+
+   for (unsigned i = 0; i < num_variables; i++)
+      intrin->variables[i] = read_deref_chain(ctx, &intrin->instr);
+
+   for (unsigned i = 0; i < num_srcs; i++)
+      read_src(ctx, &intrin->src[i], &intrin->instr);
+
+   return intrin;
+}
+
+static void
+write_load_const(write_ctx *ctx, const nir_load_const_instr *lc)
+{
+   blob_write_uint32(ctx->blob, lc->def.num_components);
+   blob_write_uint32(ctx->blob, lc->def.bit_size);
+   blob_write_bytes(ctx->blob, (uint8_t *) &lc->value, sizeof(lc->value));
+   write_add_object(ctx, &lc->def);
+}
+
+static nir_load_const_instr *
+read_load_const(read_ctx *ctx)
+{
+   unsigned num_components = blob_read_uint32(ctx->blob);
+   unsigned bit_size = blob_read_uint32(ctx->blob);
+
+   nir_load_const_instr *lc =
+      nir_load_const_instr_create(ctx->nir, num_components, bit_size);
+
+   blob_copy_bytes(ctx->blob, (uint8_t *) &lc->value, sizeof(lc->value));
+   read_add_object(ctx, &lc->def);
+
+   return lc;
+}
+
+static void
+write_ssa_undef(write_ctx *ctx, const nir_ssa_undef_instr *undef)
+{
+   blob_write_uint32(ctx->blob, undef->def.num_components);
+   blob_write_uint32(ctx->blob, undef->def.bit_size);
+   write_add_object(ctx, &undef->def);
+}
+
+static nir_ssa_undef_instr *
+read_ssa_undef(read_ctx *ctx)
+{
+   unsigned num_components = blob_read_uint32(ctx->blob);
+   unsigned bit_size = blob_read_uint32(ctx->blob);
+
+   nir_ssa_undef_instr *undef =
+      nir_ssa_undef_instr_create(ctx->nir, num_components, bit_size);
+
+   read_add_object(ctx, &undef->def);
+
+   return undef;
+}
+
+static void
+write_tex(write_ctx *ctx, const nir_tex_instr *tex)
+{
+   blob_write_uint32(ctx->blob, tex->num_srcs);
+   blob_write_uint32(ctx->blob, tex->op);
+   blob_write_uint32(ctx->blob, tex->sampler_dim);
+   blob_write_uint32(ctx->blob, tex->dest_type);
+   blob_write_uint32(ctx->blob, tex->coord_components);
+   blob_write_uint32(ctx->blob,
+                     tex->is_array |
+                     tex->is_shadow << 1 |
+                     tex->is_new_style_shadow << 2 |
+                     tex->component << 3);
+   blob_write_uint32(ctx->blob, tex->texture_index);
+   blob_write_uint32(ctx->blob, tex->texture_array_size);
+   blob_write_uint32(ctx->blob, tex->sampler_index);
+
+   write_dest(ctx, &tex->dest);
+   for (unsigned i = 0; i < tex->num_srcs; i++) {
+      blob_write_uint32(ctx->blob, tex->src[i].src_type);
+      write_src(ctx, &tex->src[i].src);
+   }
+
+   blob_write_uint32(ctx->blob, !!(tex->texture));
+   if (tex->texture)
+      write_deref_chain(ctx, tex->texture);
+   blob_write_uint32(ctx->blob, !!(tex->sampler));
+   if (tex->sampler)
+      write_deref_chain(ctx, tex->sampler);
+}
+
+static nir_tex_instr *
+read_tex(read_ctx *ctx)
+{
+   unsigned num_srcs = blob_read_uint32(ctx->blob);
+   nir_tex_instr *tex = nir_tex_instr_create(ctx->nir, num_srcs);
+
+   tex->op = blob_read_uint32(ctx->blob);
+   tex->sampler_dim = blob_read_uint32(ctx->blob);
+   tex->dest_type = blob_read_uint32(ctx->blob);
+   tex->coord_components = blob_read_uint32(ctx->blob);
+   unsigned flags = blob_read_uint32(ctx->blob);
+   tex->is_array = flags & 1;
+   tex->is_shadow = (flags >> 1) & 1;
+   tex->is_new_style_shadow = (flags >> 2) & 1;
+   tex->component = (flags >> 3) & 3;
+   tex->texture_index = blob_read_uint32(ctx->blob);
+   tex->texture_array_size = blob_read_uint32(ctx->blob);
+   tex->sampler_index = blob_read_uint32(ctx->blob);
+
+   read_dest(ctx, &tex->dest, &tex->instr);
+   for (unsigned i = 0; i < tex->num_srcs; i++) {
+      tex->src[i].src_type = blob_read_uint32(ctx->blob);
+      read_src(ctx, &tex->src[i].src, &tex->instr);
+   }
+
+   bool has_texture_deref = blob_read_uint32(ctx->blob);
+   if (has_texture_deref)
+      tex->texture = read_deref_chain(ctx, &tex->instr);
+   bool has_sampler_deref = blob_read_uint32(ctx->blob);
+   if (has_sampler_deref)
+      tex->sampler = read_deref_chain(ctx, &tex->instr);
+
+   return tex;
+}
+
+static void
+write_phi(write_ctx *ctx, const nir_phi_instr *phi)
+{
+   /* Everything a phi can reference (its sources and their predecessor
+    * blocks) has already been assigned an index by the pre-indexing walk in
+    * write_function_impl, so unlike nir_clone.c we don't need a fixup pass
+    * on the write side.
+    */
+   write_dest(ctx, &phi->dest);
+
+   blob_write_uint32(ctx->blob, exec_list_length(&phi->srcs));
+   nir_foreach_phi_src(src, phi) {
+      assert(src->src.is_ssa);
+      blob_write_uint32(ctx->blob, write_lookup_object(ctx, src->src.ssa));
+      blob_write_uint32(ctx->blob, write_lookup_object(ctx, src->pred));
+   }
+}
+
+static nir_phi_instr *
+read_phi(read_ctx *ctx, nir_block *blk)
+{
+   nir_phi_instr *phi = nir_phi_instr_create(ctx->nir);
+
+   read_dest(ctx, &phi->dest, &phi->instr);
+
+   unsigned num_srcs = blob_read_uint32(ctx->blob);
+
+   /* Phi sources may reference SSA defs and blocks that have not been read
+    * yet.  We stash the indices in the pointer fields for now and fix them
+    * up at the end of read_function_impl, exactly like nir_clone.c does
+    * with the old pointers.  We have to add the phi to the block before
+    * adding the sources so that the sources don't end up on anyone's
+    * use/def lists in the meantime.
+    */
+   nir_instr_insert_after_block(blk, &phi->instr);
+
+   for (unsigned i = 0; i < num_srcs; i++) {
+      nir_phi_src *src = ralloc(phi, nir_phi_src);
+
+      src->src.is_ssa = true;
+      src->src.ssa = (nir_ssa_def *) (uintptr_t) blob_read_uint32(ctx->blob);
+      src->pred = (nir_block *) (uintptr_t) blob_read_uint32(ctx->blob);
+      src->src.parent_instr = &phi->instr;
+
+      list_add(&src->src.use_link, &ctx->phi_srcs);
+
+      exec_list_push_tail(&phi->srcs, &src->node);
+   }
+
+   return phi;
+}
+
+static void
+read_fixup_phis(read_ctx *ctx)
+{
+   list_for_each_entry_safe(nir_phi_src, src, &ctx->phi_srcs, src.use_link) {
+      src->pred = read_lookup_object(ctx, (uint32_t) (uintptr_t) src->pred);
+      src->src.ssa = read_lookup_object(ctx, (uint32_t) (uintptr_t) src->src.ssa);
+
+      /* Remove from this list and place in the uses of the SSA def */
+      list_del(&src->src.use_link);
+      list_addtail(&src->src.use_link, &src->src.ssa->uses);
+   }
+   assert(list_empty(&ctx->phi_srcs));
+}
+
+static void
+write_jump(write_ctx *ctx, const nir_jump_instr *jmp)
+{
+   blob_write_uint32(ctx->blob, jmp->type);
+}
+
+static nir_jump_instr *
+read_jump(read_ctx *ctx)
+{
+   nir_jump_type type = blob_read_uint32(ctx->blob);
+   nir_jump_instr *jmp = nir_jump_instr_create(ctx->nir, type);
+   return jmp;
+}
+
+static void
+write_call(write_ctx *ctx, const nir_call_instr *call)
+{
+   blob_write_uint32(ctx->blob, write_lookup_object(ctx, call->callee));
+
+   for (unsigned i = 0; i < call->num_params; i++)
+      write_deref_chain(ctx, call->params[i]);
+
+   write_deref_chain(ctx, call->return_deref);
+}
+
+static nir_call_instr *
+read_call(read_ctx *ctx)
+{
+   nir_function *callee = read_object(ctx);
+   nir_call_instr *call = nir_call_instr_create(ctx->nir, callee);
+
+   for (unsigned i = 0; i < call->num_params; i++)
+      call->params[i] = read_deref_chain(ctx, &call->instr);
+
+   call->return_deref = read_deref_chain(ctx, &call->instr);
+
+   return call;
+}
+
+static void
+write_instr(write_ctx *ctx, const nir_instr *instr)
+{
+   blob_write_uint32(ctx->blob, instr->type);
+   switch (instr->type) {
+   case nir_instr_type_alu:
+      write_alu(ctx, nir_instr_as_alu((nir_instr *) instr));
+      break;
+   case nir_instr_type_intrinsic:
+      write_intrinsic(ctx, nir_instr_as_intrinsic((nir_instr *) instr));
+      break;
+   case nir_instr_type_load_const:
+      write_load_const(ctx, nir_instr_as_load_const((nir_instr *) instr));
+      break;
+   case nir_instr_type_ssa_undef:
+      write_ssa_undef(ctx, nir_instr_as_ssa_undef((nir_instr *) instr));
+      break;
+   case nir_instr_type_tex:
+      write_tex(ctx, nir_instr_as_tex((nir_instr *) instr));
+      break;
+   case nir_instr_type_phi:
+      write_phi(ctx, nir_instr_as_phi((nir_instr *) instr));
+      break;
+   case nir_instr_type_jump:
+      write_jump(ctx, nir_instr_as_jump((nir_instr *) instr));
+      break;
+   case nir_instr_type_call:
+      write_call(ctx, nir_instr_as_call((nir_instr *) instr));
+      break;
+   case nir_instr_type_parallel_copy:
+      unreachable("Cannot serialize parallel copies");
+   default:
+      unreachable("bad instr type");
+   }
+}
+
+static void
+read_instr(read_ctx *ctx, nir_block *block)
+{
+   nir_instr_type type = blob_read_uint32(ctx->blob);
+   nir_instr *instr;
+   switch (type) {
+   case nir_instr_type_alu:
+      instr = &read_alu(ctx)->instr;
+      break;
+   case nir_instr_type_intrinsic:
+      instr = &read_intrinsic(ctx)->instr;
+      break;
+   case nir_instr_type_load_const:
+      instr = &read_load_const(ctx)->instr;
+      break;
+   case nir_instr_type_ssa_undef:
+      instr = &read_ssa_undef(ctx)->instr;
+      break;
+   case nir_instr_type_tex:
+      instr = &read_tex(ctx)->instr;
+      break;
+   case nir_instr_type_phi:
+      /* Phi instructions insert themselves into the block (see read_phi) */
+      read_phi(ctx, block);
+      return;
+   case nir_instr_type_jump:
+      instr = &read_jump(ctx)->instr;
+      break;
+   case nir_instr_type_call:
+      instr = &read_call(ctx)->instr;
+      break;
+   case nir_instr_type_parallel_copy:
+      unreachable("Cannot deserialize parallel copies");
+   default:
+      unreachable("bad instr type");
+   }
+
+   nir_instr_insert_after_block(block, instr);
+}
+
+static void
+write_block(write_ctx *ctx, const nir_block *block)
+{
+   blob_write_uint32(ctx->blob, write_lookup_object(ctx, block));
+   blob_write_uint32(ctx->blob, exec_list_length(&block->instr_list));
+   nir_foreach_instr(instr, (nir_block *) block)
+      write_instr(ctx, instr);
+}
+
+static void
+read_block(read_ctx *ctx, struct exec_list *cf_list)
+{
+   /* Don't actually create a new block.  Just use the one from the tail of
+    * the list.  NIR guarantees that the tail of the list is a block and that
+    * no two blocks are side-by-side in the IR;  It should be empty.
+    */
+   nir_block *block =
+      exec_node_data(nir_block, exec_list_get_tail(cf_list), cf_node.node);
+
+   /* The blocks and their SSA defs were pre-indexed on the write side in
+    * exactly this order, so associating them as we go keeps the two index
+    * spaces in sync.
+    */
+   uint32_t idx = blob_read_uint32(ctx->blob);
+   assert(idx == ctx->next_idx);
+   (void) idx;
+   read_add_object(ctx, block);
+
+   unsigned num_instrs = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_instrs; i++)
+      read_instr(ctx, block);
+}
+
+static void
+write_cf_list(write_ctx *ctx, const struct exec_list *cf_list);
+
+static void
+read_cf_list(read_ctx *ctx, struct exec_list *cf_list);
+
+static void
+write_if(write_ctx *ctx, nir_if *nif)
+{
+   write_src(ctx, &nif->condition);
+
+   write_cf_list(ctx, &nif->then_list);
+   write_cf_list(ctx, &nif->else_list);
+}
+
+static void
+read_if(read_ctx *ctx, struct exec_list *cf_list)
+{
+   nir_if *nif = nir_if_create(ctx->nir);
+
+   read_src(ctx, &nif->condition, nif);
+
+   nir_cf_node_insert_end(cf_list, &nif->cf_node);
+
+   read_cf_list(ctx, &nif->then_list);
+   read_cf_list(ctx, &nif->else_list);
+}
+
+static void
+write_loop(write_ctx *ctx, nir_loop *loop)
+{
+   write_cf_list(ctx, &loop->body);
+}
+
+static void
+read_loop(read_ctx *ctx, struct exec_list *cf_list)
+{
+   nir_loop *loop = nir_loop_create(ctx->nir);
+
+   nir_cf_node_insert_end(cf_list, &loop->cf_node);
+
+   read_cf_list(ctx, &loop->body);
+}
+
+static void
+write_cf_node(write_ctx *ctx, nir_cf_node *cf)
+{
+   blob_write_uint32(ctx->blob, cf->type);
+
+   switch (cf->type) {
+   case nir_cf_node_block:
+      write_block(ctx, nir_cf_node_as_block(cf));
+      break;
+   case nir_cf_node_if:
+      write_if(ctx, nir_cf_node_as_if(cf));
+      break;
+   case nir_cf_node_loop:
+      write_loop(ctx, nir_cf_node_as_loop(cf));
+      break;
+   default:
+      unreachable("bad cf type");
+   }
+}
+
+static void
+read_cf_node(read_ctx *ctx, struct exec_list *list)
+{
+   nir_cf_node_type type = blob_read_uint32(ctx->blob);
+
+   switch (type) {
+   case nir_cf_node_block:
+      read_block(ctx, list);
+      break;
+   case nir_cf_node_if:
+      read_if(ctx, list);
+      break;
+   case nir_cf_node_loop:
+      read_loop(ctx, list);
+      break;
+   default:
+      unreachable("bad cf type");
+   }
+}
+
+static void
+write_cf_list(write_ctx *ctx, const struct exec_list *cf_list)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(cf_list));
+   foreach_list_typed(nir_cf_node, cf, node, cf_list) {
+      write_cf_node(ctx, cf);
+   }
+}
+
+static void
+read_cf_list(read_ctx *ctx, struct exec_list *cf_list)
+{
+   uint32_t num_cf_nodes = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_cf_nodes; i++)
+      read_cf_node(ctx, cf_list);
+}
+
+static bool
+write_add_ssa_def_cb(nir_ssa_def *def, void *state)
+{
+   write_add_object(state, def);
+   return true;
+}
+
+static void
+write_function_impl(write_ctx *ctx, nir_function_impl *fi)
+{
+   write_var_list(ctx, &fi->locals);
+   write_reg_list(ctx, &fi->registers);
+   blob_write_uint32(ctx->blob, fi->reg_alloc);
+
+   blob_write_uint32(ctx->blob, fi->num_params);
+   for (unsigned i = 0; i < fi->num_params; i++)
+      write_variable(ctx, fi->params[i]);
+
+   blob_write_uint32(ctx->blob, !!(fi->return_var));
+   if (fi->return_var)
+      write_variable(ctx, fi->return_var);
+
+   /* Pre-index every block and SSA def of the function in source order so
+    * that phi sources (the only forward references in NIR) can be written
+    * as plain indices.  The reader re-creates objects in the same order, so
+    * the two index spaces line up (see read_block).
+    */
+   nir_foreach_block(block, fi) {
+      write_add_object(ctx, block);
+      nir_foreach_instr(instr, block)
+         nir_foreach_ssa_def(instr, write_add_ssa_def_cb, ctx);
+   }
+
+   write_cf_list(ctx, &fi->body);
+}
+
+static nir_function_impl *
+read_function_impl(read_ctx *ctx, nir_function *fxn)
+{
+   nir_function_impl *fi = nir_function_impl_create_bare(ctx->nir);
+   fi->function = fxn;
+
+   read_var_list(ctx, &fi->locals);
+   read_reg_list(ctx, &fi->registers);
+   fi->reg_alloc = blob_read_uint32(ctx->blob);
+
+   fi->num_params = blob_read_uint32(ctx->blob);
+   fi->params = ralloc_array(ctx->nir, nir_variable *, fi->num_params);
+   for (unsigned i = 0; i < fi->num_params; i++)
+      fi->params[i] = read_variable(ctx);
+
+   bool has_return_var = blob_read_uint32(ctx->blob);
+   if (has_return_var)
+      fi->return_var = read_variable(ctx);
+
+   assert(list_empty(&ctx->phi_srcs));
+
+   read_cf_list(ctx, &fi->body);
+   read_fixup_phis(ctx);
+
+   fi->valid_metadata = 0;
+
+   return fi;
+}
+
+static void
+write_function(write_ctx *ctx, const nir_function *fxn)
+{
+   blob_write_string(ctx->blob, fxn->name);
+   write_add_object(ctx, fxn);
+
+   blob_write_uint32(ctx->blob, fxn->num_params);
+   for (unsigned i = 0; i < fxn->num_params; i++) {
+      blob_write_uint32(ctx->blob, fxn->params[i].param_type);
+      encode_type_to_blob(ctx->blob, fxn->params[i].type);
+   }
+
+   encode_type_to_blob(ctx->blob, fxn->return_type);
+
+   /* At first glance, it looks like we should write the function_impl here.
+    * However, call instructions need to be able to reference at least the
+    * function and those will get processed as we write the function_impls.
+    * We stop here and write function_impls as a second pass.
+    */
+}
+
+static void
+read_function(read_ctx *ctx)
+{
+   char *name = blob_read_string(ctx->blob);
+
+   nir_function *fxn = nir_function_create(ctx->nir, name);
+
+   read_add_object(ctx, fxn);
+
+   fxn->num_params = blob_read_uint32(ctx->blob);
+   fxn->params = ralloc_array(fxn, nir_parameter, fxn->num_params);
+   for (unsigned i = 0; i < fxn->num_params; i++) {
+      fxn->params[i].param_type = blob_read_uint32(ctx->blob);
+      fxn->params[i].type = decode_type_from_blob(ctx->blob);
+   }
+
+   fxn->return_type = decode_type_from_blob(ctx->blob);
+}
+
+void
+nir_serialize(struct blob *blob, const nir_shader *nir)
+{
+   write_ctx ctx;
+   ctx.remap_table = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                                             _mesa_key_pointer_equal);
+   ctx.next_idx = 0;
+   ctx.blob = blob;
+   ctx.nir = nir;
+
+   blob_write_uint32(blob, nir->stage);
+
+   /* Placeholder for the total object count; the reader uses it to size its
+    * index table before anything else is read.
+    */
+   ctx.idx_count_offset = blob->size;
+   blob_write_uint32(blob, 0);
+
+   struct nir_shader_info info = nir->info;
+   uint32_t strings = 0;
+   if (info.name)
+      strings |= 0x1;
+   if (info.label)
+      strings |= 0x2;
+   blob_write_uint32(blob, strings);
+   if (info.name)
+      blob_write_string(blob, info.name);
+   if (info.label)
+      blob_write_string(blob, info.label);
+   info.name = info.label = NULL;
+   blob_write_bytes(blob, (uint8_t *) &info, sizeof(info));
+
+   write_var_list(&ctx, &nir->uniforms);
+   write_var_list(&ctx, &nir->inputs);
+   write_var_list(&ctx, &nir->outputs);
+   write_var_list(&ctx, &nir->shared);
+   write_var_list(&ctx, &nir->globals);
+   write_var_list(&ctx, &nir->system_values);
+
+   write_reg_list(&ctx, &nir->registers);
+   blob_write_uint32(blob, nir->reg_alloc);
+   blob_write_uint32(blob, nir->num_inputs);
+   blob_write_uint32(blob, nir->num_uniforms);
+   blob_write_uint32(blob, nir->num_outputs);
+   blob_write_uint32(blob, nir->num_shared);
+
+   blob_write_uint32(blob, exec_list_length(&nir->functions));
+   nir_foreach_function(fxn, nir) {
+      write_function(&ctx, fxn);
+   }
+
+   nir_foreach_function(fxn, nir) {
+      blob_write_uint32(blob, !!(fxn->impl));
+      if (fxn->impl)
+         write_function_impl(&ctx, fxn->impl);
+   }
+
+   blob_overwrite_uint32(blob, ctx.idx_count_offset, ctx.next_idx);
+
+   _mesa_hash_table_destroy(ctx.remap_table, NULL);
+}
+
+nir_shader *
+nir_deserialize(void *mem_ctx,
+                const struct nir_shader_compiler_options *options,
+                struct blob_reader *blob)
+{
+   read_ctx ctx;
+   ctx.blob = blob;
+   list_inithead(&ctx.phi_srcs);
+   ctx.next_idx = 0;
+
+   uint32_t stage = blob_read_uint32(blob);
+
+   ctx.idx_table_len = blob_read_uint32(blob);
+   ctx.idx_table = calloc(ctx.idx_table_len, sizeof(uintptr_t));
+
+   ctx.nir = nir_shader_create(mem_ctx, stage, options);
+
+   uint32_t strings = blob_read_uint32(blob);
+   char *name = (strings & 0x1) ? blob_read_string(blob) : NULL;
+   char *label = (strings & 0x2) ? blob_read_string(blob) : NULL;
+   blob_copy_bytes(blob, (uint8_t *) &ctx.nir->info, sizeof(ctx.nir->info));
+   ctx.nir->info.name = name ? ralloc_strdup(ctx.nir, name) : NULL;
+   ctx.nir->info.label = label ? ralloc_strdup(ctx.nir, label) : NULL;
+
+   read_var_list(&ctx, &ctx.nir->uniforms);
+   read_var_list(&ctx, &ctx.nir->inputs);
+   read_var_list(&ctx, &ctx.nir->outputs);
+   read_var_list(&ctx, &ctx.nir->shared);
+   read_var_list(&ctx, &ctx.nir->globals);
+   read_var_list(&ctx, &ctx.nir->system_values);
+
+   read_reg_list(&ctx, &ctx.nir->registers);
+   ctx.nir->reg_alloc = blob_read_uint32(blob);
+   ctx.nir->num_inputs = blob_read_uint32(blob);
+   ctx.nir->num_uniforms = blob_read_uint32(blob);
+   ctx.nir->num_outputs = blob_read_uint32(blob);
+   ctx.nir->num_shared = blob_read_uint32(blob);
+
+   unsigned num_functions = blob_read_uint32(blob);
+   for (unsigned i = 0; i < num_functions; i++)
+      read_function(&ctx);
+
+   nir_foreach_function(fxn, ctx.nir) {
+      bool has_impl = blob_read_uint32(blob);
+      if (has_impl)
+         fxn->impl = read_function_impl(&ctx, fxn);
+   }
+
+   free(ctx.idx_table);
+
+   return ctx.nir;
+}
@@ -63,9 +63,11 @@ sweep_block(nir_shader *nir, nir_block *block)
 {
    ralloc_steal(nir, block);
 
+   /* Instructions live in the shader's instruction pool, which is stolen
+    * back wholesale in nir_sweep, so only their out-of-line allocations need
+    * to be rescued here.
+    */
    nir_foreach_instr(instr, block) {
-      ralloc_steal(nir, instr);
-
       nir_foreach_src(instr, sweep_src_indirect, nir);
       nir_foreach_dest(instr, sweep_dest_indirect, nir);
    }
@@ -157,6 +159,12 @@ nir_sweep(nir_shader *nir)
    if (nir->info.label)
       ralloc_steal(nir, (char *)nir->info.label);
 
+   /* The instruction pool's slab space can only be reclaimed all at once
+    * when the shader dies, so the pool (and with it the slabs backing every
+    * instruction) is always kept.
+    */
+   ralloc_steal(nir, nir->instr_pool);
+
    /* Variables and registers are not dead.  Steal them back. */
    steal_list(nir, nir_variable, &nir->uniforms);
    steal_list(nir, nir_variable, &nir->inputs);
@@ -174,3 +182,296 @@ nir_sweep(nir_shader *nir)
    /* Free everything we didn't steal back. */
    ralloc_free(rubbish);
 }
+
+/*
+ * The nir_compact() pass extends the re-ralloc idea above to the
+ * instruction pool itself.  The optimization loop typically deletes most
+ * of the instructions it was handed, leaving the survivors sparsely
+ * scattered through the pool's slabs; since slab space is only reclaimed
+ * when the whole pool dies, every later walk keeps paying for the holes.
+ * Compaction relocates the surviving instructions into a fresh pool in
+ * program order and frees the old one, so backends like brw_fs_nir see a
+ * dense, in-order instruction stream.
+ *
+ * Relocating an instruction moves its embedded nir_src and nir_ssa_def
+ * list nodes, so every use/def link has to be detached before the copy
+ * and re-attached afterwards.  Out-of-line allocations hanging off the
+ * old instruction (phi sources, texture source arrays, derefs, indirect
+ * sources, ...) live in the old pool's slabs too, so they are copied
+ * into the new pool rather than stolen before the old pool is freed.
+ */
+
+struct compact_state {
+   nir_instr *old_instr;
+   nir_instr *new_instr;
+};
+
+static bool
+detach_src(nir_src *src, void *unused)
+{
+   (void)unused;
+   list_del(&src->use_link);
+   return true;
+}
+
+static bool
+detach_dest(nir_dest *dest, void *unused)
+{
+   (void)unused;
+   if (!dest->is_ssa)
+      list_del(&dest->reg.def_link);
+   return true;
+}
+
+static bool
+attach_src(nir_src *src, void *void_instr)
+{
+   nir_instr *instr = void_instr;
+
+   src->parent_instr = instr;
+   if (src->is_ssa) {
+      list_addtail(&src->use_link, &src->ssa->uses);
+   } else {
+      list_addtail(&src->use_link, &src->reg.reg->uses);
+      if (src->reg.indirect) {
+         /* Replace the indirect with a copy in the new pool; the visitor
+          * reads the pointer again after this callback, so the copy is the
+          * one that gets attached.
+          */
+         nir_src *indirect = ralloc(instr, nir_src);
+         *indirect = *src->reg.indirect;
+         src->reg.indirect = indirect;
+      }
+   }
+   return true;
+}
+
+static bool
+attach_dest(nir_dest *dest, void *void_instr)
+{
+   nir_instr *instr = void_instr;
+
+   if (!dest->is_ssa) {
+      dest->reg.parent_instr = instr;
+      list_addtail(&dest->reg.def_link, &dest->reg.reg->defs);
+      if (dest->reg.indirect) {
+         nir_src *indirect = ralloc(instr, nir_src);
+         *indirect = *dest->reg.indirect;
+         dest->reg.indirect = indirect;
+      }
+   }
+   return true;
+}
+
+/* The def's use lists moved along with the instruction, so the sentinel
+ * links have to be repaired and every use rewritten to point at the def's
+ * new address.
+ */
+static bool
+relocate_ssa_def(nir_ssa_def *def, void *void_state)
+{
+   struct compact_state *state = void_state;
+   ptrdiff_t delta = (char *)state->new_instr - (char *)state->old_instr;
+
+   def->parent_instr = state->new_instr;
+
+   /* The debug name was ralloc'ed off the old instruction and dies with
+    * the old pool; it's still readable here, so move it across too.
+    */
+   if (def->name)
+      def->name = ralloc_strdup(state->new_instr, def->name);
+
+   struct list_head *old_uses =
+      (struct list_head *)((char *)&def->uses - delta);
+   if (def->uses.next == old_uses) {
+      list_inithead(&def->uses);
+   } else {
+      def->uses.next->prev = &def->uses;
+      def->uses.prev->next = &def->uses;
+   }
+
+   struct list_head *old_if_uses =
+      (struct list_head *)((char *)&def->if_uses - delta);
+   if (def->if_uses.next == old_if_uses) {
+      list_inithead(&def->if_uses);
+   } else {
+      def->if_uses.next->prev = &def->if_uses;
+      def->if_uses.prev->next = &def->if_uses;
+   }
+
+   nir_foreach_use(use, def)
+      use->ssa = def;
+   nir_foreach_if_use(use, def)
+      use->ssa = def;
+
+   return true;
+}
+
+static size_t
+instr_size(const nir_instr *instr)
+{
+   switch (instr->type) {
+   case nir_instr_type_alu: {
+      const nir_alu_instr *alu = nir_instr_as_alu((nir_instr *)instr);
+      return sizeof(nir_alu_instr) +
+             nir_op_infos[alu->op].num_inputs * sizeof(nir_alu_src);
+   }
+   case nir_instr_type_intrinsic: {
+      const nir_intrinsic_instr *intrin =
+         nir_instr_as_intrinsic((nir_instr *)instr);
+      return sizeof(nir_intrinsic_instr) +
+             nir_intrinsic_infos[intrin->intrinsic].num_srcs * sizeof(nir_src);
+   }
+   case nir_instr_type_tex:
+      return sizeof(nir_tex_instr);
+   case nir_instr_type_load_const:
+      return sizeof(nir_load_const_instr);
+   case nir_instr_type_jump:
+      return sizeof(nir_jump_instr);
+   case nir_instr_type_ssa_undef:
+      return sizeof(nir_ssa_undef_instr);
+   case nir_instr_type_phi:
+      return sizeof(nir_phi_instr);
+   case nir_instr_type_call:
+      return sizeof(nir_call_instr);
+   case nir_instr_type_parallel_copy:
+      return sizeof(nir_parallel_copy_instr);
+   default:
+      unreachable("Invalid instruction type");
+   }
+}
+
+static void
+compact_instr(nir_shader *nir, nir_instr *old_instr)
+{
+   size_t size = instr_size(old_instr);
+
+   nir_foreach_src(old_instr, detach_src, NULL);
+   nir_foreach_dest(old_instr, detach_dest, NULL);
+
+   /* Lists of separately-allocated nodes can't just be memcpy'd; park
+    * them on the stack and splice them back in below.
+    */
+   struct exec_list stash;
+   exec_list_make_empty(&stash);
+   if (old_instr->type == nir_instr_type_phi) {
+      exec_list_move_nodes_to(&nir_instr_as_phi(old_instr)->srcs, &stash);
+   } else if (old_instr->type == nir_instr_type_parallel_copy) {
+      exec_list_move_nodes_to(&nir_instr_as_parallel_copy(old_instr)->entries,
+                              &stash);
+   }
+
+   nir_instr *new_instr = rzalloc_pool_size(nir->instr_pool, size);
+   memcpy(new_instr, old_instr, size);
+
+   /* Take the old instruction's place in the block's instruction list.
+    * Earlier instructions have already been relocated, so the copied prev
+    * pointer is valid; the next pointer still names old memory, which
+    * stays intact until the old pool is freed.
+    */
+   new_instr->node.prev->next = &new_instr->node;
+   new_instr->node.next->prev = &new_instr->node;
+
+   switch (new_instr->type) {
+   case nir_instr_type_phi: {
+      nir_phi_instr *phi = nir_instr_as_phi(new_instr);
+      exec_list_make_empty(&phi->srcs);
+      foreach_list_typed(nir_phi_src, src, node, &stash) {
+         nir_phi_src *copy = ralloc(new_instr, nir_phi_src);
+         *copy = *src;
+         exec_list_push_tail(&phi->srcs, &copy->node);
+      }
+      break;
+   }
+
+   case nir_instr_type_parallel_copy: {
+      nir_parallel_copy_instr *pcopy = nir_instr_as_parallel_copy(new_instr);
+      exec_list_make_empty(&pcopy->entries);
+      foreach_list_typed(nir_parallel_copy_entry, entry, node, &stash) {
+         nir_parallel_copy_entry *copy =
+            ralloc(new_instr, nir_parallel_copy_entry);
+         *copy = *entry;
+         exec_list_push_tail(&pcopy->entries, &copy->node);
+      }
+      break;
+   }
+
+   case nir_instr_type_tex: {
+      nir_tex_instr *tex = nir_instr_as_tex(new_instr);
+      nir_tex_src *src = ralloc_array(new_instr, nir_tex_src, tex->num_srcs);
+      memcpy(src, tex->src, tex->num_srcs * sizeof(*src));
+      tex->src = src;
+      if (tex->texture) {
+         tex->texture =
+            nir_deref_as_var(nir_copy_deref(new_instr, &tex->texture->deref));
+      }
+      if (tex->sampler) {
+         tex->sampler =
+            nir_deref_as_var(nir_copy_deref(new_instr, &tex->sampler->deref));
+      }
+      break;
+   }
+
+   case nir_instr_type_intrinsic: {
+      nir_intrinsic_instr *intrin = nir_instr_as_intrinsic(new_instr);
+      unsigned num_variables =
+         nir_intrinsic_infos[intrin->intrinsic].num_variables;
+      for (unsigned i = 0; i < num_variables; i++) {
+         intrin->variables[i] =
+            nir_deref_as_var(nir_copy_deref(new_instr,
+                                            &intrin->variables[i]->deref));
+      }
+      break;
+   }
+
+   case nir_instr_type_call: {
+      nir_call_instr *call = nir_instr_as_call(new_instr);
+      nir_deref_var **params =
+         ralloc_array(new_instr, nir_deref_var *, call->num_params);
+      for (unsigned i = 0; i < call->num_params; i++) {
+         params[i] =
+            nir_deref_as_var(nir_copy_deref(new_instr,
+                                            &call->params[i]->deref));
+      }
+      call->params = params;
+      if (call->return_deref) {
+         call->return_deref =
+            nir_deref_as_var(nir_copy_deref(new_instr,
+                                            &call->return_deref->deref));
+      }
+      break;
+   }
+
+   default:
+      break;
+   }
+
+   struct compact_state state = {
+      .old_instr = old_instr,
+      .new_instr = new_instr,
+   };
+   nir_foreach_ssa_def(new_instr, relocate_ssa_def, &state);
+   nir_foreach_dest(new_instr, attach_dest, new_instr);
+   nir_foreach_src(new_instr, attach_src, new_instr);
+}
+
+void
+nir_compact(nir_shader *nir)
+{
+   void *old_pool = nir->instr_pool;
+   nir->instr_pool = ralloc_pool_context(nir);
+
+   nir_foreach_function(function, nir) {
+      if (!function->impl)
+         continue;
+
+      nir_foreach_block(block, function->impl) {
+         nir_foreach_instr_safe(instr, block) {
+            compact_instr(nir, instr);
+         }
+      }
+   }
+
+   /* Everything live has been relocated; release the fragmented slabs. */
+   ralloc_free(old_pool);
+}
@@ -41,11 +41,56 @@ struct nir_spirv_specialization {
    uint32_t data;
 };
 
+/*
+ * A pre-parsed index of a SPIR-V module: the entry points it declares and
+ * the word span plus call targets of every function.  Building it is one
+ * linear pass, so a driver can index a shader module once at creation and
+ * then compile any number of pipelines from it without spirv_to_nir
+ * re-discovering the same structure every time.
+ */
+
+struct spirv_index_function {
+   uint32_t id;          /**< OpFunction result id */
+   uint32_t start, end;  /**< span in words, [start, end) covers through
+                              OpFunctionEnd */
+   uint32_t num_callees;
+   uint32_t *callees;    /**< OpFunctionCall targets inside the span */
+};
+
+struct spirv_index_entry_point {
+   char *name;
+   gl_shader_stage stage;
+   uint32_t function_id;
+};
+
+struct spirv_module_index {
+   uint32_t num_entry_points;
+   struct spirv_index_entry_point *entry_points;
+
+   /* In module order, so spans are ascending. */
+   uint32_t num_functions;
+   struct spirv_index_function *functions;
+};
+
+struct spirv_module_index *spirv_module_index_create(const uint32_t *words,
+                                                     size_t word_count);
+
+void spirv_module_index_destroy(struct spirv_module_index *index);
+
+const struct spirv_index_entry_point *
+spirv_module_index_find_entry_point(const struct spirv_module_index *index,
+                                    gl_shader_stage stage, const char *name);
+
+bool *spirv_module_index_reachable(const struct spirv_module_index *index,
+                                   gl_shader_stage stage, const char *name,
+                                   void *mem_ctx);
+
 nir_function *spirv_to_nir(const uint32_t *words, size_t word_count,
                            struct nir_spirv_specialization *specializations,
                            unsigned num_specializations,
                            gl_shader_stage stage, const char *entry_point_name,
-                           const nir_shader_compiler_options *options);
+                           const nir_shader_compiler_options *options,
+                           const struct spirv_module_index *index);
 
 #ifdef __cplusplus
 }
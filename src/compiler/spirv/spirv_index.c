@@ -0,0 +1,211 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * One-pass pre-parse index of a SPIR-V module.  This deliberately knows
+ * nothing about types, decorations or constants — it only records the
+ * module structure (entry points, function spans, call targets) that
+ * spirv_to_nir() would otherwise rediscover on every invocation, so a
+ * driver can build the index once per shader module and amortize it over
+ * every pipeline created from that module.
+ */
+
+#include "nir_spirv.h"
+#include "spirv.h"
+
+static gl_shader_stage
+stage_for_execution_model(SpvExecutionModel model)
+{
+   switch (model) {
+   case SpvExecutionModelVertex:
+      return MESA_SHADER_VERTEX;
+   case SpvExecutionModelTessellationControl:
+      return MESA_SHADER_TESS_CTRL;
+   case SpvExecutionModelTessellationEvaluation:
+      return MESA_SHADER_TESS_EVAL;
+   case SpvExecutionModelGeometry:
+      return MESA_SHADER_GEOMETRY;
+   case SpvExecutionModelFragment:
+      return MESA_SHADER_FRAGMENT;
+   case SpvExecutionModelGLCompute:
+      return MESA_SHADER_COMPUTE;
+   default:
+      unreachable("Unsupported execution model");
+   }
+}
+
+struct spirv_module_index *
+spirv_module_index_create(const uint32_t *words, size_t word_count)
+{
+   struct spirv_module_index *index;
+   struct spirv_index_function *func = NULL;
+   size_t offset;
+
+   if (word_count < 5 || words[0] != SpvMagicNumber)
+      return NULL;
+
+   index = rzalloc(NULL, struct spirv_module_index);
+   if (!index)
+      return NULL;
+
+   for (offset = 5; offset < word_count; ) {
+      const uint32_t *w = words + offset;
+      SpvOp opcode = w[0] & SpvOpCodeMask;
+      unsigned count = w[0] >> SpvWordCountShift;
+
+      if (count == 0 || offset + count > word_count)
+         break; /* malformed; index what we have */
+
+      switch (opcode) {
+      case SpvOpEntryPoint: {
+         struct spirv_index_entry_point *ep;
+
+         index->entry_points = reralloc(index, index->entry_points,
+                                        struct spirv_index_entry_point,
+                                        index->num_entry_points + 1);
+         ep = &index->entry_points[index->num_entry_points++];
+         ep->stage = stage_for_execution_model(w[1]);
+         ep->function_id = w[2];
+         ep->name = ralloc_strndup(index, (const char *)&w[3],
+                                   (count - 3) * sizeof(uint32_t));
+         break;
+      }
+
+      case SpvOpFunction:
+         index->functions = reralloc(index, index->functions,
+                                     struct spirv_index_function,
+                                     index->num_functions + 1);
+         func = &index->functions[index->num_functions++];
+         func->id = w[2];
+         func->start = offset;
+         func->end = 0;
+         func->num_callees = 0;
+         func->callees = NULL;
+         break;
+
+      case SpvOpFunctionEnd:
+         if (func) {
+            func->end = offset + count;
+            func = NULL;
+         }
+         break;
+
+      case SpvOpFunctionCall:
+         if (func) {
+            func->callees = reralloc(index, func->callees, uint32_t,
+                                     func->num_callees + 1);
+            func->callees[func->num_callees++] = w[3];
+         }
+         break;
+
+      default:
+         break;
+      }
+
+      offset += count;
+   }
+
+   /* reralloc moves the function array, so fix up spans of any function
+    * left open by a malformed module.
+    */
+   if (index->num_functions &&
+       index->functions[index->num_functions - 1].end == 0)
+      index->functions[index->num_functions - 1].end = word_count;
+
+   return index;
+}
+
+void
+spirv_module_index_destroy(struct spirv_module_index *index)
+{
+   ralloc_free(index);
+}
+
+const struct spirv_index_entry_point *
+spirv_module_index_find_entry_point(const struct spirv_module_index *index,
+                                    gl_shader_stage stage, const char *name)
+{
+   for (uint32_t i = 0; i < index->num_entry_points; i++) {
+      if (index->entry_points[i].stage == stage &&
+          strcmp(index->entry_points[i].name, name) == 0)
+         return &index->entry_points[i];
+   }
+   return NULL;
+}
+
+static int
+function_index_for_id(const struct spirv_module_index *index, uint32_t id)
+{
+   for (uint32_t i = 0; i < index->num_functions; i++) {
+      if (index->functions[i].id == id)
+         return i;
+   }
+   return -1;
+}
+
+/**
+ * Compute which functions the given entry point can reach through the
+ * static call graph.  Returns a ralloc'd bool array parallel to
+ * index->functions, or NULL if the entry point isn't in the index.
+ */
+bool *
+spirv_module_index_reachable(const struct spirv_module_index *index,
+                             gl_shader_stage stage, const char *name,
+                             void *mem_ctx)
+{
+   const struct spirv_index_entry_point *ep =
+      spirv_module_index_find_entry_point(index, stage, name);
+   bool *reachable;
+   bool progress;
+
+   if (!ep)
+      return NULL;
+
+   reachable = rzalloc_array(mem_ctx, bool, index->num_functions);
+
+   int root = function_index_for_id(index, ep->function_id);
+   if (root < 0)
+      return NULL;
+   reachable[root] = true;
+
+   /* The function count is small; sweeping to a fixpoint beats building
+    * a worklist.
+    */
+   do {
+      progress = false;
+      for (uint32_t i = 0; i < index->num_functions; i++) {
+         if (!reachable[i])
+            continue;
+         for (uint32_t c = 0; c < index->functions[i].num_callees; c++) {
+            int callee =
+               function_index_for_id(index, index->functions[i].callees[c]);
+            if (callee >= 0 && !reachable[callee]) {
+               reachable[callee] = true;
+               progress = true;
+            }
+         }
+      }
+   } while (progress);
+
+   return reachable;
+}
@@ -1156,8 +1156,14 @@ static void
 vtn_handle_function_call(struct vtn_builder *b, SpvOp opcode,
                          const uint32_t *w, unsigned count)
 {
-   struct nir_function *callee =
-      vtn_value(b, w[3], vtn_value_type_function)->func->impl->function;
+   struct vtn_function *vtn_callee =
+      vtn_value(b, w[3], vtn_value_type_function)->func;
+   struct nir_function *callee = vtn_callee->impl->function;
+
+   /* The callee is now known to be reachable from the entry point, so the
+    * emission loop in spirv_to_nir() has to convert it.
+    */
+   vtn_callee->referenced = true;
 
    nir_call_instr *call = nir_call_instr_create(b->nb.shader, callee);
    for (unsigned i = 0; i < call->num_params; i++) {
@@ -2727,8 +2733,10 @@ nir_function *
 spirv_to_nir(const uint32_t *words, size_t word_count,
              struct nir_spirv_specialization *spec, unsigned num_spec,
              gl_shader_stage stage, const char *entry_point_name,
-             const nir_shader_compiler_options *options)
+             const nir_shader_compiler_options *options,
+             const struct spirv_module_index *index)
 {
+   const uint32_t *module = words;
    const uint32_t *word_end = words + word_count;
 
    /* Handle the SPIR-V header (first 4 dwords)  */
@@ -2776,20 +2784,61 @@ spirv_to_nir(const uint32_t *words, size_t word_count,
    words = vtn_foreach_instruction(b, words, word_end,
                                    vtn_handle_variable_or_type_instruction);
 
-   vtn_build_cfg(b, words, word_end);
-
-   foreach_list_typed(struct vtn_function, func, node, &b->functions) {
-      b->impl = func->impl;
-      b->const_table = _mesa_hash_table_create(b, _mesa_hash_pointer,
-                                               _mesa_key_pointer_equal);
-
-      vtn_function_emit(b, func, vtn_handle_body_instruction);
+   /* If the caller pre-indexed the module, we don't have to walk every
+    * function body to build CFGs: only the spans the entry point can
+    * reach through the static call graph matter.  The reachable set is
+    * transitively closed, so any function a walked body calls has also
+    * been walked.
+    */
+   bool *reachable = NULL;
+   if (index)
+      reachable = spirv_module_index_reachable(index, stage,
+                                               entry_point_name, b);
+
+   if (reachable) {
+      for (uint32_t i = 0; i < index->num_functions; i++) {
+         if (reachable[i]) {
+            vtn_build_cfg(b, module + index->functions[i].start,
+                          module + index->functions[i].end);
+         }
+      }
+   } else {
+      vtn_build_cfg(b, words, word_end);
    }
 
    assert(b->entry_point->value_type == vtn_value_type_function);
+   b->entry_point->func->referenced = true;
+
+   /* Emit only what the entry point's call graph reaches.  Emitting a
+    * function marks its callees as referenced, so we just keep sweeping
+    * the list until no referenced function is left unemitted.
+    */
+   bool progress;
+   do {
+      progress = false;
+      foreach_list_typed(struct vtn_function, func, node, &b->functions) {
+         if (func->referenced && !func->emitted) {
+            b->impl = func->impl;
+            b->const_table = _mesa_hash_table_create(b, _mesa_hash_pointer,
+                                                     _mesa_key_pointer_equal);
+
+            vtn_function_emit(b, func, vtn_handle_body_instruction);
+            progress = true;
+         }
+      }
+   } while (progress);
+
    nir_function *entry_point = b->entry_point->func->impl->function;
    assert(entry_point);
 
+   /* Functions that were never referenced were never converted; remove
+    * them from the shader so later passes don't trip over empty shells.
+    */
+   foreach_list_typed(struct vtn_function, func, node, &b->functions) {
+      if (!func->referenced)
+         exec_node_remove(&func->impl->function->node);
+   }
+
    ralloc_free(b);
 
    return entry_point;
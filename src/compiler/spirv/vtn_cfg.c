@@ -462,10 +462,10 @@ vtn_build_cfg(struct vtn_builder *b, const uint32_t *words, const uint32_t *end)
    vtn_foreach_instruction(b, words, end,
                            vtn_cfg_handle_prepass_instruction);
 
-   foreach_list_typed(struct vtn_function, func, node, &b->functions) {
-      vtn_cfg_walk_blocks(b, &func->body, func->start_block,
-                          NULL, NULL, NULL, NULL, NULL);
-   }
+   /* Structurizing each function's CFG is deferred to its first
+    * vtn_function_emit(), so functions that turn out to be unreachable
+    * from the entry point never pay for it.
+    */
 }
 
 static bool
@@ -758,6 +758,12 @@ void
 vtn_function_emit(struct vtn_builder *b, struct vtn_function *func,
                   vtn_instruction_handler instruction_handler)
 {
+   if (!func->cfg_built) {
+      vtn_cfg_walk_blocks(b, &func->body, func->start_block,
+                          NULL, NULL, NULL, NULL, NULL);
+      func->cfg_built = true;
+   }
+
    nir_builder_init(&b->nb, func->impl);
    b->nb.cursor = nir_after_cf_list(&func->impl->body);
    b->has_loop_continue = false;
@@ -775,4 +781,6 @@ vtn_function_emit(struct vtn_builder *b, struct vtn_function *func,
     */
    if (b->has_loop_continue)
       nir_repair_ssa_impl(func->impl);
+
+   func->emitted = true;
 }
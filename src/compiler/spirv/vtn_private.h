@@ -164,6 +164,14 @@ struct vtn_function {
    const uint32_t *end;
 
    SpvFunctionControlMask control;
+
+   /* Lazy conversion state: a function is only structurized and emitted
+    * once it is known to be reachable from the entry point.  See the
+    * emission loop in spirv_to_nir().
+    */
+   bool referenced;
+   bool cfg_built;
+   bool emitted;
 };
 
 typedef bool (*vtn_instruction_handler)(struct vtn_builder *, uint32_t,
@@ -56,6 +56,7 @@
 #endif
 
 #include "egl_dri2.h"
+#include "loader.h"
 #include "util/u_atomic.h"
 
 /* The kernel header drm_fourcc.h defines the DRM formats below.  We duplicate
@@ -437,7 +438,14 @@ dri2_open_driver(_EGLDisplay *disp)
    if (search_paths == NULL)
       search_paths = DEFAULT_DRIVER_DIR;
 
-   dri2_dpy->driver = NULL;
+   /* another display may have located the driver already */
+   dri2_dpy->driver = loader_open_cached_driver(dri2_dpy->driver_name);
+   if (dri2_dpy->driver != NULL) {
+      _eglLog(_EGL_DEBUG, "DRI2: reusing already loaded %s_dri.so",
+              dri2_dpy->driver_name);
+      goto driver_found;
+   }
+
    end = search_paths + strlen(search_paths);
    for (p = search_paths; p < end; p = next + 1) {
       int len;
@@ -480,6 +488,9 @@ dri2_open_driver(_EGLDisplay *disp)
    }
 
    _eglLog(_EGL_DEBUG, "DRI2: dlopen(%s)", path);
+   loader_cache_driver(dri2_dpy->driver_name, path);
+
+driver_found:
 
    if (asprintf(&get_extensions_name, "%s_%s",
                 __DRI_DRIVER_GET_EXTENSIONS, dri2_dpy->driver_name) != -1) {
@@ -743,6 +754,10 @@ dri2_create_screen(_EGLDisplay *disp)
       }
       if (strcmp(extensions[i]->name, __DRI2_INTEROP) == 0)
          dri2_dpy->interop = (__DRI2interopExtension *) extensions[i];
+      if (strcmp(extensions[i]->name, __DRI2_BUFFER_DAMAGE) == 0) {
+         dri2_dpy->buffer_damage =
+            (__DRI2bufferDamageExtension *) extensions[i];
+      }
    }
 
    dri2_setup_screen(disp);
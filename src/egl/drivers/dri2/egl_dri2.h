@@ -175,6 +175,7 @@ struct dri2_egl_display
    const __DRI2fenceExtension *fence;
    const __DRI2rendererQueryExtension *rendererQuery;
    const __DRI2interopExtension *interop;
+   const __DRI2bufferDamageExtension *buffer_damage;
    int                       fd;
 
    int                       own_device;
@@ -197,8 +197,18 @@ dri2_drm_destroy_surface(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *surf)
    (*dri2_dpy->core->destroyDrawable)(dri2_surf->dri_drawable);
 
    for (i = 0; i < ARRAY_SIZE(dri2_surf->color_buffers); i++) {
-      if (dri2_surf->color_buffers[i].bo)
-	 gbm_bo_destroy(dri2_surf->color_buffers[i].bo);
+      struct gbm_bo *bo = dri2_surf->color_buffers[i].bo;
+
+      if (bo == NULL)
+         continue;
+
+      /* Park idle buffers on the gbm surface so the next EGL surface
+       * created on it reuses them.  Locked buffers may still be on
+       * scanout and are destroyed as before.
+       */
+      if (dri2_surf->color_buffers[i].locked ||
+          !gbm_dri_surface_cache_bo(dri2_surf->gbm_surf, bo))
+         gbm_bo_destroy(bo);
    }
 
    for (i = 0; i < __DRI_BUFFER_COUNT; i++) {
@@ -231,6 +241,8 @@ get_back_bo(struct dri2_egl_surface *dri2_surf)
 
    if (dri2_surf->back == NULL)
       return -1;
+   if (dri2_surf->back->bo == NULL)
+      dri2_surf->back->bo = gbm_dri_surface_get_cached_bo(surf);
    if (dri2_surf->back->bo == NULL)
       dri2_surf->back->bo = gbm_bo_create(&dri2_dpy->gbm_dri->base.base,
 					  surf->base.width, surf->base.height,
@@ -253,6 +265,8 @@ get_swrast_front_bo(struct dri2_egl_surface *dri2_surf)
       dri2_surf->current = &dri2_surf->color_buffers[0];
    }
 
+   if (dri2_surf->current->bo == NULL)
+      dri2_surf->current->bo = gbm_dri_surface_get_cached_bo(surf);
    if (dri2_surf->current->bo == NULL)
       dri2_surf->current->bo = gbm_bo_create(&dri2_dpy->gbm_dri->base.base,
                                              surf->base.width, surf->base.height,
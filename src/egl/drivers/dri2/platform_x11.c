@@ -899,6 +899,24 @@ dri2_x11_swap_buffers(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *draw)
    }
 }
 
+static EGLBoolean
+dri2_x11_swrast_swap_buffers_with_damage(_EGLDriver *drv, _EGLDisplay *disp,
+                                         _EGLSurface *draw,
+                                         const EGLint *rects, EGLint n_rects)
+{
+   struct dri2_egl_display *dri2_dpy = dri2_egl_display(disp);
+   struct dri2_egl_surface *dri2_surf = dri2_egl_surface(draw);
+
+   /* Hand the damage to the driver so the swap only pushes the dirty
+    * region of the drawable to the server.
+    */
+   if (dri2_dpy->buffer_damage)
+      dri2_dpy->buffer_damage->set_damage_region(dri2_surf->dri_drawable,
+                                                 n_rects, (int *) rects);
+
+   return dri2_x11_swap_buffers(drv, disp, draw);
+}
+
 static EGLBoolean
 dri2_x11_swap_buffers_region(_EGLDriver *drv, _EGLDisplay *disp,
                              _EGLSurface *draw,
@@ -1135,6 +1153,7 @@ static struct dri2_egl_display_vtbl dri2_x11_swrast_display_vtbl = {
    .create_image = dri2_fallback_create_image_khr,
    .swap_interval = dri2_fallback_swap_interval,
    .swap_buffers = dri2_x11_swap_buffers,
+   .swap_buffers_with_damage = dri2_x11_swrast_swap_buffers_with_damage,
    .swap_buffers_region = dri2_fallback_swap_buffers_region,
    .post_sub_buffer = dri2_fallback_post_sub_buffer,
    .copy_buffers = dri2_x11_copy_buffers,
@@ -1213,6 +1232,9 @@ dri2_initialize_x11_swrast(_EGLDriver *drv, _EGLDisplay *disp)
    if (!dri2_x11_add_configs_for_visuals(dri2_dpy, disp, true))
       goto cleanup_configs;
 
+   if (dri2_dpy->buffer_damage)
+      disp->Extensions.EXT_swap_buffers_with_damage = EGL_TRUE;
+
    /* Fill vtbl last to prevent accidentally calling virtual function during
     * initialization.
     */
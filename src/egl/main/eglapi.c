@@ -1005,8 +1005,20 @@ eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
       RETURN_EGL_ERROR(disp, EGL_BAD_SURFACE, EGL_FALSE);
    #endif
 
+   /* A swap may block for a frame or more (throttling, vsync); do not make
+    * every other thread using this display wait for it.  The surface cannot
+    * go away while the lock is dropped: it is the calling thread's current
+    * draw surface and only this thread can release that binding.
+    */
+   _eglGetSurface(surf);
+   _eglUnlockDisplay(disp);
+
    ret = drv->API.SwapBuffers(drv, disp, surf);
 
+   mtx_lock(&disp->Mutex);
+   /* cannot be the last reference; the current binding still holds one */
+   _eglPutSurface(surf);
+
    RETURN_EGL_EVAL(disp, ret);
 }
 
@@ -1031,8 +1043,15 @@ eglSwapBuffersWithDamageEXT(EGLDisplay dpy, EGLSurface surface,
    if ((n_rects > 0 && rects == NULL) || n_rects < 0)
       RETURN_EGL_ERROR(disp, EGL_BAD_PARAMETER, EGL_FALSE);
 
+   /* see eglSwapBuffers */
+   _eglGetSurface(surf);
+   _eglUnlockDisplay(disp);
+
    ret = drv->API.SwapBuffersWithDamageEXT(drv, disp, surf, rects, n_rects);
 
+   mtx_lock(&disp->Mutex);
+   _eglPutSurface(surf);
+
    RETURN_EGL_EVAL(disp, ret);
 }
 
@@ -1079,8 +1098,17 @@ eglWaitClient(void)
    /* a valid current context implies an initialized current display */
    assert(disp->Initialized);
    drv = disp->Driver;
+
+   /* the driver waits for rendering to finish; drop the lock so other
+    * threads can use the display meanwhile.  The context is pinned by the
+    * calling thread's current binding, which only this thread can release.
+    */
+   mtx_unlock(&disp->Mutex);
+
    ret = drv->API.WaitClient(drv, disp, ctx);
 
+   mtx_lock(&disp->Mutex);
+
    RETURN_EGL_EVAL(disp, ret);
 }
 
@@ -1125,8 +1153,14 @@ eglWaitNative(EGLint engine)
    /* a valid current context implies an initialized current display */
    assert(disp->Initialized);
    drv = disp->Driver;
+
+   /* see eglWaitClient */
+   mtx_unlock(&disp->Mutex);
+
    ret = drv->API.WaitNative(drv, disp, engine);
 
+   mtx_lock(&disp->Mutex);
+
    RETURN_EGL_EVAL(disp, ret);
 }
 
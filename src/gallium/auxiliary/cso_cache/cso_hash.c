@@ -30,211 +30,219 @@
   *   Zack Rusin <zackr@vmware.com>
   */
 
+/*
+ * Open-addressing hash with inline entry storage and linear probing.
+ * Entries live directly in the slot array, so a lookup is a scan of
+ * adjacent slots rather than a walk of separately allocated nodes,
+ * and inserting doesn't malloc.
+ *
+ * The table is kept free of wrap-around by appending a small overflow
+ * tail after the power-of-two home range: probe order is plain slot
+ * order, which makes iteration and the collision scans below trivial.
+ * Three invariants are maintained:
+ *
+ *  - an entry is always reachable from its home slot without crossing
+ *    an empty slot (the usual linear-probing rule);
+ *
+ *  - entries sharing a key occupy consecutive filled slots, so a
+ *    caller can walk all of them with cso_hash_iter_next() until the
+ *    key changes (inserts shift trailing entries up by one slot when
+ *    needed to keep such runs together);
+ *
+ *  - removal only marks a slot deleted and never moves other entries,
+ *    so iterators stay valid across cso_hash_erase()/cso_hash_take().
+ *    Deleted slots are reclaimed by the next rehash.
+ */
+
 #include "util/u_debug.h"
 #include "util/u_memory.h"
 
 #include "cso_hash.h"
 
-#ifndef MAX
-#define MAX(a, b) ((a > b) ? (a) : (b))
-#endif
-
-static const int MinNumBits = 4;
-
-static const unsigned char prime_deltas[] = {
-   0,  0,  1,  3,  1,  5,  3,  3,  1,  9,  7,  5,  3,  9, 25,  3,
-   1, 21,  3, 21,  7, 15,  9,  5,  3, 29, 15,  0,  0,  0,  0,  0
-};
-
-static int primeForNumBits(int numBits)
-{
-   return (1 << numBits) + prime_deltas[numBits];
-}
+static const unsigned MinNumSlots = 16;
 
-/*
-    Returns the smallest integer n such that
-    primeForNumBits(n) >= hint.
-*/
-static int countBits(int hint)
-{
-   int numBits = 0;
-   int bits = hint;
+/* Probes beyond the home range spill into this many extra slots instead
+ * of wrapping around; running out of them forces a rehash.
+ */
+static const unsigned NumOverflowSlots = 16;
 
-   while (bits > 1) {
-      bits >>= 1;
-      numBits++;
-   }
+static const unsigned InvalidSlot = ~0u;
 
-   if (numBits >= (int)sizeof(prime_deltas)) {
-      numBits = sizeof(prime_deltas) - 1;
-   } else if (primeForNumBits(numBits) < hint) {
-      ++numBits;
-   }
-   return numBits;
-}
+enum cso_slot_state {
+   CSO_SLOT_EMPTY,    /* zero so calloc'd tables start out empty */
+   CSO_SLOT_FILLED,
+   CSO_SLOT_DELETED
+};
 
-struct cso_node {
-   struct cso_node *next;
+struct cso_hash_entry {
    unsigned key;
+   unsigned state;     /* enum cso_slot_state */
    void *value;
 };
 
-struct cso_hash_data {
-   struct cso_node *fakeNext;
-   struct cso_node **buckets;
-   int size;
-   int nodeSize;
-   short userNumBits;
-   short numBits;
-   int numBuckets;
-};
-
 struct cso_hash {
-   union {
-      struct cso_hash_data *d;
-      struct cso_node      *e;
-   } data;
+   struct cso_hash_entry *table;
+   unsigned numSlots;   /* power-of-two home range */
+   unsigned maxSlots;   /* numSlots plus the overflow tail */
+   unsigned shift;      /* maps a mixed key to [0, numSlots) */
+   unsigned numDeleted;
+   int size;
 };
 
-static void *cso_data_allocate_node(struct cso_hash_data *hash)
-{
-   return MALLOC(hash->nodeSize);
-}
-
-static void cso_free_node(struct cso_node *node)
+/*
+ * Keys are hashes the callers computed themselves and can be of poor
+ * quality (sequential, or a few xor'd words), so spread them with a
+ * multiplicative mix before taking the top bits.
+ */
+static unsigned cso_hash_home_slot(const struct cso_hash *hash, unsigned key)
 {
-   FREE(node);
+   return (key * 2654435761u) >> hash->shift;
 }
 
-static struct cso_node *
-cso_hash_create_node(struct cso_hash *hash,
-                      unsigned akey, void *avalue,
-                      struct cso_node **anextNode)
+static unsigned cso_slot_shift(unsigned numSlots)
 {
-   struct cso_node *node = cso_data_allocate_node(hash->data.d);
-
-   if (!node)
-      return NULL;
-
-   node->key = akey;
-   node->value = avalue;
-
-   node->next = (struct cso_node*)(*anextNode);
-   *anextNode = node;
-   ++hash->data.d->size;
-   return node;
+   unsigned shift = 32;
+   while (numSlots > 1) {
+      numSlots >>= 1;
+      --shift;
+   }
+   return shift;
 }
 
-static void cso_data_rehash(struct cso_hash_data *hash, int hint)
+/*
+ * Place a key/value pair in the given table, upholding the reachability
+ * and equal-key-run invariants described above.  Returns the slot used,
+ * or InvalidSlot if the probe sequence ran off the end of the table and
+ * the caller has to rehash.
+ */
+static unsigned cso_hash_place(struct cso_hash_entry *table,
+                               unsigned maxSlots, unsigned shift,
+                               unsigned key, void *value,
+                               unsigned *numDeleted)
 {
-   if (hint < 0) {
-      hint = countBits(-hint);
-      if (hint < MinNumBits)
-         hint = MinNumBits;
-      hash->userNumBits = (short)hint;
-      while (primeForNumBits(hint) < (hash->size >> 1))
-         ++hint;
-   } else if (hint < MinNumBits) {
-      hint = MinNumBits;
+   unsigned i = (key * 2654435761u) >> shift;
+   unsigned lastMatch = InvalidSlot;
+   unsigned pos;
+
+   for (; i < maxSlots; ++i) {
+      if (table[i].state == CSO_SLOT_EMPTY)
+         break;
+      if (table[i].state == CSO_SLOT_FILLED && table[i].key == key)
+         lastMatch = i;
    }
 
-   if (hash->numBits != hint) {
-      struct cso_node *e = (struct cso_node *)(hash);
-      struct cso_node **oldBuckets = hash->buckets;
-      int oldNumBuckets = hash->numBuckets;
-      int  i = 0;
-
-      hash->numBits = (short)hint;
-      hash->numBuckets = primeForNumBits(hint);
-      hash->buckets = MALLOC(sizeof(struct cso_node*) * hash->numBuckets);
-      for (i = 0; i < hash->numBuckets; ++i)
-         hash->buckets[i] = e;
-
-      for (i = 0; i < oldNumBuckets; ++i) {
-         struct cso_node *firstNode = oldBuckets[i];
-         while (firstNode != e) {
-            unsigned h = firstNode->key;
-            struct cso_node *lastNode = firstNode;
-            struct cso_node *afterLastNode;
-            struct cso_node **beforeFirstNode;
-            
-            while (lastNode->next != e && lastNode->next->key == h)
-               lastNode = lastNode->next;
-
-            afterLastNode = lastNode->next;
-            beforeFirstNode = &hash->buckets[h % hash->numBuckets];
-            while (*beforeFirstNode != e)
-               beforeFirstNode = &(*beforeFirstNode)->next;
-            lastNode->next = *beforeFirstNode;
-            *beforeFirstNode = firstNode;
-            firstNode = afterLastNode;
-         }
+   if (lastMatch == InvalidSlot) {
+      /* No entry with this key yet.  Only an empty slot is acceptable:
+       * a deleted slot may sit in the middle of another key's run and
+       * filling it would break that run apart.
+       */
+      if (i == maxSlots)
+         return InvalidSlot;
+      pos = i;
+   } else {
+      /* Append right after the existing run of this key. */
+      pos = lastMatch + 1;
+      if (pos == maxSlots)
+         return InvalidSlot;
+      if (table[pos].state == CSO_SLOT_FILLED) {
+         /* Shift the entries between here and the next free slot up by
+          * one.  No foreign run can straddle either end of the shifted
+          * range, so their contiguity is preserved.
+          */
+         unsigned end = pos;
+         while (end < maxSlots && table[end].state == CSO_SLOT_FILLED)
+            ++end;
+         if (end == maxSlots)
+            return InvalidSlot;
+         if (table[end].state == CSO_SLOT_DELETED)
+            --*numDeleted;
+         memmove(&table[pos + 1], &table[pos],
+                 (end - pos) * sizeof(table[0]));
+      } else if (table[pos].state == CSO_SLOT_DELETED) {
+         --*numDeleted;
       }
-      FREE(oldBuckets);
    }
-}
 
-static void cso_data_might_grow(struct cso_hash_data *hash)
-{
-   if (hash->size >= hash->numBuckets)
-      cso_data_rehash(hash, hash->numBits + 1);
+   table[pos].state = CSO_SLOT_FILLED;
+   table[pos].key = key;
+   table[pos].value = value;
+   return pos;
 }
 
-static void cso_data_has_shrunk(struct cso_hash_data *hash)
+static boolean cso_data_rehash(struct cso_hash *hash, unsigned numSlots)
 {
-   if (hash->size <= (hash->numBuckets >> 3) &&
-       hash->numBits > hash->userNumBits) {
-      int max = MAX(hash->numBits-2, hash->userNumBits);
-      cso_data_rehash(hash,  max);
-   }
-}
+   for (;;) {
+      unsigned maxSlots = numSlots + NumOverflowSlots;
+      unsigned shift = cso_slot_shift(numSlots);
+      unsigned numDeleted = 0;
+      struct cso_hash_entry *table =
+         CALLOC(maxSlots, sizeof(struct cso_hash_entry));
+      unsigned i;
+
+      if (!table)
+         return FALSE;
+
+      for (i = 0; i < hash->maxSlots; ++i) {
+         if (hash->table[i].state != CSO_SLOT_FILLED)
+            continue;
+         if (cso_hash_place(table, maxSlots, shift,
+                            hash->table[i].key, hash->table[i].value,
+                            &numDeleted) == InvalidSlot)
+            break;
+      }
+      if (i < hash->maxSlots) {
+         /* an overly long cluster ran off the end; try a bigger table */
+         FREE(table);
+         numSlots *= 2;
+         continue;
+      }
 
-static struct cso_node *cso_data_first_node(struct cso_hash_data *hash)
-{
-   struct cso_node *e = (struct cso_node *)(hash);
-   struct cso_node **bucket = hash->buckets;
-   int n = hash->numBuckets;
-   while (n--) {
-      if (*bucket != e)
-         return *bucket;
-      ++bucket;
+      FREE(hash->table);
+      hash->table = table;
+      hash->numSlots = numSlots;
+      hash->maxSlots = maxSlots;
+      hash->shift = shift;
+      hash->numDeleted = 0;
+      return TRUE;
    }
-   return e;
 }
 
-static struct cso_node **cso_hash_find_node(struct cso_hash *hash, unsigned akey)
+static void cso_data_might_grow(struct cso_hash *hash)
 {
-   struct cso_node **node;
-
-   if (hash->data.d->numBuckets) {
-      node = (struct cso_node **)(&hash->data.d->buckets[akey % hash->data.d->numBuckets]);
-      assert(*node == hash->data.e || (*node)->next);
-      while (*node != hash->data.e && (*node)->key != akey)
-         node = &(*node)->next;
-   } else {
-      node = (struct cso_node **)((const struct cso_node * const *)(&hash->data.e));
-   }
-   return node;
+   unsigned numSlots = MinNumSlots;
+
+   /* Grow (or just sweep out deleted slots) when the table is getting
+    * three quarters full.
+    */
+   if (((unsigned)hash->size + hash->numDeleted + 1) * 4 <=
+       hash->numSlots * 3)
+      return;
+
+   while (((unsigned)hash->size + 1) * 4 > numSlots * 3)
+      numSlots *= 2;
+   cso_data_rehash(hash, numSlots);
 }
 
 struct cso_hash_iter cso_hash_insert(struct cso_hash *hash,
                                        unsigned key, void *data)
 {
-   cso_data_might_grow(hash->data.d);
-
-   {
-      struct cso_node **nextNode = cso_hash_find_node(hash, key);
-      struct cso_node *node = cso_hash_create_node(hash, key, data, nextNode);
-      if (!node) {
-         struct cso_hash_iter null_iter = {hash, 0};
-         return null_iter;
-      }
+   struct cso_hash_iter iter = {hash, InvalidSlot};
+   unsigned slot;
+
+   cso_data_might_grow(hash);
 
-      {
-         struct cso_hash_iter iter = {hash, node};
+   slot = cso_hash_place(hash->table, hash->maxSlots, hash->shift,
+                         key, data, &hash->numDeleted);
+   while (slot == InvalidSlot) {
+      if (!cso_data_rehash(hash, hash->numSlots * 2))
          return iter;
-      }
+      slot = cso_hash_place(hash->table, hash->maxSlots, hash->shift,
+                            key, data, &hash->numDeleted);
    }
+
+   ++hash->size;
+   iter.slot = slot;
+   return iter;
 }
 
 struct cso_hash * cso_hash_create(void)
@@ -243,199 +251,147 @@ struct cso_hash * cso_hash_create(void)
    if (!hash)
       return NULL;
 
-   hash->data.d = MALLOC_STRUCT(cso_hash_data);
-   if (!hash->data.d) {
+   hash->numSlots = MinNumSlots;
+   hash->maxSlots = MinNumSlots + NumOverflowSlots;
+   hash->shift = cso_slot_shift(MinNumSlots);
+   hash->numDeleted = 0;
+   hash->size = 0;
+   hash->table = CALLOC(hash->maxSlots, sizeof(struct cso_hash_entry));
+   if (!hash->table) {
       FREE(hash);
       return NULL;
    }
 
-   hash->data.d->fakeNext = 0;
-   hash->data.d->buckets = 0;
-   hash->data.d->size = 0;
-   hash->data.d->nodeSize = sizeof(struct cso_node);
-   hash->data.d->userNumBits = (short)MinNumBits;
-   hash->data.d->numBits = 0;
-   hash->data.d->numBuckets = 0;
-
    return hash;
 }
 
 void cso_hash_delete(struct cso_hash *hash)
 {
-   struct cso_node *e_for_x = (struct cso_node *)(hash->data.d);
-   struct cso_node **bucket = (struct cso_node **)(hash->data.d->buckets);
-   int n = hash->data.d->numBuckets;
-   while (n--) {
-      struct cso_node *cur = *bucket++;
-      while (cur != e_for_x) {
-         struct cso_node *next = cur->next;
-         cso_free_node(cur);
-         cur = next;
-      }
-   }
-   FREE(hash->data.d->buckets);
-   FREE(hash->data.d);
+   FREE(hash->table);
    FREE(hash);
 }
 
 struct cso_hash_iter cso_hash_find(struct cso_hash *hash,
                                      unsigned key)
 {
-   struct cso_node **nextNode = cso_hash_find_node(hash, key);
-   struct cso_hash_iter iter = {hash, *nextNode};
+   struct cso_hash_iter iter = {hash, InvalidSlot};
+   unsigned i;
+
+   for (i = cso_hash_home_slot(hash, key); i < hash->maxSlots; ++i) {
+      if (hash->table[i].state == CSO_SLOT_EMPTY)
+         break;
+      if (hash->table[i].state == CSO_SLOT_FILLED &&
+          hash->table[i].key == key) {
+         iter.slot = i;
+         break;
+      }
+   }
    return iter;
 }
 
 unsigned cso_hash_iter_key(struct cso_hash_iter iter)
 {
-   if (!iter.node || iter.hash->data.e == iter.node)
+   if (iter.slot == InvalidSlot)
       return 0;
-   return iter.node->key;
+   return iter.hash->table[iter.slot].key;
 }
 
 void * cso_hash_iter_data(struct cso_hash_iter iter)
 {
-   if (!iter.node || iter.hash->data.e == iter.node)
+   if (iter.slot == InvalidSlot)
       return 0;
-   return iter.node->value;
+   return iter.hash->table[iter.slot].value;
 }
 
-static struct cso_node *cso_hash_data_next(struct cso_node *node)
+struct cso_hash_iter cso_hash_iter_next(struct cso_hash_iter iter)
 {
-   union {
-      struct cso_node *next;
-      struct cso_node *e;
-      struct cso_hash_data *d;
-   } a;
-   int start;
-   struct cso_node **bucket;
-   int n;
-
-   a.next = node->next;
-   if (!a.next) {
+   struct cso_hash_iter next = {iter.hash, InvalidSlot};
+   unsigned i;
+
+   if (iter.slot == InvalidSlot) {
       debug_printf("iterating beyond the last element\n");
-      return 0;
-   }
-   if (a.next->next)
-      return a.next;
-
-   start = (node->key % a.d->numBuckets) + 1;
-   bucket = a.d->buckets + start;
-   n = a.d->numBuckets - start;
-   while (n--) {
-      if (*bucket != a.e)
-         return *bucket;
-      ++bucket;
+      return next;
    }
-   return a.e;
-}
 
-
-static struct cso_node *cso_hash_data_prev(struct cso_node *node)
-{
-   union {
-      struct cso_node *e;
-      struct cso_hash_data *d;
-   } a;
-   int start;
-   struct cso_node *sentinel;
-   struct cso_node **bucket;
-
-   a.e = node;
-   while (a.e->next)
-      a.e = a.e->next;
-
-   if (node == a.e)
-      start = a.d->numBuckets - 1;
-   else
-      start = node->key % a.d->numBuckets;
-
-   sentinel = node;
-   bucket = a.d->buckets + start;
-   while (start >= 0) {
-      if (*bucket != sentinel) {
-         struct cso_node *prev = *bucket;
-         while (prev->next != sentinel)
-            prev = prev->next;
-         return prev;
+   for (i = iter.slot + 1; i < iter.hash->maxSlots; ++i) {
+      if (iter.hash->table[i].state == CSO_SLOT_FILLED) {
+         next.slot = i;
+         break;
       }
-
-      sentinel = a.e;
-      --bucket;
-      --start;
    }
-   debug_printf("iterating backward beyond first element\n");
-   return a.e;
-}
-
-struct cso_hash_iter cso_hash_iter_next(struct cso_hash_iter iter)
-{
-   struct cso_hash_iter next = {iter.hash, cso_hash_data_next(iter.node)};
    return next;
 }
 
 int cso_hash_iter_is_null(struct cso_hash_iter iter)
 {
-   if (!iter.node || iter.node == iter.hash->data.e)
-      return 1;
-   return 0;
+   return iter.slot == InvalidSlot;
 }
 
 void * cso_hash_take(struct cso_hash *hash,
                       unsigned akey)
 {
-   struct cso_node **node = cso_hash_find_node(hash, akey);
-   if (*node != hash->data.e) {
-      void *t = (*node)->value;
-      struct cso_node *next = (*node)->next;
-      cso_free_node(*node);
-      *node = next;
-      --hash->data.d->size;
-      cso_data_has_shrunk(hash->data.d);
-      return t;
-   }
-   return 0;
+   struct cso_hash_iter iter = cso_hash_find(hash, akey);
+
+   if (iter.slot == InvalidSlot)
+      return 0;
+
+   hash->table[iter.slot].state = CSO_SLOT_DELETED;
+   ++hash->numDeleted;
+   --hash->size;
+   return hash->table[iter.slot].value;
 }
 
 struct cso_hash_iter cso_hash_iter_prev(struct cso_hash_iter iter)
 {
-   struct cso_hash_iter prev = {iter.hash,
-                                 cso_hash_data_prev(iter.node)};
+   struct cso_hash_iter prev = {iter.hash, InvalidSlot};
+   unsigned i = (iter.slot == InvalidSlot) ? iter.hash->maxSlots
+                                           : iter.slot;
+
+   while (i--) {
+      if (iter.hash->table[i].state == CSO_SLOT_FILLED) {
+         prev.slot = i;
+         return prev;
+      }
+   }
+   debug_printf("iterating backward beyond first element\n");
    return prev;
 }
 
 struct cso_hash_iter cso_hash_first_node(struct cso_hash *hash)
 {
-   struct cso_hash_iter iter = {hash, cso_data_first_node(hash->data.d)};
+   struct cso_hash_iter iter = {hash, InvalidSlot};
+   unsigned i;
+
+   for (i = 0; i < hash->maxSlots; ++i) {
+      if (hash->table[i].state == CSO_SLOT_FILLED) {
+         iter.slot = i;
+         break;
+      }
+   }
    return iter;
 }
 
 int cso_hash_size(struct cso_hash *hash)
 {
-   return hash->data.d->size;
+   return hash->size;
 }
 
 struct cso_hash_iter cso_hash_erase(struct cso_hash *hash, struct cso_hash_iter iter)
 {
-   struct cso_hash_iter ret = iter;
-   struct cso_node *node = iter.node;
-   struct cso_node **node_ptr;
+   struct cso_hash_iter ret;
 
-   if (node == hash->data.e)
+   if (iter.slot == InvalidSlot)
       return iter;
 
-   ret = cso_hash_iter_next(ret);
-   node_ptr = (struct cso_node**)(&hash->data.d->buckets[node->key % hash->data.d->numBuckets]);
-   while (*node_ptr != node)
-      node_ptr = &(*node_ptr)->next;
-   *node_ptr = node->next;
-   cso_free_node(node);
-   --hash->data.d->size;
+   ret = cso_hash_iter_next(iter);
+   hash->table[iter.slot].state = CSO_SLOT_DELETED;
+   ++hash->numDeleted;
+   --hash->size;
    return ret;
 }
 
 boolean cso_hash_contains(struct cso_hash *hash, unsigned key)
 {
-   struct cso_node **node = cso_hash_find_node(hash, key);
-   return (*node != hash->data.e);
+   struct cso_hash_iter iter = cso_hash_find(hash, key);
+   return iter.slot != InvalidSlot;
 }
@@ -28,16 +28,16 @@
 /**
  * @file
  * Hash table implementation.
- * 
+ *
  * This file provides a hash implementation that is capable of dealing
- * with collisions. It stores colliding entries in linked list. All
- * functions operating on the hash return an iterator. The iterator
- * itself points to the collision list. If there wasn't any collision
- * the list will have just one entry, otherwise client code should
- * iterate over the entries to find the exact entry among ones that
- * had the same key (e.g. memcmp could be used on the data to check
- * that)
- * 
+ * with collisions.  Entries are stored inline in an open-addressed
+ * table; keys are hashes the caller computed up front.  Colliding
+ * entries with the same key occupy consecutive positions, so all
+ * functions operating on the hash return an iterator pointing to the
+ * first of them and client code should step the iterator while the key
+ * matches to find the exact entry (e.g. memcmp could be used on the
+ * data to check that)
+ *
  * @author Zack Rusin <zackr@vmware.com>
  */
 
@@ -52,12 +52,11 @@ extern "C" {
 
 
 struct cso_hash;
-struct cso_node;
 
 
 struct cso_hash_iter {
    struct cso_hash *hash;
-   struct cso_node  *node;
+   unsigned slot;
 };
 
 
@@ -69,9 +68,9 @@ int              cso_hash_size(struct cso_hash *hash);
 
 
 /**
- * Adds a data with the given key to the hash. If entry with the given
- * key is already in the hash, this current entry is instered before it
- * in the collision list.
+ * Adds a data with the given key to the hash. If entries with the given
+ * key are already in the hash, this entry is inserted right next to
+ * them.
  * Function returns iterator pointing to the inserted item in the hash.
  */
 struct cso_hash_iter cso_hash_insert(struct cso_hash *hash, unsigned key,
@@ -92,7 +91,7 @@ void  *cso_hash_take(struct cso_hash *hash, unsigned key);
 struct cso_hash_iter cso_hash_first_node(struct cso_hash *hash);
 
 /**
- * Return an iterator pointing to the first entry in the collision list.
+ * Return an iterator pointing to the first entry with the given key.
  */
 struct cso_hash_iter cso_hash_find(struct cso_hash *hash, unsigned key);
 
@@ -112,9 +111,9 @@ struct cso_hash_iter cso_hash_iter_prev(struct cso_hash_iter iter);
 
 
 /**
- * Convenience routine to iterate over the collision list while doing a memory
- * comparison to see which entry in the list is a direct copy of our template
- * and returns that entry.
+ * Convenience routine to iterate over the entries with the given key while
+ * doing a memory comparison to see which of them is a direct copy of our
+ * template and returns that entry.
  */
 void *cso_hash_find_data_from_template( struct cso_hash *hash,
 				        unsigned hash_key,
@@ -50,11 +50,14 @@
 
 #include "tgsi/tgsi_exec.h"
 #include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_parse.h"
 
 #include "util/u_math.h"
 #include "util/u_pointer.h"
 #include "util/u_string.h"
+#include "util/u_hash.h"
 #include "util/simple_list.h"
+#include "os/os_thread.h"
 
 
 #define DEBUG_STORE 0
@@ -65,6 +68,83 @@ draw_llvm_generate(struct draw_llvm *llvm, struct draw_llvm_variant *var,
                    boolean elts);
 
 
+/**
+ * Process-wide cache of compiled vertex shader code.
+ *
+ * Different contexts frequently compile identical vertex paths (same
+ * TGSI, same variant key) and each used to hold its own copy of the
+ * generated machine code.  Entries are keyed on the shader tokens
+ * plus the variant key and refcounted, so all contexts share a single
+ * compiled copy.  Each entry owns a private LLVMContext, which makes
+ * its lifetime independent of the context which first compiled it.
+ */
+struct draw_llvm_code
+{
+   unsigned hash;
+   unsigned key_size;         /**< tokens plus variant key, in bytes */
+   int refcount;
+
+   LLVMContextRef context;
+   struct gallivm_state *gallivm;
+   draw_jit_vert_func jit_func;
+   draw_jit_vert_func_elts jit_func_elts;
+
+   struct draw_llvm_code *next;
+
+   /* key is variable-sized, must be last */
+   char key[1];
+};
+
+static struct draw_llvm_code *vs_code_cache = NULL;
+pipe_static_mutex(vs_code_cache_mutex);
+
+
+/**
+ * Look up compiled code in the cache, taking a reference on a hit.
+ * The cache mutex must be held.
+ */
+static struct draw_llvm_code *
+draw_llvm_code_find_locked(unsigned hash, const void *key, unsigned key_size)
+{
+   struct draw_llvm_code *code;
+
+   for (code = vs_code_cache; code; code = code->next) {
+      if (code->hash == hash &&
+          code->key_size == key_size &&
+          memcmp(code->key, key, key_size) == 0) {
+         code->refcount++;
+         return code;
+      }
+   }
+
+   return NULL;
+}
+
+
+/**
+ * Drop a reference to compiled code, freeing it when unused.
+ */
+static void
+draw_llvm_code_release(struct draw_llvm_code *code)
+{
+   pipe_mutex_lock(vs_code_cache_mutex);
+
+   if (--code->refcount == 0) {
+      struct draw_llvm_code **link;
+
+      for (link = &vs_code_cache; *link != code; link = &(*link)->next)
+         ;
+      *link = code->next;
+
+      gallivm_destroy(code->gallivm);
+      LLVMContextDispose(code->context);
+      FREE(code);
+   }
+
+   pipe_mutex_unlock(vs_code_cache_mutex);
+}
+
+
 struct draw_gs_llvm_iface {
    struct lp_build_tgsi_gs_iface base;
 
@@ -545,8 +625,13 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
    struct draw_llvm_variant *variant;
    struct llvm_vertex_shader *shader =
       llvm_vertex_shader(llvm->draw->vs.vertex_shader);
+   const struct tgsi_token *tokens = shader->base.state.tokens;
+   unsigned tokens_size = tgsi_num_tokens(tokens) * sizeof(struct tgsi_token);
+   unsigned code_key_size = tokens_size + shader->variant_key_size;
    LLVMTypeRef vertex_header;
    char module_name[64];
+   char *code_key;
+   unsigned hash;
 
    variant = MALLOC(sizeof *variant +
                     shader->variant_key_size -
@@ -557,36 +642,94 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
    variant->llvm = llvm;
    variant->shader = shader;
 
-   util_snprintf(module_name, sizeof(module_name), "draw_llvm_vs_variant%u",
-                 variant->shader->variants_cached);
-
-   variant->gallivm = gallivm_create(module_name, llvm->context);
+   memcpy(&variant->key, key, shader->variant_key_size);
 
-   create_jit_types(variant);
+   /* The process-wide code cache is keyed on the shader tokens plus
+    * the variant key.
+    */
+   code_key = MALLOC(code_key_size);
+   if (!code_key) {
+      FREE(variant);
+      return NULL;
+   }
+   memcpy(code_key, tokens, tokens_size);
+   memcpy(code_key + tokens_size, key, shader->variant_key_size);
+   hash = util_hash_crc32(code_key, code_key_size);
 
-   memcpy(&variant->key, key, shader->variant_key_size);
+   pipe_mutex_lock(vs_code_cache_mutex);
 
-   if (gallivm_debug & (GALLIVM_DEBUG_TGSI | GALLIVM_DEBUG_IR)) {
-      tgsi_dump(llvm->draw->vs.vertex_shader->state.tokens, 0);
-      draw_llvm_dump_variant_key(&variant->key);
+   variant->code = draw_llvm_code_find_locked(hash, code_key, code_key_size);
+   if (variant->code) {
+      /* Another variant (possibly in another context) already compiled
+       * this shader/key combination - share its machine code.
+       */
+      variant->gallivm = NULL;
+      variant->jit_func = variant->code->jit_func;
+      variant->jit_func_elts = variant->code->jit_func_elts;
    }
+   else {
+      struct draw_llvm_code *code;
+
+      code = MALLOC(sizeof *code + code_key_size - sizeof code->key);
+      if (!code) {
+         pipe_mutex_unlock(vs_code_cache_mutex);
+         FREE(code_key);
+         FREE(variant);
+         return NULL;
+      }
 
-   vertex_header = create_jit_vertex_header(variant->gallivm, num_inputs);
+      code->hash = hash;
+      code->key_size = code_key_size;
+      code->refcount = 1;
+      memcpy(code->key, code_key, code_key_size);
 
-   variant->vertex_header_ptr_type = LLVMPointerType(vertex_header, 0);
+      /* The code gets a context of its own so that it can outlive the
+       * draw context which compiled it.
+       */
+      code->context = LLVMContextCreate();
 
-   draw_llvm_generate(llvm, variant, FALSE);  /* linear */
-   draw_llvm_generate(llvm, variant, TRUE);   /* elts */
+      util_snprintf(module_name, sizeof(module_name), "draw_llvm_vs_variant%u",
+                    variant->shader->variants_cached);
 
-   gallivm_compile_module(variant->gallivm);
+      variant->gallivm = gallivm_create(module_name, code->context);
 
-   variant->jit_func = (draw_jit_vert_func)
-         gallivm_jit_function(variant->gallivm, variant->function);
+      create_jit_types(variant);
 
-   variant->jit_func_elts = (draw_jit_vert_func_elts)
-         gallivm_jit_function(variant->gallivm, variant->function_elts);
+      if (gallivm_debug & (GALLIVM_DEBUG_TGSI | GALLIVM_DEBUG_IR)) {
+         tgsi_dump(tokens, 0);
+         draw_llvm_dump_variant_key(&variant->key);
+      }
 
-   gallivm_free_ir(variant->gallivm);
+      vertex_header = create_jit_vertex_header(variant->gallivm, num_inputs);
+
+      variant->vertex_header_ptr_type = LLVMPointerType(vertex_header, 0);
+
+      draw_llvm_generate(llvm, variant, FALSE);  /* linear */
+      draw_llvm_generate(llvm, variant, TRUE);   /* elts */
+
+      gallivm_compile_module(variant->gallivm);
+
+      variant->jit_func = (draw_jit_vert_func)
+            gallivm_jit_function(variant->gallivm, variant->function);
+
+      variant->jit_func_elts = (draw_jit_vert_func_elts)
+            gallivm_jit_function(variant->gallivm, variant->function_elts);
+
+      gallivm_free_ir(variant->gallivm);
+
+      code->gallivm = variant->gallivm;
+      code->jit_func = variant->jit_func;
+      code->jit_func_elts = variant->jit_func_elts;
+      code->next = vs_code_cache;
+      vs_code_cache = code;
+
+      variant->code = code;
+      variant->gallivm = NULL;
+   }
+
+   pipe_mutex_unlock(vs_code_cache_mutex);
+
+   FREE(code_key);
 
    variant->list_item_global.base = variant;
    variant->list_item_local.base = variant;
@@ -2041,7 +2184,7 @@ draw_llvm_destroy_variant(struct draw_llvm_variant *variant)
 {
    struct draw_llvm *llvm = variant->llvm;
 
-   gallivm_destroy(variant->gallivm);
+   draw_llvm_code_release(variant->code);
 
    remove_from_list(&variant->list_item_local);
    variant->shader->variants_cached--;
@@ -382,10 +382,16 @@ struct draw_gs_llvm_variant_list_item
 };
 
 
+struct draw_llvm_code;
+
 struct draw_llvm_variant
 {
+   /** Only valid while the variant is being generated, NULL afterwards */
    struct gallivm_state *gallivm;
 
+   /** Refcounted machine code, shared between contexts */
+   struct draw_llvm_code *code;
+
    /* LLVM JIT builder types */
    LLVMTypeRef context_ptr_type;
    LLVMTypeRef buffer_ptr_type;
@@ -119,6 +119,46 @@ static void cull_line( struct draw_stage *stage,
    stage->next->line( stage->next, header );
 }
 
+/*
+ * Cull triangles by face orientation only.  This is the common case
+ * and is split out so it doesn't have to query the (empty) cull
+ * distance state for every triangle.
+ */
+static void cull_tri_face( struct draw_stage *stage,
+                           struct prim_header *header )
+{
+   const unsigned pos = draw_current_shader_position_output(stage->draw);
+   /* Window coords: */
+   const float *v0 = header->v[0]->data[pos];
+   const float *v1 = header->v[1]->data[pos];
+   const float *v2 = header->v[2]->data[pos];
+
+   /* edge vectors: e = v0 - v2, f = v1 - v2 */
+   const float ex = v0[0] - v2[0];
+   const float ey = v0[1] - v2[1];
+   const float fx = v1[0] - v2[0];
+   const float fy = v1[1] - v2[1];
+
+
+   /* det = cross(e,f).z */
+   header->det = ex * fy - ey * fx;
+
+   if (header->det != 0) {
+      /* if det < 0 then Z points toward the camera and the triangle is
+       * counter-clockwise winding.
+       */
+      unsigned ccw = (header->det < 0);
+      unsigned face = ((ccw == cull_stage(stage)->front_ccw) ?
+                       PIPE_FACE_FRONT :
+                       PIPE_FACE_BACK);
+
+      if ((face & cull_stage(stage)->cull_face) == 0) {
+         /* triangle is not culled, pass to next stage */
+         stage->next->tri( stage->next, header );
+      }
+   }
+}
+
 /*
  * Triangles can be culled either using the cull distance
  * shader outputs or the regular face culling. If required
@@ -151,38 +191,7 @@ static void cull_tri( struct draw_stage *stage,
    }
 
    /* Do the regular face culling */
-   {
-      const unsigned pos = draw_current_shader_position_output(stage->draw);
-      /* Window coords: */
-      const float *v0 = header->v[0]->data[pos];
-      const float *v1 = header->v[1]->data[pos];
-      const float *v2 = header->v[2]->data[pos];
-
-      /* edge vectors: e = v0 - v2, f = v1 - v2 */
-      const float ex = v0[0] - v2[0];
-      const float ey = v0[1] - v2[1];
-      const float fx = v1[0] - v2[0];
-      const float fy = v1[1] - v2[1];
-
-
-      /* det = cross(e,f).z */
-      header->det = ex * fy - ey * fx;
-
-      if (header->det != 0) {
-         /* if det < 0 then Z points toward the camera and the triangle is
-          * counter-clockwise winding.
-          */
-         unsigned ccw = (header->det < 0);
-         unsigned face = ((ccw == cull_stage(stage)->front_ccw) ?
-                          PIPE_FACE_FRONT :
-                          PIPE_FACE_BACK);
-
-         if ((face & cull_stage(stage)->cull_face) == 0) {
-            /* triangle is not culled, pass to next stage */
-            stage->next->tri( stage->next, header );
-         }
-      }
-   }
+   cull_tri_face( stage, header );
 }
 
 static void cull_first_point( struct draw_stage *stage,
@@ -223,7 +232,10 @@ static void cull_first_tri( struct draw_stage *stage,
    cull->cull_face = stage->draw->rasterizer->cull_face;
    cull->front_ccw = stage->draw->rasterizer->front_ccw;
 
-   stage->tri = cull_tri;
+   if (draw_current_shader_num_written_culldistances(stage->draw))
+      stage->tri = cull_tri;
+   else
+      stage->tri = cull_tri_face;
    stage->tri( stage, header );
 }
 
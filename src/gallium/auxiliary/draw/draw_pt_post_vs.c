@@ -34,6 +34,10 @@
 #include "draw/draw_pt.h"
 #include "draw/draw_vs.h"
 
+#if defined(PIPE_ARCH_SSE)
+#include <emmintrin.h>
+#endif
+
 #define DO_CLIP_XY           0x1
 #define DO_CLIP_FULL_Z       0x2
 #define DO_CLIP_HALF_Z       0x4
@@ -115,6 +119,173 @@ dot4(const float *a, const float *b)
 #include "draw_cliptest_tmp.h"
 
 
+#if defined(PIPE_ARCH_SSE)
+
+/* SSE version of the most common flag combination, testing four vertices
+ * against all six frustum planes at a time.  Positions are gathered from
+ * the strided vertex headers and transposed to one register per
+ * component; cmpnge is true for NaNs, matching the scalar !(a >= 0)
+ * tests.  Batches of most scenes are either trivially accepted or
+ * trivially rejected here without ever entering the scalar loop.
+ */
+static boolean
+do_cliptest_xy_fullz_viewport_sse( struct pt_post_vs *pvs,
+                                   struct draw_vertex_info *info,
+                                   const struct draw_prim_info *prim_info )
+{
+   struct vertex_header *out = info->verts;
+   const unsigned pos = draw_current_shader_position_output(pvs->draw);
+   const float *scale = pvs->draw->viewports[0].scale;
+   const float *trans = pvs->draw->viewports[0].translate;
+   const __m128 zero = _mm_setzero_ps();
+   unsigned need_pipeline = 0;
+   unsigned j;
+
+   /* The vectorized loop assumes one viewport for the whole batch. */
+   if (draw_current_shader_uses_viewport_index(pvs->draw))
+      return do_cliptest_xy_fullz_viewport(pvs, info, prim_info);
+
+   for (j = 0; j + 4 <= info->count; j += 4) {
+      struct vertex_header *v[4];
+      __m128 q0, q1, q2, q3, x, y, z, w;
+      unsigned m0, m1, m2, m3, m4, m5, mask[4];
+      unsigned k;
+
+      for (k = 0; k < 4; k++) {
+         v[k] = (struct vertex_header *)((char *)out + k * info->stride);
+         initialize_vertex_header(v[k]);
+      }
+
+      q0 = _mm_loadu_ps(v[0]->data[pos]);
+      q1 = _mm_loadu_ps(v[1]->data[pos]);
+      q2 = _mm_loadu_ps(v[2]->data[pos]);
+      q3 = _mm_loadu_ps(v[3]->data[pos]);
+
+      /* save the clip space position before the viewport transform */
+      _mm_storeu_ps(v[0]->clip_pos, q0);
+      _mm_storeu_ps(v[1]->clip_pos, q1);
+      _mm_storeu_ps(v[2]->clip_pos, q2);
+      _mm_storeu_ps(v[3]->clip_pos, q3);
+
+      {
+         __m128 t0 = _mm_unpacklo_ps(q0, q1);   /* x0 x1 y0 y1 */
+         __m128 t1 = _mm_unpacklo_ps(q2, q3);   /* x2 x3 y2 y3 */
+         __m128 t2 = _mm_unpackhi_ps(q0, q1);   /* z0 z1 w0 w1 */
+         __m128 t3 = _mm_unpackhi_ps(q2, q3);   /* z2 z3 w2 w3 */
+         x = _mm_movelh_ps(t0, t1);
+         y = _mm_movehl_ps(t1, t0);
+         z = _mm_movelh_ps(t2, t3);
+         w = _mm_movehl_ps(t3, t2);
+      }
+
+      m0 = _mm_movemask_ps(_mm_cmpnge_ps(_mm_sub_ps(w, x), zero));
+      m1 = _mm_movemask_ps(_mm_cmpnge_ps(_mm_add_ps(x, w), zero));
+      m2 = _mm_movemask_ps(_mm_cmpnge_ps(_mm_sub_ps(w, y), zero));
+      m3 = _mm_movemask_ps(_mm_cmpnge_ps(_mm_add_ps(y, w), zero));
+      m4 = _mm_movemask_ps(_mm_cmpnge_ps(_mm_add_ps(z, w), zero));
+      m5 = _mm_movemask_ps(_mm_cmpnge_ps(_mm_sub_ps(w, z), zero));
+
+      for (k = 0; k < 4; k++) {
+         mask[k] = (((m0 >> k) & 1) << 0) |
+                   (((m1 >> k) & 1) << 1) |
+                   (((m2 >> k) & 1) << 2) |
+                   (((m3 >> k) & 1) << 3) |
+                   (((m4 >> k) & 1) << 4) |
+                   (((m5 >> k) & 1) << 5);
+         v[k]->clipmask = mask[k];
+         need_pipeline |= mask[k];
+      }
+
+      /* Viewport transform of the unclipped vertices.
+       */
+      {
+         PIPE_ALIGN_VAR(16) float rx[4], ry[4], rz[4], rw[4];
+         __m128 wr = _mm_div_ps(_mm_set1_ps(1.0f), w);
+
+         _mm_store_ps(rx, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(x, wr),
+                                                _mm_set1_ps(scale[0])),
+                                     _mm_set1_ps(trans[0])));
+         _mm_store_ps(ry, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, wr),
+                                                _mm_set1_ps(scale[1])),
+                                     _mm_set1_ps(trans[1])));
+         _mm_store_ps(rz, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(z, wr),
+                                                _mm_set1_ps(scale[2])),
+                                     _mm_set1_ps(trans[2])));
+         _mm_store_ps(rw, wr);
+
+         for (k = 0; k < 4; k++) {
+            float *position = v[k]->data[pos];
+
+            if (mask[k] == 0) {
+               position[0] = rx[k];
+               position[1] = ry[k];
+               position[2] = rz[k];
+               position[3] = rw[k];
+            }
+#ifdef DEBUG
+            else {
+               float zf = 0.0f;
+               position[0] =
+               position[1] =
+               position[2] =
+               position[3] = zf / zf; /* MSVC doesn't accept 0.0 / 0.0 */
+            }
+#endif
+         }
+      }
+
+      out = (struct vertex_header *)((char *)out + 4 * info->stride);
+   }
+
+   /* Tail of the batch, same tests as the scalar template.
+    */
+   for (; j < info->count; j++) {
+      float *position = out->data[pos];
+      unsigned mask = 0x0;
+      unsigned i;
+
+      initialize_vertex_header(out);
+
+      for (i = 0; i < 4; i++) {
+         out->clip_pos[i] = position[i];
+      }
+
+      if (!(-position[0] + position[3] >= 0)) mask |= (1<<0);
+      if (!( position[0] + position[3] >= 0)) mask |= (1<<1);
+      if (!(-position[1] + position[3] >= 0)) mask |= (1<<2);
+      if (!( position[1] + position[3] >= 0)) mask |= (1<<3);
+      if (!( position[2] + position[3] >= 0)) mask |= (1<<4);
+      if (!(-position[2] + position[3] >= 0)) mask |= (1<<5);
+
+      out->clipmask = mask;
+      need_pipeline |= mask;
+
+      if (mask == 0) {
+         float w = 1.0f / position[3];
+
+         position[0] = position[0] * w * scale[0] + trans[0];
+         position[1] = position[1] * w * scale[1] + trans[1];
+         position[2] = position[2] * w * scale[2] + trans[2];
+         position[3] = w;
+      }
+#ifdef DEBUG
+      else {
+         float zf = 0.0f;
+         position[0] =
+         position[1] =
+         position[2] =
+         position[3] = zf / zf; /* MSVC doesn't accept 0.0 / 0.0 */
+      }
+#endif
+
+      out = (struct vertex_header *)((char *)out + info->stride);
+   }
+
+   return need_pipeline != 0;
+}
+
+#endif /* PIPE_ARCH_SSE */
+
 
 boolean draw_pt_post_vs_run( struct pt_post_vs *pvs,
                              struct draw_vertex_info *info,
@@ -182,7 +353,11 @@ void draw_pt_post_vs_prepare( struct pt_post_vs *pvs,
       break;
 
    case DO_CLIP_XY | DO_CLIP_FULL_Z | DO_VIEWPORT:
+#if defined(PIPE_ARCH_SSE)
+      pvs->run = do_cliptest_xy_fullz_viewport_sse;
+#else
       pvs->run = do_cliptest_xy_fullz_viewport;
+#endif
       break;
 
    case DO_CLIP_XY | DO_CLIP_HALF_Z | DO_VIEWPORT:
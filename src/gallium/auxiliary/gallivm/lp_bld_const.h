@@ -141,6 +141,11 @@ lp_build_const_int_pointer(struct gallivm_state *gallivm, const void *ptr)
    LLVMTypeRef int_type;
    LLVMValueRef v;
 
+   /* The pointer is only meaningful within this process, so the emitted
+    * machine code must not be reused by a later run from the disk cache.
+    */
+   gallivm->cache_unsafe = TRUE;
+
    /* int type large enough to hold a pointer */
    int_type = LLVMIntTypeInContext(gallivm->context, 8 * sizeof(void *));
    v = LLVMConstInt(int_type, (uintptr_t) ptr, 0);
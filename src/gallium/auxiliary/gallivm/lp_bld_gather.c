@@ -27,6 +27,7 @@
 
 
 #include "util/u_debug.h"
+#include "util/u_cpu_detect.h"
 #include "lp_bld_debug.h"
 #include "lp_bld_const.h"
 #include "lp_bld_format.h"
@@ -170,6 +171,34 @@ lp_build_gather(struct gallivm_state *gallivm,
       return lp_build_gather_elem(gallivm, length,
                                   src_width, dst_width, aligned,
                                   base_ptr, offsets, 0, vector_justify);
+   } else if (util_cpu_caps.has_avx2 &&
+              src_width == 32 && dst_width == 32 &&
+              (length == 4 || length == 8)) {
+      /*
+       * Use a hardware gather instead of extracting the offsets and
+       * doing one scalar load per element.  The offsets are signed
+       * byte offsets, which matches the gather index operand with a
+       * scale of one.  With equal src and dst width there is no
+       * justification to do either.
+       */
+      LLVMTypeRef i8t = LLVMInt8TypeInContext(gallivm->context);
+      LLVMTypeRef dst_elem_type = LLVMIntTypeInContext(gallivm->context, dst_width);
+      LLVMTypeRef dst_vec_type = LLVMVectorType(dst_elem_type, length);
+      const char *intrinsic = length == 8 ? "llvm.x86.avx2.gather.d.d.256"
+                                          : "llvm.x86.avx2.gather.d.d";
+      LLVMValueRef args[5];
+
+      assert(LLVMTypeOf(base_ptr) ==
+             LLVMPointerType(LLVMInt8TypeInContext(gallivm->context), 0));
+
+      args[0] = LLVMConstNull(dst_vec_type);
+      args[1] = base_ptr;
+      args[2] = offsets;
+      args[3] = LLVMConstAllOnes(dst_vec_type);
+      args[4] = LLVMConstInt(i8t, 1, 0);
+
+      return lp_build_intrinsic(gallivm->builder, intrinsic, dst_vec_type,
+                                args, ARRAY_SIZE(args), 0);
    } else {
       /* Vector */
 
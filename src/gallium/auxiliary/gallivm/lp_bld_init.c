@@ -189,6 +189,7 @@ gallivm_free_ir(struct gallivm_state *gallivm)
    }
 
    FREE(gallivm->module_name);
+   FREE(gallivm->cache_file);
 
    if (!USE_MCJIT) {
       /* Don't free the TargetData, it's owned by the exec engine */
@@ -207,6 +208,7 @@ gallivm_free_ir(struct gallivm_state *gallivm)
    gallivm->target = NULL;
    gallivm->module = NULL;
    gallivm->module_name = NULL;
+   gallivm->cache_file = NULL;
    gallivm->passmgr = NULL;
    gallivm->context = NULL;
    gallivm->builder = NULL;
@@ -249,6 +251,8 @@ init_gallivm_engine(struct gallivm_state *gallivm)
                                                     gallivm->memorymgr,
                                                     (unsigned) optlevel,
                                                     USE_MCJIT,
+                                                    gallivm->cache_unsafe ?
+                                                       NULL : gallivm->cache_file,
                                                     &error);
       if (ret) {
          _debug_printf("%s\n", error);
@@ -454,6 +458,10 @@ lp_build_init(void)
       util_cpu_caps.has_avx = 0;
       util_cpu_caps.has_avx2 = 0;
       util_cpu_caps.has_f16c = 0;
+      util_cpu_caps.has_avx512f = 0;
+      util_cpu_caps.has_avx512dq = 0;
+      util_cpu_caps.has_avx512bw = 0;
+      util_cpu_caps.has_avx512vl = 0;
    }
 
 #ifdef PIPE_ARCH_PPC_64
@@ -517,6 +525,34 @@ gallivm_destroy(struct gallivm_state *gallivm)
 }
 
 
+/**
+ * Ask for the compiled machine code to be cached in the given file.
+ *
+ * Must be called before gallivm_compile_module().  When the file already
+ * holds the object emitted by an earlier run, the JIT engine binds it
+ * instead of running the code generator on the module.  The request is
+ * ignored if the module turns out to embed raw host pointers (see
+ * lp_build_const_int_pointer()), since those are only valid within the
+ * current process.
+ */
+void
+gallivm_set_cache_file(struct gallivm_state *gallivm, const char *cache_file)
+{
+   assert(!gallivm->compiled);
+
+   FREE(gallivm->cache_file);
+   gallivm->cache_file = NULL;
+
+   if (cache_file) {
+      size_t size = strlen(cache_file) + 1;
+      gallivm->cache_file = MALLOC(size);
+      if (gallivm->cache_file) {
+         memcpy(gallivm->cache_file, cache_file, size);
+      }
+   }
+}
+
+
 /**
  * Validate a function.
  * Verification is only done with debug builds.
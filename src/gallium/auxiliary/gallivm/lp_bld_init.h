@@ -42,6 +42,8 @@ extern "C" {
 struct gallivm_state
 {
    char *module_name;
+   char *cache_file;
+   boolean cache_unsafe;
    LLVMModuleRef module;
    LLVMExecutionEngineRef engine;
    LLVMTargetDataRef target;
@@ -67,6 +69,9 @@ gallivm_destroy(struct gallivm_state *gallivm);
 void
 gallivm_free_ir(struct gallivm_state *gallivm);
 
+void
+gallivm_set_cache_file(struct gallivm_state *gallivm, const char *cache_file);
+
 void
 gallivm_verify_function(struct gallivm_state *gallivm,
                         LLVMValueRef func);
@@ -70,6 +70,10 @@
 #include <llvm/ExecutionEngine/JITMemoryManager.h>
 #else
 #include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
 #endif
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Host.h>
@@ -389,12 +393,24 @@ class ShaderMemoryManager : public DelegatingJITMemoryManager {
       typedef std::vector<void *> Vec;
       Vec FunctionBody, ExceptionTable;
       BaseMemoryManager *TheMM;
+#if HAVE_LLVM >= 0x0306
+      /* The object cache the engine was created with, if any.  It must
+       * outlive the engine, so it is deleted together with the code.
+       */
+      llvm::ObjectCache *Cache;
+#endif
 
       GeneratedCode(BaseMemoryManager *MM) {
          TheMM = MM;
+#if HAVE_LLVM >= 0x0306
+         Cache = NULL;
+#endif
       }
 
       ~GeneratedCode() {
+#if HAVE_LLVM >= 0x0306
+         delete Cache;
+#endif
          /*
           * Deallocate things as previously requested and
           * free shared manager when no longer used.
@@ -441,6 +457,13 @@ class ShaderMemoryManager : public DelegatingJITMemoryManager {
          delete (GeneratedCode *) code;
       }
 
+#if HAVE_LLVM >= 0x0306
+      static void setObjectCache(struct lp_generated_code *code,
+                                 llvm::ObjectCache *cache) {
+         ((GeneratedCode *) code)->Cache = cache;
+      }
+#endif
+
 #if HAVE_LLVM < 0x0304
       virtual void deallocateExceptionTable(void *ET) {
          // remember for later deallocation
@@ -455,6 +478,54 @@ class ShaderMemoryManager : public DelegatingJITMemoryManager {
 };
 
 
+#if HAVE_LLVM >= 0x0306
+
+/**
+ * File-backed object cache for MCJIT.
+ *
+ * When the cache file already holds the object emitted by an earlier run,
+ * the engine loads and relocates it instead of running the code generator;
+ * otherwise the freshly emitted object is written out for the next run.
+ * Writes go through a temporary file and rename so that concurrent
+ * processes never observe a partial object.
+ */
+class ShaderObjectCache : public llvm::ObjectCache {
+
+   std::string CacheFile;
+
+   public:
+
+      ShaderObjectCache(const char *cache_file) : CacheFile(cache_file) {
+      }
+
+      virtual void notifyObjectCompiled(const llvm::Module *M,
+                                        llvm::MemoryBufferRef Obj) {
+         std::string TmpFile = CacheFile + ".tmp";
+         std::error_code EC;
+
+         llvm::raw_fd_ostream OS(TmpFile, EC, llvm::sys::fs::F_None);
+         if (EC)
+            return;
+         OS.write(Obj.getBufferStart(), Obj.getBufferSize());
+         OS.close();
+
+         if (OS.has_error() || llvm::sys::fs::rename(TmpFile, CacheFile))
+            llvm::sys::fs::remove(TmpFile);
+      }
+
+      virtual std::unique_ptr<llvm::MemoryBuffer>
+      getObject(const llvm::Module *M) {
+         llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+            llvm::MemoryBuffer::getFile(CacheFile, -1, false);
+         if (!Buffer)
+            return NULL;
+         return std::move(*Buffer);
+      }
+};
+
+#endif /* HAVE_LLVM >= 0x0306 */
+
+
 /**
  * Same as LLVMCreateJITCompilerForModule, but:
  * - allows using MCJIT and enabling AVX feature where available.
@@ -473,6 +544,7 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
                                         LLVMMCJITMemoryManagerRef CMM,
                                         unsigned OptLevel,
                                         int useMCJIT,
+                                        const char *CacheFile,
                                         char **OutError)
 {
    using namespace llvm;
@@ -571,6 +643,21 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
    MAttrs.push_back(util_cpu_caps.has_avx  ? "+avx"  : "-avx");
    MAttrs.push_back(util_cpu_caps.has_f16c ? "+f16c" : "-f16c");
    MAttrs.push_back(util_cpu_caps.has_avx2 ? "+avx2" : "-avx2");
+#if HAVE_LLVM >= 0x0309
+   /*
+    * AVX-512 codegen is only trustworthy on newer llvm versions.  The IR we
+    * build still uses at most 256-bit wide vectors, but with these
+    * attributes the code generator is free to use EVEX encodings, the
+    * additional registers and 512-bit operations when legalizing.
+    */
+   MAttrs.push_back(util_cpu_caps.has_avx512f  ? "+avx512f"  : "-avx512f" );
+   MAttrs.push_back(util_cpu_caps.has_avx512dq ? "+avx512dq" : "-avx512dq");
+   MAttrs.push_back(util_cpu_caps.has_avx512bw ? "+avx512bw" : "-avx512bw");
+   MAttrs.push_back(util_cpu_caps.has_avx512vl ? "+avx512vl" : "-avx512vl");
+   MAttrs.push_back("-avx512cd");
+   MAttrs.push_back("-avx512er");
+   MAttrs.push_back("-avx512pf");
+#else
    /* disable avx512 and all subvariants */
 #if HAVE_LLVM >= 0x0304
    MAttrs.push_back("-avx512cd");
@@ -584,6 +671,7 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
    MAttrs.push_back("-avx512vl");
 #endif
 #endif
+#endif
 
 #if defined(PIPE_ARCH_PPC)
    MAttrs.push_back(util_cpu_caps.has_altivec ? "+altivec" : "-altivec");
@@ -651,6 +739,13 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
    JIT->RegisterJITEventListener(JEL);
 #endif
    if (JIT) {
+#if HAVE_LLVM >= 0x0306
+      if (useMCJIT && CacheFile) {
+         ShaderObjectCache *Cache = new ShaderObjectCache(CacheFile);
+         JIT->setObjectCache(Cache);
+         ShaderMemoryManager::setObjectCache(*OutCode, Cache);
+      }
+#endif
       *OutJIT = wrap(JIT);
       return 0;
    }
@@ -41,6 +41,8 @@
 #include "hud/font.h"
 
 #include "cso_cache/cso_context.h"
+#include "os/os_thread.h"
+#include "os/os_time.h"
 #include "util/u_draw_quad.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
@@ -55,6 +57,97 @@
 /* Control the visibility of all HUD contexts */
 static boolean huds_visible = TRUE;
 
+/* Binary dump of all graph values, enabled with GALLIUM_HUD_DUMP_FILE.
+ * The file starts with a hud_dump_header, followed by fixed size
+ * hud_dump_records. A name record announcing a new graph id is immediately
+ * followed by the zero-padded graph name (HUD_DUMP_NAME_LENGTH bytes).
+ * All graphs of all HUD contexts of the process share one file.
+ */
+#define HUD_DUMP_MAGIC 0x44554847 /* "GHUD" */
+#define HUD_DUMP_VERSION 1
+#define HUD_DUMP_NAME_LENGTH 128
+
+#define HUD_DUMP_RECORD_NAME  1
+#define HUD_DUMP_RECORD_VALUE 2
+
+struct hud_dump_header {
+   uint32_t magic;
+   uint32_t version;
+};
+
+struct hud_dump_record {
+   uint32_t type;      /* HUD_DUMP_RECORD_* */
+   uint32_t id;        /* the graph the record belongs to */
+   uint64_t timestamp; /* os_time_get(), in microseconds */
+   uint64_t value;     /* current counter value, 0 for name records */
+};
+
+static FILE *hud_dump_file;
+static uint32_t hud_num_dump_graphs;
+pipe_static_mutex(hud_dump_mutex);
+
+static void
+hud_dump_open(void)
+{
+   const char *filename = debug_get_option("GALLIUM_HUD_DUMP_FILE", NULL);
+   struct hud_dump_header header;
+
+   pipe_mutex_lock(hud_dump_mutex);
+   if (hud_dump_file || !filename || !*filename) {
+      pipe_mutex_unlock(hud_dump_mutex);
+      return;
+   }
+
+   hud_dump_file = fopen(filename, "wb");
+   if (!hud_dump_file) {
+      fprintf(stderr, "gallium_hud: can't open dump file '%s'\n", filename);
+      pipe_mutex_unlock(hud_dump_mutex);
+      return;
+   }
+
+   header.magic = HUD_DUMP_MAGIC;
+   header.version = HUD_DUMP_VERSION;
+   fwrite(&header, sizeof(header), 1, hud_dump_file);
+   pipe_mutex_unlock(hud_dump_mutex);
+}
+
+static void
+hud_dump_register_graph(struct hud_graph *gr)
+{
+   char name[HUD_DUMP_NAME_LENGTH];
+   struct hud_dump_record record;
+
+   if (!hud_dump_file)
+      return;
+
+   pipe_mutex_lock(hud_dump_mutex);
+   record.type = HUD_DUMP_RECORD_NAME;
+   record.id = gr->dump_id = hud_num_dump_graphs++;
+   record.timestamp = os_time_get();
+   record.value = 0;
+   fwrite(&record, sizeof(record), 1, hud_dump_file);
+
+   memset(name, 0, sizeof(name));
+   strncpy(name, gr->name, sizeof(name) - 1);
+   fwrite(name, sizeof(name), 1, hud_dump_file);
+   pipe_mutex_unlock(hud_dump_mutex);
+}
+
+static void
+hud_dump_value(struct hud_graph *gr, uint64_t value)
+{
+   struct hud_dump_record record;
+
+   record.type = HUD_DUMP_RECORD_VALUE;
+   record.id = gr->dump_id;
+   record.timestamp = os_time_get();
+   record.value = value;
+
+   pipe_mutex_lock(hud_dump_mutex);
+   fwrite(&record, sizeof(record), 1, hud_dump_file);
+   pipe_mutex_unlock(hud_dump_mutex);
+}
+
 struct hud_context {
    struct pipe_context *pipe;
    struct cso_context *cso;
@@ -699,11 +792,16 @@ hud_pane_add_graph(struct hud_pane *pane, struct hud_graph *gr)
    gr->pane = pane;
    LIST_ADDTAIL(&gr->head, &pane->graph_list);
    pane->num_graphs++;
+
+   hud_dump_register_graph(gr);
 }
 
 void
 hud_graph_add_value(struct hud_graph *gr, uint64_t value)
 {
+   if (hud_dump_file)
+      hud_dump_value(gr, value);
+
    gr->current_value = value;
    value = value > gr->pane->ceiling ? gr->pane->ceiling : value;
 
@@ -1153,6 +1251,8 @@ hud_create(struct pipe_context *pipe, struct cso_context *cso)
       return NULL;
    }
 
+   hud_dump_open();
+
    hud = CALLOC_STRUCT(hud_context);
    if (!hud)
       return NULL;
@@ -1322,6 +1422,9 @@ hud_destroy(struct hud_context *hud)
       FREE(pane);
    }
 
+   if (hud_dump_file)
+      fflush(hud_dump_file);
+
    hud_batch_query_cleanup(&hud->batch_query);
    pipe->delete_fs_state(pipe, hud->fs_color);
    pipe->delete_fs_state(pipe, hud->fs_text);
@@ -48,6 +48,7 @@ struct hud_graph {
    unsigned num_vertices;
    unsigned index; /* vertex index being updated */
    uint64_t current_value;
+   uint32_t dump_id; /* id in the GALLIUM_HUD_DUMP_FILE stream */
 };
 
 struct hud_pane {
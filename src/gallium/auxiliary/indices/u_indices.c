@@ -44,7 +44,213 @@ static void translate_memcpy_uint( const void *in,
 {
    memcpy(out, &((int *)in)[start], out_nr*sizeof(int));
 }
-                              
+
+
+#if defined(PIPE_ARCH_SSE)
+
+#include <emmintrin.h>
+
+/*
+ * SSE2 replacements for the hottest of the generated translation
+ * loops.  These are substituted by u_index_translator() when the
+ * provoking vertex convention doesn't change and primitive restart
+ * is disabled, in which case the output is a fixed rearrangement of
+ * the input and the per-index scalar loops can use wide loads and
+ * stores instead.
+ */
+
+/**
+ * Widen ubyte indices to ushort, 16 indices per iteration.
+ * Point/line/triangle lists all reduce to an elementwise copy over
+ * [start, start + out_nr) when the provoking vertex doesn't change,
+ * so one function covers the three list primitives.
+ */
+static void translate_elts_ubyte2ushort_sse( const void *_in,
+                                             unsigned start,
+                                             unsigned in_nr,
+                                             unsigned out_nr,
+                                             unsigned restart_index,
+                                             void *_out )
+{
+   const ubyte *in = (const ubyte*)_in;
+   ushort *out = (ushort*)_out;
+   const __m128i zero = _mm_setzero_si128();
+   const unsigned end = out_nr + start;
+   unsigned i;
+
+   for (i = start; i + 16 <= end; i += 16) {
+      __m128i b = _mm_loadu_si128((const __m128i *)&in[i]);
+      _mm_storeu_si128((__m128i *)&out[i], _mm_unpacklo_epi8(b, zero));
+      _mm_storeu_si128((__m128i *)&out[i + 8], _mm_unpackhi_epi8(b, zero));
+   }
+   for (; i < end; i++)
+      out[i] = in[i];
+}
+
+
+/**
+ * Triangle strip to triangle list, ushort indices, first provoking
+ * vertex.  Two triangles (one even/odd pair of strip positions) per
+ * iteration; a single 8-byte load of in[i..i+3] feeds both.  The
+ * winding fixup (i, i+1+(i&1), i+2-(i&1)) depends on the parity of i,
+ * so one triangle is peeled off when start is odd.
+ */
+static void translate_tristrip_ushort_first_sse( const void *_in,
+                                                 unsigned start,
+                                                 unsigned in_nr,
+                                                 unsigned out_nr,
+                                                 unsigned restart_index,
+                                                 void *_out )
+{
+   const ushort *in = (const ushort*)_in;
+   ushort *out = (ushort*)_out;
+   unsigned i = start, j = 0;
+
+   if ((i & 1) && j + 3 <= out_nr) {
+      out[j + 0] = in[i];
+      out[j + 1] = in[i + 2];
+      out[j + 2] = in[i + 1];
+      j += 3;
+      i++;
+   }
+
+   for (; j + 6 <= out_nr; j += 6, i += 2) {
+      /* in[i..i+3] -> { i, i+1, i+2,  i+1, i+3, i+2 } */
+      __m128i v = _mm_loadl_epi64((const __m128i *)&in[i]);
+      _mm_storel_epi64((__m128i *)&out[j],
+                       _mm_shufflelo_epi16(v, _MM_SHUFFLE(1, 2, 1, 0)));
+      out[j + 4] = (ushort) _mm_extract_epi16(v, 3);
+      out[j + 5] = (ushort) _mm_extract_epi16(v, 2);
+   }
+
+   for (; j < out_nr; j += 3, i++) {
+      out[j + 0] = in[i];
+      out[j + 1] = in[i + 1 + (i & 1)];
+      out[j + 2] = in[i + 2 - (i & 1)];
+   }
+}
+
+
+/**
+ * As above but for the last provoking vertex convention, where the
+ * fixup is (i+(i&1), i+1-(i&1), i+2).
+ */
+static void translate_tristrip_ushort_last_sse( const void *_in,
+                                                unsigned start,
+                                                unsigned in_nr,
+                                                unsigned out_nr,
+                                                unsigned restart_index,
+                                                void *_out )
+{
+   const ushort *in = (const ushort*)_in;
+   ushort *out = (ushort*)_out;
+   unsigned i = start, j = 0;
+
+   if ((i & 1) && j + 3 <= out_nr) {
+      out[j + 0] = in[i + 1];
+      out[j + 1] = in[i];
+      out[j + 2] = in[i + 2];
+      j += 3;
+      i++;
+   }
+
+   for (; j + 6 <= out_nr; j += 6, i += 2) {
+      /* in[i..i+3] -> { i, i+1, i+2,  i+2, i+1, i+3 } */
+      __m128i v = _mm_loadl_epi64((const __m128i *)&in[i]);
+      _mm_storel_epi64((__m128i *)&out[j],
+                       _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 2, 1, 0)));
+      out[j + 4] = (ushort) _mm_extract_epi16(v, 1);
+      out[j + 5] = (ushort) _mm_extract_epi16(v, 3);
+   }
+
+   for (; j < out_nr; j += 3, i++) {
+      out[j + 0] = in[i + (i & 1)];
+      out[j + 1] = in[i + 1 - (i & 1)];
+      out[j + 2] = in[i + 2];
+   }
+}
+
+
+/**
+ * Triangle strip to triangle list, uint indices, first provoking
+ * vertex.  Same structure as the ushort version with 32-bit lanes.
+ */
+static void translate_tristrip_uint_first_sse( const void *_in,
+                                               unsigned start,
+                                               unsigned in_nr,
+                                               unsigned out_nr,
+                                               unsigned restart_index,
+                                               void *_out )
+{
+   const uint *in = (const uint*)_in;
+   uint *out = (uint*)_out;
+   unsigned i = start, j = 0;
+
+   if ((i & 1) && j + 3 <= out_nr) {
+      out[j + 0] = in[i];
+      out[j + 1] = in[i + 2];
+      out[j + 2] = in[i + 1];
+      j += 3;
+      i++;
+   }
+
+   for (; j + 6 <= out_nr; j += 6, i += 2) {
+      /* in[i..i+3] -> { i, i+1, i+2,  i+1, i+3, i+2 } */
+      __m128i v = _mm_loadu_si128((const __m128i *)&in[i]);
+      _mm_storeu_si128((__m128i *)&out[j],
+                       _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 2, 1, 0)));
+      _mm_storel_epi64((__m128i *)&out[j + 4],
+                       _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 0, 2, 3)));
+   }
+
+   for (; j < out_nr; j += 3, i++) {
+      out[j + 0] = in[i];
+      out[j + 1] = in[i + 1 + (i & 1)];
+      out[j + 2] = in[i + 2 - (i & 1)];
+   }
+}
+
+
+/**
+ * As above but for the last provoking vertex convention.
+ */
+static void translate_tristrip_uint_last_sse( const void *_in,
+                                              unsigned start,
+                                              unsigned in_nr,
+                                              unsigned out_nr,
+                                              unsigned restart_index,
+                                              void *_out )
+{
+   const uint *in = (const uint*)_in;
+   uint *out = (uint*)_out;
+   unsigned i = start, j = 0;
+
+   if ((i & 1) && j + 3 <= out_nr) {
+      out[j + 0] = in[i + 1];
+      out[j + 1] = in[i];
+      out[j + 2] = in[i + 2];
+      j += 3;
+      i++;
+   }
+
+   for (; j + 6 <= out_nr; j += 6, i += 2) {
+      /* in[i..i+3] -> { i, i+1, i+2,  i+2, i+1, i+3 } */
+      __m128i v = _mm_loadu_si128((const __m128i *)&in[i]);
+      _mm_storeu_si128((__m128i *)&out[j],
+                       _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 1, 0)));
+      _mm_storel_epi64((__m128i *)&out[j + 4],
+                       _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 0, 3, 1)));
+   }
+
+   for (; j < out_nr; j += 3, i++) {
+      out[j + 0] = in[i + (i & 1)];
+      out[j + 1] = in[i + 1 - (i & 1)];
+      out[j + 2] = in[i + 2];
+   }
+}
+
+#endif /* PIPE_ARCH_SSE */
+
 
 /**
  * Translate indexes when a driver can't support certain types
@@ -179,6 +385,38 @@ u_index_translator(unsigned hw_mask,
          *out_nr = nr;
          return U_TRANSLATE_ERROR;
       }
+
+#if defined(PIPE_ARCH_SSE)
+      /* Substitute SSE2 versions of the hottest translations.  These
+       * only exist for the cases where the output is a fixed
+       * rearrangement of the input: same provoking vertex on both
+       * sides and no primitive restart.
+       */
+      if (in_pv == out_pv && prim_restart == PR_DISABLE) {
+         switch (prim) {
+         case PIPE_PRIM_POINTS:
+         case PIPE_PRIM_LINES:
+         case PIPE_PRIM_TRIANGLES:
+            if (in_idx == IN_UBYTE && out_idx == OUT_USHORT)
+               *out_translate = translate_elts_ubyte2ushort_sse;
+            break;
+         case PIPE_PRIM_TRIANGLE_STRIP:
+            if (in_idx == IN_USHORT && out_idx == OUT_USHORT) {
+               *out_translate = (in_pv == PV_FIRST ?
+                                 translate_tristrip_ushort_first_sse :
+                                 translate_tristrip_ushort_last_sse);
+            }
+            else if (in_idx == IN_UINT && out_idx == OUT_UINT) {
+               *out_translate = (in_pv == PV_FIRST ?
+                                 translate_tristrip_uint_first_sse :
+                                 translate_tristrip_uint_last_sse);
+            }
+            break;
+         default:
+            break;
+         }
+      }
+#endif
    }
 
    return ret;
@@ -0,0 +1,132 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#include "pipe/p_defines.h"
+#include "os/os_timeline.h"
+
+void
+os_timeline_init(struct os_timeline *tl)
+{
+   memset(tl, 0, sizeof(*tl));
+   pipe_mutex_init(tl->mutex);
+   pipe_condvar_init(tl->signalled);
+}
+
+void
+os_timeline_destroy(struct os_timeline *tl)
+{
+   pipe_mutex_destroy(tl->mutex);
+   pipe_condvar_destroy(tl->signalled);
+}
+
+uint64_t
+os_timeline_get_point(struct os_timeline *tl)
+{
+   uint64_t point;
+
+   pipe_mutex_lock(tl->mutex);
+   point = ++tl->next_point;
+   pipe_mutex_unlock(tl->mutex);
+
+   return point;
+}
+
+void
+os_timeline_signal(struct os_timeline *tl, uint64_t point)
+{
+   pipe_mutex_lock(tl->mutex);
+   if (point > tl->value) {
+      tl->value = point;
+      pipe_condvar_broadcast(tl->signalled);
+   }
+   pipe_mutex_unlock(tl->mutex);
+}
+
+uint64_t
+os_timeline_advance(struct os_timeline *tl)
+{
+   uint64_t point;
+
+   pipe_mutex_lock(tl->mutex);
+   point = ++tl->value;
+   if (tl->next_point < point)
+      tl->next_point = point;
+   pipe_condvar_broadcast(tl->signalled);
+   pipe_mutex_unlock(tl->mutex);
+
+   return point;
+}
+
+uint64_t
+os_timeline_get_value(struct os_timeline *tl)
+{
+   uint64_t value;
+
+   pipe_mutex_lock(tl->mutex);
+   value = tl->value;
+   pipe_mutex_unlock(tl->mutex);
+
+   return value;
+}
+
+boolean
+os_timeline_passed(struct os_timeline *tl, uint64_t point)
+{
+   return os_timeline_get_value(tl) >= point;
+}
+
+boolean
+os_timeline_wait(struct os_timeline *tl, uint64_t point, uint64_t timeout_ns)
+{
+   boolean passed;
+
+   pipe_mutex_lock(tl->mutex);
+
+   if (timeout_ns == PIPE_TIMEOUT_INFINITE) {
+      while (tl->value < point)
+         pipe_condvar_wait(tl->signalled, tl->mutex);
+      passed = TRUE;
+   }
+   else {
+      xtime deadline;
+
+      xtime_get(&deadline, TIME_UTC);
+      deadline.nsec += timeout_ns % 1000000000ull;
+      deadline.sec += timeout_ns / 1000000000ull + deadline.nsec / 1000000000;
+      deadline.nsec %= 1000000000;
+
+      while (tl->value < point) {
+         if (cnd_timedwait(&tl->signalled, &tl->mutex, &deadline) == thrd_busy)
+            break;
+      }
+      passed = tl->value >= point;
+   }
+
+   pipe_mutex_unlock(tl->mutex);
+
+   return passed;
+}
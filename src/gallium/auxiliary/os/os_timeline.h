@@ -0,0 +1,117 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Timeline: a waitable monotonic counter.
+ *
+ * A timeline is a single 64-bit value that only ever moves forward.  A
+ * producer reserves a point with os_timeline_get_point(), does its work,
+ * and signals the point; any number of consumers can test or wait on any
+ * point without knowing anything else about the producer.  Unlike a
+ * one-shot fence there is nothing to allocate or recycle per sync: a
+ * point is just a number, so handing work between two contexts (say an
+ * upload context and a render context sharing a screen) costs one
+ * increment on one side and one compare on the other instead of a full
+ * pipeline flush and fence round trip.
+ */
+
+#ifndef OS_TIMELINE_H_
+#define OS_TIMELINE_H_
+
+#include "pipe/p_compiler.h"
+#include "os/os_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_timeline
+{
+   pipe_mutex mutex;
+   pipe_condvar signalled;
+
+   /* The highest point signalled so far. */
+   uint64_t value;
+
+   /* The last point handed out by os_timeline_get_point(). */
+   uint64_t next_point;
+};
+
+void
+os_timeline_init(struct os_timeline *tl);
+
+void
+os_timeline_destroy(struct os_timeline *tl);
+
+/**
+ * Reserve the next point on the timeline.  Points start at 1 so that 0
+ * can mean "nothing waited on yet" in callers.
+ */
+uint64_t
+os_timeline_get_point(struct os_timeline *tl);
+
+/**
+ * Signal the timeline up to \p point, waking all waiters at or below it.
+ * The value never moves backwards, so producers may signal reserved
+ * points out of order; a point only becomes visible once every point
+ * below it would also be satisfied.
+ */
+void
+os_timeline_signal(struct os_timeline *tl, uint64_t point);
+
+/**
+ * Signal the next point in line (value + 1) and return it.  For
+ * producers that complete work in submission order and don't reserve
+ * points up front.
+ */
+uint64_t
+os_timeline_advance(struct os_timeline *tl);
+
+uint64_t
+os_timeline_get_value(struct os_timeline *tl);
+
+/**
+ * Has the timeline reached \p point?  Never blocks.
+ */
+boolean
+os_timeline_passed(struct os_timeline *tl, uint64_t point);
+
+/**
+ * Wait for the timeline to reach \p point.
+ *
+ * \param timeout_ns  nanoseconds to wait, or PIPE_TIMEOUT_INFINITE.
+ * \return TRUE if the point was reached, FALSE on timeout.
+ */
+boolean
+os_timeline_wait(struct os_timeline *tl, uint64_t point, uint64_t timeout_ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OS_TIMELINE_H_ */
@@ -29,6 +29,7 @@
 
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
+#include "util/u_startup_profile.h"
 #include "util/u_string.h"
 #include "util/u_dl.h"
 
@@ -49,11 +50,13 @@ static int (*backends[])(struct pipe_loader_device **, int) = {
 int
 pipe_loader_probe(struct pipe_loader_device **devs, int ndev)
 {
+   int64_t profile_start = u_startup_profile_begin();
    int i, n = 0;
 
    for (i = 0; i < ARRAY_SIZE(backends); i++)
       n += backends[i](&devs[n], MAX2(0, ndev - n));
 
+   u_startup_profile_end("pipe_loader_probe", profile_start);
    return n;
 }
 
@@ -76,7 +79,11 @@ pipe_loader_configuration(struct pipe_loader_device *dev,
 struct pipe_screen *
 pipe_loader_create_screen(struct pipe_loader_device *dev)
 {
-   return dev->ops->create_screen(dev);
+   int64_t profile_start = u_startup_profile_begin();
+   struct pipe_screen *screen = dev->ops->create_screen(dev);
+
+   u_startup_profile_end("pipe_loader_create_screen", profile_start);
+   return screen;
 }
 
 struct util_dl_library *
@@ -35,6 +35,7 @@
 #include "util/u_math.h"
 #include "util/u_debug.h"
 #include "util/u_memory.h"
+#include "util/u_sampler.h"
 #include "cso_cache/cso_context.h"
 
 /** Initialize the post-processing queue. */
@@ -152,6 +153,7 @@ pp_free_fbos(struct pp_queue_t *ppq)
       pipe_resource_reference(&ppq->tmp[i], NULL);
    }
    for (i = 0; i < ppq->n_inner_tmp; i++) {
+      pipe_sampler_view_reference(&ppq->inner_views[i], NULL);
       pipe_surface_reference(&ppq->inner_tmps[i], NULL);
       pipe_resource_reference(&ppq->inner_tmp[i], NULL);
    }
@@ -260,6 +262,7 @@ pp_init_fbos(struct pp_queue_t *ppq, unsigned int w,
 
    unsigned int i;
    struct pipe_resource tmp_res;
+   struct pipe_sampler_view v_tmp;
 
    if (ppq->fbos_init)
       return;
@@ -276,7 +279,7 @@ pp_init_fbos(struct pp_queue_t *ppq, unsigned int w,
    tmp_res.depth0 = 1;
    tmp_res.array_size = 1;
    tmp_res.last_level = 0;
-   tmp_res.bind = PIPE_BIND_RENDER_TARGET;
+   tmp_res.bind = PIPE_BIND_RENDER_TARGET | PIPE_BIND_SAMPLER_VIEW;
 
    if (!p->screen->is_format_supported(p->screen, tmp_res.format,
                                        tmp_res.target, 1, tmp_res.bind))
@@ -298,6 +301,17 @@ pp_init_fbos(struct pp_queue_t *ppq, unsigned int w,
 
       if (!ppq->inner_tmp[i] || !ppq->inner_tmps[i])
          goto error;
+
+      /* The inner temps get sampled by the following passes, so keep a
+       * view around instead of recreating one on every frame.
+       */
+      u_sampler_view_default_template(&v_tmp, ppq->inner_tmp[i],
+                                      ppq->inner_tmp[i]->format);
+      ppq->inner_views[i] = p->pipe->create_sampler_view(p->pipe,
+                                                         ppq->inner_tmp[i],
+                                                         &v_tmp);
+      if (!ppq->inner_views[i])
+         goto error;
    }
 
    tmp_res.bind = PIPE_BIND_DEPTH_STENCIL;
@@ -54,9 +54,6 @@
 
 #define IMM_SPACE 80
 
-static float constants[] = { 1, 1, 0, 0 };
-static unsigned int dimensions[2] = { 0, 0 };
-
 /** Upload the constants. */
 static void
 up_consts(struct pp_queue_t *ppq)
@@ -64,11 +61,12 @@ up_consts(struct pp_queue_t *ppq)
    struct pipe_context *pipe = ppq->p->pipe;
    struct pipe_box box;
 
-   u_box_2d(0, 0, sizeof(constants), 1, &box);
+   u_box_2d(0, 0, sizeof(ppq->mlaa_consts), 1, &box);
 
    pipe->transfer_inline_write(pipe, ppq->constbuf, 0, PIPE_TRANSFER_WRITE,
-                               &box, constants, sizeof(constants),
-                               sizeof(constants));
+                               &box, ppq->mlaa_consts,
+                               sizeof(ppq->mlaa_consts),
+                               sizeof(ppq->mlaa_consts));
 }
 
 /** Run function of the MLAA filter. */
@@ -80,7 +78,7 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
    struct pp_program *p = ppq->p;
 
    struct pipe_depth_stencil_alpha_state mstencil;
-   struct pipe_sampler_view v_tmp, *arr[3];
+   struct pipe_sampler_view *arr[3];
 
    unsigned int w = 0;
    unsigned int h = 0;
@@ -103,14 +101,14 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
    cso_set_stencil_ref(p->cso, &ref);
 
    /* Init the pixel size constant */
-   if (dimensions[0] != p->framebuffer.width ||
-       dimensions[1] != p->framebuffer.height) {
-      constants[0] = 1.0f / p->framebuffer.width;
-      constants[1] = 1.0f / p->framebuffer.height;
+   if (ppq->mlaa_dims[0] != p->framebuffer.width ||
+       ppq->mlaa_dims[1] != p->framebuffer.height) {
+      ppq->mlaa_consts[0] = 1.0f / p->framebuffer.width;
+      ppq->mlaa_consts[1] = 1.0f / p->framebuffer.height;
 
       up_consts(ppq);
-      dimensions[0] = p->framebuffer.width;
-      dimensions[1] = p->framebuffer.height;
+      ppq->mlaa_dims[0] = p->framebuffer.width;
+      ppq->mlaa_dims[1] = p->framebuffer.height;
    }
 
    cso_set_constant_buffer_resource(p->cso, PIPE_SHADER_VERTEX,
@@ -133,7 +131,11 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
    else
       pp_filter_setup_in(p, ppq->depth);
 
-   pp_filter_setup_out(p, ppq->inner_tmp[0]);
+   /* The inner temps have cached surfaces and sampler views, so the
+    * passes rendering to or sampling from them don't have to create
+    * them anew on every frame.
+    */
+   pipe_surface_reference(&p->framebuffer.cbufs[0], ppq->inner_tmps[0]);
 
    pp_filter_set_fb(p);
    pp_filter_misc_state(p);
@@ -160,13 +162,7 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
    mstencil.stencil[0].zpass_op = PIPE_STENCIL_OP_KEEP;
    cso_set_depth_stencil_alpha(p->cso, &mstencil);
 
-   pp_filter_setup_in(p, ppq->areamaptex);
-   pp_filter_setup_out(p, ppq->inner_tmp[1]);
-
-   u_sampler_view_default_template(&v_tmp, ppq->inner_tmp[0],
-                                   ppq->inner_tmp[0]->format);
-   arr[1] = arr[2] = p->pipe->create_sampler_view(p->pipe,
-                                                  ppq->inner_tmp[0], &v_tmp);
+   pipe_surface_reference(&p->framebuffer.cbufs[0], ppq->inner_tmps[1]);
 
    pp_filter_set_clear_fb(p);
 
@@ -176,7 +172,8 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
       cso_set_samplers(p->cso, PIPE_SHADER_FRAGMENT, 3, samplers);
    }
 
-   arr[0] = p->view;
+   arr[0] = ppq->areamap_view;
+   arr[1] = arr[2] = ppq->inner_views[0];
    cso_set_sampler_views(p->cso, PIPE_SHADER_FRAGMENT, 3, arr);
 
    cso_set_vertex_shader_handle(p->cso, ppq->shaders[n][0]);    /* passvs */
@@ -184,12 +181,11 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
 
    pp_filter_draw(p);
    pp_filter_end_pass(p);
-   pipe_sampler_view_reference(&arr[1], NULL);
 
 
    /* Third pass: smoothed edges */
    /* Sampler order: colormap, blendmap (wtf compiler) */
-   pp_filter_setup_in(p, ppq->inner_tmp[1]);
+   pp_filter_setup_in(p, in);
    pp_filter_setup_out(p, out);
 
    pp_filter_set_fb(p);
@@ -199,16 +195,14 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
            w, h, 0, p->framebuffer.cbufs[0],
            0, 0, w, h);
 
-   u_sampler_view_default_template(&v_tmp, in, in->format);
-   arr[0] = p->pipe->create_sampler_view(p->pipe, in, &v_tmp);
-
    {
       const struct pipe_sampler_state *samplers[] =
          {&p->sampler_point, &p->sampler_point};
       cso_set_samplers(p->cso, PIPE_SHADER_FRAGMENT, 2, samplers);
    }
 
-   arr[1] = p->view;
+   arr[0] = p->view;
+   arr[1] = ppq->inner_views[1];
    cso_set_sampler_views(p->cso, PIPE_SHADER_FRAGMENT, 2, arr);
 
    cso_set_vertex_shader_handle(p->cso, ppq->shaders[n][1]);    /* offsetvs */
@@ -219,7 +213,6 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
 
    pp_filter_draw(p);
    pp_filter_end_pass(p);
-   pipe_sampler_view_reference(&arr[0], NULL);
 
    p->blend.rt[0].blend_enable = 0;
    p->framebuffer.zsbuf = NULL;
@@ -233,6 +226,7 @@ pp_jimenezmlaa_init_run(struct pp_queue_t *ppq, unsigned int n,
 
    struct pipe_box box;
    struct pipe_resource res;
+   struct pipe_sampler_view v_tmp;
    char *tmp_text = NULL;
 
    tmp_text = CALLOC(sizeof(blend2fs_1) + sizeof(blend2fs_2) +
@@ -246,7 +240,7 @@ pp_jimenezmlaa_init_run(struct pp_queue_t *ppq, unsigned int n,
    ppq->constbuf = pipe_buffer_create(ppq->p->screen,
                                       PIPE_BIND_CONSTANT_BUFFER,
                                       PIPE_USAGE_DEFAULT,
-                                      sizeof(constants));
+                                      sizeof(ppq->mlaa_consts));
    if (ppq->constbuf == NULL) {
       pp_debug("Failed to allocate constant buffer\n");
       goto fail;
@@ -284,6 +278,19 @@ pp_jimenezmlaa_init_run(struct pp_queue_t *ppq, unsigned int n,
                                        PIPE_TRANSFER_WRITE, &box,
                                        areamap, 165 * 2, sizeof(areamap));
 
+   /* The area map is immutable, so its view can be kept for the queue's
+    * lifetime instead of being recreated on every frame.
+    */
+   u_sampler_view_default_template(&v_tmp, ppq->areamaptex,
+                                   ppq->areamaptex->format);
+   ppq->areamap_view = ppq->p->pipe->create_sampler_view(ppq->p->pipe,
+                                                         ppq->areamaptex,
+                                                         &v_tmp);
+   if (ppq->areamap_view == NULL) {
+      pp_debug("Failed to create the area map sampler view\n");
+      goto fail;
+   }
+
    ppq->shaders[n][1] = pp_tgsi_to_state(ppq->p->pipe, offsetvs, true,
                                          "offsetvs");
    if (iscolor)
@@ -356,6 +363,8 @@ pp_jimenezmlaa_color(struct pp_queue_t *ppq, struct pipe_resource *in,
 void
 pp_jimenezmlaa_free(struct pp_queue_t *ppq, unsigned int n)
 {
+   pipe_sampler_view_reference(&ppq->areamap_view, NULL);
+
    if (ppq->areamaptex) {
       ppq->p->screen->resource_destroy(ppq->p->screen, ppq->areamaptex);
       ppq->areamaptex = NULL;
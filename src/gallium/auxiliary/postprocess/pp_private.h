@@ -81,6 +81,16 @@ struct pp_queue_t
 
    struct pipe_surface *tmps[2], *inner_tmps[3], *stencils;
 
+   /* Sampler views of the inner temps, cached so that the filters don't
+    * have to recreate them on every frame.
+    */
+   struct pipe_sampler_view *inner_views[3];
+
+   struct pipe_sampler_view *areamap_view;      /* cached areamaptex view */
+
+   float mlaa_consts[4];        /* constbuf contents */
+   unsigned int mlaa_dims[2];   /* size the constants were uploaded for */
+
    void ***shaders;             /* Shaders in TGSI form */
    unsigned int *filters;       /* Active filter to filters.h mapping. */
    struct pp_program *p;
@@ -1490,6 +1490,27 @@ void sse2_por( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
    emit_modrm(p, dst, src);
 }
 
+void sse2_pand( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR(dst, src);
+   emit_3ub(p, 0x66, 0x0f, 0xdb);
+   emit_modrm(p, dst, src);
+}
+
+void sse2_pxor( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR(dst, src);
+   emit_3ub(p, 0x66, 0x0f, 0xef);
+   emit_modrm(p, dst, src);
+}
+
+void sse2_psubd( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR(dst, src);
+   emit_3ub(p, 0x66, 0x0f, 0xfa);
+   emit_modrm(p, dst, src);
+}
+
 void sse2_rcpps( struct x86_function *p,
                  struct x86_reg dst,
                  struct x86_reg src )
@@ -1508,6 +1529,58 @@ void sse2_rcpss( struct x86_function *p,
    emit_modrm( p, dst, src );
 }
 
+/***********************************************************************
+ * SSE4.1 instructions
+ */
+
+void sse4_1_pmovzxbw( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR( dst, src );
+   emit_3ub(p, 0x66, 0x0f, 0x38);
+   emit_1ub(p, 0x30);
+   emit_modrm( p, dst, src );
+}
+
+void sse4_1_pmovzxbd( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR( dst, src );
+   emit_3ub(p, 0x66, 0x0f, 0x38);
+   emit_1ub(p, 0x31);
+   emit_modrm( p, dst, src );
+}
+
+void sse4_1_pmovzxwd( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR( dst, src );
+   emit_3ub(p, 0x66, 0x0f, 0x38);
+   emit_1ub(p, 0x33);
+   emit_modrm( p, dst, src );
+}
+
+void sse4_1_pmovsxbw( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR( dst, src );
+   emit_3ub(p, 0x66, 0x0f, 0x38);
+   emit_1ub(p, 0x20);
+   emit_modrm( p, dst, src );
+}
+
+void sse4_1_pmovsxbd( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR( dst, src );
+   emit_3ub(p, 0x66, 0x0f, 0x38);
+   emit_1ub(p, 0x21);
+   emit_modrm( p, dst, src );
+}
+
+void sse4_1_pmovsxwd( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR( dst, src );
+   emit_3ub(p, 0x66, 0x0f, 0x38);
+   emit_1ub(p, 0x23);
+   emit_modrm( p, dst, src );
+}
+
 /***********************************************************************
  * x87 instructions
  */
@@ -265,6 +265,16 @@ void sse2_psraw_imm( struct x86_function *p, struct x86_reg dst, unsigned imm );
 void sse2_psrad_imm( struct x86_function *p, struct x86_reg dst, unsigned imm );
 
 void sse2_por( struct x86_function *p, struct x86_reg dst, struct x86_reg src );
+void sse2_pand( struct x86_function *p, struct x86_reg dst, struct x86_reg src );
+void sse2_pxor( struct x86_function *p, struct x86_reg dst, struct x86_reg src );
+void sse2_psubd( struct x86_function *p, struct x86_reg dst, struct x86_reg src );
+
+void sse4_1_pmovzxbw( struct x86_function *p, struct x86_reg dst, struct x86_reg src );
+void sse4_1_pmovzxbd( struct x86_function *p, struct x86_reg dst, struct x86_reg src );
+void sse4_1_pmovzxwd( struct x86_function *p, struct x86_reg dst, struct x86_reg src );
+void sse4_1_pmovsxbw( struct x86_function *p, struct x86_reg dst, struct x86_reg src );
+void sse4_1_pmovsxbd( struct x86_function *p, struct x86_reg dst, struct x86_reg src );
+void sse4_1_pmovsxwd( struct x86_function *p, struct x86_reg dst, struct x86_reg src );
 
 void sse2_pshuflw( struct x86_function *p, struct x86_reg dst, struct x86_reg src, uint8_t imm );
 void sse2_pshufhw( struct x86_function *p, struct x86_reg dst, struct x86_reg src, uint8_t imm );
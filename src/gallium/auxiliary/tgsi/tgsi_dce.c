@@ -0,0 +1,308 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Conservative dead-code elimination for TGSI shaders.
+ *
+ * Removes instructions whose only results are temporary register
+ * channels which are never read afterwards.  This is aimed at
+ * interpreted execution (tgsi_exec), where every surviving
+ * instruction is paid for on every fragment/vertex.
+ *
+ * The pass only handles straight-line shaders: any control flow,
+ * predication or indirect temporary addressing makes the backwards
+ * liveness scan below invalid, in which case the shader is left
+ * untouched.
+ */
+
+#include "pipe/p_shader_tokens.h"
+#include "util/u_debug.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "tgsi_dce.h"
+#include "tgsi_parse.h"
+#include "tgsi_transform.h"
+#include "tgsi_util.h"
+
+
+/**
+ * Opcodes which end straight-line execution.  Region openers are
+ * enough to detect structured control flow; CAL/CALLNZ cover calls
+ * into subroutines.
+ */
+static boolean
+is_control_flow(unsigned opcode)
+{
+   switch (opcode) {
+   case TGSI_OPCODE_CAL:
+   case TGSI_OPCODE_RET:
+   case TGSI_OPCODE_BRK:
+   case TGSI_OPCODE_IF:
+   case TGSI_OPCODE_UIF:
+   case TGSI_OPCODE_ELSE:
+   case TGSI_OPCODE_ENDIF:
+   case TGSI_OPCODE_CONT:
+   case TGSI_OPCODE_BGNLOOP:
+   case TGSI_OPCODE_BGNSUB:
+   case TGSI_OPCODE_ENDLOOP:
+   case TGSI_OPCODE_ENDSUB:
+   case TGSI_OPCODE_CALLNZ:
+   case TGSI_OPCODE_BREAKC:
+   case TGSI_OPCODE_SWITCH:
+   case TGSI_OPCODE_CASE:
+   case TGSI_OPCODE_DEFAULT:
+   case TGSI_OPCODE_ENDSWITCH:
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+
+/**
+ * Opcodes which must be kept even if all their register results are
+ * unused.
+ */
+static boolean
+has_side_effects(unsigned opcode)
+{
+   switch (opcode) {
+   case TGSI_OPCODE_EMIT:
+   case TGSI_OPCODE_ENDPRIM:
+   case TGSI_OPCODE_KILL:
+   case TGSI_OPCODE_KILL_IF:
+   case TGSI_OPCODE_STORE:
+   case TGSI_OPCODE_MFENCE:
+   case TGSI_OPCODE_LFENCE:
+   case TGSI_OPCODE_SFENCE:
+   case TGSI_OPCODE_BARRIER:
+   case TGSI_OPCODE_ATOMUADD:
+   case TGSI_OPCODE_ATOMXCHG:
+   case TGSI_OPCODE_ATOMCAS:
+   case TGSI_OPCODE_ATOMAND:
+   case TGSI_OPCODE_ATOMOR:
+   case TGSI_OPCODE_ATOMXOR:
+   case TGSI_OPCODE_ATOMUMIN:
+   case TGSI_OPCODE_ATOMUMAX:
+   case TGSI_OPCODE_ATOMIMIN:
+   case TGSI_OPCODE_ATOMIMAX:
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+
+struct dce_transform_context
+{
+   struct tgsi_transform_context base;
+   const boolean *dead;
+   unsigned instno;
+};
+
+
+static void
+dce_transform_instruction(struct tgsi_transform_context *tctx,
+                          struct tgsi_full_instruction *inst)
+{
+   struct dce_transform_context *ctx = (struct dce_transform_context *) tctx;
+
+   if (!ctx->dead[ctx->instno++])
+      tctx->emit_instruction(tctx, inst);
+}
+
+
+/**
+ * Remove instructions which only write temporary register channels
+ * that are never read.
+ * \return new token array (to be freed with tgsi_free_tokens()), or
+ *         NULL if the shader could not be processed or nothing was
+ *         removed, in which case the caller keeps the original.
+ */
+struct tgsi_token *
+tgsi_dce(const struct tgsi_token *tokens)
+{
+   struct tgsi_parse_context parse;
+   struct tgsi_full_instruction *insts = NULL;
+   struct tgsi_token *newtoks = NULL;
+   boolean *dead = NULL;
+   ubyte *live = NULL;
+   unsigned num_insts = 0, max_insts = 0;
+   unsigned num_temps = 0;
+   unsigned num_removed = 0;
+   unsigned i;
+   int n;
+
+   if (tgsi_parse_init(&parse, tokens) != TGSI_PARSE_OK)
+      return NULL;
+
+   /* Gather the instructions, bailing out on anything which would
+    * invalidate the liveness scan below.
+    */
+   while (!tgsi_parse_end_of_tokens(&parse)) {
+      tgsi_parse_token(&parse);
+
+      switch (parse.FullToken.Token.Type) {
+      case TGSI_TOKEN_TYPE_DECLARATION:
+         {
+            const struct tgsi_full_declaration *decl =
+               &parse.FullToken.FullDeclaration;
+
+            if (decl->Declaration.File == TGSI_FILE_TEMPORARY)
+               num_temps = MAX2(num_temps, decl->Range.Last + 1);
+         }
+         break;
+
+      case TGSI_TOKEN_TYPE_INSTRUCTION:
+         {
+            const struct tgsi_full_instruction *inst =
+               &parse.FullToken.FullInstruction;
+
+            if (is_control_flow(inst->Instruction.Opcode) ||
+                inst->Instruction.Predicate)
+               goto out;
+
+            for (i = 0; i < inst->Instruction.NumDstRegs; i++) {
+               if (inst->Dst[i].Register.File == TGSI_FILE_TEMPORARY &&
+                   inst->Dst[i].Register.Indirect)
+                  goto out;
+            }
+            for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+               if (inst->Src[i].Register.File == TGSI_FILE_TEMPORARY &&
+                   inst->Src[i].Register.Indirect)
+                  goto out;
+            }
+
+            if (num_insts == max_insts) {
+               unsigned new_max = max_insts ? max_insts * 2 : 64;
+               insts = REALLOC(insts,
+                               max_insts * sizeof(*insts),
+                               new_max * sizeof(*insts));
+               if (!insts)
+                  goto out;
+               max_insts = new_max;
+            }
+            insts[num_insts++] = *inst;
+         }
+         break;
+
+      default:
+         break;
+      }
+   }
+
+   if (!num_insts || !num_temps)
+      goto out;
+
+   dead = CALLOC(num_insts, sizeof(*dead));
+   live = CALLOC(num_temps, sizeof(*live));
+   if (!dead || !live)
+      goto out;
+
+   /* Backwards scan: live[t] holds the channels of TEMP[t] read by
+    * some later instruction.  An instruction is dead if all its
+    * destinations are temporaries whose written channels are not
+    * live; the sources of dead instructions contribute no liveness.
+    */
+   for (n = num_insts - 1; n >= 0; n--) {
+      const struct tgsi_full_instruction *inst = &insts[n];
+      const unsigned num_dst = inst->Instruction.NumDstRegs;
+      boolean removable =
+         num_dst > 0 && !has_side_effects(inst->Instruction.Opcode);
+
+      for (i = 0; i < num_dst; i++) {
+         const struct tgsi_dst_register *dst = &inst->Dst[i].Register;
+
+         if (dst->File != TGSI_FILE_TEMPORARY ||
+             (dst->WriteMask & live[dst->Index]))
+            removable = FALSE;
+      }
+
+      if (removable) {
+         dead[n] = TRUE;
+         num_removed++;
+         continue;
+      }
+
+      for (i = 0; i < num_dst; i++) {
+         const struct tgsi_dst_register *dst = &inst->Dst[i].Register;
+
+         if (dst->File == TGSI_FILE_TEMPORARY)
+            live[dst->Index] &= ~dst->WriteMask;
+      }
+
+      for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+         if (inst->Src[i].Register.File == TGSI_FILE_TEMPORARY) {
+            const unsigned usage = tgsi_util_get_inst_usage_mask(inst, i);
+            unsigned chan;
+
+            for (chan = 0; chan < 4; chan++) {
+               if (usage & (1 << chan)) {
+                  unsigned swz =
+                     tgsi_util_get_full_src_register_swizzle(&inst->Src[i],
+                                                             chan);
+                  live[inst->Src[i].Register.Index] |= 1 << swz;
+               }
+            }
+         }
+      }
+
+      for (i = 0; inst->Instruction.Texture &&
+              i < inst->Texture.NumOffsets; i++) {
+         const struct tgsi_texture_offset *off = &inst->TexOffsets[i];
+
+         if (off->File == TGSI_FILE_TEMPORARY) {
+            live[off->Index] |= (1 << off->SwizzleX) |
+                                (1 << off->SwizzleY) |
+                                (1 << off->SwizzleZ);
+         }
+      }
+   }
+
+   if (num_removed) {
+      struct dce_transform_context ctx;
+      int newlen;
+
+      memset(&ctx, 0, sizeof(ctx));
+      ctx.base.transform_instruction = dce_transform_instruction;
+      ctx.dead = dead;
+
+      /* the output is strictly smaller than the input */
+      newlen = tgsi_num_tokens(tokens);
+      newtoks = tgsi_alloc_tokens(newlen);
+      if (newtoks)
+         tgsi_transform_shader(tokens, newtoks, newlen, &ctx.base);
+   }
+
+out:
+   tgsi_parse_free(&parse);
+   FREE(insts);
+   FREE(dead);
+   FREE(live);
+   return newtoks;
+}
@@ -62,6 +62,10 @@
 #include "util/u_memory.h"
 #include "util/u_math.h"
 
+#if defined(PIPE_ARCH_SSE)
+#include <emmintrin.h>
+#endif
+
 
 #define DEBUG_EXECUTION 0
 
@@ -83,14 +87,26 @@ struct tgsi_double_vector {
    union tgsi_double_channel zw;
 };
 
+/*
+ * The common float micro ops are implemented with SSE intrinsics where
+ * available; each op processes the whole four-lane channel at once.
+ * Note that tgsi_exec_channel only has natural (4 byte) alignment, hence
+ * the unaligned loads/stores.
+ */
+
 static void
 micro_abs(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_andnot_ps(_mm_set1_ps(-0.0f),
+                                       _mm_loadu_ps(src->f)));
+#else
    dst->f[0] = fabsf(src->f[0]);
    dst->f[1] = fabsf(src->f[1]);
    dst->f[2] = fabsf(src->f[2]);
    dst->f[3] = fabsf(src->f[3]);
+#endif
 }
 
 static void
@@ -141,10 +157,16 @@ micro_cmp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   __m128 mask = _mm_cmplt_ps(_mm_loadu_ps(src0->f), _mm_setzero_ps());
+   _mm_storeu_ps(dst->f, _mm_or_ps(_mm_and_ps(mask, _mm_loadu_ps(src1->f)),
+                                   _mm_andnot_ps(mask, _mm_loadu_ps(src2->f))));
+#else
    dst->f[0] = src0->f[0] < 0.0f ? src1->f[0] : src2->f[0];
    dst->f[1] = src0->f[1] < 0.0f ? src1->f[1] : src2->f[1];
    dst->f[2] = src0->f[2] < 0.0f ? src1->f[2] : src2->f[2];
    dst->f[3] = src0->f[3] < 0.0f ? src1->f[3] : src2->f[3];
+#endif
 }
 
 static void
@@ -495,10 +517,18 @@ micro_lrp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   __m128 s2 = _mm_loadu_ps(src2->f);
+   _mm_storeu_ps(dst->f,
+                 _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src0->f),
+                                       _mm_sub_ps(_mm_loadu_ps(src1->f), s2)),
+                            s2));
+#else
    dst->f[0] = src0->f[0] * (src1->f[0] - src2->f[0]) + src2->f[0];
    dst->f[1] = src0->f[1] * (src1->f[1] - src2->f[1]) + src2->f[1];
    dst->f[2] = src0->f[2] * (src1->f[2] - src2->f[2]) + src2->f[2];
    dst->f[3] = src0->f[3] * (src1->f[3] - src2->f[3]) + src2->f[3];
+#endif
 }
 
 static void
@@ -507,20 +537,32 @@ micro_mad(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f,
+                 _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src0->f),
+                                       _mm_loadu_ps(src1->f)),
+                            _mm_loadu_ps(src2->f)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0] + src2->f[0];
    dst->f[1] = src0->f[1] * src1->f[1] + src2->f[1];
    dst->f[2] = src0->f[2] * src1->f[2] + src2->f[2];
    dst->f[3] = src0->f[3] * src1->f[3] + src2->f[3];
+#endif
 }
 
 static void
 micro_mov(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_si128((__m128i *) dst->u,
+                    _mm_loadu_si128((const __m128i *) src->u));
+#else
    dst->u[0] = src->u[0];
    dst->u[1] = src->u[1];
    dst->u[2] = src->u[2];
    dst->u[3] = src->u[3];
+#endif
 }
 
 static void
@@ -580,10 +622,16 @@ micro_seq(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpeq_ps(_mm_loadu_ps(src0->f),
+                                                 _mm_loadu_ps(src1->f)),
+                                    _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] == src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] == src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] == src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] == src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -591,10 +639,16 @@ micro_sge(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(src0->f),
+                                                 _mm_loadu_ps(src1->f)),
+                                    _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] >= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] >= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] >= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] >= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -622,10 +676,16 @@ micro_sgt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpgt_ps(_mm_loadu_ps(src0->f),
+                                                 _mm_loadu_ps(src1->f)),
+                                    _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] > src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] > src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] > src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -643,10 +703,16 @@ micro_sle(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(src0->f),
+                                                 _mm_loadu_ps(src1->f)),
+                                    _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] <= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] <= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] <= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] <= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -654,10 +720,16 @@ micro_slt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(src0->f),
+                                                 _mm_loadu_ps(src1->f)),
+                                    _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] < src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] < src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] < src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -665,10 +737,16 @@ micro_sne(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpneq_ps(_mm_loadu_ps(src0->f),
+                                                  _mm_loadu_ps(src1->f)),
+                                    _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] != src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] != src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] != src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] != src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -1110,10 +1188,15 @@ micro_add(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_add_ps(_mm_loadu_ps(src0->f),
+                                    _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] + src1->f[0];
    dst->f[1] = src0->f[1] + src1->f[1];
    dst->f[2] = src0->f[2] + src1->f[2];
    dst->f[3] = src0->f[3] + src1->f[3];
+#endif
 }
 
 static void
@@ -1155,10 +1238,16 @@ micro_max(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   /* maxps matches the scalar select exactly, including for NaNs */
+   _mm_storeu_ps(dst->f, _mm_max_ps(_mm_loadu_ps(src0->f),
+                                    _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] > src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] > src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] > src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -1166,10 +1255,16 @@ micro_min(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   /* minps matches the scalar select exactly, including for NaNs */
+   _mm_storeu_ps(dst->f, _mm_min_ps(_mm_loadu_ps(src0->f),
+                                    _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] < src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] < src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] < src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -1177,10 +1272,15 @@ micro_mul(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_mul_ps(_mm_loadu_ps(src0->f),
+                                    _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0];
    dst->f[1] = src0->f[1] * src1->f[1];
    dst->f[2] = src0->f[2] * src1->f[2];
    dst->f[3] = src0->f[3] * src1->f[3];
+#endif
 }
 
 static void
@@ -1188,10 +1288,15 @@ micro_neg(
    union tgsi_exec_channel *dst,
    const union tgsi_exec_channel *src )
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_xor_ps(_mm_loadu_ps(src->f),
+                                    _mm_set1_ps(-0.0f)));
+#else
    dst->f[0] = -src->f[0];
    dst->f[1] = -src->f[1];
    dst->f[2] = -src->f[2];
    dst->f[3] = -src->f[3];
+#endif
 }
 
 static void
@@ -1218,10 +1323,15 @@ micro_sub(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_sub_ps(_mm_loadu_ps(src0->f),
+                                    _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] - src1->f[0];
    dst->f[1] = src0->f[1] - src1->f[1];
    dst->f[2] = src0->f[2] - src1->f[2];
    dst->f[3] = src0->f[3] - src1->f[3];
+#endif
 }
 
 static void
@@ -1356,6 +1466,61 @@ fetch_source_d(const struct tgsi_exec_machine *mach,
    union tgsi_exec_channel index2D;
    uint swizzle;
 
+   /* Fast path: direct, non-dimensioned operands hit the same register
+    * in all four quad channels, so the value can be fetched at once
+    * instead of going through the generic per-channel indexed path
+    * below.  This covers the vast majority of operands.
+    */
+   if (!reg->Register.Indirect && !reg->Register.Dimension) {
+      const int idx = reg->Register.Index;
+
+      swizzle = tgsi_util_get_full_src_register_swizzle(reg, chan_index);
+
+      switch (reg->Register.File) {
+      case TGSI_FILE_TEMPORARY:
+         assert(idx >= 0 && idx < TGSI_EXEC_NUM_TEMPS);
+         *chan = mach->Temps[idx].xyzw[swizzle];
+         return;
+
+      case TGSI_FILE_INPUT:
+         assert(idx >= 0 && idx < TGSI_MAX_PRIM_VERTICES * PIPE_MAX_ATTRIBS);
+         *chan = mach->Inputs[idx].xyzw[swizzle];
+         return;
+
+      case TGSI_FILE_IMMEDIATE:
+         {
+            uint i;
+            assert(idx >= 0 && idx < (int) mach->ImmLimit);
+            for (i = 0; i < TGSI_QUAD_SIZE; i++) {
+               chan->f[i] = mach->Imms[idx][swizzle];
+            }
+         }
+         return;
+
+      case TGSI_FILE_CONSTANT:
+         {
+            const uint *buf = (const uint *) mach->Consts[0];
+            const int pos = idx * 4 + swizzle;
+            uint i, value;
+
+            assert(mach->Consts[0]);
+            /* const buffer bounds check */
+            if (pos < 0 || pos >= (int) mach->ConstsSize[0])
+               value = 0;
+            else
+               value = buf[pos];
+            for (i = 0; i < TGSI_QUAD_SIZE; i++) {
+               chan->u[i] = value;
+            }
+         }
+         return;
+
+      default:
+         /* less common files keep the generic path */
+         break;
+      }
+   }
+
    /* We start with a direct index into a register file.
     *
     *    file[1],
@@ -234,6 +234,21 @@ static void set_bad( struct ureg_program *ureg )
 }
 
 
+void
+ureg_set_size_estimate( struct ureg_program *ureg, unsigned nr_tokens )
+{
+   if (!nr_tokens)
+      return;
+
+   /* ureg_finalize() appends the instruction stream onto the declarations,
+    * so the decl domain needs room for everything for the append to land
+    * without another grow.
+    */
+   tokens_expand(&ureg->domain[DOMAIN_DECL], nr_tokens);
+   tokens_expand(&ureg->domain[DOMAIN_INSN], nr_tokens);
+}
+
+
 
 static union tgsi_any_token *get_tokens( struct ureg_program *ureg,
                                          unsigned domain,
@@ -104,6 +104,14 @@ ureg_create(unsigned processor);
 struct ureg_program *
 ureg_create_with_screen(unsigned processor, struct pipe_screen *screen);
 
+/* Size the token arrays for a shader expected to need about nr_tokens
+ * tokens, so emission and finalization don't go through repeated
+ * copy-on-grow cycles.  Purely a hint: under-estimating just brings the
+ * doubling growth back.
+ */
+void
+ureg_set_size_estimate( struct ureg_program *ureg, unsigned nr_tokens );
+
 const struct tgsi_token *
 ureg_finalize( struct ureg_program * );
 
@@ -64,7 +64,7 @@ struct translate_buffer_variant
 
 #define ELEMENT_BUFFER_INSTANCE_ID  1001
 
-#define NUM_CONSTS 7
+#define NUM_CONSTS 12
 
 enum
 {
@@ -74,7 +74,12 @@ enum
    CONST_INV_32767,
    CONST_INV_65535,
    CONST_INV_2147483647,
-   CONST_255
+   CONST_255,
+   CONST_INV_1023,
+   CONST_INV_511,
+   CONST_2_10_10_10_MASK,
+   CONST_2_10_10_10_BIAS,
+   CONST_INV_65536
 };
 
 #define C(v) {(float)(v), (float)(v), (float)(v), (float)(v)}
@@ -85,7 +90,13 @@ static float consts[NUM_CONSTS][4] = {
    C(1.0 / 32767.0),
    C(1.0 / 65535.0),
    C(1.0 / 2147483647.0),
-   C(255.0)
+   C(255.0),
+   {(float)(1.0 / 1023.0), (float)(1.0 / 1023.0),
+    (float)(1.0 / 1023.0), (float)(1.0 / 3.0)},
+   {(float)(1.0 / 511.0), (float)(1.0 / 511.0), (float)(1.0 / 511.0), 1},
+   {0, 0, 0, 0},                /* filled with integers at create time */
+   {0, 0, 0, 0},                /* filled with integers at create time */
+   C(1.0 / 65536.0)
 };
 
 #undef C
@@ -476,6 +487,55 @@ translate_attr_convert(struct translate_sse *p,
        || a->input_format == PIPE_FORMAT_NONE)
       return FALSE;
 
+   /* The 2_10_10_10 vertex formats have mixed channel sizes, which the
+    * generic channel checks below can't deal with, so handle them first.
+    */
+   if ((x86_target_caps(p->func) & X86_SSE2) &&
+       a->output_format == PIPE_FORMAT_R32G32B32A32_FLOAT &&
+       (0 || a->input_format == PIPE_FORMAT_R10G10B10A2_UNORM
+        || a->input_format == PIPE_FORMAT_R10G10B10A2_USCALED
+        || a->input_format == PIPE_FORMAT_R10G10B10A2_SNORM
+        || a->input_format == PIPE_FORMAT_R10G10B10A2_SSCALED
+        || a->input_format == PIPE_FORMAT_B10G10R10A2_UNORM
+        || a->input_format == PIPE_FORMAT_B10G10R10A2_USCALED
+        || a->input_format == PIPE_FORMAT_B10G10R10A2_SNORM
+        || a->input_format == PIPE_FORMAT_B10G10R10A2_SSCALED)) {
+      struct x86_reg dataXMM = x86_make_reg(file_XMM, 0);
+      struct x86_reg tmpXMM = x86_make_reg(file_XMM, 1);
+      boolean is_signed =
+         input_desc->channel[0].type == UTIL_FORMAT_TYPE_SIGNED;
+
+      /* Spread the packed dword so that lane i holds v >> (10 * i),
+       * putting each field into the low bits of its lane.
+       */
+      sse2_movd(p->func, dataXMM, src);
+      sse2_movdqa(p->func, tmpXMM, dataXMM);
+      sse2_psrld_imm(p->func, tmpXMM, 10);
+      sse2_punpckldq(p->func, dataXMM, tmpXMM);
+      sse2_movdqa(p->func, tmpXMM, dataXMM);
+      sse2_psrld_imm(p->func, tmpXMM, 20);
+      sse2_punpcklqdq(p->func, dataXMM, tmpXMM);
+
+      sse2_pand(p->func, dataXMM, get_const(p, CONST_2_10_10_10_MASK));
+      if (is_signed) {
+         /* sign-extend the 10 (resp. 2) bit fields: (v ^ bias) - bias */
+         sse2_pxor(p->func, dataXMM, get_const(p, CONST_2_10_10_10_BIAS));
+         sse2_psubd(p->func, dataXMM, get_const(p, CONST_2_10_10_10_BIAS));
+      }
+      sse2_cvtdq2ps(p->func, dataXMM, dataXMM);
+      if (input_desc->channel[0].normalized) {
+         sse_mulps(p->func, dataXMM,
+                   get_const(p, is_signed ? CONST_INV_511 : CONST_INV_1023));
+      }
+
+      /* the B10G10R10A2 variants need the red/blue channels swapped */
+      if (input_desc->swizzle[0] == PIPE_SWIZZLE_Z)
+         sse_shufps(p->func, dataXMM, dataXMM, SHUF(2, 1, 0, 3));
+
+      sse_movups(p->func, dst, dataXMM);
+      return TRUE;
+   }
+
    if (input_desc->channel[0].size & 7)
       return FALSE;
 
@@ -531,17 +591,24 @@ translate_attr_convert(struct translate_sse *p,
                            input_desc->channel[0].size *
                            input_desc->nr_channels >> 3);
 
-            /* TODO: add support for SSE4.1 pmovzx */
             switch (input_desc->channel[0].size) {
             case 8:
-               /* TODO: this may be inefficient due to get_identity() being
-                *  used both as a float and integer register.
-                */
-               sse2_punpcklbw(p->func, dataXMM, get_const(p, CONST_IDENTITY));
-               sse2_punpcklbw(p->func, dataXMM, get_const(p, CONST_IDENTITY));
+               if (x86_target_caps(p->func) & X86_SSE4_1) {
+                  sse4_1_pmovzxbd(p->func, dataXMM, dataXMM);
+               }
+               else {
+                  /* TODO: this may be inefficient due to get_identity() being
+                   *  used both as a float and integer register.
+                   */
+                  sse2_punpcklbw(p->func, dataXMM, get_const(p, CONST_IDENTITY));
+                  sse2_punpcklbw(p->func, dataXMM, get_const(p, CONST_IDENTITY));
+               }
                break;
             case 16:
-               sse2_punpcklwd(p->func, dataXMM, get_const(p, CONST_IDENTITY));
+               if (x86_target_caps(p->func) & X86_SSE4_1)
+                  sse4_1_pmovzxwd(p->func, dataXMM, dataXMM);
+               else
+                  sse2_punpcklwd(p->func, dataXMM, get_const(p, CONST_IDENTITY));
                break;
             case 32:           /* we lose precision here */
                sse2_psrld_imm(p->func, dataXMM, 1);
@@ -583,16 +650,25 @@ translate_attr_convert(struct translate_sse *p,
                            input_desc->channel[0].size *
                            input_desc->nr_channels >> 3);
 
-            /* TODO: add support for SSE4.1 pmovsx */
             switch (input_desc->channel[0].size) {
             case 8:
-               sse2_punpcklbw(p->func, dataXMM, dataXMM);
-               sse2_punpcklbw(p->func, dataXMM, dataXMM);
-               sse2_psrad_imm(p->func, dataXMM, 24);
+               if (x86_target_caps(p->func) & X86_SSE4_1) {
+                  sse4_1_pmovsxbd(p->func, dataXMM, dataXMM);
+               }
+               else {
+                  sse2_punpcklbw(p->func, dataXMM, dataXMM);
+                  sse2_punpcklbw(p->func, dataXMM, dataXMM);
+                  sse2_psrad_imm(p->func, dataXMM, 24);
+               }
                break;
             case 16:
-               sse2_punpcklwd(p->func, dataXMM, dataXMM);
-               sse2_psrad_imm(p->func, dataXMM, 16);
+               if (x86_target_caps(p->func) & X86_SSE4_1) {
+                  sse4_1_pmovsxwd(p->func, dataXMM, dataXMM);
+               }
+               else {
+                  sse2_punpcklwd(p->func, dataXMM, dataXMM);
+                  sse2_psrad_imm(p->func, dataXMM, 16);
+               }
                break;
             case 32:           /* we lose precision here */
                break;
@@ -624,6 +700,18 @@ translate_attr_convert(struct translate_sse *p,
             }
             break;
 
+            break;
+         case UTIL_FORMAT_TYPE_FIXED:
+            /* GLES 16.16 fixed point: load as dwords, convert and scale */
+            if (!(x86_target_caps(p->func) & X86_SSE2))
+               return FALSE;
+            if (input_desc->channel[0].size != 32)
+               return FALSE;
+            emit_load_sse2(p, dataXMM, src,
+                           input_desc->channel[0].size *
+                           input_desc->nr_channels >> 3);
+            sse2_cvtdq2ps(p->func, dataXMM, dataXMM);
+            sse_mulps(p->func, dataXMM, get_const(p, CONST_INV_65536));
             break;
          case UTIL_FORMAT_TYPE_FLOAT:
             if (input_desc->channel[0].size != 32
@@ -767,6 +855,8 @@ translate_attr_convert(struct translate_sse *p,
                if (output_desc->channel[0].type == UTIL_FORMAT_TYPE_SIGNED)
                   sse2_psrlw_imm(p->func, dataXMM, 1);
             }
+            else if (x86_target_caps(p->func) & X86_SSE4_1)
+               sse4_1_pmovzxbw(p->func, dataXMM, dataXMM);
             else
                sse2_punpcklbw(p->func, dataXMM, get_const(p, CONST_IDENTITY));
             break;
@@ -785,6 +875,9 @@ translate_attr_convert(struct translate_sse *p,
                   tmpXMM = t;
                }
             }
+            else if (x86_target_caps(p->func) & X86_SSE4_1) {
+               sse4_1_pmovsxbw(p->func, dataXMM, dataXMM);
+            }
             else {
                sse2_punpcklbw(p->func, dataXMM, dataXMM);
                sse2_psraw_imm(p->func, dataXMM, 8);
@@ -1492,6 +1585,16 @@ translate_sse2_create(const struct translate_key *key)
    memset(p, 0, sizeof(*p));
    memcpy(p->consts, consts, sizeof(consts));
 
+   /* integer bit patterns can't be expressed in the float table above */
+   {
+      uint32_t *mask = (uint32_t *) p->consts[CONST_2_10_10_10_MASK];
+      uint32_t *bias = (uint32_t *) p->consts[CONST_2_10_10_10_BIAS];
+      mask[0] = mask[1] = mask[2] = 0x3ff;
+      mask[3] = 0x3;
+      bias[0] = bias[1] = bias[2] = 0x200;
+      bias[3] = 0x2;
+   }
+
    p->translate.key = *key;
    p->translate.release = translate_sse_release;
    p->translate.set_buffer = translate_sse_set_buffer;
@@ -36,6 +36,7 @@
 #include "pipe/p_compiler.h"
 #include "util/u_debug.h"
 
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_bitmask.h"
 
@@ -57,6 +58,12 @@ struct util_bitmask
    
    /** Number of consecutive bits set at the start of the bitmask */
    unsigned filled;
+
+   /** Word to start searching from, rotated to wherever the last
+    * allocation landed so repeated adds don't rescan the filled
+    * low words every time.
+    */
+   unsigned free_word;
 };
 
 
@@ -77,7 +84,8 @@ util_bitmask_create(void)
    
    bm->size = UTIL_BITMASK_INITIAL_WORDS * UTIL_BITMASK_BITS_PER_WORD;
    bm->filled = 0;
-   
+   bm->free_word = 0;
+
    return bm;
 }
 
@@ -159,38 +167,121 @@ util_bitmask_filled_unset(struct util_bitmask *bm,
 unsigned
 util_bitmask_add(struct util_bitmask *bm)
 {
+   unsigned num_words = bm->size / UTIL_BITMASK_BITS_PER_WORD;
+   unsigned i;
    unsigned word;
    unsigned bit;
+   unsigned index;
    util_bitmask_word mask;
-   
+
    assert(bm);
 
-   /* linear search for an empty index */
-   word = bm->filled / UTIL_BITMASK_BITS_PER_WORD;
-   bit  = bm->filled % UTIL_BITMASK_BITS_PER_WORD;
-   mask = 1 << bit;
-   while(word < bm->size / UTIL_BITMASK_BITS_PER_WORD) {
-      while(bit < UTIL_BITMASK_BITS_PER_WORD) {
-         if(!(bm->words[word] & mask))
-            goto found;
-         ++bm->filled;
-         ++bit;
-         mask <<= 1;
+   /* Scan whole words starting at the rotating hint, wrapping around,
+    * and let ffs find the free bit instead of testing one at a time.
+    */
+   for(i = 0; i < num_words; ++i) {
+      word = bm->free_word + i;
+      if(word >= num_words)
+         word -= num_words;
+
+      if(bm->words[word] != (util_bitmask_word)~0) {
+         bit = ffs(~bm->words[word]) - 1;
+         mask = (util_bitmask_word)1 << bit;
+         index = word * UTIL_BITMASK_BITS_PER_WORD + bit;
+
+         assert(!(bm->words[word] & mask));
+         bm->words[word] |= mask;
+         bm->free_word = word;
+
+         util_bitmask_filled_set(bm, index);
+         return index;
       }
-      ++word;
-      bit = 0;
-      mask = 1;
    }
-found:
 
-   /* grow the bitmask if necessary */
-   if(!util_bitmask_resize(bm, bm->filled))
+   /* completely full -- grow and take the first new bit */
+   index = bm->size;
+   if(!util_bitmask_resize(bm, index))
       return UTIL_BITMASK_INVALID_INDEX;
 
-   assert(!(bm->words[word] & mask));
-   bm->words[word] |= mask;
+   word = index / UTIL_BITMASK_BITS_PER_WORD;
+   bit  = index % UTIL_BITMASK_BITS_PER_WORD;
+
+   bm->words[word] |= (util_bitmask_word)1 << bit;
+   bm->free_word = word;
+
+   util_bitmask_filled_set(bm, index);
+   return index;
+}
+
+
+unsigned
+util_bitmask_add_block(struct util_bitmask *bm,
+                       unsigned count)
+{
+   unsigned num_words = bm->size / UTIL_BITMASK_BITS_PER_WORD;
+   unsigned start = 0;
+   unsigned run = 0;
+   unsigned word;
+   unsigned bit;
+   unsigned index;
 
-   return bm->filled++;
+   assert(bm);
+   assert(count);
+
+   if(count == 1)
+      return util_bitmask_add(bm);
+
+   /* Search from the start so blocks pack low; full and empty words are
+    * handled without looking at individual bits.
+    */
+   for(word = 0; word < num_words; ++word) {
+      util_bitmask_word w = bm->words[word];
+
+      if(w == 0) {
+         if(!run)
+            start = word * UTIL_BITMASK_BITS_PER_WORD;
+         run += UTIL_BITMASK_BITS_PER_WORD;
+      }
+      else if(w == (util_bitmask_word)~0) {
+         run = 0;
+      }
+      else {
+         for(bit = 0; bit < UTIL_BITMASK_BITS_PER_WORD; ++bit) {
+            if(w & ((util_bitmask_word)1 << bit))
+               run = 0;
+            else {
+               if(!run)
+                  start = word * UTIL_BITMASK_BITS_PER_WORD + bit;
+               ++run;
+               if(run == count)
+                  break;
+            }
+         }
+      }
+
+      if(run >= count)
+         break;
+   }
+
+   if(run < count) {
+      /* not enough room -- extend a trailing run past the current end */
+      if(!run)
+         start = bm->size;
+      if(!util_bitmask_resize(bm, start + count - 1))
+         return UTIL_BITMASK_INVALID_INDEX;
+   }
+
+   for(index = start; index < start + count; ++index) {
+      word = index / UTIL_BITMASK_BITS_PER_WORD;
+      bit  = index % UTIL_BITMASK_BITS_PER_WORD;
+
+      assert(!(bm->words[word] & ((util_bitmask_word)1 << bit)));
+      bm->words[word] |= (util_bitmask_word)1 << bit;
+
+      util_bitmask_filled_set(bm, index);
+   }
+
+   return start;
 }
 
 
@@ -276,10 +367,9 @@ util_bitmask_get_next_index(struct util_bitmask *bm,
 {
    unsigned word = index / UTIL_BITMASK_BITS_PER_WORD;
    unsigned bit  = index % UTIL_BITMASK_BITS_PER_WORD;
-   util_bitmask_word mask = 1 << bit;
 
    if(index < bm->filled) {
-      assert(bm->words[word] & mask);
+      assert(bm->words[word] & ((util_bitmask_word)1 << bit));
       return index;
    }
 
@@ -287,25 +377,22 @@ util_bitmask_get_next_index(struct util_bitmask *bm,
       return UTIL_BITMASK_INVALID_INDEX;
    }
 
-   /* Do a linear search */
+   /* Scan a word at a time, masking off the bits below the start */
    while(word < bm->size / UTIL_BITMASK_BITS_PER_WORD) {
-      while(bit < UTIL_BITMASK_BITS_PER_WORD) {
-         if(bm->words[word] & mask) {
-            if(index == bm->filled) {
-               ++bm->filled;
-               assert(bm->filled <= bm->size);
-            }
-            return index;
+      util_bitmask_word w = bm->words[word] & ((util_bitmask_word)~0 << bit);
+
+      if(w) {
+         index = word * UTIL_BITMASK_BITS_PER_WORD + ffs(w) - 1;
+         if(index == bm->filled) {
+            ++bm->filled;
+            assert(bm->filled <= bm->size);
          }
-         ++index;
-         ++bit;
-         mask <<= 1;
+         return index;
       }
       ++word;
       bit = 0;
-      mask = 1;
    }
-   
+
    return UTIL_BITMASK_INVALID_INDEX;
 }
 
@@ -59,15 +59,30 @@ util_bitmask_create(void);
 
 /**
  * Search a cleared bit and set it.
- * 
- * It searches for the first cleared bit.
- * 
- * Returns the bit index on success, or UTIL_BITMASK_INVALID_INDEX on out of 
+ *
+ * The search starts from a rotating hint, so indices are handed out
+ * round-robin rather than lowest-first and repeated adds don't rescan
+ * the densely set low words.
+ *
+ * Returns the bit index on success, or UTIL_BITMASK_INVALID_INDEX on out of
  * memory growing the bitmask.
  */
 unsigned
 util_bitmask_add(struct util_bitmask *bm);
 
+/**
+ * Search a run of count consecutive cleared bits and set them all.
+ *
+ * Unlike util_bitmask_add this searches lowest-first, so blocks pack
+ * towards the start of the bitmask.
+ *
+ * Returns the first bit index of the run on success, or
+ * UTIL_BITMASK_INVALID_INDEX on out of memory growing the bitmask.
+ */
+unsigned
+util_bitmask_add_block(struct util_bitmask *bm,
+                       unsigned count);
+
 /**
  * Set a bit.
  * 
@@ -82,10 +82,26 @@ struct util_cache
    /** Number of entries in the cache */
    unsigned count;
 
+   /** If non-zero, keys are copied into inline_keys on set */
+   size_t key_size;
+
+   /** Array [size] of key_size byte slots, parallel to entries */
+   char *inline_keys;
+
+   /** Direct-mapped front cache of recently hit entries, indexed by hash.
+    * Pointers in here may be stale (the entry may have been evicted or
+    * reused since), so they are re-validated against hash and key on every
+    * use; no explicit invalidation is needed.
+    */
+   struct util_cache_entry *front[16];
+
    /** Head of list, sorted from Least-recently used to Most-recently used */
    struct util_cache_entry lru;
 };
 
+#define CACHE_FRONT_INDEX(cache, hash) \
+   ((hash) & (ARRAY_SIZE((cache)->front) - 1))
+
 
 static void
 ensure_sanity(const struct util_cache *cache);
@@ -101,28 +117,57 @@ util_cache_create(uint32_t (*hash)(const void *key),
                   int (*compare)(const void *key1, const void *key2),
                   void (*destroy)(void *key, void *value),
                   uint32_t size)
+{
+   return util_cache_create_inline(hash, compare, destroy, size, 0);
+}
+
+
+/**
+ * Like util_cache_create, but keys are copied into per-entry storage.
+ * See u_cache.h for the ownership details.
+ */
+struct util_cache *
+util_cache_create_inline(uint32_t (*hash)(const void *key),
+                         int (*compare)(const void *key1, const void *key2),
+                         void (*destroy)(void *key, void *value),
+                         uint32_t size,
+                         size_t key_size)
 {
    struct util_cache *cache;
-   
+
+   assert(key_size <= UTIL_CACHE_INLINE_KEY_SIZE);
+   if (key_size > UTIL_CACHE_INLINE_KEY_SIZE)
+      return NULL;
+
    cache = CALLOC_STRUCT(util_cache);
    if (!cache)
       return NULL;
-   
+
    cache->hash = hash;
    cache->compare = compare;
    cache->destroy = destroy;
+   cache->key_size = key_size;
 
    make_empty_list(&cache->lru);
 
    size *= CACHE_DEFAULT_ALPHA;
    cache->size = size;
-   
+
    cache->entries = CALLOC(size, sizeof(struct util_cache_entry));
    if (!cache->entries) {
       FREE(cache);
       return NULL;
    }
-   
+
+   if (key_size) {
+      cache->inline_keys = CALLOC(size, key_size);
+      if (!cache->inline_keys) {
+         FREE(cache->entries);
+         FREE(cache);
+         return NULL;
+      }
+   }
+
    ensure_sanity(cache);
    return cache;
 }
@@ -213,18 +258,29 @@ util_cache_set(struct util_cache *cache,
       util_cache_entry_destroy(cache, cache->lru.prev);
 
    util_cache_entry_destroy(cache, entry);
-   
+
 #ifdef DEBUG
    ++entry->count;
 #endif
-   
-   entry->key = key;
+
+   if (cache->key_size) {
+      char *inline_key =
+         cache->inline_keys + (entry - cache->entries) * cache->key_size;
+
+      memcpy(inline_key, key, cache->key_size);
+      entry->key = inline_key;
+   }
+   else {
+      entry->key = key;
+   }
    entry->hash = hash;
    entry->value = value;
    entry->state = FILLED;
    insert_at_head(&cache->lru, entry);
    cache->count++;
 
+   cache->front[CACHE_FRONT_INDEX(cache, hash)] = entry;
+
    ensure_sanity(cache);
 }
 
@@ -244,13 +300,27 @@ util_cache_get(struct util_cache *cache,
    if (!cache)
       return NULL;
    hash = cache->hash(key);
-   entry = util_cache_entry_get(cache, hash, key);
-   if (!entry)
-      return NULL;
 
-   if (entry->state == FILLED)
+   /* Try the direct-mapped front cache before probing.  A hit means we
+    * skip the linear probe entirely; a stale or missing pointer just falls
+    * through to the normal lookup.
+    */
+   entry = cache->front[CACHE_FRONT_INDEX(cache, hash)];
+   if (!(entry &&
+         entry->state == FILLED &&
+         entry->hash == hash &&
+         cache->compare(key, entry->key) == 0)) {
+      entry = util_cache_entry_get(cache, hash, key);
+      if (!entry)
+         return NULL;
+
+      if (entry->state == FILLED)
+         cache->front[CACHE_FRONT_INDEX(cache, hash)] = entry;
+   }
+
+   if (entry->state == FILLED && cache->lru.next != entry)
       move_to_head(&cache->lru, entry);
-   
+
    return entry->value;
 }
 
@@ -305,7 +375,8 @@ util_cache_destroy(struct util_cache *cache)
 #endif
       
    util_cache_clear(cache);
-   
+
+   FREE(cache->inline_keys);
    FREE(cache->entries);
    FREE(cache);
 }
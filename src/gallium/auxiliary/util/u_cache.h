@@ -64,6 +64,25 @@ util_cache_create(uint32_t (*hash)(const void *key),
                   void (*destroy)(void *key, void *value),
                   uint32_t size);
 
+/** Maximum key size accepted by util_cache_create_inline */
+#define UTIL_CACHE_INLINE_KEY_SIZE 64
+
+/**
+ * Like util_cache_create, but keys of \p key_size bytes (at most
+ * UTIL_CACHE_INLINE_KEY_SIZE) are copied into storage owned by the cache
+ * on util_cache_set, so the caller's key buffer can live on the stack and
+ * key comparisons don't chase a pointer to a separate allocation.
+ *
+ * The 'destroy' callback is passed the cache's copy of the key, which it
+ * must not free.
+ */
+struct util_cache *
+util_cache_create_inline(uint32_t (*hash)(const void *key),
+                         int (*compare)(const void *key1, const void *key2),
+                         void (*destroy)(void *key, void *value),
+                         uint32_t size,
+                         size_t key_size);
+
 void
 util_cache_set(struct util_cache *cache,
                void *key,
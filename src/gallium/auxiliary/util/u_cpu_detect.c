@@ -34,8 +34,10 @@
 
 #include "pipe/p_config.h"
 
+#include "os/os_thread.h"
 #include "u_debug.h"
 #include "u_cpu_detect.h"
+#include "u_memcpy.h"
 
 #if defined(PIPE_ARCH_PPC)
 #if defined(PIPE_OS_APPLE)
@@ -292,16 +294,96 @@ PIPE_ALIGN_STACK static inline boolean sse2_has_daz(void)
 }
 #endif
 
-#endif /* X86 or X86_64 */
 
-void
-util_cpu_detect(void)
+/**
+ * Fill in the cache hierarchy sizes, using the Intel deterministic cache
+ * parameters leaf when it exists and the AMD extended leaves otherwise.
+ */
+static void
+detect_caches(uint32_t max_basic, uint32_t max_ext)
 {
-   static boolean util_cpu_detect_initialized = FALSE;
-
-   if(util_cpu_detect_initialized)
+   uint32_t regs[4];
+
+   if (util_cpu_caps.has_intel && max_basic >= 0x00000004) {
+      unsigned i;
+
+      for (i = 0; i < 32; i++) {
+         unsigned type, level, size;
+
+         cpuid_count(0x00000004, i, regs);
+
+         type = regs[0] & 0x1f;
+         if (!type)
+            break;
+         /* data (1) and unified (3) caches only */
+         if (type != 1 && type != 3)
+            continue;
+
+         level = (regs[0] >> 5) & 0x7;
+         size = (((regs[1] >> 22) & 0x3ff) + 1) * /* ways */
+                (((regs[1] >> 12) & 0x3ff) + 1) * /* partitions */
+                ((regs[1] & 0xfff) + 1) *         /* line size */
+                (regs[2] + 1);                    /* sets */
+
+         if (level == 1)
+            util_cpu_caps.l1d_cache = size;
+         else if (level == 2)
+            util_cpu_caps.l2_cache = size;
+         else if (level == 3)
+            util_cpu_caps.l3_cache = size;
+      }
       return;
+   }
 
+   if (max_ext >= 0x80000005) {
+      cpuid(0x80000005, regs);
+      util_cpu_caps.l1d_cache = ((regs[2] >> 24) & 0xff) * 1024;
+   }
+   if (max_ext >= 0x80000006) {
+      cpuid(0x80000006, regs);
+      util_cpu_caps.l2_cache = ((regs[2] >> 16) & 0xffff) * 1024;
+      util_cpu_caps.l3_cache = ((regs[3] >> 18) & 0x3fff) * 512 * 1024;
+   }
+}
+
+
+/**
+ * Work out the physical core count by dividing the SMT sibling count out
+ * of nr_cpus.  Best effort: on failure nr_cores stays at nr_cpus.
+ */
+static void
+detect_topology(uint32_t max_basic, uint32_t max_ext)
+{
+   uint32_t regs[4];
+   unsigned threads_per_core = 1;
+
+   if (util_cpu_caps.has_intel && max_basic >= 0x0000000b) {
+      /* Leaf 0xB level 0 is the SMT level; EBX is the number of logical
+       * processors sharing a core.
+       */
+      cpuid_count(0x0000000b, 0, regs);
+      threads_per_core = regs[1] & 0xffff;
+   } else if (!util_cpu_caps.has_intel && max_ext >= 0x8000001e) {
+      cpuid(0x8000001e, regs);
+      threads_per_core = ((regs[1] >> 8) & 0xff) + 1;
+   }
+
+   if (threads_per_core > 1 &&
+       util_cpu_caps.nr_cpus > threads_per_core &&
+       util_cpu_caps.nr_cpus % threads_per_core == 0)
+      util_cpu_caps.nr_cores = util_cpu_caps.nr_cpus / threads_per_core;
+}
+
+#endif /* X86 or X86_64 */
+
+static boolean util_cpu_detect_initialized = FALSE;
+
+pipe_static_mutex(cpu_detect_mutex);
+
+
+static void
+util_cpu_detect_once(void)
+{
    memset(&util_cpu_caps, 0, sizeof util_cpu_caps);
 
    /* Count the number of CPUs in system */
@@ -331,6 +413,9 @@ util_cpu_detect(void)
    util_cpu_caps.nr_cpus = 1;
 #endif
 
+   /* Until proven otherwise every logical CPU is its own core. */
+   util_cpu_caps.nr_cores = util_cpu_caps.nr_cpus;
+
    /* Make the fallback cacheline size nonzero so that it can be
     * safely passed to align().
     */
@@ -340,11 +425,13 @@ util_cpu_detect(void)
    if (has_cpuid()) {
       uint32_t regs[4];
       uint32_t regs2[4];
+      uint32_t max_basic;
 
       util_cpu_caps.cacheline = 32;
 
       /* Get max cpuid level */
       cpuid(0x00000000, regs);
+      max_basic = regs[0];
 
       if (regs[0] >= 0x00000001) {
          unsigned int cacheline;
@@ -385,6 +472,16 @@ util_cpu_detect(void)
          uint32_t regs7[4];
          cpuid_count(0x00000007, 0x00000000, regs7);
          util_cpu_caps.has_avx2 = (regs7[1] >> 5) & 1;
+
+         /* AVX-512 additionally requires the OS to save/restore the opmask
+          * and upper ZMM state (XCR0 bits 5-7).
+          */
+         if ((xgetbv() & 0xe6) == 0xe6) {
+            util_cpu_caps.has_avx512f  = (regs7[1] >> 16) & 1;
+            util_cpu_caps.has_avx512dq = (regs7[1] >> 17) & 1;
+            util_cpu_caps.has_avx512bw = (regs7[1] >> 30) & 1;
+            util_cpu_caps.has_avx512vl = (regs7[1] >> 31) & 1;
+         }
       }
 
       if (regs[1] == 0x756e6547 && regs[2] == 0x6c65746e && regs[3] == 0x49656e69) {
@@ -416,6 +513,9 @@ util_cpu_detect(void)
             util_cpu_caps.cacheline = cacheline;
       }
 
+      detect_caches(max_basic, regs[0]);
+      detect_topology(max_basic, regs[0]);
+
       if (!util_cpu_caps.has_sse) {
          util_cpu_caps.has_sse2 = 0;
          util_cpu_caps.has_sse3 = 0;
@@ -429,12 +529,40 @@ util_cpu_detect(void)
    check_os_altivec_support();
 #endif /* PIPE_ARCH_PPC */
 
+   /* Preferred SIMD width: the widest unit the CPU executes at full rate. */
+   if (util_cpu_caps.has_avx512f)
+      util_cpu_caps.vector_width = 64;
+   else if (util_cpu_caps.has_avx)
+      util_cpu_caps.vector_width = 32;
+   else if (util_cpu_caps.has_sse || util_cpu_caps.has_altivec)
+      util_cpu_caps.vector_width = 16;
+   else
+      util_cpu_caps.vector_width = sizeof(void *);
+
+   /* A copy bigger than half the last-level cache can't stay resident, so
+    * past that point non-temporal stores stop costing and start saving.
+    */
+   if (util_cpu_caps.l3_cache)
+      util_cpu_caps.streaming_threshold = util_cpu_caps.l3_cache / 2;
+   else if (util_cpu_caps.l2_cache)
+      util_cpu_caps.streaming_threshold = util_cpu_caps.l2_cache / 2;
+   else
+      util_cpu_caps.streaming_threshold = UTIL_STREAMING_MEMCPY_THRESHOLD;
+
 #ifdef DEBUG
    if (debug_get_option_dump_cpu()) {
       debug_printf("util_cpu_caps.nr_cpus = %u\n", util_cpu_caps.nr_cpus);
+      debug_printf("util_cpu_caps.nr_cores = %u\n", util_cpu_caps.nr_cores);
 
       debug_printf("util_cpu_caps.x86_cpu_type = %u\n", util_cpu_caps.x86_cpu_type);
       debug_printf("util_cpu_caps.cacheline = %u\n", util_cpu_caps.cacheline);
+      debug_printf("util_cpu_caps.l1d_cache = %u\n", util_cpu_caps.l1d_cache);
+      debug_printf("util_cpu_caps.l2_cache = %u\n", util_cpu_caps.l2_cache);
+      debug_printf("util_cpu_caps.l3_cache = %u\n", util_cpu_caps.l3_cache);
+      debug_printf("util_cpu_caps.streaming_threshold = %u\n",
+                   util_cpu_caps.streaming_threshold);
+      debug_printf("util_cpu_caps.vector_width = %u\n",
+                   util_cpu_caps.vector_width);
 
       debug_printf("util_cpu_caps.has_tsc = %u\n", util_cpu_caps.has_tsc);
       debug_printf("util_cpu_caps.has_mmx = %u\n", util_cpu_caps.has_mmx);
@@ -448,6 +576,10 @@ util_cpu_detect(void)
       debug_printf("util_cpu_caps.has_avx = %u\n", util_cpu_caps.has_avx);
       debug_printf("util_cpu_caps.has_avx2 = %u\n", util_cpu_caps.has_avx2);
       debug_printf("util_cpu_caps.has_f16c = %u\n", util_cpu_caps.has_f16c);
+      debug_printf("util_cpu_caps.has_avx512f = %u\n", util_cpu_caps.has_avx512f);
+      debug_printf("util_cpu_caps.has_avx512dq = %u\n", util_cpu_caps.has_avx512dq);
+      debug_printf("util_cpu_caps.has_avx512bw = %u\n", util_cpu_caps.has_avx512bw);
+      debug_printf("util_cpu_caps.has_avx512vl = %u\n", util_cpu_caps.has_avx512vl);
       debug_printf("util_cpu_caps.has_popcnt = %u\n", util_cpu_caps.has_popcnt);
       debug_printf("util_cpu_caps.has_3dnow = %u\n", util_cpu_caps.has_3dnow);
       debug_printf("util_cpu_caps.has_3dnow_ext = %u\n", util_cpu_caps.has_3dnow_ext);
@@ -456,6 +588,24 @@ util_cpu_detect(void)
       debug_printf("util_cpu_caps.has_daz = %u\n", util_cpu_caps.has_daz);
    }
 #endif
+}
+
+
+void
+util_cpu_detect(void)
+{
+   /* Detection only ever runs once per process; with screen setup now done
+    * lazily this can race between contexts created on different threads.
+    */
+   if (util_cpu_detect_initialized)
+      return;
+
+   pipe_mutex_lock(cpu_detect_mutex);
+
+   if (!util_cpu_detect_initialized) {
+      util_cpu_detect_once();
+      util_cpu_detect_initialized = TRUE;
+   }
 
-   util_cpu_detect_initialized = TRUE;
+   pipe_mutex_unlock(cpu_detect_mutex);
 }
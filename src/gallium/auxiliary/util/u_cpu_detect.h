@@ -47,11 +47,21 @@ extern "C" {
 
 struct util_cpu_caps {
    unsigned nr_cpus;
+   unsigned nr_cores;   /**< physical cores; nr_cpus counts SMT siblings */
 
    /* Feature flags */
    int x86_cpu_type;
    unsigned cacheline;
 
+   /* Cache hierarchy in bytes, 0 when unknown */
+   unsigned l1d_cache;
+   unsigned l2_cache;
+   unsigned l3_cache;   /**< the shared last-level cache */
+
+   /* Tuning parameters derived from the above */
+   unsigned streaming_threshold;  /**< copies >= this want non-temporal stores */
+   unsigned vector_width;         /**< preferred SIMD width in bytes */
+
    unsigned has_intel:1;
    unsigned has_tsc:1;
    unsigned has_mmx:1;
@@ -66,6 +76,10 @@ struct util_cpu_caps {
    unsigned has_avx:1;
    unsigned has_avx2:1;
    unsigned has_f16c:1;
+   unsigned has_avx512f:1;
+   unsigned has_avx512dq:1;
+   unsigned has_avx512bw:1;
+   unsigned has_avx512vl:1;
    unsigned has_3dnow:1;
    unsigned has_3dnow_ext:1;
    unsigned has_xop:1;
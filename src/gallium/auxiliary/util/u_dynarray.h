@@ -34,31 +34,73 @@
  * empty array.
  *
  * Also, size <= capacity and data != 0 if and only if capacity != 0
- * capacity will always be the allocation size of data
+ * capacity will always be the allocation size of data, unless the storage
+ * is external (caller-provided), in which case it is its size
  */
 struct util_dynarray
 {
    void *data;
    unsigned size;
    unsigned capacity;
+   boolean external; /* caller-provided storage, don't free or realloc it */
 };
 
+/* Don't bother with allocations smaller than this; a few growing arrays
+ * cost some slack, but the first appends stop going through realloc one
+ * element at a time.
+ */
+#define UTIL_DYNARRAY_MIN_ALLOC 64
+
 static inline void
 util_dynarray_init(struct util_dynarray *buf)
 {
    memset(buf, 0, sizeof(*buf));
 }
 
+/* Start out in caller-provided storage, typically an array on the stack or
+ * embedded in a longer-lived structure.  The contents move to the heap only
+ * if the array outgrows it, so arrays that stay small never allocate.
+ */
+static inline void
+util_dynarray_init_with_storage(struct util_dynarray *buf,
+                                void *storage, unsigned capacity)
+{
+   buf->data = storage;
+   buf->size = 0;
+   buf->capacity = capacity;
+   buf->external = TRUE;
+}
+
 static inline void
 util_dynarray_fini(struct util_dynarray *buf)
 {
    if(buf->data)
    {
-      FREE(buf->data);
+      if(!buf->external)
+         FREE(buf->data);
       util_dynarray_init(buf);
    }
 }
 
+/* Grow the allocation to hold at least newcap bytes, without touching size */
+static inline void
+util_dynarray_reserve(struct util_dynarray *buf, unsigned newcap)
+{
+   if(newcap > buf->capacity)
+   {
+      if(buf->external)
+      {
+         void *heap = MALLOC(newcap);
+         memcpy(heap, buf->data, buf->size);
+         buf->data = heap;
+         buf->external = FALSE;
+      }
+      else
+         buf->data = REALLOC(buf->data, buf->capacity, newcap);
+      buf->capacity = newcap;
+   }
+}
+
 /* use util_dynarray_trim to reduce the allocated storage */
 static inline void *
 util_dynarray_resize(struct util_dynarray *buf, unsigned newsize)
@@ -67,10 +109,11 @@ util_dynarray_resize(struct util_dynarray *buf, unsigned newsize)
    if(newsize > buf->capacity)
    {
       unsigned newcap = buf->capacity << 1;
+      if(newcap < UTIL_DYNARRAY_MIN_ALLOC)
+	      newcap = UTIL_DYNARRAY_MIN_ALLOC;
       if(newsize > newcap)
 	      newcap = newsize;
-      buf->data = REALLOC(buf->data, buf->capacity, newcap);
-      buf->capacity = newcap;
+      util_dynarray_reserve(buf, newcap);
    }
 
    p = (char *)buf->data + buf->size;
@@ -87,7 +130,7 @@ util_dynarray_grow(struct util_dynarray *buf, int diff)
 static inline void
 util_dynarray_trim(struct util_dynarray *buf)
 {
-   if (buf->size != buf->capacity) {
+   if (buf->size != buf->capacity && !buf->external) {
       if (buf->size) {
          buf->data = REALLOC(buf->data, buf->capacity, buf->size);
          buf->capacity = buf->size;
@@ -611,6 +611,27 @@ def generate_pack_kernel(format, src_channel, src_native_type):
         print_channels(format, pack_into_union)
 
 
+# 8888 unorm formats that are plain byte permutations of R8G8B8A8, handled
+# by the SIMD row kernels in u_format_simd.c
+SIMD_8UNORM_UNPACK_FORMATS = [
+    'PIPE_FORMAT_R8G8B8A8_UNORM',
+    'PIPE_FORMAT_B8G8R8A8_UNORM',
+    'PIPE_FORMAT_A8R8G8B8_UNORM',
+    'PIPE_FORMAT_A8B8G8R8_UNORM',
+    'PIPE_FORMAT_R8G8B8X8_UNORM',
+    'PIPE_FORMAT_B8G8R8X8_UNORM',
+    'PIPE_FORMAT_X8R8G8B8_UNORM',
+    'PIPE_FORMAT_X8B8G8R8_UNORM',
+]
+
+SIMD_8UNORM_PACK_FORMATS = [
+    'PIPE_FORMAT_R8G8B8A8_UNORM',
+    'PIPE_FORMAT_B8G8R8A8_UNORM',
+    'PIPE_FORMAT_A8R8G8B8_UNORM',
+    'PIPE_FORMAT_A8B8G8R8_UNORM',
+]
+
+
 def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
     '''Generate the function to unpack pixels from a particular format'''
 
@@ -622,6 +643,9 @@ def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
 
     if is_format_supported(format):
         print '   unsigned x, y;'
+        if dst_suffix == 'rgba_8unorm' and format.name in SIMD_8UNORM_UNPACK_FORMATS:
+            print '   if (util_format_simd_unpack_rgba_8unorm(%s, dst_row, dst_stride, src_row, src_stride, width, height))' % format.name
+            print '      return;'
         print '   for(y = 0; y < height; y += %u) {' % (format.block_height,)
         print '      %s *dst = dst_row;' % (dst_native_type)
         print '      const uint8_t *src = src_row;'
@@ -648,9 +672,12 @@ def generate_format_pack(format, src_channel, src_native_type, src_suffix):
     print 'static inline void'
     print 'util_format_%s_pack_%s(uint8_t *dst_row, unsigned dst_stride, const %s *src_row, unsigned src_stride, unsigned width, unsigned height)' % (name, src_suffix, src_native_type)
     print '{'
-    
+
     if is_format_supported(format):
         print '   unsigned x, y;'
+        if src_suffix == 'rgba_8unorm' and format.name in SIMD_8UNORM_PACK_FORMATS:
+            print '   if (util_format_simd_pack_rgba_8unorm(%s, dst_row, dst_stride, src_row, src_stride, width, height))' % format.name
+            print '      return;'
         print '   for(y = 0; y < height; y += %u) {' % (format.block_height,)
         print '      const %s *src = src_row;' % (src_native_type)
         print '      uint8_t *dst = dst_row;'
@@ -696,6 +723,7 @@ def generate(formats):
     print '#include "u_half.h"'
     print '#include "u_format.h"'
     print '#include "u_format_other.h"'
+    print '#include "u_format_simd.h"'
     print '#include "util/format_srgb.h"'
     print '#include "u_format_yuv.h"'
     print '#include "u_format_zs.h"'
@@ -0,0 +1,232 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * SIMD row kernels for byte-permutation pixel formats.
+ *
+ * The generated u_format_table.c unpack/pack accessors convert one pixel
+ * at a time.  For the 8888 unorm formats that are plain byte permutations
+ * of R8G8B8A8 the whole row is just shifts and masks, so do four pixels
+ * per iteration with SSE2 and let the generated functions try this first.
+ */
+
+#include <string.h>
+
+#include "util/u_format_simd.h"
+
+#if defined(PIPE_ARCH_SSE) && defined(PIPE_ARCH_LITTLE_ENDIAN)
+
+#include <emmintrin.h>
+
+/* Byte permutations within a 32bpp pixel, named after the uint32 operation
+ * on a little-endian pixel.
+ */
+enum perm_8888 {
+   PERM_COPY,    /* dst = src */
+   PERM_SWAP_02, /* swap bytes 0 and 2: B8G8R8A8 <-> R8G8B8A8 */
+   PERM_ROR8,    /* rotate right one byte: A8R8G8B8 -> R8G8B8A8 */
+   PERM_ROL8,    /* rotate left one byte: R8G8B8A8 -> A8R8G8B8 */
+   PERM_REVERSE  /* reverse all four bytes: A8B8G8R8 <-> R8G8B8A8 */
+};
+
+static inline uint32_t
+permute_8888_scalar(uint32_t v, enum perm_8888 perm)
+{
+   switch (perm) {
+   case PERM_SWAP_02:
+      return (v & 0xff00ff00) | ((v >> 16) & 0xff) | ((v & 0xff) << 16);
+   case PERM_ROR8:
+      return (v >> 8) | (v << 24);
+   case PERM_ROL8:
+      return (v << 8) | (v >> 24);
+   case PERM_REVERSE:
+      v = (v << 16) | (v >> 16);
+      return ((v & 0xff00ff00) >> 8) | ((v & 0x00ff00ff) << 8);
+   default:
+      return v;
+   }
+}
+
+static inline __m128i
+permute_8888_sse(__m128i v, enum perm_8888 perm)
+{
+   switch (perm) {
+   case PERM_SWAP_02: {
+      const __m128i mask_13 = _mm_set1_epi32(0xff00ff00);
+      const __m128i rb = _mm_andnot_si128(mask_13, v);
+      return _mm_or_si128(_mm_and_si128(v, mask_13),
+                          _mm_or_si128(_mm_slli_epi32(rb, 16),
+                                       _mm_srli_epi32(rb, 16)));
+   }
+   case PERM_ROR8:
+      return _mm_or_si128(_mm_srli_epi32(v, 8), _mm_slli_epi32(v, 24));
+   case PERM_ROL8:
+      return _mm_or_si128(_mm_slli_epi32(v, 8), _mm_srli_epi32(v, 24));
+   case PERM_REVERSE:
+      v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+      return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+   default:
+      return v;
+   }
+}
+
+/**
+ * Permute a whole rect of 32bpp pixels, optionally ORing in a constant
+ * (used to force the alpha byte to 0xff when expanding X8 formats).
+ */
+static void
+permute_8888_rect(uint8_t *dst_row, unsigned dst_stride,
+                  const uint8_t *src_row, unsigned src_stride,
+                  unsigned width, unsigned height,
+                  enum perm_8888 perm, uint32_t or_mask)
+{
+   const __m128i simd_or_mask = _mm_set1_epi32(or_mask);
+   unsigned x, y;
+
+   for (y = 0; y < height; y++) {
+      const uint8_t *src = src_row;
+      uint8_t *dst = dst_row;
+
+      for (x = 0; x + 4 <= width; x += 4) {
+         __m128i v = _mm_loadu_si128((const __m128i *)(src + x * 4));
+         v = _mm_or_si128(permute_8888_sse(v, perm), simd_or_mask);
+         _mm_storeu_si128((__m128i *)(dst + x * 4), v);
+      }
+
+      for (; x < width; x++) {
+         uint32_t v;
+         memcpy(&v, src + x * 4, 4);
+         v = permute_8888_scalar(v, perm) | or_mask;
+         memcpy(dst + x * 4, &v, 4);
+      }
+
+      src_row += src_stride;
+      dst_row += dst_stride;
+   }
+}
+
+boolean
+util_format_simd_unpack_rgba_8unorm(enum pipe_format format,
+                                    uint8_t *dst_row, unsigned dst_stride,
+                                    const uint8_t *src_row,
+                                    unsigned src_stride,
+                                    unsigned width, unsigned height)
+{
+   switch (format) {
+   case PIPE_FORMAT_R8G8B8A8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_COPY, 0);
+      return TRUE;
+   case PIPE_FORMAT_B8G8R8A8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_SWAP_02, 0);
+      return TRUE;
+   case PIPE_FORMAT_A8R8G8B8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_ROR8, 0);
+      return TRUE;
+   case PIPE_FORMAT_A8B8G8R8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_REVERSE, 0);
+      return TRUE;
+   case PIPE_FORMAT_R8G8B8X8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_COPY, 0xff000000);
+      return TRUE;
+   case PIPE_FORMAT_B8G8R8X8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_SWAP_02, 0xff000000);
+      return TRUE;
+   case PIPE_FORMAT_X8R8G8B8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_ROR8, 0xff000000);
+      return TRUE;
+   case PIPE_FORMAT_X8B8G8R8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_REVERSE, 0xff000000);
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+boolean
+util_format_simd_pack_rgba_8unorm(enum pipe_format format,
+                                  uint8_t *dst_row, unsigned dst_stride,
+                                  const uint8_t *src_row,
+                                  unsigned src_stride,
+                                  unsigned width, unsigned height)
+{
+   /* The X8 formats are left to the scalar path, which clears the
+    * undefined byte instead of leaving source alpha in it.
+    */
+   switch (format) {
+   case PIPE_FORMAT_R8G8B8A8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_COPY, 0);
+      return TRUE;
+   case PIPE_FORMAT_B8G8R8A8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_SWAP_02, 0);
+      return TRUE;
+   case PIPE_FORMAT_A8R8G8B8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_ROL8, 0);
+      return TRUE;
+   case PIPE_FORMAT_A8B8G8R8_UNORM:
+      permute_8888_rect(dst_row, dst_stride, src_row, src_stride,
+                        width, height, PERM_REVERSE, 0);
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+#else /* !(PIPE_ARCH_SSE && PIPE_ARCH_LITTLE_ENDIAN) */
+
+boolean
+util_format_simd_unpack_rgba_8unorm(enum pipe_format format,
+                                    uint8_t *dst_row, unsigned dst_stride,
+                                    const uint8_t *src_row,
+                                    unsigned src_stride,
+                                    unsigned width, unsigned height)
+{
+   return FALSE;
+}
+
+boolean
+util_format_simd_pack_rgba_8unorm(enum pipe_format format,
+                                  uint8_t *dst_row, unsigned dst_stride,
+                                  const uint8_t *src_row,
+                                  unsigned src_stride,
+                                  unsigned width, unsigned height)
+{
+   return FALSE;
+}
+
+#endif /* !(PIPE_ARCH_SSE && PIPE_ARCH_LITTLE_ENDIAN) */
@@ -0,0 +1,65 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#ifndef U_FORMAT_SIMD_H_
+#define U_FORMAT_SIMD_H_
+
+#include "pipe/p_compiler.h"
+#include "pipe/p_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * SIMD row kernels for the 8-bit formats that are plain byte permutations
+ * of R8G8B8A8_UNORM.  The generated u_format_table.c accessors try these
+ * before falling back to their scalar per-pixel loops.
+ *
+ * Both return FALSE when the format isn't handled (non-SSE builds handle
+ * nothing), in which case the caller must do the conversion itself.
+ */
+
+boolean
+util_format_simd_unpack_rgba_8unorm(enum pipe_format format,
+                                    uint8_t *dst_row, unsigned dst_stride,
+                                    const uint8_t *src_row,
+                                    unsigned src_stride,
+                                    unsigned width, unsigned height);
+
+boolean
+util_format_simd_pack_rgba_8unorm(enum pipe_format format,
+                                  uint8_t *dst_row, unsigned dst_stride,
+                                  const uint8_t *src_row,
+                                  unsigned src_stride,
+                                  unsigned width, unsigned height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_FORMAT_SIMD_H_ */
@@ -0,0 +1,304 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#include "util/u_gpu_markers.h"
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "util/u_debug.h"
+#include "util/u_hash_table.h"
+#include "util/u_memory.h"
+
+/* maximum nesting of scopes, deeper pushes are counted but not timed */
+#define UTIL_GPU_MARKER_MAX_DEPTH 64
+
+/* maximum number of in-flight scopes, more are silently dropped */
+#define UTIL_GPU_MARKER_MAX_PENDING 1024
+
+/* reused timestamp queries, to avoid create/destroy per scope */
+#define UTIL_GPU_MARKER_MAX_FREE 64
+
+struct util_gpu_marker
+{
+   char *name;
+   uint64_t time; /* ns accumulated in the current frame */
+   uint64_t last_time; /* total from the last completed frame */
+   unsigned num_scopes; /* scopes retired in the current frame */
+   struct util_gpu_marker *next; /* list of all markers */
+};
+
+struct util_gpu_marker_scope
+{
+   struct util_gpu_marker *marker;
+   struct pipe_query *begin;
+};
+
+struct util_gpu_marker_pending
+{
+   struct util_gpu_marker *marker;
+   struct pipe_query *begin, *end;
+};
+
+struct util_gpu_markers
+{
+   struct pipe_context *pipe;
+   struct util_hash_table *names; /* name -> util_gpu_marker */
+   struct util_gpu_marker *markers;
+   boolean print; /* dump the aggregates to stderr each frame */
+
+   struct util_gpu_marker_scope stack[UTIL_GPU_MARKER_MAX_DEPTH];
+   unsigned depth;
+
+   /* ring of scopes waiting for their queries to complete */
+   struct util_gpu_marker_pending pending[UTIL_GPU_MARKER_MAX_PENDING];
+   unsigned head, tail; /* monotonic, in units of scopes */
+
+   struct pipe_query *free_queries[UTIL_GPU_MARKER_MAX_FREE];
+   unsigned num_free;
+};
+
+static unsigned
+name_hash(void *key)
+{
+   const char *str = key;
+   unsigned hash = 5381;
+   while (*str)
+      hash = hash * 33 + *str++;
+   return hash;
+}
+
+static int
+name_compare(void *key1, void *key2)
+{
+   return strcmp(key1, key2);
+}
+
+struct util_gpu_markers *
+util_gpu_markers_create(struct pipe_context *pipe)
+{
+   struct util_gpu_markers *gm;
+
+   if (!pipe->screen->get_param(pipe->screen, PIPE_CAP_QUERY_TIMESTAMP))
+      return NULL;
+
+   gm = CALLOC_STRUCT(util_gpu_markers);
+   if (!gm)
+      return NULL;
+
+   gm->names = util_hash_table_create(name_hash, name_compare);
+   if (!gm->names) {
+      FREE(gm);
+      return NULL;
+   }
+
+   gm->pipe = pipe;
+   gm->print = debug_get_bool_option("GALLIUM_GPU_MARKERS_PRINT", FALSE);
+   return gm;
+}
+
+void
+util_gpu_markers_destroy(struct util_gpu_markers *gm)
+{
+   struct pipe_context *pipe = gm->pipe;
+   struct util_gpu_marker *marker, *next;
+   unsigned i;
+
+   for (i = gm->tail; i != gm->head; i++) {
+      struct util_gpu_marker_pending *pending =
+         &gm->pending[i % UTIL_GPU_MARKER_MAX_PENDING];
+
+      pipe->destroy_query(pipe, pending->begin);
+      pipe->destroy_query(pipe, pending->end);
+   }
+
+   for (i = 0; i < gm->depth && i < UTIL_GPU_MARKER_MAX_DEPTH; i++) {
+      if (gm->stack[i].begin)
+         pipe->destroy_query(pipe, gm->stack[i].begin);
+   }
+
+   for (i = 0; i < gm->num_free; i++)
+      pipe->destroy_query(pipe, gm->free_queries[i]);
+
+   for (marker = gm->markers; marker; marker = next) {
+      next = marker->next;
+      FREE(marker->name);
+      FREE(marker);
+   }
+
+   util_hash_table_destroy(gm->names);
+   FREE(gm);
+}
+
+/**
+ * Emit a timestamp query, reusing a retired one if possible.
+ */
+static struct pipe_query *
+get_timestamp(struct util_gpu_markers *gm)
+{
+   struct pipe_context *pipe = gm->pipe;
+   struct pipe_query *query;
+
+   if (gm->num_free)
+      query = gm->free_queries[--gm->num_free];
+   else
+      query = pipe->create_query(pipe, PIPE_QUERY_TIMESTAMP, 0);
+
+   if (query)
+      pipe->end_query(pipe, query);
+   return query;
+}
+
+static void
+put_query(struct util_gpu_markers *gm, struct pipe_query *query)
+{
+   if (gm->num_free < UTIL_GPU_MARKER_MAX_FREE)
+      gm->free_queries[gm->num_free++] = query;
+   else
+      gm->pipe->destroy_query(gm->pipe, query);
+}
+
+static struct util_gpu_marker *
+get_marker(struct util_gpu_markers *gm, const char *name)
+{
+   struct util_gpu_marker *marker = util_hash_table_get(gm->names,
+                                                        (void *)name);
+   if (marker)
+      return marker;
+
+   marker = CALLOC_STRUCT(util_gpu_marker);
+   if (!marker)
+      return NULL;
+
+   marker->name = MALLOC(strlen(name) + 1);
+   if (marker->name)
+      strcpy(marker->name, name);
+   if (!marker->name ||
+       util_hash_table_set(gm->names, marker->name, marker) != PIPE_OK) {
+      FREE(marker->name);
+      FREE(marker);
+      return NULL;
+   }
+
+   marker->next = gm->markers;
+   gm->markers = marker;
+   return marker;
+}
+
+void
+util_gpu_markers_push(struct util_gpu_markers *gm, const char *name)
+{
+   struct util_gpu_marker_scope *scope;
+
+   if (gm->depth >= UTIL_GPU_MARKER_MAX_DEPTH ||
+       gm->head - gm->tail >= UTIL_GPU_MARKER_MAX_PENDING) {
+      /* too deep or too many in flight, count the push but don't time it */
+      gm->depth++;
+      return;
+   }
+
+   scope = &gm->stack[gm->depth];
+   scope->marker = get_marker(gm, name);
+   scope->begin = scope->marker ? get_timestamp(gm) : NULL;
+   gm->depth++;
+}
+
+void
+util_gpu_markers_pop(struct util_gpu_markers *gm)
+{
+   struct util_gpu_marker_scope *scope;
+   struct util_gpu_marker_pending *pending;
+   struct pipe_query *end;
+
+   if (!gm->depth)
+      return;
+
+   gm->depth--;
+   if (gm->depth >= UTIL_GPU_MARKER_MAX_DEPTH)
+      return;
+
+   scope = &gm->stack[gm->depth];
+   if (!scope->begin)
+      return;
+
+   end = gm->head - gm->tail < UTIL_GPU_MARKER_MAX_PENDING ?
+            get_timestamp(gm) : NULL;
+   if (!end) {
+      put_query(gm, scope->begin);
+      return;
+   }
+
+   pending = &gm->pending[gm->head++ % UTIL_GPU_MARKER_MAX_PENDING];
+   pending->marker = scope->marker;
+   pending->begin = scope->begin;
+   pending->end = end;
+}
+
+void
+util_gpu_markers_end_frame(struct util_gpu_markers *gm)
+{
+   struct pipe_context *pipe = gm->pipe;
+   struct util_gpu_marker *marker;
+
+   while (gm->tail != gm->head) {
+      struct util_gpu_marker_pending *pending =
+         &gm->pending[gm->tail % UTIL_GPU_MARKER_MAX_PENDING];
+      union pipe_query_result begin, end;
+
+      /* the begin timestamp was emitted first, so checking the end first
+       * avoids a second potentially unfinished lookup */
+      if (!pipe->get_query_result(pipe, pending->end, FALSE, &end))
+         break;
+      pipe->get_query_result(pipe, pending->begin, TRUE, &begin);
+
+      if (pending->marker) {
+         pending->marker->time += end.u64 - begin.u64;
+         pending->marker->num_scopes++;
+      }
+
+      put_query(gm, pending->begin);
+      put_query(gm, pending->end);
+      gm->tail++;
+   }
+
+   for (marker = gm->markers; marker; marker = marker->next) {
+      if (gm->print && marker->num_scopes) {
+         fprintf(stderr, "gpu markers: %-40s %8.3f ms (%u scopes)\n",
+                 marker->name, marker->time / (1000.0 * 1000.0),
+                 marker->num_scopes);
+      }
+      marker->last_time = marker->time;
+      marker->time = 0;
+      marker->num_scopes = 0;
+   }
+}
+
+uint64_t
+util_gpu_markers_get_time(struct util_gpu_markers *gm, const char *name)
+{
+   struct util_gpu_marker *marker = util_hash_table_get(gm->names,
+                                                        (void *)name);
+   return marker ? marker->last_time : 0;
+}
@@ -0,0 +1,88 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Scoped GPU time markers.
+ *
+ * Attributes GPU time to application-provided marker names using batched
+ * PIPE_QUERY_TIMESTAMP queries.  Scopes may nest; the time of a nested scope
+ * is counted towards every enclosing marker.  Results are aggregated per
+ * marker name and rotated once per frame, so profiling doesn't require
+ * serializing the pipeline with glFinish.
+ */
+
+#ifndef U_GPU_MARKERS_H
+#define U_GPU_MARKERS_H
+
+#include "pipe/p_compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct pipe_context;
+struct util_gpu_markers;
+
+/**
+ * Create a marker context, returns NULL if the driver doesn't support
+ * timestamp queries.
+ */
+struct util_gpu_markers *
+util_gpu_markers_create(struct pipe_context *pipe);
+
+void
+util_gpu_markers_destroy(struct util_gpu_markers *gm);
+
+/**
+ * Open/close a marker scope. Scopes must be properly nested.
+ */
+void
+util_gpu_markers_push(struct util_gpu_markers *gm, const char *name);
+
+void
+util_gpu_markers_pop(struct util_gpu_markers *gm);
+
+/**
+ * Retire completed queries and rotate the per-marker aggregates.
+ * Call once per frame; never waits on the GPU, scopes whose queries
+ * haven't completed yet are accounted to the next frame.
+ */
+void
+util_gpu_markers_end_frame(struct util_gpu_markers *gm);
+
+/**
+ * Get the aggregated GPU time in nanoseconds a marker accumulated during
+ * the last completed frame, or 0 if the marker is unknown.
+ */
+uint64_t
+util_gpu_markers_get_time(struct util_gpu_markers *gm, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_GPU_MARKERS_H */
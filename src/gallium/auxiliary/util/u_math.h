@@ -640,6 +640,18 @@ util_logbase2(unsigned n)
 #endif
 }
 
+/**
+ * Calc log base 2 rounded up.
+ */
+static inline unsigned
+util_logbase2_ceil(unsigned n)
+{
+   if (n <= 1)
+      return 0;
+
+   return 1 + util_logbase2(n - 1);
+}
+
 
 /**
  * Returns the smallest power of two >= x
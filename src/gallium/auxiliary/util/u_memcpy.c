@@ -0,0 +1,148 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Size-classed memory copies.
+ *
+ * Texture transfers routinely move megabytes per call through memcpy,
+ * which drags the whole copy through the cache hierarchy and evicts
+ * everything else on the way.  The copies here switch to non-temporal
+ * stores once a copy is big enough that the destination can't usefully
+ * stay cached anyway.
+ */
+
+#include "util/u_memcpy.h"
+
+#if defined(PIPE_ARCH_SSE)
+
+#include <emmintrin.h>
+
+/**
+ * Copy one run of bytes with streaming stores, without the trailing
+ * sfence, so that a rect copy can fence once instead of once per row.
+ */
+static void
+streaming_memcpy_unfenced(uint8_t *dst, const uint8_t *src, size_t size)
+{
+   unsigned head = (unsigned)((uintptr_t)dst & 15);
+
+   /* Align the destination; movnt requires it. */
+   if (head) {
+      head = 16 - head;
+      if (head > size)
+         head = size;
+      memcpy(dst, src, head);
+      dst += head;
+      src += head;
+      size -= head;
+   }
+
+   while (size >= 64) {
+      __m128i v0 = _mm_loadu_si128((const __m128i *)(src +  0));
+      __m128i v1 = _mm_loadu_si128((const __m128i *)(src + 16));
+      __m128i v2 = _mm_loadu_si128((const __m128i *)(src + 32));
+      __m128i v3 = _mm_loadu_si128((const __m128i *)(src + 48));
+      _mm_stream_si128((__m128i *)(dst +  0), v0);
+      _mm_stream_si128((__m128i *)(dst + 16), v1);
+      _mm_stream_si128((__m128i *)(dst + 32), v2);
+      _mm_stream_si128((__m128i *)(dst + 48), v3);
+      dst += 64;
+      src += 64;
+      size -= 64;
+   }
+
+   if (size)
+      memcpy(dst, src, size);
+}
+
+void
+util_streaming_memcpy(void *dst, const void *src, size_t size)
+{
+   streaming_memcpy_unfenced((uint8_t *)dst, (const uint8_t *)src, size);
+
+   /* Streaming stores are weakly ordered; don't let later accesses
+    * (typically an unmap and fence submission) pass them.
+    */
+   _mm_sfence();
+}
+
+void
+util_memcpy_rect(uint8_t *dst, int dst_stride,
+                 const uint8_t *src, int src_stride,
+                 unsigned width, unsigned height)
+{
+   unsigned i;
+
+   if ((int)width == dst_stride && (int)width == src_stride) {
+      util_memcpy(dst, src, (size_t)height * width);
+   }
+   else if ((size_t)width * height >= util_streaming_memcpy_threshold()) {
+      for (i = 0; i < height; i++) {
+         streaming_memcpy_unfenced(dst, src, width);
+         dst += dst_stride;
+         src += src_stride;
+      }
+      _mm_sfence();
+   }
+   else {
+      for (i = 0; i < height; i++) {
+         memcpy(dst, src, width);
+         dst += dst_stride;
+         src += src_stride;
+      }
+   }
+}
+
+#else /* !PIPE_ARCH_SSE */
+
+void
+util_streaming_memcpy(void *dst, const void *src, size_t size)
+{
+   memcpy(dst, src, size);
+}
+
+void
+util_memcpy_rect(uint8_t *dst, int dst_stride,
+                 const uint8_t *src, int src_stride,
+                 unsigned width, unsigned height)
+{
+   unsigned i;
+
+   if ((int)width == dst_stride && (int)width == src_stride) {
+      memcpy(dst, src, (size_t)height * width);
+   }
+   else {
+      for (i = 0; i < height; i++) {
+         memcpy(dst, src, width);
+         dst += dst_stride;
+         src += src_stride;
+      }
+   }
+}
+
+#endif /* !PIPE_ARCH_SSE */
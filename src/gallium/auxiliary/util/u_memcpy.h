@@ -0,0 +1,82 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#ifndef U_MEMCPY_H_
+#define U_MEMCPY_H_
+
+#include <string.h>
+
+#include "pipe/p_compiler.h"
+#include "util/u_cpu_detect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Copies at least this large bypass the cache (where the CPU supports
+ * streaming stores).  Below it the destination usually fits in the cache
+ * and is likely to be read back soon, so a plain memcpy wins.  This is
+ * the fallback value; util_cpu_detect() derives a better one from the
+ * actual last-level cache size.
+ */
+#define UTIL_STREAMING_MEMCPY_THRESHOLD (1024 * 1024)
+
+static inline size_t
+util_streaming_memcpy_threshold(void)
+{
+   return util_cpu_caps.streaming_threshold ?
+          util_cpu_caps.streaming_threshold :
+          UTIL_STREAMING_MEMCPY_THRESHOLD;
+}
+
+void
+util_streaming_memcpy(void *dst, const void *src, size_t size);
+
+void
+util_memcpy_rect(uint8_t *dst, int dst_stride,
+                 const uint8_t *src, int src_stride,
+                 unsigned width, unsigned height);
+
+/**
+ * memcpy with a non-temporal store path for copies large enough that
+ * caching the destination would only evict useful data.
+ */
+static inline void
+util_memcpy(void *dst, const void *src, size_t size)
+{
+   if (size >= util_streaming_memcpy_threshold())
+      util_streaming_memcpy(dst, src, size);
+   else
+      memcpy(dst, src, size);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_MEMCPY_H_ */
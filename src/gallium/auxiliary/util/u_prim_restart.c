@@ -29,6 +29,136 @@
 #include "u_memory.h"
 #include "u_prim_restart.h"
 
+#if defined(PIPE_ARCH_SSE)
+#include <emmintrin.h>
+#endif
+
+
+/**
+ * Scan an index array and report the ranges lying between restart
+ * indexes through a callback, without building a rewritten copy of
+ * the buffer.  \p indices points at the first index to scan; the
+ * emitted range starts are biased by \p start so they can be fed
+ * straight into pipe_draw_info::start.
+ *
+ * On SSE2 targets the scan compares a whole vector of indexes per
+ * iteration and only drops to the scalar loop for groups which
+ * actually contain a restart index.
+ */
+void
+util_split_prim_restart(const void *indices,
+                        unsigned index_size,
+                        unsigned start,
+                        unsigned count,
+                        unsigned restart_index,
+                        u_split_prim_restart_func emit,
+                        void *data)
+{
+   unsigned i = 0, run_start = 0, run_count = 0;
+
+#define SCAN_INDEX(ELT)                                \
+   if ((ELT) == restart_index) {                       \
+      if (run_count)                                   \
+         emit(data, start + run_start, run_count);     \
+      run_start = i + 1;                               \
+      run_count = 0;                                   \
+   }                                                   \
+   else {                                              \
+      run_count++;                                     \
+   }
+
+   switch (index_size) {
+   case 1:
+      {
+         const uint8_t *in = (const uint8_t *) indices;
+#if defined(PIPE_ARCH_SSE)
+         /* the splat would truncate a restart index no ubyte can match */
+         if (restart_index <= 0xff) {
+            const __m128i restart = _mm_set1_epi8((char) restart_index);
+            while (i + 16 <= count) {
+               const __m128i v = _mm_loadu_si128((const __m128i *) &in[i]);
+               if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, restart)) == 0) {
+                  run_count += 16;
+                  i += 16;
+               }
+               else {
+                  const unsigned stop = i + 16;
+                  for (; i < stop; i++) {
+                     SCAN_INDEX(in[i]);
+                  }
+               }
+            }
+         }
+#endif
+         for (; i < count; i++) {
+            SCAN_INDEX(in[i]);
+         }
+      }
+      break;
+   case 2:
+      {
+         const uint16_t *in = (const uint16_t *) indices;
+#if defined(PIPE_ARCH_SSE)
+         if (restart_index <= 0xffff) {
+            const __m128i restart = _mm_set1_epi16((short) restart_index);
+            while (i + 8 <= count) {
+               const __m128i v = _mm_loadu_si128((const __m128i *) &in[i]);
+               if (_mm_movemask_epi8(_mm_cmpeq_epi16(v, restart)) == 0) {
+                  run_count += 8;
+                  i += 8;
+               }
+               else {
+                  const unsigned stop = i + 8;
+                  for (; i < stop; i++) {
+                     SCAN_INDEX(in[i]);
+                  }
+               }
+            }
+         }
+#endif
+         for (; i < count; i++) {
+            SCAN_INDEX(in[i]);
+         }
+      }
+      break;
+   case 4:
+      {
+         const uint32_t *in = (const uint32_t *) indices;
+#if defined(PIPE_ARCH_SSE)
+         {
+            const __m128i restart = _mm_set1_epi32((int) restart_index);
+            while (i + 4 <= count) {
+               const __m128i v = _mm_loadu_si128((const __m128i *) &in[i]);
+               if (_mm_movemask_epi8(_mm_cmpeq_epi32(v, restart)) == 0) {
+                  run_count += 4;
+                  i += 4;
+               }
+               else {
+                  const unsigned stop = i + 4;
+                  for (; i < stop; i++) {
+                     SCAN_INDEX(in[i]);
+                  }
+               }
+            }
+         }
+#endif
+         for (; i < count; i++) {
+            SCAN_INDEX(in[i]);
+         }
+      }
+      break;
+   default:
+      assert(!"Bad index size");
+      return;
+   }
+
+#undef SCAN_INDEX
+
+   /* emit the final range */
+   if (run_count)
+      emit(data, start + run_start, run_count);
+}
+
 
 /**
  * Translate an index buffer for primitive restart.
@@ -131,21 +261,26 @@ struct range {
 struct range_info {
    struct range *ranges;
    unsigned count, max;
+   boolean error;
 };
 
 
 /**
- * Helper function for util_draw_vbo_without_prim_restart()
- * \return true for success, false if out of memory
+ * Helper function for util_draw_vbo_without_prim_restart().
+ * util_split_prim_restart() callback which collects the ranges into
+ * a growing array; sets range_info::error if out of memory.
  */
-static boolean
-add_range(struct range_info *info, unsigned start, unsigned count)
+static void
+add_range(void *data, unsigned start, unsigned count)
 {
+   struct range_info *info = (struct range_info *) data;
+
    if (info->max == 0) {
       info->max = 10;
       info->ranges = MALLOC(info->max * sizeof(struct range));
       if (!info->ranges) {
-         return FALSE;
+         info->error = TRUE;
+         return;
       }
    }
    else if (info->count == info->max) {
@@ -154,7 +289,8 @@ add_range(struct range_info *info, unsigned start, unsigned count)
                              info->max * sizeof(struct range),
                              2 * info->max * sizeof(struct range));
       if (!info->ranges) {
-         return FALSE;
+         info->error = TRUE;
+         return;
       }
 
       info->max *= 2;
@@ -164,8 +300,6 @@ add_range(struct range_info *info, unsigned start, unsigned count)
    info->ranges[info->count].start = start;
    info->ranges[info->count].count = count;
    info->count++;
-
-   return TRUE;
 }
 
 
@@ -184,11 +318,16 @@ util_draw_vbo_without_prim_restart(struct pipe_context *context,
    struct range_info ranges = {0};
    struct pipe_draw_info new_info;
    struct pipe_transfer *src_transfer = NULL;
-   unsigned i, start, count;
+   unsigned i;
 
    assert(info->indexed);
    assert(info->primitive_restart);
 
+   if (ib->index_size != 1 && ib->index_size != 2 && ib->index_size != 4) {
+      assert(!"Bad index size");
+      return PIPE_ERROR_BAD_INPUT;
+   }
+
    /* Get pointer to the index data */
    if (ib->buffer) {
       /* map the index buffer (only the range we need to scan) */
@@ -211,47 +350,23 @@ util_draw_vbo_without_prim_restart(struct pipe_context *context,
          + info->start * ib->index_size;
    }
 
-#define SCAN_INDEXES(TYPE) \
-   for (i = 0; i <= info->count; i++) { \
-      if (i == info->count || \
-          ((const TYPE *) src_map)[i] == info->restart_index) { \
-         /* cut / restart */ \
-         if (count > 0) { \
-            if (!add_range(&ranges, info->start + start, count)) { \
-               if (src_transfer) \
-                  pipe_buffer_unmap(context, src_transfer); \
-               return PIPE_ERROR_OUT_OF_MEMORY; \
-            } \
-         } \
-         start = i + 1; \
-         count = 0; \
-      } \
-      else { \
-         count++; \
-      } \
-   }
-
-   start = info->start;
-   count = 0;
-   switch (ib->index_size) {
-   case 1:
-      SCAN_INDEXES(uint8_t);
-      break;
-   case 2:
-      SCAN_INDEXES(uint16_t);
-      break;
-   case 4:
-      SCAN_INDEXES(uint32_t);
-      break;
-   default:
-      assert(!"Bad index size");
-      return PIPE_ERROR_BAD_INPUT;
-   }
+   /* Collect the ranges between the restart indexes.  The ranges have
+    * to be gathered before drawing since the index buffer may still be
+    * mapped here.
+    */
+   util_split_prim_restart(src_map, ib->index_size, info->start,
+                           info->count, info->restart_index,
+                           add_range, &ranges);
 
    /* unmap index buffer */
    if (src_transfer)
       pipe_buffer_unmap(context, src_transfer);
 
+   if (ranges.error) {
+      FREE(ranges.ranges);
+      return PIPE_ERROR_OUT_OF_MEMORY;
+   }
+
    /* draw ranges between the restart indexes */
    new_info = *info;
    new_info.primitive_restart = FALSE;
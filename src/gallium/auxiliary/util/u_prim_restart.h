@@ -42,6 +42,23 @@ struct pipe_index_buffer;
 struct pipe_resource;
 
 
+/**
+ * Callback for util_split_prim_restart(): receives one range of
+ * indexes which contains no restart index.
+ */
+typedef void (*u_split_prim_restart_func)(void *data,
+                                          unsigned start,
+                                          unsigned count);
+
+void
+util_split_prim_restart(const void *indices,
+                        unsigned index_size,
+                        unsigned start,
+                        unsigned count,
+                        unsigned restart_index,
+                        u_split_prim_restart_func emit,
+                        void *data);
+
 enum pipe_error
 util_translate_prim_restart_ib(struct pipe_context *context,
                                struct pipe_index_buffer *src_buffer,
@@ -38,6 +38,7 @@
 
 #include "util/u_format.h"
 #include "util/u_inlines.h"
+#include "util/u_memcpy.h"
 #include "util/u_rect.h"
 #include "util/u_surface.h"
 #include "util/u_pack_color.h"
@@ -75,7 +76,6 @@ util_copy_rect(ubyte * dst,
                unsigned src_x,
                unsigned src_y)
 {
-   unsigned i;
    int src_stride_pos = src_stride < 0 ? -src_stride : src_stride;
    int blocksize = util_format_get_blocksize(format);
    int blockwidth = util_format_get_blockwidth(format);
@@ -98,15 +98,7 @@ util_copy_rect(ubyte * dst,
    src += src_y * src_stride_pos;
    width *= blocksize;
 
-   if (width == dst_stride && width == src_stride)
-      memcpy(dst, src, height * width);
-   else {
-      for (i = 0; i < height; i++) {
-         memcpy(dst, src, width);
-         dst += dst_stride;
-         src += src_stride;
-      }
-   }
+   util_memcpy_rect(dst, dst_stride, src, src_stride, width, height);
 }
 
 
@@ -29,6 +29,7 @@
 
 #include "pipe/p_compiler.h"
 #include "pipe/p_context.h"
+#include "pipe/p_screen.h"
 
 #include "util/u_memory.h"
 #include "util/u_draw.h"
@@ -338,6 +339,137 @@ create_frag_shader_rgba(struct vl_compositor *c)
    return ureg_create_shader_and_destroy(shader, c->pipe);
 }
 
+/**
+ * Compute shader equivalent of create_frag_shader_video_buffer(), writing the
+ * composited pixels with image stores instead of going through the fragment
+ * pipeline.  One thread handles one destination pixel, one 8x8 block one tile.
+ *
+ * Constants:
+ * CONST[0..2]  color conversion matrix (same layout as the fragment path)
+ * CONST[3]     destination area, in pixels: x0, y0, x1, y1
+ * CONST[4]     pixel center -> texture coordinate: scale.xy, offset.xy
+ * CONST[5]     x = array layer to sample, yz = dst area offset + pixel center
+ */
+static void *
+create_cs_video_buffer(struct vl_compositor *c)
+{
+   struct ureg_program *shader;
+   struct ureg_src block_id, thread_id;
+   struct ureg_src csc[3], dst_area, coord_trans, misc;
+   struct ureg_src sampler[3], image;
+   struct ureg_dst t_pix, t_pos, t_tc, t_texel, t_color;
+   struct ureg_dst d_image;
+   struct ureg_src store_args[2];
+   struct pipe_compute_state state;
+   const struct tgsi_token *tokens;
+   unsigned i, label;
+   void *cs;
+
+   shader = ureg_create(PIPE_SHADER_COMPUTE);
+   if (!shader)
+      return NULL;
+
+   ureg_property(shader, TGSI_PROPERTY_CS_FIXED_BLOCK_WIDTH, 8);
+   ureg_property(shader, TGSI_PROPERTY_CS_FIXED_BLOCK_HEIGHT, 8);
+   ureg_property(shader, TGSI_PROPERTY_CS_FIXED_BLOCK_DEPTH, 1);
+
+   block_id = ureg_DECL_system_value(shader, TGSI_SEMANTIC_BLOCK_ID, 0);
+   thread_id = ureg_DECL_system_value(shader, TGSI_SEMANTIC_THREAD_ID, 0);
+
+   for (i = 0; i < 3; ++i) {
+      csc[i] = ureg_DECL_constant(shader, i);
+      sampler[i] = ureg_DECL_sampler(shader, i);
+   }
+   dst_area = ureg_DECL_constant(shader, 3);
+   coord_trans = ureg_DECL_constant(shader, 4);
+   misc = ureg_DECL_constant(shader, 5);
+
+   image = ureg_DECL_image(shader, 0, TGSI_TEXTURE_2D, 0, TRUE, FALSE);
+
+   t_pix = ureg_DECL_temporary(shader);
+   t_pos = ureg_DECL_temporary(shader);
+   t_tc = ureg_DECL_temporary(shader);
+   t_texel = ureg_DECL_temporary(shader);
+   t_color = ureg_DECL_temporary(shader);
+
+   /* pos = dst area offset + block * block_size + thread + pixel center */
+   ureg_UMAD(shader, ureg_writemask(t_pix, TGSI_WRITEMASK_XY),
+             block_id, ureg_imm2u(shader, 8, 8), thread_id);
+   ureg_U2F(shader, ureg_writemask(t_pos, TGSI_WRITEMASK_XY),
+            ureg_src(t_pix));
+   ureg_ADD(shader, ureg_writemask(t_pos, TGSI_WRITEMASK_XY),
+            ureg_src(t_pos), ureg_swizzle(misc, TGSI_SWIZZLE_Y,
+            TGSI_SWIZZLE_Z, TGSI_SWIZZLE_Z, TGSI_SWIZZLE_Z));
+
+   /* the grid is rounded up to whole blocks, ignore the overhang */
+   ureg_SLT(shader, ureg_writemask(t_tc, TGSI_WRITEMASK_XY),
+            ureg_src(t_pos), ureg_swizzle(dst_area, TGSI_SWIZZLE_Z,
+            TGSI_SWIZZLE_W, TGSI_SWIZZLE_W, TGSI_SWIZZLE_W));
+   ureg_MUL(shader, ureg_writemask(t_tc, TGSI_WRITEMASK_X),
+            ureg_src(t_tc), ureg_scalar(ureg_src(t_tc), TGSI_SWIZZLE_Y));
+
+   ureg_IF(shader, ureg_scalar(ureg_src(t_tc), TGSI_SWIZZLE_X), &label);
+
+      /* store coordinates and sample position */
+      ureg_F2U(shader, ureg_writemask(t_pix, TGSI_WRITEMASK_XY),
+               ureg_src(t_pos));
+      ureg_MAD(shader, ureg_writemask(t_tc, TGSI_WRITEMASK_XY),
+               ureg_src(t_pos), coord_trans, ureg_swizzle(coord_trans,
+               TGSI_SWIZZLE_Z, TGSI_SWIZZLE_W, TGSI_SWIZZLE_W,
+               TGSI_SWIZZLE_W));
+      ureg_MOV(shader, ureg_writemask(t_tc, TGSI_WRITEMASK_Z),
+               ureg_scalar(misc, TGSI_SWIZZLE_X));
+      ureg_MOV(shader, ureg_writemask(t_tc, TGSI_WRITEMASK_W),
+               ureg_imm1f(shader, 0.0f));
+
+      /*
+       * texel.xyz = tex(tc, sampler[i])
+       * color = csc * texel
+       */
+      for (i = 0; i < 3; ++i)
+         ureg_TXL(shader, ureg_writemask(t_texel, TGSI_WRITEMASK_X << i),
+                  TGSI_TEXTURE_2D_ARRAY, ureg_src(t_tc), sampler[i]);
+
+      ureg_MOV(shader, ureg_writemask(t_texel, TGSI_WRITEMASK_W),
+               ureg_imm1f(shader, 1.0f));
+
+      for (i = 0; i < 3; ++i)
+         ureg_DP4(shader, ureg_writemask(t_color, TGSI_WRITEMASK_X << i),
+                  csc[i], ureg_src(t_texel));
+
+      ureg_MOV(shader, ureg_writemask(t_color, TGSI_WRITEMASK_W),
+               ureg_imm1f(shader, 1.0f));
+
+      d_image = ureg_dst(image);
+      store_args[0] = ureg_src(t_pix);
+      store_args[1] = ureg_src(t_color);
+      ureg_memory_insn(shader, TGSI_OPCODE_STORE, &d_image, 1, store_args, 2,
+                       0, TGSI_TEXTURE_2D, 0);
+
+   ureg_fixup_label(shader, label, ureg_get_instruction_number(shader));
+   ureg_ENDIF(shader);
+
+   ureg_release_temporary(shader, t_color);
+   ureg_release_temporary(shader, t_texel);
+   ureg_release_temporary(shader, t_tc);
+   ureg_release_temporary(shader, t_pos);
+   ureg_release_temporary(shader, t_pix);
+   ureg_END(shader);
+
+   tokens = ureg_get_tokens(shader, NULL);
+   ureg_destroy(shader);
+   if (!tokens)
+      return NULL;
+
+   memset(&state, 0, sizeof(state));
+   state.ir_type = PIPE_SHADER_IR_TGSI;
+   state.prog = tokens;
+   cs = c->pipe->create_compute_state(c->pipe, &state);
+   ureg_free_tokens((struct tgsi_token *)tokens);
+
+   return cs;
+}
+
 static bool
 init_shaders(struct vl_compositor *c)
 {
@@ -379,6 +511,15 @@ init_shaders(struct vl_compositor *c)
       return false;
    }
 
+   if (c->has_compute) {
+      c->cs_video_buffer = create_cs_video_buffer(c);
+      if (!c->cs_video_buffer) {
+         /* not fatal, fall back to drawing quads */
+         debug_printf("Unable to create YCbCr-to-RGB compute shader.\n");
+         c->has_compute = false;
+      }
+   }
+
    return true;
 }
 
@@ -392,6 +533,8 @@ static void cleanup_shaders(struct vl_compositor *c)
    c->pipe->delete_fs_state(c->pipe, c->fs_palette.yuv);
    c->pipe->delete_fs_state(c->pipe, c->fs_palette.rgb);
    c->pipe->delete_fs_state(c->pipe, c->fs_rgba);
+   if (c->cs_video_buffer)
+      c->pipe->delete_compute_state(c->pipe, c->cs_video_buffer);
 }
 
 static bool
@@ -789,6 +932,148 @@ draw_layers(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rec
    }
 }
 
+/* constant buffer layout of create_cs_video_buffer() */
+struct cs_video_consts
+{
+   vl_csc_matrix csc;
+   float dst_area[4];
+   float coord_trans[4];
+   float misc[4];
+};
+
+/**
+ * Check if the scene can be handled by dispatching the compute shader
+ * instead of drawing quads.
+ */
+static bool
+can_use_compute_layers(struct vl_compositor *c, struct vl_compositor_state *s,
+                       struct pipe_surface *dst_surface)
+{
+   struct pipe_screen *screen = c->pipe->screen;
+   unsigned i;
+
+   if (!c->has_compute)
+      return false;
+
+   if (!screen->is_format_supported(screen, dst_surface->format,
+                                    dst_surface->texture->target,
+                                    dst_surface->texture->nr_samples,
+                                    PIPE_BIND_SHADER_IMAGE))
+      return false;
+
+   for (i = 0; i < VL_COMPOSITOR_MAX_LAYERS; ++i) {
+      struct vl_compositor_layer *layer = &s->layers[i];
+
+      if (!(s->used_layers & (1 << i)))
+         continue;
+
+      /* The compute shader always overwrites the destination, which is
+       * equivalent to the default blend states since the video shader
+       * emits alpha = 1. Custom blends and rotation stay on the quad path.
+       */
+      if (!layer->cs || layer->blend || layer->rotate != VL_COMPOSITOR_ROTATE_0)
+         return false;
+   }
+
+   return s->used_layers != 0;
+}
+
+static void
+draw_layers_compute(struct vl_compositor *c, struct vl_compositor_state *s,
+                    struct pipe_surface *dst_surface, struct u_rect *dirty)
+{
+   struct pipe_image_view image;
+   unsigned i;
+
+   assert(c);
+
+   memset(&image, 0, sizeof(image));
+   image.resource = dst_surface->texture;
+   image.format = dst_surface->format;
+   image.access = PIPE_IMAGE_ACCESS_WRITE;
+   image.u.tex.level = dst_surface->u.tex.level;
+   image.u.tex.first_layer = dst_surface->u.tex.first_layer;
+   image.u.tex.last_layer = dst_surface->u.tex.last_layer;
+   c->pipe->set_shader_images(c->pipe, PIPE_SHADER_COMPUTE, 0, 1, &image);
+
+   for (i = 0; i < VL_COMPOSITOR_MAX_LAYERS; ++i) {
+      if (s->used_layers & (1 << i)) {
+         struct vl_compositor_layer *layer = &s->layers[i];
+         struct u_rect drawn = calc_drawn_area(s, layer);
+         struct cs_video_consts consts;
+         struct pipe_constant_buffer cb;
+         struct pipe_grid_info info;
+         float sx, sy;
+
+         if (drawn.x0 >= drawn.x1 || drawn.y0 >= drawn.y1)
+            continue;
+
+         /* undo the viewport transformation, one texture coordinate step
+          * per destination pixel
+          */
+         sx = (layer->src.br.x - layer->src.tl.x) /
+              (layer->viewport.scale[0] * (layer->dst.br.x - layer->dst.tl.x));
+         sy = (layer->src.br.y - layer->src.tl.y) /
+              (layer->viewport.scale[1] * (layer->dst.br.y - layer->dst.tl.y));
+
+         memcpy(&consts.csc, &s->csc, sizeof(consts.csc));
+         consts.dst_area[0] = drawn.x0;
+         consts.dst_area[1] = drawn.y0;
+         consts.dst_area[2] = drawn.x1;
+         consts.dst_area[3] = drawn.y1;
+         consts.coord_trans[0] = sx;
+         consts.coord_trans[1] = sy;
+         consts.coord_trans[2] = layer->src.tl.x - (layer->viewport.translate[0] +
+            layer->dst.tl.x * layer->viewport.scale[0]) * sx;
+         consts.coord_trans[3] = layer->src.tl.y - (layer->viewport.translate[1] +
+            layer->dst.tl.y * layer->viewport.scale[1]) * sy;
+         consts.misc[0] = layer->zw.x;
+         consts.misc[1] = drawn.x0 + 0.5f;
+         consts.misc[2] = drawn.y0 + 0.5f;
+         consts.misc[3] = 0.0f;
+
+         memset(&cb, 0, sizeof(cb));
+         u_upload_data(c->upload_cs, 0, sizeof(consts), 256, &consts,
+                       &cb.buffer_offset, &cb.buffer);
+         if (!cb.buffer)
+            continue;
+         cb.buffer_size = sizeof(consts);
+         c->pipe->set_constant_buffer(c->pipe, PIPE_SHADER_COMPUTE, 0, &cb);
+         pipe_resource_reference(&cb.buffer, NULL);
+
+         c->pipe->bind_compute_state(c->pipe, layer->cs);
+         c->pipe->bind_sampler_states(c->pipe, PIPE_SHADER_COMPUTE, 0,
+                                      3, layer->samplers);
+         c->pipe->set_sampler_views(c->pipe, PIPE_SHADER_COMPUTE, 0,
+                                    3, layer->sampler_views);
+
+         memset(&info, 0, sizeof(info));
+         info.block[0] = 8;
+         info.block[1] = 8;
+         info.block[2] = 1;
+         info.grid[0] = ((drawn.x1 - drawn.x0) + 7) / 8;
+         info.grid[1] = ((drawn.y1 - drawn.y0) + 7) / 8;
+         info.grid[2] = 1;
+         c->pipe->launch_grid(c->pipe, &info);
+
+         if (dirty) {
+            // Remember the currently drawn area as dirty for the next draw command
+            dirty->x0 = MIN2(drawn.x0, dirty->x0);
+            dirty->y0 = MIN2(drawn.y0, dirty->y0);
+            dirty->x1 = MAX2(drawn.x1, dirty->x1);
+            dirty->y1 = MAX2(drawn.y1, dirty->y1);
+         }
+      }
+   }
+
+   u_upload_unmap(c->upload_cs);
+   c->pipe->set_shader_images(c->pipe, PIPE_SHADER_COMPUTE, 0, 1, NULL);
+
+   /* make the image stores visible to transfers and sampling */
+   if (c->pipe->memory_barrier)
+      c->pipe->memory_barrier(c->pipe, PIPE_BARRIER_TEXTURE | PIPE_BARRIER_IMAGE);
+}
+
 void
 vl_compositor_reset_dirty_area(struct u_rect *dirty)
 {
@@ -829,6 +1114,7 @@ vl_compositor_clear_layers(struct vl_compositor_state *s)
       s->layers[i].clearing = i ? false : true;
       s->layers[i].blend = NULL;
       s->layers[i].fs = NULL;
+      s->layers[i].cs = NULL;
       s->layers[i].viewport.scale[2] = 1;
       s->layers[i].viewport.translate[2] = 0;
       s->layers[i].rotate = VL_COMPOSITOR_ROTATE_0;
@@ -845,6 +1131,8 @@ vl_compositor_cleanup(struct vl_compositor *c)
 {
    assert(c);
 
+   if (c->upload_cs)
+      u_upload_destroy(c->upload_cs);
    u_upload_destroy(c->upload);
    cleanup_buffers(c);
    cleanup_shaders(c);
@@ -868,6 +1156,9 @@ vl_compositor_set_csc_matrix(struct vl_compositor_state *s, vl_csc_matrix const
    );
 
    pipe_buffer_unmap(s->pipe, buf_transfer);
+
+   /* keep a CPU copy around for the compute shader constants */
+   memcpy(&s->csc, matrix, sizeof(s->csc));
 }
 
 void
@@ -946,6 +1237,7 @@ vl_compositor_set_buffer_layer(struct vl_compositor_state *s,
       switch(deinterlace) {
       case VL_COMPOSITOR_WEAVE:
          s->layers[layer].fs = c->fs_weave;
+         s->layers[layer].cs = NULL;
          break;
 
       case VL_COMPOSITOR_BOB_TOP:
@@ -953,6 +1245,7 @@ vl_compositor_set_buffer_layer(struct vl_compositor_state *s,
          s->layers[layer].src.tl.y += half_a_line;
          s->layers[layer].src.br.y += half_a_line;
          s->layers[layer].fs = c->fs_video_buffer;
+         s->layers[layer].cs = c->cs_video_buffer;
          break;
 
       case VL_COMPOSITOR_BOB_BOTTOM:
@@ -960,11 +1253,14 @@ vl_compositor_set_buffer_layer(struct vl_compositor_state *s,
          s->layers[layer].src.tl.y -= half_a_line;
          s->layers[layer].src.br.y -= half_a_line;
          s->layers[layer].fs = c->fs_video_buffer;
+         s->layers[layer].cs = c->cs_video_buffer;
          break;
       }
 
-   } else
+   } else {
       s->layers[layer].fs = c->fs_video_buffer;
+      s->layers[layer].cs = c->cs_video_buffer;
+   }
 }
 
 void
@@ -985,6 +1281,7 @@ vl_compositor_set_palette_layer(struct vl_compositor_state *s,
 
    s->layers[layer].fs = include_color_conversion ?
       c->fs_palette.yuv : c->fs_palette.rgb;
+   s->layers[layer].cs = NULL;
 
    s->layers[layer].samplers[0] = c->sampler_linear;
    s->layers[layer].samplers[1] = c->sampler_nearest;
@@ -1014,6 +1311,7 @@ vl_compositor_set_rgba_layer(struct vl_compositor_state *s,
 
    s->used_layers |= 1 << layer;
    s->layers[layer].fs = c->fs_rgba;
+   s->layers[layer].cs = NULL;
    s->layers[layer].samplers[0] = c->sampler_linear;
    s->layers[layer].samplers[1] = NULL;
    s->layers[layer].samplers[2] = NULL;
@@ -1061,6 +1359,50 @@ vl_compositor_render(struct vl_compositor_state *s,
    }
    c->pipe->set_scissor_states(c->pipe, 0, 1, &s->scissor);
 
+   if (can_use_compute_layers(c, s, dst_surface)) {
+      unsigned i;
+
+      /* gen_vertex_data() side effects, without uploading any vertices */
+      for (i = 0; i < VL_COMPOSITOR_MAX_LAYERS; i++) {
+         if (s->used_layers & (1 << i)) {
+            struct vl_compositor_layer *layer = &s->layers[i];
+
+            if (!layer->viewport_valid) {
+               layer->viewport.scale[0] = c->fb_state.width;
+               layer->viewport.scale[1] = c->fb_state.height;
+               layer->viewport.translate[0] = 0;
+               layer->viewport.translate[1] = 0;
+            }
+
+            if (dirty_area && layer->clearing) {
+               struct u_rect drawn = calc_drawn_area(s, layer);
+               if (
+                dirty_area->x0 >= drawn.x0 &&
+                dirty_area->y0 >= drawn.y0 &&
+                dirty_area->x1 <= drawn.x1 &&
+                dirty_area->y1 <= drawn.y1) {
+
+                  // We overwrite the dirty area anyway, no need for clear_render_target
+                  dirty_area->x0 = dirty_area->y0 = MAX_DIRTY;
+                  dirty_area->x1 = dirty_area->y1 = MIN_DIRTY;
+               }
+            }
+         }
+      }
+
+      if (clear_dirty && dirty_area &&
+          (dirty_area->x0 < dirty_area->x1 || dirty_area->y0 < dirty_area->y1)) {
+
+         c->pipe->clear_render_target(c->pipe, dst_surface, &s->clear_color,
+                                      0, 0, dst_surface->width, dst_surface->height);
+         dirty_area->x0 = dirty_area->y0 = MAX_DIRTY;
+         dirty_area->x1 = dirty_area->y1 = MIN_DIRTY;
+      }
+
+      draw_layers_compute(c, s, dst_surface, dirty_area);
+      return;
+   }
+
    gen_vertex_data(c, s, dirty_area);
 
    if (clear_dirty && dirty_area &&
@@ -1085,37 +1427,59 @@ vl_compositor_render(struct vl_compositor_state *s,
 bool
 vl_compositor_init(struct vl_compositor *c, struct pipe_context *pipe)
 {
+   struct pipe_screen *screen = pipe->screen;
+
    assert(c);
 
    memset(c, 0, sizeof(*c));
 
    c->pipe = pipe;
 
+   c->has_compute = screen->get_param(screen, PIPE_CAP_COMPUTE) &&
+      (screen->get_shader_param(screen, PIPE_SHADER_COMPUTE,
+                                PIPE_SHADER_CAP_SUPPORTED_IRS) &
+       (1 << PIPE_SHADER_IR_TGSI)) &&
+      pipe->create_compute_state && pipe->launch_grid &&
+      pipe->set_shader_images;
+
    c->upload = u_upload_create(pipe, 128 * 1024, PIPE_BIND_VERTEX_BUFFER,
                                PIPE_USAGE_STREAM);
 
    if (!c->upload)
       return false;
 
+   if (c->has_compute) {
+      c->upload_cs = u_upload_create(pipe, 4096, PIPE_BIND_CONSTANT_BUFFER,
+                                     PIPE_USAGE_STREAM);
+      if (!c->upload_cs)
+         c->has_compute = false;
+   }
+
    if (!init_pipe_state(c)) {
-      u_upload_destroy(c->upload);
-      return false;
+      goto error_pipe_state;
    }
 
    if (!init_shaders(c)) {
-      u_upload_destroy(c->upload);
-      cleanup_pipe_state(c);
-      return false;
+      goto error_shaders;
    }
 
    if (!init_buffers(c)) {
-      u_upload_destroy(c->upload);
-      cleanup_shaders(c);
-      cleanup_pipe_state(c);
-      return false;
+      goto error_buffers;
    }
 
    return true;
+
+error_buffers:
+   cleanup_shaders(c);
+
+error_shaders:
+   cleanup_pipe_state(c);
+
+error_pipe_state:
+   if (c->upload_cs)
+      u_upload_destroy(c->upload_cs);
+   u_upload_destroy(c->upload);
+   return false;
 }
 
 bool
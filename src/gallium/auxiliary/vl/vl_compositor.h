@@ -70,6 +70,7 @@ struct vl_compositor_layer
    struct pipe_viewport_state viewport;
 
    void *fs;
+   void *cs; /**< compute shader to use instead of fs, if usable */
    void *samplers[3];
    void *blend;
 
@@ -89,6 +90,7 @@ struct vl_compositor_state
    bool scissor_valid;
    struct pipe_scissor_state scissor;
    struct pipe_resource *csc_matrix;
+   vl_csc_matrix csc; /**< CPU copy, used to build compute shader constants */
 
    union pipe_color_union clear_color;
 
@@ -100,6 +102,7 @@ struct vl_compositor
 {
    struct pipe_context *pipe;
    struct u_upload_mgr *upload;
+   struct u_upload_mgr *upload_cs;
 
    struct pipe_framebuffer_state fb_state;
    struct pipe_vertex_buffer vertex_buf;
@@ -111,11 +114,15 @@ struct vl_compositor
    void *dsa;
    void *vertex_elems_state;
 
+   bool has_compute;
+
    void *vs;
    void *fs_video_buffer;
    void *fs_weave;
    void *fs_rgba;
 
+   void *cs_video_buffer;
+
    struct {
       void *rgb;
       void *yuv;
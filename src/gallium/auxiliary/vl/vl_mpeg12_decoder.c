@@ -627,10 +627,13 @@ vl_mpeg12_begin_frame(struct pipe_video_codec *decoder,
    rect.width = tex->width0;
    rect.height = tex->height0;
 
+   /* The whole texture is rewritten every frame, let the driver rename
+    * it instead of syncing with the still pending zscan stage.
+    */
    buf->texels =
       dec->context->transfer_map(dec->context, tex, 0,
                                  PIPE_TRANSFER_WRITE |
-                                 PIPE_TRANSFER_DISCARD_RANGE,
+                                 PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE,
                                  &rect, &buf->tex_transfer);
 
    buf->block_num = 0;
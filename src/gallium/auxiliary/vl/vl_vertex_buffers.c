@@ -297,12 +297,16 @@ vl_vb_map(struct vl_vertex_buffer *buffer, struct pipe_context *pipe)
 
    assert(buffer && pipe);
 
+   /* Discarding the whole buffers lets the driver rename their storage,
+    * so filling in the next frame doesn't stall on draws still reading
+    * the previous one.
+    */
    for (i = 0; i < VL_NUM_COMPONENTS; ++i) {
       buffer->ycbcr[i].vertex_stream = pipe_buffer_map
       (
          pipe,
          buffer->ycbcr[i].resource,
-         PIPE_TRANSFER_WRITE | PIPE_TRANSFER_DISCARD_RANGE,
+         PIPE_TRANSFER_WRITE | PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE,
          &buffer->ycbcr[i].transfer
       );
    }
@@ -312,7 +316,7 @@ vl_vb_map(struct vl_vertex_buffer *buffer, struct pipe_context *pipe)
       (
          pipe,
          buffer->mv[i].resource,
-         PIPE_TRANSFER_WRITE | PIPE_TRANSFER_DISCARD_RANGE,
+         PIPE_TRANSFER_WRITE | PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE,
          &buffer->mv[i].transfer
       );
    }
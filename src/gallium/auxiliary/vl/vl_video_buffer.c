@@ -495,6 +495,61 @@ error:
    return NULL;
 }
 
+struct pipe_video_buffer *
+vl_video_buffer_wrap_resources(struct pipe_context *pipe,
+                               const struct pipe_video_buffer *tmpl,
+                               struct pipe_resource *resources[VL_NUM_COMPONENTS])
+{
+   const enum pipe_format *resource_formats;
+   struct pipe_resource *planes[VL_NUM_COMPONENTS];
+   struct pipe_video_buffer *result;
+   unsigned i;
+
+   assert(pipe);
+   assert(tmpl->width > 0 && tmpl->height > 0);
+
+   resource_formats = vl_video_buffer_formats(pipe->screen, tmpl->buffer_format);
+   if (!resource_formats)
+      return NULL;
+
+   for (i = 0; i < VL_NUM_COMPONENTS; ++i) {
+      unsigned width = tmpl->width, height = tmpl->height;
+
+      if (resource_formats[i] == PIPE_FORMAT_NONE) {
+         if (resources[i])
+            return NULL;
+         continue;
+      }
+
+      if (!resources[i])
+         return NULL;
+
+      /* the imported planes must be laid out just like our own allocations,
+       * larger paddings than ours are fine
+       */
+      vl_video_buffer_adjust_size(&width, &height, i, tmpl->chroma_format,
+                                  tmpl->interlaced);
+      if (resources[i]->format != resource_formats[i] ||
+          resources[i]->width0 < width || resources[i]->height0 < height ||
+          resources[i]->depth0 != 1 ||
+          resources[i]->array_size < (tmpl->interlaced ? 2 : 1) ||
+          !(resources[i]->bind & PIPE_BIND_SAMPLER_VIEW))
+         return NULL;
+   }
+
+   memset(planes, 0, sizeof planes);
+   for (i = 0; i < VL_NUM_COMPONENTS; ++i)
+      pipe_resource_reference(&planes[i], resources[i]);
+
+   result = vl_video_buffer_create_ex2(pipe, tmpl, planes);
+   if (!result) {
+      for (i = 0; i < VL_NUM_COMPONENTS; ++i)
+         pipe_resource_reference(&planes[i], NULL);
+   }
+
+   return result;
+}
+
 struct pipe_video_buffer *
 vl_video_buffer_create_ex2(struct pipe_context *pipe,
                            const struct pipe_video_buffer *tmpl,
@@ -136,6 +136,16 @@ vl_video_buffer_create_ex(struct pipe_context *pipe,
                           const enum pipe_format resource_formats[VL_NUM_COMPONENTS],
                           unsigned depth, unsigned array_size, unsigned usage);
 
+/**
+ * wrap imported resources (e.g. from a dmabuf) as the buffer planes without
+ * copying, validates that their layout matches the template and adds its own
+ * references
+ */
+struct pipe_video_buffer *
+vl_video_buffer_wrap_resources(struct pipe_context *pipe,
+                               const struct pipe_video_buffer *templat,
+                               struct pipe_resource *resources[VL_NUM_COMPONENTS]);
+
 /**
  * even more extended create function, provide the pipe_resource for each plane
  */
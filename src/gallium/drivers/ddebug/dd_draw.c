@@ -27,8 +27,10 @@
 
 #include "dd_pipe.h"
 
+#include "os/os_time.h"
 #include "util/u_dump.h"
 #include "util/u_format.h"
+#include "util/u_math.h"
 #include "tgsi/tgsi_scan.h"
 
 
@@ -523,6 +525,102 @@ dd_dump_call(struct dd_context *dctx, struct dd_call *call, unsigned flags)
    dd_close_file_stream(f);
 }
 
+static void
+dd_flight_record(struct dd_context *dctx, struct dd_call *call)
+{
+   struct dd_flight_record *rec =
+      &dctx->flight_ring[dctx->flight_head++ % DD_FLIGHT_RING_SIZE];
+
+   memset(rec, 0, sizeof(*rec));
+   rec->time = os_time_get();
+   rec->draw_call = dctx->num_draw_calls;
+   rec->type = call->type;
+
+   switch (call->type) {
+   case CALL_DRAW_VBO:
+      rec->misc[0] = call->info.draw_vbo.mode;
+      rec->misc[1] = call->info.draw_vbo.count;
+      break;
+   case CALL_LAUNCH_GRID:
+      rec->misc[0] = call->info.launch_grid.grid[0];
+      rec->misc[1] = call->info.launch_grid.grid[1];
+      break;
+   case CALL_RESOURCE_COPY_REGION:
+      rec->dst = (uintptr_t)call->info.resource_copy_region.dst;
+      rec->src = (uintptr_t)call->info.resource_copy_region.src;
+      break;
+   case CALL_BLIT:
+      rec->dst = (uintptr_t)call->info.blit.dst.resource;
+      rec->src = (uintptr_t)call->info.blit.src.resource;
+      break;
+   case CALL_FLUSH_RESOURCE:
+      rec->dst = (uintptr_t)call->info.flush_resource;
+      break;
+   case CALL_CLEAR:
+      rec->misc[0] = call->info.clear.buffers;
+      break;
+   case CALL_CLEAR_BUFFER:
+      rec->dst = (uintptr_t)call->info.clear_buffer.res;
+      rec->misc[0] = call->info.clear_buffer.offset;
+      rec->misc[1] = call->info.clear_buffer.size;
+      break;
+   default:
+      break;
+   }
+}
+
+static const char *
+dd_call_type_name(unsigned type)
+{
+   switch (type) {
+   case CALL_DRAW_VBO:
+      return "draw_vbo";
+   case CALL_LAUNCH_GRID:
+      return "launch_grid";
+   case CALL_RESOURCE_COPY_REGION:
+      return "resource_copy_region";
+   case CALL_BLIT:
+      return "blit";
+   case CALL_FLUSH_RESOURCE:
+      return "flush_resource";
+   case CALL_CLEAR:
+      return "clear";
+   case CALL_CLEAR_BUFFER:
+      return "clear_buffer";
+   case CALL_CLEAR_RENDER_TARGET:
+      return "clear_render_target";
+   case CALL_CLEAR_DEPTH_STENCIL:
+      return "clear_depth_stencil";
+   default:
+      return "unknown";
+   }
+}
+
+static void
+dd_dump_flight_ring(struct dd_context *dctx, FILE *f)
+{
+   unsigned num = MIN2(dctx->flight_head, DD_FLIGHT_RING_SIZE);
+   unsigned first = dctx->flight_head - num;
+   unsigned i;
+
+   if (!num)
+      return;
+
+   fprintf(f, "Flight recorder (last %u calls, oldest first):\n", num);
+   for (i = 0; i < num; i++) {
+      struct dd_flight_record *rec =
+         &dctx->flight_ring[(first + i) % DD_FLIGHT_RING_SIZE];
+
+      fprintf(f, "  %12lli us, draw call %u: %s, dst = %p, src = %p, "
+              "misc = {%u, %u}\n",
+              (long long)rec->time, rec->draw_call,
+              dd_call_type_name(rec->type),
+              (void*)rec->dst, (void*)rec->src,
+              rec->misc[0], rec->misc[1]);
+   }
+   fprintf(f, "\n");
+}
+
 static void
 dd_kill_process(void)
 {
@@ -569,6 +667,7 @@ dd_flush_and_handle_hang(struct dd_context *dctx,
 
       if (f) {
          fprintf(f, "dd: %s.\n", cause);
+         dd_dump_flight_ring(dctx, f);
          dd_dump_driver_state(dctx, f, PIPE_DEBUG_DEVICE_IS_HUNG);
          dd_close_file_stream(f);
       }
@@ -587,6 +686,7 @@ dd_context_flush(struct pipe_context *_pipe,
 
    switch (dd_screen(dctx->base.screen)->mode) {
    case DD_DETECT_HANGS:
+   case DD_FLIGHT_RECORD:
       dd_flush_and_handle_hang(dctx, fence, flags,
                                "GPU hang detected in pipe->flush()");
       break;
@@ -633,6 +733,12 @@ dd_after_draw(struct dd_context *dctx, struct dd_call *call)
             pipe->flush(pipe, NULL, 0);
          dd_dump_call(dctx, call, 0);
          break;
+      case DD_FLIGHT_RECORD:
+         /* Just record the fingerprint; hangs are detected in pipe->flush
+          * and the ring is dumped there.
+          */
+         dd_flight_record(dctx, call);
+         break;
       default:
          assert(0);
       }
@@ -35,7 +35,8 @@
 
 enum dd_mode {
    DD_DETECT_HANGS,
-   DD_DUMP_ALL_CALLS
+   DD_DUMP_ALL_CALLS,
+   DD_FLIGHT_RECORD
 };
 
 struct dd_screen
@@ -72,6 +73,22 @@ struct dd_state
    } state;
 };
 
+/* Compact fingerprint of one call, cheap enough to record on every call.
+ * Written into a fixed-size ring in DD_FLIGHT_RECORD mode and only dumped
+ * when a hang is detected.
+ */
+struct dd_flight_record
+{
+   int64_t time; /* os_time_get() */
+   unsigned draw_call;
+   unsigned type; /* enum call_type */
+   uintptr_t dst, src; /* identifying resources, if any */
+   unsigned misc[2]; /* type-dependent details */
+};
+
+/* must be a power of two */
+#define DD_FLIGHT_RING_SIZE 256
+
 struct dd_context
 {
    struct pipe_context base;
@@ -114,6 +131,9 @@ struct dd_context
    float tess_default_levels[6];
 
    unsigned num_draw_calls;
+
+   struct dd_flight_record flight_ring[DD_FLIGHT_RING_SIZE];
+   unsigned flight_head; /* total number of records written */
 };
 
 
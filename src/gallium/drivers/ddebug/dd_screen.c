@@ -284,6 +284,7 @@ ddebug_screen_create(struct pipe_screen *screen)
    struct dd_screen *dscreen;
    const char *option = debug_get_option("GALLIUM_DDEBUG", NULL);
    bool dump_always = option && !strncmp(option, "always", 6);
+   bool flight = option && !strncmp(option, "flight", 6);
    bool no_flush = option && strstr(option, "noflush");
    bool help = option && !strcmp(option, "help");
    unsigned timeout = 0;
@@ -302,6 +303,12 @@ ddebug_screen_create(struct pipe_screen *screen)
       puts("    fence timeout and dump context and driver information into");
       puts("    $HOME/"DD_DIR"/ when a hang is detected.");
       puts("");
+      puts("  GALLIUM_DDEBUG=\"flight [timeout in ms]\"");
+      puts("    Flight recorder: log a compact fingerprint of every draw call into a");
+      puts("    fixed-size memory ring without flushing, and dump the ring into");
+      puts("    $HOME/"DD_DIR"/ when a hang is detected in pipe->flush (default");
+      puts("    timeout 1000 ms). Cheap enough to stay enabled in production.");
+      puts("");
       puts("  If 'noflush' is specified, do not flush on every draw call. In hang");
       puts("  detection mode, this only detect hangs in pipe->flush.");
       puts("  If 'verbose' is specified, additional information is written to stderr.");
@@ -314,8 +321,10 @@ ddebug_screen_create(struct pipe_screen *screen)
 
    if (!option)
       return screen;
-   if (!dump_always && sscanf(option, "%u", &timeout) != 1)
+   if (!dump_always && !flight && sscanf(option, "%u", &timeout) != 1)
       return screen;
+   if (flight && sscanf(option + 6, "%u", &timeout) != 1)
+      timeout = 1000;
 
    dscreen = CALLOC_STRUCT(dd_screen);
    if (!dscreen)
@@ -354,7 +363,8 @@ ddebug_screen_create(struct pipe_screen *screen)
 
    dscreen->screen = screen;
    dscreen->timeout_ms = timeout;
-   dscreen->mode = dump_always ? DD_DUMP_ALL_CALLS : DD_DETECT_HANGS;
+   dscreen->mode = dump_always ? DD_DUMP_ALL_CALLS :
+                   flight ? DD_FLIGHT_RECORD : DD_DETECT_HANGS;
    dscreen->no_flush = no_flush;
    dscreen->verbose = strstr(option, "verbose") != NULL;
 
@@ -366,6 +376,10 @@ ddebug_screen_create(struct pipe_screen *screen)
       fprintf(stderr, "Gallium debugger active. "
               "The hang detection timout is %i ms.\n", timeout);
       break;
+   case DD_FLIGHT_RECORD:
+      fprintf(stderr, "Gallium debugger active in flight recorder mode. "
+              "The hang detection timout is %i ms.\n", timeout);
+      break;
    default:
       assert(0);
    }
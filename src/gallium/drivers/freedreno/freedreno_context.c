@@ -260,7 +260,9 @@ fd_context_init(struct fd_context *ctx, struct pipe_screen *pscreen,
 	fd_context_next_rb(pctx);
 	fd_reset_wfi(ctx);
 
-	util_dynarray_init(&ctx->draw_patches);
+	util_dynarray_init_with_storage(&ctx->draw_patches,
+			ctx->draw_patches_storage,
+			sizeof(ctx->draw_patches_storage));
 
 	util_slab_create(&ctx->transfer_pool, sizeof(struct fd_transfer),
 			16, UTIL_SLAB_SINGLETHREADED);
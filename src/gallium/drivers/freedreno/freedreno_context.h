@@ -288,6 +288,11 @@ struct fd_context {
 	 */
 	struct util_dynarray draw_patches;
 
+	/* Most batches have few enough draws that the patch list fits in this
+	 * embedded storage, so the dynarray never hits the heap.
+	 */
+	uint8_t draw_patches_storage[64 * sizeof(struct fd_cs_patch)];
+
 	struct pipe_scissor_state scissor;
 
 	/* we don't have a disable/enable bit for scissor, so instead we keep
@@ -29,6 +29,7 @@
 #include "pipe/p_state.h"
 #include "util/u_dual_blend.h"
 #include "util/u_string.h"
+#include "util/u_framebuffer.h"
 #include "util/u_memory.h"
 #include "util/u_helpers.h"
 
@@ -124,6 +125,15 @@ fd_set_framebuffer_state(struct pipe_context *pctx,
 	DBG("%d: cbufs[0]=%p, zsbuf=%p", ctx->needs_flush,
 			framebuffer->cbufs[0], framebuffer->zsbuf);
 
+	/* Re-binding the current framebuffer is not a render pass boundary,
+	 * so keep accumulating draws into the current pass rather than
+	 * taking a gmem resolve/restore round-trip.  The state trackers
+	 * re-emit fb state much more often than they actually switch
+	 * render targets.
+	 */
+	if (util_framebuffer_state_equal(cso, framebuffer))
+		return;
+
 	fd_context_render(pctx);
 
 	if ((cso->width != framebuffer->width) ||
@@ -172,6 +172,7 @@ ir3_optimize_nir(struct ir3_shader *shader, nir_shader *s,
 		debug_printf("----------------------\n");
 	}
 
+	nir_compact(s);
 	nir_sweep(s);
 
 	return s;
@@ -41,6 +41,7 @@
 #include "util/u_blitter.h"
 
 
+struct draw_vertex_shader;
 struct i915_winsys;
 struct i915_winsys_buffer;
 struct i915_winsys_batchbuffer;
@@ -216,6 +217,18 @@ struct i915_velems_state {
 };
 
 
+/**
+ * Subclass of pipe_shader_state (vertex shaders are executed by the draw
+ * module, we only keep what the vertex layout cache needs to key on).
+ */
+struct i915_vertex_shader {
+   struct draw_vertex_shader *draw_shader;
+
+   /** CRC of the TGSI tokens, identifies the output signature */
+   uint32_t signature_hash;
+};
+
+
 struct i915_context {
    struct pipe_context base;
 
@@ -233,7 +246,7 @@ struct i915_context {
 
    struct i915_fragment_shader *fs;
 
-   void *vs;
+   struct i915_vertex_shader *vs;
 
    struct i915_velems_state *velems;
    unsigned nr_vertex_buffers;
@@ -537,6 +537,9 @@ i915_destroy_screen(struct pipe_screen *screen)
    if (is->iws)
       is->iws->destroy(is->iws);
 
+   i915_vertex_layout_cache_destroy(is->layout_cache);
+   pipe_mutex_destroy(is->layout_mutex);
+
    FREE(is);
 }
 
@@ -577,6 +580,13 @@ i915_screen_create(struct i915_winsys *iws)
 
    is->iws = iws;
 
+   is->layout_cache = i915_vertex_layout_cache_create();
+   if (!is->layout_cache) {
+      FREE(is);
+      return NULL;
+   }
+   pipe_mutex_init(is->layout_mutex);
+
    is->base.destroy = i915_destroy_screen;
    is->base.flush_frontbuffer = i915_flush_frontbuffer;
 
@@ -31,8 +31,11 @@
 #include "pipe/p_state.h"
 #include "pipe/p_screen.h"
 
+#include "os/os_thread.h"
+
 
 struct i915_winsys;
+struct i915_vertex_layout_cache;
 
 
 /**
@@ -51,9 +54,20 @@ struct i915_screen
       boolean lie;
       boolean use_blitter;
    } debug;
+
+   /** Vertex layouts translated so far, shared by all contexts.
+    *  Protected by layout_mutex.
+    */
+   struct i915_vertex_layout_cache *layout_cache;
+   pipe_mutex layout_mutex;
 };
 
 
+struct i915_vertex_layout_cache *i915_vertex_layout_cache_create(void);
+
+void i915_vertex_layout_cache_destroy(struct i915_vertex_layout_cache *cache);
+
+
 /*
  * Cast wrappers
  */
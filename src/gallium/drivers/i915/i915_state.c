@@ -30,6 +30,7 @@
 
 
 #include "draw/draw_context.h"
+#include "util/u_hash.h"
 #include "util/u_helpers.h"
 #include "util/u_inlines.h"
 #include "util/u_math.h"
@@ -645,22 +646,38 @@ i915_create_vs_state(struct pipe_context *pipe,
                      const struct pipe_shader_state *templ)
 {
    struct i915_context *i915 = i915_context(pipe);
+   struct i915_vertex_shader *ivs = CALLOC_STRUCT(i915_vertex_shader);
 
-   /* just pass-through to draw module */
-   return draw_create_vertex_shader(i915->draw, templ);
+   if (!ivs)
+      return NULL;
+
+   /* the shader is executed by the draw module */
+   ivs->draw_shader = draw_create_vertex_shader(i915->draw, templ);
+   if (!ivs->draw_shader) {
+      FREE(ivs);
+      return NULL;
+   }
+
+   /* identifies the output signature in the vertex layout cache */
+   ivs->signature_hash =
+      util_hash_crc32(templ->tokens,
+                      tgsi_num_tokens(templ->tokens) *
+                      sizeof(struct tgsi_token));
+
+   return ivs;
 }
 
 static void i915_bind_vs_state(struct pipe_context *pipe, void *shader)
 {
    struct i915_context *i915 = i915_context(pipe);
+   struct i915_vertex_shader *ivs = (struct i915_vertex_shader *) shader;
 
-   if (i915->vs == shader)
+   if (i915->vs == ivs)
       return;
 
-   i915->vs = shader;
+   i915->vs = ivs;
 
-   /* just pass-through to draw module */
-   draw_bind_vertex_shader(i915->draw, (struct draw_vertex_shader *) shader);
+   draw_bind_vertex_shader(i915->draw, ivs ? ivs->draw_shader : NULL);
 
    i915->dirty |= I915_NEW_VS;
 }
@@ -668,9 +685,10 @@ static void i915_bind_vs_state(struct pipe_context *pipe, void *shader)
 static void i915_delete_vs_state(struct pipe_context *pipe, void *shader)
 {
    struct i915_context *i915 = i915_context(pipe);
+   struct i915_vertex_shader *ivs = (struct i915_vertex_shader *) shader;
 
-   /* just pass-through to draw module */
-   draw_delete_vertex_shader(i915->draw, (struct draw_vertex_shader *) shader);
+   draw_delete_vertex_shader(i915->draw, ivs->draw_shader);
+   FREE(ivs);
 }
 
 static void i915_set_constant_buffer(struct pipe_context *pipe,
@@ -26,16 +26,82 @@
  **************************************************************************/
 
 
+#include "util/u_hash.h"
 #include "util/u_memory.h"
 #include "pipe/p_shader_tokens.h"
 #include "draw/draw_context.h"
 #include "draw/draw_vertex.h"
 #include "i915_context.h"
+#include "i915_screen.h"
 #include "i915_state.h"
 #include "i915_debug.h"
 #include "i915_fpc.h"
 #include "i915_reg.h"
 
+
+/***********************************************************************
+ * Screen-level cache of derived vertex layouts.
+ *
+ * The layout is a pure function of the fragment shader's inputs and the
+ * vertex shader's output signature, so layouts translated by one context
+ * can be reused by all the others instead of being recomputed per state
+ * change.
+ */
+
+struct i915_vertex_layout_key {
+   uint32_t vs_signature;
+   uint32_t num_inputs;
+   ubyte semantic_name[PIPE_MAX_SHADER_INPUTS];
+   ubyte semantic_index[PIPE_MAX_SHADER_INPUTS];
+   int generic_mapping[I915_TEX_UNITS];
+};
+
+struct i915_vertex_layout_entry {
+   boolean valid;
+   struct i915_vertex_layout_key key;
+   struct vertex_info vinfo;
+};
+
+#define I915_VERTEX_LAYOUT_CACHE_SIZE 32
+
+struct i915_vertex_layout_cache {
+   struct i915_vertex_layout_entry entry[I915_VERTEX_LAYOUT_CACHE_SIZE];
+};
+
+
+struct i915_vertex_layout_cache *
+i915_vertex_layout_cache_create(void)
+{
+   return CALLOC_STRUCT(i915_vertex_layout_cache);
+}
+
+
+void
+i915_vertex_layout_cache_destroy(struct i915_vertex_layout_cache *cache)
+{
+   FREE(cache);
+}
+
+
+static void make_vertex_layout_key(const struct i915_context *i915,
+                                   struct i915_vertex_layout_key *key)
+{
+   const struct i915_fragment_shader *fs = i915->fs;
+   uint i;
+
+   memset(key, 0, sizeof(*key));
+
+   key->vs_signature = i915->vs ? i915->vs->signature_hash : 0;
+   key->num_inputs = fs->info.num_inputs;
+   for (i = 0; i < fs->info.num_inputs; i++) {
+      key->semantic_name[i] = fs->info.input_semantic_name[i];
+      key->semantic_index[i] = fs->info.input_semantic_index[i];
+   }
+   memcpy(key->generic_mapping, fs->generic_mapping,
+          sizeof(key->generic_mapping));
+}
+
+
 static uint find_mapping(const struct i915_fragment_shader* fs, int unit)
 {
    int i;
@@ -51,10 +117,10 @@ static uint find_mapping(const struct i915_fragment_shader* fs, int unit)
 
 
 /***********************************************************************
- * Determine the hardware vertex layout.
- * Depends on vertex/fragment shader state.
+ * Translate the hardware vertex layout from the shader state.
  */
-static void calculate_vertex_layout(struct i915_context *i915)
+static void translate_vertex_layout(struct i915_context *i915,
+                                    struct vertex_info *vinfo_out)
 {
    const struct i915_fragment_shader *fs = i915->fs;
    struct vertex_info vinfo;
@@ -170,6 +236,46 @@ static void calculate_vertex_layout(struct i915_context *i915)
 
    draw_compute_vertex_size(&vinfo);
 
+   *vinfo_out = vinfo;
+}
+
+
+/***********************************************************************
+ * Determine the hardware vertex layout.
+ * Depends on vertex/fragment shader state.
+ */
+static void calculate_vertex_layout(struct i915_context *i915)
+{
+   struct i915_screen *is = i915_screen(i915->base.screen);
+   struct i915_vertex_layout_key key;
+   struct i915_vertex_layout_entry *entry;
+   struct vertex_info vinfo;
+   boolean hit = FALSE;
+
+   /* See if this layout has already been translated, possibly by another
+    * context on the same screen.
+    */
+   make_vertex_layout_key(i915, &key);
+   entry = &is->layout_cache->entry[util_hash_crc32(&key, sizeof(key)) %
+                                    I915_VERTEX_LAYOUT_CACHE_SIZE];
+
+   pipe_mutex_lock(is->layout_mutex);
+   if (entry->valid && memcmp(&entry->key, &key, sizeof(key)) == 0) {
+      vinfo = entry->vinfo;
+      hit = TRUE;
+   }
+   pipe_mutex_unlock(is->layout_mutex);
+
+   if (!hit) {
+      translate_vertex_layout(i915, &vinfo);
+
+      pipe_mutex_lock(is->layout_mutex);
+      entry->key = key;
+      entry->vinfo = vinfo;
+      entry->valid = TRUE;
+      pipe_mutex_unlock(is->layout_mutex);
+   }
+
    if (memcmp(&i915->current.vertex_info, &vinfo, sizeof(vinfo))) {
       /* Need to set this flag so that the LIS2/4 registers get set.
        * It also means the i915_update_immediate() function must be called
@@ -39,6 +39,7 @@
 #include "util/simple_list.h"
 #include "lp_clear.h"
 #include "lp_context.h"
+#include "lp_screen.h"
 #include "lp_flush.h"
 #include "lp_perf.h"
 #include "lp_state.h"
@@ -58,6 +59,12 @@ static void llvmpipe_destroy( struct pipe_context *pipe )
 
    lp_print_counters();
 
+   /* No more variant compiles may be outstanding once we start tearing
+    * the context down.
+    */
+   if (util_queue_is_initialized(&llvmpipe->compile_queue))
+      util_queue_destroy(&llvmpipe->compile_queue);
+
    if (llvmpipe->blitter) {
       util_blitter_destroy(llvmpipe->blitter);
    }
@@ -133,6 +140,9 @@ llvmpipe_create_context(struct pipe_screen *screen, void *priv,
 {
    struct llvmpipe_context *llvmpipe;
 
+   if (!llvmpipe_screen_late_init(llvmpipe_screen(screen)))
+      return NULL;
+
    llvmpipe = align_malloc(sizeof(struct llvmpipe_context), 16);
    if (!llvmpipe)
       return NULL;
@@ -145,6 +155,11 @@ llvmpipe_create_context(struct pipe_screen *screen, void *priv,
 
    make_empty_list(&llvmpipe->setup_variants_list);
 
+   /* If thread creation fails we simply fall back to compiling variants
+    * synchronously on the application thread.
+    */
+   (void) util_queue_init(&llvmpipe->compile_queue, "lp_compile", 8, 1, 0);
+
 
    llvmpipe->pipe.screen = screen;
    llvmpipe->pipe.priv = priv;
@@ -35,6 +35,7 @@
 
 #include "draw/draw_vertex.h"
 #include "util/u_blitter.h"
+#include "util/u_queue.h"
 
 #include "lp_tex_sample.h"
 #include "lp_jit.h"
@@ -144,6 +145,9 @@ struct llvmpipe_context {
    unsigned nr_fs_variants;
    unsigned nr_fs_instrs;
 
+   /** Worker queue for asynchronous shader variant compilation */
+   struct util_queue compile_queue;
+
    struct lp_setup_variant_list_item setup_variants_list;
    unsigned nr_setup_variants;
 
@@ -52,8 +52,7 @@ lp_fence_create(unsigned rank)
 
    pipe_reference_init(&fence->reference, 1);
 
-   pipe_mutex_init(fence->mutex);
-   pipe_condvar_init(fence->signalled);
+   os_timeline_init(&fence->timeline);
 
    fence->id = fence_id++;
    fence->rank = rank;
@@ -72,8 +71,7 @@ lp_fence_destroy(struct lp_fence *fence)
    if (LP_DEBUG & DEBUG_FENCE)
       debug_printf("%s %d\n", __FUNCTION__, fence->id);
 
-   pipe_mutex_destroy(fence->mutex);
-   pipe_condvar_destroy(fence->signalled);
+   os_timeline_destroy(&fence->timeline);
    FREE(fence);
 }
 
@@ -85,29 +83,23 @@ lp_fence_destroy(struct lp_fence *fence)
 void
 lp_fence_signal(struct lp_fence *fence)
 {
+   uint64_t count;
+
    if (LP_DEBUG & DEBUG_FENCE)
       debug_printf("%s %d\n", __FUNCTION__, fence->id);
 
-   pipe_mutex_lock(fence->mutex);
-
-   fence->count++;
-   assert(fence->count <= fence->rank);
+   count = os_timeline_advance(&fence->timeline);
+   assert(count <= fence->rank);
 
    if (LP_DEBUG & DEBUG_FENCE)
       debug_printf("%s count=%u rank=%u\n", __FUNCTION__,
-                   fence->count, fence->rank);
-
-   /* Wakeup all threads waiting on the mutex:
-    */
-   pipe_condvar_broadcast(fence->signalled);
-
-   pipe_mutex_unlock(fence->mutex);
+                   (unsigned) count, fence->rank);
 }
 
 boolean
 lp_fence_signalled(struct lp_fence *f)
 {
-   return f->count == f->rank;
+   return os_timeline_passed(&f->timeline, f->rank);
 }
 
 void
@@ -116,12 +108,8 @@ lp_fence_wait(struct lp_fence *f)
    if (LP_DEBUG & DEBUG_FENCE)
       debug_printf("%s %d\n", __FUNCTION__, f->id);
 
-   pipe_mutex_lock(f->mutex);
    assert(f->issued);
-   while (f->count < f->rank) {
-      pipe_condvar_wait(f->signalled, f->mutex);
-   }
-   pipe_mutex_unlock(f->mutex);
+   os_timeline_wait(&f->timeline, f->rank, PIPE_TIMEOUT_INFINITE);
 }
 
 
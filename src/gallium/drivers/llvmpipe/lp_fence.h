@@ -31,6 +31,7 @@
 
 
 #include "os/os_thread.h"
+#include "os/os_timeline.h"
 #include "pipe/p_state.h"
 #include "util/u_inlines.h"
 
@@ -43,12 +44,13 @@ struct lp_fence
    struct pipe_reference reference;
    unsigned id;
 
-   pipe_mutex mutex;
-   pipe_condvar signalled;
+   /* Each rendering thread advances the timeline by one when it hits the
+    * fence; the fence is finished once the timeline reaches rank.
+    */
+   struct os_timeline timeline;
 
    boolean issued;
    unsigned rank;
-   unsigned count;
 };
 
 
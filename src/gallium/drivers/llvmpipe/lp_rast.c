@@ -25,8 +25,10 @@
  *
  **************************************************************************/
 
+#include <float.h>
 #include <limits.h>
 #include "util/u_memory.h"
+#include "util/u_format.h"
 #include "util/u_math.h"
 #include "util/u_rect.h"
 #include "util/u_surface.h"
@@ -69,7 +71,7 @@ lp_rast_begin( struct lp_rasterizer *rast,
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
    lp_scene_begin_rasterization( scene );
-   lp_scene_bin_iter_begin( scene );
+   lp_scene_bin_iter_begin( scene, MAX2(rast->num_threads, 1) );
 }
 
 
@@ -108,6 +110,10 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
    task->thread_data.vis_counter = 0;
    task->ps_invocations = 0;
 
+   /* The depth buffer contents are unknown until we see a clear. */
+   task->tile_zmin = -FLT_MAX;
+   task->tile_zmax = FLT_MAX;
+
    for (i = 0; i < task->scene->fb.nr_cbufs; i++) {
       if (task->scene->fb.cbufs[i]) {
          task->color_tiles[i] = scene->cbufs[i].map +
@@ -280,11 +286,137 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
          }
          dst_layer += scene->zsbuf.layer_stride;
       }
+
+      /*
+       * If the clear covered all depth bits we know the exact depth bounds
+       * of the tile, which allows coarse z rejection of later primitives.
+       */
+      {
+         enum pipe_format format = scene->fb.zsbuf->format;
+         uint64_t zmask64 = util_pack64_mask_z_stencil(format, ~0, 0);
+
+         if (zmask64 &&
+             (arg.clear_zstencil.mask & zmask64) == zmask64) {
+            union { uint8_t bytes[8]; uint16_t u16; uint32_t u32; uint64_t u64; } zs;
+            float zf;
+
+            zs.u64 = 0;
+            switch (block_size) {
+            case 2:
+               zs.u16 = (uint16_t) clear_value;
+               break;
+            case 4:
+               zs.u32 = clear_value;
+               break;
+            case 8:
+               zs.u64 = clear_value64;
+               break;
+            default:
+               assert(0);
+               break;
+            }
+
+            util_format_description(format)->unpack_z_float(&zf, 0,
+                                                            zs.bytes, 0, 1, 1);
+            task->tile_zmin = zf;
+            task->tile_zmax = zf;
+         }
+      }
    }
 }
 
 
 
+/**
+ * Check whether a primitive with interpolated z in [zmin,zmax] can be
+ * discarded for this tile without shading, based on the coarse per-tile
+ * depth bounds.  Only valid when the depth test alone decides fragment
+ * visibility - any path that can produce side effects for depth-failing
+ * fragments (stencil, shader z writes) disqualifies the primitive.
+ */
+static boolean
+lp_rast_coarse_z_reject(const struct lp_rasterizer_task *task,
+                        const struct lp_rast_shader_inputs *inputs)
+{
+   const struct lp_rast_state *state = task->state;
+   const struct lp_fragment_shader_variant *variant;
+   const struct lp_fragment_shader_variant_key *key;
+
+   if (!state || task->scene->fb_max_layer > 0)
+      return FALSE;
+
+   variant = state->variant;
+   key = &variant->key;
+
+   if (!key->depth.enabled ||
+       key->depth_clamp ||
+       key->stencil[0].enabled ||
+       variant->shader->info.base.writes_z)
+      return FALSE;
+
+   switch (key->depth.func) {
+   case PIPE_FUNC_NEVER:
+      return TRUE;
+   case PIPE_FUNC_LESS:
+      return inputs->zmin >= task->tile_zmax;
+   case PIPE_FUNC_LEQUAL:
+      return inputs->zmin > task->tile_zmax;
+   case PIPE_FUNC_GREATER:
+      return inputs->zmax <= task->tile_zmin;
+   case PIPE_FUNC_GEQUAL:
+      return inputs->zmax < task->tile_zmin;
+   default:
+      return FALSE;
+   }
+}
+
+
+/**
+ * Tighten the coarse per-tile depth bounds after a primitive covering the
+ * whole tile has been shaded.  Requires that every pixel of the tile got
+ * an unconditional depth write for passing fragments, so anything which
+ * can suppress the write (discard, alpha test, stencil) disqualifies it.
+ */
+static void
+lp_rast_coarse_z_update(struct lp_rasterizer_task *task,
+                        const struct lp_rast_shader_inputs *inputs)
+{
+   const struct lp_fragment_shader_variant *variant = task->state->variant;
+   const struct lp_fragment_shader_variant_key *key = &variant->key;
+
+   if (task->scene->fb_max_layer > 0)
+      return;
+
+   if (!key->depth.enabled ||
+       !key->depth.writemask ||
+       key->depth_clamp ||
+       key->stencil[0].enabled ||
+       key->alpha.enabled ||
+       variant->shader->info.base.writes_z ||
+       variant->shader->info.base.uses_kill)
+      return;
+
+   switch (key->depth.func) {
+   case PIPE_FUNC_LESS:
+   case PIPE_FUNC_LEQUAL:
+      task->tile_zmin = MIN2(task->tile_zmin, inputs->zmin);
+      task->tile_zmax = MIN2(task->tile_zmax, inputs->zmax);
+      break;
+   case PIPE_FUNC_GREATER:
+   case PIPE_FUNC_GEQUAL:
+      task->tile_zmin = MAX2(task->tile_zmin, inputs->zmin);
+      task->tile_zmax = MAX2(task->tile_zmax, inputs->zmax);
+      break;
+   case PIPE_FUNC_ALWAYS:
+      task->tile_zmin = inputs->zmin;
+      task->tile_zmax = inputs->zmax;
+      break;
+   default:
+      break;
+   }
+}
+
+
 /**
  * Run the shader on all blocks in a tile.  This is used when a tile is
  * completely contained inside a triangle.
@@ -315,6 +447,15 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    }
    variant = state->variant;
 
+   /* Coarse hierarchical z: skip the whole tile if the depth test can't pass. */
+   if (lp_rast_coarse_z_reject(task, inputs)) {
+      LP_COUNT(nr_zreject_64);
+      return;
+   }
+
+   /* An asynchronously compiled variant may not have finished yet. */
+   lp_fs_variant_wait_for_compile(variant);
+
    /* render the whole 64x64 tile in 4x4 chunks */
    for (y = 0; y < task->height; y += 4){
       for (x = 0; x < task->width; x += 4) {
@@ -364,6 +505,9 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          END_JIT_CALL();
       }
    }
+
+   /* The whole tile was covered, so the depth bounds can be tightened. */
+   lp_rast_coarse_z_update(task, inputs);
 }
 
 
@@ -410,6 +554,9 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
 
    assert(state);
 
+   /* An asynchronously compiled variant may not have finished yet. */
+   lp_fs_variant_wait_for_compile(variant);
+
    /* Sanity checks */
    assert(x < scene->tiles_x * TILE_SIZE);
    assert(y < scene->tiles_y * TILE_SIZE);
@@ -606,7 +753,22 @@ do_rasterize_bin(struct lp_rasterizer_task *task,
 
    for (block = bin->head; block; block = block->next) {
       for (k = 0; k < block->count; k++) {
-         dispatch[block->cmd[k]]( task, block->arg[k] );
+         unsigned cmd = block->cmd[k];
+
+         /*
+          * Coarse hierarchical z: drop triangle commands that cannot pass
+          * the depth test anywhere in this tile before iterating stamps.
+          */
+         if (((cmd >= LP_RAST_OP_TRIANGLE_1 &&
+               cmd <= LP_RAST_OP_TRIANGLE_4_16) ||
+              (cmd >= LP_RAST_OP_TRIANGLE_32_1 &&
+               cmd <= LP_RAST_OP_TRIANGLE_32_4_16)) &&
+             lp_rast_coarse_z_reject(task, &block->arg[k].triangle.tri->inputs)) {
+            LP_COUNT(nr_zreject_64);
+            continue;
+         }
+
+         dispatch[cmd]( task, block->arg[k] );
       }
    }
 }
@@ -683,7 +845,8 @@ rasterize_scene(struct lp_rasterizer_task *task,
          int i, j;
 
          assert(scene);
-         while ((bin = lp_scene_bin_iter_next(scene, &i, &j))) {
+         while ((bin = lp_scene_bin_iter_next(scene, task->thread_index,
+                                              &i, &j))) {
             if (!is_empty_bin( bin ))
                rasterize_bin(task, bin, i, j);
          }
@@ -882,11 +1045,14 @@ lp_rast_create( unsigned num_threads )
    struct lp_rasterizer *rast;
    unsigned i;
 
-   rast = CALLOC_STRUCT(lp_rasterizer);
+   /* aligned allocation for the cache line aligned per-thread tasks */
+   rast = align_malloc(sizeof(struct lp_rasterizer), 64);
    if (!rast) {
       goto no_rast;
    }
 
+   memset(rast, 0, sizeof(struct lp_rasterizer));
+
    rast->full_scenes = lp_scene_queue_create();
    if (!rast->full_scenes) {
       goto no_full_scenes;
@@ -927,7 +1093,7 @@ no_thread_data_cache:
 
    lp_scene_queue_destroy(rast->full_scenes);
 no_full_scenes:
-   FREE(rast);
+   align_free(rast);
 no_rast:
    return NULL;
 }
@@ -975,7 +1141,7 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
 
    lp_scene_queue_destroy(rast->full_scenes);
 
-   FREE(rast);
+   align_free(rast);
 }
 
 
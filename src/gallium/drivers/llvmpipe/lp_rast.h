@@ -104,6 +104,9 @@ struct lp_rast_shader_inputs {
    unsigned stride;             /* how much to advance data between a0, dadx, dady */
    unsigned layer;              /* the layer to render to (from gs, already clamped) */
    unsigned viewport_index;     /* the active viewport index (from gs, already clamped) */
+   float zmin;                  /* conservative min interpolated z, for coarse z reject */
+   float zmax;                  /* conservative max interpolated z, for coarse z reject */
+   unsigned pad1[2];            /* keep a0, dadx, dady 16-byte aligned */
    /* followed by a0, dadx, dady and planes[] */
 };
 
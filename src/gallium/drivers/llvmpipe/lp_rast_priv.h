@@ -78,7 +78,11 @@ struct cmd_bin;
 
 /**
  * Per-thread rasterization state
+ *
+ * Aligned to a cache line so that the hot per-thread counters of
+ * adjacent tasks in lp_rasterizer::tasks don't false-share.
  */
+PIPE_ALIGN_TYPE(64,
 struct lp_rasterizer_task
 {
    const struct cmd_bin *bin;
@@ -91,6 +95,14 @@ struct lp_rasterizer_task
    uint8_t *color_tiles[PIPE_MAX_COLOR_BUFS];
    uint8_t *depth_tile;
 
+   /**
+    * Conservative bounds of the depth values currently in the tile's
+    * depth buffer, for coarse hierarchical z rejection.  Only tracked
+    * while rendering to layer 0.
+    */
+   float tile_zmin;
+   float tile_zmax;
+
    /** "back" pointer */
    struct lp_rasterizer *rast;
 
@@ -104,7 +116,7 @@ struct lp_rasterizer_task
 
    pipe_semaphore work_ready;
    pipe_semaphore work_done;
-};
+});
 
 
 /**
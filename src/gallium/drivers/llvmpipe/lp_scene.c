@@ -31,6 +31,7 @@
 #include "util/u_inlines.h"
 #include "util/simple_list.h"
 #include "util/u_format.h"
+#include "util/u_atomic.h"
 #include "lp_scene.h"
 #include "lp_fence.h"
 #include "lp_debug.h"
@@ -53,17 +54,18 @@ struct resource_ref {
 struct lp_scene *
 lp_scene_create( struct pipe_context *pipe )
 {
-   struct lp_scene *scene = CALLOC_STRUCT(lp_scene);
+   /* aligned allocation so that the cache line padding of the bins works */
+   struct lp_scene *scene = align_malloc(sizeof(struct lp_scene), 64);
    if (!scene)
       return NULL;
 
+   memset(scene, 0, sizeof(struct lp_scene));
+
    scene->pipe = pipe;
 
    scene->data.head =
       CALLOC_STRUCT(data_block);
 
-   pipe_mutex_init(scene->mutex);
-
 #ifdef DEBUG
    /* Do some scene limit sanity checks here */
    {
@@ -90,10 +92,9 @@ void
 lp_scene_destroy(struct lp_scene *scene)
 {
    lp_fence_reference(&scene->fence, NULL);
-   pipe_mutex_destroy(scene->mutex);
    assert(scene->data.head->next == NULL);
    FREE(scene->data.head);
-   FREE(scene);
+   align_free(scene);
 }
 
 
@@ -449,61 +450,61 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 
 
 
-/** advance curr_x,y to the next bin */
-static boolean
-next_bin(struct lp_scene *scene)
+/**
+ * Carve the bins up into one contiguous slice per rasterizer thread.
+ */
+void
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads )
 {
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
-   }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return FALSE;
-   }
-   return TRUE;
-}
+   const unsigned num_bins = scene->tiles_x * scene->tiles_y;
+   unsigned bins_per_slice, i;
 
+   assert(num_threads >= 1);
+   assert(num_threads <= LP_MAX_THREADS);
 
-void
-lp_scene_bin_iter_begin( struct lp_scene *scene )
-{
-   scene->curr_x = scene->curr_y = -1;
+   scene->num_slices = num_threads;
+   bins_per_slice = (num_bins + num_threads - 1) / num_threads;
+
+   for (i = 0; i < num_threads; i++) {
+      p_atomic_set(&scene->slice[i].next, MIN2(i * bins_per_slice, num_bins));
+      scene->slice[i].end = MIN2((i + 1) * bins_per_slice, num_bins);
+   }
 }
 
 
 /**
  * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
- * Multiple rendering threads will call this function to get a chunk
- * of work (a bin) to work on.
+ * Each rendering thread drains its own slice of bins first, which
+ * keeps the threads working on adjacent tiles and off each other's
+ * counters, and then steals bins from the remaining slices so that a
+ * few expensive tiles don't leave the other threads idle at the end
+ * of the scene.  No lock is taken on this path.
  */
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene , int *x, int *y)
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned thread_index,
+                        int *x, int *y )
 {
-   struct cmd_bin *bin = NULL;
+   const unsigned first = thread_index % scene->num_slices;
+   unsigned k;
 
-   pipe_mutex_lock(scene->mutex);
+   for (k = 0; k < scene->num_slices; k++) {
+      unsigned s = (first + k) % scene->num_slices;
+      int bin_idx;
 
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
-   }
-   else if (!next_bin(scene)) {
-      /* no more bins left */
-      goto end;
-   }
+      if (p_atomic_read(&scene->slice[s].next) >= scene->slice[s].end)
+         continue;
+
+      bin_idx = p_atomic_inc_return(&scene->slice[s].next) - 1;
+      if (bin_idx >= scene->slice[s].end)
+         continue;   /* lost the race for the slice's last bin */
 
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
+      *x = bin_idx % scene->tiles_x;
+      *y = bin_idx / scene->tiles_x;
+
+      return lp_scene_get_bin(scene, *x, *y);
+   }
 
-end:
-   /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
-   pipe_mutex_unlock(scene->mutex);
-   return bin;
+   return NULL;
 }
 
 
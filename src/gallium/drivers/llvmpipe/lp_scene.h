@@ -92,12 +92,16 @@ struct data_block {
 
 /**
  * For each screen tile we have one of these bins.
+ *
+ * Padded to a full cache line so that bins handed to different
+ * rasterizer threads never share one.
  */
+PIPE_ALIGN_TYPE(64,
 struct cmd_bin {
    const struct lp_rast_state *last_state;       /* most recent state set in bin */
    struct cmd_block *head;
    struct cmd_block *tail;
-};
+});
    
 
 /**
@@ -173,8 +177,18 @@ struct lp_scene {
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
-   pipe_mutex mutex;
+   /**
+    * Bin iteration state.  The bins are divided into one contiguous
+    * slice per rasterizer thread; each thread drains its own slice and
+    * then steals from the others.  Each slice gets its own cache line
+    * so threads normally only contend on their own counter.
+    */
+   struct {
+      int next;       /**< atomic counter, next bin in the slice */
+      int end;        /**< first bin past the end of the slice */
+      char pad[56];   /**< avoid false sharing between slices */
+   } slice[LP_MAX_THREADS];
+   unsigned num_slices;
 
    struct cmd_bin tile[TILES_X][TILES_Y];
    struct data_block_list data;
@@ -379,10 +393,11 @@ lp_scene_get_num_bins( const struct lp_scene *scene )
 
 
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene );
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads );
 
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene, int *x, int *y );
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned thread_index,
+                        int *x, int *y );
 
 
 
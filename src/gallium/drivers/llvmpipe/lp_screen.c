@@ -92,10 +92,47 @@ llvmpipe_get_vendor(struct pipe_screen *screen)
 }
 
 
+/**
+ * Finish the expensive parts of screen setup: LLVM initialization and the
+ * rasterizer threads.  Deferred from screen creation so that short-lived
+ * processes which create a screen but never render (GLX probes, thumbnailers)
+ * don't pay for them.
+ */
+boolean
+llvmpipe_screen_late_init(struct llvmpipe_screen *screen)
+{
+   boolean ret = TRUE;
+
+   pipe_mutex_lock(screen->late_init_mutex);
+
+   if (!screen->late_init_done) {
+      if (!lp_jit_screen_init(screen)) {
+         ret = FALSE;
+         goto out;
+      }
+
+      screen->rast = lp_rast_create(screen->num_threads);
+      if (!screen->rast) {
+         lp_jit_screen_cleanup(screen);
+         ret = FALSE;
+         goto out;
+      }
+
+      screen->late_init_done = TRUE;
+   }
+
+out:
+   pipe_mutex_unlock(screen->late_init_mutex);
+   return ret;
+}
+
+
 static const char *
 llvmpipe_get_name(struct pipe_screen *screen)
 {
    static char buf[100];
+   /* the native vector width is only known once LLVM has been set up */
+   llvmpipe_screen_late_init(llvmpipe_screen(screen));
    util_snprintf(buf, sizeof(buf), "llvmpipe (LLVM %u.%u, %u bits)",
 		 HAVE_LLVM >> 8, HAVE_LLVM & 0xff,
 		 lp_native_vector_width );
@@ -533,12 +570,14 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
    if (screen->rast)
       lp_rast_destroy(screen->rast);
 
-   lp_jit_screen_cleanup(screen);
+   if (screen->late_init_done)
+      lp_jit_screen_cleanup(screen);
 
    if(winsys->destroy)
       winsys->destroy(winsys);
 
    pipe_mutex_destroy(screen->rast_mutex);
+   pipe_mutex_destroy(screen->late_init_mutex);
 
    FREE(screen);
 }
@@ -605,11 +644,6 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    if (!screen)
       return NULL;
 
-   if (!lp_jit_screen_init(screen)) {
-      FREE(screen);
-      return NULL;
-   }
-
    screen->winsys = winsys;
 
    screen->base.destroy = llvmpipe_destroy_screen;
@@ -631,19 +665,20 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
 
    llvmpipe_init_screen_resource_funcs(&screen->base);
 
-   screen->num_threads = util_cpu_caps.nr_cpus > 1 ? util_cpu_caps.nr_cpus : 0;
+   /* One rasterizer thread per physical core; the threads are FPU-bound,
+    * so SMT siblings only add scheduling noise.
+    */
+   screen->num_threads = util_cpu_caps.nr_cores > 1 ? util_cpu_caps.nr_cores : 0;
 #ifdef PIPE_SUBSYSTEM_EMBEDDED
    screen->num_threads = 0;
 #endif
    screen->num_threads = debug_get_num_option("LP_NUM_THREADS", screen->num_threads);
    screen->num_threads = MIN2(screen->num_threads, LP_MAX_THREADS);
 
-   screen->rast = lp_rast_create(screen->num_threads);
-   if (!screen->rast) {
-      lp_jit_screen_cleanup(screen);
-      FREE(screen);
-      return NULL;
-   }
+   /* LLVM and the rasterizer threads are brought up by
+    * llvmpipe_screen_late_init() when the first context is created.
+    */
+   pipe_mutex_init(screen->late_init_mutex);
    pipe_mutex_init(screen->rast_mutex);
 
    util_format_s3tc_init();
@@ -57,9 +57,17 @@ struct llvmpipe_screen
 
    struct lp_rasterizer *rast;
    pipe_mutex rast_mutex;
+
+   /* the expensive parts of screen setup are done on first use */
+   boolean late_init_done;
+   pipe_mutex late_init_mutex;
 };
 
 
+boolean
+llvmpipe_screen_late_init(struct llvmpipe_screen *screen);
+
+
 
 
 static inline struct llvmpipe_screen *
@@ -266,16 +266,184 @@ begin_binning( struct lp_setup_context *setup )
 }
 
 
-/* This basically bins and then flushes any outstanding full-screen
- * clears.  
+/**
+ * Can a clear of the given surface be deferred as per-resource
+ * metadata (see llvmpipe_resource::pending_clear)?
  *
- * TODO: fast path for fullscreen clears and no triangles.
+ * The clear value is tracked for the whole resource, so the surface
+ * must cover all of it, and materialization happens outside the
+ * ordinary command stream, so no queued scene may still reference
+ * the resource.
+ */
+static boolean
+lp_setup_can_defer_clear(struct lp_setup_context *setup,
+                         struct pipe_surface *surf)
+{
+   struct llvmpipe_resource *lpr = llvmpipe_resource(surf->texture);
+   unsigned num_layers;
+
+   if (lpr->dt || !llvmpipe_resource_is_texture(surf->texture))
+      return FALSE;
+
+   if (surf->format != surf->texture->format)
+      return FALSE;
+
+   if (surf->texture->last_level > 0 || surf->u.tex.level > 0)
+      return FALSE;
+
+   if (surf->texture->target == PIPE_TEXTURE_3D)
+      num_layers = surf->texture->depth0;
+   else
+      num_layers = surf->texture->array_size;
+
+   if (surf->u.tex.first_layer != 0 ||
+       surf->u.tex.last_layer != num_layers - 1)
+      return FALSE;
+
+   if (surf->width != surf->texture->width0 ||
+       surf->height != surf->texture->height0)
+      return FALSE;
+
+   if (llvmpipe_is_resource_referenced(setup->pipe, surf->texture, 0) !=
+       LP_UNREFERENCED)
+      return FALSE;
+
+   return TRUE;
+}
+
+
+/**
+ * Resolve deferred clears on the current framebuffer.
+ * A full clear binned by this scene supersedes a deferred one, so the
+ * latter can simply be dropped; otherwise the deferred clear value
+ * must be written out since the scene may read or partially overwrite
+ * the buffer.
+ */
+static void
+lp_setup_resolve_pending_clears(struct lp_setup_context *setup)
+{
+   unsigned i;
+
+   for (i = 0; i < setup->fb.nr_cbufs; i++) {
+      struct pipe_surface *cbuf = setup->fb.cbufs[i];
+      struct llvmpipe_resource *lpr;
+
+      if (!cbuf)
+         continue;
+
+      lpr = llvmpipe_resource(cbuf->texture);
+      if (!lpr->pending_clear)
+         continue;
+
+      assert(PIPE_CLEAR_COLOR0 == 1 << 2);
+      if ((setup->clear.flags & (1 << (2 + i))) &&
+          lp_setup_can_defer_clear(setup, cbuf))
+         lpr->pending_clear = FALSE;
+      else
+         llvmpipe_resource_materialize_clear(lpr);
+   }
+
+   if (setup->fb.zsbuf) {
+      struct pipe_surface *zsbuf = setup->fb.zsbuf;
+      struct llvmpipe_resource *lpr = llvmpipe_resource(zsbuf->texture);
+
+      if (lpr->pending_clear) {
+         uint64_t zsmask_full =
+            util_pack64_mask_z_stencil(zsbuf->format, ~0, ~0);
+
+         if ((setup->clear.flags & PIPE_CLEAR_DEPTHSTENCIL) &&
+             (setup->clear.zsmask & zsmask_full) == zsmask_full &&
+             lp_setup_can_defer_clear(setup, zsbuf))
+            lpr->pending_clear = FALSE;
+         else
+            llvmpipe_resource_materialize_clear(lpr);
+      }
+   }
+}
+
+
+/**
+ * Turn the accumulated clears of a clear-only scene into per-resource
+ * metadata where possible, so nothing gets written until somebody
+ * actually reads or renders to the buffer.  Buffers which don't
+ * qualify keep their clear flags and get binned as usual.
+ */
+static void
+lp_setup_try_defer_clears(struct lp_setup_context *setup)
+{
+   unsigned i;
+
+   if (setup->active_binned_queries)
+      return;
+
+   for (i = 0; i < setup->fb.nr_cbufs; i++) {
+      struct pipe_surface *cbuf = setup->fb.cbufs[i];
+      struct llvmpipe_resource *lpr;
+
+      assert(PIPE_CLEAR_COLOR0 == 1 << 2);
+      if (!cbuf || !(setup->clear.flags & (1 << (2 + i))))
+         continue;
+
+      if (!lp_setup_can_defer_clear(setup, cbuf))
+         continue;
+
+      lpr = llvmpipe_resource(cbuf->texture);
+      lpr->pending_clear = TRUE;
+      lpr->clear_value = setup->clear.color_val[i];
+      lpr->clear_pixel_size = util_format_get_blocksize(cbuf->format);
+      setup->clear.flags &= ~(1 << (2 + i));
+   }
+
+   if (setup->fb.zsbuf && (setup->clear.flags & PIPE_CLEAR_DEPTHSTENCIL)) {
+      struct pipe_surface *zsbuf = setup->fb.zsbuf;
+      uint64_t zsmask_full =
+         util_pack64_mask_z_stencil(zsbuf->format, ~0, ~0);
+
+      /* Only defer if all bits get written, so materialization never
+       * needs a read-modify-write.
+       */
+      if ((setup->clear.zsmask & zsmask_full) == zsmask_full &&
+          lp_setup_can_defer_clear(setup, zsbuf)) {
+         struct llvmpipe_resource *lpr = llvmpipe_resource(zsbuf->texture);
+
+         lpr->pending_clear = TRUE;
+         lpr->clear_pixel_size = util_format_get_blocksize(zsbuf->format);
+         memset(&lpr->clear_value, 0, sizeof lpr->clear_value);
+         switch (lpr->clear_pixel_size) {
+         case 2:
+            lpr->clear_value.us = (uint16_t) setup->clear.zsvalue;
+            break;
+         case 4:
+            lpr->clear_value.ui[0] = (uint32_t) setup->clear.zsvalue;
+            break;
+         default:
+            assert(lpr->clear_pixel_size == 8);
+            memcpy(&lpr->clear_value, &setup->clear.zsvalue,
+                   sizeof setup->clear.zsvalue);
+            break;
+         }
+         setup->clear.flags &= ~PIPE_CLEAR_DEPTHSTENCIL;
+         setup->clear.zsmask = 0;
+         setup->clear.zsvalue = 0;
+      }
+   }
+}
+
+
+/* This basically bins and then flushes any outstanding full-screen
+ * clears.
  */
 static boolean
 execute_clears( struct lp_setup_context *setup )
 {
    LP_DBG(DEBUG_SETUP, "%s\n", __FUNCTION__);
 
+   /* The scene contains nothing but clears, so full-buffer ones can
+    * become metadata instead of burning memory bandwidth now.
+    */
+   lp_setup_resolve_pending_clears( setup );
+   lp_setup_try_defer_clears( setup );
+
    return begin_binning( setup );
 }
 
@@ -318,6 +486,7 @@ set_scene_state( struct lp_setup_context *setup,
       break;
 
    case SETUP_ACTIVE:
+      lp_setup_resolve_pending_clears( setup );
       if (!begin_binning( setup ))
          goto fail;
       break;
@@ -1168,6 +1337,15 @@ try_update_scene_state( struct lp_setup_context *setup )
           */
          for (i = 0; i < ARRAY_SIZE(setup->fs.current_tex); i++) {
             if (setup->fs.current_tex[i]) {
+               struct llvmpipe_resource *lpr =
+                  llvmpipe_resource(setup->fs.current_tex[i]);
+
+               /* Deferred clears must hit memory before the scene
+                * samples the texture.
+                */
+               if (lpr->pending_clear)
+                  llvmpipe_resource_materialize_clear(lpr);
+
                if (!lp_scene_add_resource_reference(scene,
                                                     setup->fs.current_tex[i],
                                                     new_scene)) {
@@ -649,6 +649,10 @@ try_setup_line( struct lp_setup_context *setup,
    line->inputs.layer = layer;
    line->inputs.viewport_index = viewport_index;
 
+   /* z is interpolated between the endpoints only */
+   line->inputs.zmin = MIN2(v1[0][2], v2[0][2]);
+   line->inputs.zmax = MAX2(v1[0][2], v2[0][2]);
+
    /*
     * XXX: this code is mostly identical to the one in lp_setup_tri, except it
     * uses 4 planes instead of 3. Could share the code (including the sse
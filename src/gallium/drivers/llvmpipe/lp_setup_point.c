@@ -489,6 +489,10 @@ try_setup_point( struct lp_setup_context *setup,
    point->inputs.layer = layer;
    point->inputs.viewport_index = viewport_index;
 
+   /* points have constant z */
+   point->inputs.zmin = v0[0][2];
+   point->inputs.zmax = v0[0][2];
+
    {
       struct lp_rast_plane *plane = GET_PLANES(point);
 
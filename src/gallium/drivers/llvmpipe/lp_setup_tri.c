@@ -57,6 +57,26 @@ subpixel_snap(float a)
    return util_iround(FIXED_ONE * a);
 }
 
+#if defined(PIPE_ARCH_SSE)
+/*
+ * Emulate _mm_min_epi32/_mm_max_epi32 (SSE4.1) with SSE2, same trick
+ * as the mul helpers in u_sse.h.
+ */
+static inline __m128i
+mm_min_epi32(__m128i a, __m128i b)
+{
+   __m128i mask = _mm_cmpgt_epi32(a, b);
+   return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a));
+}
+
+static inline __m128i
+mm_max_epi32(__m128i a, __m128i b)
+{
+   __m128i mask = _mm_cmpgt_epi32(a, b);
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
 static inline float
 fixed_to_float(int a)
 {
@@ -313,6 +333,34 @@ do_triangle_ccw(struct lp_setup_context *setup,
        */
       int adj = (setup->bottom_edge_rule != 0) ? 1 : 0;
 
+#if defined(PIPE_ARCH_SSE)
+      /*
+       * Vectorized min/max over the three vertices.  Lane 3 of
+       * position->x/y is undefined so replicate lane 0 into it before
+       * the horizontal reduction.
+       */
+      __m128i vx = _mm_load_si128((__m128i *)position->x);
+      __m128i vy = _mm_load_si128((__m128i *)position->y);
+      __m128i vmin, vmax, t;
+
+      vx = _mm_shuffle_epi32(vx, _MM_SHUFFLE(0,2,1,0));
+      vy = _mm_shuffle_epi32(vy, _MM_SHUFFLE(0,2,1,0));
+
+      /* transpose-free: reduce x and y at the same time */
+      t = _mm_unpacklo_epi64(vx, vy);               /* x0 x1 y0 y1 */
+      vmin = mm_min_epi32(t, _mm_unpackhi_epi64(vx, vy));
+      vmax = mm_max_epi32(t, _mm_unpackhi_epi64(vx, vy));
+      vmin = mm_min_epi32(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(2,3,0,1)));
+      vmax = mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(2,3,0,1)));
+
+      /* Inclusive x0, exclusive x1 */
+      bbox.x0 =  _mm_cvtsi128_si32(vmin) >> FIXED_ORDER;
+      bbox.x1 = (_mm_cvtsi128_si32(vmax) - 1) >> FIXED_ORDER;
+
+      /* Inclusive / exclusive depending upon adj (bottom-left or top-right) */
+      bbox.y0 = (_mm_cvtsi128_si32(_mm_shuffle_epi32(vmin, _MM_SHUFFLE(0,0,0,2))) + adj) >> FIXED_ORDER;
+      bbox.y1 = (_mm_cvtsi128_si32(_mm_shuffle_epi32(vmax, _MM_SHUFFLE(0,0,0,2))) - 1 + adj) >> FIXED_ORDER;
+#else
       /* Inclusive x0, exclusive x1 */
       bbox.x0 =  MIN3(position->x[0], position->x[1], position->x[2]) >> FIXED_ORDER;
       bbox.x1 = (MAX3(position->x[0], position->x[1], position->x[2]) - 1) >> FIXED_ORDER;
@@ -320,6 +368,7 @@ do_triangle_ccw(struct lp_setup_context *setup,
       /* Inclusive / exclusive depending upon adj (bottom-left or top-right) */
       bbox.y0 = (MIN3(position->y[0], position->y[1], position->y[2]) + adj) >> FIXED_ORDER;
       bbox.y1 = (MAX3(position->y[0], position->y[1], position->y[2]) - 1 + adj) >> FIXED_ORDER;
+#endif
    }
 
    if (bbox.x1 < bbox.x0 ||
@@ -386,6 +435,24 @@ do_triangle_ccw(struct lp_setup_context *setup,
    tri->inputs.layer = layer;
    tri->inputs.viewport_index = viewport_index;
 
+   /*
+    * Conservative interpolated z bounds over the bounding box, for coarse
+    * per-tile z rejection in the rasterizer.  Evaluate the position z plane
+    * at the bbox corners - the coefficients already include polygon offset.
+    */
+   {
+      const float dzdx = GET_DADX(&tri->inputs)[0][2];
+      const float dzdy = GET_DADY(&tri->inputs)[0][2];
+      const float zx0 = dzdx * (float)bbox.x0;
+      const float zx1 = dzdx * (float)(bbox.x1 + 1);
+      const float zy0 = dzdy * (float)bbox.y0;
+      const float zy1 = dzdy * (float)(bbox.y1 + 1);
+      const float az = GET_A0(&tri->inputs)[0][2];
+
+      tri->inputs.zmin = az + MIN2(zx0, zx1) + MIN2(zy0, zy1);
+      tri->inputs.zmax = az + MAX2(zx0, zx1) + MAX2(zy0, zy1);
+   }
+
    if (0)
       lp_dump_setup_coef(&setup->setup.variant->key,
                          (const float (*)[4])GET_A0(&tri->inputs),
@@ -59,12 +59,18 @@
 
 #include <limits.h>
 #include "pipe/p_defines.h"
+#ifdef PIPE_OS_UNIX
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#endif
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "util/u_pointer.h"
 #include "util/u_format.h"
 #include "util/u_dump.h"
 #include "util/u_string.h"
+#include "util/u_hash.h"
 #include "util/simple_list.h"
 #include "util/u_dual_blend.h"
 #include "os/os_time.h"
@@ -2548,9 +2554,106 @@ lp_debug_fs_variant(const struct lp_fragment_shader_variant *variant)
 }
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(fs_code_cache, "LP_CODE_CACHE", TRUE)
+
+
+/**
+ * Build the on-disk code cache filename for a variant.
+ *
+ * The TGSI tokens and the variant key fully determine the generated code,
+ * so the filename hashes both; the LLVM version and native vector width go
+ * in as well since they change what the code generator emits.  Returns
+ * FALSE when caching is disabled or no cache directory is available, in
+ * which case the variant is simply compiled as usual.
+ */
+static boolean
+fs_variant_cache_filename(struct lp_fragment_shader *shader,
+                          const struct lp_fragment_shader_variant_key *key,
+                          char *filename, size_t size)
+{
+#ifdef PIPE_OS_UNIX
+   char dir[1024];
+   const char *xdg_cache_home = getenv("XDG_CACHE_HOME");
+   const char *home = getenv("HOME");
+   unsigned tgsi_hash, key_hash;
+
+   if (!debug_get_option_fs_code_cache())
+      return FALSE;
+
+   if (xdg_cache_home) {
+      util_snprintf(dir, sizeof dir, "%s/mesa_llvmpipe_cache",
+                    xdg_cache_home);
+   }
+   else if (home) {
+      util_snprintf(dir, sizeof dir, "%s/.cache/mesa_llvmpipe_cache", home);
+   }
+   else {
+      return FALSE;
+   }
+
+   if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+      return FALSE;
+
+   tgsi_hash = util_hash_crc32(shader->base.tokens,
+                               tgsi_num_tokens(shader->base.tokens) *
+                               sizeof(struct tgsi_token));
+   key_hash = util_hash_crc32(key, shader->variant_key_size);
+
+   util_snprintf(filename, size, "%s/fs_%08x_%08x_%x_%u.o", dir,
+                 tgsi_hash, key_hash, HAVE_LLVM, lp_native_vector_width);
+   return TRUE;
+#else
+   return FALSE;
+#endif
+}
+
+
+/**
+ * Worker-thread entry point: compile a variant's IR to machine code.
+ *
+ * Runs on the context's compile queue (or inline on the application thread
+ * when the queue could not be created).  Everything it touches is private
+ * to the variant: the gallivm state was created with a dedicated
+ * LLVMContext, so the compile can proceed while the application thread
+ * keeps using lp->context for the draw module.
+ */
+static void
+llvmpipe_fs_compile_variant_job(void *job, int thread_index)
+{
+   struct lp_fragment_shader_variant *variant =
+      (struct lp_fragment_shader_variant *) job;
+
+   gallivm_compile_module(variant->gallivm);
+
+   if (variant->function[RAST_EDGE_TEST]) {
+      variant->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
+            gallivm_jit_function(variant->gallivm,
+                                 variant->function[RAST_EDGE_TEST]);
+   }
+
+   if (variant->function[RAST_WHOLE]) {
+         variant->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
+               gallivm_jit_function(variant->gallivm,
+                                    variant->function[RAST_WHOLE]);
+   } else if (!variant->jit_function[RAST_WHOLE]) {
+      variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
+   }
+
+   gallivm_free_ir(variant->gallivm);
+
+   LLVMContextDispose(variant->llvm_context);
+   variant->llvm_context = NULL;
+}
+
+
 /**
  * Generate a new fragment shader variant from the shader code and
  * other state indicated by the key.
+ *
+ * Only the LLVM IR is built here; the returned variant is still being
+ * compiled on the context's compile queue and must not be called into
+ * until its compile_fence has signalled (see
+ * lp_fs_variant_wait_for_compile()).
  */
 static struct lp_fragment_shader_variant *
 generate_variant(struct llvmpipe_context *lp,
@@ -2561,6 +2664,7 @@ generate_variant(struct llvmpipe_context *lp,
    const struct util_format_description *cbuf0_format_desc;
    boolean fullcolormask;
    char module_name[64];
+   char cache_filename[1024];
 
    variant = CALLOC_STRUCT(lp_fragment_shader_variant);
    if (!variant)
@@ -2569,8 +2673,19 @@ generate_variant(struct llvmpipe_context *lp,
    util_snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
                  shader->no, shader->variants_created);
 
-   variant->gallivm = gallivm_create(module_name, lp->context);
+   /* The variant gets its own LLVMContext so that the compile job can run
+    * concurrently with IR construction for the draw module, which keeps
+    * using lp->context on the application thread.
+    */
+   variant->llvm_context = LLVMContextCreate();
+   if (!variant->llvm_context) {
+      FREE(variant);
+      return NULL;
+   }
+
+   variant->gallivm = gallivm_create(module_name, variant->llvm_context);
    if (!variant->gallivm) {
+      LLVMContextDispose(variant->llvm_context);
       FREE(variant);
       return NULL;
    }
@@ -2582,6 +2697,14 @@ generate_variant(struct llvmpipe_context *lp,
 
    memcpy(&variant->key, key, shader->variant_key_size);
 
+   /* On a warm cache the JIT engine binds the machine code emitted by an
+    * earlier run instead of re-running the whole gallivm pipeline.
+    */
+   if (fs_variant_cache_filename(shader, key, cache_filename,
+                                 sizeof cache_filename)) {
+      gallivm_set_cache_file(variant->gallivm, cache_filename);
+   }
+
    /*
     * Determine whether we are touching all channels in the color buffer.
     */
@@ -2626,29 +2749,22 @@ generate_variant(struct llvmpipe_context *lp,
    }
 
    /*
-    * Compile everything
+    * Compile everything.  The instruction count feeds the variant cache
+    * accounting in llvmpipe_update_fs() as soon as we return, so count the
+    * IR here rather than racing with the compile job.
     */
 
-   gallivm_compile_module(variant->gallivm);
-
    variant->nr_instrs += lp_build_count_ir_module(variant->gallivm->module);
 
-   if (variant->function[RAST_EDGE_TEST]) {
-      variant->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
-            gallivm_jit_function(variant->gallivm,
-                                 variant->function[RAST_EDGE_TEST]);
-   }
+   util_queue_fence_init(&variant->compile_fence);
 
-   if (variant->function[RAST_WHOLE]) {
-         variant->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
-               gallivm_jit_function(variant->gallivm,
-                                    variant->function[RAST_WHOLE]);
-   } else if (!variant->jit_function[RAST_WHOLE]) {
-      variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
+   if (util_queue_is_initialized(&lp->compile_queue)) {
+      util_queue_add_job(&lp->compile_queue, variant, &variant->compile_fence,
+                         llvmpipe_fs_compile_variant_job, NULL);
+   } else {
+      llvmpipe_fs_compile_variant_job(variant, 0);
    }
 
-   gallivm_free_ir(variant->gallivm);
-
    return variant;
 }
 
@@ -2784,6 +2900,10 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                    lp->nr_fs_variants);
    }
 
+   /* The variant may still be sitting on the compile queue. */
+   lp_fs_variant_wait_for_compile(variant);
+   util_queue_fence_destroy(&variant->compile_fence);
+
    gallivm_destroy(variant->gallivm);
 
    /* remove from shader's list */
@@ -32,6 +32,7 @@
 
 #include "pipe/p_compiler.h"
 #include "pipe/p_state.h"
+#include "util/u_queue.h"
 #include "tgsi/tgsi_scan.h" /* for tgsi_shader_info */
 #include "gallivm/lp_bld_sample.h" /* for struct lp_sampler_static_state */
 #include "gallivm/lp_bld_tgsi.h" /* for lp_tgsi_info */
@@ -102,6 +103,12 @@ struct lp_fragment_shader_variant
 
    struct gallivm_state *gallivm;
 
+   /** Context owning the variant's module; disposed once it is compiled. */
+   LLVMContextRef llvm_context;
+
+   /** Signalled once jit_function[] is ready to call. */
+   struct util_queue_fence compile_fence;
+
    LLVMTypeRef jit_context_ptr_type;
    LLVMTypeRef jit_thread_data_ptr_type;
    LLVMTypeRef jit_linear_context_ptr_type;
@@ -143,6 +150,25 @@ struct lp_fragment_shader
 };
 
 
+/**
+ * Block until the variant's machine code is ready to call.
+ *
+ * Variants are compiled asynchronously on the context's compile queue, so
+ * anything about to call into jit_function[] (or to destroy the variant)
+ * must wait on the fence first.  The fast path is a single flag test once
+ * the compile has finished.
+ */
+static inline void
+lp_fs_variant_wait_for_compile(const struct lp_fragment_shader_variant *variant)
+{
+   struct lp_fragment_shader_variant *v =
+      (struct lp_fragment_shader_variant *) variant;
+
+   if (!util_queue_fence_is_signalled(&v->compile_fence))
+      util_queue_fence_wait(&v->compile_fence);
+}
+
+
 void
 lp_debug_fs_variant(const struct lp_fragment_shader_variant *variant);
 
@@ -37,6 +37,7 @@
 #include "lp_context.h"
 #include "lp_screen.h"
 #include "lp_state.h"
+#include "lp_texture.h"
 #include "lp_debug.h"
 #include "state_tracker/sw_winsys.h"
 
@@ -263,6 +264,12 @@ prepare_shader_sampling(
          unsigned first_level = 0;
          unsigned last_level = 0;
 
+         /* Deferred clears must hit memory before the draw module
+          * samples the texture.
+          */
+         if (lp_tex->pending_clear)
+            llvmpipe_resource_materialize_clear(lp_tex);
+
          if (!lp_tex->dt) {
             /* regular texture - setup array of mipmap level offsets */
             struct pipe_resource *res = view->texture;
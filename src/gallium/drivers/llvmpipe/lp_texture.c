@@ -542,6 +542,10 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
       }
    }
 
+   /* The mapped memory must hold the actual contents */
+   if (lpr->pending_clear)
+      llvmpipe_resource_materialize_clear(lpr);
+
    /* Check if we're mapping the current constant buffer */
    if ((usage & PIPE_TRANSFER_WRITE) &&
        (resource->bind & PIPE_BIND_CONSTANT_BUFFER)) {
@@ -749,6 +753,51 @@ llvmpipe_get_texture_image_address(struct llvmpipe_resource *lpr,
 }
 
 
+/**
+ * Write out a deferred clear (see llvmpipe_resource::pending_clear).
+ *
+ * Deferred clears are only created for resources which no queued scene
+ * references, and every path which makes a resource visible to
+ * rendering or mapping resolves the clear before the resource is read,
+ * so plain stores are safe here.
+ */
+void
+llvmpipe_resource_materialize_clear(struct llvmpipe_resource *lpr)
+{
+   const unsigned pixel_size = lpr->clear_pixel_size;
+   const unsigned width = lpr->base.width0;
+   const unsigned height = lpr->base.height0;
+   const unsigned row_stride = lpr->row_stride[0];
+   unsigned num_layers, layer, x, y;
+
+   if (!lpr->pending_clear)
+      return;
+
+   lpr->pending_clear = FALSE;
+
+   assert(llvmpipe_resource_is_texture(&lpr->base));
+   assert(!lpr->dt);
+   assert(lpr->base.last_level == 0);
+
+   if (lpr->base.target == PIPE_TEXTURE_3D)
+      num_layers = lpr->base.depth0;
+   else
+      num_layers = lpr->base.array_size;
+
+   for (layer = 0; layer < num_layers; layer++) {
+      ubyte *dst = llvmpipe_get_texture_image_address(lpr, layer, 0);
+
+      /* fill the first row pixel by pixel, then replicate it */
+      for (x = 0; x < width; x++) {
+         memcpy(dst + x * pixel_size, &lpr->clear_value, pixel_size);
+      }
+      for (y = 1; y < height; y++) {
+         memcpy(dst + y * row_stride, dst, width * pixel_size);
+      }
+   }
+}
+
+
 /**
  * Return size of resource in bytes
  */
@@ -31,6 +31,7 @@
 
 #include "pipe/p_state.h"
 #include "util/u_debug.h"
+#include "util/u_pack_color.h"
 #include "lp_limits.h"
 
 
@@ -85,6 +86,16 @@ struct llvmpipe_resource
     */
    void *data;
 
+   /**
+    * Deferred clear.  When set, the texture contents are stale and the
+    * whole resource is logically filled with clear_value; the memory is
+    * only written once somebody actually reads or renders to it.
+    * Only ever set for single-level non-display-target textures.
+    */
+   boolean pending_clear;
+   union util_color clear_value;
+   unsigned clear_pixel_size;
+
    boolean userBuffer;  /** Is this a user-space buffer? */
    unsigned timestamp;
 
@@ -219,6 +230,9 @@ ubyte *
 llvmpipe_get_texture_image_address(struct llvmpipe_resource *lpr,
                                    unsigned face_slice, unsigned level);
 
+void
+llvmpipe_resource_materialize_clear(struct llvmpipe_resource *lpr);
+
 
 extern void
 llvmpipe_print_resources(void);
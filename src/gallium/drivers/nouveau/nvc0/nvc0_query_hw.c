@@ -276,8 +276,11 @@ nvc0_hw_end_query(struct nvc0_context *nvc0, struct nvc0_query *q)
    default:
       break;
    }
-   if (hq->is64bit)
-      nouveau_fence_ref(nvc0->screen->base.fence.current, &hq->fence);
+   /* Remember the fence covering the query write, so that waiting for the
+    * result only has to wait for this query instead of stalling on all
+    * pending writes to the shared slab with a kernel bo_wait.
+    */
+   nouveau_fence_ref(nvc0->screen->base.fence.current, &hq->fence);
 }
 
 static boolean
@@ -306,8 +309,17 @@ nvc0_hw_get_query_result(struct nvc0_context *nvc0, struct nvc0_query *q,
          }
          return false;
       }
-      if (nouveau_bo_wait(hq->bo, NOUVEAU_BO_RD, nvc0->screen->base.client))
-         return false;
+      if (hq->fence) {
+         /* The query data lives in a persistent mapping, so all we need is
+          * for the GPU to have caught up with the sequence write, which the
+          * fence covers without a round trip to the kernel.
+          */
+         if (!nouveau_fence_wait(hq->fence, &nvc0->base.debug))
+            return false;
+      } else {
+         if (nouveau_bo_wait(hq->bo, NOUVEAU_BO_RD, nvc0->screen->base.client))
+            return false;
+      }
       NOUVEAU_DRV_STAT(&nvc0->screen->base, query_sync_count, 1);
    }
    hq->state = NVC0_HW_QUERY_STATE_READY;
@@ -775,6 +775,57 @@ nvc0_draw_elements(struct nvc0_context *nvc0, bool shorten,
    NOUVEAU_DRV_STAT(&nvc0->screen->base, draw_calls_indexed, 1);
 }
 
+/* Hand an instanced direct draw to the multi-draw macros instead of
+ * replaying VERTEX_BEGIN/END per instance on the CPU: the parameters are
+ * pushed inline and the macro expands the instance loop on the GPU, so the
+ * draw costs a fixed handful of dwords regardless of instance count.
+ */
+static void
+nvc0_draw_instanced_macro(struct nvc0_context *nvc0,
+                          const struct pipe_draw_info *info)
+{
+   struct nouveau_pushbuf *push = nvc0->base.pushbuf;
+   struct nvc0_screen *screen = nvc0->screen;
+   const bool indexed = info->indexed;
+   const unsigned size = indexed ? 5 : 4;
+
+   PUSH_SPACE(push, 11 + size);
+
+   if (!indexed && nvc0->state.index_bias) {
+      /* index_bias is implied 0 if !info->indexed (really ?) */
+      IMMED_NVC0(push, NVC0_3D(VB_ELEMENT_BASE), 0);
+      IMMED_NVC0(push, NVC0_3D(VERTEX_ID_BASE), 0);
+      nvc0->state.index_bias = 0;
+   }
+
+   /* Queue things up to let the macro write params to the driver constbuf */
+   BEGIN_NVC0(push, NVC0_3D(CB_SIZE), 3);
+   PUSH_DATA (push, 512);
+   PUSH_DATAh(push, screen->uniform_bo->offset + NVC0_CB_AUX_INFO(0));
+   PUSH_DATA (push, screen->uniform_bo->offset + NVC0_CB_AUX_INFO(0));
+   BEGIN_NVC0(push, NVC0_3D(CB_POS), 1);
+   PUSH_DATA (push, NVC0_CB_AUX_DRAW_INFO);
+
+   PUSH_DATA (push, NVC0_FIFO_PKHDR_1I(0, indexed ?
+                                       NVC0_3D_MACRO_DRAW_ELEMENTS_INDIRECT :
+                                       NVC0_3D_MACRO_DRAW_ARRAYS_INDIRECT,
+                                       3 + size));
+   PUSH_DATA (push, nvc0_prim_gl(info->mode));
+   PUSH_DATA (push, info->drawid);
+   PUSH_DATA (push, 1); /* numparams */
+   PUSH_DATA (push, info->count);
+   PUSH_DATA (push, info->instance_count);
+   PUSH_DATA (push, info->start);
+   if (indexed)
+      PUSH_DATA (push, info->index_bias);
+   PUSH_DATA (push, info->start_instance);
+
+   if (indexed)
+      NOUVEAU_DRV_STAT(&nvc0->screen->base, draw_calls_indexed, 1);
+   else
+      NOUVEAU_DRV_STAT(&nvc0->screen->base, draw_calls_array, 1);
+}
+
 static void
 nvc0_draw_stream_output(struct nvc0_context *nvc0,
                         const struct pipe_draw_info *info)
@@ -936,6 +987,7 @@ nvc0_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    struct nvc0_context *nvc0 = nvc0_context(pipe);
    struct nouveau_pushbuf *push = nvc0->base.pushbuf;
    struct nvc0_screen *screen = nvc0->screen;
+   unsigned space;
    int s;
 
    /* NOTE: caller must ensure that (min_index + index_bias) is >= 0 */
@@ -974,8 +1026,23 @@ nvc0_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
 
    nvc0_state_validate_3d(nvc0, ~0);
 
+   /* Predict the space all the fixed-size updates below will take and
+    * reserve it in one go, instead of checking (and possibly kicking off
+    * the push buffer) before each one individually.
+    */
+   space = 8; /* base instance, flush, and prim restart */
+   if (nvc0->vertprog->vp.need_draw_parameters)
+      space += 9;
+   if (nvc0->screen->base.class_3d < NVE4_3D_CLASS)
+      space += 1; /* seamless cube map */
+   space += 1; /* MEM_BARRIER */
+   for (s = 0; s < 5; ++s) {
+      if (nvc0->textures_coherent[s])
+         space += nvc0->num_textures[s] * 2;
+   }
+   PUSH_SPACE(push, space);
+
    if (nvc0->vertprog->vp.need_draw_parameters) {
-      PUSH_SPACE(push, 9);
       BEGIN_NVC0(push, NVC0_3D(CB_SIZE), 3);
       PUSH_DATA (push, 512);
       PUSH_DATAh(push, screen->uniform_bo->offset + NVC0_CB_AUX_INFO(0));
@@ -992,7 +1059,6 @@ nvc0_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    if (nvc0->screen->base.class_3d < NVE4_3D_CLASS &&
        nvc0->seamless_cube_map != nvc0->state.seamless_cube_map) {
       nvc0->state.seamless_cube_map = nvc0->seamless_cube_map;
-      PUSH_SPACE(push, 1);
       IMMED_NVC0(push, NVC0_3D(TEX_MISC),
                  nvc0->seamless_cube_map ? NVC0_3D_TEX_MISC_SEAMLESS_CUBE_MAP : 0);
    }
@@ -1005,7 +1071,6 @@ nvc0_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    }
 
    if (nvc0->cb_dirty) {
-      PUSH_SPACE(push, 1);
       IMMED_NVC0(push, NVC0_3D(MEM_BARRIER), 0x1011);
       nvc0->cb_dirty = false;
    }
@@ -1014,8 +1079,6 @@ nvc0_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
       if (!nvc0->textures_coherent[s])
          continue;
 
-      PUSH_SPACE(push, nvc0->num_textures[s] * 2);
-
       for (int i = 0; i < nvc0->num_textures[s]; ++i) {
          struct nv50_tic_entry *tic = nv50_tic_entry(nvc0->textures[s][i]);
          if (!(nvc0->textures_coherent[s] & (1 << i)))
@@ -1034,9 +1097,6 @@ nvc0_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
       return;
    }
 
-   /* space for base instance, flush, and prim restart */
-   PUSH_SPACE(push, 8);
-
    if (nvc0->state.instance_base != info->start_instance) {
       nvc0->state.instance_base = info->start_instance;
       /* NOTE: this does not affect the shader input, should it ? */
@@ -1070,13 +1130,23 @@ nvc0_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
       if (info->primitive_restart && info->restart_index > 65535)
          shorten = false;
 
-      nvc0_draw_elements(nvc0, shorten,
-                         info->mode, info->start, info->count,
-                         info->instance_count, info->index_bias);
+      /* The macro only wins once it amortizes its fixed setup cost over
+       * the per-instance replays it saves, and it needs the index buffer
+       * to be accessible by the GPU.
+       */
+      if (info->instance_count > 2 && nvc0->idxbuf.buffer)
+         nvc0_draw_instanced_macro(nvc0, info);
+      else
+         nvc0_draw_elements(nvc0, shorten,
+                            info->mode, info->start, info->count,
+                            info->instance_count, info->index_bias);
    } else {
-      nvc0_draw_arrays(nvc0,
-                       info->mode, info->start, info->count,
-                       info->instance_count);
+      if (info->instance_count > 2)
+         nvc0_draw_instanced_macro(nvc0, info);
+      else
+         nvc0_draw_arrays(nvc0,
+                          info->mode, info->start, info->count,
+                          info->instance_count);
    }
    push->kick_notify = nvc0_default_kick_notify;
 
@@ -173,6 +173,10 @@ bool r600_init_resource(struct r600_common_screen *rscreen,
 	if (rscreen->debug_flags & DBG_NO_WC)
 		flags &= ~RADEON_FLAG_GTT_WC;
 
+	/* Remember the flags for the transfer code, which avoids CPU reads
+	 * from write-combined memory. */
+	res->flags = flags;
+
 	/* Allocate a new resource. */
 	new_buf = rscreen->ws->buffer_create(rscreen->ws, size, alignment,
 					     res->domains, flags);
@@ -355,11 +359,14 @@ static void *r600_buffer_transfer_map(struct pipe_context *ctx,
 			usage |= PIPE_TRANSFER_UNSYNCHRONIZED;
 		}
 	}
-	/* Using a staging buffer in GTT for larger reads is much faster. */
+	/* Use a staging buffer in cached GTT for reads, because reads of
+	 * VRAM and of write-combined GTT are uncached and therefore very
+	 * slow on the CPU. */
 	else if ((usage & PIPE_TRANSFER_READ) &&
 		 !(usage & (PIPE_TRANSFER_WRITE |
 			    PIPE_TRANSFER_PERSISTENT)) &&
-		 rbuffer->domains & RADEON_DOMAIN_VRAM &&
+		 (rbuffer->domains & RADEON_DOMAIN_VRAM ||
+		  rbuffer->flags & RADEON_FLAG_GTT_WC) &&
 		 r600_can_dma_copy_buffer(rctx, 0, box->x, box->width)) {
 		struct r600_resource *staging;
 
@@ -412,6 +412,8 @@ void r600_common_context_cleanup(struct r600_common_context *rctx)
 	if (rctx->allocator_so_filled_size) {
 		u_suballocator_destroy(rctx->allocator_so_filled_size);
 	}
+	r600_release_pooled_query_buffers(rctx);
+	r600_release_cached_staging_texture(rctx);
 	rctx->ws->fence_reference(&rctx->last_sdma_fence, NULL);
 }
 
@@ -116,6 +116,7 @@ enum r600_coherency {
 
 struct r600_common_context;
 struct r600_perfcounters;
+struct r600_query_buffer;
 struct tgsi_shader_info;
 
 struct radeon_shader_reloc {
@@ -169,6 +170,7 @@ struct r600_resource {
 
 	/* Resource state. */
 	enum radeon_bo_domain		domains;
+	enum radeon_bo_flag		flags;
 
 	/* The buffer range which is initialized (with a write transfer,
 	 * streamout, DMA, or as a random access target). The rest of
@@ -460,6 +462,11 @@ struct r600_common_context {
 	struct u_suballocator		*allocator_so_filled_size;
 	struct util_slab_mempool	pool_transfers;
 
+	/* Staging texture of the most recent texture transfer, kept around
+	 * for re-use by compatible transfers (e.g. streaming updates of
+	 * video overlays). */
+	struct r600_texture		*staging_texture_cache;
+
 	/* Current unaccounted memory usage. */
 	uint64_t			vram;
 	uint64_t			gtt;
@@ -481,6 +488,10 @@ struct r600_common_context {
 	int				num_perfect_occlusion_queries;
 	struct list_head		active_queries;
 	unsigned			num_cs_dw_queries_suspend;
+	/* Pool of idle result buffers for re-use, chained via "previous".
+	 * All pooled buffers have the default query buffer size. */
+	struct r600_query_buffer	*query_buffer_pool;
+	unsigned			num_pooled_query_buffers;
 	/* Additional hardware info. */
 	unsigned			backend_mask;
 	unsigned			max_db; /* for OQ */
@@ -612,6 +623,7 @@ void r600_perfcounters_destroy(struct r600_common_screen *rscreen);
 /* r600_query.c */
 void r600_init_screen_query_functions(struct r600_common_screen *rscreen);
 void r600_query_init(struct r600_common_context *rctx);
+void r600_release_pooled_query_buffers(struct r600_common_context *ctx);
 void r600_suspend_queries(struct r600_common_context *ctx);
 void r600_resume_queries(struct r600_common_context *ctx);
 void r600_query_init_backend_mask(struct r600_common_context *ctx);
@@ -631,6 +643,7 @@ void r600_streamout_init(struct r600_common_context *rctx);
 void r600_test_dma(struct r600_common_screen *rscreen);
 
 /* r600_texture.c */
+void r600_release_cached_staging_texture(struct r600_common_context *rctx);
 bool r600_prepare_for_dma_blit(struct r600_common_context *rctx,
 				struct r600_texture *rdst,
 				unsigned dst_level, unsigned dstx,
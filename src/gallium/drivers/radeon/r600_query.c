@@ -241,6 +241,51 @@ static struct pipe_query *r600_query_sw_create(struct pipe_context *ctx,
 	return (struct pipe_query *)query;
 }
 
+/* Maximum number of idle result buffers kept for re-use per context. */
+#define R600_MAX_POOLED_QUERY_BUFFERS	32
+
+/**
+ * Return a result buffer to the per-context pool, or free it if the pool
+ * is full or the buffer has a non-default size.
+ *
+ * The buffer may still be in flight; r600_new_query_buffer skips busy
+ * buffers, so pooling never adds synchronization.
+ */
+static void r600_release_query_buffer(struct r600_common_context *ctx,
+				      struct r600_resource **buf)
+{
+	struct r600_query_buffer *qbuf;
+
+	if (!*buf)
+		return;
+
+	if ((*buf)->b.b.width0 != ctx->screen->info.gart_page_size ||
+	    ctx->num_pooled_query_buffers >= R600_MAX_POOLED_QUERY_BUFFERS ||
+	    !(qbuf = MALLOC_STRUCT(r600_query_buffer))) {
+		pipe_resource_reference((struct pipe_resource**)buf, NULL);
+		return;
+	}
+
+	qbuf->buf = *buf;
+	qbuf->results_end = 0;
+	qbuf->previous = ctx->query_buffer_pool;
+	ctx->query_buffer_pool = qbuf;
+	ctx->num_pooled_query_buffers++;
+	*buf = NULL;
+}
+
+void r600_release_pooled_query_buffers(struct r600_common_context *ctx)
+{
+	while (ctx->query_buffer_pool) {
+		struct r600_query_buffer *qbuf = ctx->query_buffer_pool;
+
+		ctx->query_buffer_pool = qbuf->previous;
+		pipe_resource_reference((struct pipe_resource**)&qbuf->buf, NULL);
+		FREE(qbuf);
+	}
+	ctx->num_pooled_query_buffers = 0;
+}
+
 void r600_query_hw_destroy(struct r600_common_context *rctx,
 			   struct r600_query *rquery)
 {
@@ -251,11 +296,11 @@ void r600_query_hw_destroy(struct r600_common_context *rctx,
 	while (prev) {
 		struct r600_query_buffer *qbuf = prev;
 		prev = prev->previous;
-		pipe_resource_reference((struct pipe_resource**)&qbuf->buf, NULL);
+		r600_release_query_buffer(rctx, &qbuf->buf);
 		FREE(qbuf);
 	}
 
-	pipe_resource_reference((struct pipe_resource**)&query->buffer.buf, NULL);
+	r600_release_query_buffer(rctx, &query->buffer.buf);
 	FREE(rquery);
 }
 
@@ -264,16 +309,42 @@ static struct r600_resource *r600_new_query_buffer(struct r600_common_context *c
 {
 	unsigned buf_size = MAX2(query->result_size,
 				 ctx->screen->info.gart_page_size);
+	struct r600_resource *buf = NULL;
 
-	/* Queries are normally read by the CPU after
-	 * being written by the gpu, hence staging is probably a good
-	 * usage pattern.
+	/* Try to re-use an idle buffer from the pool first. Buffers that the
+	 * GPU might still be reading are skipped, so this never stalls.
 	 */
-	struct r600_resource *buf = (struct r600_resource*)
-		pipe_buffer_create(ctx->b.screen, PIPE_BIND_CUSTOM,
-				   PIPE_USAGE_STAGING, buf_size);
-	if (!buf)
-		return NULL;
+	if (buf_size == ctx->screen->info.gart_page_size) {
+		struct r600_query_buffer **pprev = &ctx->query_buffer_pool;
+
+		while (*pprev) {
+			struct r600_query_buffer *qbuf = *pprev;
+
+			if (!r600_rings_is_buffer_referenced(ctx, qbuf->buf->buf,
+							     RADEON_USAGE_READWRITE) &&
+			    ctx->ws->buffer_wait(qbuf->buf->buf, 0,
+						 RADEON_USAGE_READWRITE)) {
+				buf = qbuf->buf;
+				*pprev = qbuf->previous;
+				ctx->num_pooled_query_buffers--;
+				FREE(qbuf);
+				break;
+			}
+			pprev = &qbuf->previous;
+		}
+	}
+
+	if (!buf) {
+		/* Queries are normally read by the CPU after
+		 * being written by the gpu, hence staging is probably a good
+		 * usage pattern.
+		 */
+		buf = (struct r600_resource*)
+			pipe_buffer_create(ctx->b.screen, PIPE_BIND_CUSTOM,
+					   PIPE_USAGE_STAGING, buf_size);
+		if (!buf)
+			return NULL;
+	}
 
 	if (query->flags & R600_QUERY_HW_FLAG_PREDICATE) {
 		if (!query->ops->prepare_buffer(ctx, query, buf)) {
@@ -709,7 +780,7 @@ static void r600_query_hw_reset_buffers(struct r600_common_context *rctx,
 	while (prev) {
 		struct r600_query_buffer *qbuf = prev;
 		prev = prev->previous;
-		pipe_resource_reference((struct pipe_resource**)&qbuf->buf, NULL);
+		r600_release_query_buffer(rctx, &qbuf->buf);
 		FREE(qbuf);
 	}
 
@@ -720,7 +791,7 @@ static void r600_query_hw_reset_buffers(struct r600_common_context *rctx,
 		/* Obtain a new buffer if the current one can't be mapped without a stall. */
 		if (r600_rings_is_buffer_referenced(rctx, query->buffer.buf->buf, RADEON_USAGE_READWRITE) ||
 		    !rctx->ws->buffer_wait(query->buffer.buf->buf, 0, RADEON_USAGE_READWRITE)) {
-			pipe_resource_reference((struct pipe_resource**)&query->buffer.buf, NULL);
+			r600_release_query_buffer(rctx, &query->buffer.buf);
 			query->buffer.buf = r600_new_query_buffer(rctx, query);
 		} else {
 			if (!query->ops->prepare_buffer(rctx, query, query->buffer.buf))
@@ -1222,6 +1222,68 @@ static void r600_init_temp_resource_from_box(struct pipe_resource *res,
 	}
 }
 
+/* Return the cached staging texture from a previous transfer if it matches
+ * the template and is idle, or NULL. This avoids both the allocation and
+ * the map/unmap overhead for streaming updates of tiled textures. */
+static struct r600_texture *
+r600_reuse_staging_texture(struct r600_common_context *rctx,
+			   const struct pipe_resource *templ)
+{
+	struct r600_texture *staging = rctx->staging_texture_cache;
+	struct pipe_resource *res;
+
+	if (!staging)
+		return NULL;
+
+	res = &staging->resource.b.b;
+	if (res->target != templ->target ||
+	    res->format != templ->format ||
+	    res->width0 != templ->width0 ||
+	    res->height0 != templ->height0 ||
+	    res->array_size != templ->array_size ||
+	    res->usage != templ->usage)
+		return NULL;
+
+	/* The staging texture may still be busy with the DMA copy of the
+	 * previous transfer. Never stall for it - allocating a new texture
+	 * is cheaper than a sync. */
+	if (r600_rings_is_buffer_referenced(rctx, staging->resource.buf,
+					    RADEON_USAGE_READWRITE) ||
+	    !rctx->ws->buffer_wait(staging->resource.buf, 0,
+				   RADEON_USAGE_READWRITE))
+		return NULL;
+
+	rctx->staging_texture_cache = NULL;
+	return staging;
+}
+
+/* Release a transfer's staging texture, keeping it cached for re-use
+ * if possible. */
+static void r600_release_staging_texture(struct r600_common_context *rctx,
+					 struct r600_resource **staging)
+{
+	struct r600_texture *rtex = (struct r600_texture*)*staging;
+
+	/* Only cache plain transfer textures. Depth staging textures have
+	 * a different layout and are not worth caching. */
+	if (!rtex->is_depth &&
+	    rtex->resource.b.b.flags & R600_RESOURCE_FLAG_TRANSFER) {
+		pipe_resource_reference((struct pipe_resource**)
+					&rctx->staging_texture_cache, NULL);
+		rctx->staging_texture_cache = rtex;
+		*staging = NULL;
+		return;
+	}
+
+	pipe_resource_reference((struct pipe_resource**)staging, NULL);
+}
+
+void r600_release_cached_staging_texture(struct r600_common_context *rctx)
+{
+	pipe_resource_reference((struct pipe_resource**)
+				&rctx->staging_texture_cache, NULL);
+}
+
 static void *r600_texture_transfer_map(struct pipe_context *ctx,
 				       struct pipe_resource *texture,
 				       unsigned level,
@@ -1335,8 +1397,11 @@ static void *r600_texture_transfer_map(struct pipe_context *ctx,
 		resource.usage = (usage & PIPE_TRANSFER_READ) ?
 			PIPE_USAGE_STAGING : PIPE_USAGE_STREAM;
 
-		/* Create the temporary texture. */
-		staging = (struct r600_texture*)ctx->screen->resource_create(ctx->screen, &resource);
+		/* Re-use the staging texture of the previous transfer if it's
+		 * compatible and idle, otherwise create a new one. */
+		staging = r600_reuse_staging_texture(rctx, &resource);
+		if (!staging)
+			staging = (struct r600_texture*)ctx->screen->resource_create(ctx->screen, &resource);
 		if (!staging) {
 			R600_ERR("failed to create temporary texture to hold untiled copy\n");
 			FREE(trans);
@@ -1373,6 +1438,7 @@ static void *r600_texture_transfer_map(struct pipe_context *ctx,
 static void r600_texture_transfer_unmap(struct pipe_context *ctx,
 					struct pipe_transfer* transfer)
 {
+	struct r600_common_context *rctx = (struct r600_common_context*)ctx;
 	struct r600_transfer *rtransfer = (struct r600_transfer*)transfer;
 	struct pipe_resource *texture = transfer->resource;
 	struct r600_texture *rtex = (struct r600_texture*)texture;
@@ -1389,7 +1455,7 @@ static void r600_texture_transfer_unmap(struct pipe_context *ctx,
 	}
 
 	if (rtransfer->staging)
-		pipe_resource_reference((struct pipe_resource**)&rtransfer->staging, NULL);
+		r600_release_staging_texture(rctx, &rtransfer->staging);
 
 	FREE(transfer);
 }
@@ -27,6 +27,7 @@
 #define SI_PIPE_H
 
 #include "si_state.h"
+#include "util/u_queue.h"
 
 #include <llvm-c/TargetMachine.h>
 
@@ -98,15 +99,19 @@ struct si_screen {
 	 * Design & limitations:
 	 * - The shader cache is per screen (= per process), never saved to
 	 *   disk, and skips redundant shader compilations from TGSI to bytecode.
-	 * - It can only be used with one-variant-per-shader support, in which
-	 *   case only the main (typically middle) part of shaders is cached.
-	 * - Only VS, TCS, TES, PS are cached, out of which only the hw VS
-	 *   variants of VS and TES are cached, so LS and ES aren't.
-	 * - GS and CS aren't cached, but it's certainly possible to cache
-	 *   those as well.
+	 * - With one-variant-per-shader support, only the main (typically
+	 *   middle) part of shaders is cached. Monolithic variants are
+	 *   cached whole, keyed additionally on the variant key.
+	 * - GS isn't cached, because the GS copy shader is compiled along
+	 *   with it and isn't captured by the cached binary.
 	 */
 	pipe_mutex			shader_cache_mutex;
 	struct hash_table		*shader_cache;
+
+	/* Shader compiler queue for multithreaded compilation of main
+	 * shader parts and pre-compiled variants at CSO creation time. */
+	struct util_queue		shader_compiler_queue;
+	LLVMTargetMachineRef		tm[4]; /* only non-NULL if the queue is used */
 };
 
 struct si_blend_color {
@@ -284,6 +289,8 @@ struct si_context {
 	bool			occlusion_queries_disabled;
 
 	/* Emitted draw state. */
+	int			last_index_size;
+	int			last_num_instances;
 	int			last_base_vertex;
 	int			last_start_instance;
 	int			last_sh_base_reg;
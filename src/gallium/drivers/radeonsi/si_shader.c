@@ -7170,10 +7170,41 @@ int si_shader_create(struct si_screen *sscreen, LLVMTargetMachineRef tm,
 	    shader->selector->type == PIPE_SHADER_COMPUTE) {
 		/* Monolithic shader (compiled as a whole, has many variants,
 		 * may take a long time to compile).
+		 *
+		 * These are cached too, keyed on the TGSI binary and the
+		 * variant key together, so that other contexts don't redo
+		 * the compilation.
+		 *
+		 * Geometry shaders are excluded: the GS copy shader is
+		 * generated alongside them and isn't captured by the cached
+		 * binary.
 		 */
-		r = si_compile_tgsi_shader(sscreen, tm, shader, true, debug);
-		if (r)
-			return r;
+		void *tgsi_binary = NULL;
+
+		if (shader->selector->type != PIPE_SHADER_GEOMETRY)
+			tgsi_binary = si_get_tgsi_binary(shader->selector,
+							 &shader->key);
+
+		pipe_mutex_lock(sscreen->shader_cache_mutex);
+
+		if (tgsi_binary &&
+		    si_shader_cache_load_shader(sscreen, tgsi_binary, shader)) {
+			FREE(tgsi_binary);
+		} else {
+			r = si_compile_tgsi_shader(sscreen, tm, shader, true,
+						   debug);
+			if (r) {
+				FREE(tgsi_binary);
+				pipe_mutex_unlock(sscreen->shader_cache_mutex);
+				return r;
+			}
+
+			if (tgsi_binary &&
+			    !si_shader_cache_insert_shader(sscreen, tgsi_binary,
+							   shader))
+				FREE(tgsi_binary);
+		}
+		pipe_mutex_unlock(sscreen->shader_cache_mutex);
 	} else {
 		/* The shader consists of 2-3 parts:
 		 *
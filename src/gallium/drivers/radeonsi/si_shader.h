@@ -70,6 +70,7 @@
 
 #include <llvm-c/Core.h> /* LLVMModuleRef */
 #include "tgsi/tgsi_scan.h"
+#include "util/u_queue.h"
 #include "si_state.h"
 
 struct radeon_shader_binary;
@@ -222,6 +223,14 @@ struct si_shader;
  * binaries for one TGSI program. This can be shared by multiple contexts.
  */
 struct si_shader_selector {
+	struct si_screen	*screen;
+	struct util_queue_fence ready;
+
+	/* Should only be used by si_init_shader_selector_async when it's
+	 * invoked on the main thread. */
+	LLVMTargetMachineRef	tm;
+	struct pipe_debug_callback *debug;
+
 	pipe_mutex		mutex;
 	struct si_shader	*first_variant; /* immutable after the first variant */
 	struct si_shader	*last_variant; /* mutable */
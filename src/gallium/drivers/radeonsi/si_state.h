@@ -42,6 +42,7 @@
 
 struct si_screen;
 struct si_shader;
+union si_shader_key;
 
 struct si_state_blend {
 	struct si_pm4_state	pm4;
@@ -311,6 +312,14 @@ bool si_update_shaders(struct si_context *sctx);
 void si_init_shader_functions(struct si_context *sctx);
 bool si_init_shader_cache(struct si_screen *sscreen);
 void si_destroy_shader_cache(struct si_screen *sscreen);
+void *si_get_tgsi_binary(struct si_shader_selector *sel,
+			 union si_shader_key *key);
+bool si_shader_cache_insert_shader(struct si_screen *sscreen,
+				   void *tgsi_binary,
+				   struct si_shader *shader);
+bool si_shader_cache_load_shader(struct si_screen *sscreen,
+				 void *tgsi_binary,
+				 struct si_shader *shader);
 
 /* si_state_draw.c */
 void si_emit_cache_flush(struct si_context *sctx, struct r600_atom *atom);
@@ -43,12 +43,18 @@
 /**
  * Return the TGSI binary in a buffer. The first 4 bytes contain its size as
  * integer.
+ *
+ * If "key" is non-NULL, the variant key is appended, so that monolithic
+ * shader variants get their own cache entries.  Main shader parts pass NULL
+ * and therefore can't collide with variants (the size differs).
  */
-static void *si_get_tgsi_binary(struct si_shader_selector *sel)
+void *si_get_tgsi_binary(struct si_shader_selector *sel,
+			 union si_shader_key *key)
 {
 	unsigned tgsi_size = tgsi_num_tokens(sel->tokens) *
 			     sizeof(struct tgsi_token);
-	unsigned size = 4 + tgsi_size + sizeof(sel->so);
+	unsigned key_size = key ? sizeof(*key) : 0;
+	unsigned size = 4 + tgsi_size + sizeof(sel->so) + key_size;
 	char *result = (char*)MALLOC(size);
 
 	if (!result)
@@ -57,6 +63,8 @@ static void *si_get_tgsi_binary(struct si_shader_selector *sel)
 	*((uint32_t*)result) = size;
 	memcpy(result + 4, sel->tokens, tgsi_size);
 	memcpy(result + 4 + tgsi_size, &sel->so, sizeof(sel->so));
+	if (key)
+		memcpy(result + 4 + tgsi_size + sizeof(sel->so), key, key_size);
 	return result;
 }
 
@@ -175,9 +183,9 @@ static bool si_load_shader_binary(struct si_shader *shader, void *binary)
  *
  * Returns false on failure, in which case the tgsi_binary should be freed.
  */
-static bool si_shader_cache_insert_shader(struct si_screen *sscreen,
-					  void *tgsi_binary,
-					  struct si_shader *shader)
+bool si_shader_cache_insert_shader(struct si_screen *sscreen,
+				   void *tgsi_binary,
+				   struct si_shader *shader)
 {
 	void *hw_binary = si_get_shader_binary(shader);
 
@@ -193,9 +201,9 @@ static bool si_shader_cache_insert_shader(struct si_screen *sscreen,
 	return true;
 }
 
-static bool si_shader_cache_load_shader(struct si_screen *sscreen,
-					void *tgsi_binary,
-				        struct si_shader *shader)
+bool si_shader_cache_load_shader(struct si_screen *sscreen,
+				 void *tgsi_binary,
+				 struct si_shader *shader)
 {
 	struct hash_entry *entry =
 		_mesa_hash_table_search(sscreen->shader_cache, tgsi_binary);
@@ -929,6 +937,46 @@ static inline void si_shader_selector_key(struct pipe_context *ctx,
 	}
 }
 
+/**
+ * Compile a shader variant and add it to the selector's variant list.
+ * The caller must hold sel->mutex.
+ *
+ * Returns the new variant, or NULL on failure.
+ */
+static struct si_shader *
+si_build_shader_variant(struct si_shader_selector *sel,
+			union si_shader_key *key,
+			LLVMTargetMachineRef tm,
+			struct pipe_debug_callback *debug)
+{
+	struct si_shader *shader = CALLOC_STRUCT(si_shader);
+	int r;
+
+	if (!shader)
+		return NULL;
+
+	shader->selector = sel;
+	shader->key = *key;
+
+	r = si_shader_create(sel->screen, tm, shader, debug);
+	if (unlikely(r)) {
+		R600_ERR("Failed to build shader variant (type=%u) %d\n",
+			 sel->type, r);
+		FREE(shader);
+		return NULL;
+	}
+	si_shader_init_pm4_state(shader);
+
+	if (!sel->last_variant) {
+		sel->first_variant = shader;
+		sel->last_variant = shader;
+	} else {
+		sel->last_variant->next_variant = shader;
+		sel->last_variant = shader;
+	}
+	return shader;
+}
+
 /* Select the hw shader variant depending on the current state. */
 static int si_shader_select_with_key(struct pipe_context *ctx,
 				     struct si_shader_ctx_state *state,
@@ -938,7 +986,6 @@ static int si_shader_select_with_key(struct pipe_context *ctx,
 	struct si_shader_selector *sel = state->cso;
 	struct si_shader *current = state->current;
 	struct si_shader *iter, *shader = NULL;
-	int r;
 
 	/* Check if we don't need to change anything.
 	 * This path is also used for most shaders that don't need multiple
@@ -947,6 +994,11 @@ static int si_shader_select_with_key(struct pipe_context *ctx,
 	if (likely(current && memcmp(&current->key, key, sizeof(*key)) == 0))
 		return 0;
 
+	/* The selector must be compiled before variants can be built on
+	 * top of the main shader part.
+	 */
+	util_queue_fence_wait(&sel->ready);
+
 	pipe_mutex_lock(sel->mutex);
 
 	/* Find the shader variant. */
@@ -961,31 +1013,11 @@ static int si_shader_select_with_key(struct pipe_context *ctx,
 	}
 
 	/* Build a new shader. */
-	shader = CALLOC_STRUCT(si_shader);
+	shader = si_build_shader_variant(sel, key, sctx->tm, &sctx->b.debug);
 	if (!shader) {
 		pipe_mutex_unlock(sel->mutex);
 		return -ENOMEM;
 	}
-	shader->selector = sel;
-	shader->key = *key;
-
-	r = si_shader_create(sctx->screen, sctx->tm, shader, &sctx->b.debug);
-	if (unlikely(r)) {
-		R600_ERR("Failed to build shader variant (type=%u) %d\n",
-			 sel->type, r);
-		FREE(shader);
-		pipe_mutex_unlock(sel->mutex);
-		return r;
-	}
-	si_shader_init_pm4_state(shader);
-
-	if (!sel->last_variant) {
-		sel->first_variant = shader;
-		sel->last_variant = shader;
-	} else {
-		sel->last_variant->next_variant = shader;
-		sel->last_variant = shader;
-	}
 	state->current = shader;
 	pipe_mutex_unlock(sel->mutex);
 	return 0;
@@ -1025,6 +1057,104 @@ static void si_parse_next_shader_property(const struct tgsi_shader_info *info,
 	}
 }
 
+/**
+ * Compile the main shader part and the pre-compiled variant of a shader
+ * selector.
+ *
+ * This is also called on the main thread (with thread_index = -1) when the
+ * compiler queue isn't available or when a debug callback is set, because
+ * debug callbacks can't be invoked from other threads.
+ *
+ * Compile failures aren't fatal here; without a main shader part, variants
+ * fall back to a monolithic compile at draw time.
+ */
+static void si_init_shader_selector_async(void *job, int thread_index)
+{
+	struct si_shader_selector *sel = (struct si_shader_selector *)job;
+	struct si_screen *sscreen = sel->screen;
+	LLVMTargetMachineRef tm;
+	struct pipe_debug_callback *debug = sel->debug;
+	unsigned i;
+
+	if (thread_index >= 0) {
+		assert(thread_index < ARRAY_SIZE(sscreen->tm));
+		tm = sscreen->tm[thread_index];
+		/* Don't call the debug callback from a thread. */
+		debug = NULL;
+	} else {
+		tm = sel->tm;
+	}
+
+	/* Compile the main shader part for use with a prolog and/or epilog. */
+	if (sel->type != PIPE_SHADER_GEOMETRY &&
+	    !sscreen->use_monolithic_shaders) {
+		struct si_shader *shader = CALLOC_STRUCT(si_shader);
+		void *tgsi_binary;
+
+		if (!shader)
+			return;
+
+		shader->selector = sel;
+		si_parse_next_shader_property(&sel->info, &shader->key);
+
+		tgsi_binary = si_get_tgsi_binary(sel, NULL);
+
+		/* Try to load the shader from the shader cache. */
+		pipe_mutex_lock(sscreen->shader_cache_mutex);
+
+		if (tgsi_binary &&
+		    si_shader_cache_load_shader(sscreen, tgsi_binary, shader)) {
+			FREE(tgsi_binary);
+		} else {
+			/* Compile the shader if it hasn't been loaded from the cache. */
+			if (si_compile_tgsi_shader(sscreen, tm, shader, false,
+						   debug) != 0) {
+				FREE(shader);
+				FREE(tgsi_binary);
+				pipe_mutex_unlock(sscreen->shader_cache_mutex);
+				fprintf(stderr, "radeonsi: can't compile a main shader part\n");
+				return;
+			}
+
+			if (tgsi_binary &&
+			    !si_shader_cache_insert_shader(sscreen, tgsi_binary, shader))
+				FREE(tgsi_binary);
+		}
+		pipe_mutex_unlock(sscreen->shader_cache_mutex);
+
+		sel->main_shader_part = shader;
+	}
+
+	/* Pre-compilation. */
+	if (sel->type == PIPE_SHADER_GEOMETRY ||
+	    sscreen->b.debug_flags & DBG_PRECOMPILE) {
+		union si_shader_key key;
+
+		memset(&key, 0, sizeof(key));
+		si_parse_next_shader_property(&sel->info, &key);
+
+		/* Set reasonable defaults, so that the shader key doesn't
+		 * cause any code to be eliminated.
+		 */
+		switch (sel->type) {
+		case PIPE_SHADER_TESS_CTRL:
+			key.tcs.epilog.prim_mode = PIPE_PRIM_TRIANGLES;
+			break;
+		case PIPE_SHADER_FRAGMENT:
+			key.ps.epilog.alpha_func = PIPE_FUNC_ALWAYS;
+			for (i = 0; i < 8; i++)
+				if (sel->info.colors_written & (1 << i))
+					key.ps.epilog.spi_shader_col_format |=
+						V_028710_SPI_SHADER_FP16_ABGR << (i * 4);
+			break;
+		}
+
+		pipe_mutex_lock(sel->mutex);
+		si_build_shader_variant(sel, &key, tm, debug);
+		pipe_mutex_unlock(sel->mutex);
+	}
+}
+
 static void *si_create_shader_selector(struct pipe_context *ctx,
 				       const struct pipe_shader_state *state)
 {
@@ -1036,6 +1166,9 @@ static void *si_create_shader_selector(struct pipe_context *ctx,
 	if (!sel)
 		return NULL;
 
+	sel->screen = sscreen;
+	sel->tm = sctx->tm;
+	sel->debug = &sctx->b.debug;
 	sel->tokens = tgsi_dup_tokens(state->tokens);
 	if (!sel->tokens) {
 		FREE(sel);
@@ -1144,82 +1277,19 @@ static void *si_create_shader_selector(struct pipe_context *ctx,
 		sel->db_shader_control |= S_02880C_EXEC_ON_HIER_FAIL(1) |
 					  S_02880C_EXEC_ON_NOOP(1);
 
-	/* Compile the main shader part for use with a prolog and/or epilog. */
-	if (sel->type != PIPE_SHADER_GEOMETRY &&
-	    !sscreen->use_monolithic_shaders) {
-		struct si_shader *shader = CALLOC_STRUCT(si_shader);
-		void *tgsi_binary;
-
-		if (!shader)
-			goto error;
-
-		shader->selector = sel;
-		si_parse_next_shader_property(&sel->info, &shader->key);
-
-		tgsi_binary = si_get_tgsi_binary(sel);
-
-		/* Try to load the shader from the shader cache. */
-		pipe_mutex_lock(sscreen->shader_cache_mutex);
-
-		if (tgsi_binary &&
-		    si_shader_cache_load_shader(sscreen, tgsi_binary, shader)) {
-			FREE(tgsi_binary);
-		} else {
-			/* Compile the shader if it hasn't been loaded from the cache. */
-			if (si_compile_tgsi_shader(sscreen, sctx->tm, shader, false,
-						   &sctx->b.debug) != 0) {
-				FREE(shader);
-				FREE(tgsi_binary);
-				pipe_mutex_unlock(sscreen->shader_cache_mutex);
-				goto error;
-			}
-
-			if (tgsi_binary &&
-			    !si_shader_cache_insert_shader(sscreen, tgsi_binary, shader))
-				FREE(tgsi_binary);
-		}
-		pipe_mutex_unlock(sscreen->shader_cache_mutex);
-
-		sel->main_shader_part = shader;
-	}
-
-	/* Pre-compilation. */
-	if (sel->type == PIPE_SHADER_GEOMETRY ||
-	    sscreen->b.debug_flags & DBG_PRECOMPILE) {
-		struct si_shader_ctx_state state = {sel};
-		union si_shader_key key;
-
-		memset(&key, 0, sizeof(key));
-		si_parse_next_shader_property(&sel->info, &key);
-
-		/* Set reasonable defaults, so that the shader key doesn't
-		 * cause any code to be eliminated.
-		 */
-		switch (sel->type) {
-		case PIPE_SHADER_TESS_CTRL:
-			key.tcs.epilog.prim_mode = PIPE_PRIM_TRIANGLES;
-			break;
-		case PIPE_SHADER_FRAGMENT:
-			key.ps.epilog.alpha_func = PIPE_FUNC_ALWAYS;
-			for (i = 0; i < 8; i++)
-				if (sel->info.colors_written & (1 << i))
-					key.ps.epilog.spi_shader_col_format |=
-						V_028710_SPI_SHADER_FP16_ABGR << (i * 4);
-			break;
-		}
+	pipe_mutex_init(sel->mutex);
+	util_queue_fence_init(&sel->ready);
 
-		if (si_shader_select_with_key(ctx, &state, &key))
-			goto error;
-	}
+	/* The debug callback must not be called from other threads. */
+	if (sctx->b.debug.debug_message ||
+	    !util_queue_is_initialized(&sscreen->shader_compiler_queue))
+		si_init_shader_selector_async(sel, -1);
+	else
+		util_queue_add_job(&sscreen->shader_compiler_queue, sel,
+				   &sel->ready, si_init_shader_selector_async,
+				   NULL);
 
-	pipe_mutex_init(sel->mutex);
 	return sel;
-
-error:
-	fprintf(stderr, "radeonsi: can't create a shader\n");
-	tgsi_free_tokens(sel->tokens);
-	FREE(sel);
-	return NULL;
 }
 
 static void si_bind_vs_shader(struct pipe_context *ctx, void *state)
@@ -1345,7 +1415,7 @@ static void si_delete_shader_selector(struct pipe_context *ctx, void *state)
 {
 	struct si_context *sctx = (struct si_context *)ctx;
 	struct si_shader_selector *sel = (struct si_shader_selector *)state;
-	struct si_shader *p = sel->first_variant, *c;
+	struct si_shader *p, *c;
 	struct si_shader_ctx_state *current_shader[SI_NUM_SHADERS] = {
 		[PIPE_SHADER_VERTEX] = &sctx->vs_shader,
 		[PIPE_SHADER_TESS_CTRL] = &sctx->tcs_shader,
@@ -1359,6 +1429,10 @@ static void si_delete_shader_selector(struct pipe_context *ctx, void *state)
 		current_shader[sel->type]->current = NULL;
 	}
 
+	util_queue_fence_wait(&sel->ready);
+	util_queue_fence_destroy(&sel->ready);
+
+	p = sel->first_variant;
 	while (p) {
 		c = p->next_variant;
 		si_delete_shader(sctx, p);
@@ -773,12 +773,15 @@ static unsigned mask_count[16] =
 
 
 /**
- * General depth/stencil test function.  Used when there's no fast-path.
+ * General depth/stencil test on an array of quads, compacting the array
+ * to the surviving quads.  Shared between the fallback path and the
+ * fused depth+color output paths below.
+ * \return number of quads which passed
  */
-static void
-depth_test_quads_fallback(struct quad_stage *qs, 
-                          struct quad_header *quads[],
-                          unsigned nr)
+static unsigned
+depth_stencil_test_quads(struct quad_stage *qs,
+                         struct quad_header *quads[],
+                         unsigned nr)
 {
    unsigned i, pass = 0;
    const struct tgsi_shader_info *fsInfo = &qs->softpipe->fs_variant->info;
@@ -842,15 +845,157 @@ depth_test_quads_fallback(struct quad_stage *qs,
    }
 
    if (qs->softpipe->active_query_count) {
-      for (i = 0; i < nr; i++) 
+      for (i = 0; i < nr; i++)
          qs->softpipe->occlusion_count += mask_count[quads[i]->inout.mask];
    }
 
+   return nr;
+}
+
+
+/**
+ * General depth/stencil test function.  Used when there's no fast-path.
+ */
+static void
+depth_test_quads_fallback(struct quad_stage *qs,
+                          struct quad_header *quads[],
+                          unsigned nr)
+{
+   nr = depth_stencil_test_quads(qs, quads, nr);
+
    if (nr)
       qs->next->run(qs->next, quads, nr);
 }
 
 
+/**
+ * Fused depth/stencil test + color output, replacing the separate run
+ * through the blend stage for the common no-blend single-cbuf case.
+ * Each quad is processed end-to-end in one pass over its data.
+ */
+static void
+fused_depth_test_output(struct quad_stage *qs,
+                        struct quad_header *quads[],
+                        unsigned nr)
+{
+   struct softpipe_cached_tile *tile;
+   unsigned i, j, q;
+
+   nr = depth_stencil_test_quads(qs, quads, nr);
+   if (!nr)
+      return;
+
+   tile = sp_get_cached_tile(qs->softpipe->cbuf_cache[0],
+                             quads[0]->input.x0,
+                             quads[0]->input.y0, quads[0]->input.layer);
+
+   for (q = 0; q < nr; q++) {
+      struct quad_header *quad = quads[q];
+      float (*quadColor)[4] = quad->output.color[0];
+      const int itx = (quad->input.x0 & (TILE_SIZE-1));
+      const int ity = (quad->input.y0 & (TILE_SIZE-1));
+
+      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+         if (quad->inout.mask & (1 << j)) {
+            int x = itx + (j & 1);
+            int y = ity + (j >> 1);
+            for (i = 0; i < 4; i++) { /* loop over color chans */
+               tile->data.color[y][x][i] = quadColor[i][j];
+            }
+         }
+      }
+   }
+}
+
+
+/**
+ * Fused depth/stencil test + standard alpha blending.  Only used for
+ * normalized color buffers, so the fragment colors are always clamped
+ * before and after blending.
+ */
+static void
+fused_depth_test_blend_alpha(struct quad_stage *qs,
+                             struct quad_header *quads[],
+                             unsigned nr)
+{
+   struct softpipe_cached_tile *tile;
+   unsigned i, j, q;
+
+   nr = depth_stencil_test_quads(qs, quads, nr);
+   if (!nr)
+      return;
+
+   tile = sp_get_cached_tile(qs->softpipe->cbuf_cache[0],
+                             quads[0]->input.x0,
+                             quads[0]->input.y0, quads[0]->input.layer);
+
+   for (q = 0; q < nr; q++) {
+      struct quad_header *quad = quads[q];
+      float (*quadColor)[4] = quad->output.color[0];
+      const int itx = (quad->input.x0 & (TILE_SIZE-1));
+      const int ity = (quad->input.y0 & (TILE_SIZE-1));
+
+      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+         if (quad->inout.mask & (1 << j)) {
+            const int x = itx + (j & 1);
+            const int y = ity + (j >> 1);
+            const float alpha = CLAMP(quadColor[3][j], 0.0f, 1.0f);
+            const float one_minus_alpha = 1.0f - alpha;
+
+            for (i = 0; i < 4; i++) { /* loop over color chans */
+               const float src = CLAMP(quadColor[i][j], 0.0f, 1.0f);
+               const float blended = src * alpha +
+                  tile->data.color[y][x][i] * one_minus_alpha;
+               tile->data.color[y][x][i] = CLAMP(blended, 0.0f, 1.0f);
+            }
+         }
+      }
+   }
+}
+
+
+/**
+ * Check whether the blend-side state allows replacing the blend stage
+ * with one of the fused depth+color output paths.
+ */
+static boolean
+fused_color_output_possible(struct quad_stage *qs)
+{
+   struct softpipe_context *softpipe = qs->softpipe;
+   const struct pipe_blend_state *blend = softpipe->blend;
+   enum pipe_format format;
+
+   /* Must feed the blend stage directly; in particular the early-z
+    * pipeline order (depth before shade) can't skip the shade stage.
+    */
+   if (qs->next != softpipe->quad.blend)
+      return FALSE;
+
+   if (softpipe->framebuffer.nr_cbufs != 1 ||
+       !softpipe->framebuffer.cbufs[0])
+      return FALSE;
+
+   if (blend->logicop_enable ||
+       blend->rt[0].colormask != 0xf)
+      return FALSE;
+
+   if (softpipe->rasterizer->clamp_fragment_color)
+      return FALSE;
+
+   /* Keep the color write a plain masked copy: no luminance/intensity/rgb
+    * rebasing (see choose_blend_quad()).
+    */
+   format = softpipe->framebuffer.cbufs[0]->format;
+   if (util_format_is_intensity(format) ||
+       util_format_is_luminance(format) ||
+       util_format_is_luminance_alpha(format) ||
+       !util_format_has_alpha(format))
+      return FALSE;
+
+   return TRUE;
+}
+
+
 /**
  * Special-case Z testing for 16-bit Zbuffer and Z buffer writes enabled.
  */
@@ -973,6 +1118,29 @@ choose_depth_test(struct quad_stage *qs,
       }
    }
 
+   /* If we'd otherwise take the general path and the color output is
+    * simple enough, use a fused function which also does the work of the
+    * blend stage, so each quad makes a single pass through its data.
+    */
+   if (qs->run == depth_test_quads_fallback &&
+       fused_color_output_possible(qs)) {
+      const struct pipe_blend_state *blend = qs->softpipe->blend;
+
+      if (!blend->rt[0].blend_enable) {
+         qs->run = fused_depth_test_output;
+      }
+      else if (util_format_description(qs->softpipe->framebuffer.cbufs[0]->
+                                       format)->channel[0].normalized &&
+               blend->rt[0].rgb_func == PIPE_BLEND_ADD &&
+               blend->rt[0].alpha_func == PIPE_BLEND_ADD &&
+               blend->rt[0].rgb_src_factor == PIPE_BLENDFACTOR_SRC_ALPHA &&
+               blend->rt[0].alpha_src_factor == PIPE_BLENDFACTOR_SRC_ALPHA &&
+               blend->rt[0].rgb_dst_factor == PIPE_BLENDFACTOR_INV_SRC_ALPHA &&
+               blend->rt[0].alpha_dst_factor == PIPE_BLENDFACTOR_INV_SRC_ALPHA) {
+         qs->run = fused_depth_test_blend_alpha;
+      }
+   }
+
    /* next quad/fragment stage */
    qs->run( qs, quads, nr );
 }
@@ -36,22 +36,69 @@
  * all the enabled attributes run contiguously.
  */
 
+#include "util/u_debug.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "pipe/p_defines.h"
 #include "pipe/p_shader_tokens.h"
+#include "os/os_thread.h"
+#include "tgsi/tgsi_exec.h"
 
 #include "sp_context.h"
 #include "sp_state.h"
 #include "sp_quad.h"
 #include "sp_quad_pipe.h"
+#include "sp_texture.h"
+#include "sp_tex_sample.h"
+#include "sp_tex_tile_cache.h"
+
+
+/** Max number of worker threads (including the main thread) */
+#define SP_MAX_SHADE_THREADS 16
+
+/** Max quads per quad_stage::run() batch (MAX_QUADS in sp_setup.c) */
+#define SP_MAX_SHADE_QUADS 16
+
+
+struct quad_shade_stage;
+
+
+/**
+ * Per-thread state for parallel fragment shading.  Each worker owns a
+ * TGSI machine and a private set of texture tile caches so shading
+ * doesn't touch any mutable context state.
+ */
+struct shade_worker
+{
+   struct quad_shade_stage *qss;
+   unsigned index;
+
+   pipe_thread thread;
+   pipe_semaphore work_ready;
+   pipe_semaphore work_done;
+   boolean exit_flag;
+
+   struct tgsi_exec_machine *machine;
+   struct sp_tgsi_sampler *sampler;
+   struct softpipe_tex_tile_cache *tex_cache[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+};
 
 
 struct quad_shade_stage
 {
    struct quad_stage stage;  /**< base class */
 
-   /* no other fields at this time */
+   /** Total number of shading threads; <= 1 means serial operation */
+   unsigned num_threads;
+   /** Whether the current state allows threaded shading (set per begin) */
+   boolean threads_active;
+   /** workers[1..num_threads-1] are used; index 0 is the main thread */
+   struct shade_worker workers[SP_MAX_SHADE_THREADS];
+
+   /** Current batch of quads being shaded by the workers */
+   struct quad_header **job_quads;
+   unsigned job_nr;
+   boolean job_alive[SP_MAX_SHADE_QUADS];
 };
 
 
@@ -64,23 +111,38 @@ quad_shade_stage(struct quad_stage *qs)
 
 
 /**
- * Execute fragment shader for the four fragments in the quad.
+ * Execute fragment shader for the four fragments in the quad on the
+ * given machine.
+ * \return TRUE if quad is alive, FALSE if all four pixels are killed
+ */
+static inline boolean
+shade_one(struct quad_stage *qs,
+          struct tgsi_exec_machine *machine,
+          struct quad_header *quad)
+{
+   struct softpipe_context *softpipe = qs->softpipe;
+
+   /* run shader */
+   machine->flatshade_color = softpipe->rasterizer->flatshade ? TRUE : FALSE;
+   return softpipe->fs_variant->run( softpipe->fs_variant, machine, quad, softpipe->early_depth );
+}
+
+
+/**
+ * Serial path: shade one quad on the context's machine, updating stats.
  * \return TRUE if quad is alive, FALSE if all four pixels are killed
  */
 static inline boolean
 shade_quad(struct quad_stage *qs, struct quad_header *quad)
 {
    struct softpipe_context *softpipe = qs->softpipe;
-   struct tgsi_exec_machine *machine = softpipe->fs_machine;
 
    if (softpipe->active_statistics_queries) {
       softpipe->pipeline_statistics.ps_invocations +=
-         util_bitcount(quad->inout.mask);         
+         util_bitcount(quad->inout.mask);
    }
 
-   /* run shader */
-   machine->flatshade_color = softpipe->rasterizer->flatshade ? TRUE : FALSE;
-   return softpipe->fs_variant->run( softpipe->fs_variant, machine, quad, softpipe->early_depth );
+   return shade_one(qs, softpipe->fs_machine, quad);
 }
 
 
@@ -104,15 +166,107 @@ coverage_quad(struct quad_stage *qs, struct quad_header *quad)
 }
 
 
+/**
+ * Shade every nth quad of the current batch, starting at \p first.
+ * The same interleaved split is used by the main thread and by each
+ * worker, so the batch is consumed exactly once.
+ */
+static void
+shade_worker_subset(struct quad_shade_stage *qss,
+                    struct tgsi_exec_machine *machine,
+                    unsigned first)
+{
+   unsigned i;
+
+   for (i = first; i < qss->job_nr; i += qss->num_threads) {
+      qss->job_alive[i] = shade_one(&qss->stage, machine, qss->job_quads[i]);
+   }
+}
+
+
+static PIPE_THREAD_ROUTINE( shade_worker_thread, init_data )
+{
+   struct shade_worker *worker = (struct shade_worker *) init_data;
+   struct quad_shade_stage *qss = worker->qss;
+
+   while (1) {
+      /* wait for work */
+      pipe_semaphore_wait(&worker->work_ready);
+
+      if (worker->exit_flag)
+         break;
+
+      shade_worker_subset(qss, worker->machine, worker->index);
+
+      /* signal done with work */
+      pipe_semaphore_signal(&worker->work_done);
+   }
+
+   pipe_semaphore_signal(&worker->work_done);
+
+   return 0;
+}
+
+
+/**
+ * Shade a batch of quads on all threads, then pass the survivors down
+ * the pipe in their original order.  Depth test and blend still run
+ * serially on the main thread, so quad ordering is preserved.
+ */
+static void
+shade_quads_threaded(struct quad_stage *qs,
+                     struct quad_header *quads[],
+                     unsigned nr)
+{
+   struct quad_shade_stage *qss = quad_shade_stage(qs);
+   struct softpipe_context *softpipe = qs->softpipe;
+   unsigned t, i, nr_quads = 0;
+
+   if (softpipe->active_statistics_queries) {
+      for (i = 0; i < nr; i++) {
+         softpipe->pipeline_statistics.ps_invocations +=
+            util_bitcount(quads[i]->inout.mask);
+      }
+   }
+
+   qss->job_quads = quads;
+   qss->job_nr = nr;
+
+   for (t = 1; t < qss->num_threads; t++) {
+      qss->workers[t].machine->InterpCoefs = quads[0]->coef;
+      pipe_semaphore_signal(&qss->workers[t].work_ready);
+   }
+
+   shade_worker_subset(qss, softpipe->fs_machine, 0);
+
+   for (t = 1; t < qss->num_threads; t++) {
+      pipe_semaphore_wait(&qss->workers[t].work_done);
+   }
+
+   /* Same compaction rule as the serial path: keep the first quad even
+    * if it was entirely killed, see the comment in shade_quads().
+    */
+   for (i = 0; i < nr; i++) {
+      if (!qss->job_alive[i] && i > 0)
+         continue;
+      quads[nr_quads++] = quads[i];
+   }
+
+   if (nr_quads)
+      qs->next->run(qs->next, quads, nr_quads);
+}
+
+
 /**
  * Shade/write an array of quads
  * Called via quad_stage::run()
  */
 static void
-shade_quads(struct quad_stage *qs, 
+shade_quads(struct quad_stage *qs,
             struct quad_header *quads[],
             unsigned nr)
 {
+   struct quad_shade_stage *qss = quad_shade_stage(qs);
    struct softpipe_context *softpipe = qs->softpipe;
    struct tgsi_exec_machine *machine = softpipe->fs_machine;
    unsigned i, nr_quads = 0;
@@ -123,6 +277,11 @@ shade_quads(struct quad_stage *qs,
 
    machine->InterpCoefs = quads[0]->coef;
 
+   if (qss->threads_active && nr > 1 && nr <= SP_MAX_SHADE_QUADS) {
+      shade_quads_threaded(qs, quads, nr);
+      return;
+   }
+
    for (i = 0; i < nr; i++) {
       /* Only omit this quad from the output list if all the fragments
        * are killed _AND_ it's not the first quad in the list.
@@ -147,12 +306,99 @@ shade_quads(struct quad_stage *qs,
 }
    
 
+/**
+ * Check whether the current state is safe for threaded shading.
+ * Shaders with side effects and textures which may force a flush or go
+ * through the winsys when a tile is fetched have to stay serial.
+ */
+static boolean
+shade_threads_usable(struct softpipe_context *softpipe)
+{
+   const struct tgsi_shader_info *info = &softpipe->fs_variant->info;
+   unsigned i;
+
+   if (info->file_max[TGSI_FILE_IMAGE] >= 0 ||
+       info->file_max[TGSI_FILE_BUFFER] >= 0)
+      return FALSE;
+
+   for (i = 0; i < softpipe->num_sampler_views[PIPE_SHADER_FRAGMENT]; i++) {
+      struct pipe_sampler_view *view =
+         softpipe->sampler_views[PIPE_SHADER_FRAGMENT][i];
+
+      if (!view)
+         continue;
+
+      if (softpipe_resource(view->texture)->dt)
+         return FALSE;
+
+      if (softpipe_is_resource_referenced(&softpipe->pipe, view->texture,
+                                          0, 0) & SP_REFERENCED_FOR_WRITE)
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
 /**
  * Per-primitive (or per-begin?) setup
  */
 static void
 shade_begin(struct quad_stage *qs)
 {
+   struct quad_shade_stage *qss = quad_shade_stage(qs);
+   struct softpipe_context *softpipe = qs->softpipe;
+
+   qss->threads_active = qss->num_threads > 1 &&
+                         shade_threads_usable(softpipe);
+
+   if (qss->threads_active) {
+      const unsigned num_views =
+         softpipe->num_sampler_views[PIPE_SHADER_FRAGMENT];
+      unsigned t, i;
+
+      for (t = 1; t < qss->num_threads; t++) {
+         struct shade_worker *worker = &qss->workers[t];
+
+         /* Mirror the context's fragment sampler state, redirecting the
+          * texture caches to this worker's private ones.
+          */
+         memcpy(worker->sampler,
+                softpipe->tgsi.sampler[PIPE_SHADER_FRAGMENT],
+                sizeof(*worker->sampler));
+
+         for (i = 0; i < num_views; i++) {
+            struct pipe_sampler_view *view =
+               softpipe->sampler_views[PIPE_SHADER_FRAGMENT][i];
+            struct softpipe_tex_tile_cache *tc = worker->tex_cache[i];
+
+            sp_tex_tile_cache_set_sampler_view(tc, view);
+            if (view) {
+               struct softpipe_resource *spr =
+                  softpipe_resource(view->texture);
+               if (spr->timestamp != tc->timestamp) {
+                  sp_tex_tile_cache_validate_texture(tc);
+                  tc->timestamp = spr->timestamp;
+               }
+               worker->sampler->sp_sview[i].cache = tc;
+            }
+         }
+
+         softpipe->fs_variant->prepare(softpipe->fs_variant,
+                                       worker->machine,
+                                       (struct tgsi_sampler *) worker->sampler,
+                                       (struct tgsi_image *) softpipe->
+                                       tgsi.image[PIPE_SHADER_FRAGMENT],
+                                       (struct tgsi_buffer *) softpipe->
+                                       tgsi.buffer[PIPE_SHADER_FRAGMENT]);
+
+         tgsi_exec_set_constant_buffers(worker->machine,
+                         PIPE_MAX_CONSTANT_BUFFERS,
+                         softpipe->mapped_constants[PIPE_SHADER_FRAGMENT],
+                         softpipe->const_buffer_size[PIPE_SHADER_FRAGMENT]);
+      }
+   }
+
    qs->next->begin(qs->next);
 }
 
@@ -160,6 +406,32 @@ shade_begin(struct quad_stage *qs)
 static void
 shade_destroy(struct quad_stage *qs)
 {
+   struct quad_shade_stage *qss = quad_shade_stage(qs);
+   unsigned t, i;
+
+   for (t = 1; t < qss->num_threads; t++) {
+      struct shade_worker *worker = &qss->workers[t];
+
+      worker->exit_flag = TRUE;
+      pipe_semaphore_signal(&worker->work_ready);
+      /* Wait for the worker to acknowledge instead of joining it, to
+       * avoid a deadlock on Windows (see lp_rast_destroy()).
+       */
+      pipe_semaphore_wait(&worker->work_done);
+
+      pipe_semaphore_destroy(&worker->work_ready);
+      pipe_semaphore_destroy(&worker->work_done);
+
+      for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+         if (worker->tex_cache[i]) {
+            sp_tex_tile_cache_set_sampler_view(worker->tex_cache[i], NULL);
+            sp_destroy_tex_tile_cache(worker->tex_cache[i]);
+         }
+      }
+      FREE(worker->sampler);
+      tgsi_exec_machine_destroy(worker->machine);
+   }
+
    FREE( qs );
 }
 
@@ -168,6 +440,9 @@ struct quad_stage *
 sp_quad_shade_stage( struct softpipe_context *softpipe )
 {
    struct quad_shade_stage *qss = CALLOC_STRUCT(quad_shade_stage);
+   long num_threads;
+   unsigned t, i;
+
    if (!qss)
       goto fail;
 
@@ -176,6 +451,33 @@ sp_quad_shade_stage( struct softpipe_context *softpipe )
    qss->stage.run = shade_quads;
    qss->stage.destroy = shade_destroy;
 
+   /* Threaded shading is opt-in; default remains serial operation. */
+   num_threads = debug_get_num_option("SOFTPIPE_NUM_THREADS", 0);
+   qss->num_threads = CLAMP(num_threads, 0, SP_MAX_SHADE_THREADS);
+
+   for (t = 1; t < qss->num_threads; t++) {
+      struct shade_worker *worker = &qss->workers[t];
+
+      worker->qss = qss;
+      worker->index = t;
+      worker->machine = tgsi_exec_machine_create(PIPE_SHADER_FRAGMENT);
+      worker->sampler = sp_create_tgsi_sampler();
+      if (!worker->machine || !worker->sampler) {
+         /* just run with the workers created so far */
+         FREE(worker->sampler);
+         if (worker->machine)
+            tgsi_exec_machine_destroy(worker->machine);
+         qss->num_threads = t;
+         break;
+      }
+      for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+         worker->tex_cache[i] = sp_create_tex_tile_cache(&softpipe->pipe);
+      }
+      pipe_semaphore_init(&worker->work_ready, 0);
+      pipe_semaphore_init(&worker->work_done, 0);
+      worker->thread = pipe_thread_create(shade_worker_thread, worker);
+   }
+
    return &qss->stage;
 
 fail:
@@ -37,6 +37,7 @@
 #include "draw/draw_context.h"
 #include "draw/draw_vs.h"
 #include "draw/draw_gs.h"
+#include "tgsi/tgsi_dce.h"
 #include "tgsi/tgsi_dump.h"
 #include "tgsi/tgsi_scan.h"
 #include "tgsi/tgsi_parse.h"
@@ -129,6 +130,17 @@ softpipe_create_fs_state(struct pipe_context *pipe,
    /* we need to keep a local copy of the tokens */
    state->shader.tokens = tgsi_dup_tokens(templ->tokens);
 
+   /* Strip instructions whose results are never used; the interpreter
+    * pays for every instruction on every fragment.
+    */
+   {
+      struct tgsi_token *opt = tgsi_dce(state->shader.tokens);
+      if (opt) {
+         tgsi_free_tokens(state->shader.tokens);
+         state->shader.tokens = opt;
+      }
+   }
+
    /* draw's fs state */
    state->draw_shader = draw_create_fragment_shader(softpipe->draw,
                                                     &state->shader);
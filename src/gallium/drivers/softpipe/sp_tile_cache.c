@@ -43,13 +43,12 @@ sp_alloc_tile(struct softpipe_tile_cache *tc);
 
 
 /**
- * Return the position in the cache for the tile that contains win pos (x,y).
- * We currently use a direct mapped cache so this is like a hack key.
- * At some point we should investige something more sophisticated, like
- * a LRU replacement policy.
+ * Return the set in the cache for the tile that contains win pos (x,y).
+ * The cache is set associative: a tile can live in any of the NUM_WAYS
+ * ways of its set and we evict the least recently used way on a miss.
  */
-#define CACHE_POS(x, y, l)                        \
-   (((x) + (y) * 5 + (l) * 10) % NUM_ENTRIES)
+#define CACHE_SET(x, y, l)                        \
+   (((x) + (y) * 5 + (l) * 10) % NUM_SETS)
 
 
 static inline int addr_to_clear_pos(union tile_address addr)
@@ -111,6 +110,7 @@ sp_create_tile_cache( struct pipe_context *pipe )
          tc->tile_addrs[pos].bits.invalid = 1;
       }
       tc->last_tile_addr.bits.invalid = 1;
+      tc->last_miss_addr.bits.invalid = 1;
 
       /* this allocation allows us to guarantee that allocation
        * failures are never fatal later
@@ -509,111 +509,165 @@ sp_alloc_tile(struct softpipe_tile_cache *tc)
 }
 
 /**
- * Get a tile from the cache.
- * \param x, y  position of tile, in pixels
+ * Get the cache entry holding the given tile, loading the tile from the
+ * transfer (or materializing it from the clear value) on a miss.
+ * Hits update the entry's LRU stamp; misses fill an empty way of the
+ * tile's set if there is one, else evict the least recently used way.
  */
-struct softpipe_cached_tile *
-sp_find_cached_tile(struct softpipe_tile_cache *tc, 
-                    union tile_address addr )
+static struct softpipe_cached_tile *
+sp_load_tile(struct softpipe_tile_cache *tc,
+             union tile_address addr)
 {
    struct pipe_transfer *pt;
-   /* cache pos/entry: */
-   const int pos = CACHE_POS(addr.bits.x,
+   const int set = CACHE_SET(addr.bits.x,
                              addr.bits.y, addr.bits.layer);
-   struct softpipe_cached_tile *tile = tc->entries[pos];
+   struct softpipe_cached_tile *tile;
+   int way, pos, free_pos = -1, lru_pos = -1;
    int layer;
+
+   /* look for the tile among the ways of its set */
+   for (way = 0; way < NUM_WAYS; way++) {
+      pos = set * NUM_WAYS + way;
+      if (tc->entries[pos] && addr.value == tc->tile_addrs[pos].value) {
+         tc->age[pos] = ++tc->age_counter;
+         tc->prefetch_hint = FALSE;
+         return tc->entries[pos];
+      }
+      if (!tc->entries[pos] || tc->tile_addrs[pos].bits.invalid) {
+         if (free_pos < 0)
+            free_pos = pos;
+      }
+      else if (lru_pos < 0 || tc->age[pos] < tc->age[lru_pos]) {
+         lru_pos = pos;
+      }
+   }
+
+   pos = free_pos >= 0 ? free_pos : lru_pos;
+   tile = tc->entries[pos];
    if (!tile) {
       tile = sp_alloc_tile(tc);
       tc->entries[pos] = tile;
    }
 
-   if (addr.value != tc->tile_addrs[pos].value) {
-
-      layer = tc->tile_addrs[pos].bits.layer;
-      if (tc->tile_addrs[pos].bits.invalid == 0) {
-         /* put dirty tile back in framebuffer */
-         if (tc->depth_stencil) {
-            pipe_put_tile_raw(tc->transfer[layer], tc->transfer_map[layer],
-                              tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                              tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                              TILE_SIZE, TILE_SIZE,
-                              tile->data.depth32, 0/*STRIDE*/);
+   layer = tc->tile_addrs[pos].bits.layer;
+   if (tc->tile_addrs[pos].bits.invalid == 0) {
+      /* put dirty tile back in framebuffer */
+      if (tc->depth_stencil) {
+         pipe_put_tile_raw(tc->transfer[layer], tc->transfer_map[layer],
+                           tc->tile_addrs[pos].bits.x * TILE_SIZE,
+                           tc->tile_addrs[pos].bits.y * TILE_SIZE,
+                           TILE_SIZE, TILE_SIZE,
+                           tile->data.depth32, 0/*STRIDE*/);
+      }
+      else {
+         if (util_format_is_pure_uint(tc->surface->format)) {
+            pipe_put_tile_ui_format(tc->transfer[layer], tc->transfer_map[layer],
+                                   tc->tile_addrs[pos].bits.x * TILE_SIZE,
+                                   tc->tile_addrs[pos].bits.y * TILE_SIZE,
+                                   TILE_SIZE, TILE_SIZE,
+                                   tc->surface->format,
+                                   (unsigned *) tile->data.colorui128);
+         } else if (util_format_is_pure_sint(tc->surface->format)) {
+            pipe_put_tile_i_format(tc->transfer[layer], tc->transfer_map[layer],
+                                   tc->tile_addrs[pos].bits.x * TILE_SIZE,
+                                   tc->tile_addrs[pos].bits.y * TILE_SIZE,
+                                   TILE_SIZE, TILE_SIZE,
+                                   tc->surface->format,
+                                   (int *) tile->data.colori128);
+         } else {
+            pipe_put_tile_rgba_format(tc->transfer[layer], tc->transfer_map[layer],
+                                      tc->tile_addrs[pos].bits.x * TILE_SIZE,
+                                      tc->tile_addrs[pos].bits.y * TILE_SIZE,
+                                      TILE_SIZE, TILE_SIZE,
+                                      tc->surface->format,
+                                      (float *) tile->data.color);
          }
-         else {
-            if (util_format_is_pure_uint(tc->surface->format)) {
-               pipe_put_tile_ui_format(tc->transfer[layer], tc->transfer_map[layer],
+      }
+   }
+
+   tc->tile_addrs[pos] = addr;
+   tc->age[pos] = ++tc->age_counter;
+
+   layer = tc->tile_addrs[pos].bits.layer;
+   pt = tc->transfer[layer];
+   assert(pt->resource);
+
+   if (is_clear_flag_set(tc->clear_flags, addr, tc->clear_flags_size)) {
+      /* don't get tile from framebuffer, just clear it */
+      if (tc->depth_stencil) {
+         clear_tile(tile, pt->resource->format, tc->clear_val);
+      }
+      else {
+         clear_tile_rgba(tile, pt->resource->format, &tc->clear_color);
+      }
+      clear_clear_flag(tc->clear_flags, addr, tc->clear_flags_size);
+   }
+   else {
+      /* get new tile data from transfer */
+      if (tc->depth_stencil) {
+         pipe_get_tile_raw(tc->transfer[layer], tc->transfer_map[layer],
+                           tc->tile_addrs[pos].bits.x * TILE_SIZE,
+                           tc->tile_addrs[pos].bits.y * TILE_SIZE,
+                           TILE_SIZE, TILE_SIZE,
+                           tile->data.depth32, 0/*STRIDE*/);
+      }
+      else {
+         if (util_format_is_pure_uint(tc->surface->format)) {
+            pipe_get_tile_ui_format(tc->transfer[layer], tc->transfer_map[layer],
                                       tc->tile_addrs[pos].bits.x * TILE_SIZE,
                                       tc->tile_addrs[pos].bits.y * TILE_SIZE,
                                       TILE_SIZE, TILE_SIZE,
                                       tc->surface->format,
                                       (unsigned *) tile->data.colorui128);
-            } else if (util_format_is_pure_sint(tc->surface->format)) {
-               pipe_put_tile_i_format(tc->transfer[layer], tc->transfer_map[layer],
+         } else if (util_format_is_pure_sint(tc->surface->format)) {
+            pipe_get_tile_i_format(tc->transfer[layer], tc->transfer_map[layer],
                                       tc->tile_addrs[pos].bits.x * TILE_SIZE,
                                       tc->tile_addrs[pos].bits.y * TILE_SIZE,
                                       TILE_SIZE, TILE_SIZE,
                                       tc->surface->format,
                                       (int *) tile->data.colori128);
-            } else {
-               pipe_put_tile_rgba_format(tc->transfer[layer], tc->transfer_map[layer],
-                                         tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                         tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                         TILE_SIZE, TILE_SIZE,
-                                         tc->surface->format,
-                                         (float *) tile->data.color);
-            }
+         } else {
+            pipe_get_tile_rgba_format(tc->transfer[layer], tc->transfer_map[layer],
+                                      tc->tile_addrs[pos].bits.x * TILE_SIZE,
+                                      tc->tile_addrs[pos].bits.y * TILE_SIZE,
+                                      TILE_SIZE, TILE_SIZE,
+                                      tc->surface->format,
+                                      (float *) tile->data.color);
          }
       }
+   }
 
-      tc->tile_addrs[pos] = addr;
+   /* remember the miss for the sequential-walk prefetch heuristic */
+   tc->prefetch_hint = !tc->last_miss_addr.bits.invalid &&
+                       addr.bits.layer == tc->last_miss_addr.bits.layer &&
+                       addr.bits.y == tc->last_miss_addr.bits.y &&
+                       addr.bits.x == tc->last_miss_addr.bits.x + 1;
+   tc->last_miss_addr = addr;
 
-      layer = tc->tile_addrs[pos].bits.layer;
-      pt = tc->transfer[layer];
-      assert(pt->resource);
+   return tile;
+}
 
-      if (is_clear_flag_set(tc->clear_flags, addr, tc->clear_flags_size)) {
-         /* don't get tile from framebuffer, just clear it */
-         if (tc->depth_stencil) {
-            clear_tile(tile, pt->resource->format, tc->clear_val);
-         }
-         else {
-            clear_tile_rgba(tile, pt->resource->format, &tc->clear_color);
-         }
-         clear_clear_flag(tc->clear_flags, addr, tc->clear_flags_size);
-      }
-      else {
-         /* get new tile data from transfer */
-         if (tc->depth_stencil) {
-            pipe_get_tile_raw(tc->transfer[layer], tc->transfer_map[layer],
-                              tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                              tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                              TILE_SIZE, TILE_SIZE,
-                              tile->data.depth32, 0/*STRIDE*/);
-         }
-         else {
-            if (util_format_is_pure_uint(tc->surface->format)) {
-               pipe_get_tile_ui_format(tc->transfer[layer], tc->transfer_map[layer],
-                                         tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                         tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                         TILE_SIZE, TILE_SIZE,
-                                         tc->surface->format,
-                                         (unsigned *) tile->data.colorui128);
-            } else if (util_format_is_pure_sint(tc->surface->format)) {
-               pipe_get_tile_i_format(tc->transfer[layer], tc->transfer_map[layer],
-                                         tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                         tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                         TILE_SIZE, TILE_SIZE,
-                                         tc->surface->format,
-                                         (int *) tile->data.colori128);
-            } else {
-               pipe_get_tile_rgba_format(tc->transfer[layer], tc->transfer_map[layer],
-                                         tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                         tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                         TILE_SIZE, TILE_SIZE,
-                                         tc->surface->format,
-                                         (float *) tile->data.color);
-            }
-         }
+
+/**
+ * Get a tile from the cache.
+ * \param x, y  position of tile, in pixels
+ */
+struct softpipe_cached_tile *
+sp_find_cached_tile(struct softpipe_tile_cache *tc,
+                    union tile_address addr )
+{
+   struct softpipe_cached_tile *tile = sp_load_tile(tc, addr);
+
+   /* If this miss continues a left-to-right walk along a scanline, pull
+    * in the next tile ahead of its first use.  Adjacent x values always
+    * select different sets, so this can't evict the tile being returned.
+    */
+   if (tc->prefetch_hint) {
+      union tile_address next = addr;
+      next.bits.x = addr.bits.x + 1;
+      if (next.bits.x * TILE_SIZE < (unsigned) tc->transfer[addr.bits.layer]->box.width) {
+         tc->prefetch_hint = FALSE;
+         sp_load_tile(tc, next);
       }
    }
 
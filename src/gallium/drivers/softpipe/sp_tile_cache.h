@@ -76,7 +76,14 @@ struct softpipe_cached_tile
    } data;
 };
 
-#define NUM_ENTRIES 50
+/**
+ * The cache is set associative with LRU replacement within each set,
+ * so scattered framebuffer accesses mapping to the same set no longer
+ * evict each other on every lookup.
+ */
+#define NUM_SETS 12
+#define NUM_WAYS 4
+#define NUM_ENTRIES (NUM_SETS * NUM_WAYS)
 
 
 struct softpipe_tile_cache
@@ -89,6 +96,8 @@ struct softpipe_tile_cache
 
    union tile_address tile_addrs[NUM_ENTRIES];
    struct softpipe_cached_tile *entries[NUM_ENTRIES];
+   unsigned age[NUM_ENTRIES];   /**< LRU stamps, see age_counter */
+   unsigned age_counter;
    uint *clear_flags;
    uint clear_flags_size;
    union pipe_color_union clear_color; /**< for color bufs */
@@ -99,6 +108,10 @@ struct softpipe_tile_cache
 
    union tile_address last_tile_addr;
    struct softpipe_cached_tile *last_tile;  /**< most recently retrieved tile */
+
+   /** For detecting a sequential walk along a scanline, for prefetch */
+   union tile_address last_miss_addr;
+   boolean prefetch_hint;
 };
 
 
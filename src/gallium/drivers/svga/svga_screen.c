@@ -34,6 +34,7 @@
 #include "svga_context.h"
 #include "svga_format.h"
 #include "svga_screen.h"
+#include "svga_shader.h"
 #include "svga_tgsi.h"
 #include "svga_resource_texture.h"
 #include "svga_resource.h"
@@ -888,7 +889,9 @@ svga_destroy_screen( struct pipe_screen *screen )
    struct svga_screen *svgascreen = svga_screen(screen);
    
    svga_screen_cache_cleanup(svgascreen);
+   svga_variant_cache_destroy(svgascreen);
 
+   pipe_mutex_destroy(svgascreen->variant_mutex);
    pipe_mutex_destroy(svgascreen->swc_mutex);
    pipe_mutex_destroy(svgascreen->tex_mutex);
 
@@ -1074,8 +1077,10 @@ svga_screen_create(struct svga_winsys_screen *sws)
 
    pipe_mutex_init(svgascreen->tex_mutex);
    pipe_mutex_init(svgascreen->swc_mutex);
+   pipe_mutex_init(svgascreen->variant_mutex);
 
    svga_screen_cache_init(svgascreen);
+   svga_variant_cache_init(svgascreen);
 
    return screen;
 error2:
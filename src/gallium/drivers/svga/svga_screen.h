@@ -36,6 +36,7 @@
 struct svga_winsys_screen;
 struct svga_winsys_context;
 struct SVGACmdMemory;
+struct util_hash_table;
 
 /**
  * Subclass of pipe_screen
@@ -80,6 +81,16 @@ struct svga_screen
 
    struct svga_host_surface_cache cache;
 
+   /** Cache of translated shader variants, shared by all contexts on
+    * this screen.  Maps (TGSI token hash, compile key, shader type) to
+    * the compiled bytecode so other contexts don't re-translate.
+    */
+   struct util_hash_table *variant_cache;
+   pipe_mutex variant_mutex;
+
+   /** $SVGA_SHADER_CACHE_DIR, or NULL if the on-disk tier is disabled */
+   const char *variant_cache_dir;
+
    /** HUD counters */
    struct {
       /** Memory used by all resources (buffers and surfaces) */
@@ -23,8 +23,14 @@
  *
  **********************************************************/
 
+#include <stdio.h>
+
 #include "util/u_bitmask.h"
+#include "util/u_debug.h"
+#include "util/u_hash_table.h"
 #include "util/u_memory.h"
+#include "util/u_string.h"
+#include "tgsi/tgsi_parse.h"
 #include "svga_context.h"
 #include "svga_cmd.h"
 #include "svga_format.h"
@@ -218,11 +224,15 @@ svga_search_shader_key(const struct svga_shader *shader,
                        const struct svga_compile_key *key)
 {
    struct svga_shader_variant *variant = shader->variants;
+   uint32_t key_hash;
 
    assert(key);
 
+   key_hash = svga_compile_key_hash(key);
+
    for ( ; variant; variant = variant->next) {
-      if (svga_compile_keys_equal(key, &variant->key))
+      if (variant->key_hash == key_hash &&
+          svga_compile_keys_equal(key, &variant->key))
          return variant;
    }
    return NULL;
@@ -465,6 +475,392 @@ svga_destroy_shader_variant(struct svga_context *svga,
    return ret;
 }
 
+/***********************************************************************
+ * Screen-wide shader variant cache.
+ *
+ * Translating TGSI into SVGA3D bytecode is expensive enough to show up
+ * when many contexts (or many short-lived processes, as in VDI logins)
+ * keep compiling the same shader set.  The cache maps a (TGSI token
+ * string, compile key, shader type) triple to the translated bytecode
+ * so the work is done once per screen, with an optional on-disk tier
+ * that carries translations across processes.
+ */
+
+struct svga_variant_cache_entry
+{
+   /* lookup key */
+   uint32_t tgsi_hash;    /**< crc32 of the source TGSI tokens */
+   uint32_t key_hash;
+   unsigned unit;         /**< PIPE_SHADER_x */
+   struct svga_compile_key key;
+
+   /* translation result */
+   uint32_t *tokens;
+   unsigned nr_tokens;
+   unsigned extra_const_start;
+   boolean uses_flat_interp;
+   boolean constant_color_output;
+   unsigned pstipple_sampler_unit;
+};
+
+
+#define SVGA_VARIANT_CACHE_MAGIC   0x53564743  /* 'SVGC' */
+
+/** Bump whenever the file layout or the translator output changes */
+#define SVGA_VARIANT_CACHE_VERSION 1
+
+/** On-disk layout: this header, then the compile key, then the tokens */
+struct svga_variant_cache_file
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t hw_version;
+   uint32_t vgpu10;
+   uint32_t gb_objects;
+   uint32_t unit;
+   uint32_t tgsi_hash;
+   uint32_t key_size;
+   uint32_t nr_tokens;
+   uint32_t extra_const_start;
+   uint32_t uses_flat_interp;
+   uint32_t constant_color_output;
+   uint32_t pstipple_sampler_unit;
+};
+
+
+static unsigned
+svga_variant_cache_hash_func(void *key)
+{
+   const struct svga_variant_cache_entry *entry = key;
+
+   return entry->tgsi_hash ^ entry->key_hash ^ entry->unit;
+}
+
+
+static int
+svga_variant_cache_compare_func(void *key1, void *key2)
+{
+   struct svga_variant_cache_entry *a = key1;
+   struct svga_variant_cache_entry *b = key2;
+
+   if (a->unit == b->unit &&
+       a->tgsi_hash == b->tgsi_hash &&
+       svga_compile_keys_equal(&a->key, &b->key))
+      return 0;
+   return 1;
+}
+
+
+void
+svga_variant_cache_init(struct svga_screen *svgascreen)
+{
+   svgascreen->variant_cache =
+      util_hash_table_create(svga_variant_cache_hash_func,
+                             svga_variant_cache_compare_func);
+   svgascreen->variant_cache_dir =
+      debug_get_option("SVGA_SHADER_CACHE_DIR", NULL);
+}
+
+
+static enum pipe_error
+variant_cache_entry_destroy(void *key, void *value, void *data)
+{
+   struct svga_variant_cache_entry *entry = value;
+
+   FREE(entry->tokens);
+   FREE(entry);
+   return PIPE_OK;
+}
+
+
+void
+svga_variant_cache_destroy(struct svga_screen *svgascreen)
+{
+   if (svgascreen->variant_cache) {
+      util_hash_table_foreach(svgascreen->variant_cache,
+                              variant_cache_entry_destroy, NULL);
+      util_hash_table_destroy(svgascreen->variant_cache);
+      svgascreen->variant_cache = NULL;
+   }
+}
+
+
+/** Fill in a cache entry with just the lookup key fields */
+static void
+svga_variant_cache_probe(const struct svga_shader *shader,
+                         const struct svga_compile_key *key,
+                         unsigned unit,
+                         struct svga_variant_cache_entry *probe)
+{
+   memset(probe, 0, sizeof(*probe));
+   probe->tgsi_hash = util_hash_crc32(shader->tokens,
+                                      tgsi_num_tokens(shader->tokens)
+                                      * sizeof(struct tgsi_token));
+   probe->key_hash = svga_compile_key_hash(key);
+   probe->unit = unit;
+   memcpy(&probe->key, key, svga_compile_key_size(key));
+}
+
+
+static void
+svga_variant_cache_filename(const struct svga_screen *svgascreen,
+                            const struct svga_variant_cache_entry *entry,
+                            char *filename, size_t len)
+{
+   util_snprintf(filename, len, "%s/svga-%08x-%08x-%u.shader",
+                 svgascreen->variant_cache_dir,
+                 entry->tgsi_hash, entry->key_hash, entry->unit);
+}
+
+
+/**
+ * Try to load a cache entry from the on-disk tier.  Anything unexpected
+ * (stale layout version, different device configuration, short read) is
+ * simply treated as a miss.
+ */
+static struct svga_variant_cache_entry *
+svga_variant_cache_load(struct svga_screen *svgascreen,
+                        const struct svga_variant_cache_entry *probe)
+{
+   struct svga_variant_cache_entry *entry = NULL;
+   struct svga_variant_cache_file header;
+   unsigned key_size = svga_compile_key_size(&probe->key);
+   char filename[1024];
+   FILE *f;
+
+   svga_variant_cache_filename(svgascreen, probe, filename, sizeof(filename));
+
+   f = fopen(filename, "rb");
+   if (!f)
+      return NULL;
+
+   if (fread(&header, sizeof(header), 1, f) != 1 ||
+       header.magic != SVGA_VARIANT_CACHE_MAGIC ||
+       header.version != SVGA_VARIANT_CACHE_VERSION ||
+       header.hw_version != (uint32_t) svgascreen->hw_version ||
+       header.vgpu10 != (uint32_t) svgascreen->sws->have_vgpu10 ||
+       header.gb_objects != (uint32_t) svgascreen->sws->have_gb_objects ||
+       header.unit != probe->unit ||
+       header.tgsi_hash != probe->tgsi_hash ||
+       header.key_size != key_size ||
+       header.nr_tokens == 0 ||
+       header.nr_tokens > (1 << 22) /* sanity bound for corrupt files */)
+      goto out;
+
+   entry = CALLOC_STRUCT(svga_variant_cache_entry);
+   if (!entry)
+      goto out;
+
+   entry->tokens = MALLOC(header.nr_tokens * sizeof(uint32_t));
+   if (!entry->tokens)
+      goto fail;
+
+   /* The filename only encodes hashes, so compare the full key to
+    * guard against collisions.
+    */
+   if (fread(&entry->key, key_size, 1, f) != 1 ||
+       !svga_compile_keys_equal(&probe->key, &entry->key) ||
+       fread(entry->tokens, header.nr_tokens * sizeof(uint32_t), 1, f) != 1)
+      goto fail;
+
+   entry->tgsi_hash = probe->tgsi_hash;
+   entry->key_hash = probe->key_hash;
+   entry->unit = probe->unit;
+   entry->nr_tokens = header.nr_tokens;
+   entry->extra_const_start = header.extra_const_start;
+   entry->uses_flat_interp = (boolean) header.uses_flat_interp;
+   entry->constant_color_output = (boolean) header.constant_color_output;
+   entry->pstipple_sampler_unit = header.pstipple_sampler_unit;
+
+out:
+   fclose(f);
+   return entry;
+
+fail:
+   FREE(entry->tokens);
+   FREE(entry);
+   entry = NULL;
+   goto out;
+}
+
+
+static void
+svga_variant_cache_save(struct svga_screen *svgascreen,
+                        const struct svga_variant_cache_entry *entry)
+{
+   struct svga_variant_cache_file header;
+   unsigned key_size = svga_compile_key_size(&entry->key);
+   char filename[1024], tmpname[1024 + 8];
+   FILE *f;
+
+   memset(&header, 0, sizeof(header));
+   header.magic = SVGA_VARIANT_CACHE_MAGIC;
+   header.version = SVGA_VARIANT_CACHE_VERSION;
+   header.hw_version = (uint32_t) svgascreen->hw_version;
+   header.vgpu10 = (uint32_t) svgascreen->sws->have_vgpu10;
+   header.gb_objects = (uint32_t) svgascreen->sws->have_gb_objects;
+   header.unit = entry->unit;
+   header.tgsi_hash = entry->tgsi_hash;
+   header.key_size = key_size;
+   header.nr_tokens = entry->nr_tokens;
+   header.extra_const_start = entry->extra_const_start;
+   header.uses_flat_interp = entry->uses_flat_interp;
+   header.constant_color_output = entry->constant_color_output;
+   header.pstipple_sampler_unit = entry->pstipple_sampler_unit;
+
+   svga_variant_cache_filename(svgascreen, entry, filename, sizeof(filename));
+   util_snprintf(tmpname, sizeof(tmpname), "%s.tmp", filename);
+
+   f = fopen(tmpname, "wb");
+   if (!f)
+      return;
+
+   if (fwrite(&header, sizeof(header), 1, f) == 1 &&
+       fwrite(&entry->key, key_size, 1, f) == 1 &&
+       fwrite(entry->tokens, entry->nr_tokens * sizeof(uint32_t), 1, f) == 1) {
+      fclose(f);
+      /* Publish atomically so a concurrent reader never sees a partial
+       * file.  If two processes race on the temp file the loser may
+       * install garbage, which fails validation on read and gets
+       * rewritten on the next miss.
+       */
+      rename(tmpname, filename);
+   }
+   else {
+      fclose(f);
+      remove(tmpname);
+   }
+}
+
+
+/**
+ * Look for a previously translated (tokens, key) pair in the screen's
+ * variant cache and, on a hit, wrap the cached bytecode in a fresh
+ * variant for this context.  The caller defines the shader with the
+ * device and links the variant into the list as if it had been newly
+ * translated.
+ */
+struct svga_shader_variant *
+svga_variant_cache_lookup(struct svga_context *svga,
+                          const struct svga_shader *shader,
+                          const struct svga_compile_key *key,
+                          unsigned unit)
+{
+   struct svga_screen *svgascreen = svga_screen(svga->pipe.screen);
+   struct svga_variant_cache_entry probe, *entry;
+   struct svga_shader_variant *variant = NULL;
+   uint32_t *tokens;
+
+   if (!svgascreen->variant_cache)
+      return NULL;
+
+   svga_variant_cache_probe(shader, key, unit, &probe);
+
+   pipe_mutex_lock(svgascreen->variant_mutex);
+
+   entry = util_hash_table_get(svgascreen->variant_cache, &probe);
+   if (!entry && svgascreen->variant_cache_dir) {
+      entry = svga_variant_cache_load(svgascreen, &probe);
+      if (entry &&
+          util_hash_table_set(svgascreen->variant_cache,
+                              entry, entry) != PIPE_OK) {
+         FREE(entry->tokens);
+         FREE(entry);
+         entry = NULL;
+      }
+   }
+
+   if (entry) {
+      tokens = MALLOC(entry->nr_tokens * sizeof(uint32_t));
+      if (tokens) {
+         variant = svga_new_shader_variant(svga);
+         if (variant) {
+            memcpy(tokens, entry->tokens,
+                   entry->nr_tokens * sizeof(uint32_t));
+            variant->shader = shader;
+            memcpy(&variant->key, key, sizeof(*key));
+            variant->key_hash = probe.key_hash;
+            variant->tokens = tokens;
+            variant->nr_tokens = entry->nr_tokens;
+            variant->id = UTIL_BITMASK_INVALID_INDEX;
+            variant->extra_const_start = entry->extra_const_start;
+            variant->uses_flat_interp = entry->uses_flat_interp;
+            variant->constant_color_output = entry->constant_color_output;
+            variant->pstipple_sampler_unit = entry->pstipple_sampler_unit;
+         }
+         else {
+            FREE(tokens);
+         }
+      }
+   }
+
+   pipe_mutex_unlock(svgascreen->variant_mutex);
+
+   return variant;
+}
+
+
+/**
+ * Add a freshly translated variant to the screen's variant cache.
+ * Fallback (dummy) shaders must not be added since their bytecode
+ * doesn't correspond to the application's TGSI.
+ */
+void
+svga_variant_cache_insert(struct svga_context *svga,
+                          const struct svga_shader *shader,
+                          unsigned unit,
+                          const struct svga_shader_variant *variant)
+{
+   struct svga_screen *svgascreen = svga_screen(svga->pipe.screen);
+   struct svga_variant_cache_entry probe, *entry;
+
+   if (!svgascreen->variant_cache)
+      return;
+
+   svga_variant_cache_probe(shader, &variant->key, unit, &probe);
+
+   pipe_mutex_lock(svgascreen->variant_mutex);
+
+   if (!util_hash_table_get(svgascreen->variant_cache, &probe)) {
+      entry = CALLOC_STRUCT(svga_variant_cache_entry);
+      if (entry) {
+         entry->tokens = MALLOC(variant->nr_tokens * sizeof(uint32_t));
+         if (!entry->tokens) {
+            FREE(entry);
+            entry = NULL;
+         }
+      }
+
+      if (entry) {
+         memcpy(entry->tokens, variant->tokens,
+                variant->nr_tokens * sizeof(uint32_t));
+         entry->tgsi_hash = probe.tgsi_hash;
+         entry->key_hash = probe.key_hash;
+         entry->unit = unit;
+         memcpy(&entry->key, &variant->key,
+                svga_compile_key_size(&variant->key));
+         entry->nr_tokens = variant->nr_tokens;
+         entry->extra_const_start = variant->extra_const_start;
+         entry->uses_flat_interp = variant->uses_flat_interp;
+         entry->constant_color_output = variant->constant_color_output;
+         entry->pstipple_sampler_unit = variant->pstipple_sampler_unit;
+
+         if (util_hash_table_set(svgascreen->variant_cache,
+                                 entry, entry) == PIPE_OK) {
+            if (svgascreen->variant_cache_dir)
+               svga_variant_cache_save(svgascreen, entry);
+         }
+         else {
+            FREE(entry->tokens);
+            FREE(entry);
+         }
+      }
+   }
+
+   pipe_mutex_unlock(svgascreen->variant_mutex);
+}
+
+
 /*
  * Rebind shaders.
  * Called at the beginning of every new command buffer to ensure that
@@ -26,6 +26,7 @@
 #ifndef SVGA_SHADER_H
 #define SVGA_SHADER_H
 
+#include "util/u_hash.h"
 #include "svga3d_reg.h"
 #include "svga_context.h"
 #include "svga_streamout.h"
@@ -133,6 +134,9 @@ struct svga_shader_variant
    /** Parameters used to generate this variant */
    struct svga_compile_key key;
 
+   /** Hash of 'key', used to speed up the variant list search */
+   uint32_t key_hash;
+
    /* Compiled shader tokens:
     */
    const unsigned *tokens;
@@ -227,14 +231,30 @@ struct svga_geometry_shader
 };
 
 
+/** Size of the used part of a compile key, given its num_textures */
+static inline unsigned
+svga_compile_key_size(const struct svga_compile_key *key)
+{
+   return (const char *) &key->tex[key->num_textures] - (const char *) key;
+}
+
+
 static inline boolean
 svga_compile_keys_equal(const struct svga_compile_key *a,
                         const struct svga_compile_key *b)
 {
-   unsigned key_size =
-      (const char *) &a->tex[a->num_textures] - (const char *) a;
+   return memcmp(a, b, svga_compile_key_size(a)) == 0;
+}
+
 
-   return memcmp(a, b, key_size) == 0;
+/**
+ * Hash a compile key.  The make_xx_key() functions memset the key
+ * before filling it in, so hashing the raw bytes is deterministic.
+ */
+static inline uint32_t
+svga_compile_key_hash(const struct svga_compile_key *key)
+{
+   return util_hash_crc32(key, svga_compile_key_size(key));
 }
 
 
@@ -277,6 +297,24 @@ svga_set_shader(struct svga_context *svga,
 struct svga_shader_variant *
 svga_new_shader_variant(struct svga_context *svga);
 
+void
+svga_variant_cache_init(struct svga_screen *svgascreen);
+
+void
+svga_variant_cache_destroy(struct svga_screen *svgascreen);
+
+struct svga_shader_variant *
+svga_variant_cache_lookup(struct svga_context *svga,
+                          const struct svga_shader *shader,
+                          const struct svga_compile_key *key,
+                          unsigned unit);
+
+void
+svga_variant_cache_insert(struct svga_context *svga,
+                          const struct svga_shader *shader,
+                          unsigned unit,
+                          const struct svga_shader_variant *variant);
+
 enum pipe_error
 svga_destroy_shader_variant(struct svga_context *svga,
                             SVGA3dShaderType type,
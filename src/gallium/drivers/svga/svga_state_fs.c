@@ -132,7 +132,13 @@ compile_fs(struct svga_context *svga,
    struct svga_shader_variant *variant;
    enum pipe_error ret = PIPE_ERROR;
 
-   variant = translate_fragment_program(svga, fs, key);
+   /* See if another context has already translated this (tokens, key)
+    * pair, so the TGSI translation can be skipped.
+    */
+   variant = svga_variant_cache_lookup(svga, &fs->base, key,
+                                       PIPE_SHADER_FRAGMENT);
+   if (!variant)
+      variant = translate_fragment_program(svga, fs, key);
    if (variant == NULL) {
       debug_printf("Failed to compile fragment shader,"
                    " using dummy shader instead.\n");
@@ -149,6 +155,13 @@ compile_fs(struct svga_context *svga,
       /* Use simple pass-through shader instead */
       variant = get_compiled_dummy_shader(svga, fs, key);
    }
+   else {
+      /* a usable variant; make it available to other contexts (no-op
+       * if this was itself a cache hit)
+       */
+      svga_variant_cache_insert(svga, &fs->base, PIPE_SHADER_FRAGMENT,
+                                variant);
+   }
 
    if (!variant) {
       return PIPE_ERROR;
@@ -71,7 +71,13 @@ compile_gs(struct svga_context *svga,
    struct svga_shader_variant *variant;
    enum pipe_error ret = PIPE_ERROR;
 
-   variant = translate_geometry_program(svga, gs, key);
+   /* See if another context has already translated this (tokens, key)
+    * pair, so the TGSI translation can be skipped.
+    */
+   variant = svga_variant_cache_lookup(svga, &gs->base, key,
+                                       PIPE_SHADER_GEOMETRY);
+   if (!variant)
+      variant = translate_geometry_program(svga, gs, key);
    if (!variant) {
       /* some problem during translation, try the dummy shader */
       const struct tgsi_token *dummy = get_dummy_geometry_shader();
@@ -86,6 +92,13 @@ compile_gs(struct svga_context *svga,
          return PIPE_ERROR;
       }
    }
+   else {
+      /* a usable variant; make it available to other contexts (no-op
+       * if this was itself a cache hit)
+       */
+      svga_variant_cache_insert(svga, &gs->base, PIPE_SHADER_GEOMETRY,
+                                variant);
+   }
 
    ret = svga_define_shader(svga, SVGA3D_SHADERTYPE_GS, variant);
    if (ret != PIPE_OK) {
@@ -123,7 +123,13 @@ compile_vs(struct svga_context *svga,
    struct svga_shader_variant *variant;
    enum pipe_error ret = PIPE_ERROR;
 
-   variant = translate_vertex_program(svga, vs, key);
+   /* See if another context has already translated this (tokens, key)
+    * pair, so the TGSI translation can be skipped.
+    */
+   variant = svga_variant_cache_lookup(svga, &vs->base, key,
+                                       PIPE_SHADER_VERTEX);
+   if (!variant)
+      variant = translate_vertex_program(svga, vs, key);
    if (variant == NULL) {
       debug_printf("Failed to compile vertex shader,"
                    " using dummy shader instead.\n");
@@ -140,6 +146,13 @@ compile_vs(struct svga_context *svga,
       /* Use simple pass-through shader instead */
       variant = get_compiled_dummy_vertex_shader(svga, vs, key);
    }
+   else {
+      /* a usable variant; make it available to other contexts (no-op
+       * if this was itself a cache hit)
+       */
+      svga_variant_cache_insert(svga, &vs->base, PIPE_SHADER_VERTEX,
+                                variant);
+   }
 
    if (!variant) {
       return PIPE_ERROR;
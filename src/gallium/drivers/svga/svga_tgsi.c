@@ -227,6 +227,7 @@ svga_tgsi_vgpu9_translate(struct svga_context *svga,
    variant->tokens = (const unsigned *) emit.buf;
    variant->nr_tokens = (emit.ptr - emit.buf) / sizeof(unsigned);
    memcpy(&variant->key, key, sizeof(*key));
+   variant->key_hash = svga_compile_key_hash(key);
    variant->id = UTIL_BITMASK_INVALID_INDEX;
 
    variant->pstipple_sampler_unit = emit.pstipple_sampler_unit;
@@ -6825,6 +6825,7 @@ svga_tgsi_vgpu10_translate(struct svga_context *svga,
    variant->tokens = (const unsigned *)emit->buf;
    emit->buf = NULL;  /* buffer is no longer owed by emitter context */
    memcpy(&variant->key, key, sizeof(*key));
+   variant->key_hash = svga_compile_key_hash(key);
    variant->id = UTIL_BITMASK_INVALID_INDEX;
 
    /* The extra constant starting offset starts with the number of
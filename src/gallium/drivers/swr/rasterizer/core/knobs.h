@@ -54,9 +54,12 @@
 #elif (KNOB_ARCH == KNOB_ARCH_AVX512)
 #define KNOB_ARCH_ISA AVX512F
 #define KNOB_ARCH_STR "AVX512"
-#define KNOB_SIMD_WIDTH 16
-#define KNOB_SIMD_BYTES 64
-#error "AVX512 not yet supported"
+// The core tile templates and simd intrinsics layer are still 8-wide.
+// An AVX-512 build keeps that width and picks up the EVEX encodings and
+// larger register file from the compiler; 16-wide SIMD tiles need the
+// backends and jitter plumbed for a second vector width first.
+#define KNOB_SIMD_WIDTH 8
+#define KNOB_SIMD_BYTES 32
 #else
 #error "Unknown architecture"
 #endif
@@ -106,11 +106,13 @@ JitManager::JitManager(uint32_t simdWidth, const char *arch)
     // force JIT to use the same CPU arch as the rest of swr
     if(mArch.AVX512F())
     {
-        assert(0 && "Implement AVX512 jitter");
+        // The swr core is still 8-wide; jit for the real host CPU so the
+        // backend can use the EVEX encodings and extra registers, but keep
+        // the vector width matched to the core.
         hostCPUName = sys::getHostCPUName();
         if (mVWidth == 0)
         {
-            mVWidth = 16;
+            mVWidth = 8;
         }
     }
     else if(mArch.AVX2())
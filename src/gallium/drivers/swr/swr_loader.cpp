@@ -38,7 +38,16 @@ swr_create_screen(struct sw_winsys *winsys)
    util_dl_library *pLibrary = nullptr;
 
    util_cpu_detect();
-   if (util_cpu_caps.has_avx2) {
+   if (util_cpu_caps.has_avx512f) {
+      fprintf(stderr, "AVX512\n");
+      pLibrary = util_dl_open("libswrAVX512.so");
+      if (!pLibrary) {
+         /* The AVX512 library is only built when the compiler supports
+          * the EVEX flags, so fall back to AVX2 rather than aborting. */
+         fprintf(stderr, "SWR AVX512 library not found, using AVX2\n");
+         pLibrary = util_dl_open("libswrAVX2.so");
+      }
+   } else if (util_cpu_caps.has_avx2) {
       fprintf(stderr, "AVX2\n");
       pLibrary = util_dl_open("libswrAVX2.so");
    } else if (util_cpu_caps.has_avx) {
@@ -30,10 +30,13 @@
  * @file
  * Trace dumping functions.
  *
- * For now we just use standard XML for dumping the trace calls, as this is
- * simple to write, parse, and visually inspect, but the actual representation
- * is abstracted out of this file, so that we can switch to a binary
- * representation if/when it becomes justified.
+ * By default we use standard XML for dumping the trace calls, as this is
+ * simple to write, parse, and visually inspect.  The representation is
+ * abstracted out of this file, and a compact binary representation can be
+ * selected instead with GALLIUM_TRACE_FORMAT=binary, which is roughly an
+ * order of magnitude cheaper to produce -- handy when the act of tracing
+ * itself perturbs what you are trying to measure.  Binary traces can be
+ * inspected with src/gallium/tools/trace/parse_bin.py.
  *
  * @author Jose Fonseca <jfonseca@vmware.com>
  */
@@ -47,12 +50,14 @@
 #include "os/os_thread.h"
 #include "os/os_time.h"
 #include "util/u_debug.h"
+#include "util/u_hash_table.h"
 #include "util/u_memory.h"
 #include "util/u_string.h"
 #include "util/u_math.h"
 #include "util/u_format.h"
 
 #include "tr_dump.h"
+#include "tr_profile.h"
 #include "tr_screen.h"
 #include "tr_texture.h"
 
@@ -62,6 +67,7 @@ static FILE *stream = NULL;
 pipe_static_mutex(call_mutex);
 static long unsigned call_no = 0;
 static boolean dumping = FALSE;
+static boolean binary = FALSE;
 
 
 static inline void
@@ -93,6 +99,139 @@ trace_dump_writef(const char *format, ...)
 }
 
 
+/*
+ * Binary representation.
+ *
+ * The stream begins with a 4 byte magic and a 32bit version, followed by a
+ * sequence of records.  Each record is a single opcode byte plus a fixed
+ * operand layout, all integers native endian.  Repeated identifiers (class,
+ * method, argument, struct and member names, enums) are interned: the first
+ * occurrence is written as (id | TRACE_BIN_STRING_DEF, length, chars) and
+ * later ones as just the 32bit id.
+ */
+
+#define TRACE_BIN_MAGIC "GALT"
+#define TRACE_BIN_VERSION 1
+
+#define TRACE_BIN_STRING_DEF 0x80000000
+
+enum trace_bin_op {
+   TRACE_BIN_CALL_BEGIN = 1, /**< uint32 call_no, str class, str method */
+   TRACE_BIN_CALL_END,       /**< int64 duration in microseconds */
+   TRACE_BIN_ARG_BEGIN,      /**< str name */
+   TRACE_BIN_ARG_END,
+   TRACE_BIN_RET_BEGIN,
+   TRACE_BIN_RET_END,
+   TRACE_BIN_BOOL,           /**< uint8 */
+   TRACE_BIN_INT,            /**< int64 */
+   TRACE_BIN_UINT,           /**< uint64 */
+   TRACE_BIN_FLOAT,          /**< double */
+   TRACE_BIN_BYTES,          /**< uint32 size, data */
+   TRACE_BIN_STRING,         /**< uint32 length, chars (not interned) */
+   TRACE_BIN_ENUM,           /**< str */
+   TRACE_BIN_ARRAY_BEGIN,
+   TRACE_BIN_ARRAY_END,
+   TRACE_BIN_ELEM_BEGIN,
+   TRACE_BIN_ELEM_END,
+   TRACE_BIN_STRUCT_BEGIN,   /**< str name */
+   TRACE_BIN_STRUCT_END,
+   TRACE_BIN_MEMBER_BEGIN,   /**< str name */
+   TRACE_BIN_MEMBER_END,
+   TRACE_BIN_NULL,
+   TRACE_BIN_PTR             /**< uint64 */
+};
+
+static struct util_hash_table *bin_strings = NULL;
+static uint32_t bin_num_strings = 0;
+
+
+static inline void
+trace_dump_bin_op(uint8_t op)
+{
+   trace_dump_write((const char *)&op, sizeof(op));
+}
+
+
+static inline void
+trace_dump_bin_uint8(uint8_t value)
+{
+   trace_dump_write((const char *)&value, sizeof(value));
+}
+
+
+static inline void
+trace_dump_bin_uint32(uint32_t value)
+{
+   trace_dump_write((const char *)&value, sizeof(value));
+}
+
+
+static inline void
+trace_dump_bin_uint64(uint64_t value)
+{
+   trace_dump_write((const char *)&value, sizeof(value));
+}
+
+
+static inline void
+trace_dump_bin_double(double value)
+{
+   trace_dump_write((const char *)&value, sizeof(value));
+}
+
+
+static unsigned
+trace_dump_bin_string_hash(void *key)
+{
+   const char *str = key;
+   unsigned hash = 5381;
+   while (*str)
+      hash = hash * 33 + *str++;
+   return hash;
+}
+
+
+static int
+trace_dump_bin_string_compare(void *key1, void *key2)
+{
+   return strcmp(key1, key2);
+}
+
+
+/**
+ * Write an interned string, i.e. a 32bit id, defining it on first use.
+ */
+static void
+trace_dump_bin_string_id(const char *str)
+{
+   void *value;
+
+   if (!bin_strings)
+      bin_strings = util_hash_table_create(trace_dump_bin_string_hash,
+                                           trace_dump_bin_string_compare);
+
+   value = bin_strings ? util_hash_table_get(bin_strings, (void *)str) : NULL;
+   if (value) {
+      trace_dump_bin_uint32((uint32_t)(uintptr_t)value);
+   } else {
+      size_t len = strlen(str);
+      uint32_t id = ++bin_num_strings;
+      char *key;
+
+      /* The names are almost always string literals, but don't rely on it */
+      key = MALLOC(len + 1);
+      if (key && bin_strings) {
+         memcpy(key, str, len + 1);
+         util_hash_table_set(bin_strings, key, (void *)(uintptr_t)id);
+      }
+
+      trace_dump_bin_uint32(id | TRACE_BIN_STRING_DEF);
+      trace_dump_bin_uint32(len);
+      trace_dump_write(str, len);
+   }
+}
+
+
 static inline void
 trace_dump_escape(const char *str)
 {
@@ -223,16 +362,30 @@ trace_dump_trace_flush(void)
    }
 }
 
+static enum pipe_error
+trace_dump_free_string(void *key, void *value, void *data)
+{
+   FREE(key);
+   return PIPE_OK;
+}
+
 static void
 trace_dump_trace_close(void)
 {
    if (stream) {
-      trace_dump_writes("</trace>\n");
+      if (!binary)
+         trace_dump_writes("</trace>\n");
       if (close_stream) {
          fclose(stream);
          close_stream = FALSE;
          stream = NULL;
       }
+      if (bin_strings) {
+         util_hash_table_foreach(bin_strings, trace_dump_free_string, NULL);
+         util_hash_table_destroy(bin_strings);
+         bin_strings = NULL;
+         bin_num_strings = 0;
+      }
       call_no = 0;
    }
 }
@@ -261,6 +414,9 @@ trace_dump_trace_begin(void)
       return FALSE;
 
    if (!stream) {
+      const char *format = debug_get_option("GALLIUM_TRACE_FORMAT", "xml");
+
+      binary = strcmp(format, "binary") == 0;
 
       if (strcmp(filename, "stderr") == 0) {
          close_stream = FALSE;
@@ -272,14 +428,19 @@ trace_dump_trace_begin(void)
       }
       else {
          close_stream = TRUE;
-         stream = fopen(filename, "wt");
+         stream = fopen(filename, binary ? "wb" : "wt");
          if (!stream)
             return FALSE;
       }
 
-      trace_dump_writes("<?xml version='1.0' encoding='UTF-8'?>\n");
-      trace_dump_writes("<?xml-stylesheet type='text/xsl' href='trace.xsl'?>\n");
-      trace_dump_writes("<trace version='0.1'>\n");
+      if (binary) {
+         trace_dump_write(TRACE_BIN_MAGIC, 4);
+         trace_dump_bin_uint32(TRACE_BIN_VERSION);
+      } else {
+         trace_dump_writes("<?xml version='1.0' encoding='UTF-8'?>\n");
+         trace_dump_writes("<?xml-stylesheet type='text/xsl' href='trace.xsl'?>\n");
+         trace_dump_writes("<trace version='0.1'>\n");
+      }
 
       /* Many applications don't exit cleanly, others may create and destroy a
        * screen multiple times, so we only write </trace> tag and close at exit
@@ -360,19 +521,29 @@ static int64_t call_start_time = 0;
 
 void trace_dump_call_begin_locked(const char *klass, const char *method)
 {
+   trace_profile_call_begin(method);
+
    if (!dumping)
       return;
 
    ++call_no;
-   trace_dump_indent(1);
-   trace_dump_writes("<call no=\'");
-   trace_dump_writef("%lu", call_no);
-   trace_dump_writes("\' class=\'");
-   trace_dump_escape(klass);
-   trace_dump_writes("\' method=\'");
-   trace_dump_escape(method);
-   trace_dump_writes("\'>");
-   trace_dump_newline();
+
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_CALL_BEGIN);
+      trace_dump_bin_uint32(call_no);
+      trace_dump_bin_string_id(klass);
+      trace_dump_bin_string_id(method);
+   } else {
+      trace_dump_indent(1);
+      trace_dump_writes("<call no=\'");
+      trace_dump_writef("%lu", call_no);
+      trace_dump_writes("\' class=\'");
+      trace_dump_escape(klass);
+      trace_dump_writes("\' method=\'");
+      trace_dump_escape(method);
+      trace_dump_writes("\'>");
+      trace_dump_newline();
+   }
 
    call_start_time = os_time_get();
 }
@@ -381,11 +552,22 @@ void trace_dump_call_end_locked(void)
 {
    int64_t call_end_time;
 
+   trace_profile_call_end();
+
    if (!dumping)
       return;
 
    call_end_time = os_time_get();
 
+   if (binary) {
+      /* Let stdio buffer the stream -- flushing every call is a large part
+       * of what makes the XML format slow.
+       */
+      trace_dump_bin_op(TRACE_BIN_CALL_END);
+      trace_dump_bin_uint64(call_end_time - call_start_time);
+      return;
+   }
+
    trace_dump_call_time(call_end_time - call_start_time);
    trace_dump_indent(1);
    trace_dump_tag_end("call");
@@ -410,6 +592,12 @@ void trace_dump_arg_begin(const char *name)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_ARG_BEGIN);
+      trace_dump_bin_string_id(name);
+      return;
+   }
+
    trace_dump_indent(2);
    trace_dump_tag_begin1("arg", "name", name);
 }
@@ -419,6 +607,11 @@ void trace_dump_arg_end(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_ARG_END);
+      return;
+   }
+
    trace_dump_tag_end("arg");
    trace_dump_newline();
 }
@@ -428,6 +621,11 @@ void trace_dump_ret_begin(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_RET_BEGIN);
+      return;
+   }
+
    trace_dump_indent(2);
    trace_dump_tag_begin("ret");
 }
@@ -437,6 +635,11 @@ void trace_dump_ret_end(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_RET_END);
+      return;
+   }
+
    trace_dump_tag_end("ret");
    trace_dump_newline();
 }
@@ -446,6 +649,12 @@ void trace_dump_bool(int value)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_BOOL);
+      trace_dump_bin_uint8(value ? 1 : 0);
+      return;
+   }
+
    trace_dump_writef("<bool>%c</bool>", value ? '1' : '0');
 }
 
@@ -454,6 +663,12 @@ void trace_dump_int(long long int value)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_INT);
+      trace_dump_bin_uint64(value);
+      return;
+   }
+
    trace_dump_writef("<int>%lli</int>", value);
 }
 
@@ -462,6 +677,12 @@ void trace_dump_uint(long long unsigned value)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_UINT);
+      trace_dump_bin_uint64(value);
+      return;
+   }
+
    trace_dump_writef("<uint>%llu</uint>", value);
 }
 
@@ -470,6 +691,12 @@ void trace_dump_float(double value)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_FLOAT);
+      trace_dump_bin_double(value);
+      return;
+   }
+
    trace_dump_writef("<float>%g</float>", value);
 }
 
@@ -483,6 +710,13 @@ void trace_dump_bytes(const void *data,
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_BYTES);
+      trace_dump_bin_uint32(size);
+      trace_dump_write(data, size);
+      return;
+   }
+
    trace_dump_writes("<bytes>");
    for(i = 0; i < size; ++i) {
       uint8_t byte = *p++;
@@ -527,6 +761,15 @@ void trace_dump_string(const char *str)
    if (!dumping)
       return;
 
+   if (binary) {
+      size_t len = strlen(str);
+      /* Strings carry arbitrary data (e.g. shader sources), don't intern */
+      trace_dump_bin_op(TRACE_BIN_STRING);
+      trace_dump_bin_uint32(len);
+      trace_dump_write(str, len);
+      return;
+   }
+
    trace_dump_writes("<string>");
    trace_dump_escape(str);
    trace_dump_writes("</string>");
@@ -537,6 +780,12 @@ void trace_dump_enum(const char *value)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_ENUM);
+      trace_dump_bin_string_id(value);
+      return;
+   }
+
    trace_dump_writes("<enum>");
    trace_dump_escape(value);
    trace_dump_writes("</enum>");
@@ -547,6 +796,11 @@ void trace_dump_array_begin(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_ARRAY_BEGIN);
+      return;
+   }
+
    trace_dump_writes("<array>");
 }
 
@@ -555,6 +809,11 @@ void trace_dump_array_end(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_ARRAY_END);
+      return;
+   }
+
    trace_dump_writes("</array>");
 }
 
@@ -563,6 +822,11 @@ void trace_dump_elem_begin(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_ELEM_BEGIN);
+      return;
+   }
+
    trace_dump_writes("<elem>");
 }
 
@@ -571,6 +835,11 @@ void trace_dump_elem_end(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_ELEM_END);
+      return;
+   }
+
    trace_dump_writes("</elem>");
 }
 
@@ -579,6 +848,12 @@ void trace_dump_struct_begin(const char *name)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_STRUCT_BEGIN);
+      trace_dump_bin_string_id(name);
+      return;
+   }
+
    trace_dump_writef("<struct name='%s'>", name);
 }
 
@@ -587,6 +862,11 @@ void trace_dump_struct_end(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_STRUCT_END);
+      return;
+   }
+
    trace_dump_writes("</struct>");
 }
 
@@ -595,6 +875,12 @@ void trace_dump_member_begin(const char *name)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_MEMBER_BEGIN);
+      trace_dump_bin_string_id(name);
+      return;
+   }
+
    trace_dump_writef("<member name='%s'>", name);
 }
 
@@ -603,6 +889,11 @@ void trace_dump_member_end(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_MEMBER_END);
+      return;
+   }
+
    trace_dump_writes("</member>");
 }
 
@@ -611,6 +902,11 @@ void trace_dump_null(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_NULL);
+      return;
+   }
+
    trace_dump_writes("<null/>");
 }
 
@@ -619,10 +915,18 @@ void trace_dump_ptr(const void *value)
    if (!dumping)
       return;
 
-   if(value)
-      trace_dump_writef("<ptr>0x%08lx</ptr>", (unsigned long)(uintptr_t)value);
-   else
+   if (!value) {
       trace_dump_null();
+      return;
+   }
+
+   if (binary) {
+      trace_dump_bin_op(TRACE_BIN_PTR);
+      trace_dump_bin_uint64((uintptr_t)value);
+      return;
+   }
+
+   trace_dump_writef("<ptr>0x%08lx</ptr>", (unsigned long)(uintptr_t)value);
 }
 
 
@@ -0,0 +1,225 @@
+/**************************************************************************
+ *
+ * Copyright 2008 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Per-entry-point CPU profiling for the trace driver.
+ *
+ * Set GALLIUM_TRACE_PROFILE to a file name to accumulate call counts and
+ * a log2 cycle histogram for every wrapped pipe_context/pipe_screen entry
+ * point, written out as CSV at exit.  Useful for catching draw-overhead
+ * regressions across driver updates without external probing tools.
+ *
+ * Cycles come from rdtsc where available and fall back to the monotonic
+ * nanosecond clock elsewhere, so absolute values are only comparable on
+ * the same machine.
+ */
+
+#include "pipe/p_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pipe/p_compiler.h"
+#include "os/os_time.h"
+#include "util/u_debug.h"
+
+#include "tr_profile.h"
+
+
+/* enough for every pipe_context/pipe_screen entry point */
+#define TRACE_PROFILE_MAX_ENTRIES 160
+
+/* log2 cycle buckets, the last one collects everything above 2^31 */
+#define TRACE_PROFILE_NUM_BUCKETS 32
+
+/* nested wrapped calls, e.g. a blit implemented with draw_vbo */
+#define TRACE_PROFILE_MAX_DEPTH 8
+
+struct trace_profile_entry
+{
+   const char *method;
+   uint64_t num_calls;
+   uint64_t total_cycles;
+   uint64_t buckets[TRACE_PROFILE_NUM_BUCKETS];
+};
+
+static boolean profiling = FALSE;
+static const char *profile_filename;
+static struct trace_profile_entry entries[TRACE_PROFILE_MAX_ENTRIES];
+static unsigned num_entries;
+
+struct trace_profile_frame
+{
+   struct trace_profile_entry *entry;
+   uint64_t start;
+};
+
+static struct trace_profile_frame stack[TRACE_PROFILE_MAX_DEPTH];
+static unsigned depth;
+
+
+static inline uint64_t
+trace_profile_cycles(void)
+{
+#if defined(PIPE_ARCH_X86) || defined(PIPE_ARCH_X86_64)
+   uint32_t hi, lo;
+   __asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+   return ((uint64_t)hi << 32) | lo;
+#else
+   return (uint64_t)os_time_get_nano();
+#endif
+}
+
+
+static struct trace_profile_entry *
+trace_profile_entry(const char *method)
+{
+   unsigned i;
+
+   /* The method names are string literals in tr_context.c/tr_screen.c,
+    * so comparing pointers is enough and keeps the hot path cheap.
+    */
+   for (i = 0; i < num_entries; i++) {
+      if (entries[i].method == method)
+         return &entries[i];
+   }
+
+   if (num_entries >= TRACE_PROFILE_MAX_ENTRIES)
+      return NULL;
+
+   entries[num_entries].method = method;
+   return &entries[num_entries++];
+}
+
+
+static void
+trace_profile_dump(void)
+{
+   FILE *f;
+   unsigned i, b;
+
+   if (!num_entries)
+      return;
+
+   f = fopen(profile_filename, "wt");
+   if (!f) {
+      fprintf(stderr, "trace: can't open profile file %s\n",
+              profile_filename);
+      return;
+   }
+
+   fprintf(f, "method,calls,total_cycles");
+   for (b = 0; b < TRACE_PROFILE_NUM_BUCKETS; b++)
+      fprintf(f, ",lt_2e%u", b + 1);
+   fprintf(f, "\n");
+
+   for (i = 0; i < num_entries; i++) {
+      struct trace_profile_entry *entry = &entries[i];
+
+      fprintf(f, "%s,%llu,%llu",
+              entry->method,
+              (unsigned long long)entry->num_calls,
+              (unsigned long long)entry->total_cycles);
+      for (b = 0; b < TRACE_PROFILE_NUM_BUCKETS; b++)
+         fprintf(f, ",%llu", (unsigned long long)entry->buckets[b]);
+      fprintf(f, "\n");
+   }
+
+   fclose(f);
+   fprintf(stderr, "trace: wrote entry point profile to %s\n",
+           profile_filename);
+}
+
+
+boolean
+trace_profile_begin(void)
+{
+   static boolean firstrun = TRUE;
+
+   if (!firstrun)
+      return profiling;
+   firstrun = FALSE;
+
+   profile_filename = debug_get_option("GALLIUM_TRACE_PROFILE", NULL);
+   if (!profile_filename)
+      return FALSE;
+
+   atexit(trace_profile_dump);
+   profiling = TRUE;
+   return TRUE;
+}
+
+
+void
+trace_profile_call_begin(const char *method)
+{
+   struct trace_profile_frame *frame;
+
+   if (!profiling)
+      return;
+
+   if (depth >= TRACE_PROFILE_MAX_DEPTH) {
+      /* keep push/pop balanced, the end hook skips these frames */
+      depth++;
+      return;
+   }
+
+   frame = &stack[depth++];
+   frame->entry = trace_profile_entry(method);
+   frame->start = trace_profile_cycles();
+}
+
+
+void
+trace_profile_call_end(void)
+{
+   struct trace_profile_frame *frame;
+   uint64_t cycles;
+   unsigned bucket;
+
+   if (!profiling || !depth)
+      return;
+
+   depth--;
+   if (depth >= TRACE_PROFILE_MAX_DEPTH)
+      return;
+
+   frame = &stack[depth];
+   if (!frame->entry)
+      return;
+
+   cycles = trace_profile_cycles() - frame->start;
+
+   bucket = 0;
+   while (bucket < TRACE_PROFILE_NUM_BUCKETS - 1 && (cycles >> (bucket + 1)))
+      bucket++;
+
+   frame->entry->num_calls++;
+   frame->entry->total_cycles += cycles;
+   frame->entry->buckets[bucket]++;
+}
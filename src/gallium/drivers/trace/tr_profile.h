@@ -0,0 +1,51 @@
+/**************************************************************************
+ *
+ * Copyright 2008 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Per-entry-point CPU profiling for the trace driver.
+ */
+
+#ifndef TR_PROFILE_H
+#define TR_PROFILE_H
+
+#include "pipe/p_compiler.h"
+
+/*
+ * Check GALLIUM_TRACE_PROFILE and enable profiling if set.
+ */
+boolean trace_profile_begin(void);
+
+/*
+ * Account one call to the given entry point.  Both functions must be
+ * called with the call mutex held; trace_dump_call_begin/end_locked
+ * do this for every wrapped entry point.
+ */
+void trace_profile_call_begin(const char *method);
+void trace_profile_call_end(void);
+
+#endif /* TR_PROFILE_H */
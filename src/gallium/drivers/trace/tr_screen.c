@@ -32,6 +32,7 @@
 #include "tr_dump.h"
 #include "tr_dump_defines.h"
 #include "tr_dump_state.h"
+#include "tr_profile.h"
 #include "tr_texture.h"
 #include "tr_context.h"
 #include "tr_screen.h"
@@ -476,6 +477,10 @@ trace_enabled(void)
       trace = TRUE;
    }
 
+   /* Profiling needs the wrapper too, but not the dump stream. */
+   if (trace_profile_begin())
+      trace = TRUE;
+
    return trace;
 }
 
@@ -59,14 +59,29 @@ vc4_tile_blit(struct pipe_context *pctx, const struct pipe_blit_info *info)
         int tile_width = msaa ? 32 : 64;
         int tile_height = msaa ? 32 : 64;
 
-        if (util_format_is_depth_or_stencil(info->dst.resource->format))
-                return false;
+        bool is_zs_blit =
+                util_format_is_depth_or_stencil(info->dst.resource->format);
 
         if (info->scissor_enable)
                 return false;
 
-        if ((info->mask & PIPE_MASK_RGBA) == 0)
-                return false;
+        if (is_zs_blit) {
+                /* The RCL loads and stores the Z/S tile as a unit, so the
+                 * blit has to write every component present in the format.
+                 */
+                const struct util_format_description *desc =
+                        util_format_description(info->dst.resource->format);
+
+                if (util_format_has_depth(desc) &&
+                    !(info->mask & PIPE_MASK_Z))
+                        return false;
+                if (util_format_has_stencil(desc) &&
+                    !(info->mask & PIPE_MASK_S))
+                        return false;
+        } else {
+                if ((info->mask & PIPE_MASK_RGBA) == 0)
+                        return false;
+        }
 
         if (info->dst.box.x != info->src.box.x ||
             info->dst.box.y != info->src.box.y ||
@@ -131,16 +146,29 @@ vc4_tile_blit(struct pipe_context *pctx, const struct pipe_blit_info *info)
         struct pipe_surface *src_surf =
                 vc4_get_blit_surface(pctx, info->src.resource, info->src.level);
 
-        pipe_surface_reference(&vc4->color_read, src_surf);
-        pipe_surface_reference(&vc4->color_write,
-                               dst_surf->texture->nr_samples > 1 ?
-                               NULL : dst_surf);
-        pipe_surface_reference(&vc4->msaa_color_write,
-                               dst_surf->texture->nr_samples > 1 ?
-                               dst_surf : NULL);
-        pipe_surface_reference(&vc4->zs_read, NULL);
-        pipe_surface_reference(&vc4->zs_write, NULL);
-        pipe_surface_reference(&vc4->msaa_zs_write, NULL);
+        if (is_zs_blit) {
+                pipe_surface_reference(&vc4->color_read, NULL);
+                pipe_surface_reference(&vc4->color_write, NULL);
+                pipe_surface_reference(&vc4->msaa_color_write, NULL);
+                pipe_surface_reference(&vc4->zs_read, src_surf);
+                pipe_surface_reference(&vc4->zs_write,
+                                       dst_surf->texture->nr_samples > 1 ?
+                                       NULL : dst_surf);
+                pipe_surface_reference(&vc4->msaa_zs_write,
+                                       dst_surf->texture->nr_samples > 1 ?
+                                       dst_surf : NULL);
+        } else {
+                pipe_surface_reference(&vc4->color_read, src_surf);
+                pipe_surface_reference(&vc4->color_write,
+                                       dst_surf->texture->nr_samples > 1 ?
+                                       NULL : dst_surf);
+                pipe_surface_reference(&vc4->msaa_color_write,
+                                       dst_surf->texture->nr_samples > 1 ?
+                                       dst_surf : NULL);
+                pipe_surface_reference(&vc4->zs_read, NULL);
+                pipe_surface_reference(&vc4->zs_write, NULL);
+                pipe_surface_reference(&vc4->msaa_zs_write, NULL);
+        }
 
         vc4->draw_min_x = info->dst.box.x;
         vc4->draw_min_y = info->dst.box.y;
@@ -514,10 +514,26 @@ get_instruction_priority(uint64_t inst)
         return baseline_score;
 }
 
+/**
+ * Returns true if the instruction leaves its dual-issue slot fillable by the
+ * pairing pass: one ALU pipe free and a signal that qpu_merge_inst() could
+ * still combine with another instruction.
+ */
+static bool
+qpu_inst_can_pair(uint64_t inst)
+{
+        if (QPU_GET_FIELD(inst, QPU_SIG) != QPU_SIG_NONE)
+                return false;
+
+        return (QPU_GET_FIELD(inst, QPU_OP_ADD) == QPU_A_NOP ||
+                QPU_GET_FIELD(inst, QPU_OP_MUL) == QPU_M_NOP);
+}
+
 static struct schedule_node *
 choose_instruction_to_schedule(struct choose_scoreboard *scoreboard,
                                struct list_head *schedule_list,
-                               struct schedule_node *prev_inst)
+                               struct schedule_node *prev_inst,
+                               uint32_t time)
 {
         struct schedule_node *chosen = NULL;
         int chosen_prio = 0;
@@ -570,6 +586,34 @@ choose_instruction_to_schedule(struct choose_scoreboard *scoreboard,
                         continue;
                 }
 
+                /* Prefer an instruction whose result latency has already
+                 * passed over one that would stall the clock waiting for
+                 * its operands.
+                 */
+                bool n_stalls = n->unblocked_time > time;
+                bool chosen_stalls = chosen->unblocked_time > time;
+                if (!n_stalls && chosen_stalls) {
+                        chosen = n;
+                        chosen_prio = prio;
+                } else if (n_stalls && !chosen_stalls) {
+                        continue;
+                }
+
+                /* When picking the first half of a pair, prefer an
+                 * instruction that leaves the other ALU pipe free, so the
+                 * merge below has a chance to fill the dual-issue slot.
+                 */
+                if (!prev_inst) {
+                        bool n_pairs = qpu_inst_can_pair(n->inst->inst);
+                        bool chosen_pairs = qpu_inst_can_pair(chosen->inst->inst);
+                        if (n_pairs && !chosen_pairs) {
+                                chosen = n;
+                                chosen_prio = prio;
+                        } else if (!n_pairs && chosen_pairs) {
+                                continue;
+                        }
+                }
+
                 if (n->delay > chosen->delay) {
                         chosen = n;
                         chosen_prio = prio;
@@ -759,7 +803,7 @@ schedule_instructions(struct vc4_compile *c, struct list_head *schedule_list)
                 struct schedule_node *chosen =
                         choose_instruction_to_schedule(&scoreboard,
                                                        schedule_list,
-                                                       NULL);
+                                                       NULL, time);
                 struct schedule_node *merge = NULL;
 
                 /* If there are no valid instructions to schedule, drop a NOP
@@ -794,7 +838,7 @@ schedule_instructions(struct vc4_compile *c, struct list_head *schedule_list)
 
                         merge = choose_instruction_to_schedule(&scoreboard,
                                                                schedule_list,
-                                                               chosen);
+                                                               chosen, time);
                         if (merge) {
                                 time = MAX2(merge->unblocked_time, time);
                                 list_del(&merge->link);
@@ -35,6 +35,9 @@
 #include "util/u_slab.h"
 #include "util/u_upload_mgr.h"
 #include "util/u_blitter.h"
+#include "util/u_hash.h"
+#include "util/u_hash_table.h"
+#include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_text.h"
 #include "indices/u_primconvert.h"
 
@@ -472,12 +475,49 @@ void virgl_transfer_inline_write(struct pipe_context *ctx,
                               box, data, stride, layer_stride);
 }
 
+/* Creating a host shader object means pushing the whole TGSI text over
+ * the virtio ring, so identical shaders created again (app recompiles,
+ * shader variants that transform to the same text, ...) share the host
+ * object instead of re-transmitting it.  The cache key is the transformed
+ * token stream plus the stream output info, both of which end up encoded.
+ */
+struct virgl_shader_cso {
+   uint32_t handle;
+   uint32_t type;
+   unsigned refcount;
+   unsigned num_tokens;
+   struct tgsi_token *tokens;
+   struct pipe_stream_output_info so_info;
+};
+
+static unsigned virgl_shader_cso_hash(void *key)
+{
+   struct virgl_shader_cso *cso = key;
+
+   return util_hash_crc32(cso->tokens,
+                          cso->num_tokens * sizeof(struct tgsi_token)) ^
+          util_hash_crc32(&cso->so_info, sizeof(cso->so_info)) ^
+          cso->type;
+}
+
+static int virgl_shader_cso_compare(void *key1, void *key2)
+{
+   struct virgl_shader_cso *a = key1, *b = key2;
+
+   if (a->type != b->type || a->num_tokens != b->num_tokens)
+      return 1;
+   if (memcmp(a->tokens, b->tokens,
+              a->num_tokens * sizeof(struct tgsi_token)))
+      return 1;
+   return memcmp(&a->so_info, &b->so_info, sizeof(a->so_info));
+}
+
 static void *virgl_shader_encoder(struct pipe_context *ctx,
                                   const struct pipe_shader_state *shader,
                                   unsigned type)
 {
    struct virgl_context *vctx = virgl_context(ctx);
-   uint32_t handle;
+   struct virgl_shader_cso key, *cso;
    struct tgsi_token *new_tokens;
    int ret;
 
@@ -485,18 +525,56 @@ static void *virgl_shader_encoder(struct pipe_context *ctx,
    if (!new_tokens)
       return NULL;
 
-   handle = virgl_object_assign_handle();
-   /* encode VS state */
-   ret = virgl_encode_shader_state(vctx, handle, type,
+   key.type = type;
+   key.num_tokens = tgsi_num_tokens(new_tokens);
+   key.tokens = new_tokens;
+   key.so_info = shader->stream_output;
+   cso = util_hash_table_get(vctx->shader_cache, &key);
+   if (cso) {
+      /* the host already has this shader, just take another reference
+       * on its handle */
+      cso->refcount++;
+      FREE(new_tokens);
+      return cso;
+   }
+
+   cso = CALLOC_STRUCT(virgl_shader_cso);
+   if (!cso) {
+      FREE(new_tokens);
+      return NULL;
+   }
+
+   cso->handle = virgl_object_assign_handle();
+   ret = virgl_encode_shader_state(vctx, cso->handle, type,
                                    &shader->stream_output,
                                    new_tokens);
    if (ret) {
+      FREE(cso);
+      FREE(new_tokens);
       return NULL;
    }
 
-   FREE(new_tokens);
-   return (void *)(unsigned long)handle;
+   cso->type = type;
+   cso->refcount = 1;
+   cso->num_tokens = key.num_tokens;
+   cso->tokens = new_tokens;
+   cso->so_info = shader->stream_output;
+   util_hash_table_set(vctx->shader_cache, cso, cso);
+
+   return cso;
+}
+
+static void virgl_delete_shader_state(struct virgl_context *vctx, void *ss)
+{
+   struct virgl_shader_cso *cso = ss;
+
+   if (--cso->refcount)
+      return;
 
+   util_hash_table_remove(vctx->shader_cache, cso);
+   virgl_encode_delete_object(vctx, cso->handle, VIRGL_OBJECT_SHADER);
+   FREE(cso->tokens);
+   FREE(cso);
 }
 static void *virgl_create_vs_state(struct pipe_context *ctx,
                                    const struct pipe_shader_state *shader)
@@ -520,58 +598,57 @@ static void
 virgl_delete_fs_state(struct pipe_context *ctx,
                      void *fs)
 {
-   uint32_t handle = (unsigned long)fs;
    struct virgl_context *vctx = virgl_context(ctx);
 
-   virgl_encode_delete_object(vctx, handle, VIRGL_OBJECT_SHADER);
+   virgl_delete_shader_state(vctx, fs);
 }
 
 static void
 virgl_delete_gs_state(struct pipe_context *ctx,
                      void *gs)
 {
-   uint32_t handle = (unsigned long)gs;
    struct virgl_context *vctx = virgl_context(ctx);
 
-   virgl_encode_delete_object(vctx, handle, VIRGL_OBJECT_SHADER);
+   virgl_delete_shader_state(vctx, gs);
 }
 
 static void
 virgl_delete_vs_state(struct pipe_context *ctx,
                      void *vs)
 {
-   uint32_t handle = (unsigned long)vs;
    struct virgl_context *vctx = virgl_context(ctx);
 
-   virgl_encode_delete_object(vctx, handle, VIRGL_OBJECT_SHADER);
+   virgl_delete_shader_state(vctx, vs);
+}
+
+static uint32_t virgl_shader_handle(void *vss)
+{
+   return vss ? ((struct virgl_shader_cso *)vss)->handle : 0;
 }
 
 static void virgl_bind_vs_state(struct pipe_context *ctx,
                                         void *vss)
 {
-   uint32_t handle = (unsigned long)vss;
    struct virgl_context *vctx = virgl_context(ctx);
 
-   virgl_encode_bind_shader(vctx, handle, PIPE_SHADER_VERTEX);
+   virgl_encode_bind_shader(vctx, virgl_shader_handle(vss), PIPE_SHADER_VERTEX);
 }
 
 static void virgl_bind_gs_state(struct pipe_context *ctx,
                                void *vss)
 {
-   uint32_t handle = (unsigned long)vss;
    struct virgl_context *vctx = virgl_context(ctx);
 
-   virgl_encode_bind_shader(vctx, handle, PIPE_SHADER_GEOMETRY);
+   virgl_encode_bind_shader(vctx, virgl_shader_handle(vss), PIPE_SHADER_GEOMETRY);
 }
 
 
 static void virgl_bind_fs_state(struct pipe_context *ctx,
                                         void *vss)
 {
-   uint32_t handle = (unsigned long)vss;
    struct virgl_context *vctx = virgl_context(ctx);
 
-   virgl_encode_bind_shader(vctx, handle, PIPE_SHADER_FRAGMENT);
+   virgl_encode_bind_shader(vctx, virgl_shader_handle(vss), PIPE_SHADER_FRAGMENT);
 }
 
 static void virgl_clear(struct pipe_context *ctx,
@@ -627,6 +704,10 @@ static void virgl_flush_eq(struct virgl_context *ctx, void *closure)
 {
    struct virgl_screen *rs = virgl_screen(ctx->base.screen);
 
+   /* the cmdbuf is going away, so there is no previous inline write
+    * left to extend */
+   pipe_resource_reference(&ctx->last_inline_write.res, NULL);
+
    /* send the buffer to the remote side for decoding */
    ctx->num_transfers = ctx->num_draws = 0;
    rs->vws->submit_cmd(rs->vws, ctx->cbuf);
@@ -656,6 +737,12 @@ static void virgl_flush_from_st(struct pipe_context *ctx,
       pipe_resource_reference(&res, NULL);
 
    }
+
+   /* the fence rides along with the submission, so the wait covers
+    * everything encoded up to this point */
+   if (fence && *fence)
+      rs->vws->emit_fence(rs->vws, vctx->cbuf, *fence);
+
    virgl_flush_eq(vctx, vctx);
 }
 
@@ -861,6 +948,7 @@ virgl_context_destroy( struct pipe_context *ctx )
       u_upload_destroy(vctx->uploader);
    util_primconvert_destroy(vctx->primconvert);
 
+   util_hash_table_destroy(vctx->shader_cache);
    util_slab_destroy(&vctx->texture_transfer_pool);
    FREE(vctx);
 }
@@ -946,6 +1034,11 @@ struct pipe_context *virgl_context_create(struct pipe_screen *pscreen,
    util_slab_create(&vctx->texture_transfer_pool, sizeof(struct virgl_transfer),
                     16, UTIL_SLAB_SINGLETHREADED);
 
+   vctx->shader_cache = util_hash_table_create(virgl_shader_cso_hash,
+                                               virgl_shader_cso_compare);
+   if (!vctx->shader_cache)
+      goto fail;
+
    vctx->primconvert = util_primconvert_create(&vctx->base, rs->caps.caps.v1.prim_mask);
    vctx->uploader = u_upload_create(&vctx->base, 1024 * 1024,
                                      PIPE_BIND_INDEX_BUFFER, PIPE_USAGE_STREAM);
@@ -31,6 +31,7 @@
 struct pipe_screen;
 struct tgsi_token;
 struct u_upload_mgr;
+struct util_hash_table;
 struct virgl_cmd_buf;
 
 struct virgl_sampler_view {
@@ -73,6 +74,19 @@ struct virgl_context {
    int num_draws;
    struct list_head to_flush_bufs;
 
+   /* dedup cache of host shader objects, keyed by shader content */
+   struct util_hash_table *shader_cache;
+
+   /* tail RESOURCE_INLINE_WRITE of the cbuf, so a sub-data upload to the
+    * adjacent buffer range can be packed into the same command */
+   struct {
+      struct pipe_resource *res;
+      uint32_t cdw;
+      unsigned level;
+      unsigned usage;
+      struct pipe_box box;
+   } last_inline_write;
+
    struct primconvert_context *primconvert;
    uint32_t hw_sub_ctx_id;
 };
@@ -22,6 +22,7 @@
  */
 #include <stdint.h>
 
+#include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
 #include "pipe/p_state.h"
@@ -482,6 +483,46 @@ static void virgl_encoder_iw_emit_header_1d(struct virgl_context *ctx,
    virgl_encoder_write_dword(ctx->cbuf, box->depth);
 }
 
+/* Append to the previous RESOURCE_INLINE_WRITE instead of emitting a new
+ * command when the state trackers feed us consecutive sub-data uploads to
+ * adjacent ranges of the same buffer, so one command header and resource
+ * reference cover the whole run.  The previous command can only be patched
+ * while it is still the tail of the cbuf and its payload ended on a dword
+ * boundary (the data blocks are dword-padded in the stream).
+ */
+static boolean virgl_encoder_extend_inline_write(struct virgl_context *ctx,
+                                                struct virgl_resource *res,
+                                                unsigned level, unsigned usage,
+                                                const struct pipe_box *box,
+                                                const void *data, uint32_t size)
+{
+   uint32_t *hdr;
+
+   if (ctx->last_inline_write.res != &res->u.b)
+      return FALSE;
+   if (level != ctx->last_inline_write.level ||
+       usage != ctx->last_inline_write.usage ||
+       box->y != ctx->last_inline_write.box.y ||
+       box->z != ctx->last_inline_write.box.z ||
+       box->x != ctx->last_inline_write.box.x + ctx->last_inline_write.box.width)
+      return FALSE;
+   if (ctx->last_inline_write.box.width & 3)
+      return FALSE;
+   if (ctx->cbuf->cdw != ctx->last_inline_write.cdw + 12 +
+       ctx->last_inline_write.box.width / 4)
+      return FALSE;
+   if (ctx->cbuf->cdw + (size + 3) / 4 + 1 > VIRGL_MAX_CMDBUF_DWORDS)
+      return FALSE;
+
+   ctx->last_inline_write.box.width += size;
+   hdr = ctx->cbuf->buf + ctx->last_inline_write.cdw;
+   hdr[0] = VIRGL_CMD0(VIRGL_CCMD_RESOURCE_INLINE_WRITE, 0,
+                       ((ctx->last_inline_write.box.width + 3) / 4) + 11);
+   hdr[VIRGL_RESOURCE_IW_W] = ctx->last_inline_write.box.width;
+   virgl_encoder_write_block(ctx->cbuf, data, size);
+   return TRUE;
+}
+
 int virgl_encoder_inline_write(struct virgl_context *ctx,
                               struct virgl_resource *res,
                               unsigned level, unsigned usage,
@@ -492,6 +533,14 @@ int virgl_encoder_inline_write(struct virgl_context *ctx,
    uint32_t size = (stride ? stride : box->width) * box->height;
    uint32_t length, thispass, left_bytes;
    struct pipe_box mybox = *box;
+   boolean mergeable = !stride && !layer_stride && size &&
+      box->height == 1 && box->depth == 1;
+   uint32_t start_cdw = 0;
+
+   if (mergeable &&
+       virgl_encoder_extend_inline_write(ctx, res, level, usage, box,
+                                         data, size))
+      return 0;
 
    length = 11 + (size + 3) / 4;
    if ((ctx->cbuf->cdw + length + 1) > VIRGL_MAX_CMDBUF_DWORDS) {
@@ -511,6 +560,7 @@ int virgl_encoder_inline_write(struct virgl_context *ctx,
       length = MIN2(thispass, left_bytes);
 
       mybox.width = length;
+      start_cdw = ctx->cbuf->cdw;
       virgl_encoder_write_cmd_dword(ctx, VIRGL_CMD0(VIRGL_CCMD_RESOURCE_INLINE_WRITE, 0, ((length + 3) / 4) + 11));
       virgl_encoder_iw_emit_header_1d(ctx, res, level, usage, &mybox, stride, layer_stride);
       virgl_encoder_write_block(ctx->cbuf, data, length);
@@ -518,6 +568,17 @@ int virgl_encoder_inline_write(struct virgl_context *ctx,
       mybox.x += length;
       data += length;
    }
+
+   /* remember the last emitted write so the next upload to the adjacent
+    * range can be packed into it */
+   if (mergeable) {
+      pipe_resource_reference(&ctx->last_inline_write.res, &res->u.b);
+      ctx->last_inline_write.cdw = start_cdw;
+      ctx->last_inline_write.level = level;
+      ctx->last_inline_write.usage = usage;
+      ctx->last_inline_write.box = mybox;
+      ctx->last_inline_write.box.x = mybox.x - mybox.width;
+   }
    return 0;
 }
 
@@ -190,8 +190,11 @@ static void *virgl_texture_transfer_map(struct pipe_context *ctx,
    if (readback)
       vs->vws->transfer_get(vs->vws, hw_res, box, trans->base.stride, l_stride, offset, level);
 
+   /* wait on the resource we are actually going to map - for a resolved
+    * readback that is the small staging texture, which only has the blit
+    * pending against it, not everything else queued on the source */
    if (doflushwait || readback)
-      vs->vws->resource_wait(vs->vws, vtex->base.hw_res);
+      vs->vws->resource_wait(vs->vws, hw_res);
 
    ptr = vs->vws->resource_map(vs->vws, hw_res);
    if (!ptr) {
@@ -85,6 +85,11 @@ struct virgl_winsys {
    void (*emit_res)(struct virgl_winsys *vws, struct virgl_cmd_buf *buf, struct virgl_hw_res *res, boolean write_buffer);
    int (*submit_cmd)(struct virgl_winsys *vws, struct virgl_cmd_buf *buf);
 
+   /* attach a fence to the cmd buf, so submitting the buffer arms the
+    * fence as part of the submission instead of a separate round-trip */
+   void (*emit_fence)(struct virgl_winsys *vws, struct virgl_cmd_buf *buf,
+                      struct pipe_fence_handle *fence);
+
    boolean (*res_is_referenced)(struct virgl_winsys *vws,
                                 struct virgl_cmd_buf *buf,
                                 struct virgl_hw_res *res);
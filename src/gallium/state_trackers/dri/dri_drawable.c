@@ -33,8 +33,12 @@
 #include "dri_context.h"
 #include "dri_drawable.h"
 
+#include "main/glthread.h"
+#include "state_tracker/st_context.h"
+
 #include "pipe/p_screen.h"
 #include "util/u_format.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_inlines.h"
 
@@ -451,6 +455,12 @@ dri_flush(__DRIcontext *cPriv,
       return;
    }
 
+   /* The loader calls this directly on the application thread, bypassing
+    * the marshal dispatch table, so drain any glthread batches still
+    * queued for the server thread before touching the pipe context.
+    */
+   _mesa_glthread_finish(((struct st_context *)ctx->st)->ctx);
+
    if (drawable) {
       /* prevent recursion */
       if (drawable->flushing)
@@ -581,4 +591,56 @@ const __DRI2throttleExtension dri2ThrottleExtension = {
 };
 
 
+/**
+ * Buffer-damage extension, the set_damage_region function.
+ *
+ * Records the bounding box of the application-provided rectangles so the
+ * next swap only has to present the dirty part of the drawable.
+ */
+static void
+dri_set_damage_region(__DRIdrawable *dPriv, unsigned int nrects, int *rects)
+{
+   struct dri_drawable *drawable = dri_drawable(dPriv);
+   int x0, y0, x1, y1;
+   unsigned int i;
+
+   if (!nrects) {
+      drawable->have_damage = FALSE;
+      return;
+   }
+
+   x0 = rects[0];
+   y0 = rects[1];
+   x1 = rects[0] + rects[2];
+   y1 = rects[1] + rects[3];
+
+   for (i = 1; i < nrects; i++) {
+      const int *rect = &rects[i * 4];
+
+      x0 = MIN2(x0, rect[0]);
+      y0 = MIN2(y0, rect[1]);
+      x1 = MAX2(x1, rect[0] + rect[2]);
+      y1 = MAX2(y1, rect[1] + rect[3]);
+   }
+
+   x0 = CLAMP(x0, 0, dPriv->w);
+   y0 = CLAMP(y0, 0, dPriv->h);
+   x1 = CLAMP(x1, x0, dPriv->w);
+   y1 = CLAMP(y1, y0, dPriv->h);
+
+   drawable->damage_x = x0;
+   drawable->damage_y = y0;
+   drawable->damage_w = x1 - x0;
+   drawable->damage_h = y1 - y0;
+   drawable->have_damage = drawable->damage_w > 0 && drawable->damage_h > 0;
+}
+
+
+const __DRI2bufferDamageExtension dri2BufferDamageExtension = {
+    .base = { __DRI2_BUFFER_DAMAGE, 1 },
+
+    .set_damage_region = dri_set_damage_region,
+};
+
+
 /* vim: set sw=3 ts=8 sts=3 expandtab: */
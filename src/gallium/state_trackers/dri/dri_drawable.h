@@ -30,7 +30,9 @@
 
 #include "pipe/p_compiler.h"
 #include "pipe/p_format.h"
+#include "pipe/p_state.h"
 #include "state_tracker/st_api.h"
+#include "util/u_queue.h"
 
 struct pipe_surface;
 struct st_framebuffer;
@@ -67,9 +69,24 @@ struct dri_drawable
    unsigned int desired_fences;
    boolean flushing; /* prevents recursion in dri_flush */
 
+   /* union of the rectangles passed in through __DRI2_BUFFER_DAMAGE since
+    * the last swap, with a bottom-left origin.  When have_damage is unset
+    * the whole drawable is considered dirty.
+    */
+   int damage_x, damage_y, damage_w, damage_h;
+   boolean have_damage;
+
    /* used only by DRISW */
    struct pipe_surface *drisw_surface;
 
+   /* optional asynchronous present thread, used only by DRISW */
+   struct util_queue present_queue;
+   struct util_queue_fence present_fence;
+   struct pipe_resource *present_texture;
+   struct pipe_box present_box;
+   boolean present_sub_box;
+   boolean present_queue_active;
+
    /* hooks filled in by dri2 & drisw */
    void (*allocate_textures)(struct dri_context *ctx,
                              struct dri_drawable *drawable,
@@ -123,6 +140,7 @@ dri_flush(__DRIcontext *cPriv,
 
 extern const __DRItexBufferExtension driTexBufferExtension;
 extern const __DRI2throttleExtension dri2ThrottleExtension;
+extern const __DRI2bufferDamageExtension dri2BufferDamageExtension;
 #endif
 
 /* vim: set sw=3 ts=8 sts=3 expandtab: */
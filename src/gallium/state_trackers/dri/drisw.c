@@ -51,6 +51,14 @@
 DEBUG_GET_ONCE_BOOL_OPTION(swrast_no_present, "SWRAST_NO_PRESENT", FALSE);
 static boolean swrast_no_present = FALSE;
 
+/* Copy the frame to the X server from a separate thread, so the app doesn't
+ * wait for the image transfer. The loader's putImage goes through Xlib, so
+ * this requires the app to have called XInitThreads().
+ */
+DEBUG_GET_ONCE_BOOL_OPTION(swrast_async_present, "SWRAST_ASYNC_PRESENT",
+                           FALSE);
+static boolean swrast_async_present = FALSE;
+
 static inline void
 get_drawable_info(__DRIdrawable *dPriv, int *x, int *y, int *w, int *h)
 {
@@ -183,6 +191,46 @@ drisw_copy_to_front(__DRIdrawable * dPriv,
    drisw_invalidate_drawable(dPriv);
 }
 
+/* Wait for a pending asynchronous present to hit the server, so that the
+ * staging texture can be reused and putImage calls don't overlap.
+ */
+static inline void
+drisw_wait_present(struct dri_drawable *drawable)
+{
+   if (drawable->present_queue_active)
+      util_queue_fence_wait(&drawable->present_fence);
+}
+
+/* Fetch and clear the damage pending on the drawable, flipped to the
+ * top-left origin the winsys expects.  Returns FALSE when the whole
+ * drawable has to be presented.
+ */
+static boolean
+drisw_get_damage_box(struct dri_drawable *drawable, struct pipe_box *box)
+{
+   __DRIdrawable *dPriv = drawable->dPriv;
+
+   if (!drawable->have_damage)
+      return FALSE;
+
+   u_box_2d(drawable->damage_x,
+            dPriv->h - drawable->damage_y - drawable->damage_h,
+            drawable->damage_w, drawable->damage_h, box);
+   drawable->have_damage = FALSE;
+
+   return TRUE;
+}
+
+static void
+drisw_present_job(void *job, int thread_index)
+{
+   struct dri_drawable *drawable = (struct dri_drawable *) job;
+
+   drisw_present_texture(drawable->dPriv, drawable->present_texture,
+                         drawable->present_sub_box ?
+                            &drawable->present_box : NULL);
+}
+
 /*
  * Backend functions for st_framebuffer interface and swap_buffers.
  */
@@ -193,6 +241,7 @@ drisw_swap_buffers(__DRIdrawable *dPriv)
    struct dri_context *ctx = dri_get_current(dPriv->driScreenPriv);
    struct dri_drawable *drawable = dri_drawable(dPriv);
    struct pipe_resource *ptex;
+   struct pipe_box box;
 
    if (!ctx)
       return;
@@ -203,9 +252,52 @@ drisw_swap_buffers(__DRIdrawable *dPriv)
       if (ctx->pp)
          pp_run(ctx->pp, ptex, ptex, drawable->textures[ST_ATTACHMENT_DEPTH_STENCIL]);
 
+      if (drawable->present_queue_active) {
+         struct pipe_context *pipe = ctx->st->pipe;
+
+         /* The previous frame must be on the wire before its staging
+          * texture can be overwritten.
+          */
+         drisw_wait_present(drawable);
+
+         if (!drawable->present_texture ||
+             drawable->present_texture->width0 != ptex->width0 ||
+             drawable->present_texture->height0 != ptex->height0) {
+            struct pipe_resource templ = *ptex;
+
+            pipe_resource_reference(&drawable->present_texture, NULL);
+            drawable->present_texture =
+               pipe->screen->resource_create(pipe->screen, &templ);
+         }
+
+         if (drawable->present_texture) {
+            /* Snapshot the back buffer, then hand the copy to the present
+             * thread so the app can start on the next frame right away.
+             */
+            dri_pipe_blit(pipe, drawable->present_texture, ptex);
+
+            ctx->st->flush(ctx->st, ST_FLUSH_FRONT, NULL);
+
+            drawable->present_sub_box =
+               drisw_get_damage_box(drawable, &drawable->present_box);
+            util_queue_add_job(&drawable->present_queue, drawable,
+                               &drawable->present_fence,
+                               drisw_present_job, NULL);
+            drisw_invalidate_drawable(dPriv);
+            return;
+         }
+         /* Fall through to the synchronous path on allocation failure. */
+      }
+
       ctx->st->flush(ctx->st, ST_FLUSH_FRONT, NULL);
 
-      drisw_copy_to_front(dPriv, ptex);
+      if (drisw_get_damage_box(drawable, &box)) {
+         drisw_wait_present(drawable);
+         drisw_present_texture(dPriv, ptex, &box);
+         drisw_invalidate_drawable(dPriv);
+      } else {
+         drisw_copy_to_front(dPriv, ptex);
+      }
    }
 }
 
@@ -228,6 +320,8 @@ drisw_copy_sub_buffer(__DRIdrawable *dPriv, int x, int y,
 
       ctx->st->flush(ctx->st, ST_FLUSH_FRONT, NULL);
 
+      drisw_wait_present(drawable);
+
       u_box_2d(x, dPriv->h - y - h, w, h, &box);
       drisw_present_texture(dPriv, ptex, &box);
    }
@@ -246,6 +340,7 @@ drisw_flush_frontbuffer(struct dri_context *ctx,
    ptex = drawable->textures[statt];
 
    if (ptex) {
+      drisw_wait_present(drawable);
       drisw_copy_to_front(ctx->dPriv, ptex);
    }
 }
@@ -369,6 +464,7 @@ static const __DRIextension *drisw_screen_extensions[] = {
    &driTexBufferExtension.base,
    &dri2RendererQueryExtension.base,
    &dri2ConfigQueryExtension.base,
+   &dri2BufferDamageExtension.base,
    NULL
 };
 
@@ -393,6 +489,7 @@ drisw_init_screen(__DRIscreen * sPriv)
    screen->fd = -1;
 
    swrast_no_present = debug_get_option_swrast_no_present();
+   swrast_async_present = debug_get_option_swrast_async_present();
 
    sPriv->driverPrivate = (void *)screen;
    sPriv->extensions = drisw_screen_extensions;
@@ -433,9 +530,31 @@ drisw_create_buffer(__DRIscreen * sPriv,
    drawable->flush_frontbuffer = drisw_flush_frontbuffer;
    drawable->update_tex_buffer = drisw_update_tex_buffer;
 
+   if (swrast_async_present && !isPixmap && !swrast_no_present) {
+      util_queue_fence_init(&drawable->present_fence);
+      if (util_queue_init(&drawable->present_queue, "present", 1, 1, 0))
+         drawable->present_queue_active = TRUE;
+   }
+
    return TRUE;
 }
 
+static void
+drisw_destroy_buffer(__DRIdrawable * dPriv)
+{
+   struct dri_drawable *drawable = dri_drawable(dPriv);
+
+   if (drawable->present_queue_active) {
+      drisw_wait_present(drawable);
+      util_queue_destroy(&drawable->present_queue);
+      util_queue_fence_destroy(&drawable->present_fence);
+      drawable->present_queue_active = FALSE;
+   }
+   pipe_resource_reference(&drawable->present_texture, NULL);
+
+   dri_destroy_buffer(dPriv);
+}
+
 /**
  * DRI driver virtual function table.
  *
@@ -447,7 +566,7 @@ const struct __DriverAPIRec galliumsw_driver_api = {
    .CreateContext = dri_create_context,
    .DestroyContext = dri_destroy_context,
    .CreateBuffer = drisw_create_buffer,
-   .DestroyBuffer = dri_destroy_buffer,
+   .DestroyBuffer = drisw_destroy_buffer,
    .SwapBuffers = drisw_swap_buffers,
    .MakeCurrent = dri_make_current,
    .UnbindContext = dri_unbind_context,
@@ -0,0 +1,394 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/* Measures the CPU cost of draw calls against any pipe driver, with and
+ * without state changes between the draws, and prints per-path nanosecond
+ * costs.  Useful for quantifying regressions in the driver's state atom
+ * walks between releases.
+ */
+
+#define WIDTH 300
+#define HEIGHT 300
+
+#define NUM_WARMUP 1000
+#define NUM_DRAWS  100000
+
+/* pipe_*_state structs */
+#include "pipe/p_state.h"
+/* pipe_context */
+#include "pipe/p_context.h"
+/* pipe_screen */
+#include "pipe/p_screen.h"
+/* PIPE_* */
+#include "pipe/p_defines.h"
+/* TGSI_SEMANTIC_{POSITION|GENERIC} */
+#include "pipe/p_shader_tokens.h"
+/* pipe_buffer_* helpers */
+#include "util/u_inlines.h"
+
+/* constant state object helper */
+#include "cso_cache/cso_context.h"
+
+/* os_time_get */
+#include "os/os_time.h"
+/* FREE & CALLOC_STRUCT */
+#include "util/u_memory.h"
+/* u_sampler_view_default_template */
+#include "util/u_sampler.h"
+/* util_make_[fragment|vertex]_passthrough_shader */
+#include "util/u_simple_shaders.h"
+/* to get a hardware pipe driver */
+#include "pipe-loader/pipe_loader.h"
+
+#include <stdio.h>
+
+struct program
+{
+	struct pipe_loader_device *dev;
+	struct pipe_screen *screen;
+	struct pipe_context *pipe;
+	struct cso_context *cso;
+
+	struct pipe_blend_state blend[2];
+	struct pipe_depth_stencil_alpha_state depthstencil;
+	struct pipe_rasterizer_state rasterizer;
+	struct pipe_sampler_state sampler;
+	struct pipe_viewport_state viewport;
+	struct pipe_framebuffer_state framebuffer;
+	struct pipe_vertex_element velem[2][2];
+
+	void *vs;
+	void *fs;
+	void *fs_tex;
+
+	union pipe_color_union clear_color;
+
+	struct pipe_resource *vbuf;
+	struct pipe_resource *target;
+	struct pipe_resource *tex[2];
+	struct pipe_sampler_view *view[2];
+};
+
+static void init_prog(struct program *p)
+{
+	struct pipe_surface surf_tmpl;
+	int i, ret;
+
+	/* find a hardware device */
+	ret = pipe_loader_probe(&p->dev, 1);
+	assert(ret);
+
+	/* init a pipe screen */
+	p->screen = pipe_loader_create_screen(p->dev);
+	assert(p->screen);
+
+	/* create the pipe driver context and cso context */
+	p->pipe = p->screen->context_create(p->screen, NULL, 0);
+	p->cso = cso_create_context(p->pipe);
+
+	/* set clear color */
+	p->clear_color.f[0] = 0.3;
+	p->clear_color.f[1] = 0.1;
+	p->clear_color.f[2] = 0.3;
+	p->clear_color.f[3] = 1.0;
+
+	/* vertex buffer */
+	{
+		float vertices[3][2][4] = {
+			{
+				{ 0.0f, -0.9f, 0.0f, 1.0f },
+				{ 1.0f, 0.0f, 0.0f, 1.0f }
+			},
+			{
+				{ -0.9f, 0.9f, 0.0f, 1.0f },
+				{ 0.0f, 1.0f, 0.0f, 1.0f }
+			},
+			{
+				{ 0.9f, 0.9f, 0.0f, 1.0f },
+				{ 0.0f, 0.0f, 1.0f, 1.0f }
+			}
+		};
+
+		p->vbuf = pipe_buffer_create(p->screen, PIPE_BIND_VERTEX_BUFFER,
+					     PIPE_USAGE_DEFAULT, sizeof(vertices));
+		pipe_buffer_write(p->pipe, p->vbuf, 0, sizeof(vertices), vertices);
+	}
+
+	/* render target texture */
+	{
+		struct pipe_resource tmplt;
+		memset(&tmplt, 0, sizeof(tmplt));
+		tmplt.target = PIPE_TEXTURE_2D;
+		tmplt.format = PIPE_FORMAT_B8G8R8A8_UNORM; /* All drivers support this */
+		tmplt.width0 = WIDTH;
+		tmplt.height0 = HEIGHT;
+		tmplt.depth0 = 1;
+		tmplt.array_size = 1;
+		tmplt.last_level = 0;
+		tmplt.bind = PIPE_BIND_RENDER_TARGET;
+
+		p->target = p->screen->resource_create(p->screen, &tmplt);
+	}
+
+	/* sampler textures */
+	for (i = 0; i < 2; i++) {
+		struct pipe_resource t_tmplt;
+		struct pipe_sampler_view v_tmplt;
+
+		memset(&t_tmplt, 0, sizeof(t_tmplt));
+		t_tmplt.target = PIPE_TEXTURE_2D;
+		t_tmplt.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+		t_tmplt.width0 = 2;
+		t_tmplt.height0 = 2;
+		t_tmplt.depth0 = 1;
+		t_tmplt.array_size = 1;
+		t_tmplt.last_level = 0;
+		t_tmplt.bind = PIPE_BIND_SAMPLER_VIEW;
+
+		p->tex[i] = p->screen->resource_create(p->screen, &t_tmplt);
+
+		u_sampler_view_default_template(&v_tmplt, p->tex[i],
+						p->tex[i]->format);
+
+		p->view[i] = p->pipe->create_sampler_view(p->pipe, p->tex[i],
+							  &v_tmplt);
+	}
+
+	/* disabled blending/masking, with a second variant to switch to */
+	memset(p->blend, 0, sizeof(p->blend));
+	p->blend[0].rt[0].colormask = PIPE_MASK_RGBA;
+	p->blend[1].rt[0].colormask = PIPE_MASK_R | PIPE_MASK_G | PIPE_MASK_B;
+
+	/* no-op depth/stencil/alpha */
+	memset(&p->depthstencil, 0, sizeof(p->depthstencil));
+
+	/* rasterizer */
+	memset(&p->rasterizer, 0, sizeof(p->rasterizer));
+	p->rasterizer.cull_face = PIPE_FACE_NONE;
+	p->rasterizer.half_pixel_center = 1;
+	p->rasterizer.bottom_edge_rule = 1;
+	p->rasterizer.depth_clip = 1;
+
+	/* sampler */
+	memset(&p->sampler, 0, sizeof(p->sampler));
+	p->sampler.wrap_s = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+	p->sampler.wrap_t = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+	p->sampler.wrap_r = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+	p->sampler.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+	p->sampler.min_img_filter = PIPE_TEX_MIPFILTER_NEAREST;
+	p->sampler.mag_img_filter = PIPE_TEX_MIPFILTER_NEAREST;
+	p->sampler.normalized_coords = 1;
+
+	surf_tmpl.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+	surf_tmpl.u.tex.level = 0;
+	surf_tmpl.u.tex.first_layer = 0;
+	surf_tmpl.u.tex.last_layer = 0;
+	/* drawing destination */
+	memset(&p->framebuffer, 0, sizeof(p->framebuffer));
+	p->framebuffer.width = WIDTH;
+	p->framebuffer.height = HEIGHT;
+	p->framebuffer.nr_cbufs = 1;
+	p->framebuffer.cbufs[0] = p->pipe->create_surface(p->pipe, p->target, &surf_tmpl);
+
+	/* viewport: (-1,-1)-(1,1) mapped to the render target */
+	p->viewport.scale[0] = (float)WIDTH / 2.0f;
+	p->viewport.scale[1] = (float)HEIGHT / 2.0f;
+	p->viewport.scale[2] = 1.0f;
+	p->viewport.translate[0] = (float)WIDTH / 2.0f;
+	p->viewport.translate[1] = (float)HEIGHT / 2.0f;
+	p->viewport.translate[2] = 0.0f;
+
+	/* vertex elements state, the second variant swaps the attributes */
+	memset(p->velem, 0, sizeof(p->velem));
+	for (i = 0; i < 2; i++) {
+		p->velem[i][0].src_offset = (i ? 1 : 0) * 4 * sizeof(float);
+		p->velem[i][0].instance_divisor = 0;
+		p->velem[i][0].vertex_buffer_index = 0;
+		p->velem[i][0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+		p->velem[i][1].src_offset = (i ? 0 : 1) * 4 * sizeof(float);
+		p->velem[i][1].instance_divisor = 0;
+		p->velem[i][1].vertex_buffer_index = 0;
+		p->velem[i][1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+	}
+
+	/* vertex shader */
+	{
+		const uint semantic_names[] = { TGSI_SEMANTIC_POSITION,
+						TGSI_SEMANTIC_GENERIC };
+		const uint semantic_indexes[] = { 0, 0 };
+		p->vs = util_make_vertex_passthrough_shader(p->pipe, 2, semantic_names, semantic_indexes, FALSE);
+	}
+
+	/* fragment shaders */
+	p->fs = util_make_fragment_passthrough_shader(p->pipe,
+	            TGSI_SEMANTIC_GENERIC, TGSI_INTERPOLATE_PERSPECTIVE, TRUE);
+	p->fs_tex = util_make_fragment_tex_shader(p->pipe, TGSI_TEXTURE_2D,
+	                                          TGSI_INTERPOLATE_PERSPECTIVE,
+	                                          TGSI_RETURN_TYPE_FLOAT);
+}
+
+static void close_prog(struct program *p)
+{
+	int i;
+
+	cso_destroy_context(p->cso);
+
+	p->pipe->delete_vs_state(p->pipe, p->vs);
+	p->pipe->delete_fs_state(p->pipe, p->fs);
+	p->pipe->delete_fs_state(p->pipe, p->fs_tex);
+
+	for (i = 0; i < 2; i++) {
+		pipe_sampler_view_reference(&p->view[i], NULL);
+		pipe_resource_reference(&p->tex[i], NULL);
+	}
+	pipe_surface_reference(&p->framebuffer.cbufs[0], NULL);
+	pipe_resource_reference(&p->target, NULL);
+	pipe_resource_reference(&p->vbuf, NULL);
+
+	p->pipe->destroy(p->pipe);
+	p->screen->destroy(p->screen);
+	pipe_loader_release(&p->dev, 1);
+
+	FREE(p);
+}
+
+/* set the state common to all the scenarios */
+static void set_default_state(struct program *p)
+{
+	const struct pipe_sampler_state *samplers[] = {&p->sampler};
+	struct pipe_vertex_buffer vbuffer;
+
+	cso_set_framebuffer(p->cso, &p->framebuffer);
+
+	p->pipe->clear(p->pipe, PIPE_CLEAR_COLOR, &p->clear_color, 0, 0);
+
+	cso_set_blend(p->cso, &p->blend[0]);
+	cso_set_depth_stencil_alpha(p->cso, &p->depthstencil);
+	cso_set_rasterizer(p->cso, &p->rasterizer);
+	cso_set_viewport(p->cso, &p->viewport);
+
+	cso_set_samplers(p->cso, PIPE_SHADER_FRAGMENT, 1, samplers);
+	cso_set_sampler_views(p->cso, PIPE_SHADER_FRAGMENT, 1, &p->view[0]);
+
+	cso_set_fragment_shader_handle(p->cso, p->fs);
+	cso_set_vertex_shader_handle(p->cso, p->vs);
+
+	cso_set_vertex_elements(p->cso, 2, p->velem[0]);
+
+	memset(&vbuffer, 0, sizeof(vbuffer));
+	vbuffer.buffer = p->vbuf;
+	vbuffer.stride = 2 * 4 * sizeof(float);
+	vbuffer.buffer_offset = 0;
+	cso_set_vertex_buffers(p->cso, 0, 1, &vbuffer);
+}
+
+static void draw_only(struct program *p, int i)
+{
+	cso_draw_arrays(p->cso, PIPE_PRIM_TRIANGLES, 0, 3);
+}
+
+static void draw_state_change(struct program *p, int i)
+{
+	cso_set_blend(p->cso, &p->blend[i & 1]);
+	cso_draw_arrays(p->cso, PIPE_PRIM_TRIANGLES, 0, 3);
+}
+
+static void draw_uniform_update(struct program *p, int i)
+{
+	float constants[4] = {0.0f, 0.25f, 0.5f, (float)i};
+	struct pipe_constant_buffer cb;
+
+	memset(&cb, 0, sizeof(cb));
+	cb.user_buffer = constants;
+	cb.buffer_size = sizeof(constants);
+	p->pipe->set_constant_buffer(p->pipe, PIPE_SHADER_FRAGMENT, 0, &cb);
+
+	cso_draw_arrays(p->cso, PIPE_PRIM_TRIANGLES, 0, 3);
+}
+
+static void draw_texture_bind(struct program *p, int i)
+{
+	cso_set_sampler_views(p->cso, PIPE_SHADER_FRAGMENT, 1,
+			      &p->view[i & 1]);
+	cso_draw_arrays(p->cso, PIPE_PRIM_TRIANGLES, 0, 3);
+}
+
+static void draw_velem_change(struct program *p, int i)
+{
+	cso_set_vertex_elements(p->cso, 2, p->velem[i & 1]);
+	cso_draw_arrays(p->cso, PIPE_PRIM_TRIANGLES, 0, 3);
+}
+
+static void bench(struct program *p, const char *name,
+		  void (*draw)(struct program *p, int i))
+{
+	int64_t start, duration;
+	int i;
+
+	/* let one-time setup costs (shader compiles etc.) settle */
+	for (i = 0; i < NUM_WARMUP; i++)
+		draw(p, i);
+	p->pipe->flush(p->pipe, NULL, 0);
+
+	start = os_time_get();
+	for (i = 0; i < NUM_DRAWS; i++)
+		draw(p, i);
+	p->pipe->flush(p->pipe, NULL, 0);
+	duration = os_time_get() - start;
+
+	printf("   %-24s %8.1f kdraws/s, %8.1f ns/draw\n", name,
+	       (double)NUM_DRAWS * 1000.0 / duration,
+	       (double)duration * 1000.0 / NUM_DRAWS);
+}
+
+int main(int argc, char** argv)
+{
+	struct program *p = CALLOC_STRUCT(program);
+
+	init_prog(p);
+
+	printf("drawoverhead: %d draws per scenario on %s\n", NUM_DRAWS,
+	       p->screen->get_name(p->screen));
+
+	set_default_state(p);
+	bench(p, "draw", draw_only);
+	bench(p, "draw | state change", draw_state_change);
+
+	set_default_state(p);
+	bench(p, "draw | uniform update", draw_uniform_update);
+
+	/* rebind with a texturing fragment shader so the view is used */
+	set_default_state(p);
+	cso_set_fragment_shader_handle(p->cso, p->fs_tex);
+	bench(p, "draw | texture bind", draw_texture_bind);
+
+	set_default_state(p);
+	bench(p, "draw | vertex elements", draw_velem_change);
+
+	close_prog(p);
+
+	return 0;
+}
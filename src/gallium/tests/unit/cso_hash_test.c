@@ -0,0 +1,278 @@
+/**************************************************************************
+ *
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ * Randomized differential test for cso_hash.
+ *
+ * Runs random insert/take/contains traffic (plus full iterations with
+ * mid-iteration erase) against the table and a naive reference multiset,
+ * checking after every batch that the two agree and that the table's
+ * documented invariants hold: iteration visits every entry exactly once,
+ * entries sharing a key are visited consecutively, and iterators stay
+ * usable across cso_hash_erase().  Small key spaces force long equal-key
+ * runs and collision shifts; the op counts push the table through
+ * several rehashes.  Run it under the address/UB sanitizers when
+ * touching cso_hash.c - the interesting failures are stale slots, not
+ * crashes.
+ */
+
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cso_cache/cso_hash.h"
+
+
+#define MAX_ENTRIES 4096
+#define MAX_KEY_SPACE 1024
+
+struct ref_entry {
+   unsigned key;
+   uintptr_t value;
+};
+
+static struct ref_entry ref[MAX_ENTRIES];
+static unsigned char visited[MAX_ENTRIES];
+static int ref_size;
+
+
+static void
+ref_insert(unsigned key, uintptr_t value)
+{
+   assert(ref_size < MAX_ENTRIES);
+   ref[ref_size].key = key;
+   ref[ref_size].value = value;
+   ref_size++;
+}
+
+
+/**
+ * Remove the reference pair matching (key, value); asserts it exists.
+ */
+static void
+ref_remove(unsigned key, uintptr_t value)
+{
+   int i;
+
+   for (i = 0; i < ref_size; i++) {
+      if (ref[i].key == key && ref[i].value == value) {
+         ref[i] = ref[ref_size - 1];
+         ref_size--;
+         return;
+      }
+   }
+   assert(!"removed value not in reference");
+}
+
+
+static int
+ref_count_key(unsigned key)
+{
+   int count = 0;
+   int i;
+
+   for (i = 0; i < ref_size; i++) {
+      if (ref[i].key == key)
+         count++;
+   }
+   return count;
+}
+
+
+/**
+ * Mark the reference pair matching an iterated (key, value) as visited;
+ * asserts that an unvisited match exists, so a duplicate visit trips.
+ */
+static void
+ref_visit(unsigned key, uintptr_t value)
+{
+   int i;
+
+   for (i = 0; i < ref_size; i++) {
+      if (!visited[i] && ref[i].key == key && ref[i].value == value) {
+         visited[i] = 1;
+         return;
+      }
+   }
+   assert(!"iterated entry not in reference (or visited twice)");
+}
+
+
+/**
+ * Full consistency check: size, exactly-once iteration, equal-key runs,
+ * and per-key find()+next() walks against the reference.
+ */
+static void
+check_table(struct cso_hash *hash, unsigned key_space)
+{
+   static unsigned char key_closed[MAX_KEY_SPACE];
+   struct cso_hash_iter iter;
+   unsigned prev_key = ~0u;
+   unsigned key;
+   int count = 0;
+   int i;
+
+   assert(key_space <= MAX_KEY_SPACE);
+   assert(cso_hash_size(hash) == ref_size);
+
+   /* Iteration must visit every entry exactly once, and all entries with
+    * the same key back to back: once iteration has moved off a key, that
+    * key must never reappear.
+    */
+   memset(visited, 0, sizeof(visited));
+   memset(key_closed, 0, key_space);
+
+   for (iter = cso_hash_first_node(hash); !cso_hash_iter_is_null(iter);
+        iter = cso_hash_iter_next(iter)) {
+      key = cso_hash_iter_key(iter);
+      assert(key < key_space);
+      if (key != prev_key) {
+         assert(!key_closed[key]);
+         if (prev_key != ~0u)
+            key_closed[prev_key] = 1;
+         prev_key = key;
+      }
+      ref_visit(key, (uintptr_t) cso_hash_iter_data(iter));
+      count++;
+   }
+   assert(count == ref_size);
+
+   /* find() must land on the head of a key's run and next() must yield
+    * the whole run before the key changes.
+    */
+   for (key = 0; key < key_space; key++) {
+      int expected = ref_count_key(key);
+
+      assert(cso_hash_contains(hash, key) == (expected > 0));
+
+      count = 0;
+      iter = cso_hash_find(hash, key);
+      while (!cso_hash_iter_is_null(iter) && cso_hash_iter_key(iter) == key) {
+         count++;
+         iter = cso_hash_iter_next(iter);
+      }
+      assert(count == expected);
+   }
+
+   /* A backward walk visits just as many entries: step forward to the
+    * end-of-table iterator, then iter_prev() back through every entry.
+    */
+   iter = cso_hash_first_node(hash);
+   while (!cso_hash_iter_is_null(iter))
+      iter = cso_hash_iter_next(iter);
+   for (i = 0; i < ref_size; i++) {
+      iter = cso_hash_iter_prev(iter);
+      assert(!cso_hash_iter_is_null(iter));
+   }
+}
+
+
+static void
+test_random(unsigned seed, unsigned key_space, unsigned num_ops)
+{
+   struct cso_hash *hash = cso_hash_create();
+   uintptr_t next_value = 1;
+   unsigned op;
+
+   printf("Testing %u random ops over %u keys (seed %u).\n",
+          num_ops, key_space, seed);
+
+   srand(seed);
+   ref_size = 0;
+
+   for (op = 0; op < num_ops; op++) {
+      unsigned r = rand() % 100;
+      unsigned key = rand() % key_space;
+
+      if (r < 55 && ref_size < MAX_ENTRIES) {
+         uintptr_t value = next_value++;
+         struct cso_hash_iter iter =
+            cso_hash_insert(hash, key, (void *) value);
+
+         assert(!cso_hash_iter_is_null(iter));
+         assert(cso_hash_iter_key(iter) == key);
+         assert(cso_hash_iter_data(iter) == (void *) value);
+         ref_insert(key, value);
+      }
+      else if (r < 80) {
+         void *data = cso_hash_take(hash, key);
+
+         if (ref_count_key(key) > 0) {
+            assert(data != NULL);
+            ref_remove(key, (uintptr_t) data);
+         }
+         else {
+            assert(data == NULL);
+         }
+      }
+      else if (r < 95) {
+         assert(cso_hash_contains(hash, key) == (ref_count_key(key) > 0));
+      }
+      else {
+         /* Sweep the whole table, erasing a third of the keys mid
+          * iteration and continuing from the iterator erase returns -
+          * the pattern the cso context uses when trimming its caches.
+          */
+         unsigned victim = rand() % 3;
+         struct cso_hash_iter iter = cso_hash_first_node(hash);
+
+         while (!cso_hash_iter_is_null(iter)) {
+            if (cso_hash_iter_key(iter) % 3 == victim) {
+               ref_remove(cso_hash_iter_key(iter),
+                          (uintptr_t) cso_hash_iter_data(iter));
+               iter = cso_hash_erase(hash, iter);
+            }
+            else {
+               iter = cso_hash_iter_next(iter);
+            }
+         }
+      }
+
+      if ((op & 255) == 0)
+         check_table(hash, key_space);
+   }
+
+   check_table(hash, key_space);
+   cso_hash_delete(hash);
+}
+
+
+int main() {
+   /* Heavy collisions: long equal-key runs and collision shifts. */
+   test_random(1, 32, 20000);
+
+   /* Wide key space: grows through several rehashes. */
+   test_random(2, 1024, 20000);
+
+   /* Pathological: every insert lands in one of eight runs. */
+   test_random(3, 8, 50000);
+
+   return 0;
+}
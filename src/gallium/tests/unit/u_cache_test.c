@@ -33,6 +33,8 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "util/u_cache.h"
 #include "util/u_hash.h"
@@ -63,6 +65,60 @@ cache_test_compare(const void *key1, const void *key2) {
 }
 
 
+static int
+cache_test_compare_contents(const void *key1, const void *key2) {
+   return memcmp(key1, key2, sizeof(cache_test_key));
+}
+
+
+static void
+cache_test_destroy_value(void *key, void *value)
+{
+   /* the key is the cache's inline copy, only the value is ours */
+   (void) key;
+   free(value);
+}
+
+
+static void
+test_inline_keys(void)
+{
+   struct util_cache *cache;
+   cache_test_value *value_in;
+   cache_test_value *value_out;
+   cache_test_key key;
+   int i;
+
+   printf("Testing inline keys.\n");
+
+   cache = util_cache_create_inline(cache_test_hash,
+                                    cache_test_compare_contents,
+                                    cache_test_destroy_value,
+                                    32,
+                                    sizeof(cache_test_key));
+
+   for (i = 0; i < 1000; i++) {
+      value_in = malloc(sizeof(cache_test_value));
+
+      key = i;
+      *value_in = ~i;
+      util_cache_set(cache, &key, value_in);
+
+      /* the cache must not remember the address of our stack key */
+      key = i;
+      value_out = util_cache_get(cache, &key);
+      assert(value_out != NULL);
+      assert(value_in == value_out);
+
+      /* a second lookup hits the direct-mapped front cache */
+      value_out = util_cache_get(cache, &key);
+      assert(value_in == value_out);
+   }
+
+   util_cache_destroy(cache);
+}
+
+
 int main() {
    unsigned cache_size;
    unsigned cache_count;
@@ -117,5 +173,7 @@ int main() {
       }
    }
 
+   test_inline_keys();
+
    return 0;
 }
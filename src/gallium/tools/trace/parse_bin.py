@@ -0,0 +1,235 @@
+#!/usr/bin/env python
+##########################################################################
+#
+# Copyright 2008 VMware, Inc.
+# All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sub license, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice (including the
+# next paragraph) shall be included in all copies or substantial portions
+# of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+# IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+##########################################################################
+
+'''Parser for the binary trace format (GALLIUM_TRACE_FORMAT=binary).
+
+See the format description in src/gallium/drivers/trace/tr_dump.c.
+'''
+
+
+import struct
+import sys
+import optparse
+
+from model import *
+import format
+
+
+CALL_BEGIN    = 1
+CALL_END      = 2
+ARG_BEGIN     = 3
+ARG_END       = 4
+RET_BEGIN     = 5
+RET_END       = 6
+BOOL          = 7
+INT           = 8
+UINT          = 9
+FLOAT         = 10
+BYTES         = 11
+STRING        = 12
+ENUM          = 13
+ARRAY_BEGIN   = 14
+ARRAY_END     = 15
+ELEM_BEGIN    = 16
+ELEM_END      = 17
+STRUCT_BEGIN  = 18
+STRUCT_END    = 19
+MEMBER_BEGIN  = 20
+MEMBER_END    = 21
+NULL          = 22
+PTR           = 23
+
+MAGIC = 'GALT'
+VERSION = 1
+
+STRING_DEF = 0x80000000
+
+
+class BinTraceParser:
+
+    def __init__(self, fp):
+        self.fp = fp
+        self.strings = {}
+
+    def parse(self):
+        magic = self.fp.read(4)
+        if magic != MAGIC:
+            raise ValueError('not a binary gallium trace')
+        version = self.read_uint32()
+        if version > VERSION:
+            raise ValueError('unsupported trace version %u' % version)
+        while True:
+            op = self.read_op()
+            if op is None:
+                break
+            if op != CALL_BEGIN:
+                raise ValueError('unexpected opcode %u' % op)
+            call = self.parse_call()
+            if call is not None:
+                self.handle_call(call)
+
+    def parse_call(self):
+        no = self.read_uint32()
+        klass = self.read_interned()
+        method = self.read_interned()
+        args = []
+        ret = None
+        while True:
+            op = self.read_op()
+            if op is None:
+                # truncated trace, e.g. the application crashed mid call
+                return None
+            if op == CALL_END:
+                time = self.read_int64()
+                break
+            elif op == ARG_BEGIN:
+                name = self.read_interned()
+                value = self.parse_value(self.read_op())
+                self.expect(ARG_END)
+                args.append((name, value))
+            elif op == RET_BEGIN:
+                ret = self.parse_value(self.read_op())
+                self.expect(RET_END)
+            else:
+                raise ValueError('unexpected opcode %u' % op)
+        return Call(no, klass, method, args, ret, Literal(time))
+
+    def parse_value(self, op):
+        if op == NULL:
+            return Literal(None)
+        if op == BOOL:
+            return Literal(struct.unpack('<B', self.fp.read(1))[0])
+        if op == INT:
+            return Literal(self.read_int64())
+        if op == UINT:
+            return Literal(struct.unpack('<Q', self.fp.read(8))[0])
+        if op == FLOAT:
+            return Literal(struct.unpack('<d', self.fp.read(8))[0])
+        if op == BYTES:
+            size = self.read_uint32()
+            return Blob(self.fp.read(size).encode('hex'))
+        if op == STRING:
+            length = self.read_uint32()
+            return Literal(self.fp.read(length))
+        if op == ENUM:
+            return NamedConstant(self.read_interned())
+        if op == PTR:
+            return Pointer('0x%08x' % struct.unpack('<Q', self.fp.read(8))[0])
+        if op == ARRAY_BEGIN:
+            elems = []
+            while True:
+                elem_op = self.read_op()
+                if elem_op == ARRAY_END:
+                    break
+                assert elem_op == ELEM_BEGIN
+                elems.append(self.parse_value(self.read_op()))
+                self.expect(ELEM_END)
+            return Array(elems)
+        if op == STRUCT_BEGIN:
+            name = self.read_interned()
+            members = []
+            while True:
+                member_op = self.read_op()
+                if member_op == STRUCT_END:
+                    break
+                assert member_op == MEMBER_BEGIN
+                member_name = self.read_interned()
+                members.append((member_name, self.parse_value(self.read_op())))
+                self.expect(MEMBER_END)
+            return Struct(name, members)
+        raise ValueError('unexpected opcode %u' % op)
+
+    def read_op(self):
+        byte = self.fp.read(1)
+        if not byte:
+            return None
+        return struct.unpack('<B', byte)[0]
+
+    def expect(self, op):
+        found = self.read_op()
+        if found != op:
+            raise ValueError('opcode %u expected, %u found' % (op, found))
+
+    def read_uint32(self):
+        return struct.unpack('<I', self.fp.read(4))[0]
+
+    def read_int64(self):
+        return struct.unpack('<q', self.fp.read(8))[0]
+
+    def read_interned(self):
+        id = self.read_uint32()
+        if id & STRING_DEF:
+            id &= ~STRING_DEF
+            length = self.read_uint32()
+            self.strings[id] = self.fp.read(length)
+        return self.strings[id]
+
+    def handle_call(self, call):
+        pass
+
+
+class BinTraceDumper(BinTraceParser):
+
+    def __init__(self, fp, outStream = sys.stdout):
+        BinTraceParser.__init__(self, fp)
+        self.formatter = format.DefaultFormatter(outStream)
+        self.pretty_printer = PrettyPrinter(self.formatter)
+
+    def handle_call(self, call):
+        call.visit(self.pretty_printer)
+        self.formatter.newline()
+
+
+class Main:
+
+    def main(self):
+        optparser = optparse.OptionParser(
+            usage="\n\t%prog [options] TRACE  [...]")
+        (options, args) = optparser.parse_args(sys.argv[1:])
+
+        if not args:
+            optparser.error('insufficient number of arguments')
+
+        for arg in args:
+            if arg.endswith('.gz'):
+                from gzip import GzipFile
+                stream = GzipFile(arg, 'rb')
+            elif arg.endswith('.bz2'):
+                from bz2 import BZ2File
+                stream = BZ2File(arg, 'rb')
+            else:
+                stream = open(arg, 'rb')
+            self.process_arg(stream, options)
+
+    def process_arg(self, stream, options):
+        parser = BinTraceDumper(stream)
+        parser.parse()
+
+
+if __name__ == '__main__':
+    Main().main()
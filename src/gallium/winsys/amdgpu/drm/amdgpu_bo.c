@@ -129,6 +129,9 @@ void amdgpu_bo_destroy(struct pb_buffer *_buf)
    bo->ws->num_buffers--;
    pipe_mutex_unlock(bo->ws->global_bo_list_lock);
 
+   if (bo->cpu_ptr)
+      amdgpu_bo_cpu_unmap(bo->bo);
+
    amdgpu_bo_va_op(bo->bo, 0, bo->base.size, bo->va, 0, AMDGPU_VA_OP_UNMAP);
    amdgpu_va_range_free(bo->va_handle);
    amdgpu_bo_free(bo->bo);
@@ -229,20 +232,33 @@ static void *amdgpu_bo_map(struct pb_buffer *buf,
    if (bo->user_ptr)
        return bo->user_ptr;
 
+   /* The mapping is kept until the buffer is destroyed, so that repeated
+    * maps of the same buffer (u_upload_mgr, transfers) are a simple pointer
+    * return instead of kernel mmap traffic.
+    *
+    * Racing first-time maps are benign: libdrm reference-counts the mapping
+    * and returns the same CPU address to all of them.
+    */
+   if (bo->cpu_ptr)
+      return bo->cpu_ptr;
+
    r = amdgpu_bo_cpu_map(bo->bo, &cpu);
    if (r) {
       /* Clear the cache and try again. */
       pb_cache_release_all_buffers(&bo->ws->bo_cache);
       r = amdgpu_bo_cpu_map(bo->bo, &cpu);
+      if (r)
+         return NULL;
    }
-   return r ? NULL : cpu;
+
+   bo->cpu_ptr = cpu;
+   return cpu;
 }
 
 static void amdgpu_bo_unmap(struct pb_buffer *buf)
 {
-   struct amdgpu_winsys_bo *bo = (struct amdgpu_winsys_bo*)buf;
-
-   amdgpu_bo_cpu_unmap(bo->bo);
+   /* The mapping is cached in bo->cpu_ptr and released when the buffer is
+    * destroyed. */
 }
 
 static const struct pb_vtbl amdgpu_winsys_bo_vtbl = {
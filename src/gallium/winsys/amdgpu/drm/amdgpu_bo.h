@@ -42,6 +42,7 @@ struct amdgpu_winsys_bo {
 
    struct amdgpu_winsys *ws;
    void *user_ptr; /* from buffer_from_ptr */
+   void *cpu_ptr; /* kept mapped until the buffer is destroyed */
 
    amdgpu_bo_handle bo;
    uint32_t unique_id;
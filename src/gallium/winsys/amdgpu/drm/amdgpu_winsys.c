@@ -308,6 +308,9 @@ static void amdgpu_winsys_destroy(struct radeon_winsys *rws)
 {
    struct amdgpu_winsys *ws = (struct amdgpu_winsys*)rws;
 
+   if (util_queue_is_initialized(&ws->cs_queue))
+      util_queue_destroy(&ws->cs_queue);
+
    pipe_mutex_destroy(ws->bo_fence_lock);
    pb_cache_deinit(&ws->bo_cache);
    pipe_mutex_destroy(ws->global_bo_list_lock);
@@ -487,6 +490,10 @@ amdgpu_winsys_create(int fd, radeon_screen_create_t screen_create)
    pipe_mutex_init(ws->global_bo_list_lock);
    pipe_mutex_init(ws->bo_fence_lock);
 
+   /* The submission thread is not critical; if its creation fails, CS
+    * flushes are submitted directly on the application thread. */
+   util_queue_init(&ws->cs_queue, "amdgpu_cs", 8, 1, 0);
+
    /* Create the screen at the end. The winsys must be initialized
     * completely.
     *
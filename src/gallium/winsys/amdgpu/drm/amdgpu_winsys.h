@@ -34,6 +34,7 @@
 
 #include "pipebuffer/pb_cache.h"
 #include "gallium/drivers/radeon/radeon_winsys.h"
+#include "util/u_queue.h"
 #include "addrlib/addrinterface.h"
 #include "os/os_thread.h"
 #include <amdgpu.h>
@@ -56,6 +57,11 @@ struct amdgpu_winsys {
    uint64_t buffer_wait_time; /* time spent in buffer_wait in ns */
    uint64_t num_cs_flushes;
 
+   /* CS submissions are offloaded to this queue, so that the application
+    * thread can start recording the next IB right away.
+    */
+   struct util_queue cs_queue;
+
    struct radeon_info info;
 
    struct amdgpu_gpu_info amdinfo;
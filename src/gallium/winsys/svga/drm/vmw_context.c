@@ -27,6 +27,7 @@
 #include "svga_cmd.h"
 
 #include "util/u_debug.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_debug_stack.h"
 #include "util/u_debug_flush.h"
@@ -44,12 +45,24 @@
 #include "vmw_query.h"
 
 #define VMW_COMMAND_SIZE (64*1024)
+
+/*
+ * Limit for adaptive command buffer growth.  The buffer starts at
+ * VMW_COMMAND_SIZE and is doubled whenever a reservation would
+ * otherwise force a flush on command space alone, so draw-heavy frames
+ * settle at a size that matches their observed flush volume.
+ */
+#define VMW_MAX_COMMAND_SIZE (512*1024)
+
 #define VMW_SURFACE_RELOCS (1024)
 #define VMW_SHADER_RELOCS (1024)
 #define VMW_REGION_RELOCS (512)
 
 #define VMW_MUST_FLUSH_STACK 8
 
+/** There is no tail SurfaceDMA command to merge new boxes into */
+#define VMW_INVALID_CMD_OFFSET (~0u)
+
 /*
  * A factor applied to the maximum mob memory size to determine
  * the optimial time to preemptively flush the command buffer.
@@ -104,10 +117,20 @@ struct vmw_svga_winsys_context
 #endif
 
    struct {
-      uint8_t buffer[VMW_COMMAND_SIZE];
+      uint8_t *buffer;
       uint32_t size;
       uint32_t used;
       uint32_t reserved;
+
+      /**
+       * Offset of the SurfaceDMA command at the buffer tail and the
+       * index of its guest-pointer region relocation, used to append
+       * copy boxes of a subsequent compatible SurfaceDMA instead of
+       * emitting a new command.  VMW_INVALID_CMD_OFFSET if the last
+       * committed command wasn't a SurfaceDMA.
+       */
+      uint32_t dma_cmd_offset;
+      uint32_t dma_reloc;
    } command;
 
    struct {
@@ -222,6 +245,7 @@ vmw_swc_flush(struct svga_winsys_context *swc,
 
    vswc->command.used = 0;
    vswc->command.reserved = 0;
+   vswc->command.dma_cmd_offset = VMW_INVALID_CMD_OFFSET;
 
    for(i = 0; i < vswc->surface.used + vswc->surface.staged; ++i) {
       struct vmw_ctx_validate_item *isurf = &vswc->surface.items[i];
@@ -266,6 +290,72 @@ vmw_swc_flush(struct svga_winsys_context *swc,
 }
 
 
+static inline void *
+vmw_swc_rebase_ptr(void *ptr, uint8_t *old_buf, uint32_t old_size,
+                   uint8_t *new_buf)
+{
+   uint8_t *p = ptr;
+
+   if (p >= old_buf && p < old_buf + old_size)
+      return new_buf + (p - old_buf);
+   return ptr;
+}
+
+/**
+ * Grow the command buffer so that the pending reservation fits,
+ * avoiding a flush that would be taken on command space alone.
+ * Returns FALSE if the buffer is already at its maximum size or
+ * reallocation fails, in which case the caller flushes as before.
+ */
+static boolean
+vmw_swc_grow_command_buffer(struct vmw_svga_winsys_context *vswc,
+                            uint32_t nr_bytes)
+{
+   uint8_t *old_buf = vswc->command.buffer;
+   uint32_t old_size = vswc->command.size;
+   uint32_t new_size = old_size;
+   uint8_t *new_buf;
+   unsigned i;
+
+   while (new_size < vswc->command.used + nr_bytes) {
+      if (new_size >= VMW_MAX_COMMAND_SIZE)
+         return FALSE;
+      new_size = MIN2(new_size * 2, VMW_MAX_COMMAND_SIZE);
+   }
+
+   new_buf = REALLOC(old_buf, old_size, new_size);
+   if (!new_buf)
+      return FALSE;
+
+   /*
+    * Region relocations patch guest pointers inside the command buffer
+    * at flush time; rebase any that point into the old allocation.
+    */
+   if (new_buf != old_buf) {
+      for (i = 0; i < vswc->region.used + vswc->region.staged; ++i) {
+         struct vmw_buffer_relocation *reloc = &vswc->region.relocs[i];
+
+         if (reloc->is_mob) {
+            reloc->mob.id = vmw_swc_rebase_ptr(reloc->mob.id, old_buf,
+                                               old_size, new_buf);
+            reloc->mob.offset_into_mob =
+               vmw_swc_rebase_ptr(reloc->mob.offset_into_mob, old_buf,
+                                  old_size, new_buf);
+         }
+         else {
+            reloc->region.where = vmw_swc_rebase_ptr(reloc->region.where,
+                                                     old_buf, old_size,
+                                                     new_buf);
+         }
+      }
+   }
+
+   vswc->command.buffer = new_buf;
+   vswc->command.size = new_size;
+
+   return TRUE;
+}
+
 static void *
 vmw_swc_reserve(struct svga_winsys_context *swc,
                 uint32_t nr_bytes, uint32_t nr_relocs )
@@ -282,6 +372,17 @@ vmw_swc_reserve(struct svga_winsys_context *swc,
    debug_flush_might_flush(vswc->fctx);
 #endif
 
+   /*
+    * If command space is the only thing standing in the way, grow the
+    * buffer instead of forcing the caller to flush.
+    */
+   if(!vswc->preemptive_flush &&
+      vswc->command.used + nr_bytes > vswc->command.size &&
+      vswc->surface.used + nr_relocs <= vswc->surface.size &&
+      vswc->shader.used + nr_relocs <= vswc->shader.size &&
+      vswc->region.used + nr_relocs <= vswc->region.size)
+      (void) vmw_swc_grow_command_buffer(vswc, nr_bytes);
+
    assert(nr_bytes <= vswc->command.size);
    if(nr_bytes > vswc->command.size)
       return NULL;
@@ -598,13 +699,151 @@ vmw_swc_query_relocation(struct svga_winsys_context *swc,
                           SVGA_RELOC_READ | SVGA_RELOC_WRITE);
 }
 
+static boolean
+vmw_copy_boxes_intersect(const SVGA3dCopyBox *a, const SVGA3dCopyBox *b)
+{
+   /* check both the host (x/y/z) and guest (srcx/srcy/srcz) rectangles,
+    * since which one is the destination depends on the transfer direction
+    */
+   return (a->x < b->x + b->w && b->x < a->x + a->w &&
+           a->y < b->y + b->h && b->y < a->y + a->h &&
+           a->z < b->z + b->d && b->z < a->z + a->d) ||
+          (a->srcx < b->srcx + b->w && b->srcx < a->srcx + a->w &&
+           a->srcy < b->srcy + b->h && b->srcy < a->srcy + a->h &&
+           a->srcz < b->srcz + b->d && b->srcz < a->srcz + a->d);
+}
+
+/**
+ * Check whether the command being committed is a single SurfaceDMA
+ * targeting the same guest buffer, host image and transfer direction
+ * as the SurfaceDMA at the buffer tail.  If so, append its copy boxes
+ * to the tail command instead of emitting a new one, so back-to-back
+ * uploads to the same surface cost the host one DMA transition.
+ */
+static boolean
+vmw_swc_merge_surface_dma(struct vmw_svga_winsys_context *vswc)
+{
+   const uint32_t suffix_size = sizeof(SVGA3dCmdSurfaceDMASuffix);
+   const uint32_t min_size = sizeof(SVGA3dCmdHeader) +
+      sizeof(SVGA3dCmdSurfaceDMA) + sizeof(SVGA3dCopyBox) + suffix_size;
+   const struct vmw_buffer_relocation *prev_reloc, *new_reloc;
+   SVGA3dCmdHeader *prev_hdr, *new_hdr;
+   SVGA3dCmdSurfaceDMA *prev_body, *new_body;
+   SVGA3dCmdSurfaceDMASuffix *prev_suffix, *new_suffix;
+   SVGA3dCmdSurfaceDMASuffix suffix;
+   uint32_t new_boxes_size;
+
+   if (vswc->command.dma_cmd_offset == VMW_INVALID_CMD_OFFSET)
+      return FALSE;
+
+   if (vswc->command.reserved < min_size)
+      return FALSE;
+
+   new_hdr = (SVGA3dCmdHeader *) (vswc->command.buffer + vswc->command.used);
+   if (new_hdr->id != SVGA_3D_CMD_SURFACE_DMA ||
+       sizeof(*new_hdr) + new_hdr->size != vswc->command.reserved)
+      return FALSE;
+
+   /* The guest pointer must be the only staged region relocation */
+   if (vswc->region.staged != 1)
+      return FALSE;
+
+   new_body = (SVGA3dCmdSurfaceDMA *) &new_hdr[1];
+   new_suffix = (SVGA3dCmdSurfaceDMASuffix *)
+      (vswc->command.buffer + vswc->command.used + vswc->command.reserved -
+       suffix_size);
+   if (new_suffix->suffixSize != suffix_size)
+      return FALSE;
+
+   prev_hdr = (SVGA3dCmdHeader *)
+      (vswc->command.buffer + vswc->command.dma_cmd_offset);
+   prev_body = (SVGA3dCmdSurfaceDMA *) &prev_hdr[1];
+   prev_suffix = (SVGA3dCmdSurfaceDMASuffix *)
+      (vswc->command.buffer + vswc->command.used - suffix_size);
+
+   /*
+    * Guest pointer contents are placeholders until relocations are
+    * applied at flush time, so compare the relocations instead.
+    */
+   prev_reloc = &vswc->region.relocs[vswc->command.dma_reloc];
+   new_reloc = &vswc->region.relocs[vswc->region.used];
+   if (prev_reloc->is_mob || new_reloc->is_mob ||
+       prev_reloc->buffer != new_reloc->buffer ||
+       prev_reloc->offset != new_reloc->offset)
+      return FALSE;
+
+   if (prev_body->guest.pitch != new_body->guest.pitch ||
+       memcmp(&prev_body->host, &new_body->host,
+              sizeof(prev_body->host)) != 0 ||
+       prev_body->transfer != new_body->transfer)
+      return FALSE;
+
+   if (prev_suffix->suffixSize != suffix_size ||
+       memcmp(&prev_suffix->flags, &new_suffix->flags,
+              sizeof(prev_suffix->flags)) != 0)
+      return FALSE;
+
+   /*
+    * Boxes within one command have no defined ordering, so only merge
+    * copies whose regions don't overlap.
+    */
+   {
+      const SVGA3dCopyBox *prev_boxes = (const SVGA3dCopyBox *) &prev_body[1];
+      const SVGA3dCopyBox *new_boxes = (const SVGA3dCopyBox *) &new_body[1];
+      uint32_t prev_nboxes = (prev_hdr->size - sizeof(*prev_body) -
+                              suffix_size) / sizeof(SVGA3dCopyBox);
+      uint32_t new_nboxes = (new_hdr->size - sizeof(*new_body) -
+                             suffix_size) / sizeof(SVGA3dCopyBox);
+      uint32_t i, j;
+
+      for (i = 0; i < new_nboxes; ++i) {
+         for (j = 0; j < prev_nboxes; ++j) {
+            if (vmw_copy_boxes_intersect(&new_boxes[i], &prev_boxes[j]))
+               return FALSE;
+         }
+      }
+   }
+
+   /* Append the new boxes over the tail suffix and re-emit the suffix */
+   suffix = *prev_suffix;
+   suffix.maximumOffset = MAX2(suffix.maximumOffset,
+                               new_suffix->maximumOffset);
+   new_boxes_size = new_hdr->size - sizeof(*new_body) - suffix_size;
+   memmove(prev_suffix, &new_body[1], new_boxes_size);
+   memcpy((uint8_t *) prev_suffix + new_boxes_size, &suffix, suffix_size);
+
+   prev_hdr->size += new_boxes_size;
+   vswc->command.used += new_boxes_size;
+
+   /* Drop the merged command and its staged guest-pointer relocation */
+   vswc->region.staged = 0;
+
+   return TRUE;
+}
+
 static void
 vmw_swc_commit(struct svga_winsys_context *swc)
 {
    struct vmw_svga_winsys_context *vswc = vmw_svga_winsys_context(swc);
+   SVGA3dCmdHeader *hdr;
 
    assert(vswc->command.used + vswc->command.reserved <= vswc->command.size);
-   vswc->command.used += vswc->command.reserved;
+   if (!vmw_swc_merge_surface_dma(vswc)) {
+      /* Remember lone SurfaceDMA commands so the next one can merge */
+      hdr = (SVGA3dCmdHeader *)
+         (vswc->command.buffer + vswc->command.used);
+      if (vswc->command.reserved >= sizeof(*hdr) &&
+          hdr->id == SVGA_3D_CMD_SURFACE_DMA &&
+          sizeof(*hdr) + hdr->size == vswc->command.reserved &&
+          vswc->region.staged == 1) {
+         vswc->command.dma_cmd_offset = vswc->command.used;
+         vswc->command.dma_reloc = vswc->region.used;
+      }
+      else if (vswc->command.reserved) {
+         vswc->command.dma_cmd_offset = VMW_INVALID_CMD_OFFSET;
+      }
+      vswc->command.used += vswc->command.reserved;
+   }
    vswc->command.reserved = 0;
 
    assert(vswc->surface.staged <= vswc->surface.reserved);
@@ -650,6 +889,7 @@ vmw_swc_destroy(struct svga_winsys_context *swc)
    util_hash_table_destroy(vswc->hash);
    pb_validate_destroy(vswc->validate);
    vmw_ioctl_context_destroy(vswc->vws, swc->cid);
+   FREE(vswc->command.buffer);
 #ifdef DEBUG
    debug_flush_ctx_destroy(vswc->fctx);
 #endif
@@ -798,7 +1038,12 @@ vmw_svga_winsys_context_create(struct svga_winsys_screen *sws)
 
    vswc->vws = vws;
 
+   vswc->command.buffer = MALLOC(VMW_COMMAND_SIZE);
+   if(!vswc->command.buffer)
+      goto out_no_cmdbuf;
+
    vswc->command.size = VMW_COMMAND_SIZE;
+   vswc->command.dma_cmd_offset = VMW_INVALID_CMD_OFFSET;
    vswc->surface.size = VMW_SURFACE_RELOCS;
    vswc->shader.size = VMW_SHADER_RELOCS;
    vswc->region.size = VMW_REGION_RELOCS;
@@ -820,6 +1065,8 @@ vmw_svga_winsys_context_create(struct svga_winsys_screen *sws)
 out_no_hash:
    pb_validate_destroy(vswc->validate);
 out_no_validate:
+   FREE(vswc->command.buffer);
+out_no_cmdbuf:
    vmw_ioctl_context_destroy(vws, vswc->base.cid);
 out_no_context:
    FREE(vswc);
@@ -51,6 +51,14 @@
 
 DEBUG_GET_ONCE_BOOL_OPTION(xlib_no_shm, "XLIB_NO_SHM", FALSE)
 
+/* Present from a second shared memory segment and pace reuse with
+ * ShmCompletion events, so the rasterizer never writes pixels the server is
+ * still reading. Off by default: the completion events arrive on the
+ * application's event queue, and an application that discards unknown
+ * events in its own event loop would make us wait forever.
+ */
+DEBUG_GET_ONCE_BOOL_OPTION(xlib_shm_pipeline, "XLIB_SHM_PIPELINE", FALSE)
+
 /**
  * Display target for Xlib winsys.
  * Low-level OS/window system memory buffer
@@ -77,6 +85,15 @@ struct xlib_displaytarget
 
    XShmSegmentInfo shminfo;
    Bool shm;  /** Using shared memory images? */
+
+   /* Optional second segment that XShmPutImage reads from, so the data
+    * segment above stays owned by the rasterizer. Reuse is paced by
+    * ShmCompletion events instead of XSync.
+    */
+   XShmSegmentInfo put_shminfo;
+   Bool put_pending;        /** A completion event is outstanding */
+   Drawable put_drawable;   /** Drawable of the outstanding put */
+   int shm_event_base;
 };
 
 
@@ -119,10 +136,8 @@ handle_xerror(Display *dpy, XErrorEvent *event)
 
 
 static char *
-alloc_shm(struct xlib_displaytarget *buf, unsigned size)
+alloc_shm_seg(XShmSegmentInfo *shminfo, unsigned size)
 {
-   XShmSegmentInfo *const shminfo = & buf->shminfo;
-
    shminfo->shmid = -1;
    shminfo->shmaddr = (char *) -1;
 
@@ -142,6 +157,33 @@ alloc_shm(struct xlib_displaytarget *buf, unsigned size)
 }
 
 
+static char *
+alloc_shm(struct xlib_displaytarget *buf, unsigned size)
+{
+   return alloc_shm_seg(&buf->shminfo, size);
+}
+
+
+/**
+ * XIfEvent predicate: the ShmCompletion event for the outstanding put.
+ */
+struct shm_completion_match
+{
+   int event_type;
+   Drawable drawable;
+};
+
+static Bool
+shm_completion_match_pred(Display *display, XEvent *ev, XPointer arg)
+{
+   const struct shm_completion_match *match =
+      (const struct shm_completion_match *) arg;
+
+   return ev->type == match->event_type &&
+          ((XShmCompletionEvent *) ev)->drawable == match->drawable;
+}
+
+
 /**
  * Allocate a shared memory XImage back buffer for the given display target.
  */
@@ -194,6 +236,28 @@ alloc_shm_ximage(struct xlib_displaytarget *xlib_dt,
       return;
    }
 
+   /* Attach the put segment as well, dropping back to single-segment
+    * operation if that fails.
+    */
+   if (xlib_dt->put_shminfo.shmaddr != (char *) -1) {
+      XErrorFlag = 0;
+      XShmAttach(xlib_dt->display, &xlib_dt->put_shminfo);
+      XSync(xlib_dt->display, False);
+      shmctl(xlib_dt->put_shminfo.shmid, IPC_RMID, 0);
+
+      if (XErrorFlag) {
+         XErrorFlag = 0;
+         shmdt(xlib_dt->put_shminfo.shmaddr);
+         xlib_dt->put_shminfo.shmid = -1;
+         xlib_dt->put_shminfo.shmaddr = (char *) -1;
+      }
+      else {
+         xlib_dt->shm_event_base = XShmGetEventBase(xlib_dt->display);
+      }
+   }
+
+   (void) XSetErrorHandler(old_handler);
+
    xlib_dt->shm = True;
 }
 
@@ -276,6 +340,13 @@ xlib_displaytarget_destroy(struct sw_winsys *ws,
       }
    }
 
+   if (xlib_dt->put_shminfo.shmaddr != (char *) -1) {
+      shmdt(xlib_dt->put_shminfo.shmaddr);
+      shmctl(xlib_dt->put_shminfo.shmid, IPC_RMID, 0);
+      xlib_dt->put_shminfo.shmid = -1;
+      xlib_dt->put_shminfo.shmaddr = (char *) -1;
+   }
+
    if (xlib_dt->tempImage) {
       XDestroyImage(xlib_dt->tempImage);
       xlib_dt->tempImage = NULL;
@@ -339,7 +410,34 @@ xlib_sw_display(struct xlib_drawable *xlib_drawable,
       XSetFunction(display, xlib_dt->gc, GXcopy);
    }
 
-   if (xlib_dt->shm) {
+   if (xlib_dt->shm && xlib_dt->put_shminfo.shmaddr != (char *) -1) {
+      /* Wait until the server is done with the previous frame before
+       * overwriting the put segment.
+       */
+      if (xlib_dt->put_pending) {
+         XEvent ev;
+         struct shm_completion_match match;
+
+         match.event_type = xlib_dt->shm_event_base + ShmCompletion;
+         match.drawable = xlib_dt->put_drawable;
+         XIfEvent(display, &ev, shm_completion_match_pred, (XPointer) &match);
+         xlib_dt->put_pending = False;
+      }
+
+      memcpy(xlib_dt->put_shminfo.shmaddr, xlib_dt->data,
+             xlib_dt->stride * xlib_dt->height);
+
+      ximage = xlib_dt->tempImage;
+      ximage->data = xlib_dt->put_shminfo.shmaddr;
+      /* The server locates the segment through the image's segment info. */
+      ximage->obdata = (char *) &xlib_dt->put_shminfo;
+
+      XShmPutImage(xlib_dt->display, xlib_drawable->drawable, xlib_dt->gc,
+                   ximage, 0, 0, 0, 0, xlib_dt->width, xlib_dt->height, True);
+      xlib_dt->put_pending = True;
+      xlib_dt->put_drawable = xlib_drawable->drawable;
+   }
+   else if (xlib_dt->shm) {
       ximage = xlib_dt->tempImage;
       ximage->data = xlib_dt->data;
 
@@ -410,10 +508,16 @@ xlib_displaytarget_create(struct sw_winsys *winsys,
    xlib_dt->stride = align(util_format_get_stride(format, width), alignment);
    size = xlib_dt->stride * nblocksy;
 
+   xlib_dt->put_shminfo.shmid = -1;
+   xlib_dt->put_shminfo.shmaddr = (char *) -1;
+
    if (!debug_get_option_xlib_no_shm()) {
       xlib_dt->data = alloc_shm(xlib_dt, size);
       if (xlib_dt->data) {
          xlib_dt->shm = True;
+
+         if (debug_get_option_xlib_shm_pipeline())
+            alloc_shm_seg(&xlib_dt->put_shminfo, size);
       }
    }
 
@@ -706,6 +706,17 @@ static int handle_compare(void *key1, void *key2)
     return PTR_TO_UINT(key1) != PTR_TO_UINT(key2);
 }
 
+/* The execbuffer ioctl marks every bo in its handle list busy until the
+ * host has processed the batch, so riding the fence bo along with the
+ * submission arms the fence without a separate ioctl.
+ */
+static void virgl_drm_emit_fence(struct virgl_winsys *qws,
+                                 struct virgl_cmd_buf *cbuf,
+                                 struct pipe_fence_handle *fence)
+{
+   virgl_drm_emit_res(qws, cbuf, virgl_hw_res(fence), FALSE);
+}
+
 static struct pipe_fence_handle *
 virgl_cs_create_fence(struct virgl_winsys *vws)
 {
@@ -784,6 +795,7 @@ virgl_drm_winsys_create(int drmFD)
    qdws->base.cmd_buf_create = virgl_drm_cmd_buf_create;
    qdws->base.cmd_buf_destroy = virgl_drm_cmd_buf_destroy;
    qdws->base.submit_cmd = virgl_drm_winsys_submit_cmd;
+   qdws->base.emit_fence = virgl_drm_emit_fence;
    qdws->base.emit_res = virgl_drm_emit_res;
    qdws->base.res_is_referenced = virgl_drm_res_is_ref;
 
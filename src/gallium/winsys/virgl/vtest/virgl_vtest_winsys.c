@@ -522,6 +522,15 @@ static int virgl_vtest_get_caps(struct virgl_winsys *vws,
    return virgl_vtest_send_get_caps(vtws, caps);
 }
 
+/* like the drm winsys, submitting the buffer with the fence resource
+ * attached is what arms the fence */
+static void virgl_vtest_emit_fence(struct virgl_winsys *vws,
+                                   struct virgl_cmd_buf *cbuf,
+                                   struct pipe_fence_handle *fence)
+{
+   virgl_vtest_emit_res(vws, cbuf, virgl_hw_res(fence), FALSE);
+}
+
 static struct pipe_fence_handle *
 virgl_cs_create_fence(struct virgl_winsys *vws)
 {
@@ -651,6 +660,7 @@ virgl_vtest_winsys_wrap(struct sw_winsys *sws)
    vtws->base.cmd_buf_create = virgl_vtest_cmd_buf_create;
    vtws->base.cmd_buf_destroy = virgl_vtest_cmd_buf_destroy;
    vtws->base.submit_cmd = virgl_vtest_winsys_submit_cmd;
+   vtws->base.emit_fence = virgl_vtest_emit_fence;
 
    vtws->base.emit_res = virgl_vtest_emit_res;
    vtws->base.res_is_referenced = virgl_vtest_res_is_ref;
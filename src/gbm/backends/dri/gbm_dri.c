@@ -1003,6 +1003,10 @@ static void
 gbm_dri_surface_destroy(struct gbm_surface *_surf)
 {
    struct gbm_dri_surface *surf = gbm_dri_surface(_surf);
+   struct gbm_bo *bo;
+
+   while ((bo = gbm_dri_surface_get_cached_bo(surf)) != NULL)
+      gbm_dri_bo_destroy(bo);
 
    free(surf);
 }
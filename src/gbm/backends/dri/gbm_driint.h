@@ -108,10 +108,19 @@ struct gbm_dri_bo {
    void *map;
 };
 
+/* A gbm_surface never changes size or format, so color buffers parked
+ * here when an EGL surface is torn down can be handed back verbatim to
+ * the next EGL surface created on it, instead of round-tripping through
+ * the kernel allocator.
+ */
+#define GBM_DRI_MAX_SPARE_BOS 4
+
 struct gbm_dri_surface {
    struct gbm_surface base;
 
    void *dri_private;
+
+   struct gbm_bo *spare_bos[GBM_DRI_MAX_SPARE_BOS];
 };
 
 static inline struct gbm_dri_device *
@@ -132,6 +141,49 @@ gbm_dri_surface(struct gbm_surface *surface)
    return (struct gbm_dri_surface *) surface;
 }
 
+/* Park a color buffer for reuse by a later EGL surface on the same
+ * gbm_surface.  Returns false when the buffer doesn't match the surface
+ * or all slots are taken; the caller keeps ownership and should destroy
+ * the buffer as usual.  Usage flags are not checked because every buffer
+ * allocated for a surface is created with the surface's own flags.
+ */
+static inline int
+gbm_dri_surface_cache_bo(struct gbm_dri_surface *surf, struct gbm_bo *bo)
+{
+   unsigned i;
+
+   if (bo->width != surf->base.width ||
+       bo->height != surf->base.height ||
+       bo->format != surf->base.format)
+      return 0;
+
+   for (i = 0; i < GBM_DRI_MAX_SPARE_BOS; i++) {
+      if (surf->spare_bos[i] == NULL) {
+         surf->spare_bos[i] = bo;
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+static inline struct gbm_bo *
+gbm_dri_surface_get_cached_bo(struct gbm_dri_surface *surf)
+{
+   unsigned i;
+   struct gbm_bo *bo;
+
+   for (i = 0; i < GBM_DRI_MAX_SPARE_BOS; i++) {
+      if (surf->spare_bos[i] != NULL) {
+         bo = surf->spare_bos[i];
+         surf->spare_bos[i] = NULL;
+         return bo;
+      }
+   }
+
+   return NULL;
+}
+
 static inline void *
 gbm_dri_bo_map_dumb(struct gbm_dri_bo *bo)
 {
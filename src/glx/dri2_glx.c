@@ -41,6 +41,7 @@
 #include <X11/extensions/dri2proto.h>
 #include <dlfcn.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/mman.h>
@@ -75,6 +76,18 @@ struct dri2_display
    __glxHashTable *dri2Hash;
 
    const __DRIextension *loader_extensions[4];
+
+   /* Optional thread that reaps swap replies off the render thread, see
+    * dri2XcbSwapBuffers.  At most one swap is in flight at a time;
+    * swapWork points at the drawable whose reply is owed.  All of this is
+    * guarded by swapMutex.
+    */
+   Bool swapThreadEnabled;
+   Bool swapThreadShutdown;
+   pthread_t swapThread;
+   pthread_mutex_t swapMutex;
+   pthread_cond_t swapCond;
+   struct dri2_drawable *swapWork;
 };
 
 struct dri2_drawable
@@ -88,12 +101,18 @@ struct dri2_drawable
    int have_fake_front;
    int swap_interval;
 
+   /* Swap handed to the swap thread, still waiting for its reply */
+   Bool swap_pending;
+   xcb_dri2_swap_buffers_cookie_t swap_cookie;
+
    uint64_t previous_time;
    unsigned frames;
 };
 
 static const struct glx_context_vtable dri2_context_vtable;
 
+static void dri2WaitPendingSwap(struct dri2_drawable *priv);
+
 /* For XCB's handling of ust/msc/sbc counters, we have to hand it the high and
  * low halves separately.  This helps you split them.
  */
@@ -339,6 +358,8 @@ dri2DestroyDrawable(__GLXDRIdrawable *base)
    struct glx_display *dpyPriv = psc->base.display;
    struct dri2_display *pdp = (struct dri2_display *)dpyPriv->dri2Display;
 
+   dri2WaitPendingSwap(pdraw);
+
    __glxHashDelete(pdp->dri2Hash, pdraw->base.xDrawable);
    (*psc->core->destroyDrawable) (pdraw->driDrawable);
 
@@ -461,6 +482,8 @@ dri2WaitForMSC(__GLXDRIdrawable *pdraw, int64_t target_msc, int64_t divisor,
    uint32_t divisor_hi, divisor_lo;
    uint32_t remainder_hi, remainder_lo;
 
+   dri2WaitPendingSwap((struct dri2_drawable *) pdraw);
+
    split_counter(target_msc, &target_msc_hi, &target_msc_lo);
    split_counter(divisor, &divisor_hi, &divisor_lo);
    split_counter(remainder, &remainder_hi, &remainder_lo);
@@ -491,6 +514,8 @@ dri2WaitForSBC(__GLXDRIdrawable *pdraw, int64_t target_sbc, int64_t *ust,
    xcb_dri2_wait_sbc_reply_t *wait_sbc_reply;
    uint32_t target_sbc_hi, target_sbc_lo;
 
+   dri2WaitPendingSwap((struct dri2_drawable *) pdraw);
+
    split_counter(target_sbc, &target_sbc_hi, &target_sbc_lo);
 
    wait_sbc_cookie = xcb_dri2_wait_sbc_unchecked(c, pdraw->xDrawable,
@@ -578,6 +603,8 @@ __dri2CopySubBuffer(__GLXDRIdrawable *pdraw, int x, int y,
    if (!priv->have_back)
       return;
 
+   dri2WaitPendingSwap(priv);
+
    xrect.x = x;
    xrect.y = priv->height - y - height;
    xrect.width = width;
@@ -772,6 +799,73 @@ static void show_fps(struct dri2_drawable *draw)
    }
 }
 
+static struct dri2_display *
+dri2GetDisplay(struct dri2_drawable *priv)
+{
+   struct glx_display *dpyPriv = priv->base.psc->display;
+
+   return (struct dri2_display *) dpyPriv->dri2Display;
+}
+
+/* Wait until the swap thread has reaped the reply of the last swap issued
+ * for this drawable, and with it the invalidate events of that swap.
+ */
+static void
+dri2WaitPendingSwap(struct dri2_drawable *priv)
+{
+   struct dri2_display *pdp = dri2GetDisplay(priv);
+
+   if (!pdp->swapThreadEnabled)
+      return;
+
+   pthread_mutex_lock(&pdp->swapMutex);
+   while (priv->swap_pending)
+      pthread_cond_wait(&pdp->swapCond, &pdp->swapMutex);
+   pthread_mutex_unlock(&pdp->swapMutex);
+}
+
+static void *
+dri2SwapThread(void *arg)
+{
+   struct dri2_display *pdp = arg;
+
+   pthread_mutex_lock(&pdp->swapMutex);
+   for (;;) {
+      struct dri2_drawable *priv = pdp->swapWork;
+      xcb_dri2_swap_buffers_reply_t *swap_buffers_reply;
+      Display *dpy;
+
+      if (priv == NULL) {
+         if (pdp->swapThreadShutdown)
+            break;
+         pthread_cond_wait(&pdp->swapCond, &pdp->swapMutex);
+         continue;
+      }
+      pthread_mutex_unlock(&pdp->swapMutex);
+
+      dpy = priv->base.psc->dpy;
+
+      /* Reap the invalidate events through the event filter first, so
+       * the next drawing doesn't use an invalidated buffer, then wait
+       * for the swap reply; see dri2XcbSwapBuffers.
+       */
+      XSync(dpy, False);
+
+      swap_buffers_reply =
+         xcb_dri2_swap_buffers_reply(XGetXCBConnection(dpy),
+                                     priv->swap_cookie, NULL);
+      free(swap_buffers_reply);
+
+      pthread_mutex_lock(&pdp->swapMutex);
+      pdp->swapWork = NULL;
+      priv->swap_pending = False;
+      pthread_cond_broadcast(&pdp->swapCond);
+   }
+   pthread_mutex_unlock(&pdp->swapMutex);
+
+   return NULL;
+}
+
 static int64_t
 dri2XcbSwapBuffers(Display *dpy,
                   __GLXDRIdrawable *pdraw,
@@ -779,6 +873,8 @@ dri2XcbSwapBuffers(Display *dpy,
                   int64_t divisor,
                   int64_t remainder)
 {
+   struct dri2_drawable *priv = (struct dri2_drawable *) pdraw;
+   struct dri2_display *pdp = dri2GetDisplay(priv);
    xcb_dri2_swap_buffers_cookie_t swap_buffers_cookie;
    xcb_dri2_swap_buffers_reply_t *swap_buffers_reply;
    uint32_t target_msc_hi, target_msc_lo;
@@ -787,6 +883,9 @@ dri2XcbSwapBuffers(Display *dpy,
    int64_t ret = 0;
    xcb_connection_t *c = XGetXCBConnection(dpy);
 
+   /* Never more than one swap in flight per drawable */
+   dri2WaitPendingSwap(priv);
+
    split_counter(target_msc, &target_msc_hi, &target_msc_lo);
    split_counter(divisor, &divisor_hi, &divisor_lo);
    split_counter(remainder, &remainder_hi, &remainder_lo);
@@ -797,6 +896,26 @@ dri2XcbSwapBuffers(Display *dpy,
                                       divisor_hi, divisor_lo,
                                       remainder_hi, remainder_lo);
 
+   /* Hand the reply to the swap thread, so the render thread can start
+    * on the next frame while the server dispatches this swap.  The OML
+    * paths need the real swap count from the reply and stay synchronous.
+    */
+   if (pdp->swapThreadEnabled &&
+       target_msc == 0 && divisor == 0 && remainder == 0) {
+      xcb_flush(c);
+
+      pthread_mutex_lock(&pdp->swapMutex);
+      while (pdp->swapWork != NULL)
+         pthread_cond_wait(&pdp->swapCond, &pdp->swapMutex);
+      priv->swap_cookie = swap_buffers_cookie;
+      priv->swap_pending = True;
+      pdp->swapWork = priv;
+      pthread_cond_broadcast(&pdp->swapCond);
+      pthread_mutex_unlock(&pdp->swapMutex);
+
+      return ret;
+   }
+
    /* Immediately wait on the swapbuffers reply.  If we didn't, we'd have
     * to do so some time before reusing a (non-pageflipped) backbuffer.
     * Otherwise, the new rendering could get ahead of the X Server's
@@ -868,6 +987,11 @@ dri2GetBuffers(__DRIdrawable * driDrawable,
    struct dri2_drawable *pdraw = loaderPrivate;
    DRI2Buffer *buffers;
 
+   /* Make sure a pending swap has been dispatched by the server before
+    * fetching the buffers it may have exchanged.
+    */
+   dri2WaitPendingSwap(pdraw);
+
    buffers = DRI2GetBuffers(pdraw->base.psc->dpy, pdraw->base.xDrawable,
                             width, height, attachments, count, out_count);
    if (buffers == NULL)
@@ -891,6 +1015,8 @@ dri2GetBuffersWithFormat(__DRIdrawable * driDrawable,
    struct dri2_drawable *pdraw = loaderPrivate;
    DRI2Buffer *buffers;
 
+   dri2WaitPendingSwap(pdraw);
+
    buffers = DRI2GetBuffersWithFormat(pdraw->base.psc->dpy,
                                       pdraw->base.xDrawable,
                                       width, height, attachments,
@@ -1340,6 +1466,16 @@ dri2DestroyDisplay(__GLXDRIdisplay * dpy)
 {
    struct dri2_display *pdp = (struct dri2_display *) dpy;
 
+   if (pdp->swapThreadEnabled) {
+      pthread_mutex_lock(&pdp->swapMutex);
+      pdp->swapThreadShutdown = True;
+      pthread_cond_broadcast(&pdp->swapCond);
+      pthread_mutex_unlock(&pdp->swapMutex);
+      pthread_join(pdp->swapThread, NULL);
+      pthread_mutex_destroy(&pdp->swapMutex);
+      pthread_cond_destroy(&pdp->swapCond);
+   }
+
    __glxHashDestroy(pdp->dri2Hash);
    free(dpy);
 }
@@ -1405,6 +1541,25 @@ dri2CreateDisplay(Display * dpy)
       return NULL;
    }
 
+   /* Reaping swap replies on a separate thread makes SwapBuffers return
+    * without a server round trip, but Xlib is only usable from multiple
+    * threads when the application has called XInitThreads(), which we
+    * cannot detect, so the thread is opt-in.
+    */
+   pdp->swapThreadEnabled = False;
+   if (pdp->swapAvailable && getenv("LIBGL_ASYNC_SWAP")) {
+      pdp->swapThreadShutdown = False;
+      pdp->swapWork = NULL;
+      pthread_mutex_init(&pdp->swapMutex, NULL);
+      pthread_cond_init(&pdp->swapCond, NULL);
+      if (pthread_create(&pdp->swapThread, NULL, dri2SwapThread, pdp) == 0) {
+         pdp->swapThreadEnabled = True;
+      } else {
+         pthread_mutex_destroy(&pdp->swapMutex);
+         pthread_cond_destroy(&pdp->swapCond);
+      }
+   }
+
    return &pdp->base;
 }
 
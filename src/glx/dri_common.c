@@ -102,6 +102,11 @@ driOpenDriver(const char *driverName)
    char realDriverName[200];
    int len;
 
+   /* another display connection may have located the driver already */
+   handle = loader_open_cached_driver(driverName);
+   if (handle)
+      return handle;
+
    /* Attempt to make sure libGL symbols will be visible to the driver */
    glhandle = dlopen(GL_LIB_NAME, RTLD_NOW | RTLD_GLOBAL);
 
@@ -147,7 +152,9 @@ driOpenDriver(const char *driverName)
          InfoMessageF("dlopen %s failed (%s)\n", realDriverName, dlerror());
    }
 
-   if (!handle)
+   if (handle)
+      loader_cache_driver(driverName, realDriverName);
+   else
       ErrorMessageF("unable to load driver: %s_dri.so\n", driverName);
 
    if (glhandle)
@@ -646,6 +646,12 @@ struct isl_format_layout {
       struct isl_channel_layout p; /**< Palette channel */
    } channels;
 
+   /** Bitmask of (1 << isl_base_type) over all channels present in the
+    * format, precomputed by the table generator so that queries such as
+    * isl_format_has_sint_channel() need not scan the channels.
+    */
+   uint16_t channel_type_mask;
+
    enum isl_colorspace colorspace;
    enum isl_txc txc;
 };
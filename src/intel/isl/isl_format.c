@@ -416,13 +416,7 @@ isl_format_has_channel_type(enum isl_format fmt, enum isl_base_type type)
 {
    const struct isl_format_layout *fmtl = isl_format_get_layout(fmt);
 
-   return fmtl->channels.r.type == type ||
-          fmtl->channels.g.type == type ||
-          fmtl->channels.b.type == type ||
-          fmtl->channels.a.type == type ||
-          fmtl->channels.l.type == type ||
-          fmtl->channels.i.type == type ||
-          fmtl->channels.p.type == type;
+   return fmtl->channel_type_mask & (1 << type);
 }
 
 bool
@@ -96,6 +96,17 @@ do
     : ${colorspace:=ISL_COLORSPACE_NONE}
     : ${txc:=ISL_TXC_NONE}
 
+    # Precompute the channel type mask. Duplicate terms are harmless; the
+    # compiler folds the expression to a constant.
+    channel_type_mask="0"
+    for channel in "$red" "$green" "$blue" "$alpha" \
+                   "$luminance" "$intensity" "$palette"
+    do
+        if [[ -n $channel ]]; then
+            channel_type_mask="$channel_type_mask | (1 << ${channel%@*})"
+        fi
+    done
+
     cat <<EOF
    [$format] = {
       .format = $format,
@@ -111,6 +122,7 @@ do
           .i = { $intensity },
           .p = { $palette },
       },
+      .channel_type_mask = $channel_type_mask,
       .colorspace = $colorspace,
       .txc = $txc,
    },
@@ -533,6 +533,32 @@ anv_block_pool_alloc(struct anv_block_pool *pool)
    return anv_block_pool_alloc_new(pool, &pool->state);
 }
 
+/* Grabs up to \a count blocks for a caller that expects to need several,
+ * such as a state stream.  We take as many blocks as we can off the free
+ * list in one pass so that concurrent callers hit the shared list head
+ * less often, and only fall back to fresh pool space when the list runs
+ * dry.  At least one block is always returned.
+ */
+static uint32_t
+anv_block_pool_alloc_n(struct anv_block_pool *pool,
+                       int32_t *blocks, uint32_t count)
+{
+   uint32_t n = 0;
+
+   while (n < count &&
+          anv_free_list_pop(&pool->free_list, &pool->map, &blocks[n])) {
+      assert(blocks[n] >= 0);
+      n++;
+   }
+
+   if (n == 0)
+      blocks[n++] = anv_block_pool_alloc_new(pool, &pool->state);
+
+   assert(pool->map);
+
+   return n;
+}
+
 /* Allocates a block out of the back of the block pool.
  *
  * This will allocated a block earlier than the "start" of the block pool.
@@ -712,6 +738,8 @@ anv_state_stream_init(struct anv_state_stream *stream,
    stream->next = 1;
    stream->end = 0;
 
+   stream->num_cached_blocks = 0;
+
    VG(VALGRIND_CREATE_MEMPOOL(stream, 0, false));
 }
 
@@ -730,6 +758,11 @@ anv_state_stream_finish(struct anv_state_stream *stream)
       next = sb.next;
    }
 
+   /* Give back the blocks we fetched ahead of need but never used. */
+   for (uint32_t i = 0; i < stream->num_cached_blocks; i++)
+      anv_block_pool_free(stream->block_pool, stream->cached_blocks[i]);
+   stream->num_cached_blocks = 0;
+
    VG(VALGRIND_DESTROY_MEMPOOL(stream));
 }
 
@@ -743,7 +776,13 @@ anv_state_stream_alloc(struct anv_state_stream *stream,
 
    state.offset = align_u32(stream->next, alignment);
    if (state.offset + size > stream->end) {
-      uint32_t block = anv_block_pool_alloc(stream->block_pool);
+      if (stream->num_cached_blocks == 0) {
+         stream->num_cached_blocks =
+            anv_block_pool_alloc_n(stream->block_pool, stream->cached_blocks,
+                                   ANV_STATE_STREAM_BLOCK_CACHE_SIZE);
+      }
+
+      uint32_t block = stream->cached_blocks[--stream->num_cached_blocks];
       sb = stream->block_pool->map + block;
 
       VG(VALGRIND_MAKE_MEM_UNDEFINED(sb, sizeof(*sb)));
@@ -732,10 +732,11 @@ anv_cmd_buffer_end_batch_buffer(struct anv_cmd_buffer *cmd_buffer)
       if (!cmd_buffer->device->can_chain_batches) {
          cmd_buffer->exec_mode = ANV_CMD_BUFFER_EXEC_MODE_GROW_AND_EMIT;
       } else if ((cmd_buffer->batch_bos.next == cmd_buffer->batch_bos.prev) &&
-          (batch_bo->length < ANV_CMD_BUFFER_BATCH_SIZE / 2)) {
+          (batch_bo->length < ANV_CMD_BUFFER_BATCH_COPY_THRESHOLD)) {
          /* If the secondary has exactly one batch buffer in its list *and*
-          * that batch buffer is less than half of the maximum size, we're
-          * probably better of simply copying it into our batch.
+          * that batch buffer is tiny, we're better off simply copying it
+          * into our batch. Everything else is chained to keep
+          * vkCmdExecuteCommands O(1) per secondary.
           */
          cmd_buffer->exec_mode = ANV_CMD_BUFFER_EXEC_MODE_EMIT;
       } else if (!(cmd_buffer->usage_flags &
@@ -975,12 +976,24 @@ read_reloc(const struct anv_device *device, const void *p)
 }
 
 static void
-write_reloc(const struct anv_device *device, void *p, uint64_t v)
+write_reloc(const struct anv_device *device, void *p, uint64_t v, bool flush)
 {
+   unsigned reloc_size = device->info.gen >= 8 ? sizeof(uint64_t) :
+                                                 sizeof(uint32_t);
+
    if (device->info.gen >= 8)
       *(uint64_t *)p = v;
    else
       *(uint32_t *)p = v;
+
+   if (flush && !device->info.has_llc) {
+      void *l = (void *) (((uintptr_t) p) & ~CACHELINE_MASK);
+      __builtin_ia32_mfence();
+      while (l < p + reloc_size) {
+         __builtin_ia32_clflush(l);
+         l += CACHELINE_SIZE;
+      }
+   }
 }
 
 static void
@@ -1046,7 +1059,7 @@ adjust_relocations_to_block_pool(struct anv_block_pool *pool,
          assert(relocs->relocs[i].offset < from_bo->size);
          write_reloc(pool->device, from_bo->map + relocs->relocs[i].offset,
                      relocs->relocs[i].presumed_offset +
-                     relocs->relocs[i].delta);
+                     relocs->relocs[i].delta, false);
       }
    }
 
@@ -1137,3 +1150,93 @@ anv_cmd_buffer_prepare_execbuf(struct anv_cmd_buffer *cmd_buffer)
    if (!cmd_buffer->execbuf2.need_reloc)
       cmd_buffer->execbuf2.execbuf.flags |= I915_EXEC_NO_RELOC;
 }
+
+/* Walk the list of relocations of a batch BO we own and rewrite any stale
+ * relocated values in place. Since the CPU is the only thing that writes
+ * these BOs, the values can be brought up to date without kernel help.
+ */
+static void
+anv_reloc_list_apply(struct anv_device *device,
+                     struct anv_reloc_list *list,
+                     struct anv_bo *bo)
+{
+   for (size_t i = 0; i < list->num_relocs; i++) {
+      struct anv_bo *target_bo = list->reloc_bos[i];
+
+      if (list->relocs[i].presumed_offset == target_bo->offset)
+         continue;
+
+      assert(list->relocs[i].offset < bo->size);
+      write_reloc(device, bo->map + list->relocs[i].offset,
+                  target_bo->offset + list->relocs[i].delta, true);
+      list->relocs[i].presumed_offset = target_bo->offset;
+   }
+}
+
+static bool
+anv_reloc_list_is_current(const struct anv_reloc_list *list)
+{
+   for (size_t i = 0; i < list->num_relocs; i++) {
+      if (list->relocs[i].presumed_offset != list->reloc_bos[i]->offset)
+         return false;
+   }
+
+   return true;
+}
+
+/* Try to perform all of a command buffer's relocations on the CPU, so that
+ * the kernel can skip relocation processing for its execbuf. Returns true
+ * on success, in which case I915_EXEC_NO_RELOC may be set.
+ */
+bool
+anv_cmd_buffer_relocate(struct anv_cmd_buffer *cmd_buffer)
+{
+   /* Surface states live in a block pool that is shared by all command
+    * buffers and may have been recentered since this command buffer was
+    * recorded, so we can't safely rewrite them here. If any of them have
+    * gone stale, let the kernel process the relocations.
+    */
+   if (!anv_reloc_list_is_current(&cmd_buffer->surface_relocs))
+      return false;
+
+   /* The batch BOs are only ever written by this command buffer, so stale
+    * relocated values can simply be rewritten in place.
+    */
+   struct anv_batch_bo **bbo;
+   anv_vector_foreach(bbo, &cmd_buffer->seen_bbos)
+      anv_reloc_list_apply(cmd_buffer->device, &(*bbo)->relocs, &(*bbo)->bo);
+
+   /* Now that the batch contents match the presumed offsets, tell the
+    * kernel where we expect every BO to be placed. If none of them have
+    * to move, it can skip relocation processing altogether.
+    */
+   for (uint32_t i = 0; i < cmd_buffer->execbuf2.bo_count; i++) {
+      cmd_buffer->execbuf2.objects[i].offset =
+         cmd_buffer->execbuf2.bos[i]->offset;
+   }
+
+   return true;
+}
+
+/* Called after a successful execbuf, with the BO offsets returned by the
+ * kernel already copied back. Whether the relocations were processed by the
+ * kernel or in userspace, every relocated value now matches the target BO's
+ * current offset, so record that in the presumed offsets rather than relying
+ * on the kernel writing them back.
+ */
+void
+anv_cmd_buffer_mark_relocs_current(struct anv_cmd_buffer *cmd_buffer)
+{
+   for (size_t i = 0; i < cmd_buffer->surface_relocs.num_relocs; i++) {
+      cmd_buffer->surface_relocs.relocs[i].presumed_offset =
+         cmd_buffer->surface_relocs.reloc_bos[i]->offset;
+   }
+
+   struct anv_batch_bo **bbo;
+   anv_vector_foreach(bbo, &cmd_buffer->seen_bbos) {
+      struct anv_reloc_list *relocs = &(*bbo)->relocs;
+
+      for (size_t i = 0; i < relocs->num_relocs; i++)
+         relocs->relocs[i].presumed_offset = relocs->reloc_bos[i]->offset;
+   }
+}
@@ -783,6 +783,44 @@ anv_device_submit_simple_batch(struct anv_device *device,
    return result;
 }
 
+struct anv_bo_reclaim_entry {
+   struct list_head link;
+   struct anv_bo bo;
+};
+
+static void *
+anv_device_reclaim_thread(void *_device)
+{
+   struct anv_device *device = _device;
+
+   pthread_mutex_lock(&device->reclaim_mutex);
+   while (true) {
+      while (list_empty(&device->reclaim_list)) {
+         if (device->reclaim_thread_exit) {
+            pthread_mutex_unlock(&device->reclaim_mutex);
+            return NULL;
+         }
+         pthread_cond_wait(&device->reclaim_cond, &device->reclaim_mutex);
+      }
+
+      /* Grab the whole batch so the ioctls run without the lock held. */
+      struct list_head bos;
+      list_replace(&device->reclaim_list, &bos);
+      list_inithead(&device->reclaim_list);
+      pthread_mutex_unlock(&device->reclaim_mutex);
+
+      list_for_each_entry_safe(struct anv_bo_reclaim_entry, entry,
+                               &bos, link) {
+         if (entry->bo.map)
+            anv_gem_munmap(entry->bo.map, entry->bo.size);
+         anv_gem_close(device, entry->bo.gem_handle);
+         anv_free(&device->alloc, entry);
+      }
+
+      pthread_mutex_lock(&device->reclaim_mutex);
+   }
+}
+
 VkResult anv_CreateDevice(
     VkPhysicalDevice                            physicalDevice,
     const VkDeviceCreateInfo*                   pCreateInfo,
@@ -853,6 +891,14 @@ VkResult anv_CreateDevice(
 
    pthread_mutex_init(&device->mutex, NULL);
 
+   pthread_mutex_init(&device->reclaim_mutex, NULL);
+   pthread_cond_init(&device->reclaim_cond, NULL);
+   list_inithead(&device->reclaim_list);
+   device->reclaim_thread_exit = false;
+   device->reclaim_thread_running =
+      pthread_create(&device->reclaim_thread, NULL,
+                     anv_device_reclaim_thread, device) == 0;
+
    anv_bo_pool_init(&device->batch_bo_pool, device);
 
    anv_block_pool_init(&device->dynamic_state_block_pool, device, 16384);
@@ -923,6 +969,19 @@ void anv_DestroyDevice(
 
    anv_device_finish_meta(device);
 
+   /* The reclaim thread drains its queue before exiting, so after the join
+    * all pending GEM handles have been closed.
+    */
+   if (device->reclaim_thread_running) {
+      pthread_mutex_lock(&device->reclaim_mutex);
+      device->reclaim_thread_exit = true;
+      pthread_cond_signal(&device->reclaim_cond);
+      pthread_mutex_unlock(&device->reclaim_mutex);
+      pthread_join(device->reclaim_thread, NULL);
+   }
+   pthread_cond_destroy(&device->reclaim_cond);
+   pthread_mutex_destroy(&device->reclaim_mutex);
+
 #ifdef HAVE_VALGRIND
    /* We only need to free these to prevent valgrind errors.  The backing
     * BO will go away in a couple of lines so we don't actually leak.
@@ -1042,6 +1101,16 @@ VkResult anv_QueueSubmit(
                          pSubmits[i].pCommandBuffers[j]);
          assert(cmd_buffer->level == VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
+         /* Perform the relocations on the CPU if we can, so that the
+          * kernel skips relocation processing for this execbuf. The
+          * relocations may have gone stale since the command buffer was
+          * recorded or last submitted.
+          */
+         if (anv_cmd_buffer_relocate(cmd_buffer))
+            cmd_buffer->execbuf2.execbuf.flags |= I915_EXEC_NO_RELOC;
+         else
+            cmd_buffer->execbuf2.execbuf.flags &= ~I915_EXEC_NO_RELOC;
+
          ret = anv_gem_execbuffer(device, &cmd_buffer->execbuf2.execbuf);
          if (ret != 0) {
             /* We don't know the real error. */
@@ -1051,6 +1120,8 @@ VkResult anv_QueueSubmit(
 
          for (uint32_t k = 0; k < cmd_buffer->execbuf2.bo_count; k++)
             cmd_buffer->execbuf2.bos[k]->offset = cmd_buffer->execbuf2.objects[k].offset;
+
+         anv_cmd_buffer_mark_relocs_current(cmd_buffer);
       }
    }
 
@@ -1165,6 +1236,29 @@ void anv_FreeMemory(
    if (mem == NULL)
       return;
 
+   /* Hand the BO to the reclaim thread: munmap and the GEM close ioctl can
+    * take a while and vkFreeMemory tends to get called mid-frame.  There is
+    * no need to wait for the GPU here; the kernel keeps the object alive
+    * until all batches referencing it have retired.  If the thread isn't
+    * running or we can't allocate a queue entry, just pay for the close on
+    * this thread as before.
+    */
+   if (device->reclaim_thread_running && mem->bo.gem_handle != 0) {
+      struct anv_bo_reclaim_entry *entry =
+         anv_alloc(&device->alloc, sizeof(*entry), 8,
+                   VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+      if (entry) {
+         entry->bo = mem->bo;
+         pthread_mutex_lock(&device->reclaim_mutex);
+         list_addtail(&entry->link, &device->reclaim_list);
+         pthread_cond_signal(&device->reclaim_cond);
+         pthread_mutex_unlock(&device->reclaim_mutex);
+
+         anv_free2(&device->alloc, pAllocator, mem);
+         return;
+      }
+   }
+
    if (mem->bo.map)
       anv_gem_munmap(mem->bo.map, mem->bo.size);
 
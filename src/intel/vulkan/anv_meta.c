@@ -126,9 +126,20 @@ meta_free(void* _device, void *data)
    return device->alloc.pfnFree(device->alloc.pUserData, data);
 }
 
+static void *
+meta_init_clear_state(void *_device)
+{
+   struct anv_device *device = _device;
+
+   return (void *)(uintptr_t) anv_device_init_meta_clear_state(device);
+}
+
 VkResult
 anv_device_init_meta(struct anv_device *device)
 {
+   pthread_t clear_thread;
+   bool clear_async;
+   VkResult clear_result = VK_SUCCESS;
    VkResult result;
 
    device->meta_state.alloc = (VkAllocationCallbacks) {
@@ -138,9 +149,17 @@ anv_device_init_meta(struct anv_device *device)
       .pfnFree = meta_free,
    };
 
-   result = anv_device_init_meta_clear_state(device);
-   if (result != VK_SUCCESS)
-      goto fail_clear;
+   /* The clear pipeline matrix (every sample count times every attachment
+    * count) is by far the biggest chunk of compilation here, so build it on
+    * a second thread while this one sets up the blit and resolve state.
+    * This is safe because everything below allocates through the device's
+    * lock-free pools and the default pipeline cache, which takes its own
+    * mutex.  If the thread can't be created, just compile everything here.
+    */
+   clear_async = pthread_create(&clear_thread, NULL,
+                                meta_init_clear_state, device) == 0;
+   if (!clear_async)
+      clear_result = anv_device_init_meta_clear_state(device);
 
    result = anv_device_init_meta_resolve_state(device);
    if (result != VK_SUCCESS)
@@ -154,15 +173,34 @@ anv_device_init_meta(struct anv_device *device)
    if (result != VK_SUCCESS)
       goto fail_blit2d;
 
+   if (clear_async) {
+      void *thread_result;
+      pthread_join(clear_thread, &thread_result);
+      clear_result = (VkResult)(uintptr_t) thread_result;
+      clear_async = false;
+   }
+   if (clear_result != VK_SUCCESS) {
+      result = clear_result;
+      goto fail_clear;
+   }
+
    return VK_SUCCESS;
 
+fail_clear:
+   anv_device_finish_meta_blit2d_state(device);
 fail_blit2d:
    anv_device_finish_meta_blit_state(device);
 fail_blit:
    anv_device_finish_meta_resolve_state(device);
 fail_resolve:
-   anv_device_finish_meta_clear_state(device);
-fail_clear:
+   if (clear_async) {
+      void *thread_result;
+      pthread_join(clear_thread, &thread_result);
+      clear_result = (VkResult)(uintptr_t) thread_result;
+   }
+   /* On failure, init_meta_clear_state cleans up after itself. */
+   if (clear_result == VK_SUCCESS)
+      anv_device_finish_meta_clear_state(device);
    return result;
 }
 
@@ -60,6 +60,17 @@ VkResult anv_CreateShaderModule(
    module->size = pCreateInfo->codeSize;
    memcpy(module->data, pCreateInfo->pCode, module->size);
 
+   /* Index the module structure up front so that compiling N pipelines
+    * from it doesn't rediscover it N times.  This quietly returns NULL
+    * for anything that isn't a well-formed SPIR-V header, in which case
+    * spirv_to_nir falls back to walking the whole module.
+    */
+   module->index = NULL;
+   if (module->size % 4 == 0) {
+      module->index = spirv_module_index_create((uint32_t *)module->data,
+                                                module->size / 4);
+   }
+
    _mesa_sha1_compute(module->data, module->size, module->sha1);
 
    *pShaderModule = anv_shader_module_to_handle(module);
@@ -75,6 +86,7 @@ void anv_DestroyShaderModule(
    ANV_FROM_HANDLE(anv_device, device, _device);
    ANV_FROM_HANDLE(anv_shader_module, module, _module);
 
+   spirv_module_index_destroy(module->index);
    anv_free2(&device->alloc, pAllocator, module);
 }
 
@@ -135,7 +147,8 @@ anv_shader_compile_to_nir(struct anv_device *device,
 
       entry_point = spirv_to_nir(spirv, module->size / 4,
                                  spec_entries, num_spec_entries,
-                                 stage, entrypoint_name, nir_options);
+                                 stage, entrypoint_name, nir_options,
+                                 module->index);
       nir = entry_point->shader;
       assert(nir->stage == stage);
       nir_validate_shader(nir);
@@ -354,6 +354,30 @@ anv_pipeline_cache_load(struct anv_pipeline_cache *cache,
    void *end = (void *) data + size;
    void *p = (void *) data + header.header_size;
 
+   /* Count the entries up front, both to validate the blob (a truncated
+    * final entry is ignored) and to size the hash table before inserting
+    * anything. Growing the table while loading would rehash all previously
+    * loaded entries on every doubling, which adds up for large caches.
+    */
+   uint32_t count = 0;
+   void *q = p;
+   while (q + sizeof(struct cache_entry) <= end) {
+      struct cache_entry *entry = q;
+      void *next = q + entry_size(entry) + entry->kernel_size;
+
+      if (next > end)
+         break;
+
+      q = next;
+      count++;
+   }
+   end = q;
+
+   while (cache->table_size > 0 && count >= cache->table_size / 2) {
+      if (anv_pipeline_cache_grow(cache) != VK_SUCCESS)
+         break;
+   }
+
    while (p < end) {
       struct cache_entry *entry = p;
 
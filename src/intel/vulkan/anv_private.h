@@ -53,6 +53,7 @@ typedef uint32_t xcb_visualid_t;
 typedef uint32_t xcb_window_t;
 
 struct anv_l3_config;
+struct spirv_module_index;
 
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_intel.h>
@@ -405,6 +406,8 @@ struct anv_state_pool {
 
 struct anv_state_stream_block;
 
+#define ANV_STATE_STREAM_BLOCK_CACHE_SIZE 4
+
 struct anv_state_stream {
    struct anv_block_pool *block_pool;
 
@@ -417,6 +420,14 @@ struct anv_state_stream {
    uint32_t next;
    /* Offset at which the current block ends */
    uint32_t end;
+
+   /* Blocks taken from the pool free list in batches ahead of need, so
+    * that a recording thread only touches the shared list head once per
+    * few blocks. Unused blocks go back to the pool when the stream is
+    * finished.
+    */
+   int32_t cached_blocks[ANV_STATE_STREAM_BLOCK_CACHE_SIZE];
+   uint32_t num_cached_blocks;
 };
 
 #define CACHELINE_SIZE 64
@@ -703,6 +714,17 @@ struct anv_device {
     uint32_t                                    default_mocs;
 
     pthread_mutex_t                             mutex;
+
+    /* BOs freed with vkFreeMemory are queued here and closed in batches on
+     * a worker thread so that munmap and the GEM close ioctl stay off the
+     * application's frame-critical threads.
+     */
+    pthread_mutex_t                             reclaim_mutex;
+    pthread_cond_t                              reclaim_cond;
+    struct list_head                            reclaim_list;
+    pthread_t                                   reclaim_thread;
+    bool                                        reclaim_thread_exit;
+    bool                                        reclaim_thread_running;
 };
 
 void anv_device_get_cache_uuid(void *uuid);
@@ -1203,6 +1225,12 @@ struct anv_cmd_pool {
 
 #define ANV_CMD_BUFFER_BATCH_SIZE 8192
 
+/* Secondary command buffers smaller than this are copied into the primary
+ * instead of chained with MI_BATCH_BUFFER_START. For tiny batches the copy
+ * is cheaper than the relocation and execbuf bookkeeping of chaining.
+ */
+#define ANV_CMD_BUFFER_BATCH_COPY_THRESHOLD 512
+
 enum anv_cmd_buffer_exec_mode {
    ANV_CMD_BUFFER_EXEC_MODE_PRIMARY,
    ANV_CMD_BUFFER_EXEC_MODE_EMIT,
@@ -1280,6 +1308,8 @@ void anv_cmd_buffer_end_batch_buffer(struct anv_cmd_buffer *cmd_buffer);
 void anv_cmd_buffer_add_secondary(struct anv_cmd_buffer *primary,
                                   struct anv_cmd_buffer *secondary);
 void anv_cmd_buffer_prepare_execbuf(struct anv_cmd_buffer *cmd_buffer);
+bool anv_cmd_buffer_relocate(struct anv_cmd_buffer *cmd_buffer);
+void anv_cmd_buffer_mark_relocs_current(struct anv_cmd_buffer *cmd_buffer);
 
 VkResult anv_cmd_buffer_emit_binding_table(struct anv_cmd_buffer *cmd_buffer,
                                            unsigned stage, struct anv_state *bt_state);
@@ -1351,6 +1381,11 @@ struct nir_shader;
 struct anv_shader_module {
    struct nir_shader *                          nir;
 
+   /* Structural index of the SPIR-V blob, built once at module creation
+    * and shared by every pipeline compiled from this module.
+    */
+   struct spirv_module_index *                  index;
+
    unsigned char                                sha1[20];
    uint32_t                                     size;
    char                                         data[0];
@@ -1395,6 +1430,15 @@ struct anv_pipeline_bind_map {
 
 struct anv_pipeline {
    struct anv_device *                          device;
+
+   /* All state that is fixed at pipeline creation time (vertex elements,
+    * blend, URB setup, shader stage enables, ...) is packed into this
+    * batch when the pipeline is created, so that binding the pipeline is
+    * a single copy of the pre-packed dwords into the command buffer.
+    * Packets that mix pipeline and dynamic state keep their pre-packed
+    * pipeline half in the per-gen structs below and are combined with the
+    * dynamic half at record time with anv_batch_emit_merge().
+    */
    struct anv_batch                             batch;
    uint32_t                                     batch_data[512];
    struct anv_reloc_list                        batch_relocs;
@@ -69,12 +69,13 @@
 #include <sys/stat.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <dlfcn.h>
+#include <pthread.h>
 #ifdef HAVE_LIBUDEV
 #include <assert.h>
-#include <dlfcn.h>
 #include <unistd.h>
-#include <stdlib.h>
 #ifdef USE_DRICONF
 #include "xmlconfig.h"
 #include "xmlpool.h"
@@ -83,6 +84,7 @@
 #ifdef HAVE_SYSFS
 #include <sys/types.h>
 #endif
+#include "util/u_startup_profile.h"
 #include "loader.h"
 
 #ifdef HAVE_LIBDRM
@@ -120,6 +122,82 @@ loader_open_device(const char *device_name)
    return fd;
 }
 
+/*
+ * Process-wide caches.  A client that opens a display connection per
+ * request redoes the driver search, relocation and device id lookups every
+ * time; remembering where a driver was found -- and pinning it so it stays
+ * resident once the last connection using it goes away -- makes everything
+ * after the first connection cheap.
+ */
+
+static pthread_mutex_t loader_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+struct driver_cache_entry {
+   struct driver_cache_entry *next;
+   char *driver_name;
+   char *path;
+};
+
+static struct driver_cache_entry *driver_cache = NULL;
+
+void
+loader_cache_driver(const char *driver_name, const char *path)
+{
+   struct driver_cache_entry *e;
+
+   pthread_mutex_lock(&loader_cache_mutex);
+
+   for (e = driver_cache; e; e = e->next) {
+      if (strcmp(e->driver_name, driver_name) == 0)
+         goto out;
+   }
+
+   e = malloc(sizeof(*e));
+   if (!e)
+      goto out;
+
+   e->driver_name = strdup(driver_name);
+   e->path = strdup(path);
+
+   /* Take a reference of our own so the driver stays mapped and relocated
+    * even when all display connections using it are gone.
+    */
+   if (!e->driver_name || !e->path ||
+       dlopen(path, RTLD_NOW | RTLD_GLOBAL) == NULL) {
+      free(e->driver_name);
+      free(e->path);
+      free(e);
+      goto out;
+   }
+
+   e->next = driver_cache;
+   driver_cache = e;
+
+out:
+   pthread_mutex_unlock(&loader_cache_mutex);
+}
+
+void *
+loader_open_cached_driver(const char *driver_name)
+{
+   struct driver_cache_entry *e;
+   void *handle = NULL;
+
+   pthread_mutex_lock(&loader_cache_mutex);
+
+   for (e = driver_cache; e; e = e->next) {
+      if (strcmp(e->driver_name, driver_name) == 0) {
+         /* the object is already resident; this only bumps its refcount */
+         handle = dlopen(e->path, RTLD_NOW | RTLD_GLOBAL);
+         break;
+      }
+   }
+
+   pthread_mutex_unlock(&loader_cache_mutex);
+
+   return handle;
+}
+
 #ifdef HAVE_LIBUDEV
 #include <libudev.h>
 
@@ -579,8 +657,53 @@ drm_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
 #endif
 
 
-int
-loader_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
+#define LOADER_PCI_ID_CACHE_SIZE 8
+
+static struct {
+   dev_t rdev;
+   int vendor_id;
+   int chip_id;
+} pci_id_cache[LOADER_PCI_ID_CACHE_SIZE];
+static int pci_id_cache_count = 0;
+
+static int
+cached_pci_id_for_rdev(dev_t rdev, int *vendor_id, int *chip_id)
+{
+   int i, found = 0;
+
+   pthread_mutex_lock(&loader_cache_mutex);
+
+   for (i = 0; i < pci_id_cache_count; i++) {
+      if (pci_id_cache[i].rdev == rdev) {
+         *vendor_id = pci_id_cache[i].vendor_id;
+         *chip_id = pci_id_cache[i].chip_id;
+         found = 1;
+         break;
+      }
+   }
+
+   pthread_mutex_unlock(&loader_cache_mutex);
+
+   return found;
+}
+
+static void
+cache_pci_id_for_rdev(dev_t rdev, int vendor_id, int chip_id)
+{
+   pthread_mutex_lock(&loader_cache_mutex);
+
+   if (pci_id_cache_count < LOADER_PCI_ID_CACHE_SIZE) {
+      pci_id_cache[pci_id_cache_count].rdev = rdev;
+      pci_id_cache[pci_id_cache_count].vendor_id = vendor_id;
+      pci_id_cache[pci_id_cache_count].chip_id = chip_id;
+      pci_id_cache_count++;
+   }
+
+   pthread_mutex_unlock(&loader_cache_mutex);
+}
+
+static int
+get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
 {
 #if HAVE_LIBUDEV
    if (libudev_get_pci_id_for_fd(fd, vendor_id, chip_id))
@@ -597,6 +720,28 @@ loader_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
    return 0;
 }
 
+int
+loader_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
+{
+   struct stat st;
+   int have_rdev;
+
+   /* the underlying lookups walk udev or sysfs; a process opening the same
+    * device once per display connection shouldn't redo that every time
+    */
+   have_rdev = (fstat(fd, &st) == 0 && S_ISCHR(st.st_mode));
+   if (have_rdev && cached_pci_id_for_rdev(st.st_rdev, vendor_id, chip_id))
+      return 1;
+
+   if (!get_pci_id_for_fd(fd, vendor_id, chip_id))
+      return 0;
+
+   if (have_rdev)
+      cache_pci_id_for_rdev(st.st_rdev, *vendor_id, *chip_id);
+
+   return 1;
+}
+
 
 #ifdef HAVE_LIBUDEV
 static char *
@@ -715,6 +860,7 @@ loader_get_device_name_for_fd(int fd)
 char *
 loader_get_driver_for_fd(int fd, unsigned driver_types)
 {
+   int64_t profile_start = u_startup_profile_begin();
    int vendor_id, chip_id, i, j;
    char *driver = NULL;
 
@@ -738,6 +884,7 @@ loader_get_driver_for_fd(int fd, unsigned driver_types)
       drmFreeVersion(version);
 #endif
 
+      u_startup_profile_end("loader_get_driver_for_fd", profile_start);
       return driver;
    }
 
@@ -767,6 +914,7 @@ out:
    log_(driver ? _LOADER_DEBUG : _LOADER_WARNING,
          "pci id for fd %d: %04x:%04x, driver %s\n",
          fd, vendor_id, chip_id, driver);
+   u_startup_profile_end("loader_get_driver_for_fd", profile_start);
    return driver;
 }
 
@@ -48,6 +48,18 @@ loader_get_driver_for_fd(int fd, unsigned driver_types);
 char *
 loader_get_device_name_for_fd(int fd);
 
+/* Process-wide driver handle cache: remember where a driver was found (and
+ * keep it resident) so later display connections skip the path search and
+ * relocation.  loader_open_cached_driver() returns a fresh dlopen reference
+ * for a previously cached driver, or NULL on a cache miss.
+ */
+
+void
+loader_cache_driver(const char *driver_name, const char *path);
+
+void *
+loader_open_cached_driver(const char *driver_name);
+
 /* Function to get a different device than the one we are to use by default,
  * if the user requests so and it is possible. The initial fd will be closed
  * if necessary. The returned fd is potentially a render-node.
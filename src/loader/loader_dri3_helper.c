@@ -65,9 +65,20 @@ dri3_fence_await(xcb_connection_t *c, struct loader_dri3_buffer *buffer)
    xshmfence_await(buffer->shm_fence);
 }
 
+static void
+dri3_flush_present_events(struct loader_dri3_drawable *draw);
+
 static void
 dri3_update_num_back(struct loader_dri3_drawable *draw)
 {
+   /* A fixed depth overrides the heuristic, so a deeper swap chain can be
+    * requested when the app can't afford to ever block in dri3_find_back.
+    */
+   if (draw->max_num_back) {
+      draw->num_back = draw->max_num_back;
+      return;
+   }
+
    draw->num_back = 1;
    if (draw->flipping) {
       if (!draw->is_pixmap &&
@@ -106,6 +117,57 @@ dri3_free_render_buffer(struct loader_dri3_drawable *draw,
    free(buffer);
 }
 
+/** dri3_retire_render_buffer
+ *
+ * Park a buffer made obsolete by a resize in the per-drawable cache instead
+ * of destroying it.  Interactive resizes bounce between a small set of
+ * sizes, and every miss costs a full image allocation plus the
+ * pixmap-from-buffer and fence-from-fd exchanges with the server; keeping a
+ * few retired buffers around turns most of that into a table lookup.  The
+ * oldest entry is evicted for real when the cache is full.
+ */
+static void
+dri3_retire_render_buffer(struct loader_dri3_drawable *draw,
+                          struct loader_dri3_buffer *buffer)
+{
+   int i;
+
+   for (i = 0; i < LOADER_DRI3_BUFFER_CACHE_SIZE; i++) {
+      if (!draw->buffer_cache[i]) {
+         draw->buffer_cache[i] = buffer;
+         return;
+      }
+   }
+
+   dri3_free_render_buffer(draw, draw->buffer_cache[0]);
+   for (i = 1; i < LOADER_DRI3_BUFFER_CACHE_SIZE; i++)
+      draw->buffer_cache[i - 1] = draw->buffer_cache[i];
+   draw->buffer_cache[LOADER_DRI3_BUFFER_CACHE_SIZE - 1] = buffer;
+}
+
+/** dri3_cached_render_buffer
+ *
+ * Fetch a matching buffer from the retire cache, or NULL.
+ */
+static struct loader_dri3_buffer *
+dri3_cached_render_buffer(struct loader_dri3_drawable *draw,
+                          unsigned int format, int width, int height)
+{
+   int i;
+
+   for (i = 0; i < LOADER_DRI3_BUFFER_CACHE_SIZE; i++) {
+      struct loader_dri3_buffer *buffer = draw->buffer_cache[i];
+
+      if (buffer && buffer->format == format &&
+          buffer->width == width && buffer->height == height) {
+         draw->buffer_cache[i] = NULL;
+         return buffer;
+      }
+   }
+
+   return NULL;
+}
+
 void
 loader_dri3_drawable_fini(struct loader_dri3_drawable *draw)
 {
@@ -118,6 +180,11 @@ loader_dri3_drawable_fini(struct loader_dri3_drawable *draw)
          dri3_free_render_buffer(draw, draw->buffers[i]);
    }
 
+   for (i = 0; i < LOADER_DRI3_BUFFER_CACHE_SIZE; i++) {
+      if (draw->buffer_cache[i])
+         dri3_free_render_buffer(draw, draw->buffer_cache[i]);
+   }
+
    if (draw->special_event)
       xcb_unregister_for_special_event(draw->conn, draw->special_event);
 }
@@ -137,6 +204,7 @@ loader_dri3_drawable_init(xcb_connection_t *conn,
    xcb_generic_error_t *error;
    GLint vblank_mode = DRI_CONF_VBLANK_DEF_INTERVAL_1;
    int swap_interval;
+   const char *env;
 
    draw->conn = conn;
    draw->ext = ext;
@@ -166,6 +234,15 @@ loader_dri3_drawable_init(xcb_connection_t *conn,
    }
    draw->vtable->set_swap_interval(draw, swap_interval);
 
+   draw->max_num_back = 0;
+   env = getenv("LIBGL_DRI3_NUM_BACK");
+   if (env) {
+      draw->max_num_back = atoi(env);
+      if (draw->max_num_back < 1 ||
+          draw->max_num_back > LOADER_DRI3_MAX_BACK)
+         draw->max_num_back = 0;
+   }
+
    dri3_update_num_back(draw);
 
    /* Create a new drawable */
@@ -366,6 +443,12 @@ dri3_find_back(struct loader_dri3_drawable *draw)
    xcb_generic_event_t *ev;
    xcb_present_generic_event_t *ge;
 
+   /* Pick up any idle notifies that have already arrived, so the busy
+    * flags and buffer ages are current before we choose a buffer or
+    * decide to block.
+    */
+   dri3_flush_present_events(draw);
+
    for (;;) {
       for (b = 0; b < draw->num_back; b++) {
          int id = LOADER_DRI3_BACK_ID((b + draw->cur_back) % draw->num_back);
@@ -918,6 +1001,7 @@ dri3_alloc_render_buffer(struct loader_dri3_drawable *draw, unsigned int format,
    buffer->own_pixmap = true;
    buffer->sync_fence = sync_fence;
    buffer->shm_fence = shm_fence;
+   buffer->format = format;
    buffer->width = width;
    buffer->height = height;
 
@@ -1209,13 +1293,17 @@ dri3_get_buffer(__DRIdrawable *driDrawable,
        buffer->height != draw->height) {
       struct loader_dri3_buffer *new_buffer;
 
-      /* Allocate the new buffers
+      /* Allocate the new buffers, preferring a previously retired one of
+       * the right size
        */
-      new_buffer = dri3_alloc_render_buffer(draw,
-                                                   format,
-                                                   draw->width,
-                                                   draw->height,
-                                                   draw->depth);
+      new_buffer = dri3_cached_render_buffer(draw, format,
+                                             draw->width, draw->height);
+      if (!new_buffer)
+         new_buffer = dri3_alloc_render_buffer(draw,
+                                               format,
+                                               draw->width,
+                                               draw->height,
+                                               draw->depth);
       if (!new_buffer)
          return NULL;
 
@@ -1242,7 +1330,7 @@ dri3_get_buffer(__DRIdrawable *driDrawable,
                                            0, 0, draw->width, draw->height,
                                            0, 0, draw->width, draw->height, 0);
             }
-            dri3_free_render_buffer(draw, buffer);
+            dri3_retire_render_buffer(draw, buffer);
          }
          break;
       case loader_dri3_buffer_front:
@@ -1255,6 +1343,10 @@ dri3_get_buffer(__DRIdrawable *driDrawable,
                         draw->width, draw->height);
          dri3_fence_trigger(draw->conn, new_buffer);
 
+         /* the old fake front was previously leaked on resize */
+         if (buffer)
+            dri3_retire_render_buffer(draw, buffer);
+
          if (new_buffer->linear_buffer &&
              draw->vtable->in_current_context(draw)) {
             dri3_fence_await(draw->conn, new_buffer);
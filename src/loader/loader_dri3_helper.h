@@ -65,6 +65,7 @@ struct loader_dri3_buffer {
    uint32_t     pitch;
    uint32_t     cpp;
    uint32_t     flags;
+   uint32_t     format;
    uint32_t     width, height;
    uint64_t     last_swap;
 
@@ -109,6 +110,12 @@ struct loader_dri3_vtable {
 
 #define LOADER_DRI3_NUM_BUFFERS (1 + LOADER_DRI3_MAX_BACK)
 
+/* Buffers retired by a resize are parked here instead of being destroyed,
+ * so a later request for the same size reuses the pixmap and fence pair
+ * instead of redoing the whole allocation dance with the server.
+ */
+#define LOADER_DRI3_BUFFER_CACHE_SIZE LOADER_DRI3_MAX_BACK
+
 struct loader_dri3_drawable {
    xcb_connection_t *conn;
    __DRIdrawable *dri_drawable;
@@ -146,8 +153,10 @@ struct loader_dri3_drawable {
    uint32_t recv_msc_serial;
 
    struct loader_dri3_buffer *buffers[LOADER_DRI3_NUM_BUFFERS];
+   struct loader_dri3_buffer *buffer_cache[LOADER_DRI3_BUFFER_CACHE_SIZE];
    int cur_back;
    int num_back;
+   int max_num_back;            /* user-configured depth, 0 = automatic */
 
    uint32_t *stamp;
 
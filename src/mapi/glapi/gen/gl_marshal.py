@@ -0,0 +1,230 @@
+#!/usr/bin/env python
+
+# Copyright (C) 2012 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+
+# This script generates the file marshal_generated.c, which contains the
+# marshal dispatch table used by glthread (see glthread.c) together with
+# the code that encodes GL calls into command batches and replays them on
+# the server thread.
+#
+# A function is marshalled asynchronously when all of its parameters can
+# be copied into a fixed-size command struct: it must return void and take
+# no pointer arguments.  Everything else (queries, anything sourcing or
+# returning client memory, and the explicit synchronization points) is
+# marshalled synchronously: the batch queue is drained and the call is
+# made directly on the application thread.
+
+import argparse
+import license
+import gl_XML
+
+
+# Functions which fit the asynchronous criteria but must execute
+# synchronously anyway.
+sync_functions = frozenset([
+    # glFinish must not return before rendering is complete.
+    'Finish',
+    # glFlush has to push pending commands to the server before returning.
+    'Flush',
+])
+
+
+header = """
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/dispatch.h"
+#include "main/glthread.h"
+#include "main/marshal.h"
+"""
+
+
+def marshal_is_async(func):
+    """Can this function be encoded into a command batch?"""
+    if func.return_type != 'void':
+        return False
+    if func.name in sync_functions:
+        return False
+    for p in func.parameters:
+        if p.is_padding:
+            continue
+        if p.is_pointer():
+            return False
+    return True
+
+
+class PrintCode(gl_XML.gl_print_base):
+
+    def __init__(self):
+        gl_XML.gl_print_base.__init__(self)
+
+        self.name = 'gl_marshal.py'
+        self.license = license.bsd_license_template % (
+            'Copyright (C) 2012 Intel Corporation',
+            'Intel Corporation')
+
+    def printRealHeader(self):
+        print header
+
+    def print_sync_function(self, func):
+        print 'static {0} GLAPIENTRY'.format(func.return_type)
+        print '_mesa_marshal_{0}({1})'.format(
+            func.name, func.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        print '   _mesa_glthread_finish(ctx);'
+        ret = 'return ' if func.return_type != 'void' else ''
+        print '   {0}CALL_{1}(ctx->CurrentDispatch, ({2}));'.format(
+            ret, func.name, func.get_called_parameter_string())
+        print '}'
+
+    def print_async_function(self, func):
+        print 'struct marshal_cmd_{0}'.format(func.name)
+        print '{'
+        print '   struct marshal_cmd_base cmd_base;'
+        for p in func.parameters:
+            if p.is_padding:
+                continue
+            print '   {0} {1};'.format(p.type_string(), p.name)
+        print '};'
+        print ''
+
+        print 'static void'
+        print ('_mesa_unmarshal_{0}(struct gl_context *ctx, '
+               'const struct marshal_cmd_{0} *cmd)').format(func.name)
+        print '{'
+        args = ', '.join('cmd->{0}'.format(p.name)
+                         for p in func.parameters if not p.is_padding)
+        print '   CALL_{0}(ctx->CurrentDispatch, ({1}));'.format(
+            func.name, args)
+        print '}'
+        print ''
+
+        print 'static void GLAPIENTRY'
+        print '_mesa_marshal_{0}({1})'.format(
+            func.name, func.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        print '   struct marshal_cmd_{0} *cmd ='.format(func.name)
+        print ('      _mesa_glthread_allocate_command(ctx, '
+               'DISPATCH_CMD_{0},').format(func.name)
+        print ('                                      '
+               'sizeof(struct marshal_cmd_{0}));').format(func.name)
+        assigned = False
+        for p in func.parameters:
+            if p.is_padding:
+                continue
+            print '   cmd->{0} = {0};'.format(p.name)
+            assigned = True
+        if not assigned:
+            print '   (void) cmd;'
+        print '}'
+
+    def printBody(self, api):
+        async_funcs = []
+        all_funcs = []
+
+        for func in api.functionIterateByOffset():
+            all_funcs.append(func)
+            if marshal_is_async(func):
+                async_funcs.append(func)
+
+        print 'enum marshal_dispatch_cmd_id'
+        print '{'
+        for func in async_funcs:
+            print '   DISPATCH_CMD_{0},'.format(func.name)
+        print '};'
+        print ''
+
+        for func in all_funcs:
+            print ''
+            print '/* {0}: marshalled {1} */'.format(
+                func.name,
+                'asynchronously' if marshal_is_async(func)
+                else 'synchronously')
+            if marshal_is_async(func):
+                self.print_async_function(func)
+            else:
+                self.print_sync_function(func)
+
+        print ''
+        print ''
+        print '/**'
+        print ' * Execute one command from a glthread batch and return its'
+        print ' * size, so the server thread can step to the next one.'
+        print ' */'
+        print 'size_t'
+        print ('_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, '
+               'const struct marshal_cmd_base *cmd)')
+        print '{'
+        print '   switch (cmd->cmd_id) {'
+        for func in async_funcs:
+            print '   case DISPATCH_CMD_{0}:'.format(func.name)
+            print ('      _mesa_unmarshal_{0}(ctx, (const struct '
+                   'marshal_cmd_{0} *) cmd);').format(func.name)
+            print '      break;'
+        print '   default:'
+        print '      unreachable("unexpected command id in glthread batch");'
+        print '   }'
+        print '   return cmd->cmd_size;'
+        print '}'
+        print ''
+        print ''
+        print '/**'
+        print ' * Create the client-side dispatch table which encodes GL'
+        print ' * calls for the glthread server thread.'
+        print ' */'
+        print 'struct _glapi_table *'
+        print '_mesa_create_marshal_table(const struct gl_context *ctx)'
+        print '{'
+        print '   struct _glapi_table *table;'
+        print ''
+        print '   table = _mesa_alloc_dispatch_table();'
+        print '   if (table == NULL)'
+        print '      return NULL;'
+        print ''
+        for func in all_funcs:
+            print '   SET_{0}(table, _mesa_marshal_{0});'.format(func.name)
+        print ''
+        print '   return table;'
+        print '}'
+
+
+def _parser():
+    """Parse arguments and return namespace."""
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-f',
+                        dest='filename',
+                        default='gl_and_es_API.xml',
+                        help='an xml file describing an API')
+    return parser.parse_args()
+
+
+def main():
+    """Main function."""
+    args = _parser()
+    printer = PrintCode()
+    api = gl_XML.parse_GL_API(args.filename)
+    printer.Print(api)
+
+
+if __name__ == '__main__':
+    main()
@@ -31,6 +31,7 @@
 #include "main/glheader.h"
 #include "main/context.h"
 #include "main/framebuffer.h"
+#include "main/glthread.h"
 #include "main/renderbuffer.h"
 #include "main/texobj.h"
 #include "main/hash.h"
@@ -157,6 +158,12 @@ intelDRI2Flush(__DRIdrawable *drawable)
    if (intel == NULL)
       return;
 
+   /* The loader calls this directly on the application thread, bypassing
+    * the marshal dispatch table, so drain any glthread batches still
+    * queued for the server thread before flushing.
+    */
+   _mesa_glthread_finish(ctx);
+
    INTEL_FIREVERTICES(intel);
 
    intel->need_throttle = true;
@@ -337,7 +337,8 @@ retry:
     * map all the BOs into the GPU at batch exec time later.  If so, flush the
     * batch and try again with nothing else in the batch.
     */
-   if (dri_bufmgr_check_aperture_space(&brw->batch.bo, 1)) {
+   drm_intel_bo *aper_array[] = { brw->batch.bo, brw->batch.state_bo };
+   if (dri_bufmgr_check_aperture_space(aper_array, 2)) {
       if (!check_aperture_failed_once) {
          check_aperture_failed_once = true;
          intel_batchbuffer_reset_to_saved(brw);
@@ -364,6 +364,14 @@ struct brw_stage_prog_data {
    struct brw_image_param *image_param;
 };
 
+/**
+ * Well-known zero constant, referenced by param[] entries that pad a vec4
+ * slot out to four components.  Sharing a single sentinel (rather than
+ * file-local statics) lets the disk program cache recognize these entries
+ * when it serializes prog_data.
+ */
+extern const union gl_constant_value brw_param_zero;
+
 /* Data about a particular attempt to compile a program.  Note that
  * there can be many of these, each in a different GL state
  * corresponding to a different brw_wm_prog_key struct, with different
@@ -64,6 +64,7 @@
 #include "intel_image.h"
 #include "intel_tex.h"
 #include "intel_tex_obj.h"
+#include "intel_tiled_memcpy.h"
 
 #include "swrast_setup/swrast_setup.h"
 #include "tnl/tnl.h"
@@ -916,6 +917,19 @@ brwCreateContext(gl_api api,
    if (INTEL_DEBUG & DEBUG_PERF)
       brw->perf_debug = true;
 
+   /* A small thread pool for parallelizing the per-stage work at link time.
+    * If thread creation fails, brw_link_shader just runs everything on the
+    * application thread.
+    */
+   util_queue_init(&brw->compile_queue, "brwcomp", MESA_SHADER_STAGES, 4, 0);
+
+   /* A second pool for splitting large tiled-memcpy texture uploads by tile
+    * rows; these jobs are CPU-bound memory copies, so the width here is what
+    * bounds upload bandwidth on the fast texsubimage path.
+    */
+   util_queue_init(&brw->tiled_memcpy_queue, "brwtile",
+                   TILED_MEMCPY_MAX_JOBS, 4, 0);
+
    brw_initialize_cs_context_constants(brw, devinfo->max_cs_threads);
    brw_initialize_context_constants(brw);
 
@@ -1055,6 +1069,12 @@ intelDestroyContext(__DRIcontext * driContextPriv)
       aub_dump_bmp(&brw->ctx);
    }
 
+   if (util_queue_is_initialized(&brw->compile_queue))
+      util_queue_destroy(&brw->compile_queue);
+
+   if (util_queue_is_initialized(&brw->tiled_memcpy_queue))
+      util_queue_destroy(&brw->tiled_memcpy_queue);
+
    _mesa_meta_free(&brw->ctx);
 
    if (INTEL_DEBUG & DEBUG_SHADER_TIME) {
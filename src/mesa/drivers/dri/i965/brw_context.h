@@ -36,6 +36,7 @@
 #include <stdbool.h>
 #include "main/macros.h"
 #include "main/mtypes.h"
+#include "util/u_queue.h"
 #include "brw_structs.h"
 #include "brw_compiler.h"
 #include "intel_aub.h"
@@ -540,6 +541,9 @@ struct brw_cache {
 
    uint32_t next_offset;
    bool bo_used_by_gpu;
+
+   /** Directory for the on-disk program cache, or NULL if disabled. */
+   char *disk_cache_dir;
 };
 
 
@@ -554,6 +558,20 @@ struct brw_tracked_state {
    void (*emit)( struct brw_context *brw );
 };
 
+#define BRW_MAX_STATE_ATOMS 76
+#define BRW_ATOM_BITMAP_WORDS ((BRW_MAX_STATE_ATOMS + 63) / 64)
+
+/**
+ * For each dirty bit, a bitmap over atom indices of the atoms listening to
+ * it.  Built once per pipeline by brw_copy_pipeline_atoms(), and used by
+ * brw_upload_pipeline_state() to visit only the atoms a flagged bit can
+ * concern instead of testing every atom in the list on every draw.
+ */
+struct brw_atom_listeners {
+   uint64_t mesa[32][BRW_ATOM_BITMAP_WORDS];
+   uint64_t brw[BRW_NUM_STATE_BITS][BRW_ATOM_BITMAP_WORDS];
+};
+
 enum shader_time_shader_type {
    ST_NONE,
    ST_VS,
@@ -608,6 +626,13 @@ struct intel_batchbuffer {
    /** Last BO submitted to the hardware.  Used for glFinish(). */
    drm_intel_bo *last_bo;
 
+   /** BO holding the indirect state (surface states, unit states, ...)
+    * referenced by the current batch.  Keeping it separate from the
+    * command BO means filling one doesn't eat into the other, so draw-
+    * heavy batches no longer split when commands and state collide.
+    */
+   drm_intel_bo *state_bo;
+
 #ifdef DEBUG
    uint16_t emit, total;
 #endif
@@ -615,7 +640,22 @@ struct intel_batchbuffer {
    uint32_t *map_next;
    uint32_t *map;
    uint32_t *cpu_map;
+   uint32_t *state_map;
+   uint32_t *state_cpu_map;
 #define BATCH_SZ (8192*sizeof(uint32_t))
+#define STATE_SZ (8192*sizeof(uint32_t))
+
+   /** Pool of batch and state BOs recycled across flushes, so that
+    * starting a new batch doesn't have to allocate (and on LLC, map)
+    * fresh BOs each time.  A pool entry the GPU is still chewing on is
+    * replaced rather than waited for.
+    */
+#define BATCH_BO_POOL_SZ 4
+   drm_intel_bo *pool_bo[BATCH_BO_POOL_SZ];
+   uint32_t *pool_map[BATCH_BO_POOL_SZ];
+   drm_intel_bo *pool_state_bo[BATCH_BO_POOL_SZ];
+   uint32_t *pool_state_map[BATCH_BO_POOL_SZ];
+   unsigned pool_next;
 
    uint32_t state_batch_offset;
    enum brw_gpu_ring ring;
@@ -625,6 +665,8 @@ struct intel_batchbuffer {
    struct {
       uint32_t *map_next;
       int reloc_count;
+      int state_reloc_count;
+      uint32_t state_batch_offset;
    } saved;
 };
 
@@ -1271,8 +1313,9 @@ struct brw_context
    } perfmon;
 
    int num_atoms[BRW_NUM_PIPELINES];
-   const struct brw_tracked_state render_atoms[76];
+   const struct brw_tracked_state render_atoms[BRW_MAX_STATE_ATOMS];
    const struct brw_tracked_state compute_atoms[11];
+   struct brw_atom_listeners atom_listeners[BRW_NUM_PIPELINES];
 
    /* If (INTEL_DEBUG & DEBUG_BATCH) */
    struct {
@@ -1332,6 +1375,18 @@ struct brw_context
 
    struct brw_fast_clear_state *fast_clear_state;
 
+   /* Thread pool for going wide across the shader stages at link time.
+    * May be uninitialized if thread creation failed, in which case
+    * everything runs on the application thread.
+    */
+   struct util_queue compile_queue;
+
+   /* Thread pool for splitting large tiled-memcpy texture uploads by tile
+    * rows.  May be uninitialized, in which case the copies run on the
+    * application thread.
+    */
+   struct util_queue tiled_memcpy_queue;
+
    __DRIcontext *driContext;
    struct intel_screen *intelScreen;
 };
@@ -1787,7 +1842,7 @@ brw_program_reloc(struct brw_context *brw, uint32_t state_offset,
       return prog_offset;
    }
 
-   drm_intel_bo_emit_reloc(brw->batch.bo,
+   drm_intel_bo_emit_reloc(brw->batch.state_bo,
 			   state_offset,
 			   brw->cache.bo,
 			   prog_offset,
@@ -0,0 +1,644 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file brw_disk_cache.c
+ *
+ * On-disk tier underneath the in-memory program cache in brw_state_cache.c.
+ *
+ * When MESA_SHADER_CACHE_DIR is set, final GEN assembly and prog_data for
+ * VS and FS programs are written out after codegen, keyed on the prog_key
+ * plus a hash of the program source (the program_string_id in the key is
+ * only unique within one process, so it is replaced by the source hash).
+ * On an in-memory cache miss we try the disk first, and a hit is inserted
+ * into the in-memory cache through the normal brw_upload_cache() path,
+ * skipping the backend compiler entirely.
+ *
+ * prog_data is not a plain blob: its param[]/pull_param[] arrays hold
+ * pointers to the live uniform values that are dereferenced on every
+ * constant upload.  Each entry is serialized as a relocation naming the
+ * object it points into (parameter list, uniform storage block, clip plane
+ * array, image params, or the shared zero sentinel), and is rebased against
+ * the current program's objects when loaded.  A program whose params point
+ * anywhere we can't describe is simply not stored on disk.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "main/imports.h"
+#include "main/macros.h"
+#include "program/prog_parameter.h"
+#include "compiler/glsl/ir_uniform.h"
+#include "compiler/nir_types.h"
+#include "util/ralloc.h"
+#include "util/u_hash64.h"
+#include "brw_context.h"
+#include "brw_state.h"
+#include "brw_vs.h"
+#include "brw_wm.h"
+#include "brw_program.h"
+#include "intel_debug.h"
+
+#define FILE_DEBUG_FLAG DEBUG_STATE
+
+#define BRW_DISK_CACHE_MAGIC 0x42525743
+#define BRW_DISK_CACHE_VERSION 1
+
+struct brw_disk_cache_header {
+   uint32_t magic;
+   uint32_t version;
+   uint32_t device_id;
+   uint32_t cache_id;
+   uint32_t key_size;
+   uint32_t data_size;
+   uint32_t aux_size;
+   uint32_t pad;
+   /* Second, independently seeded hash of the same identity that produced
+    * the file name, so that a file name collision can't match.
+    */
+   uint64_t check_hash;
+};
+
+/* param[]/pull_param[] relocation encoding: type in the top two bits,
+ * payload layout depending on the type.
+ */
+#define RELOC_TYPE_SHIFT 30
+#define RELOC_PAYLOAD_MASK 0x3fffffffu
+#define RELOC_TYPE(r) ((r) >> RELOC_TYPE_SHIFT)
+
+#define RELOC_PARAM_LIST 0u /**< payload: index into plist->ParameterValues */
+#define RELOC_STORAGE 1u    /**< payload: storage index << 16 | component */
+#define RELOC_MISC 2u       /**< payload: subtype << 16 | component */
+#define RELOC_IMAGE 3u      /**< payload: dword offset into image_param[] */
+
+#define RELOC_MISC_ZERO 0u
+#define RELOC_MISC_EYE_PLANE 1u
+#define RELOC_MISC_CLIP_PLANE 2u
+
+/** NULL pointer sentinel; checked before decoding the type bits. */
+#define RELOC_NULL 0xffffffffu
+
+static bool
+brw_disk_cache_enabled(const struct brw_context *brw)
+{
+   /* Shader time offsets baked into the assembly are only valid within the
+    * process that handed them out, so never mix that with the disk cache.
+    */
+   return brw->cache.disk_cache_dir != NULL &&
+          !(INTEL_DEBUG & DEBUG_SHADER_TIME);
+}
+
+/**
+ * Byte offset of the program_string_id field within the prog key, or -1 if
+ * this kind of program doesn't go to disk.
+ */
+static int
+program_string_id_offset(enum brw_cache_id cache_id)
+{
+   switch (cache_id) {
+   case BRW_CACHE_VS_PROG:
+      return offsetof(struct brw_vs_prog_key, program_string_id);
+   case BRW_CACHE_FS_PROG:
+      return offsetof(struct brw_wm_prog_key, program_string_id);
+   default:
+      return -1;
+   }
+}
+
+/**
+ * Number of gl_constant_value slots backing a uniform storage block, using
+ * the same arithmetic as brw_nir_setup_glsl_uniform().
+ */
+static unsigned
+uniform_storage_components(const struct gl_uniform_storage *storage)
+{
+   unsigned vector_count = MAX2(storage->array_elements, 1) *
+                           glsl_get_matrix_columns(storage->type);
+   unsigned vector_size = glsl_get_vector_elements(storage->type);
+
+   if (glsl_get_base_type(storage->type) == GLSL_TYPE_DOUBLE)
+      vector_size *= 2;
+
+   return vector_count * vector_size;
+}
+
+/**
+ * Computes the pair of hashes identifying a program on disk, and fills
+ * key_copy (key_size bytes) with the key with its program_string_id
+ * cleared.  Returns false if the program can't be identified stably.
+ */
+static bool
+brw_disk_cache_hash(struct brw_context *brw,
+                    enum brw_cache_id cache_id,
+                    const void *key, GLuint key_size,
+                    struct gl_shader_program *shader_prog,
+                    const struct gl_program *prog,
+                    void *key_copy,
+                    uint64_t hashes[2])
+{
+   const int id_offset = program_string_id_offset(cache_id);
+   unsigned seed;
+
+   if (id_offset < 0)
+      return false;
+
+   /* The program_string_id is only unique within this process; the source
+    * text hashed below identifies the program across runs instead.
+    */
+   memcpy(key_copy, key, key_size);
+   memset((char *)key_copy + id_offset, 0, sizeof(unsigned));
+
+   for (seed = 0; seed < 2; seed++) {
+      struct util_hash64_state state;
+      uint32_t val;
+
+      util_hash64_init(&state, seed);
+
+      val = brw->intelScreen->deviceID;
+      util_hash64_update(&state, &val, sizeof(val));
+      val = cache_id;
+      util_hash64_update(&state, &val, sizeof(val));
+      util_hash64_update(&state, key_copy, key_size);
+
+      if (shader_prog) {
+         unsigned i;
+
+         for (i = 0; i < shader_prog->NumShaders; i++) {
+            struct gl_shader *sh = shader_prog->Shaders[i];
+
+            if (sh->Source == NULL)
+               return false;
+
+            val = sh->Stage;
+            util_hash64_update(&state, &val, sizeof(val));
+            util_hash64_update(&state, sh->Source, strlen(sh->Source) + 1);
+         }
+
+         /* The linked uniform layout depends on more than the source text
+          * (transform feedback varyings, for instance), so fold a summary
+          * of it in as well.
+          */
+         val = shader_prog->NumUniformStorage;
+         util_hash64_update(&state, &val, sizeof(val));
+         for (i = 0; i < shader_prog->NumUniformStorage; i++) {
+            const struct gl_uniform_storage *storage =
+               &shader_prog->UniformStorage[i];
+            uint32_t layout[2];
+
+            util_hash64_update(&state, storage->name,
+                               strlen(storage->name) + 1);
+            layout[0] = storage->array_elements;
+            layout[1] = uniform_storage_components(storage);
+            util_hash64_update(&state, layout, sizeof(layout));
+         }
+      } else {
+         if (prog->String == NULL)
+            return false;
+
+         util_hash64_update(&state, prog->String,
+                            strlen((const char *)prog->String) + 1);
+      }
+
+      val = prog->Parameters ? prog->Parameters->NumParameters : 0;
+      util_hash64_update(&state, &val, sizeof(val));
+
+      hashes[seed] = util_hash64_final(&state);
+   }
+
+   return true;
+}
+
+/**
+ * Describes one param[] pointer as a relocation against the objects it may
+ * point into.  Returns false for pointers we can't describe, in which case
+ * the program isn't stored on disk.
+ */
+static bool
+encode_param_reloc(struct brw_context *brw,
+                   const struct brw_stage_prog_data *prog_data,
+                   const struct gl_program_parameter_list *plist,
+                   struct gl_shader_program *shader_prog,
+                   const union gl_constant_value *p,
+                   uint32_t *out)
+{
+   const uintptr_t up = (uintptr_t)p;
+   uintptr_t base;
+   size_t size;
+
+   if (p == NULL) {
+      *out = RELOC_NULL;
+      return true;
+   }
+
+   if (p == &brw_param_zero) {
+      *out = (RELOC_MISC << RELOC_TYPE_SHIFT) | (RELOC_MISC_ZERO << 16);
+      return true;
+   }
+
+   if (plist) {
+      base = (uintptr_t)plist->ParameterValues;
+      size = plist->NumParameters * 4 * sizeof(union gl_constant_value);
+      if (up >= base && up < base + size) {
+         *out = (RELOC_PARAM_LIST << RELOC_TYPE_SHIFT) |
+                (uint32_t)((up - base) / sizeof(union gl_constant_value));
+         return true;
+      }
+   }
+
+   base = (uintptr_t)prog_data->image_param;
+   size = prog_data->nr_image_params * sizeof(struct brw_image_param);
+   if (size > 0 && up >= base && up < base + size) {
+      *out = (RELOC_IMAGE << RELOC_TYPE_SHIFT) | (uint32_t)((up - base) / 4);
+      return true;
+   }
+
+   base = (uintptr_t)brw->ctx.Transform.EyeUserPlane;
+   size = sizeof(brw->ctx.Transform.EyeUserPlane);
+   if (up >= base && up < base + size) {
+      *out = (RELOC_MISC << RELOC_TYPE_SHIFT) | (RELOC_MISC_EYE_PLANE << 16) |
+             (uint32_t)((up - base) / sizeof(GLfloat));
+      return true;
+   }
+
+   base = (uintptr_t)brw->ctx.Transform._ClipUserPlane;
+   size = sizeof(brw->ctx.Transform._ClipUserPlane);
+   if (up >= base && up < base + size) {
+      *out = (RELOC_MISC << RELOC_TYPE_SHIFT) | (RELOC_MISC_CLIP_PLANE << 16) |
+             (uint32_t)((up - base) / sizeof(GLfloat));
+      return true;
+   }
+
+   if (shader_prog) {
+      unsigned u;
+
+      for (u = 0; u < shader_prog->NumUniformStorage; u++) {
+         const struct gl_uniform_storage *storage =
+            &shader_prog->UniformStorage[u];
+
+         base = (uintptr_t)storage->storage;
+         size = uniform_storage_components(storage) *
+                sizeof(union gl_constant_value);
+         if (size == 0 || up < base || up >= base + size)
+            continue;
+
+         const uint32_t off =
+            (uint32_t)((up - base) / sizeof(union gl_constant_value));
+         if (u >= (1u << 14) || off >= (1u << 16))
+            return false;
+
+         *out = (RELOC_STORAGE << RELOC_TYPE_SHIFT) | (u << 16) | off;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+/**
+ * Rebases one relocation against the current program's objects.  Returns
+ * false if the relocation doesn't fit them, which means the cached file is
+ * stale or corrupt and the load is abandoned.
+ */
+static bool
+decode_param_reloc(struct brw_context *brw,
+                   const struct brw_stage_prog_data *prog_data,
+                   const struct gl_program_parameter_list *plist,
+                   struct gl_shader_program *shader_prog,
+                   uint32_t reloc,
+                   const union gl_constant_value **out)
+{
+   if (reloc == RELOC_NULL) {
+      *out = NULL;
+      return true;
+   }
+
+   const uint32_t payload = reloc & RELOC_PAYLOAD_MASK;
+
+   switch (RELOC_TYPE(reloc)) {
+   case RELOC_PARAM_LIST:
+      if (!plist || payload >= plist->NumParameters * 4)
+         return false;
+      *out = (const union gl_constant_value *)plist->ParameterValues + payload;
+      return true;
+
+   case RELOC_STORAGE: {
+      const uint32_t u = payload >> 16;
+      const uint32_t off = payload & 0xffff;
+
+      if (!shader_prog || u >= shader_prog->NumUniformStorage)
+         return false;
+
+      const struct gl_uniform_storage *storage =
+         &shader_prog->UniformStorage[u];
+      if (off >= uniform_storage_components(storage))
+         return false;
+
+      *out = storage->storage + off;
+      return true;
+   }
+
+   case RELOC_MISC: {
+      const uint32_t off = payload & 0xffff;
+
+      switch (payload >> 16) {
+      case RELOC_MISC_ZERO:
+         *out = &brw_param_zero;
+         return true;
+      case RELOC_MISC_EYE_PLANE:
+         if (off >= ARRAY_SIZE(brw->ctx.Transform.EyeUserPlane) * 4)
+            return false;
+         *out = (const union gl_constant_value *)
+                brw->ctx.Transform.EyeUserPlane + off;
+         return true;
+      case RELOC_MISC_CLIP_PLANE:
+         if (off >= ARRAY_SIZE(brw->ctx.Transform._ClipUserPlane) * 4)
+            return false;
+         *out = (const union gl_constant_value *)
+                brw->ctx.Transform._ClipUserPlane + off;
+         return true;
+      default:
+         return false;
+      }
+   }
+
+   case RELOC_IMAGE:
+      if (payload * 4 >= prog_data->nr_image_params *
+                         sizeof(struct brw_image_param))
+         return false;
+      *out = (const union gl_constant_value *)
+             ((const char *)prog_data->image_param + payload * 4);
+      return true;
+
+   default:
+      return false;
+   }
+}
+
+static bool
+write_all(int fd, const void *data, size_t size)
+{
+   const char *p = data;
+
+   while (size > 0) {
+      ssize_t written = write(fd, p, size);
+
+      if (written <= 0) {
+         if (errno == EINTR)
+            continue;
+         return false;
+      }
+      p += written;
+      size -= written;
+   }
+
+   return true;
+}
+
+void
+brw_disk_cache_store(struct brw_context *brw,
+                     enum brw_cache_id cache_id,
+                     const void *key, GLuint key_size,
+                     const void *data, GLuint data_size,
+                     const void *aux, GLuint aux_size,
+                     struct gl_shader_program *shader_prog,
+                     struct gl_program *prog)
+{
+   const struct brw_stage_prog_data *prog_data = aux;
+   const unsigned nr_relocs = prog_data->nr_params + prog_data->nr_pull_params;
+   struct brw_disk_cache_header header;
+   uint64_t hashes[2];
+   uint32_t *relocs = NULL;
+   void *key_copy;
+   char *path = NULL, *tmp_path = NULL;
+   unsigned i;
+   int fd = -1;
+
+   if (!brw_disk_cache_enabled(brw))
+      return;
+
+   key_copy = malloc(key_size);
+   if (!brw_disk_cache_hash(brw, cache_id, key, key_size, shader_prog, prog,
+                            key_copy, hashes))
+      goto out;
+
+   relocs = malloc(MAX2(nr_relocs, 1) * sizeof(*relocs));
+   for (i = 0; i < prog_data->nr_params; i++) {
+      if (!encode_param_reloc(brw, prog_data, prog->Parameters, shader_prog,
+                              prog_data->param[i], &relocs[i]))
+         goto out;
+   }
+   for (i = 0; i < prog_data->nr_pull_params; i++) {
+      if (!encode_param_reloc(brw, prog_data, prog->Parameters, shader_prog,
+                              prog_data->pull_param[i],
+                              &relocs[prog_data->nr_params + i]))
+         goto out;
+   }
+
+   path = ralloc_asprintf(NULL, "%s/%016" PRIx64 ".bin",
+                          brw->cache.disk_cache_dir, hashes[0]);
+   if (access(path, F_OK) == 0)
+      goto out;
+
+   tmp_path = ralloc_asprintf(NULL, "%s/tmpXXXXXX",
+                              brw->cache.disk_cache_dir);
+   fd = mkstemp(tmp_path);
+   if (fd < 0)
+      goto out;
+
+   memset(&header, 0, sizeof(header));
+   header.magic = BRW_DISK_CACHE_MAGIC;
+   header.version = BRW_DISK_CACHE_VERSION;
+   header.device_id = brw->intelScreen->deviceID;
+   header.cache_id = cache_id;
+   header.key_size = key_size;
+   header.data_size = data_size;
+   header.aux_size = aux_size;
+   header.check_hash = hashes[1];
+
+   if (write_all(fd, &header, sizeof(header)) &&
+       write_all(fd, key_copy, key_size) &&
+       write_all(fd, data, data_size) &&
+       write_all(fd, aux, aux_size) &&
+       write_all(fd, relocs, nr_relocs * sizeof(*relocs)) &&
+       write_all(fd, prog_data->image_param,
+                 prog_data->nr_image_params *
+                 sizeof(struct brw_image_param)) &&
+       rename(tmp_path, path) == 0) {
+      DBG("stored program %016" PRIx64 " in the disk cache\n", hashes[0]);
+   } else {
+      unlink(tmp_path);
+   }
+   close(fd);
+
+ out:
+   ralloc_free(tmp_path);
+   ralloc_free(path);
+   free(relocs);
+   free(key_copy);
+}
+
+bool
+brw_disk_cache_search(struct brw_context *brw,
+                      enum brw_cache_id cache_id,
+                      const void *key, GLuint key_size, GLuint aux_size,
+                      struct gl_shader_program *shader_prog,
+                      struct gl_program *prog,
+                      uint32_t *out_offset, void *out_aux)
+{
+   const struct brw_disk_cache_header *header;
+   struct brw_stage_prog_data *prog_data = NULL;
+   const union gl_constant_value **param = NULL, **pull_param = NULL;
+   struct brw_image_param *image_param = NULL;
+   uint64_t hashes[2];
+   void *key_copy, *buf = NULL;
+   char *path = NULL;
+   const char *file_key, *data, *image_data;
+   const uint32_t *relocs;
+   struct stat st;
+   size_t expected_size;
+   bool found = false;
+   unsigned i;
+   int fd = -1;
+
+   if (!brw_disk_cache_enabled(brw))
+      return false;
+
+   key_copy = malloc(key_size);
+   if (!brw_disk_cache_hash(brw, cache_id, key, key_size, shader_prog, prog,
+                            key_copy, hashes))
+      goto out;
+
+   path = ralloc_asprintf(NULL, "%s/%016" PRIx64 ".bin",
+                          brw->cache.disk_cache_dir, hashes[0]);
+   fd = open(path, O_RDONLY);
+   if (fd < 0)
+      goto out;
+
+   if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(*header))
+      goto out;
+
+   buf = malloc(st.st_size);
+   if (read(fd, buf, st.st_size) != st.st_size)
+      goto out;
+
+   header = buf;
+   if (header->magic != BRW_DISK_CACHE_MAGIC ||
+       header->version != BRW_DISK_CACHE_VERSION ||
+       header->device_id != brw->intelScreen->deviceID ||
+       header->cache_id != (uint32_t)cache_id ||
+       header->key_size != key_size ||
+       header->aux_size != aux_size ||
+       header->check_hash != hashes[1])
+      goto out;
+
+   file_key = (const char *)buf + sizeof(*header);
+   if (memcmp(file_key, key_copy, key_size) != 0)
+      goto out;
+
+   data = file_key + key_size;
+
+   /* The param counts come out of the aux blob itself, so copy it to
+    * aligned storage before believing anything in it.
+    */
+   prog_data = malloc(aux_size);
+   memcpy(prog_data, data + header->data_size, aux_size);
+
+   const unsigned nr_relocs = prog_data->nr_params +
+                              prog_data->nr_pull_params;
+   expected_size = sizeof(*header) + key_size + header->data_size +
+                   aux_size + nr_relocs * sizeof(uint32_t) +
+                   prog_data->nr_image_params *
+                   sizeof(struct brw_image_param);
+   if ((size_t)st.st_size != expected_size)
+      goto out;
+
+   relocs = (const uint32_t *)(data + header->data_size + aux_size);
+   image_data = (const char *)(relocs + nr_relocs);
+
+   param = rzalloc_array(NULL, const union gl_constant_value *,
+                         prog_data->nr_params);
+   pull_param = rzalloc_array(NULL, const union gl_constant_value *,
+                              prog_data->nr_pull_params);
+   image_param = rzalloc_array(NULL, struct brw_image_param,
+                               prog_data->nr_image_params);
+   memcpy(image_param, image_data,
+          prog_data->nr_image_params * sizeof(struct brw_image_param));
+   prog_data->image_param = image_param;
+
+   for (i = 0; i < prog_data->nr_params; i++) {
+      if (!decode_param_reloc(brw, prog_data, prog->Parameters, shader_prog,
+                              relocs[i], &param[i]))
+         goto out;
+   }
+   for (i = 0; i < prog_data->nr_pull_params; i++) {
+      if (!decode_param_reloc(brw, prog_data, prog->Parameters, shader_prog,
+                              relocs[prog_data->nr_params + i],
+                              &pull_param[i]))
+         goto out;
+   }
+
+   prog_data->param = param;
+   prog_data->pull_param = pull_param;
+
+   /* Insert it into the in-memory cache; the param arrays now belong to
+    * the cache item and are freed with it by brw_stage_prog_data_free().
+    */
+   brw_upload_cache(&brw->cache, cache_id, key, key_size,
+                    data, header->data_size, prog_data, aux_size,
+                    out_offset, out_aux);
+
+   DBG("loaded program %016" PRIx64 " from the disk cache\n", hashes[0]);
+   param = NULL;
+   pull_param = NULL;
+   image_param = NULL;
+   found = true;
+
+ out:
+   if (fd >= 0)
+      close(fd);
+   ralloc_free(image_param);
+   ralloc_free(pull_param);
+   ralloc_free(param);
+   free(prog_data);
+   free(buf);
+   ralloc_free(path);
+   free(key_copy);
+   return found;
+}
+
+void
+brw_disk_cache_init(struct brw_context *brw)
+{
+   const char *dir = getenv("MESA_SHADER_CACHE_DIR");
+
+   if (dir == NULL || dir[0] == '\0')
+      return;
+
+   if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+      return;
+
+   brw->cache.disk_cache_dir = strdup(dir);
+}
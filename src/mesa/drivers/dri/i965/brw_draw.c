@@ -586,7 +586,8 @@ retry:
 
       brw->no_batch_wrap = false;
 
-      if (dri_bufmgr_check_aperture_space(&brw->batch.bo, 1)) {
+      drm_intel_bo *aper_array[] = { brw->batch.bo, brw->batch.state_bo };
+      if (dri_bufmgr_check_aperture_space(aper_array, 2)) {
 	 if (!fail_next) {
 	    intel_batchbuffer_reset_to_saved(brw);
 	    intel_batchbuffer_flush(brw);
@@ -669,6 +669,19 @@ static const uint32_t *datatype_table;
 static const uint16_t *subreg_table;
 static const uint16_t *src_index_table;
 
+/* The generator emits long runs of the same instruction template (the same
+ * MOV/ADD/MAD/SEND execution controls and datatypes), so the table entry an
+ * instruction compacts to is almost always the one its predecessor used.
+ * Remember the last match per table and try it before the linear search.
+ * The cached index is verified against the uncompacted value before use, so
+ * a stale value (e.g. from another thread) only costs the search.
+ */
+static int last_control_index;
+static int last_datatype_index;
+static int last_subreg_index;
+static int last_src0_index;
+static int last_src1_index;
+
 static bool
 set_control_index(const struct brw_device_info *devinfo,
                   brw_compact_inst *dst, brw_inst *src)
@@ -688,8 +701,14 @@ set_control_index(const struct brw_device_info *devinfo,
    if (devinfo->gen == 7)
       uncompacted |= brw_inst_bits(src, 90, 89) << 17; /* 2b */
 
+   if (control_index_table[last_control_index] == uncompacted) {
+      brw_compact_inst_set_control_index(devinfo, dst, last_control_index);
+      return true;
+   }
+
    for (int i = 0; i < 32; i++) {
       if (control_index_table[i] == uncompacted) {
+         last_control_index = i;
          brw_compact_inst_set_control_index(devinfo, dst, i);
 	 return true;
       }
@@ -709,8 +728,14 @@ set_datatype_index(const struct brw_device_info *devinfo, brw_compact_inst *dst,
       : (brw_inst_bits(src, 63, 61) << 15) | /*  3b */
         (brw_inst_bits(src, 46, 32));        /* 15b */
 
+   if (datatype_table[last_datatype_index] == uncompacted) {
+      brw_compact_inst_set_datatype_index(devinfo, dst, last_datatype_index);
+      return true;
+   }
+
    for (int i = 0; i < 32; i++) {
       if (datatype_table[i] == uncompacted) {
+         last_datatype_index = i;
          brw_compact_inst_set_datatype_index(devinfo, dst, i);
 	 return true;
       }
@@ -730,8 +755,14 @@ set_subreg_index(const struct brw_device_info *devinfo, brw_compact_inst *dst,
    if (!is_immediate)
       uncompacted |= brw_inst_bits(src, 100, 96) << 10; /* 5b */
 
+   if (subreg_table[last_subreg_index] == uncompacted) {
+      brw_compact_inst_set_subreg_index(devinfo, dst, last_subreg_index);
+      return true;
+   }
+
    for (int i = 0; i < 32; i++) {
       if (subreg_table[i] == uncompacted) {
+         last_subreg_index = i;
          brw_compact_inst_set_subreg_index(devinfo, dst, i);
 	 return true;
       }
@@ -742,10 +773,16 @@ set_subreg_index(const struct brw_device_info *devinfo, brw_compact_inst *dst,
 
 static bool
 get_src_index(uint16_t uncompacted,
-              uint16_t *compacted)
+              uint16_t *compacted, int *last)
 {
+   if (src_index_table[*last] == uncompacted) {
+      *compacted = *last;
+      return true;
+   }
+
    for (int i = 0; i < 32; i++) {
       if (src_index_table[i] == uncompacted) {
+         *last = i;
 	 *compacted = i;
 	 return true;
       }
@@ -761,7 +798,7 @@ set_src0_index(const struct brw_device_info *devinfo,
    uint16_t compacted;
    uint16_t uncompacted = brw_inst_bits(src, 88, 77); /* 12b */
 
-   if (!get_src_index(uncompacted, &compacted))
+   if (!get_src_index(uncompacted, &compacted, &last_src0_index))
       return false;
 
    brw_compact_inst_set_src0_index(devinfo, dst, compacted);
@@ -780,7 +817,7 @@ set_src1_index(const struct brw_device_info *devinfo, brw_compact_inst *dst,
    } else {
       uint16_t uncompacted = brw_inst_bits(src, 120, 109); /* 12b */
 
-      if (!get_src_index(uncompacted, &compacted))
+      if (!get_src_index(uncompacted, &compacted, &last_src1_index))
          return false;
    }
 
@@ -1468,6 +1505,16 @@ brw_compact_instructions(struct brw_codegen *p, int start_offset,
       }
    }
 
+   if (unlikely(INTEL_DEBUG & DEBUG_COMPILE_STATS)) {
+      int old_size = p->next_insn_offset - start_offset;
+      int total = old_size / sizeof(brw_inst);
+      fprintf(stderr, "BRW-COMPACT-STATS: insns=%d compacted=%d (%.0f%%)"
+              " bytes=%d->%d\n",
+              total, compacted_count,
+              total ? compacted_count * 100.0 / total : 0.0,
+              old_size, offset);
+   }
+
    /* Fix up control flow offsets. */
    p->next_insn_offset = start_offset + offset;
    for (offset = 0; offset < p->next_insn_offset - start_offset;
@@ -425,6 +425,17 @@ void fs_visitor::calculate_payload_ranges(int payload_node_count,
  * And we have payload_node_count nodes covering these registers in order
  * (note that in SIMD16, a node is two registers).
  */
+struct ip_order {
+   int ip;
+   unsigned int n;
+};
+
+static int
+compare_ip(const void *a, const void *b)
+{
+   return ((const struct ip_order *)a)->ip - ((const struct ip_order *)b)->ip;
+}
+
 void
 fs_visitor::setup_payload_interference(struct ra_graph *g,
                                        int payload_node_count,
@@ -433,25 +444,54 @@ fs_visitor::setup_payload_interference(struct ra_graph *g,
    int payload_last_use_ip[payload_node_count];
    calculate_payload_ranges(payload_node_count, payload_last_use_ip);
 
+   /* Mark each payload node as interfering with any virtual grf that is
+    * live between the start of the program and our last use of the payload
+    * node.  Rather than scanning every VGRF for every payload node, walk
+    * the payload nodes in order of increasing last use and the VGRFs in
+    * order of increasing start IP, accumulating the interference row as
+    * VGRFs come into range.
+    *
+    * Note that we use a <= comparison, unlike virtual_grf_interferes(),
+    * in order to not have to worry about the uniform issue described in
+    * calculate_live_intervals().
+    */
+   struct ip_order payload_order[payload_node_count];
+   for (int i = 0; i < payload_node_count; i++) {
+      payload_order[i].ip = payload_last_use_ip[i];
+      payload_order[i].n = i;
+   }
+   qsort(payload_order, payload_node_count, sizeof(payload_order[0]),
+         compare_ip);
+
+   struct ip_order *vgrf_order =
+      ralloc_array(NULL, struct ip_order, this->alloc.count);
+   for (unsigned j = 0; j < this->alloc.count; j++) {
+      vgrf_order[j].ip = this->virtual_grf_start[j];
+      vgrf_order[j].n = j;
+   }
+   qsort(vgrf_order, this->alloc.count, sizeof(vgrf_order[0]), compare_ip);
+
+   BITSET_WORD *row =
+      rzalloc_array(NULL, BITSET_WORD, BITSET_WORDS(this->alloc.count));
+   unsigned next_vgrf = 0;
+
    for (int i = 0; i < payload_node_count; i++) {
-      if (payload_last_use_ip[i] == -1)
+      if (payload_order[i].ip == -1)
          continue;
 
-      /* Mark the payload node as interfering with any virtual grf that is
-       * live between the start of the program and our last use of the payload
-       * node.
-       */
-      for (unsigned j = 0; j < this->alloc.count; j++) {
-         /* Note that we use a <= comparison, unlike virtual_grf_interferes(),
-          * in order to not have to worry about the uniform issue described in
-          * calculate_live_intervals().
-          */
-         if (this->virtual_grf_start[j] <= payload_last_use_ip[i]) {
-            ra_add_node_interference(g, first_payload_node + i, j);
-         }
+      while (next_vgrf < this->alloc.count &&
+             vgrf_order[next_vgrf].ip <= payload_order[i].ip) {
+         BITSET_SET(row, vgrf_order[next_vgrf].n);
+         next_vgrf++;
       }
+
+      ra_add_node_interference_row(g, first_payload_node + payload_order[i].n,
+                                   row, this->alloc.count);
    }
 
+   ralloc_free(row);
+   ralloc_free(vgrf_order);
+
    for (int i = 0; i < payload_node_count; i++) {
       /* Mark each payload node as being allocated to its physical register.
        *
@@ -518,6 +558,15 @@ setup_mrf_hack_interference(fs_visitor *v, struct ra_graph *g,
    bool mrf_used[BRW_MAX_MRF(v->devinfo->gen)];
    get_used_mrfs(v, mrf_used);
 
+   /* Since we don't have any live/dead analysis on the MRFs, every used MRF
+    * gets marked as conflicting with all virtual GRFs, so build the row of
+    * all of them once up front.
+    */
+   BITSET_WORD *vgrf_row =
+      ralloc_array(NULL, BITSET_WORD, BITSET_WORDS(v->alloc.count));
+   memset(vgrf_row, 0xff,
+          BITSET_WORDS(v->alloc.count) * sizeof(BITSET_WORD));
+
    *first_used_mrf = BRW_MAX_MRF(v->devinfo->gen);
    for (int i = 0; i < BRW_MAX_MRF(v->devinfo->gen); i++) {
       /* Mark each MRF reg node as being allocated to its physical register.
@@ -527,18 +576,16 @@ setup_mrf_hack_interference(fs_visitor *v, struct ra_graph *g,
        */
       ra_set_node_reg(g, first_mrf_node + i, GEN7_MRF_HACK_START + i);
 
-      /* Since we don't have any live/dead analysis on the MRFs, just mark all
-       * that are used as conflicting with all virtual GRFs.
-       */
       if (mrf_used[i]) {
          if (i < *first_used_mrf)
             *first_used_mrf = i;
 
-         for (unsigned j = 0; j < v->alloc.count; j++) {
-            ra_add_node_interference(g, first_mrf_node + i, j);
-         }
+         ra_add_node_interference_row(g, first_mrf_node + i, vgrf_row,
+                                      v->alloc.count);
       }
    }
+
+   ralloc_free(vgrf_row);
 }
 
 bool
@@ -183,15 +183,79 @@ process_glsl_ir(gl_shader_stage stage,
    }
 }
 
+struct brw_link_stage_job {
+   struct brw_context *brw;
+   struct gl_shader_program *shProg;
+   struct gl_shader *shader;
+   struct gl_program *prog;
+   struct util_queue_fence fence;
+};
+
+static void
+brw_link_stage_execute(void *data, int thread_index)
+{
+   struct brw_link_stage_job *job = (struct brw_link_stage_job *) data;
+   struct brw_context *brw = job->brw;
+   const struct brw_compiler *compiler = brw->intelScreen->compiler;
+   struct gl_shader *shader = job->shader;
+   struct gl_program *prog = job->prog;
+
+   process_glsl_ir(shader->Stage, brw, job->shProg, shader);
+
+   /* Make a pass over the IR to add state references for any built-in
+    * uniforms that are used.  This has to be done now (during linking).
+    * Code generation doesn't happen until the first time this shader is
+    * used for rendering.  Waiting until then to generate the parameters is
+    * too late.  At that point, the values for the built-in uniforms won't
+    * get sent to the shader.
+    */
+   foreach_in_list(ir_instruction, node, shader->ir) {
+      ir_variable *var = node->as_variable();
+
+      if ((var == NULL) || (var->data.mode != ir_var_uniform)
+          || (strncmp(var->name, "gl_", 3) != 0))
+         continue;
+
+      const ir_state_slot *const slots = var->get_state_slots();
+      assert(slots != NULL);
+
+      for (unsigned int i = 0; i < var->get_num_state_slots(); i++) {
+         _mesa_add_state_reference(prog->Parameters,
+                                   (gl_state_index *) slots[i].tokens);
+      }
+   }
+
+   do_set_program_inouts(shader->ir, prog, shader->Stage);
+
+   prog->SamplersUsed = shader->active_samplers;
+   prog->ShadowSamplers = shader->shadow_samplers;
+
+   brw_add_texrect_params(prog);
+
+   prog->nir = brw_create_nir(brw, job->shProg, prog, shader->Stage,
+                              compiler->scalar_stage[shader->Stage]);
+}
+
 extern "C" GLboolean
 brw_link_shader(struct gl_context *ctx, struct gl_shader_program *shProg)
 {
    struct brw_context *brw = brw_context(ctx);
-   const struct brw_compiler *compiler = brw->intelScreen->compiler;
+   struct brw_link_stage_job jobs[MESA_SHADER_STAGES];
    unsigned int stage;
 
+   /* Debug output has to stay ordered and KHR_debug callbacks have to come
+    * from the application thread, so only go wide when not debugging.
+    */
+   const bool use_queue = util_queue_is_initialized(&brw->compile_queue) &&
+                          !brw->perf_debug &&
+                          !(ctx->_Shader->Flags & GLSL_DUMP);
+
+   /* Create all the gl_programs up front so that a failure doesn't leave
+    * stage jobs in flight.
+    */
    for (stage = 0; stage < ARRAY_SIZE(shProg->_LinkedShaders); stage++) {
       struct gl_shader *shader = shProg->_LinkedShaders[stage];
+      jobs[stage].prog = NULL;
       if (!shader)
 	 continue;
 
@@ -204,44 +268,39 @@ brw_link_shader(struct gl_context *ctx, struct gl_shader_program *shProg)
 
       _mesa_copy_linked_program_data((gl_shader_stage) stage, shProg, prog);
 
-      process_glsl_ir((gl_shader_stage) stage, brw, shProg, shader);
-
-      /* Make a pass over the IR to add state references for any built-in
-       * uniforms that are used.  This has to be done now (during linking).
-       * Code generation doesn't happen until the first time this shader is
-       * used for rendering.  Waiting until then to generate the parameters is
-       * too late.  At that point, the values for the built-in uniforms won't
-       * get sent to the shader.
-       */
-      foreach_in_list(ir_instruction, node, shader->ir) {
-	 ir_variable *var = node->as_variable();
-
-	 if ((var == NULL) || (var->data.mode != ir_var_uniform)
-	     || (strncmp(var->name, "gl_", 3) != 0))
-	    continue;
-
-	 const ir_state_slot *const slots = var->get_state_slots();
-	 assert(slots != NULL);
-
-	 for (unsigned int i = 0; i < var->get_num_state_slots(); i++) {
-	    _mesa_add_state_reference(prog->Parameters,
-				      (gl_state_index *) slots[i].tokens);
-	 }
-      }
-
-      do_set_program_inouts(shader->ir, prog, shader->Stage);
-
-      prog->SamplersUsed = shader->active_samplers;
-      prog->ShadowSamplers = shader->shadow_samplers;
-      _mesa_update_shader_textures_used(shProg, prog);
+      jobs[stage].brw = brw;
+      jobs[stage].shProg = shProg;
+      jobs[stage].shader = shader;
+      jobs[stage].prog = prog;
+   }
 
-      _mesa_reference_program(ctx, &shader->Program, prog);
+   /* The per-stage work only touches its own gl_shader and gl_program, so
+    * the stages can be processed in parallel.
+    */
+   for (stage = 0; stage < ARRAY_SIZE(shProg->_LinkedShaders); stage++) {
+      if (!jobs[stage].prog)
+         continue;
+
+      util_queue_fence_init(&jobs[stage].fence);
+      if (use_queue) {
+         util_queue_add_job(&brw->compile_queue, &jobs[stage],
+                            &jobs[stage].fence, brw_link_stage_execute, NULL);
+      } else {
+         brw_link_stage_execute(&jobs[stage], -1);
+      }
+   }
 
-      brw_add_texrect_params(prog);
+   for (stage = 0; stage < ARRAY_SIZE(shProg->_LinkedShaders); stage++) {
+      if (!jobs[stage].prog)
+         continue;
 
-      prog->nir = brw_create_nir(brw, shProg, prog, (gl_shader_stage) stage,
-                                 compiler->scalar_stage[stage]);
+      util_queue_fence_wait(&jobs[stage].fence);
+      util_queue_fence_destroy(&jobs[stage].fence);
 
+      /* Now finish the bits that touch state shared between the stages. */
+      struct gl_program *prog = jobs[stage].prog;
+      _mesa_update_shader_textures_used(shProg, prog);
+      _mesa_reference_program(ctx, &jobs[stage].shader->Program, prog);
       _mesa_reference_program(ctx, &prog, NULL);
    }
 
@@ -400,8 +400,7 @@ nir_optimize(nir_shader *nir, bool is_scalar)
       }
 
       OPT(nir_copy_prop);
-      OPT(nir_opt_dce);
-      OPT(nir_opt_cse);
+      OPT(nir_opt_dce_cse);
       OPT(nir_opt_peephole_select);
       OPT(nir_opt_algebraic);
       OPT(nir_opt_constant_folding);
@@ -420,6 +419,12 @@ nir_optimize(nir_shader *nir, bool is_scalar)
       OPT_V(nir_lower_double_pack);
    } while (progress);
 
+   /* The fused DCE+CSE above only sweeps code that became dead in its own
+    * wake, so do one full mark-and-sweep pass at the end to catch anything
+    * the other passes orphaned.
+    */
+   OPT(nir_opt_dce);
+
    return nir;
 }
 
@@ -534,6 +539,10 @@ brw_postprocess_nir(nir_shader *nir,
    if (devinfo->gen <= 5)
       brw_nir_analyze_boolean_resolves(nir);
 
+   /* Pack the surviving instructions back into program order before the
+    * backend walks them.
+    */
+   nir_compact(nir);
    nir_sweep(nir);
 
    if (unlikely(debug_enabled)) {
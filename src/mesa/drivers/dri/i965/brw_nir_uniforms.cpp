@@ -118,10 +118,8 @@ brw_nir_setup_glsl_uniform(gl_shader_stage stage, nir_variable *var,
 
             if (!is_scalar) {
                /* Pad out with zeros if needed (only needed for vec4) */
-               for (; i < max_vector_size; i++) {
-                  static const gl_constant_value zero = { 0.0 };
-                  stage_prog_data->param[uniform_index++] = &zero;
-               }
+               for (; i < max_vector_size; i++)
+                  stage_prog_data->param[uniform_index++] = &brw_param_zero;
             }
          }
       }
@@ -174,9 +172,7 @@ brw_nir_setup_arb_uniforms(nir_shader *shader, struct gl_program *prog,
       for (i = 0; i < plist->Parameters[p].Size; i++) {
          stage_prog_data->param[4 * p + i] = &plist->ParameterValues[p][i];
       }
-      for (; i < 4; i++) {
-         static const gl_constant_value zero = { 0.0 };
-         stage_prog_data->param[4 * p + i] = &zero;
-      }
+      for (; i < 4; i++)
+         stage_prog_data->param[4 * p + i] = &brw_param_zero;
    }
 }
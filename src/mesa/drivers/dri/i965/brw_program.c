@@ -549,6 +549,8 @@ brw_destroy_shader_time(struct brw_context *brw)
    brw->shader_time.bo = NULL;
 }
 
+const union gl_constant_value brw_param_zero = { 0.0 };
+
 void
 brw_stage_prog_data_free(const void *p)
 {
@@ -102,10 +102,10 @@ brw_emit_sampler_state(struct brw_context *brw,
 
    ss[2] = border_color_offset;
    if (brw->gen < 6) {
-      ss[2] += brw->batch.bo->offset64; /* reloc */
-      drm_intel_bo_emit_reloc(brw->batch.bo,
+      ss[2] += brw->batch.state_bo->offset64; /* reloc */
+      drm_intel_bo_emit_reloc(brw->batch.state_bo,
                               batch_offset_for_sampler_state + 8,
-                              brw->batch.bo, border_color_offset,
+                              brw->batch.state_bo, border_color_offset,
                               I915_GEM_DOMAIN_SAMPLER, 0);
    }
 
@@ -1337,6 +1337,7 @@ brw_compile_tes(const struct brw_compiler *compiler,
                 unsigned *final_assembly_size,
                 char **error_str)
 {
+   const int64_t stats_start = intel_compile_stats_begin();
    const struct brw_device_info *devinfo = compiler->devinfo;
    struct gl_shader *shader =
       shader_prog->_LinkedShaders[MESA_SHADER_TESS_EVAL];
@@ -1416,7 +1417,11 @@ brw_compile_tes(const struct brw_compiler *compiler,
 
       g.generate_code(v.cfg, 8);
 
-      return g.get_assembly(final_assembly_size);
+      const unsigned *assembly = g.get_assembly(final_assembly_size);
+
+      intel_compile_stats_end("tes", stats_start, *final_assembly_size);
+
+      return assembly;
    } else {
       brw::vec4_tes_visitor v(compiler, log_data, key, prog_data,
 			      nir, mem_ctx, shader_time_index);
@@ -1429,8 +1434,13 @@ brw_compile_tes(const struct brw_compiler *compiler,
       if (unlikely(INTEL_DEBUG & DEBUG_TES))
 	 v.dump_instructions();
 
-      return brw_vec4_generate_assembly(compiler, log_data, mem_ctx, nir,
-					&prog_data->base, v.cfg,
-					final_assembly_size);
+      const unsigned *assembly =
+	 brw_vec4_generate_assembly(compiler, log_data, mem_ctx, nir,
+				    &prog_data->base, v.cfg,
+				    final_assembly_size);
+
+      intel_compile_stats_end("tes", stats_start, *final_assembly_size);
+
+      return assembly;
    }
 }
@@ -244,6 +244,25 @@ void brw_state_cache_check_size( struct brw_context *brw );
 void brw_init_caches( struct brw_context *brw );
 void brw_destroy_caches( struct brw_context *brw );
 
+/***********************************************************************
+ * brw_disk_cache.c
+ */
+
+void brw_disk_cache_init(struct brw_context *brw);
+bool brw_disk_cache_search(struct brw_context *brw,
+                           enum brw_cache_id cache_id,
+                           const void *key, GLuint key_size, GLuint aux_size,
+                           struct gl_shader_program *shader_prog,
+                           struct gl_program *prog,
+                           uint32_t *out_offset, void *out_aux);
+void brw_disk_cache_store(struct brw_context *brw,
+                          enum brw_cache_id cache_id,
+                          const void *key, GLuint key_size,
+                          const void *data, GLuint data_size,
+                          const void *aux, GLuint aux_size,
+                          struct gl_shader_program *shader_prog,
+                          struct gl_program *prog);
+
 /***********************************************************************
  * brw_state_batch.c
  */
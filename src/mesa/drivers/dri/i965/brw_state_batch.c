@@ -48,7 +48,7 @@ brw_track_state_batch(struct brw_context *brw,
        * our array doesn't need to be any larger
        */
       brw->state_batch_list = ralloc_size(brw, sizeof(*brw->state_batch_list) *
-					  batch->bo->size / 32);
+					  batch->state_bo->size / 32);
    }
 
    brw->state_batch_list[brw->state_batch_count].offset = offset;
@@ -76,9 +76,9 @@ make_annotation(drm_intel_aub_annotation *annotation, uint32_t type,
  * deliver them to DRM.
  *
  * The "used" section of the batch buffer (the portion containing batch
- * commands) is annotated with AUB_TRACE_TYPE_BATCH.  The remainder of the
- * batch buffer (which contains data structures pointed to by batch commands)
- * is annotated according to the type of each data structure.
+ * commands) is annotated with AUB_TRACE_TYPE_BATCH.  The state buffer
+ * (which contains data structures pointed to by batch commands) is
+ * annotated according to the type of each data structure.
  */
 void
 brw_annotate_aub(struct brw_context *brw)
@@ -88,6 +88,9 @@ brw_annotate_aub(struct brw_context *brw)
    int a = 0;
    make_annotation(&annotations[a++], AUB_TRACE_TYPE_BATCH, 0,
                    4 * USED_BATCH(brw->batch));
+   drm_intel_bufmgr_gem_set_aub_annotations(brw->batch.bo, annotations, 1);
+
+   a = 0;
    for (int i = brw->state_batch_count; i-- > 0; ) {
       uint32_t type = brw->state_batch_list[i].type;
       uint32_t start_offset = brw->state_batch_list[i].offset;
@@ -97,24 +100,27 @@ brw_annotate_aub(struct brw_context *brw)
       make_annotation(&annotations[a++], AUB_TRACE_TYPE(type),
                       AUB_TRACE_SUBTYPE(type), end_offset);
    }
-   assert(a == annotation_count);
-   drm_intel_bufmgr_gem_set_aub_annotations(brw->batch.bo, annotations,
-                                            annotation_count);
+   assert(a == annotation_count - 1);
+   drm_intel_bufmgr_gem_set_aub_annotations(brw->batch.state_bo, annotations,
+                                            annotation_count - 1);
 }
 
 /**
- * Allocates a block of space in the batchbuffer for indirect state.
+ * Allocates a block of space in the state buffer for indirect state.
  *
  * We don't want to allocate separate BOs for every bit of indirect
  * state in the driver.  It means overallocating by a significant
  * margin (4096 bytes, even if the object is just a 20-byte surface
  * state), and more buffers to walk and count for aperture size checking.
+ * So, all indirect state shares one BO per batch, which the batch
+ * references through STATE_BASE_ADDRESS (and, on gen4, through direct
+ * state pointer relocations).  The aperture checks before each draw pass
+ * the state BO explicitly so its relocation tree is counted even as more
+ * relocations are added to it afterwards.
  *
- * However, due to the restrictions imposed by the aperture size
- * checking performance hacks, we can't have the batch point at a
- * separate indirect state buffer, because once the batch points at
- * it, no more relocations can be added to it.  So, we sneak these
- * buffers in at the top of the batchbuffer.
+ * Since the commands and the state no longer share one BO, filling this
+ * buffer is the only thing (besides command bytes themselves) that can
+ * force a batch flush mid-frame.
  */
 void *
 __brw_state_batch(struct brw_context *brw,
@@ -128,15 +134,13 @@ __brw_state_batch(struct brw_context *brw,
    struct intel_batchbuffer *batch = &brw->batch;
    uint32_t offset;
 
-   assert(size < batch->bo->size);
+   assert(size < batch->state_bo->size);
    offset = ROUND_DOWN_TO(batch->state_batch_offset - size, alignment);
 
-   /* If allocating from the top would wrap below the batchbuffer, or
-    * if the batch's used space (plus the reserved pad) collides with our
-    * space, then flush and try again.
+   /* If allocating from the top would wrap below the start of the state
+    * buffer, then flush and try again.
     */
-   if (batch->state_batch_offset < size ||
-       offset < 4 * USED_BATCH(*batch) + batch->reserved_space) {
+   if (batch->state_batch_offset < size) {
       intel_batchbuffer_flush(brw);
       offset = ROUND_DOWN_TO(batch->state_batch_offset - size, alignment);
    }
@@ -147,5 +151,5 @@ __brw_state_batch(struct brw_context *brw,
       brw_track_state_batch(brw, type, offset, size, index);
 
    *out_offset = offset;
-   return batch->map + (offset>>2);
+   return batch->state_map + (offset>>2);
 }
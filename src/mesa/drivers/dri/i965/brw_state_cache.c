@@ -352,6 +352,8 @@ brw_init_caches(struct brw_context *brw)
 				  4096, 64);
    if (brw->has_llc)
       drm_intel_gem_bo_map_unsynchronized(cache->bo);
+
+   brw_disk_cache_init(brw);
 }
 
 static void
@@ -440,6 +442,8 @@ brw_destroy_cache(struct brw_context *brw, struct brw_cache *cache)
    free(cache->items);
    cache->items = NULL;
    cache->size = 0;
+   free(cache->disk_cache_dir);
+   cache->disk_cache_dir = NULL;
 }
 
 
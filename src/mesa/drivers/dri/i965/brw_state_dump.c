@@ -77,7 +77,7 @@ static void
 batch_out(struct brw_context *brw, const char *name, uint32_t offset,
 	  int index, char *fmt, ...)
 {
-   uint32_t *data = brw->batch.bo->virtual + offset;
+   uint32_t *data = brw->batch.state_bo->virtual + offset;
    va_list va;
 
    fprintf(stderr, "0x%08x:      0x%08x: %8s: ",
@@ -91,7 +91,7 @@ static void
 batch_out64(struct brw_context *brw, const char *name, uint32_t offset,
             int index, char *fmt, ...)
 {
-   uint32_t *tmp = brw->batch.bo->virtual + offset;
+   uint32_t *tmp = brw->batch.state_bo->virtual + offset;
 
    /* Swap the dwords since we want to handle this as a 64b value, but the data
     * is typically emitted as dwords.
@@ -123,7 +123,7 @@ get_965_surfacetype(unsigned int surfacetype)
 static void dump_vs_state(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "VS_STATE";
-   struct brw_vs_unit_state *vs = brw->batch.bo->virtual + offset;
+   struct brw_vs_unit_state *vs = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0, "thread0\n");
    batch_out(brw, name, offset, 1, "thread1\n");
@@ -138,7 +138,7 @@ static void dump_vs_state(struct brw_context *brw, uint32_t offset)
 static void dump_gs_state(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "GS_STATE";
-   struct brw_gs_unit_state *gs = brw->batch.bo->virtual + offset;
+   struct brw_gs_unit_state *gs = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0, "thread0\n");
    batch_out(brw, name, offset, 1, "thread1\n");
@@ -153,7 +153,7 @@ static void dump_gs_state(struct brw_context *brw, uint32_t offset)
 static void dump_clip_state(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "CLIP_STATE";
-   struct brw_clip_unit_state *clip = brw->batch.bo->virtual + offset;
+   struct brw_clip_unit_state *clip = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0, "thread0\n");
    batch_out(brw, name, offset, 1, "thread1\n");
@@ -172,7 +172,7 @@ static void dump_clip_state(struct brw_context *brw, uint32_t offset)
 static void dump_sf_state(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "SF_STATE";
-   struct brw_sf_unit_state *sf = brw->batch.bo->virtual + offset;
+   struct brw_sf_unit_state *sf = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0, "thread0\n");
    batch_out(brw, name, offset, 1, "thread1\n");
@@ -188,7 +188,7 @@ static void dump_sf_state(struct brw_context *brw, uint32_t offset)
 static void dump_wm_state(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "WM_STATE";
-   struct brw_wm_unit_state *wm = brw->batch.bo->virtual + offset;
+   struct brw_wm_unit_state *wm = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0, "thread0\n");
    batch_out(brw, name, offset, 1, "thread1\n");
@@ -215,7 +215,7 @@ static void dump_wm_state(struct brw_context *brw, uint32_t offset)
 static void dump_surface_state(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "SURF";
-   uint32_t *surf = brw->batch.bo->virtual + offset;
+   uint32_t *surf = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0, "%s %s\n",
 	     get_965_surfacetype(GET_FIELD(surf[0], BRW_SURFACE_TYPE)),
@@ -239,7 +239,7 @@ static void dump_surface_state(struct brw_context *brw, uint32_t offset)
 static void dump_gen7_surface_state(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "SURF";
-   uint32_t *surf = brw->batch.bo->virtual + offset;
+   uint32_t *surf = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0, "%s %s %s\n",
              get_965_surfacetype(GET_FIELD(surf[0], BRW_SURFACE_TYPE)),
@@ -278,7 +278,7 @@ static float q_to_float(uint32_t data, int integer_end, int integer_start,
 static void
 dump_gen8_surface_state(struct brw_context *brw, uint32_t offset, int index)
 {
-   uint32_t *surf = brw->batch.bo->virtual + offset;
+   uint32_t *surf = brw->batch.state_bo->virtual + offset;
    int aux_mode = surf[6] & INTEL_MASK(2, 0);
    const char *aux_str;
    char *name;
@@ -355,7 +355,7 @@ dump_sdc(struct brw_context *brw, uint32_t offset)
    const char *name = "SDC";
 
    if (brw->gen >= 5 && brw->gen <= 6) {
-      struct gen5_sampler_default_color *sdc = (brw->batch.bo->virtual +
+      struct gen5_sampler_default_color *sdc = (brw->batch.state_bo->virtual +
                                                 offset);
       batch_out(brw, name, offset, 0, "unorm rgba\n");
       batch_out(brw, name, offset, 1, "r %f\n", sdc->f[0]);
@@ -370,7 +370,7 @@ dump_sdc(struct brw_context *brw, uint32_t offset)
       batch_out(brw, name, offset, 10, "s16 ba\n");
       batch_out(brw, name, offset, 11, "s8 rgba\n");
    } else {
-      float *sdc = brw->batch.bo->virtual + offset;
+      float *sdc = brw->batch.state_bo->virtual + offset;
       batch_out(brw, name, offset, 0, "r %f\n", sdc[0]);
       batch_out(brw, name, offset, 1, "g %f\n", sdc[1]);
       batch_out(brw, name, offset, 2, "b %f\n", sdc[2]);
@@ -382,7 +382,7 @@ static void dump_sampler_state(struct brw_context *brw,
 			       uint32_t offset, uint32_t size)
 {
    unsigned i;
-   uint32_t *samp = brw->batch.bo->virtual + offset;
+   uint32_t *samp = brw->batch.state_bo->virtual + offset;
 
    for (i = 0; i < size / 16; i++) {
       char name[20];
@@ -401,7 +401,7 @@ static void dump_sampler_state(struct brw_context *brw,
 static void gen7_dump_sampler_state(struct brw_context *brw,
                                     uint32_t offset, uint32_t size)
 {
-   const uint32_t *samp = brw->batch.bo->virtual + offset;
+   const uint32_t *samp = brw->batch.state_bo->virtual + offset;
    char name[20];
 
    for (int i = 0; i < size / 16; i++) {
@@ -442,7 +442,7 @@ static void dump_sf_viewport_state(struct brw_context *brw,
 				   uint32_t offset)
 {
    const char *name = "SF VP";
-   struct brw_sf_viewport *vp = brw->batch.bo->virtual + offset;
+   struct brw_sf_viewport *vp = brw->batch.state_bo->virtual + offset;
 
    assert(brw->gen < 7);
 
@@ -463,7 +463,7 @@ static void dump_clip_viewport_state(struct brw_context *brw,
 				     uint32_t offset)
 {
    const char *name = "CLIP VP";
-   struct brw_clipper_viewport *vp = brw->batch.bo->virtual + offset;
+   struct brw_clipper_viewport *vp = brw->batch.state_bo->virtual + offset;
 
    assert(brw->gen < 7);
 
@@ -477,7 +477,7 @@ static void dump_sf_clip_viewport_state(struct brw_context *brw,
 					uint32_t offset)
 {
    const char *name = "SF_CLIP VP";
-   struct gen7_sf_clip_viewport *vp = brw->batch.bo->virtual + offset;
+   struct gen7_sf_clip_viewport *vp = brw->batch.state_bo->virtual + offset;
 
    assert(brw->gen >= 7);
 
@@ -492,7 +492,7 @@ static void dump_sf_clip_viewport_state(struct brw_context *brw,
    batch_out(brw, name, offset, 9, "guardband ymin = %f\n", vp->guardband.ymin);
    batch_out(brw, name, offset, 10, "guardband ymax = %f\n", vp->guardband.ymax);
    if (brw->gen >= 8) {
-      float *cc_vp = brw->batch.bo->virtual + offset;
+      float *cc_vp = brw->batch.state_bo->virtual + offset;
       batch_out(brw, name, offset, 12, "Min extents: %.2fx%.2f\n",
                 cc_vp[12], cc_vp[14]);
       batch_out(brw, name, offset, 14, "Max extents: %.2fx%.2f\n",
@@ -504,7 +504,7 @@ static void dump_sf_clip_viewport_state(struct brw_context *brw,
 static void dump_cc_viewport_state(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "CC VP";
-   struct brw_cc_viewport *vp = brw->batch.bo->virtual + offset;
+   struct brw_cc_viewport *vp = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0, "min_depth = %f\n", vp->min_depth);
    batch_out(brw, name, offset, 1, "max_depth = %f\n", vp->max_depth);
@@ -513,7 +513,7 @@ static void dump_cc_viewport_state(struct brw_context *brw, uint32_t offset)
 static void dump_depth_stencil_state(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "D_S";
-   struct gen6_depth_stencil_state *ds = brw->batch.bo->virtual + offset;
+   struct gen6_depth_stencil_state *ds = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0,
 	     "stencil %sable, func %d, write %sable\n",
@@ -547,7 +547,7 @@ static void dump_cc_state_gen4(struct brw_context *brw, uint32_t offset)
 static void dump_cc_state_gen6(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "CC";
-   struct gen6_color_calc_state *cc = brw->batch.bo->virtual + offset;
+   struct gen6_color_calc_state *cc = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0,
 	     "alpha test format %s, round disable %d, stencil ref %d, "
@@ -574,7 +574,7 @@ static void dump_blend_state(struct brw_context *brw, uint32_t offset)
 static void
 gen8_dump_blend_state(struct brw_context *brw, uint32_t offset, uint32_t size)
 {
-   const uint32_t *blend = brw->batch.bo->virtual + offset;
+   const uint32_t *blend = brw->batch.state_bo->virtual + offset;
    const char *logicop[] =
    {
         "LOGICOP_CLEAR (BLACK)",
@@ -661,7 +661,7 @@ static void
 dump_scissor(struct brw_context *brw, uint32_t offset)
 {
    const char *name = "SCISSOR";
-   struct gen6_scissor_rect *scissor = brw->batch.bo->virtual + offset;
+   struct gen6_scissor_rect *scissor = brw->batch.state_bo->virtual + offset;
 
    batch_out(brw, name, offset, 0, "xmin %d, ymin %d\n",
 	     scissor->xmin, scissor->ymin);
@@ -673,8 +673,8 @@ static void
 dump_vs_constants(struct brw_context *brw, uint32_t offset, uint32_t size)
 {
    const char *name = "VS_CONST";
-   uint32_t *as_uint = brw->batch.bo->virtual + offset;
-   float *as_float = brw->batch.bo->virtual + offset;
+   uint32_t *as_uint = brw->batch.state_bo->virtual + offset;
+   float *as_float = brw->batch.state_bo->virtual + offset;
    int i;
 
    for (i = 0; i < size / 4; i += 4) {
@@ -689,8 +689,8 @@ static void
 dump_wm_constants(struct brw_context *brw, uint32_t offset, uint32_t size)
 {
    const char *name = "WM_CONST";
-   uint32_t *as_uint = brw->batch.bo->virtual + offset;
-   float *as_float = brw->batch.bo->virtual + offset;
+   uint32_t *as_uint = brw->batch.state_bo->virtual + offset;
+   float *as_float = brw->batch.state_bo->virtual + offset;
    int i;
 
    for (i = 0; i < size / 4; i += 4) {
@@ -706,7 +706,7 @@ static void dump_binding_table(struct brw_context *brw, uint32_t offset,
 {
    char name[20];
    int i;
-   uint32_t *data = brw->batch.bo->virtual + offset;
+   uint32_t *data = brw->batch.state_bo->virtual + offset;
 
    for (i = 0; i < size / 4; i++) {
       if (data[i] == 0)
@@ -875,9 +875,9 @@ dump_state_batch(struct brw_context *brw)
  */
 void brw_debug_batch(struct brw_context *brw)
 {
-   drm_intel_bo_map(brw->batch.bo, false);
+   drm_intel_bo_map(brw->batch.state_bo, false);
    dump_state_batch(brw);
-   drm_intel_bo_unmap(brw->batch.bo);
+   drm_intel_bo_unmap(brw->batch.state_bo);
 
    if (0)
       dump_prog_cache(brw);
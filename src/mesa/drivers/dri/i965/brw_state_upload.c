@@ -441,11 +441,33 @@ brw_copy_pipeline_atoms(struct brw_context *brw,
     */
    struct brw_tracked_state *context_atoms =
       (struct brw_tracked_state *) brw_get_pipeline_atoms(brw, pipeline);
+   struct brw_atom_listeners *listeners = &brw->atom_listeners[pipeline];
+
+   assert(num_atoms <= BRW_MAX_STATE_ATOMS);
+
+   memset(listeners, 0, sizeof(*listeners));
 
    for (int i = 0; i < num_atoms; i++) {
       context_atoms[i] = *atoms[i];
       assert(context_atoms[i].dirty.mesa | context_atoms[i].dirty.brw);
       assert(context_atoms[i].emit);
+
+      /* Record which atom each dirty bit concerns, so the upload loop can
+       * skip straight to the listening atoms.
+       */
+      GLbitfield mesa = context_atoms[i].dirty.mesa;
+      uint64_t brw_bits = context_atoms[i].dirty.brw;
+
+      while (mesa) {
+         const int b = ffs(mesa) - 1;
+         mesa &= ~(1u << b);
+         listeners->mesa[b][i / 64] |= 1ull << (i % 64);
+      }
+      while (brw_bits) {
+         const int b = ffsll(brw_bits) - 1;
+         brw_bits &= ~(1ull << b);
+         listeners->brw[b][i / 64] |= 1ull << (i % 64);
+      }
    }
 
    brw->num_atoms[pipeline] = num_atoms;
@@ -763,6 +785,39 @@ check_and_emit_atom(struct brw_context *brw,
    }
 }
 
+/**
+ * Adds the atoms listening to any dirty bit not yet accounted for to the
+ * candidate bitmap.  Called again after each emit, so state flagged by an
+ * atom only costs a scan of the newly set bits.
+ */
+static void
+gather_atom_candidates(const struct brw_atom_listeners *listeners,
+                       const struct brw_state_flags *state,
+                       struct brw_state_flags *accounted,
+                       uint64_t *candidates)
+{
+   GLbitfield mesa = state->mesa & ~accounted->mesa;
+   uint64_t brw_bits = state->brw & ~accounted->brw;
+   unsigned w;
+
+   while (mesa) {
+      const int b = ffs(mesa) - 1;
+      mesa &= ~(1u << b);
+      for (w = 0; w < BRW_ATOM_BITMAP_WORDS; w++)
+         candidates[w] |= listeners->mesa[b][w];
+   }
+
+   while (brw_bits) {
+      const int b = ffsll(brw_bits) - 1;
+      brw_bits &= ~(1ull << b);
+      for (w = 0; w < BRW_ATOM_BITMAP_WORDS; w++)
+         candidates[w] |= listeners->brw[b][w];
+   }
+
+   accounted->mesa = state->mesa;
+   accounted->brw = state->brw;
+}
+
 static inline void
 brw_upload_pipeline_state(struct brw_context *brw,
                           enum brw_pipeline pipeline)
@@ -868,10 +923,28 @@ brw_upload_pipeline_state(struct brw_context *brw,
       }
    }
    else {
-      for (i = 0; i < num_atoms; i++) {
-	 const struct brw_tracked_state *atom = &atoms[i];
-
-         check_and_emit_atom(brw, &state, atom);
+      /* Visit only the atoms listening to a flagged dirty bit, in list
+       * order.  Emitting an atom may flag more state, but only state that
+       * concerns atoms later in the list (the debug path above asserts
+       * exactly this), so extending the candidate set as we go is safe.
+       */
+      const struct brw_atom_listeners *listeners =
+         &brw->atom_listeners[pipeline];
+      uint64_t candidates[BRW_ATOM_BITMAP_WORDS] = { 0 };
+      struct brw_state_flags accounted = { 0, 0 };
+
+      gather_atom_candidates(listeners, &state, &accounted, candidates);
+
+      for (i = 0; i < BRW_ATOM_BITMAP_WORDS; i++) {
+         while (candidates[i]) {
+            const int b = ffsll(candidates[i]) - 1;
+            const struct brw_tracked_state *atom = &atoms[i * 64 + b];
+
+            candidates[i] &= ~(1ull << b);
+            atom->emit(brw);
+            merge_ctx_state(brw, &state);
+            gather_atom_candidates(listeners, &state, &accounted, candidates);
+         }
       }
    }
 
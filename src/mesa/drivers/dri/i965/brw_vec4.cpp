@@ -1662,8 +1662,7 @@ vec4_visitor::setup_uniforms(int reg)
          reralloc(NULL, stage_prog_data->param, const gl_constant_value *, 4);
       for (unsigned int i = 0; i < 4; i++) {
 	 unsigned int slot = this->uniforms * 4 + i;
-	 static gl_constant_value zero = { 0.0 };
-	 stage_prog_data->param[slot] = &zero;
+	 stage_prog_data->param[slot] = &brw_param_zero;
       }
 
       this->uniforms++;
@@ -2075,6 +2074,7 @@ brw_compile_vs(const struct brw_compiler *compiler, void *log_data,
                unsigned *final_assembly_size,
                char **error_str)
 {
+   const int64_t stats_start = intel_compile_stats_begin();
    const bool is_scalar = compiler->scalar_stage[MESA_SHADER_VERTEX];
    nir_shader *shader = nir_shader_clone(mem_ctx, src_shader);
    shader = brw_nir_apply_sampler_key(shader, compiler->devinfo, &key->tex,
@@ -2182,6 +2182,8 @@ brw_compile_vs(const struct brw_compiler *compiler, void *log_data,
                                             final_assembly_size);
    }
 
+   intel_compile_stats_end("vs", stats_start, *final_assembly_size);
+
    return assembly;
 }
 
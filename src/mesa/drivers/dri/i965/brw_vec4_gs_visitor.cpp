@@ -589,6 +589,7 @@ brw_compile_gs(const struct brw_compiler *compiler, void *log_data,
                unsigned *final_assembly_size,
                char **error_str)
 {
+   const int64_t stats_start = intel_compile_stats_begin();
    struct brw_gs_compile c;
    memset(&c, 0, sizeof(c));
    c.key = *key;
@@ -827,7 +828,12 @@ brw_compile_gs(const struct brw_compiler *compiler, void *log_data,
             g.enable_debug(name);
          }
          g.generate_code(v.cfg, 8);
-         return g.get_assembly(final_assembly_size);
+
+         const unsigned *assembly = g.get_assembly(final_assembly_size);
+
+         intel_compile_stats_end("gs", stats_start, *final_assembly_size);
+
+         return assembly;
       }
    }
 
@@ -843,9 +849,14 @@ brw_compile_gs(const struct brw_compiler *compiler, void *log_data,
          vec4_gs_visitor v(compiler, log_data, &c, prog_data, shader,
                            mem_ctx, true /* no_spills */, shader_time_index);
          if (v.run()) {
-            return brw_vec4_generate_assembly(compiler, log_data, mem_ctx,
-                                              shader, &prog_data->base, v.cfg,
-                                              final_assembly_size);
+            const unsigned *assembly =
+               brw_vec4_generate_assembly(compiler, log_data, mem_ctx,
+                                          shader, &prog_data->base, v.cfg,
+                                          final_assembly_size);
+
+            intel_compile_stats_end("gs", stats_start, *final_assembly_size);
+
+            return assembly;
          }
       }
    }
@@ -897,6 +908,8 @@ brw_compile_gs(const struct brw_compiler *compiler, void *log_data,
       ret = brw_vec4_generate_assembly(compiler, log_data, mem_ctx, shader,
                                        &prog_data->base, gs->cfg,
                                        final_assembly_size);
+
+      intel_compile_stats_end("gs", stats_start, *final_assembly_size);
    }
 
    delete gs;
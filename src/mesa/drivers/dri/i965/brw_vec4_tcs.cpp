@@ -431,6 +431,7 @@ brw_compile_tcs(const struct brw_compiler *compiler,
                 unsigned *final_assembly_size,
                 char **error_str)
 {
+   const int64_t stats_start = intel_compile_stats_begin();
    const struct brw_device_info *devinfo = compiler->devinfo;
    struct brw_vue_prog_data *vue_prog_data = &prog_data->base;
    const bool is_scalar = compiler->scalar_stage[MESA_SHADER_TESS_CTRL];
@@ -523,7 +524,11 @@ brw_compile_tcs(const struct brw_compiler *compiler,
 
       g.generate_code(v.cfg, 8);
 
-      return g.get_assembly(final_assembly_size);
+      const unsigned *assembly = g.get_assembly(final_assembly_size);
+
+      intel_compile_stats_end("tcs", stats_start, *final_assembly_size);
+
+      return assembly;
    } else {
       vec4_tcs_visitor v(compiler, log_data, key, prog_data,
                          nir, mem_ctx, shader_time_index, &input_vue_map);
@@ -537,9 +542,14 @@ brw_compile_tcs(const struct brw_compiler *compiler,
          v.dump_instructions();
 
 
-      return brw_vec4_generate_assembly(compiler, log_data, mem_ctx, nir,
-                                        &prog_data->base, v.cfg,
-                                        final_assembly_size);
+      const unsigned *assembly =
+         brw_vec4_generate_assembly(compiler, log_data, mem_ctx, nir,
+                                    &prog_data->base, v.cfg,
+                                    final_assembly_size);
+
+      intel_compile_stats_end("tcs", stats_start, *final_assembly_size);
+
+      return assembly;
    }
 }
 
@@ -63,6 +63,19 @@ brw_codegen_vs_prog(struct brw_context *brw,
    if (prog)
       vs = (struct brw_shader *) prog->_LinkedShaders[MESA_SHADER_VERTEX];
 
+   /* A warm start may have this program on disk already. */
+   if (brw_disk_cache_search(brw, BRW_CACHE_VS_PROG, key, sizeof(*key),
+                             sizeof(struct brw_vs_prog_data),
+                             prog, &vp->program.Base,
+                             &brw->vs.base.prog_offset, &brw->vs.prog_data)) {
+      if (brw->vs.prog_data->base.base.total_scratch) {
+         brw_get_scratch_bo(brw, &brw->vs.base.scratch_bo,
+                            brw->vs.prog_data->base.base.total_scratch *
+                            brw->max_vs_threads);
+      }
+      return true;
+   }
+
    memset(&prog_data, 0, sizeof(prog_data));
 
    /* Use ALT floating point mode for ARB programs so that 0^0 == 1. */
@@ -221,6 +234,11 @@ brw_codegen_vs_prog(struct brw_context *brw,
 		    program, program_size,
 		    &prog_data, sizeof(prog_data),
 		    &brw->vs.base.prog_offset, &brw->vs.prog_data);
+   brw_disk_cache_store(brw, BRW_CACHE_VS_PROG,
+                        key, sizeof(struct brw_vs_prog_key),
+                        program, program_size,
+                        &prog_data, sizeof(prog_data),
+                        prog, &vp->program.Base);
    ralloc_free(mem_ctx);
 
    return true;
@@ -158,11 +158,11 @@ brw_upload_vs_unit(struct brw_context *brw)
    if (stage_state->sampler_count) {
       /* BRW_NEW_SAMPLER_STATE_TABLE - reloc */
       vs->vs5.sampler_state_pointer =
-         (brw->batch.bo->offset64 + stage_state->sampler_offset) >> 5;
-      drm_intel_bo_emit_reloc(brw->batch.bo,
+         (brw->batch.state_bo->offset64 + stage_state->sampler_offset) >> 5;
+      drm_intel_bo_emit_reloc(brw->batch.state_bo,
                               stage_state->state_offset +
                               offsetof(struct brw_vs_unit_state, vs5),
-                              brw->batch.bo,
+                              brw->batch.state_bo,
                               (stage_state->sampler_offset |
                                vs->vs5.sampler_count),
                               I915_GEM_DOMAIN_INSTRUCTION, 0);
@@ -170,7 +170,7 @@ brw_upload_vs_unit(struct brw_context *brw)
 
    /* Emit scratch space relocation */
    if (brw->vs.prog_data->base.base.total_scratch != 0) {
-      drm_intel_bo_emit_reloc(brw->batch.bo,
+      drm_intel_bo_emit_reloc(brw->batch.state_bo,
 			      stage_state->state_offset +
 			      offsetof(struct brw_vs_unit_state, thread2),
 			      stage_state->scratch_bo,
@@ -84,6 +84,20 @@ brw_codegen_wm_prog(struct brw_context *brw,
    if (prog)
       fs = (struct brw_shader *)prog->_LinkedShaders[MESA_SHADER_FRAGMENT];
 
+   /* A warm start may have this program on disk already. */
+   if (brw_disk_cache_search(brw, BRW_CACHE_FS_PROG, key, sizeof(*key),
+                             sizeof(struct brw_wm_prog_data),
+                             prog, &fp->program.Base,
+                             &brw->wm.base.prog_offset, &brw->wm.prog_data)) {
+      if (brw->wm.prog_data->base.total_scratch) {
+         brw_get_scratch_bo(brw, &brw->wm.base.scratch_bo,
+                            brw->wm.prog_data->base.total_scratch *
+                            brw->max_wm_threads);
+      }
+      ralloc_free(mem_ctx);
+      return true;
+   }
+
    memset(&prog_data, 0, sizeof(prog_data));
 
    /* Use ALT floating point mode for ARB programs so that 0^0 == 1. */
@@ -176,6 +190,11 @@ brw_codegen_wm_prog(struct brw_context *brw,
 		    program, program_size,
 		    &prog_data, sizeof(prog_data),
 		    &brw->wm.base.prog_offset, &brw->wm.prog_data);
+   brw_disk_cache_store(brw, BRW_CACHE_FS_PROG,
+                        key, sizeof(struct brw_wm_prog_key),
+                        program, program_size,
+                        &prog_data, sizeof(prog_data),
+                        prog, &fp->program.Base);
 
    ralloc_free(mem_ctx);
 
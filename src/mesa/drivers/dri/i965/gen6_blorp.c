@@ -63,14 +63,14 @@ gen6_blorp_emit_vertex_buffer_state(struct brw_context *brw,
    OUT_BATCH((_3DSTATE_VERTEX_BUFFERS << 16) | (batch_length - 2));
    OUT_BATCH(dw0);
    if (brw->gen >= 8) {
-      OUT_RELOC64(brw->batch.bo, I915_GEM_DOMAIN_VERTEX, 0, vertex_offset);
+      OUT_RELOC64(brw->batch.state_bo, I915_GEM_DOMAIN_VERTEX, 0, vertex_offset);
       OUT_BATCH(vbo_size);
    } else {
       /* start address */
-      OUT_RELOC(brw->batch.bo, I915_GEM_DOMAIN_VERTEX, 0,
+      OUT_RELOC(brw->batch.state_bo, I915_GEM_DOMAIN_VERTEX, 0,
                 vertex_offset);
       /* end address */
-      OUT_RELOC(brw->batch.bo, I915_GEM_DOMAIN_VERTEX, 0,
+      OUT_RELOC(brw->batch.state_bo, I915_GEM_DOMAIN_VERTEX, 0,
                 vertex_offset + vbo_size - 1);
       OUT_BATCH(0);
    }
@@ -383,7 +383,7 @@ gen6_blorp_emit_surface_state(struct brw_context *brw,
                BRW_SURFACE_VERTICAL_ALIGN_ENABLE : 0));
 
    /* Emit relocation to surface contents */
-   drm_intel_bo_emit_reloc(brw->batch.bo,
+   drm_intel_bo_emit_reloc(brw->batch.state_bo,
                            wm_surf_offset + 4,
                            mt->bo,
                            surf[1] - mt->bo->offset64,
@@ -70,7 +70,7 @@ gen7_upload_constant_state(struct brw_context *brw,
       /* XXX: When using buffers other than 0, you need to specify the
        * graphics virtual address regardless of INSPM/debug bits
        */
-      OUT_RELOC64(brw->batch.bo, I915_GEM_DOMAIN_RENDER, 0,
+      OUT_RELOC64(brw->batch.state_bo, I915_GEM_DOMAIN_RENDER, 0,
                   stage_state->push_const_offset);
       OUT_BATCH(0);
       OUT_BATCH(0);
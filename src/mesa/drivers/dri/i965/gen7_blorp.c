@@ -234,7 +234,7 @@ gen7_blorp_emit_surface_state(struct brw_context *brw,
    }
 
    /* Emit relocation to surface contents */
-   drm_intel_bo_emit_reloc(brw->batch.bo,
+   drm_intel_bo_emit_reloc(brw->batch.state_bo,
                            wm_surf_offset + 4,
                            mt->bo,
                            surf[1] - mt->bo->offset64,
@@ -48,12 +48,16 @@ intel_batchbuffer_init(struct brw_context *brw)
       brw->batch.cpu_map = malloc(BATCH_SZ);
       brw->batch.map = brw->batch.cpu_map;
       brw->batch.map_next = brw->batch.cpu_map;
+      brw->batch.state_cpu_map = malloc(STATE_SZ);
+      brw->batch.state_map = brw->batch.state_cpu_map;
    }
 }
 
 static void
 intel_batchbuffer_reset(struct brw_context *brw)
 {
+   const unsigned slot = brw->batch.pool_next;
+
    if (brw->batch.last_bo != NULL) {
       drm_intel_bo_unreference(brw->batch.last_bo);
       brw->batch.last_bo = NULL;
@@ -62,16 +66,61 @@ intel_batchbuffer_reset(struct brw_context *brw)
 
    brw_render_cache_set_clear(brw);
 
-   brw->batch.bo = drm_intel_bo_alloc(brw->bufmgr, "batchbuffer",
-					BATCH_SZ, 4096);
+   if (brw->batch.state_bo != NULL) {
+      drm_intel_bo_unreference(brw->batch.state_bo);
+      brw->batch.state_bo = NULL;
+   }
+
+   /* Take the next batch and state BOs from the pool.  If the GPU hasn't
+    * finished executing them yet, replace them with fresh BOs instead of
+    * stalling.  With a deep enough pool this only happens when the GPU is
+    * several batches behind, which the swap throttling normally prevents.
+    * The batch and state BO of a slot always retire together, so checking
+    * the batch BO covers both.
+    */
+   if (brw->batch.pool_bo[slot] != NULL &&
+       drm_intel_bo_busy(brw->batch.pool_bo[slot])) {
+      drm_intel_bo_unreference(brw->batch.pool_bo[slot]);
+      brw->batch.pool_bo[slot] = NULL;
+      brw->batch.pool_map[slot] = NULL;
+      drm_intel_bo_unreference(brw->batch.pool_state_bo[slot]);
+      brw->batch.pool_state_bo[slot] = NULL;
+      brw->batch.pool_state_map[slot] = NULL;
+   }
+
+   if (brw->batch.pool_bo[slot] == NULL) {
+      brw->batch.pool_bo[slot] = drm_intel_bo_alloc(brw->bufmgr, "batchbuffer",
+                                                    BATCH_SZ, 4096);
+      brw->batch.pool_state_bo[slot] = drm_intel_bo_alloc(brw->bufmgr,
+                                                          "statebuffer",
+                                                          STATE_SZ, 4096);
+      if (brw->has_llc) {
+         /* Map the BOs once and keep them mapped for as long as they stay
+          * in the pool, so recycling them costs neither a mmap nor the
+          * first touch pagefaults.
+          */
+         drm_intel_bo_map(brw->batch.pool_bo[slot], true);
+         brw->batch.pool_map[slot] = brw->batch.pool_bo[slot]->virtual;
+         drm_intel_bo_map(brw->batch.pool_state_bo[slot], true);
+         brw->batch.pool_state_map[slot] =
+            brw->batch.pool_state_bo[slot]->virtual;
+      }
+   }
+
+   brw->batch.bo = brw->batch.pool_bo[slot];
+   drm_intel_bo_reference(brw->batch.bo);
+   brw->batch.state_bo = brw->batch.pool_state_bo[slot];
+   drm_intel_bo_reference(brw->batch.state_bo);
+   brw->batch.pool_next = (slot + 1) % BATCH_BO_POOL_SZ;
+
    if (brw->has_llc) {
-      drm_intel_bo_map(brw->batch.bo, true);
-      brw->batch.map = brw->batch.bo->virtual;
+      brw->batch.map = brw->batch.pool_map[slot];
+      brw->batch.state_map = brw->batch.pool_state_map[slot];
    }
    brw->batch.map_next = brw->batch.map;
 
    brw->batch.reserved_space = BATCH_RESERVED;
-   brw->batch.state_batch_offset = brw->batch.bo->size;
+   brw->batch.state_batch_offset = brw->batch.state_bo->size;
    brw->batch.needs_sol_reset = false;
    brw->batch.state_base_address_emitted = false;
 
@@ -87,14 +136,20 @@ intel_batchbuffer_save_state(struct brw_context *brw)
    brw->batch.saved.map_next = brw->batch.map_next;
    brw->batch.saved.reloc_count =
       drm_intel_gem_bo_get_reloc_count(brw->batch.bo);
+   brw->batch.saved.state_reloc_count =
+      drm_intel_gem_bo_get_reloc_count(brw->batch.state_bo);
+   brw->batch.saved.state_batch_offset = brw->batch.state_batch_offset;
 }
 
 void
 intel_batchbuffer_reset_to_saved(struct brw_context *brw)
 {
    drm_intel_gem_bo_clear_relocs(brw->batch.bo, brw->batch.saved.reloc_count);
+   drm_intel_gem_bo_clear_relocs(brw->batch.state_bo,
+                                 brw->batch.saved.state_reloc_count);
 
    brw->batch.map_next = brw->batch.saved.map_next;
+   brw->batch.state_batch_offset = brw->batch.saved.state_batch_offset;
    if (USED_BATCH(brw->batch) == 0)
       brw->batch.ring = UNKNOWN_RING;
 }
@@ -102,9 +157,26 @@ intel_batchbuffer_reset_to_saved(struct brw_context *brw)
 void
 intel_batchbuffer_free(struct brw_context *brw)
 {
+   unsigned i;
+
    free(brw->batch.cpu_map);
+   free(brw->batch.state_cpu_map);
    drm_intel_bo_unreference(brw->batch.last_bo);
    drm_intel_bo_unreference(brw->batch.bo);
+   drm_intel_bo_unreference(brw->batch.state_bo);
+
+   for (i = 0; i < BATCH_BO_POOL_SZ; i++) {
+      if (brw->batch.pool_bo[i] != NULL) {
+         if (brw->batch.pool_map[i] != NULL)
+            drm_intel_bo_unmap(brw->batch.pool_bo[i]);
+         drm_intel_bo_unreference(brw->batch.pool_bo[i]);
+      }
+      if (brw->batch.pool_state_bo[i] != NULL) {
+         if (brw->batch.pool_state_map[i] != NULL)
+            drm_intel_bo_unmap(brw->batch.pool_state_bo[i]);
+         drm_intel_bo_unreference(brw->batch.pool_state_bo[i]);
+      }
+   }
 }
 
 void
@@ -188,6 +260,7 @@ brw_new_batch(struct brw_context *brw)
 {
    /* Create a new batchbuffer and reset the associated state: */
    drm_intel_gem_bo_clear_relocs(brw->batch.bo, 0);
+   drm_intel_gem_bo_clear_relocs(brw->batch.state_bo, 0);
    intel_batchbuffer_reset(brw);
 
    /* If the kernel supports hardware contexts, then most hardware state is
@@ -325,15 +398,16 @@ do_flush_locked(struct brw_context *brw)
    struct intel_batchbuffer *batch = &brw->batch;
    int ret = 0;
 
-   if (brw->has_llc) {
-      drm_intel_bo_unmap(batch->bo);
-   } else {
+   /* On LLC the batch BO stays mapped for as long as it sits in the BO
+    * pool; submitting a mapped BO is fine, so there is nothing to do here.
+    */
+   if (!brw->has_llc) {
       ret = drm_intel_bo_subdata(batch->bo, 0, 4 * USED_BATCH(*batch), batch->map);
-      if (ret == 0 && batch->state_batch_offset != batch->bo->size) {
-	 ret = drm_intel_bo_subdata(batch->bo,
+      if (ret == 0 && batch->state_batch_offset != batch->state_bo->size) {
+	 ret = drm_intel_bo_subdata(batch->state_bo,
 				    batch->state_batch_offset,
-				    batch->bo->size - batch->state_batch_offset,
-				    (char *)batch->map + batch->state_batch_offset);
+				    batch->state_bo->size - batch->state_batch_offset,
+				    (char *)batch->state_map + batch->state_batch_offset);
       }
    }
 
@@ -392,13 +466,14 @@ _intel_batchbuffer_flush(struct brw_context *brw,
 
    if (unlikely(INTEL_DEBUG & DEBUG_BATCH)) {
       int bytes_for_commands = 4 * USED_BATCH(brw->batch);
-      int bytes_for_state = brw->batch.bo->size - brw->batch.state_batch_offset;
+      int bytes_for_state =
+         brw->batch.state_bo->size - brw->batch.state_batch_offset;
       int total_bytes = bytes_for_commands + bytes_for_state;
       fprintf(stderr, "%s:%d: Batchbuffer flush with %4db (pkt) + "
               "%4db (state) = %4db (%0.1f%%)\n", file, line,
               bytes_for_commands, bytes_for_state,
               total_bytes,
-              100.0f * total_bytes / BATCH_SZ);
+              100.0f * total_bytes / (BATCH_SZ + STATE_SZ));
    }
 
    brw->batch.reserved_space = 0;
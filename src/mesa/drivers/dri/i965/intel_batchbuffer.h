@@ -97,7 +97,7 @@ static inline uint32_t float_as_int(float f)
 static inline unsigned
 intel_batchbuffer_space(struct brw_context *brw)
 {
-   return (brw->batch.state_batch_offset - brw->batch.reserved_space)
+   return (BATCH_SZ - brw->batch.reserved_space)
       - USED_BATCH(brw->batch) * 4;
 }
 
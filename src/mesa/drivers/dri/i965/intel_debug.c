@@ -29,6 +29,10 @@
  * miscellaneous debugging code.
  */
 
+#include <inttypes.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
 #include "brw_context.h"
 #include "intel_debug.h"
 #include "util/u_atomic.h" /* for p_atomic_cmpxchg */
@@ -79,6 +83,7 @@ static const struct debug_control debug_control[] = {
    { "ds",          DEBUG_TES },
    { "tes",         DEBUG_TES },
    { "l3",          DEBUG_L3 },
+   { "compstats",   DEBUG_COMPILE_STATS },
    { NULL,    0 }
 };
 
@@ -103,3 +108,37 @@ brw_process_intel_debug_variable(void)
    uint64_t intel_debug = parse_debug_string(getenv("INTEL_DEBUG"), debug_control);
    (void) p_atomic_cmpxchg(&INTEL_DEBUG, 0, intel_debug);
 }
+
+static int64_t
+get_time_us(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000ll + tv.tv_usec;
+}
+
+int64_t
+intel_compile_stats_begin(void)
+{
+   if (likely(!(INTEL_DEBUG & DEBUG_COMPILE_STATS)))
+      return 0;
+
+   return get_time_us();
+}
+
+void
+intel_compile_stats_end(const char *stage, int64_t start_time,
+                        unsigned program_size)
+{
+   struct rusage ru;
+
+   if (likely(!(INTEL_DEBUG & DEBUG_COMPILE_STATS)))
+      return;
+
+   /* ralloc does no accounting, report the process' high-water mark */
+   getrusage(RUSAGE_SELF, &ru);
+
+   fprintf(stderr, "BRW-COMPILE-STATS: stage=%s time_us=%" PRIi64
+           " size=%u maxrss_kb=%ld\n",
+           stage, get_time_us() - start_time, program_size, ru.ru_maxrss);
+}
@@ -72,6 +72,7 @@ extern uint64_t INTEL_DEBUG;
 #define DEBUG_TCS                 (1ull << 36)
 #define DEBUG_TES                 (1ull << 37)
 #define DEBUG_L3                  (1ull << 38)
+#define DEBUG_COMPILE_STATS       (1ull << 39)
 
 #ifdef HAVE_ANDROID_PLATFORM
 #define LOG_TAG "INTEL-MESA"
@@ -121,3 +122,11 @@ extern uint64_t INTEL_DEBUG;
 extern uint64_t intel_debug_flag_for_shader_stage(gl_shader_stage stage);
 
 extern void brw_process_intel_debug_variable(void);
+
+/* Whole-compile statistics for INTEL_DEBUG=compstats.  _begin returns the
+ * start time in microseconds, or 0 when the stats are disabled; _end prints
+ * one machine-readable line per compile.
+ */
+extern int64_t intel_compile_stats_begin(void);
+extern void intel_compile_stats_end(const char *stage, int64_t start_time,
+                                    unsigned program_size);
@@ -28,6 +28,7 @@
 #include <unistd.h>
 #include "main/context.h"
 #include "main/framebuffer.h"
+#include "main/glthread.h"
 #include "main/renderbuffer.h"
 #include "main/texobj.h"
 #include "main/hash.h"
@@ -169,6 +170,12 @@ intel_dri2_flush_with_flags(__DRIcontext *cPriv,
 
    struct gl_context *ctx = &brw->ctx;
 
+   /* The loader calls this directly on the application thread, bypassing
+    * the marshal dispatch table, so drain any glthread batches still
+    * queued for the server thread before flushing.
+    */
+   _mesa_glthread_finish(ctx);
+
    FLUSH_VERTICES(ctx, 0);
 
    if (flags & __DRI2_FLUSH_DRAWABLE)
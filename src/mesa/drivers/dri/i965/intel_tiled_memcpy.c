@@ -36,7 +36,9 @@
 #include "brw_context.h"
 #include "intel_tiled_memcpy.h"
 
-#if defined(__SSSE3__)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
 #include <tmmintrin.h>
 #elif defined(__SSE2__)
 #include <emmintrin.h>
@@ -97,6 +99,26 @@ rgba8_copy(void *dst, const void *src, size_t bytes)
    return dst;
 }
 
+#ifdef __AVX2__
+/* vpshufb shuffles within each 128-bit lane, so the 16-byte permutation is
+ * simply repeated for both lanes.
+ */
+static const uint8_t rgba8_permutation_32[32] =
+   { 2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15,
+     2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15 };
+
+/* Only 16-byte alignment is guaranteed on the tiled side, so use unaligned
+ * 256-bit accesses; they run at full speed on 16-byte-aligned addresses.
+ */
+static inline void
+rgba8_copy_32(void *dst, const void *src)
+{
+   _mm256_storeu_si256(dst,
+                       _mm256_shuffle_epi8(_mm256_loadu_si256(src),
+                                           *(__m256i *)rgba8_permutation_32));
+}
+#endif
+
 #ifdef __SSSE3__
 static const uint8_t rgba8_permutation[16] =
    { 2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15 };
@@ -161,6 +183,14 @@ rgba8_copy_aligned_dst(void *dst, const void *src, size_t bytes)
 {
    assert(bytes == 0 || !(((uintptr_t)dst) & 0xf));
 
+#if defined(__AVX2__)
+   if (bytes == 64) {
+      rgba8_copy_32(dst +  0, src +  0);
+      rgba8_copy_32(dst + 32, src + 32);
+      return dst;
+   }
+#endif
+
 #if defined(__SSSE3__) || defined(__SSE2__)
    if (bytes == 64) {
       rgba8_copy_16_aligned_dst(dst +  0, src +  0);
@@ -191,6 +221,14 @@ rgba8_copy_aligned_src(void *dst, const void *src, size_t bytes)
 {
    assert(bytes == 0 || !(((uintptr_t)src) & 0xf));
 
+#if defined(__AVX2__)
+   if (bytes == 64) {
+      rgba8_copy_32(dst +  0, src +  0);
+      rgba8_copy_32(dst + 32, src + 32);
+      return dst;
+   }
+#endif
+
 #if defined(__SSSE3__) || defined(__SSE2__)
    if (bytes == 64) {
       rgba8_copy_16_aligned_src(dst +  0, src +  0);
@@ -617,7 +655,7 @@ ytiled_to_linear_faster(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3,
 }
 
 /**
- * Copy from linear to tiled texture.
+ * Copy from linear to tiled texture, single-threaded.
  *
  * Divide the region given by X range [xt1, xt2) and Y range [yt1, yt2) into
  * pieces that do not cross tile boundaries and copy each piece with a tile
@@ -627,14 +665,14 @@ ytiled_to_linear_faster(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3,
  * 'dst' is the start of the texture and 'src' is the corresponding
  * address to copy from, though copying begins at (xt1, yt1).
  */
-void
-linear_to_tiled(uint32_t xt1, uint32_t xt2,
-                uint32_t yt1, uint32_t yt2,
-                char *dst, const char *src,
-                uint32_t dst_pitch, int32_t src_pitch,
-                bool has_swizzling,
-                uint32_t tiling,
-                mem_copy_fn mem_copy)
+static void
+linear_to_tiled_region(uint32_t xt1, uint32_t xt2,
+                       uint32_t yt1, uint32_t yt2,
+                       char *dst, const char *src,
+                       uint32_t dst_pitch, int32_t src_pitch,
+                       bool has_swizzling,
+                       uint32_t tiling,
+                       mem_copy_fn mem_copy)
 {
    tile_copy_fn tile_copy;
    uint32_t xt0, xt3;
@@ -707,6 +745,112 @@ linear_to_tiled(uint32_t xt1, uint32_t xt2,
    }
 }
 
+/* Uploads below this size (in bytes) aren't worth the job submission and
+ * fence overhead of going wide.
+ */
+#define TILED_MEMCPY_THREAD_THRESHOLD (512 * 1024)
+
+struct tiled_memcpy_job {
+   uint32_t xt1, xt2;
+   uint32_t yt1, yt2;
+   char *dst;
+   const char *src;
+   uint32_t dst_pitch;
+   int32_t src_pitch;
+   bool has_swizzling;
+   uint32_t tiling;
+   mem_copy_fn mem_copy;
+   struct util_queue_fence fence;
+};
+
+static void
+tiled_memcpy_job_execute(void *data, int thread_index)
+{
+   struct tiled_memcpy_job *job = data;
+
+   linear_to_tiled_region(job->xt1, job->xt2, job->yt1, job->yt2,
+                          job->dst, job->src, job->dst_pitch, job->src_pitch,
+                          job->has_swizzling, job->tiling, job->mem_copy);
+}
+
+/**
+ * Copy from linear to tiled texture.
+ *
+ * Same as \ref linear_to_tiled_region, except that a large enough region is
+ * split by rows of whole tiles and spread across 'queue' plus the calling
+ * thread.  Tile rows are disjoint in the destination, so the pieces can be
+ * copied concurrently; the split is aligned to tile boundaries so that no
+ * two threads write into the same tile.  Blocks until all pieces are done.
+ * 'queue' may be NULL or uninitialized, in which case the copy simply runs
+ * on the calling thread.
+ */
+void
+linear_to_tiled(uint32_t xt1, uint32_t xt2,
+                uint32_t yt1, uint32_t yt2,
+                char *dst, const char *src,
+                uint32_t dst_pitch, int32_t src_pitch,
+                bool has_swizzling,
+                uint32_t tiling,
+                mem_copy_fn mem_copy,
+                struct util_queue *queue)
+{
+   const uint32_t th = (tiling == I915_TILING_Y) ? ytile_height : xtile_height;
+
+   if (queue && util_queue_is_initialized(queue) &&
+       (uint64_t)(xt2 - xt1) * (yt2 - yt1) >= TILED_MEMCPY_THREAD_THRESHOLD) {
+      const uint32_t yt0 = ALIGN_DOWN(yt1, th);
+      const uint32_t tile_rows = (ALIGN_UP(yt2, th) - yt0) / th;
+      const unsigned num_pieces =
+         MIN2(MIN2(queue->num_threads + 1, tile_rows), TILED_MEMCPY_MAX_JOBS);
+
+      if (num_pieces > 1) {
+         const uint32_t rows_per_piece = DIV_ROUND_UP(tile_rows, num_pieces);
+         struct tiled_memcpy_job jobs[TILED_MEMCPY_MAX_JOBS];
+         unsigned num_jobs = 0;
+         unsigned i;
+
+         for (i = 1; i < num_pieces; i++) {
+            struct tiled_memcpy_job *job = &jobs[num_jobs];
+            uint32_t ya = yt0 + i * rows_per_piece * th;
+
+            if (ya >= yt2)
+               break;
+
+            job->xt1 = xt1;
+            job->xt2 = xt2;
+            job->yt1 = ya;
+            job->yt2 = MIN2(ya + rows_per_piece * th, yt2);
+            job->dst = dst;
+            job->src = src;
+            job->dst_pitch = dst_pitch;
+            job->src_pitch = src_pitch;
+            job->has_swizzling = has_swizzling;
+            job->tiling = tiling;
+            job->mem_copy = mem_copy;
+            util_queue_fence_init(&job->fence);
+            util_queue_add_job(queue, job, &job->fence,
+                               tiled_memcpy_job_execute, NULL);
+            num_jobs++;
+         }
+
+         /* The calling thread copies the first piece itself. */
+         linear_to_tiled_region(xt1, xt2,
+                                yt1, MIN2(yt0 + rows_per_piece * th, yt2),
+                                dst, src, dst_pitch, src_pitch,
+                                has_swizzling, tiling, mem_copy);
+
+         for (i = 0; i < num_jobs; i++) {
+            util_queue_fence_wait(&jobs[i].fence);
+            util_queue_fence_destroy(&jobs[i].fence);
+         }
+         return;
+      }
+   }
+
+   linear_to_tiled_region(xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch,
+                          has_swizzling, tiling, mem_copy);
+}
+
 /**
  * Copy from tiled to linear texture.
  *
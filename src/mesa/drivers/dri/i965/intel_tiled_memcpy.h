@@ -35,6 +35,13 @@
 #include <stdint.h>
 #include "main/mtypes.h"
 
+struct util_queue;
+
+/* Upper bound on the number of pieces linear_to_tiled() splits a copy into:
+ * the worker threads plus the application thread.
+ */
+#define TILED_MEMCPY_MAX_JOBS 8
+
 typedef void *(*mem_copy_fn)(void *dest, const void *src, size_t n);
 
 void
@@ -44,7 +51,8 @@ linear_to_tiled(uint32_t xt1, uint32_t xt2,
                 uint32_t dst_pitch, int32_t src_pitch,
                 bool has_swizzling,
                 uint32_t tiling,
-                mem_copy_fn mem_copy);
+                mem_copy_fn mem_copy,
+                struct util_queue *queue);
 
 void
 tiled_to_linear(uint32_t xt1, uint32_t xt2,
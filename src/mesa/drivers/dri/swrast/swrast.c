@@ -38,6 +38,7 @@
 #include "main/extensions.h"
 #include "main/formats.h"
 #include "main/framebuffer.h"
+#include "main/glthread.h"
 #include "main/imports.h"
 #include "main/renderbuffer.h"
 #include "main/version.h"
@@ -629,6 +630,12 @@ dri_swap_buffers(__DRIdrawable * dPriv)
 
     TRACE;
 
+    /* The loader calls this directly on the application thread, so drain
+     * any glthread batches still queued for the server thread first.
+     */
+    if (ctx)
+	_mesa_glthread_finish(ctx);
+
     fb = &drawable->Base;
 
     frontrb =
@@ -915,8 +922,13 @@ dri_copy_sub_buffer(__DRIdrawable *dPriv, int x, int y,
     struct gl_framebuffer *fb;
     struct dri_swrast_renderbuffer *frontrb, *backrb;
 
+    GET_CURRENT_CONTEXT(ctx);
+
     TRACE;
 
+    if (ctx)
+	_mesa_glthread_finish(ctx);
+
     fb = &drawable->Base;
 
     frontrb =
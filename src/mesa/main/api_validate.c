@@ -357,6 +357,61 @@ _mesa_valid_prim_mode(struct gl_context *ctx, GLenum mode, const char *name)
    return GL_TRUE;
 }
 
+
+/**
+ * Do the state-dependent part of draw validation: primitive mode checks
+ * (_mesa_valid_prim_mode) and the valid-to-render checks.
+ *
+ * The verdict depends only on GL state, not on the draw parameters, so a
+ * successful verdict is cached in ctx->DrawValidation and reused by
+ * back-to-back draws with unchanged state.  Any state mutation sets a
+ * ctx->NewState bit before the next draw, and a successful validation ends
+ * with NewState cleared (by way of _mesa_update_state), so a zero NewState
+ * plus matching snapshot fields means the previous verdict still holds.
+ * Transform feedback Begin/End/Pause/Resume don't set NewState flags and a
+ * bound-but-unvalidated pipeline must be revalidated, so both are checked
+ * explicitly.  Failed verdicts are never cached; they must raise a GL error
+ * on every draw.
+ */
+static bool
+validate_draw_state(struct gl_context *ctx, GLenum mode, const char *name)
+{
+   struct gl_draw_validation_cache *cache = &ctx->DrawValidation;
+   struct gl_transform_feedback_object *xfb_obj
+      = ctx->TransformFeedback.CurrentObject;
+
+   if (cache->Valid &&
+       ctx->NewState == 0 &&
+       mode == cache->Mode &&
+       ctx->Array.VAO == cache->VAO &&
+       ctx->_Shader == cache->Shader &&
+       (!ctx->_Shader->Name || ctx->_Shader->Validated) &&
+       xfb_obj == cache->XFBObj &&
+       xfb_obj->Active == cache->XFBActive &&
+       xfb_obj->Paused == cache->XFBPaused &&
+       ctx->TransformFeedback.Mode == cache->XFBMode)
+      return true;
+
+   cache->Valid = GL_FALSE;
+
+   if (!_mesa_valid_prim_mode(ctx, mode, name))
+      return false;
+
+   if (!check_valid_to_render(ctx, name))
+      return false;
+
+   cache->Valid = GL_TRUE;
+   cache->Mode = mode;
+   cache->VAO = ctx->Array.VAO;
+   cache->Shader = ctx->_Shader;
+   cache->XFBObj = ctx->TransformFeedback.CurrentObject;
+   cache->XFBActive = cache->XFBObj->Active;
+   cache->XFBPaused = cache->XFBObj->Paused;
+   cache->XFBMode = ctx->TransformFeedback.Mode;
+   return true;
+}
+
+
 /**
  * Verify that the element type is valid.
  *
@@ -403,16 +458,12 @@ validate_DrawElements_common(struct gl_context *ctx,
       return false;
    }
 
-   if (!_mesa_valid_prim_mode(ctx, mode, caller)) {
+   if (!validate_draw_state(ctx, mode, caller))
       return false;
-   }
 
    if (!valid_elements_type(ctx, type, caller))
       return false;
 
-   if (!check_valid_to_render(ctx, caller))
-      return false;
-
    /* Not using a VBO for indices, so avoid NULL pointer derefs later.
     */
    if (!_mesa_is_bufferobj(ctx->Array.VAO->IndexBufferObj) && indices == NULL)
@@ -464,16 +515,12 @@ _mesa_validate_MultiDrawElements(struct gl_context *ctx,
       }
    }
 
-   if (!_mesa_valid_prim_mode(ctx, mode, "glMultiDrawElements")) {
+   if (!validate_draw_state(ctx, mode, "glMultiDrawElements"))
       return GL_FALSE;
-   }
 
    if (!valid_elements_type(ctx, type, "glMultiDrawElements"))
       return GL_FALSE;
 
-   if (!check_valid_to_render(ctx, "glMultiDrawElements"))
-      return GL_FALSE;
-
    /* Not using a VBO for indices, so avoid NULL pointer derefs later.
     */
    if (!_mesa_is_bufferobj(ctx->Array.VAO->IndexBufferObj)) {
@@ -527,11 +574,7 @@ _mesa_validate_DrawArrays(struct gl_context *ctx, GLenum mode, GLsizei count)
       return GL_FALSE;
    }
 
-   if (!_mesa_valid_prim_mode(ctx, mode, "glDrawArrays")) {
-      return GL_FALSE;
-   }
-
-   if (!check_valid_to_render(ctx, "glDrawArrays"))
+   if (!validate_draw_state(ctx, mode, "glDrawArrays"))
       return GL_FALSE;
 
    /* From the GLES3 specification, section 2.14.2 (Transform Feedback
@@ -584,9 +627,8 @@ _mesa_validate_DrawArraysInstanced(struct gl_context *ctx, GLenum mode, GLint fi
       return GL_FALSE;
    }
 
-   if (!_mesa_valid_prim_mode(ctx, mode, "glDrawArraysInstanced")) {
+   if (!validate_draw_state(ctx, mode, "glDrawArraysInstanced"))
       return GL_FALSE;
-   }
 
    if (numInstances <= 0) {
       if (numInstances < 0)
@@ -595,9 +637,6 @@ _mesa_validate_DrawArraysInstanced(struct gl_context *ctx, GLenum mode, GLint fi
       return GL_FALSE;
    }
 
-   if (!check_valid_to_render(ctx, "glDrawArraysInstanced(invalid to render)"))
-      return GL_FALSE;
-
    /* From the GLES3 specification, section 2.14.2 (Transform Feedback
     * Primitive Capture):
     *
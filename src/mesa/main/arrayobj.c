@@ -269,6 +269,8 @@ _mesa_initialize_vao(struct gl_context *ctx,
    mtx_init(&obj->Mutex, mtx_plain);
    obj->RefCount = 1;
 
+   _mesa_vao_state_changed(ctx, obj);
+
    /* Init the individual arrays */
    for (i = 0; i < ARRAY_SIZE(obj->VertexAttrib); i++) {
       switch (i) {
@@ -81,6 +81,19 @@ extern void
 _mesa_update_vao_client_arrays(struct gl_context *ctx,
                                struct gl_vertex_array_object *vao);
 
+/**
+ * Mark the given VAO's array/binding state as changed.  The serial
+ * number comes from a per-context counter so that a (VAO, serial)
+ * pair is never reused, even if a VAO is deleted and a new one is
+ * later allocated at the same address.
+ */
+static inline void
+_mesa_vao_state_changed(struct gl_context *ctx,
+                        struct gl_vertex_array_object *vao)
+{
+   vao->StateSerial = ++ctx->Array.NextVAOStateSerial;
+}
+
 /*
  * API functions
  */
@@ -106,6 +106,9 @@ _mesa_destroy_visual( struct gl_config *vis );
 /** \name Context-related functions */
 /*@{*/
 
+extern struct _glapi_table *
+_mesa_alloc_dispatch_table(void);
+
 extern GLboolean
 _mesa_initialize_context( struct gl_context *ctx,
                           gl_api api,
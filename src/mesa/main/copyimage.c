@@ -141,7 +141,7 @@ prepare_target(struct gl_context *ctx, GLuint name, GLenum target,
          return false;
       }
 
-      _mesa_test_texobj_completeness(ctx, texObj);
+      _mesa_update_texobj_completeness(ctx, texObj);
       if (!texObj->_BaseComplete ||
           (level != 0 && !texObj->_MipmapComplete)) {
          _mesa_error(ctx, GL_INVALID_OPERATION,
@@ -795,6 +795,18 @@ struct dd_function_table {
    void (*EmitStringMarker)(struct gl_context *ctx, const GLchar *string, GLsizei len);
    /*@}*/
 
+   /**
+    * \name GL_KHR_debug group markers
+    *
+    * Notify the driver of debug group boundaries, e.g. to attribute GPU
+    * time to them. Called after the group stack has been validated.
+    */
+   /*@{*/
+   void (*PushDebugGroup)(struct gl_context *ctx, const GLchar *message,
+                          GLsizei len);
+   void (*PopDebugGroup)(struct gl_context *ctx);
+   /*@}*/
+
    /**
     * \name Support for multiple T&L engines
     */
@@ -1218,6 +1218,9 @@ _mesa_PushDebugGroup(GLenum source, GLuint id, GLsizei length,
          MESA_DEBUG_TYPE_PUSH_GROUP, id,
          MESA_DEBUG_SEVERITY_NOTIFICATION, length,
          message);
+
+   if (ctx->Driver.PushDebugGroup)
+      ctx->Driver.PushDebugGroup(ctx, message, length);
 }
 
 
@@ -1260,6 +1263,9 @@ _mesa_PopDebugGroup(void)
          msg.length, msg.message);
 
    debug_message_clear(&msg);
+
+   if (ctx->Driver.PopDebugGroup)
+      ctx->Driver.PopDebugGroup(ctx);
 }
 
 
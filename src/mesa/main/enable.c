@@ -29,6 +29,7 @@
 
 
 #include "glheader.h"
+#include "arrayobj.h"
 #include "clip.h"
 #include "context.h"
 #include "debug_output.h"
@@ -139,6 +140,7 @@ client_state(struct gl_context *ctx, GLenum cap, GLboolean state)
       vao->_Enabled &= ~flag;
 
    vao->NewArrays |= flag;
+   _mesa_vao_state_changed(ctx, vao);
 
    if (ctx->Driver.Enable) {
       ctx->Driver.Enable( ctx, cap, state );
@@ -1249,9 +1249,8 @@ create_new_program(struct gl_context *ctx, struct state_key *key)
    const struct gl_shader_compiler_options *options =
       &ctx->Const.ShaderCompilerOptions[MESA_SHADER_FRAGMENT];
 
-   while (do_common_optimization(p.shader->ir, false, false, options,
-                                 ctx->Const.NativeIntegers))
-      ;
+   do_common_optimization(p.shader->ir, false, false, options,
+                          ctx->Const.NativeIntegers);
    reparent_ir(p.shader->ir, p.shader->ir);
 
    p.shader->CompileStatus = true;
@@ -46,6 +46,8 @@ string = """/*
 #include "format_pack.h"
 #include "format_utils.h"
 #include "macros.h"
+#include "sse_format_rows.h"
+#include "x86/common_x86_asm.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
 #include "util/format_srgb.h"
@@ -345,6 +347,11 @@ _mesa_pack_ubyte_rgba_row(mesa_format format, GLuint n,
    GLuint i;
    GLubyte *d = dst;
 
+#if defined(USE_SSE41)
+   if (cpu_has_sse4_1 && _mesa_sse_pack_ubyte_rgba_row(format, n, src, d))
+      return;
+#endif
+
    switch (format) {
 %for f in rgb_formats:
    %if f.is_compressed():
@@ -405,6 +412,19 @@ _mesa_pack_float_rgba_row(mesa_format format, GLuint n,
    GLuint i;
    GLubyte *d = dst;
 
+   if (format == MESA_FORMAT_RGBA_FLOAT16) {
+      /* The row is a flat float array and the packed row a flat half array,
+       * so convert the whole thing in bulk (F16C when available).
+       */
+      _mesa_float_to_half_array((GLhalfARB *) d, (const GLfloat *) src, n * 4);
+      return;
+   }
+
+#if defined(USE_SSE41)
+   if (cpu_has_sse4_1 && _mesa_sse_pack_float_rgba_row(format, n, src, d))
+      return;
+#endif
+
    switch (format) {
 %for f in rgb_formats:
    %if f.is_compressed():
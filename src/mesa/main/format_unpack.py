@@ -46,6 +46,8 @@ string = """/*
 #include "format_unpack.h"
 #include "format_utils.h"
 #include "macros.h"
+#include "sse_format_rows.h"
+#include "x86/common_x86_asm.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
 #include "util/format_srgb.h"
@@ -311,6 +313,14 @@ _mesa_unpack_rgba_row(mesa_format format, GLuint n,
    GLubyte *s = (GLubyte *)src;
    GLuint i;
 
+   if (format == MESA_FORMAT_RGBA_FLOAT16) {
+      /* The packed row is a flat half array and the output a flat float
+       * array, so convert the whole thing in bulk (F16C when available).
+       */
+      _mesa_half_to_float_array((GLfloat *) dst, (const GLhalfARB *) s, n * 4);
+      return;
+   }
+
    switch (format) {
 %for f in rgb_formats:
    %if f.is_compressed():
@@ -345,6 +355,11 @@ _mesa_unpack_ubyte_rgba_row(mesa_format format, GLuint n,
    GLubyte *s = (GLubyte *)src;
    GLuint i;
 
+#if defined(USE_SSE41)
+   if (cpu_has_sse4_1 && _mesa_sse_unpack_ubyte_rgba_row(format, n, s, dst))
+      return;
+#endif
+
    switch (format) {
 %for f in rgb_formats:
    %if not f.is_normalized():
@@ -777,6 +777,52 @@ swizzle_convert_try_memcpy(void *dst,
    return true;
 }
 
+/**
+ * Attempts to perform the given swizzle-and-convert operation with the bulk
+ * half-float array helpers
+ *
+ * Half<->float conversions with an identity swizzle and matching channel
+ * counts are just a flat array conversion, which
+ * _mesa_float_to_half_array()/_mesa_half_to_float_array() do with F16C when
+ * the CPU has it.  Anything else falls back to the standard loops below.
+ *
+ * \return  true if it successfully performed the swizzle-and-convert
+ *          operation with a bulk conversion, false otherwise
+ */
+static bool
+swizzle_convert_try_half_array(void *dst,
+                               enum mesa_array_format_datatype dst_type,
+                               int num_dst_channels,
+                               const void *src,
+                               enum mesa_array_format_datatype src_type,
+                               int num_src_channels,
+                               const uint8_t swizzle[4], bool normalized,
+                               int count)
+{
+   int i;
+
+   if (num_src_channels != num_dst_channels)
+      return false;
+
+   for (i = 0; i < num_dst_channels; ++i)
+      if (swizzle[i] != i && swizzle[i] != MESA_FORMAT_SWIZZLE_NONE)
+         return false;
+
+   if (dst_type == MESA_ARRAY_FORMAT_TYPE_HALF &&
+       src_type == MESA_ARRAY_FORMAT_TYPE_FLOAT) {
+      _mesa_float_to_half_array(dst, src, count * num_src_channels);
+      return true;
+   }
+
+   if (dst_type == MESA_ARRAY_FORMAT_TYPE_FLOAT &&
+       src_type == MESA_ARRAY_FORMAT_TYPE_HALF) {
+      _mesa_half_to_float_array(dst, src, count * num_src_channels);
+      return true;
+   }
+
+   return false;
+}
+
 /**
  * Represents a single instance of the standard swizzle-and-convert loop
  *
@@ -1496,6 +1542,11 @@ _mesa_swizzle_and_convert(void *void_dst, enum mesa_array_format_datatype dst_ty
                                   swizzle, normalized, count))
       return;
 
+   if (swizzle_convert_try_half_array(void_dst, dst_type, num_dst_channels,
+                                      void_src, src_type, num_src_channels,
+                                      swizzle, normalized, count))
+      return;
+
    switch (dst_type) {
    case MESA_ARRAY_FORMAT_TYPE_FLOAT:
       convert_float(void_dst, num_dst_channels, void_src, src_type,
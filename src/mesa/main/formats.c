@@ -89,6 +89,47 @@ _mesa_get_format_info(mesa_format format)
 }
 
 
+static struct mesa_format_fast_info format_fast_info[MESA_FORMAT_COUNT];
+static once_flag format_fast_info_filled = ONCE_FLAG_INIT;
+
+static void
+format_fast_info_init(void)
+{
+   unsigned i;
+
+   STATIC_ASSERT(sizeof(struct mesa_format_fast_info) == 16);
+
+   for (i = 0; i < MESA_FORMAT_COUNT; i++) {
+      const struct gl_format_info *info = &format_info[i];
+      struct mesa_format_fast_info *fast = &format_fast_info[i];
+
+      assert(info->BaseFormat <= 0xffff && info->DataType <= 0xffff);
+
+      fast->BaseFormat = (GLushort) info->BaseFormat;
+      fast->DataType = (GLushort) info->DataType;
+      fast->BytesPerBlock = info->BytesPerBlock;
+      fast->BlockWidth = info->BlockWidth;
+      fast->BlockHeight = info->BlockHeight;
+      fast->BlockDepth = info->BlockDepth;
+      memcpy(fast->Swizzle, info->Swizzle, 4);
+      fast->IsSRGBFormat = info->IsSRGBFormat;
+   }
+}
+
+
+/**
+ * Return the compact info record for the given format; see the struct
+ * comment in formats.h.
+ */
+const struct mesa_format_fast_info *
+_mesa_get_format_fast_info(mesa_format format)
+{
+   call_once(&format_fast_info_filled, format_fast_info_init);
+   assert(format < MESA_FORMAT_COUNT);
+   return &format_fast_info[format];
+}
+
+
 /** Return string name of format (for debugging) */
 const char *
 _mesa_get_format_name(mesa_format format)
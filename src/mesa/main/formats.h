@@ -660,6 +660,30 @@ typedef enum
 } mesa_format;
 
 
+/**
+ * Compact per-format record holding the fields the hot conversion and
+ * validation paths need, packed into 16 bytes so a cache line covers
+ * four formats.  Fetch it once with _mesa_get_format_fast_info() and
+ * read the fields directly instead of making several
+ * _mesa_get_format_*() calls against the same format.
+ */
+struct mesa_format_fast_info
+{
+   GLushort BaseFormat;       /**< GLenum; all base formats fit in 16 bits */
+   GLushort DataType;         /**< GLenum, e.g. GL_UNSIGNED_NORMALIZED */
+   GLubyte BytesPerBlock;
+   GLubyte BlockWidth;
+   GLubyte BlockHeight;
+   GLubyte BlockDepth;
+   GLubyte Swizzle[4];        /**< MESA_FORMAT_SWIZZLE_x */
+   GLubyte IsSRGBFormat;
+   GLubyte Pad[3];
+};
+
+
+extern const struct mesa_format_fast_info *
+_mesa_get_format_fast_info(mesa_format format);
+
 extern const char *
 _mesa_get_format_name(mesa_format format);
 
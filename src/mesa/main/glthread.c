@@ -0,0 +1,243 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2012 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file glthread.c
+ *
+ * Threaded GL dispatch (glthread).
+ *
+ * Instead of executing GL commands on the application thread, the marshal
+ * dispatch table (see marshal_generated.c) encodes them into command
+ * batches which a dedicated server thread replays through the regular
+ * dispatch table.  Commands which cannot be encoded, mostly because they
+ * return data to the application, drain the queue and execute on the
+ * application thread instead, so ordering is always preserved.
+ *
+ * This is an opt-in feature enabled by setting MESA_GLTHREAD in the
+ * environment.  It helps single-threaded CPU-bound applications, but note
+ * that client-side vertex arrays are unsafe with it: a marshalled draw may
+ * read client memory after the application has resumed modifying it.
+ */
+
+#include "main/glthread.h"
+#include "main/context.h"
+#include "main/imports.h"
+#include "main/marshal.h"
+#include "glapi/glapi.h"
+
+
+static void
+glthread_execute_batch(struct gl_context *ctx, struct glthread_batch *batch)
+{
+   size_t pos = 0;
+
+   while (pos < batch->used) {
+      const struct marshal_cmd_base *cmd =
+         (const struct marshal_cmd_base *) &batch->buffer[pos];
+
+      pos += _mesa_unmarshal_dispatch_cmd(ctx, cmd);
+   }
+   assert(pos == batch->used);
+}
+
+
+static int
+glthread_server(void *data)
+{
+   struct gl_context *ctx = data;
+   struct glthread_state *glthread = ctx->GLThread;
+
+   /* The command implementations use GET_CURRENT_CONTEXT(), so the context
+    * has to look current on this thread too.  The application thread only
+    * encodes commands while glthread is active, so the two threads never
+    * touch GL state concurrently.
+    */
+   _glapi_set_context(ctx);
+
+   mtx_lock(&glthread->mutex);
+   while (true) {
+      struct glthread_batch *batch = glthread->batch_queue;
+
+      if (batch == NULL) {
+         if (glthread->shutdown)
+            break;
+         cnd_wait(&glthread->new_work, &glthread->mutex);
+         continue;
+      }
+
+      glthread->batch_queue = batch->next;
+      if (glthread->batch_queue == NULL)
+         glthread->batch_queue_tail = NULL;
+
+      mtx_unlock(&glthread->mutex);
+      glthread_execute_batch(ctx, batch);
+      free(batch);
+      mtx_lock(&glthread->mutex);
+
+      if (glthread->batch_queue == NULL) {
+         glthread->busy = false;
+         cnd_broadcast(&glthread->work_done);
+      }
+   }
+   glthread->busy = false;
+   cnd_broadcast(&glthread->work_done);
+   mtx_unlock(&glthread->mutex);
+
+   return 0;
+}
+
+
+void
+_mesa_glthread_init(struct gl_context *ctx)
+{
+   struct glthread_state *glthread;
+
+   glthread = calloc(1, sizeof(*glthread));
+   if (glthread == NULL)
+      return;
+
+   glthread->batch = calloc(1, sizeof(*glthread->batch));
+   if (glthread->batch == NULL) {
+      free(glthread);
+      return;
+   }
+
+   ctx->MarshalExec = _mesa_create_marshal_table(ctx);
+   if (ctx->MarshalExec == NULL) {
+      free(glthread->batch);
+      free(glthread);
+      return;
+   }
+
+   mtx_init(&glthread->mutex, mtx_plain);
+   cnd_init(&glthread->new_work);
+   cnd_init(&glthread->work_done);
+
+   /* The server thread reads ctx->GLThread, so set it first. */
+   ctx->GLThread = glthread;
+
+   if (thrd_create(&glthread->thread, glthread_server, ctx) != thrd_success) {
+      ctx->GLThread = NULL;
+      free(ctx->MarshalExec);
+      ctx->MarshalExec = NULL;
+      cnd_destroy(&glthread->work_done);
+      cnd_destroy(&glthread->new_work);
+      mtx_destroy(&glthread->mutex);
+      free(glthread->batch);
+      free(glthread);
+   }
+}
+
+
+void
+_mesa_glthread_destroy(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   int result;
+
+   if (glthread == NULL)
+      return;
+
+   _mesa_glthread_flush_batch(ctx);
+
+   mtx_lock(&glthread->mutex);
+   glthread->shutdown = true;
+   cnd_broadcast(&glthread->new_work);
+   mtx_unlock(&glthread->mutex);
+
+   thrd_join(glthread->thread, &result);
+
+   cnd_destroy(&glthread->work_done);
+   cnd_destroy(&glthread->new_work);
+   mtx_destroy(&glthread->mutex);
+   free(glthread->batch);
+   free(glthread);
+   ctx->GLThread = NULL;
+}
+
+
+/**
+ * Submit the batch currently being filled to the server thread.
+ */
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_batch *batch = glthread->batch;
+   struct glthread_batch *fresh;
+
+   if (batch->used == 0)
+      return;
+
+   fresh = calloc(1, sizeof(*fresh));
+   if (fresh == NULL) {
+      /* Out of memory: wait for the server to go idle, then execute the
+       * batch in place on the application thread.
+       */
+      mtx_lock(&glthread->mutex);
+      while (glthread->busy)
+         cnd_wait(&glthread->work_done, &glthread->mutex);
+      mtx_unlock(&glthread->mutex);
+
+      glthread_execute_batch(ctx, batch);
+      batch->used = 0;
+      return;
+   }
+
+   mtx_lock(&glthread->mutex);
+   if (glthread->batch_queue_tail)
+      glthread->batch_queue_tail->next = batch;
+   else
+      glthread->batch_queue = batch;
+   glthread->batch_queue_tail = batch;
+   glthread->busy = true;
+   cnd_signal(&glthread->new_work);
+   mtx_unlock(&glthread->mutex);
+
+   glthread->batch = fresh;
+}
+
+
+/**
+ * Wait for all pending batches to have been executed.
+ *
+ * This is the synchronization point used by every GL call which cannot be
+ * marshalled asynchronously, so that the application thread observes the
+ * same state it would without glthread.
+ */
+void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (glthread == NULL)
+      return;
+
+   _mesa_glthread_flush_batch(ctx);
+
+   mtx_lock(&glthread->mutex);
+   while (glthread->busy)
+      cnd_wait(&glthread->work_done, &glthread->mutex);
+   mtx_unlock(&glthread->mutex);
+}
@@ -0,0 +1,98 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2012 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file glthread.h
+ *
+ * State used by the threaded GL dispatch (glthread), see glthread.c.
+ */
+
+#ifndef GLTHREAD_H
+#define GLTHREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "c11/threads.h"
+
+/** The size of one batch of marshalled commands, in bytes. */
+#define MARSHAL_MAX_CMD_SIZE (64 * 1024)
+
+struct gl_context;
+
+/**
+ * A batch of marshalled commands, executed in order by the server thread.
+ */
+struct glthread_batch
+{
+   struct glthread_batch *next;
+
+   /** Number of bytes of \c buffer which contain commands. */
+   size_t used;
+
+   /** The commands, a sequence of marshal_cmd_base-headed records. */
+   uint8_t buffer[MARSHAL_MAX_CMD_SIZE];
+};
+
+struct glthread_state
+{
+   /** The server thread which executes marshalled commands. */
+   thrd_t thread;
+
+   /** Protects all fields below. */
+   mtx_t mutex;
+
+   /** Signalled when a batch is queued or shutdown is requested. */
+   cnd_t new_work;
+
+   /** Signalled when the server thread runs out of work. */
+   cnd_t work_done;
+
+   /** Tells the server thread to exit once the queue is empty. */
+   bool shutdown;
+
+   /** True while batches are queued or being executed. */
+   bool busy;
+
+   /** Queue of batches waiting to be executed, oldest first. */
+   struct glthread_batch *batch_queue;
+   struct glthread_batch *batch_queue_tail;
+
+   /** The batch currently being filled by the application thread. */
+   struct glthread_batch *batch;
+};
+
+void
+_mesa_glthread_init(struct gl_context *ctx);
+
+void
+_mesa_glthread_destroy(struct gl_context *ctx);
+
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx);
+
+void
+_mesa_glthread_finish(struct gl_context *ctx);
+
+#endif /* GLTHREAD_H */
@@ -36,8 +36,10 @@
 
 #include "glheader.h"
 #include "imports.h"
+#include "macros.h"
 #include "hash.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 
 /**
  * Magic GLuint object name that gets stored outside of the struct hash_table.
@@ -52,11 +54,44 @@
  */
 #define DELETED_KEY_VALUE 1
 
+/** @{
+ * Bounds of the flat name->data array that mirrors the hash table for small
+ * keys so that _mesa_HashLookup() can answer without taking the mutex.
+ * glGen*()ed names are small consecutive integers, so in practice the mirror
+ * covers everything; apps that bind huge hand-picked names just fall back to
+ * the locked path for those names.
+ */
+#define FLAT_ARRAY_MIN_SIZE 1024
+#define FLAT_ARRAY_MAX_SIZE (64 * 1024)
+/** @} */
+
+/**
+ * Flat mirror of the hash table for keys < size.  The entries array lives in
+ * the same allocation so that a reader dereferencing a published pointer
+ * always sees a consistent size/data pair.
+ */
+struct flat_array {
+   GLuint size;                /**< number of entries in data[] */
+   void **data;                /**< data[key], NULL if key absent */
+};
+
 /**
- * The hash table data structure.  
+ * The hash table data structure.
  */
 struct _mesa_HashTable {
    struct hash_table *ht;
+   struct flat_array *flat;              /**< lock-free lookup mirror */
+   /** Outgrown incarnations of 'flat'.  Lock-free readers may still be
+    * looking at them, so they are only freed together with the table;
+    * doubling growth keeps this list (and the memory it pins) small.
+    */
+   struct flat_array *retired_flat[16];
+   GLuint num_retired;
+   /** Set when a failed grow left a small key out of 'flat'; the next
+    * successful grow rebuilds from the hash table instead of copying the
+    * incomplete mirror forward.
+    */
+   GLboolean flat_incomplete;
    GLuint MaxKey;                        /**< highest key inserted so far */
    mtx_t Mutex;                /**< mutual exclusion lock */
    mtx_t WalkMutex;            /**< for _mesa_HashWalk() */
@@ -109,6 +144,77 @@ uint_key(GLuint id)
 }
 /** @} */
 
+/**
+ * Mirror an insertion or removal into the flat lookup array, growing it if
+ * needed.  Must be called with the table mutex held.
+ */
+static void
+update_flat_array(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+   struct flat_array *flat = table->flat;
+
+   if (key >= FLAT_ARRAY_MAX_SIZE)
+      return;
+
+   if (!flat || key >= flat->size) {
+      struct flat_array *bigger;
+      GLuint size;
+
+      /* a key the array doesn't cover is already "not present" */
+      if (!data)
+         return;
+
+      size = flat ? flat->size : FLAT_ARRAY_MIN_SIZE;
+      while (size <= key)
+         size *= 2;
+
+      bigger = malloc(sizeof(*bigger) + size * sizeof(void *));
+      if (!bigger) {
+         /* The key is in the hash table but not in the mirror.  That's
+          * fine while the mirror doesn't cover it (readers fall back to
+          * the locked path), but a later grow that covers the key must
+          * not copy this incomplete mirror forward, or lock-free lookups
+          * would miss a live entry.  Flag it for rebuilding.
+          */
+         table->flat_incomplete = GL_TRUE;
+         return;   /* no mirror for this key; locked lookups still work */
+      }
+      bigger->size = size;
+      bigger->data = (void **) (bigger + 1);
+      memset(bigger->data, 0, size * sizeof(void *));
+      if (table->flat_incomplete) {
+         /* Repopulate from the table itself; we hold the mutex, so it
+          * can't change underneath us.
+          */
+         struct hash_entry *entry;
+         hash_table_foreach(table->ht, entry) {
+            GLuint k = (GLuint)(uintptr_t) entry->key;
+            if (k < size)
+               bigger->data[k] = entry->data;
+         }
+         if (table->deleted_key_data)
+            bigger->data[DELETED_KEY_VALUE] = table->deleted_key_data;
+         table->flat_incomplete = GL_FALSE;
+      } else if (flat) {
+         memcpy(bigger->data, flat->data, flat->size * sizeof(void *));
+      }
+
+      /* Publish the new array.  The cmpxchg always succeeds (we hold the
+       * mutex); it's used for its memory barrier, so that a lock-free
+       * reader can't see the pointer before the contents written above.
+       */
+      (void) p_atomic_cmpxchg(&table->flat, flat, bigger);
+
+      if (flat) {
+         assert(table->num_retired < ARRAY_SIZE(table->retired_flat));
+         table->retired_flat[table->num_retired++] = flat;
+      }
+      flat = bigger;
+   }
+
+   p_atomic_set(&flat->data[key], data);
+}
+
 /**
  * Create a new hash table.
  * 
@@ -152,6 +258,8 @@ _mesa_NewHashTable(void)
 void
 _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 {
+   GLuint i;
+
    assert(table);
 
    if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL) {
@@ -160,6 +268,10 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   free(table->flat);
+   for (i = 0; i < table->num_retired; i++)
+      free(table->retired_flat[i]);
+
    mtx_destroy(&table->Mutex);
    mtx_destroy(&table->WalkMutex);
    free(table);
@@ -201,8 +313,23 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
+   const struct flat_array *flat;
    void *res;
+
    assert(table);
+   assert(key);
+
+   /* The flat array mirrors every entry with a small key, so if it covers
+    * this key we can answer without taking the mutex: entry updates are
+    * single aligned pointer stores and the array is published fully
+    * initialized (and never freed while the table exists).  This is what
+    * makes glBind* of one context cheap while another thread is genning
+    * and uploading objects.
+    */
+   flat = p_atomic_read(&table->flat);
+   if (flat && key < flat->size)
+      return p_atomic_read(&flat->data[key]);
+
    mtx_lock(&table->Mutex);
    res = _mesa_HashLookup_unlocked(table, key);
    mtx_unlock(&table->Mutex);
@@ -280,6 +407,8 @@ _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
          _mesa_hash_table_insert_pre_hashed(table->ht, hash, uint_key(key), data);
       }
    }
+
+   update_flat_array(table, key, data);
 }
 
 
@@ -349,6 +478,8 @@ _mesa_HashRemove_unlocked(struct _mesa_HashTable *table, GLuint key)
       entry = _mesa_hash_table_search(table->ht, uint_key(key));
       _mesa_hash_table_remove(table->ht, entry);
    }
+
+   update_flat_array(table, key, NULL);
 }
 
 
@@ -394,6 +525,10 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
       callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
       table->deleted_key_data = NULL;
    }
+   if (table->flat)
+      memset(table->flat->data, 0, table->flat->size * sizeof(void *));
+   /* the table is empty, so the mirror can't be missing anything now */
+   table->flat_incomplete = GL_FALSE;
    table->InDeleteAll = GL_FALSE;
    mtx_unlock(&table->Mutex);
 }
@@ -0,0 +1,60 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2012 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file marshal.c
+ *
+ * Helpers for the generated command marshalling code, see glthread.c.
+ */
+
+#include "main/glthread.h"
+#include "main/macros.h"
+#include "main/marshal.h"
+#include "main/mtypes.h"
+
+
+/**
+ * Reserve space for a command in the batch currently being filled,
+ * submitting the batch first if the command doesn't fit.
+ */
+void *
+_mesa_glthread_allocate_command(struct gl_context *ctx,
+                                uint16_t cmd_id, size_t size)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct marshal_cmd_base *cmd_base;
+   const size_t aligned_size = ALIGN(size, 8);
+
+   assert(aligned_size <= MARSHAL_MAX_CMD_SIZE);
+
+   if (glthread->batch->used + aligned_size > MARSHAL_MAX_CMD_SIZE)
+      _mesa_glthread_flush_batch(ctx);
+
+   cmd_base = (struct marshal_cmd_base *)
+      &glthread->batch->buffer[glthread->batch->used];
+   glthread->batch->used += aligned_size;
+   cmd_base->cmd_id = cmd_id;
+   cmd_base->cmd_size = aligned_size;
+   return cmd_base;
+}
@@ -0,0 +1,66 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2012 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file marshal.h
+ *
+ * Declarations shared between glthread.c and the generated command
+ * marshalling code in marshal_generated.c.
+ */
+
+#ifndef MARSHAL_H
+#define MARSHAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct gl_context;
+struct _glapi_table;
+
+/**
+ * Header of every record in a glthread batch buffer.
+ */
+struct marshal_cmd_base
+{
+   /** One of the DISPATCH_CMD_* ids from marshal_generated.c. */
+   uint16_t cmd_id;
+
+   /** Size of the whole record in bytes; a multiple of 8. */
+   uint16_t cmd_size;
+};
+
+void *
+_mesa_glthread_allocate_command(struct gl_context *ctx,
+                                uint16_t cmd_id, size_t size);
+
+/* In marshal_generated.c: */
+
+struct _glapi_table *
+_mesa_create_marshal_table(const struct gl_context *ctx);
+
+size_t
+_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx,
+                             const struct marshal_cmd_base *cmd);
+
+#endif /* MARSHAL_H */
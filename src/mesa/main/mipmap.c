@@ -27,6 +27,8 @@
  * \file mipmap.c  mipmap generation and teximage resizing functions.
  */
 
+#include "c11/threads.h"
+
 #include "imports.h"
 #include "formats.h"
 #include "glformats.h"
@@ -37,6 +39,8 @@
 #include "texstore.h"
 #include "image.h"
 #include "macros.h"
+#include "sse_mipmap.h"
+#include "x86/common_x86_asm.h"
 #include "util/half_float.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
@@ -166,6 +170,14 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
       const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
       const GLubyte(*rowB)[4] = (const GLubyte(*)[4]) srcRowB;
       GLubyte(*dst)[4] = (GLubyte(*)[4]) dstRow;
+#if defined(USE_SSE41)
+      if (cpu_has_sse4_1 && colStride == 2) {
+         _mesa_sse_downsample_rgba8_row((const GLubyte *) srcRowA,
+                                        (const GLubyte *) srcRowB,
+                                        dstWidth, (GLubyte *) dstRow);
+         return;
+      }
+#endif
       for (i = j = 0, k = k0; i < (GLuint) dstWidth;
            i++, j += colStride, k += colStride) {
          dst[i][0] = (rowA[j][0] + rowA[k][0] + rowB[j][0] + rowB[k][0]) / 4;
@@ -795,6 +807,16 @@ do_row_3D(GLenum datatype, GLuint comps, GLint srcWidth,
    if ((datatype == GL_UNSIGNED_BYTE) && (comps == 4)) {
       DECLARE_ROW_POINTERS(GLubyte, 4);
 
+#if defined(USE_SSE41)
+      if (cpu_has_sse4_1 && colStride == 2) {
+         _mesa_sse_downsample_rgba8_row_3D((const GLubyte *) srcRowA,
+                                           (const GLubyte *) srcRowB,
+                                           (const GLubyte *) srcRowC,
+                                           (const GLubyte *) srcRowD,
+                                           dstWidth, (GLubyte *) dstRow);
+         return;
+      }
+#endif
       for (i = j = 0, k = k0; i < (GLuint) dstWidth;
            i++, j += colStride, k += colStride) {
          FILTER_3D(0);
@@ -1442,6 +1464,51 @@ make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/**
+ * Minimum size (in texels) of a dest image for filtering its rows on
+ * multiple threads; smaller images aren't worth the thread creation cost.
+ */
+#define MIPMAP_PARALLEL_THRESHOLD (1024 * 1024)
+
+/** Max number of threads used for one mipmap level, including the caller */
+#define MIPMAP_MAX_THREADS 4
+
+
+struct mipmap_rows_args
+{
+   GLenum datatype;
+   GLuint comps;
+   GLint srcWidthNB;
+   const GLubyte *srcA;
+   const GLubyte *srcB;
+   GLint srcRowDelta;
+   GLint dstWidthNB;
+   GLubyte *dst;
+   GLint dstRowStride;
+   GLint numRows;
+};
+
+
+static int
+do_rows_func(void *data)
+{
+   const struct mipmap_rows_args *args = data;
+   const GLubyte *srcA = args->srcA;
+   const GLubyte *srcB = args->srcB;
+   GLubyte *dst = args->dst;
+   GLint row;
+
+   for (row = 0; row < args->numRows; row++) {
+      do_row(args->datatype, args->comps, args->srcWidthNB, srcA, srcB,
+             args->dstWidthNB, dst);
+      srcA += args->srcRowDelta;
+      srcB += args->srcRowDelta;
+      dst += args->dstRowStride;
+   }
+   return 0;
+}
+
+
 static void
 make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
                GLint srcWidth, GLint srcHeight,
@@ -1472,12 +1539,59 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 
    dst = dstPtr + border * ((dstWidth + 1) * bpt);
 
-   for (row = 0; row < dstHeightNB; row++) {
-      do_row(datatype, comps, srcWidthNB, srcA, srcB,
-             dstWidthNB, dst);
-      srcA += srcRowStep * srcRowStride;
-      srcB += srcRowStep * srcRowStride;
-      dst += dstRowStride;
+   if (dstWidthNB * dstHeightNB >= MIPMAP_PARALLEL_THRESHOLD &&
+       dstHeightNB >= MIPMAP_MAX_THREADS) {
+      /* Big image: farm the rows out to several threads.  Each dest row
+       * only depends on its own pair of source rows, so disjoint row
+       * ranges can be filtered concurrently.
+       */
+      struct mipmap_rows_args args[MIPMAP_MAX_THREADS];
+      thrd_t threads[MIPMAP_MAX_THREADS];
+      GLboolean created[MIPMAP_MAX_THREADS];
+      const GLint rowsPerJob = dstHeightNB / MIPMAP_MAX_THREADS;
+      GLint firstRow = 0;
+      GLuint t;
+
+      for (t = 0; t < MIPMAP_MAX_THREADS; t++) {
+         args[t].datatype = datatype;
+         args[t].comps = comps;
+         args[t].srcWidthNB = srcWidthNB;
+         args[t].srcA = srcA + firstRow * srcRowStep * srcRowStride;
+         args[t].srcB = srcB + firstRow * srcRowStep * srcRowStride;
+         args[t].srcRowDelta = srcRowStep * srcRowStride;
+         args[t].dstWidthNB = dstWidthNB;
+         args[t].dst = dst + firstRow * dstRowStride;
+         args[t].dstRowStride = dstRowStride;
+         /* the last job takes the remainder rows */
+         args[t].numRows = (t == MIPMAP_MAX_THREADS - 1)
+            ? dstHeightNB - firstRow : rowsPerJob;
+         firstRow += rowsPerJob;
+      }
+
+      for (t = 1; t < MIPMAP_MAX_THREADS; t++) {
+         created[t] = thrd_create(&threads[t], do_rows_func,
+                                  &args[t]) == thrd_success;
+         if (!created[t]) {
+            /* no thread: filter this range on the calling thread */
+            do_rows_func(&args[t]);
+         }
+      }
+
+      do_rows_func(&args[0]);
+
+      for (t = 1; t < MIPMAP_MAX_THREADS; t++) {
+         if (created[t])
+            thrd_join(threads[t], NULL);
+      }
+   }
+   else {
+      for (row = 0; row < dstHeightNB; row++) {
+         do_row(datatype, comps, srcWidthNB, srcA, srcB,
+                dstWidthNB, dst);
+         srcA += srcRowStep * srcRowStride;
+         srcB += srcRowStep * srcRowStride;
+         dst += dstRowStride;
+      }
    }
 
    /* This is ugly but probably won't be used much */
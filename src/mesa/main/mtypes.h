@@ -80,6 +80,7 @@ struct gl_program_cache;
 struct gl_texture_object;
 struct gl_debug_state;
 struct gl_context;
+struct glthread_state;
 struct st_context;
 struct gl_uniform_storage;
 struct prog_instruction;
@@ -990,6 +991,7 @@ struct gl_texture_object
    GLboolean GenerateMipmap;   /**< GL_SGIS_generate_mipmap */
    GLboolean _BaseComplete;    /**< Is the base texture level valid? */
    GLboolean _MipmapComplete;  /**< Is the whole mipmap valid? */
+   GLboolean _CompletenessValid; /**< Are the _*Complete flags up to date? */
    GLboolean _IsIntegerFormat; /**< Does the texture store integer values? */
    GLboolean _RenderToTexture; /**< Any rendering to this texture? */
    GLboolean Purgeable;        /**< Is the buffer purgeable under memory
@@ -1441,6 +1443,13 @@ struct gl_vertex_array_object
    /** Mask of VERT_BIT_* values indicating changed/dirty arrays */
    GLbitfield64 NewArrays;
 
+   /**
+    * Serial number, unique within the context, which is updated whenever
+    * the array or binding state above changes.  Unlike NewArrays it is
+    * never cleared, so drivers can keep caches keyed on it.
+    */
+   GLuint StateSerial;
+
    /** The index buffer (also known as the element array buffer in OpenGL). */
    struct gl_buffer_object *IndexBufferObj;
 };
@@ -1485,6 +1494,9 @@ struct gl_array_attrib
    /** The last VAO accessed by a DSA function */
    struct gl_vertex_array_object *LastLookedUpVAO;
 
+   /** Source of gl_vertex_array_object::StateSerial values */
+   GLuint NextVAOStateSerial;
+
    /** Array objects (GL_ARB/APPLE_vertex_array_object) */
    struct _mesa_HashTable *Objects;
 
@@ -3025,7 +3037,7 @@ struct gl_sync_object
 struct gl_shared_state
 {
    mtx_t Mutex;		   /**< for thread safety */
-   GLint RefCount;			   /**< Reference count */
+   GLint RefCount;			   /**< Reference count, atomic */
    struct _mesa_HashTable *DisplayList;	   /**< Display lists hash table */
    struct _mesa_HashTable *BitmapAtlas;    /**< For optimized glBitmap text */
    struct _mesa_HashTable *TexObjects;	   /**< Texture objects hash table */
@@ -3074,6 +3086,7 @@ struct gl_shared_state
 
    /* GL_ARB_sync */
    struct set *SyncObjects;
+   mtx_t SyncMutex;	   /**< protects SyncObjects and sync ref counts */
 
    /** GL_ARB_sampler_objects */
    struct _mesa_HashTable *SamplerObjects;
@@ -4268,6 +4281,30 @@ struct gl_atomic_buffer_binding
    GLsizeiptr Size;
 };
 
+/**
+ * Cached verdict of the state-dependent part of draw-call validation
+ * (primitive mode vs. shader stages, valid-to-render checks).
+ *
+ * Repeat draws with unchanged state are extremely common, so api_validate.c
+ * snapshots the state a successful validation depended on and skips the
+ * checks while the snapshot still matches.  See validate_draw_state().
+ */
+struct gl_draw_validation_cache
+{
+   GLboolean Valid;      /**< whether the snapshot below validated OK */
+   GLenum Mode;          /**< primitive mode the verdict applies to */
+   struct gl_vertex_array_object *VAO;
+   struct gl_pipeline_object *Shader;
+   /** Transform feedback state can change without setting a
+    * gl_context::NewState flag, so it's compared explicitly.
+    */
+   struct gl_transform_feedback_object *XFBObj;
+   GLboolean XFBActive;
+   GLboolean XFBPaused;
+   GLenum XFBMode;
+};
+
+
 /**
  * Mesa rendering context.
  *
@@ -4306,8 +4343,17 @@ struct gl_context
     * re-set on glXMakeCurrent().
     */
    struct _glapi_table *CurrentDispatch;
+
+   /**
+    * Dispatch table which marshals GL calls to the glthread server thread,
+    * or NULL when glthread is not in use.  See glthread.c.
+    */
+   struct _glapi_table *MarshalExec;
    /*@}*/
 
+   /** Threaded dispatch state, or NULL.  See glthread.c. */
+   struct glthread_state *GLThread;
+
    struct gl_config Visual;
    struct gl_framebuffer *DrawBuffer;	/**< buffer for writing */
    struct gl_framebuffer *ReadBuffer;	/**< buffer for reading */
@@ -4527,6 +4573,9 @@ struct gl_context
 
    struct gl_driver_flags DriverFlags;
 
+   /** Cached draw-call validation verdict, see api_validate.c */
+   struct gl_draw_validation_cache DrawValidation;
+
    GLboolean ViewportInitialized;  /**< has viewport size been initialized? */
 
    GLbitfield64 varying_vp_inputs;  /**< mask of VERT_BIT_* flags */
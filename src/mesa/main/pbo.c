@@ -63,6 +63,36 @@
  * \return GL_TRUE if the buffer access is OK, GL_FALSE if the access would
  *         go out of bounds.
  */
+/**
+ * Compute the range of bytes [*startOut, *endOut) relative to the start of
+ * the pixel data that a transfer of the given image will touch, taking the
+ * pixelstore state (row length, skip rows/pixels, alignment) into account.
+ * \return GL_FALSE if the image is zero-sized (no bytes are accessed)
+ */
+static GLboolean
+get_pbo_access_range(GLuint dimensions,
+                     const struct gl_pixelstore_attrib *pack,
+                     GLsizei width, GLsizei height, GLsizei depth,
+                     GLenum format, GLenum type,
+                     uintptr_t *startOut, uintptr_t *endOut)
+{
+   if (width == 0 || height == 0 || depth == 0) {
+      *startOut = *endOut = 0;
+      return GL_FALSE;
+   }
+
+   /* offset of the first pixel we'll read/write */
+   *startOut = _mesa_image_offset(dimensions, pack, width, height,
+                                  format, type, 0, 0, 0);
+
+   /* offset of just past the last pixel we'll read/write */
+   *endOut = _mesa_image_offset(dimensions, pack, width, height,
+                                format, type, depth-1, height-1, width);
+
+   return GL_TRUE;
+}
+
+
 GLboolean
 _mesa_validate_pbo_access(GLuint dimensions,
                           const struct gl_pixelstore_attrib *pack,
@@ -106,17 +136,10 @@ _mesa_validate_pbo_access(GLuint dimensions,
    /* If the size of the image is zero then no pixels are accessed so we
     * don't need to check anything else.
     */
-   if (width == 0 || height == 0 || depth == 0)
+   if (!get_pbo_access_range(dimensions, pack, width, height, depth,
+                             format, type, &start, &end))
       return GL_TRUE;
 
-   /* get the offset to the first pixel we'll read/write */
-   start = _mesa_image_offset(dimensions, pack, width, height,
-                              format, type, 0, 0, 0);
-
-   /* get the offset to just past the last pixel we'll read/write */
-   end =  _mesa_image_offset(dimensions, pack, width, height,
-                             format, type, depth-1, height-1, width);
-
    start += offset;
    end += offset;
 
@@ -400,6 +423,7 @@ _mesa_validate_pbo_teximage(struct gl_context *ctx, GLuint dimensions,
 			    const char *funcName)
 {
    GLubyte *buf;
+   uintptr_t start, end;
 
    if (!_mesa_is_bufferobj(unpack->BufferObj)) {
       /* no PBO */
@@ -412,8 +436,32 @@ _mesa_validate_pbo_teximage(struct gl_context *ctx, GLuint dimensions,
       return NULL;
    }
 
-   buf = (GLubyte *) ctx->Driver.MapBufferRange(ctx, 0,
-                                                unpack->BufferObj->Size,
+   if (!get_pbo_access_range(dimensions, unpack, width, height, depth,
+                             format, type, &start, &end)) {
+      /* Zero-sized image: nothing will be read, but map the buffer anyway
+       * so the caller's matching _mesa_unmap_teximage_pbo() has something
+       * to unmap.
+       */
+      buf = (GLubyte *) ctx->Driver.MapBufferRange(ctx, 0,
+                                                   unpack->BufferObj->Size,
+                                                   GL_MAP_READ_BIT,
+                                                   unpack->BufferObj,
+                                                   MAP_INTERNAL);
+      if (!buf) {
+         _mesa_error(ctx, GL_INVALID_OPERATION, "%s%uD(PBO is mapped)",
+                     funcName, dimensions);
+         return NULL;
+      }
+      return ADD_POINTERS(buf, pixels);
+   }
+
+   /* Map only the span of the buffer the image covers.  Streaming uploads
+    * often source a small subrange of a large PBO and mapping the whole
+    * buffer can make the driver stall on, or copy, bytes we'll never read.
+    */
+   buf = (GLubyte *) ctx->Driver.MapBufferRange(ctx,
+                                                (GLintptr) pixels + start,
+                                                end - start,
 						GL_MAP_READ_BIT,
 						unpack->BufferObj,
                                                 MAP_INTERNAL);
@@ -423,7 +471,10 @@ _mesa_validate_pbo_teximage(struct gl_context *ctx, GLuint dimensions,
       return NULL;
    }
 
-   return ADD_POINTERS(buf, pixels);
+   /* Return the usual "start of pixel data" pointer; the bytes preceding
+    * \c start are never dereferenced.
+    */
+   return buf - start;
 }
 
 
@@ -454,15 +505,29 @@ _mesa_validate_pbo_compressed_teximage(struct gl_context *ctx,
       return pixels;
    }
 
+   /* Map only the imageSize-byte span the upload will read (see
+    * _mesa_validate_pbo_teximage), falling back to the whole buffer for
+    * zero-sized images so the caller's unmap has something to unmap.
+    */
+   if (imageSize > 0) {
+      buf = (GLubyte*) ctx->Driver.MapBufferRange(ctx, (GLintptr) pixels,
+                                                  imageSize,
+                                                  GL_MAP_READ_BIT,
+                                                  packing->BufferObj,
+                                                  MAP_INTERNAL);
+      /* Validation above already checked that PBO is not mapped, so buffer
+       * should not be null.
+       */
+      assert(buf);
+
+      return buf;
+   }
+
    buf = (GLubyte*) ctx->Driver.MapBufferRange(ctx, 0,
 					       packing->BufferObj->Size,
 					       GL_MAP_READ_BIT,
 					       packing->BufferObj,
                                                MAP_INTERNAL);
-
-   /* Validation above already checked that PBO is not mapped, so buffer
-    * should not be null.
-    */
    assert(buf);
 
    return ADD_POINTERS(buf, pixels);
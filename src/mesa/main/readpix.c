@@ -43,6 +43,14 @@
 #include "pixeltransfer.h"
 
 
+/**
+ * Byte budget for the intermediate RGBA buffer when a two-pass glReadPixels
+ * conversion is tiled by rows.  Sized so that a tile of rows stays cache-hot
+ * between the unpack and repack passes.
+ */
+#define READPIX_TILE_BYTES (512 * 1024)
+
+
 /**
  * Return true if the conversion L=R+G+B is needed.
  */
@@ -86,7 +94,9 @@ _mesa_get_readpixels_transfer_ops(const struct gl_context *ctx,
                                   GLboolean uses_blit)
 {
    GLbitfield transferOps = ctx->_ImageTransferState;
-   GLenum srcBaseFormat = _mesa_get_format_base_format(texFormat);
+   const struct mesa_format_fast_info *texInfo =
+      _mesa_get_format_fast_info(texFormat);
+   GLenum srcBaseFormat = texInfo->BaseFormat;
    GLenum dstBaseFormat = _mesa_unpack_format_to_base_format(format);
 
    if (format == GL_DEPTH_COMPONENT ||
@@ -123,7 +133,7 @@ _mesa_get_readpixels_transfer_ops(const struct gl_context *ctx,
     * because the values are already in the range [0,1] so it won't
     * have any effect anyway.
     */
-   if (_mesa_get_format_datatype(texFormat) == GL_UNSIGNED_NORMALIZED &&
+   if (texInfo->DataType == GL_UNSIGNED_NORMALIZED &&
        !_mesa_need_rgb_to_luminance_conversion(srcBaseFormat, dstBaseFormat)) {
       transferOps &= ~IMAGE_CLAMP_BIT;
    }
@@ -195,7 +205,7 @@ readpixels_can_use_memcpy(const struct gl_context *ctx, GLenum format, GLenum ty
    }
 
    /* The base internal format and the base Mesa format must match. */
-   if (rb->_BaseFormat != _mesa_get_format_base_format(rb->Format)) {
+   if (rb->_BaseFormat != _mesa_get_format_fast_info(rb->Format)->BaseFormat) {
       return GL_FALSE;
    }
 
@@ -238,7 +248,7 @@ readpixels_memcpy(struct gl_context *ctx,
       return GL_TRUE;  /* don't bother trying the slow path */
    }
 
-   texelBytes = _mesa_get_format_bytes(rb->Format);
+   texelBytes = _mesa_get_format_fast_info(rb->Format)->BytesPerBlock;
 
    /* memcpy*/
    for (j = 0; j < height; j++) {
@@ -527,6 +537,43 @@ read_rgba_pixels( struct gl_context *ctx,
           dst_stride == rgba_stride) {
          need_convert = false;
          rgba = dst;
+      } else if (!convert_rgb_to_lum) {
+         /* We need a second conversion from the RGBA buffer to the dst
+          * format.  Rather than materializing the whole image in RGBA form
+          * (half a gigabyte for a 4K float readback), run both passes over
+          * a tile of rows at a time so the intermediate data stays in the
+          * cache.
+          */
+         const int tile_rows = CLAMP(READPIX_TILE_BYTES / rgba_stride,
+                                     1, height);
+         int row;
+
+         rgba = malloc(tile_rows * rgba_stride);
+         if (!rgba) {
+            _mesa_error(ctx, GL_OUT_OF_MEMORY, "glReadPixels");
+            goto done_unmap;
+         }
+
+         for (row = 0; row < height; row += tile_rows) {
+            const int num_rows = MIN2(tile_rows, height - row);
+
+            _mesa_format_convert(rgba, rgba_format, rgba_stride,
+                                 map + row * rb_stride, rb_format, rb_stride,
+                                 width, num_rows,
+                                 needs_rebase ? rebase_swizzle : NULL);
+
+            if (transferOps)
+               _mesa_apply_rgba_transfer_ops(ctx, transferOps,
+                                             width * num_rows, rgba);
+
+            _mesa_format_convert(dst + row * dst_stride, dst_format,
+                                 dst_stride, rgba, rgba_format, rgba_stride,
+                                 width, num_rows, NULL);
+         }
+
+         free(rgba);
+         rgba = NULL;
+         goto done_swap;
       } else {
          need_convert = true;
          rgba = malloc(height * rgba_stride);
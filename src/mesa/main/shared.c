@@ -42,6 +42,7 @@
 
 #include "util/hash_table.h"
 #include "util/set.h"
+#include "util/u_atomic.h"
 
 /**
  * Allocate and initialize a shared context state structure.
@@ -127,6 +128,7 @@ _mesa_alloc_shared_state(struct gl_context *ctx)
 
    shared->SyncObjects = _mesa_set_create(NULL, _mesa_hash_pointer,
                                           _mesa_key_pointer_equal);
+   mtx_init(&shared->SyncMutex, mtx_plain);
 
    return shared;
 }
@@ -377,6 +379,7 @@ free_shared_state(struct gl_context *ctx, struct gl_shared_state *shared)
 
    mtx_destroy(&shared->Mutex);
    mtx_destroy(&shared->TexMutex);
+   mtx_destroy(&shared->SyncMutex);
 
    free(shared);
 }
@@ -397,15 +400,9 @@ _mesa_reference_shared_state(struct gl_context *ctx,
    if (*ptr) {
       /* unref old state */
       struct gl_shared_state *old = *ptr;
-      GLboolean delete;
 
-      mtx_lock(&old->Mutex);
-      assert(old->RefCount >= 1);
-      old->RefCount--;
-      delete = (old->RefCount == 0);
-      mtx_unlock(&old->Mutex);
-
-      if (delete) {
+      assert(p_atomic_read(&old->RefCount) >= 1);
+      if (p_atomic_dec_zero(&old->RefCount)) {
          free_shared_state(ctx, old);
       }
 
@@ -414,9 +411,7 @@ _mesa_reference_shared_state(struct gl_context *ctx,
 
    if (state) {
       /* reference new state */
-      mtx_lock(&state->Mutex);
-      state->RefCount++;
+      p_atomic_inc(&state->RefCount);
       *ptr = state;
-      mtx_unlock(&state->Mutex);
    }
 }
@@ -0,0 +1,268 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (c) 2011 VMware, Inc.
+ * Copyright (c) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file sse_format_rows.c
+ *
+ * PSHUFB row kernels for the 8-bit formats that are plain byte
+ * permutations of RGBA, used as fast paths by the generated
+ * _mesa_pack_ubyte_rgba_row()/_mesa_unpack_ubyte_rgba_row(), plus a
+ * float-to-sRGB kernel for packing float spans to the 8888 sRGB
+ * formats.  Formats with X or implied-one channels and the plain
+ * byte-to-byte sRGB table conversions keep using the scalar loops --
+ * a PSHUFB-sliced 256-entry table gather was measured well behind the
+ * L1-resident scalar lookups.
+ */
+
+#include <string.h>
+#include <smmintrin.h>
+
+#include "main/format_utils.h"
+#include "main/sse_format_rows.h"
+#include "util/format_srgb.h"
+
+/**
+ * Write n 4-byte pixels where dest byte j of each pixel is source byte
+ * perm[j] of the same pixel.
+ */
+static void
+permute_bytes_row(const GLubyte *src, GLubyte *dst, GLuint n,
+                  const GLubyte perm[4])
+{
+   const __m128i shuf = _mm_setr_epi8(perm[0], perm[1], perm[2], perm[3],
+                                      perm[0] + 4, perm[1] + 4,
+                                      perm[2] + 4, perm[3] + 4,
+                                      perm[0] + 8, perm[1] + 8,
+                                      perm[2] + 8, perm[3] + 8,
+                                      perm[0] + 12, perm[1] + 12,
+                                      perm[2] + 12, perm[3] + 12);
+   GLuint i;
+
+   for (i = 0; i + 4 <= n; i += 4) {
+      const __m128i v = _mm_loadu_si128((const __m128i *) (src + i * 4));
+      _mm_storeu_si128((__m128i *) (dst + i * 4), _mm_shuffle_epi8(v, shuf));
+   }
+
+   for (; i < n; i++) {
+      dst[i * 4 + 0] = src[i * 4 + perm[0]];
+      dst[i * 4 + 1] = src[i * 4 + perm[1]];
+      dst[i * 4 + 2] = src[i * 4 + perm[2]];
+      dst[i * 4 + 3] = src[i * 4 + perm[3]];
+   }
+}
+
+
+/**
+ * Convert 4 unclamped linear float channel values to sRGB in [0,255],
+ * returned in the low byte of each 32-bit lane.  SSE version of
+ * util_format_linear_float_to_srgb_8unorm(); see the comments there.
+ */
+static __m128i
+linear_float_to_srgb_8unorm_x4(__m128 x)
+{
+   const __m128 minval = _mm_castsi128_ps(_mm_set1_epi32((127 - 13) << 23));
+   const __m128 almostone = _mm_castsi128_ps(_mm_set1_epi32(0x3f7fffff));
+   __m128i ui, tabidx, tab, bias, scale, t;
+
+   /* clamp to [2^(-13), 1-eps]; NaNs map to the low end as in the
+    * scalar code
+    */
+   x = _mm_blendv_ps(minval, x, _mm_cmpgt_ps(x, minval));
+   x = _mm_min_ps(x, almostone);
+
+   ui = _mm_castps_si128(x);
+   tabidx = _mm_srli_epi32(_mm_sub_epi32(ui, _mm_castps_si128(minval)), 20);
+
+   tab = _mm_setr_epi32(
+      util_format_linear_to_srgb_helper_table[_mm_extract_epi32(tabidx, 0)],
+      util_format_linear_to_srgb_helper_table[_mm_extract_epi32(tabidx, 1)],
+      util_format_linear_to_srgb_helper_table[_mm_extract_epi32(tabidx, 2)],
+      util_format_linear_to_srgb_helper_table[_mm_extract_epi32(tabidx, 3)]);
+
+   bias = _mm_slli_epi32(_mm_srli_epi32(tab, 16), 9);
+   scale = _mm_and_si128(tab, _mm_set1_epi32(0xffff));
+   t = _mm_and_si128(_mm_srli_epi32(ui, 12), _mm_set1_epi32(0xff));
+
+   return _mm_srli_epi32(_mm_add_epi32(bias, _mm_mullo_epi32(scale, t)), 16);
+}
+
+
+/**
+ * _mesa_float_to_unorm(x, 8) for 4 values at once.
+ */
+static __m128i
+float_to_unorm8_x4(__m128 x)
+{
+   x = _mm_max_ps(x, _mm_setzero_ps());
+   x = _mm_min_ps(x, _mm_set1_ps(1.0f));
+   /* cvtps rounds to nearest even, like _mesa_lroundevenf() */
+   return _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(255.0f)));
+}
+
+
+/**
+ * Pack n float RGBA pixels to an 8888 sRGB format; r/g/b get the
+ * linear-to-sRGB conversion, alpha a plain unorm8 conversion.
+ * 'shift' gives the bit position of each of r/g/b/a in a packed pixel,
+ * so the byte permutation folds into the recombining shifts.
+ *
+ * Works on 4 transposed pixels at a time, which needs one sRGB
+ * conversion per channel instead of one per pixel.
+ */
+static void
+pack_float_srgb_row(const GLfloat (*src)[4], GLubyte *dst, GLuint n,
+                    const GLubyte shift[4])
+{
+   GLuint i, j;
+
+   for (i = 0; i + 4 <= n; i += 4) {
+      __m128 r = _mm_loadu_ps(src[i + 0]);
+      __m128 g = _mm_loadu_ps(src[i + 1]);
+      __m128 b = _mm_loadu_ps(src[i + 2]);
+      __m128 a = _mm_loadu_ps(src[i + 3]);
+      __m128i v;
+
+      _MM_TRANSPOSE4_PS(r, g, b, a);
+
+      v = _mm_or_si128(
+             _mm_or_si128(
+                _mm_slli_epi32(linear_float_to_srgb_8unorm_x4(r), shift[0]),
+                _mm_slli_epi32(linear_float_to_srgb_8unorm_x4(g), shift[1])),
+             _mm_or_si128(
+                _mm_slli_epi32(linear_float_to_srgb_8unorm_x4(b), shift[2]),
+                _mm_slli_epi32(float_to_unorm8_x4(a), shift[3])));
+
+      _mm_storeu_si128((__m128i *) (dst + i * 4), v);
+   }
+
+   for (; i < n; i++) {
+      GLuint p =
+         (GLuint) util_format_linear_float_to_srgb_8unorm(src[i][0])
+            << shift[0] |
+         (GLuint) util_format_linear_float_to_srgb_8unorm(src[i][1])
+            << shift[1] |
+         (GLuint) util_format_linear_float_to_srgb_8unorm(src[i][2])
+            << shift[2] |
+         (GLuint) _mesa_float_to_unorm(src[i][3], 8) << shift[3];
+
+      for (j = 0; j < 4; j++)
+         dst[i * 4 + j] = (p >> (j * 8)) & 0xff;
+   }
+}
+
+
+/**
+ * Try to pack a row of ubyte RGBA pixels with a SSE kernel.
+ * \return GL_TRUE if the format was handled, GL_FALSE otherwise
+ */
+GLboolean
+_mesa_sse_pack_ubyte_rgba_row(mesa_format format, GLuint n,
+                              const GLubyte src[][4], GLubyte *dst)
+{
+   static const GLubyte rgba_to_bgra[4] = { 2, 1, 0, 3 };
+   static const GLubyte rgba_to_argb[4] = { 3, 0, 1, 2 };
+   static const GLubyte rgba_to_abgr[4] = { 3, 2, 1, 0 };
+
+   switch (format) {
+   case MESA_FORMAT_R8G8B8A8_UNORM:
+      memcpy(dst, src, n * 4);
+      return GL_TRUE;
+   case MESA_FORMAT_B8G8R8A8_UNORM:
+      permute_bytes_row((const GLubyte *) src, dst, n, rgba_to_bgra);
+      return GL_TRUE;
+   case MESA_FORMAT_A8R8G8B8_UNORM:
+      permute_bytes_row((const GLubyte *) src, dst, n, rgba_to_argb);
+      return GL_TRUE;
+   case MESA_FORMAT_A8B8G8R8_UNORM:
+      permute_bytes_row((const GLubyte *) src, dst, n, rgba_to_abgr);
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Try to pack a row of float RGBA pixels with a SSE kernel.
+ * \return GL_TRUE if the format was handled, GL_FALSE otherwise
+ */
+GLboolean
+_mesa_sse_pack_float_rgba_row(mesa_format format, GLuint n,
+                              const GLfloat src[][4], GLubyte *dst)
+{
+   /* bit positions of r/g/b/a within a packed pixel */
+   static const GLubyte rgba_shifts[4] = { 0, 8, 16, 24 };
+   static const GLubyte bgra_shifts[4] = { 16, 8, 0, 24 };
+   static const GLubyte argb_shifts[4] = { 8, 16, 24, 0 };
+   static const GLubyte abgr_shifts[4] = { 24, 16, 8, 0 };
+
+   switch (format) {
+   case MESA_FORMAT_R8G8B8A8_SRGB:
+      pack_float_srgb_row(src, dst, n, rgba_shifts);
+      return GL_TRUE;
+   case MESA_FORMAT_B8G8R8A8_SRGB:
+      pack_float_srgb_row(src, dst, n, bgra_shifts);
+      return GL_TRUE;
+   case MESA_FORMAT_A8R8G8B8_SRGB:
+      pack_float_srgb_row(src, dst, n, argb_shifts);
+      return GL_TRUE;
+   case MESA_FORMAT_A8B8G8R8_SRGB:
+      pack_float_srgb_row(src, dst, n, abgr_shifts);
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Try to unpack a row of pixels to ubyte RGBA with a SSE kernel.
+ * \return GL_TRUE if the format was handled, GL_FALSE otherwise
+ */
+GLboolean
+_mesa_sse_unpack_ubyte_rgba_row(mesa_format format, GLuint n,
+                                const GLubyte *src, GLubyte dst[][4])
+{
+   static const GLubyte bgra_to_rgba[4] = { 2, 1, 0, 3 };
+   static const GLubyte argb_to_rgba[4] = { 1, 2, 3, 0 };
+   static const GLubyte abgr_to_rgba[4] = { 3, 2, 1, 0 };
+
+   switch (format) {
+   case MESA_FORMAT_R8G8B8A8_UNORM:
+      memcpy(dst, src, n * 4);
+      return GL_TRUE;
+   case MESA_FORMAT_B8G8R8A8_UNORM:
+      permute_bytes_row(src, (GLubyte *) dst, n, bgra_to_rgba);
+      return GL_TRUE;
+   case MESA_FORMAT_A8R8G8B8_UNORM:
+      permute_bytes_row(src, (GLubyte *) dst, n, argb_to_rgba);
+      return GL_TRUE;
+   case MESA_FORMAT_A8B8G8R8_UNORM:
+      permute_bytes_row(src, (GLubyte *) dst, n, abgr_to_rgba);
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
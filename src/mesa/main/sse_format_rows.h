@@ -0,0 +1,49 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (c) 2011 VMware, Inc.
+ * Copyright (c) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file sse_format_rows.h
+ * SSE row kernels for the hot cases of the pack/unpack row functions.
+ */
+
+#ifndef SSE_FORMAT_ROWS_H
+#define SSE_FORMAT_ROWS_H
+
+#include "glheader.h"
+#include "formats.h"
+
+GLboolean
+_mesa_sse_pack_ubyte_rgba_row(mesa_format format, GLuint n,
+                              const GLubyte src[][4], GLubyte *dst);
+
+GLboolean
+_mesa_sse_pack_float_rgba_row(mesa_format format, GLuint n,
+                              const GLfloat src[][4], GLubyte *dst);
+
+GLboolean
+_mesa_sse_unpack_ubyte_rgba_row(mesa_format format, GLuint n,
+                                const GLubyte *src, GLubyte dst[][4]);
+
+#endif /* SSE_FORMAT_ROWS_H */
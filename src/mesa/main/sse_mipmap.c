@@ -0,0 +1,129 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 1999-2016  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file sse_mipmap.c
+ *
+ * SSE versions of the RGBA8888 2x2 (and 2x2x2) box filters from mipmap.c,
+ * for the case where the source row is twice as wide as the dest row.
+ * The results match the scalar filters in do_row()/do_row_3D() exactly.
+ */
+
+#include "main/sse_mipmap.h"
+#include <smmintrin.h>
+
+/**
+ * Average two source rows of 4-byte texels down to one dest row that is
+ * half as wide, i.e. dst[i] = (rowA[2*i] + rowA[2*i+1] + rowB[2*i]
+ * + rowB[2*i+1]) / 4 per component.
+ */
+void
+_mesa_sse_downsample_rgba8_row(const unsigned char *srcRowA,
+                               const unsigned char *srcRowB,
+                               unsigned dstWidth, unsigned char *dstRow)
+{
+   const __m128i zero = _mm_setzero_si128();
+   unsigned i;
+
+   /* do two dest pixels (four source pixels per row) at a time */
+   for (i = 0; i + 2 <= dstWidth; i += 2) {
+      __m128i a = _mm_loadu_si128((const __m128i *) (srcRowA + i * 8));
+      __m128i b = _mm_loadu_si128((const __m128i *) (srcRowB + i * 8));
+      /* widen to 16 bits and sum the rows; lo holds source pixels 0/1 of
+       * this group, hi holds source pixels 2/3
+       */
+      __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                 _mm_unpacklo_epi8(b, zero));
+      __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                 _mm_unpackhi_epi8(b, zero));
+      __m128i sum;
+      /* add each pair of adjacent source pixels together */
+      lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+      hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+      sum = _mm_srli_epi16(_mm_unpacklo_epi64(lo, hi), 2);
+      _mm_storel_epi64((__m128i *) (dstRow + i * 4),
+                       _mm_packus_epi16(sum, sum));
+   }
+
+   /* last dest pixel of an odd-width row */
+   for (; i < dstWidth; i++) {
+      const unsigned char *a = srcRowA + i * 8;
+      const unsigned char *b = srcRowB + i * 8;
+      unsigned char *d = dstRow + i * 4;
+      unsigned e;
+      for (e = 0; e < 4; e++)
+         d[e] = (a[e] + a[4 + e] + b[e] + b[4 + e]) / 4;
+   }
+}
+
+
+/**
+ * Like _mesa_sse_downsample_rgba8_row() but averaging four source rows,
+ * with the rounding used by FILTER_SUM_3D(): (sum of eight + 4) >> 3.
+ */
+void
+_mesa_sse_downsample_rgba8_row_3D(const unsigned char *srcRowA,
+                                  const unsigned char *srcRowB,
+                                  const unsigned char *srcRowC,
+                                  const unsigned char *srcRowD,
+                                  unsigned dstWidth, unsigned char *dstRow)
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i bias = _mm_set1_epi16(4);
+   unsigned i;
+
+   for (i = 0; i + 2 <= dstWidth; i += 2) {
+      __m128i a = _mm_loadu_si128((const __m128i *) (srcRowA + i * 8));
+      __m128i b = _mm_loadu_si128((const __m128i *) (srcRowB + i * 8));
+      __m128i c = _mm_loadu_si128((const __m128i *) (srcRowC + i * 8));
+      __m128i d = _mm_loadu_si128((const __m128i *) (srcRowD + i * 8));
+      __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                               _mm_unpacklo_epi8(b, zero)),
+                                 _mm_add_epi16(_mm_unpacklo_epi8(c, zero),
+                                               _mm_unpacklo_epi8(d, zero)));
+      __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                               _mm_unpackhi_epi8(b, zero)),
+                                 _mm_add_epi16(_mm_unpackhi_epi8(c, zero),
+                                               _mm_unpackhi_epi8(d, zero)));
+      __m128i sum;
+      lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+      hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+      sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), bias);
+      sum = _mm_srli_epi16(sum, 3);
+      _mm_storel_epi64((__m128i *) (dstRow + i * 4),
+                       _mm_packus_epi16(sum, sum));
+   }
+
+   for (; i < dstWidth; i++) {
+      const unsigned char *a = srcRowA + i * 8;
+      const unsigned char *b = srcRowB + i * 8;
+      const unsigned char *c = srcRowC + i * 8;
+      const unsigned char *d = srcRowD + i * 8;
+      unsigned char *dst = dstRow + i * 4;
+      unsigned e;
+      for (e = 0; e < 4; e++)
+         dst[e] = (a[e] + a[4 + e] + b[e] + b[4 + e]
+                   + c[e] + c[4 + e] + d[e] + d[4 + e] + 4) >> 3;
+   }
+}
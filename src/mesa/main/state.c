@@ -89,11 +89,17 @@ update_program_enables(struct gl_context *ctx)
  * This function needs to be called after texture state validation in case
  * we're generating a fragment program from fixed-function texture state.
  *
+ * \param vp_dirty  dirty state flags which affect the vertex program
+ * \param fp_dirty  dirty state flags which affect the fragment program
+ *
+ * Stages whose inputs aren't covered by the dirty flags keep their current
+ * program, so the cost of this function scales with what actually changed.
+ *
  * \return bitfield which will indicate _NEW_PROGRAM state if a new vertex
  * or fragment program is being used.
  */
 static GLbitfield
-update_program(struct gl_context *ctx)
+update_program(struct gl_context *ctx, GLbitfield vp_dirty, GLbitfield fp_dirty)
 {
    const struct gl_shader_program *vsProg =
       ctx->_Shader->CurrentProgram[MESA_SHADER_VERTEX];
@@ -132,126 +138,136 @@ update_program(struct gl_context *ctx)
     * come up, or matter.
     */
 
-   if (fsProg && fsProg->LinkStatus
-       && fsProg->_LinkedShaders[MESA_SHADER_FRAGMENT]) {
-      /* Use GLSL fragment shader */
-      _mesa_reference_shader_program(ctx,
-                                     &ctx->_Shader->_CurrentFragmentProgram,
-				     fsProg);
-      _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._Current,
-                               gl_fragment_program(fsProg->_LinkedShaders[MESA_SHADER_FRAGMENT]->Program));
-      _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._TexEnvProgram,
-			       NULL);
-   }
-   else if (ctx->FragmentProgram._Enabled) {
-      /* Use user-defined fragment program */
-      _mesa_reference_shader_program(ctx,
-                                     &ctx->_Shader->_CurrentFragmentProgram,
-				     NULL);
-      _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._Current,
-                               ctx->FragmentProgram.Current);
-      _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._TexEnvProgram,
-			       NULL);
-   }
-   else if (ctx->ATIFragmentShader._Enabled &&
-            ctx->ATIFragmentShader.Current->Program) {
-       /* Use the enabled ATI fragment shader's associated program */
-      _mesa_reference_shader_program(ctx,
-                                     &ctx->_Shader->_CurrentFragmentProgram,
-                                     NULL);
-      _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._Current,
-                               gl_fragment_program(ctx->ATIFragmentShader.Current->Program));
-      _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._TexEnvProgram,
-                               NULL);
-   }
-   else if (ctx->FragmentProgram._MaintainTexEnvProgram) {
-      /* Use fragment program generated from fixed-function state */
-      struct gl_shader_program *f = _mesa_get_fixed_func_fragment_program(ctx);
-
-      _mesa_reference_shader_program(ctx,
-                                     &ctx->_Shader->_CurrentFragmentProgram,
-				     f);
-      _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._Current,
-			       gl_fragment_program(f->_LinkedShaders[MESA_SHADER_FRAGMENT]->Program));
-      _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._TexEnvProgram,
-			       gl_fragment_program(f->_LinkedShaders[MESA_SHADER_FRAGMENT]->Program));
-   }
-   else {
-      /* No fragment program */
-      _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._Current, NULL);
-      _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._TexEnvProgram,
-			       NULL);
+   if (fp_dirty) {
+      if (fsProg && fsProg->LinkStatus
+          && fsProg->_LinkedShaders[MESA_SHADER_FRAGMENT]) {
+         /* Use GLSL fragment shader */
+         _mesa_reference_shader_program(ctx,
+                                        &ctx->_Shader->_CurrentFragmentProgram,
+                                        fsProg);
+         _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._Current,
+                                  gl_fragment_program(fsProg->_LinkedShaders[MESA_SHADER_FRAGMENT]->Program));
+         _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._TexEnvProgram,
+                                  NULL);
+      }
+      else if (ctx->FragmentProgram._Enabled) {
+         /* Use user-defined fragment program */
+         _mesa_reference_shader_program(ctx,
+                                        &ctx->_Shader->_CurrentFragmentProgram,
+                                        NULL);
+         _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._Current,
+                                  ctx->FragmentProgram.Current);
+         _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._TexEnvProgram,
+                                  NULL);
+      }
+      else if (ctx->ATIFragmentShader._Enabled &&
+               ctx->ATIFragmentShader.Current->Program) {
+         /* Use the enabled ATI fragment shader's associated program */
+         _mesa_reference_shader_program(ctx,
+                                        &ctx->_Shader->_CurrentFragmentProgram,
+                                        NULL);
+         _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._Current,
+                                  gl_fragment_program(ctx->ATIFragmentShader.Current->Program));
+         _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._TexEnvProgram,
+                                  NULL);
+      }
+      else if (ctx->FragmentProgram._MaintainTexEnvProgram) {
+         /* Use fragment program generated from fixed-function state */
+         struct gl_shader_program *f =
+            _mesa_get_fixed_func_fragment_program(ctx);
+
+         _mesa_reference_shader_program(ctx,
+                                        &ctx->_Shader->_CurrentFragmentProgram,
+                                        f);
+         _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._Current,
+                                  gl_fragment_program(f->_LinkedShaders[MESA_SHADER_FRAGMENT]->Program));
+         _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._TexEnvProgram,
+                                  gl_fragment_program(f->_LinkedShaders[MESA_SHADER_FRAGMENT]->Program));
+      }
+      else {
+         /* No fragment program */
+         _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._Current, NULL);
+         _mesa_reference_fragprog(ctx, &ctx->FragmentProgram._TexEnvProgram,
+                                  NULL);
+      }
    }
 
-   if (gsProg && gsProg->LinkStatus
-       && gsProg->_LinkedShaders[MESA_SHADER_GEOMETRY]) {
-      /* Use GLSL geometry shader */
-      _mesa_reference_geomprog(ctx, &ctx->GeometryProgram._Current,
-			       gl_geometry_program(gsProg->_LinkedShaders[MESA_SHADER_GEOMETRY]->Program));
-   } else {
-      /* No geometry program */
-      _mesa_reference_geomprog(ctx, &ctx->GeometryProgram._Current, NULL);
-   }
+   /* The geometry, tessellation and compute stages can only come from GLSL
+    * shaders, so they only depend on _NEW_PROGRAM.
+    */
+   if ((vp_dirty | fp_dirty) & _NEW_PROGRAM) {
+      if (gsProg && gsProg->LinkStatus
+          && gsProg->_LinkedShaders[MESA_SHADER_GEOMETRY]) {
+         /* Use GLSL geometry shader */
+         _mesa_reference_geomprog(ctx, &ctx->GeometryProgram._Current,
+                                  gl_geometry_program(gsProg->_LinkedShaders[MESA_SHADER_GEOMETRY]->Program));
+      } else {
+         /* No geometry program */
+         _mesa_reference_geomprog(ctx, &ctx->GeometryProgram._Current, NULL);
+      }
 
-   if (tesProg && tesProg->LinkStatus
-       && tesProg->_LinkedShaders[MESA_SHADER_TESS_EVAL]) {
-      /* Use GLSL tessellation evaluation shader */
-      _mesa_reference_tesseprog(ctx, &ctx->TessEvalProgram._Current,
-         gl_tess_eval_program(
-            tesProg->_LinkedShaders[MESA_SHADER_TESS_EVAL]->Program));
-   }
-   else {
-      /* No tessellation evaluation program */
-      _mesa_reference_tesseprog(ctx, &ctx->TessEvalProgram._Current, NULL);
-   }
+      if (tesProg && tesProg->LinkStatus
+          && tesProg->_LinkedShaders[MESA_SHADER_TESS_EVAL]) {
+         /* Use GLSL tessellation evaluation shader */
+         _mesa_reference_tesseprog(ctx, &ctx->TessEvalProgram._Current,
+            gl_tess_eval_program(
+               tesProg->_LinkedShaders[MESA_SHADER_TESS_EVAL]->Program));
+      }
+      else {
+         /* No tessellation evaluation program */
+         _mesa_reference_tesseprog(ctx, &ctx->TessEvalProgram._Current, NULL);
+      }
 
-   if (tcsProg && tcsProg->LinkStatus
-       && tcsProg->_LinkedShaders[MESA_SHADER_TESS_CTRL]) {
-      /* Use GLSL tessellation control shader */
-      _mesa_reference_tesscprog(ctx, &ctx->TessCtrlProgram._Current,
-         gl_tess_ctrl_program(
-            tcsProg->_LinkedShaders[MESA_SHADER_TESS_CTRL]->Program));
-   }
-   else {
-      /* No tessellation control program */
-      _mesa_reference_tesscprog(ctx, &ctx->TessCtrlProgram._Current, NULL);
+      if (tcsProg && tcsProg->LinkStatus
+          && tcsProg->_LinkedShaders[MESA_SHADER_TESS_CTRL]) {
+         /* Use GLSL tessellation control shader */
+         _mesa_reference_tesscprog(ctx, &ctx->TessCtrlProgram._Current,
+            gl_tess_ctrl_program(
+               tcsProg->_LinkedShaders[MESA_SHADER_TESS_CTRL]->Program));
+      }
+      else {
+         /* No tessellation control program */
+         _mesa_reference_tesscprog(ctx, &ctx->TessCtrlProgram._Current, NULL);
+      }
+
+      if (csProg && csProg->LinkStatus
+          && csProg->_LinkedShaders[MESA_SHADER_COMPUTE]) {
+         /* Use GLSL compute shader */
+         _mesa_reference_compprog(ctx, &ctx->ComputeProgram._Current,
+                                  gl_compute_program(csProg->_LinkedShaders[MESA_SHADER_COMPUTE]->Program));
+      } else {
+         /* no compute program */
+         _mesa_reference_compprog(ctx, &ctx->ComputeProgram._Current, NULL);
+      }
    }
 
    /* Examine vertex program after fragment program as
     * _mesa_get_fixed_func_vertex_program() needs to know active
     * fragprog inputs.
     */
-   if (vsProg && vsProg->LinkStatus
-       && vsProg->_LinkedShaders[MESA_SHADER_VERTEX]) {
-      /* Use GLSL vertex shader */
-      _mesa_reference_vertprog(ctx, &ctx->VertexProgram._Current,
-			       gl_vertex_program(vsProg->_LinkedShaders[MESA_SHADER_VERTEX]->Program));
-   }
-   else if (ctx->VertexProgram._Enabled) {
-      /* Use user-defined vertex program */
-      _mesa_reference_vertprog(ctx, &ctx->VertexProgram._Current,
-                               ctx->VertexProgram.Current);
-   }
-   else if (ctx->VertexProgram._MaintainTnlProgram) {
-      /* Use vertex program generated from fixed-function state */
-      _mesa_reference_vertprog(ctx, &ctx->VertexProgram._Current,
-                               _mesa_get_fixed_func_vertex_program(ctx));
-      _mesa_reference_vertprog(ctx, &ctx->VertexProgram._TnlProgram,
-                               ctx->VertexProgram._Current);
-   }
-   else {
-      /* no vertex program */
-      _mesa_reference_vertprog(ctx, &ctx->VertexProgram._Current, NULL);
-   }
-
-   if (csProg && csProg->LinkStatus
-       && csProg->_LinkedShaders[MESA_SHADER_COMPUTE]) {
-      /* Use GLSL compute shader */
-      _mesa_reference_compprog(ctx, &ctx->ComputeProgram._Current,
-                               gl_compute_program(csProg->_LinkedShaders[MESA_SHADER_COMPUTE]->Program));
-   } else {
-      /* no compute program */
-      _mesa_reference_compprog(ctx, &ctx->ComputeProgram._Current, NULL);
+   if (vp_dirty) {
+      if (vsProg && vsProg->LinkStatus
+          && vsProg->_LinkedShaders[MESA_SHADER_VERTEX]) {
+         /* Use GLSL vertex shader */
+         _mesa_reference_vertprog(ctx, &ctx->VertexProgram._Current,
+                                  gl_vertex_program(vsProg->_LinkedShaders[MESA_SHADER_VERTEX]->Program));
+      }
+      else if (ctx->VertexProgram._Enabled) {
+         /* Use user-defined vertex program */
+         _mesa_reference_vertprog(ctx, &ctx->VertexProgram._Current,
+                                  ctx->VertexProgram.Current);
+      }
+      else if (ctx->VertexProgram._MaintainTnlProgram) {
+         /* Use vertex program generated from fixed-function state */
+         _mesa_reference_vertprog(ctx, &ctx->VertexProgram._Current,
+                                  _mesa_get_fixed_func_vertex_program(ctx));
+         _mesa_reference_vertprog(ctx, &ctx->VertexProgram._TnlProgram,
+                                  ctx->VertexProgram._Current);
+      }
+      else {
+         /* no vertex program */
+         _mesa_reference_vertprog(ctx, &ctx->VertexProgram._Current, NULL);
+      }
    }
 
    /* Let the driver know what's happening:
@@ -387,9 +403,19 @@ void
 _mesa_update_state_locked( struct gl_context *ctx )
 {
    GLbitfield new_state = ctx->NewState;
-   GLbitfield prog_flags = _NEW_PROGRAM;
+   GLbitfield vp_flags = _NEW_PROGRAM;
+   GLbitfield fp_flags = _NEW_PROGRAM;
+   GLbitfield prog_flags;
    GLbitfield new_prog_state = 0x0;
-   const GLbitfield computed_states = ~(_NEW_CURRENT_ATTRIB | _NEW_LINE);
+   /* No core derived state depends on these flags; they are only of
+    * interest to the driver, which still sees them via Driver.UpdateState().
+    */
+   const GLbitfield computed_states = ~(_NEW_CURRENT_ATTRIB | _NEW_LINE |
+                                        _NEW_DEPTH | _NEW_EVAL | _NEW_HINT |
+                                        _NEW_POLYGONSTIPPLE |
+                                        _NEW_MULTISAMPLE | _NEW_TRACK_MATRIX |
+                                        _NEW_BUFFER_OBJECT |
+                                        _NEW_PROGRAM_CONSTANTS);
 
    /* we can skip a bunch of state validation checks if the dirty
     * state matches one or more bits in 'computed_states'.
@@ -402,17 +428,20 @@ _mesa_update_state_locked( struct gl_context *ctx )
 
    /* Determine which state flags effect vertex/fragment program state */
    if (ctx->FragmentProgram._MaintainTexEnvProgram) {
-      prog_flags |= (_NEW_BUFFERS | _NEW_TEXTURE | _NEW_FOG |
-		     _NEW_VARYING_VP_INPUTS | _NEW_LIGHT | _NEW_POINT |
-		     _NEW_RENDERMODE | _NEW_PROGRAM | _NEW_FRAG_CLAMP |
-		     _NEW_COLOR);
+      fp_flags |= (_NEW_BUFFERS | _NEW_TEXTURE | _NEW_FOG |
+		   _NEW_VARYING_VP_INPUTS | _NEW_LIGHT | _NEW_POINT |
+		   _NEW_RENDERMODE | _NEW_FRAG_CLAMP | _NEW_COLOR);
    }
    if (ctx->VertexProgram._MaintainTnlProgram) {
-      prog_flags |= (_NEW_VARYING_VP_INPUTS | _NEW_TEXTURE |
-                     _NEW_TEXTURE_MATRIX | _NEW_TRANSFORM | _NEW_POINT |
-                     _NEW_FOG | _NEW_LIGHT |
-                     _MESA_NEW_NEED_EYE_COORDS);
+      /* The fixed-function vertex program is generated against the inputs
+       * of the current fragment program, so it also depends on fp_flags.
+       */
+      vp_flags |= (_NEW_VARYING_VP_INPUTS | _NEW_TEXTURE |
+                   _NEW_TEXTURE_MATRIX | _NEW_TRANSFORM | _NEW_POINT |
+                   _NEW_FOG | _NEW_LIGHT |
+                   _MESA_NEW_NEED_EYE_COORDS) | fp_flags;
    }
+   prog_flags = vp_flags | fp_flags;
 
    /*
     * Now update derived state info
@@ -465,7 +494,8 @@ _mesa_update_state_locked( struct gl_context *ctx )
        * this call may generate/bind a new program.  If so, we need to
        * propogate the _NEW_PROGRAM flag to the driver.
        */
-      new_prog_state |= update_program( ctx );
+      new_prog_state |= update_program( ctx, new_state & vp_flags,
+                                        new_state & fp_flags );
    }
 
    if (new_state & _NEW_ARRAY)
@@ -179,7 +179,7 @@ struct gl_sync_object *
 _mesa_get_and_ref_sync(struct gl_context *ctx, GLsync sync, bool incRefCount)
 {
    struct gl_sync_object *syncObj = (struct gl_sync_object *) sync;
-   mtx_lock(&ctx->Shared->Mutex);
+   mtx_lock(&ctx->Shared->SyncMutex);
    if (syncObj != NULL
       && _mesa_set_search(ctx->Shared->SyncObjects, syncObj) != NULL
       && (syncObj->Type == GL_SYNC_FENCE)
@@ -190,7 +190,7 @@ _mesa_get_and_ref_sync(struct gl_context *ctx, GLsync sync, bool incRefCount)
    } else {
      syncObj = NULL;
    }
-   mtx_unlock(&ctx->Shared->Mutex);
+   mtx_unlock(&ctx->Shared->SyncMutex);
    return syncObj;
 }
 
@@ -201,17 +201,17 @@ _mesa_unref_sync_object(struct gl_context *ctx, struct gl_sync_object *syncObj,
 {
    struct set_entry *entry;
 
-   mtx_lock(&ctx->Shared->Mutex);
+   mtx_lock(&ctx->Shared->SyncMutex);
    syncObj->RefCount -= amount;
    if (syncObj->RefCount == 0) {
       entry = _mesa_set_search(ctx->Shared->SyncObjects, syncObj);
       assert (entry != NULL);
       _mesa_set_remove(ctx->Shared->SyncObjects, entry);
-      mtx_unlock(&ctx->Shared->Mutex);
+      mtx_unlock(&ctx->Shared->SyncMutex);
 
       ctx->Driver.DeleteSyncObject(ctx, syncObj);
    } else {
-      mtx_unlock(&ctx->Shared->Mutex);
+      mtx_unlock(&ctx->Shared->SyncMutex);
    }
 }
 
@@ -294,9 +294,9 @@ _mesa_FenceSync(GLenum condition, GLbitfield flags)
 
       ctx->Driver.FenceSync(ctx, syncObj, condition, flags);
 
-      mtx_lock(&ctx->Shared->Mutex);
+      mtx_lock(&ctx->Shared->SyncMutex);
       _mesa_set_add(ctx->Shared->SyncObjects, syncObj);
-      mtx_unlock(&ctx->Shared->Mutex);
+      mtx_unlock(&ctx->Shared->SyncMutex);
 
       return (GLsync) syncObj;
    }
@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file hash_mirror.cpp
+ *
+ * Differential test for the flat lookup mirror in main/hash.c.
+ *
+ * _mesa_HashLookup() answers from a lock-free flat array for names below
+ * 64k and only falls back to the mutex-protected hash table beyond it,
+ * so the mirror silently returning a stale pointer (or NULL for a live
+ * name) would look like GL object corruption, not a crash.  These tests
+ * drive random insert/remove/lookup traffic against a shadow array and
+ * check every answer, crossing the mirror's growth steps, its 64k upper
+ * bound, _mesa_HashDeleteAll() and table reuse.  Run them under the
+ * address sanitizer when touching hash.c; retired mirror incarnations
+ * are kept alive for lock-free readers and a use-after-free there won't
+ * fail functionally.
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+extern "C" {
+#include "main/hash.h"
+}
+
+/* Past FLAT_ARRAY_MAX_SIZE (64k) so lookups exercise both the mirror and
+ * the locked fallback path.
+ */
+#define KEY_RANGE (96 * 1024)
+
+static void *
+key_data(GLuint key)
+{
+   /* arbitrary non-NULL pointer pattern derived from the key */
+   return (void *)(uintptr_t)((key * 2654435761u) | 1);
+}
+
+TEST(HashMirrorTest, RandomDifferential)
+{
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   static void *shadow[KEY_RANGE];
+
+   ASSERT_TRUE(table != NULL);
+   memset(shadow, 0, sizeof(shadow));
+
+   srand(1);
+   for (unsigned op = 0; op < 200000; op++) {
+      GLuint key = 1 + rand() % (KEY_RANGE - 1);
+
+      switch (rand() % 3) {
+      case 0:
+         _mesa_HashInsert(table, key, key_data(key));
+         shadow[key] = key_data(key);
+         break;
+      case 1:
+         if (shadow[key]) {
+            _mesa_HashRemove(table, key);
+            shadow[key] = NULL;
+         }
+         break;
+      default:
+         ASSERT_EQ(shadow[key], _mesa_HashLookup(table, key));
+         break;
+      }
+   }
+
+   /* Final sweep: every key must agree, in particular every slot the
+    * mirror grew to cover along the way.
+    */
+   for (GLuint key = 1; key < KEY_RANGE; key++)
+      ASSERT_EQ(shadow[key], _mesa_HashLookup(table, key));
+
+   for (GLuint key = 1; key < KEY_RANGE; key++) {
+      if (shadow[key])
+         _mesa_HashRemove(table, key);
+   }
+   _mesa_DeleteHashTable(table);
+}
+
+TEST(HashMirrorTest, GrowthAndBoundary)
+{
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+
+   ASSERT_TRUE(table != NULL);
+
+   /* Consecutive glGen*()-style names walk the mirror through every
+    * doubling up to its cap and across the 64k fallback boundary.
+    */
+   for (GLuint key = 1; key < KEY_RANGE; key++) {
+      _mesa_HashInsert(table, key, key_data(key));
+      ASSERT_EQ(key_data(key), _mesa_HashLookup(table, key));
+      /* the previous key must still be visible through the new mirror */
+      if (key > 1)
+         ASSERT_EQ(key_data(key - 1), _mesa_HashLookup(table, key - 1));
+   }
+
+   ASSERT_EQ(KEY_RANGE - 1, _mesa_HashNumEntries(table));
+
+   for (GLuint key = 1; key < KEY_RANGE; key++)
+      _mesa_HashRemove(table, key);
+   _mesa_DeleteHashTable(table);
+}
+
+static void
+count_entry(GLuint key, void *data, void *userData)
+{
+   (void) key;
+   (void) data;
+   ++*(unsigned *) userData;
+}
+
+TEST(HashMirrorTest, DeleteAllAndReuse)
+{
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   unsigned count = 0;
+
+   ASSERT_TRUE(table != NULL);
+
+   for (GLuint key = 1; key <= 10000; key++)
+      _mesa_HashInsert(table, key, key_data(key));
+
+   _mesa_HashDeleteAll(table, count_entry, &count);
+   ASSERT_EQ(10000u, count);
+
+   /* the mirror must have been wiped along with the table */
+   for (GLuint key = 1; key <= 10000; key++)
+      ASSERT_TRUE(_mesa_HashLookup(table, key) == NULL);
+
+   /* reuse after DeleteAll, including the magic deleted-key name 1 */
+   for (GLuint key = 1; key <= 100; key++)
+      _mesa_HashInsert(table, key, key_data(key + 7));
+   for (GLuint key = 1; key <= 100; key++)
+      ASSERT_EQ(key_data(key + 7), _mesa_HashLookup(table, key));
+
+   for (GLuint key = 1; key <= 100; key++)
+      _mesa_HashRemove(table, key);
+   _mesa_DeleteHashTable(table);
+}
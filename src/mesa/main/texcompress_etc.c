@@ -40,6 +40,7 @@
 #include <stdbool.h>
 #include "texcompress.h"
 #include "texcompress_etc.h"
+#include "texcompress_s3tc.h"
 #include "texstore.h"
 #include "macros.h"
 #include "format_unpack.h"
@@ -665,6 +666,201 @@ etc2_rgba8_fetch_texel(const struct etc2_block *block,
    etc2_alpha8_fetch_texel(block, x, y, dst);
 }
 
+/* The per-texel fetch functions above re-test the block mode and re-derive
+ * the texel color for every single texel, which is what dominates whole
+ * texture decompression of ETC2 content on hardware without native support.
+ * A block can only ever produce a handful of distinct colors (four per
+ * subblock for the palette modes, eight alpha/R11 codewords), so the
+ * decoders below expand those into a small palette once per block and then
+ * just index it, with the planar gradient evaluated incrementally.  They
+ * write a full 4x4 block; the unpack loops fall back to the texel fetches
+ * for the partial blocks at the texture edges.
+ */
+
+static void
+etc2_rgb8_decode_block(const struct etc2_block *block,
+                       GLboolean punchthrough_alpha,
+                       GLboolean bgra,
+                       uint8_t *dst_row,
+                       unsigned dst_stride)
+{
+   const int rc = bgra ? 2 : 0;
+   const int bc = bgra ? 0 : 2;
+   uint8_t palette[8][4];
+   int x, y, i;
+
+   if (block->is_planar_mode) {
+      /* Walk the gradient one horizontal/vertical step at a time instead of
+       * re-evaluating the plane equation per texel.
+       */
+      const int hr = block->base_colors[1][0] - block->base_colors[0][0];
+      const int hg = block->base_colors[1][1] - block->base_colors[0][1];
+      const int hb = block->base_colors[1][2] - block->base_colors[0][2];
+      const int vr = block->base_colors[2][0] - block->base_colors[0][0];
+      const int vg = block->base_colors[2][1] - block->base_colors[0][1];
+      const int vb = block->base_colors[2][2] - block->base_colors[0][2];
+
+      for (y = 0; y < 4; y++) {
+         uint8_t *dst = dst_row + y * dst_stride;
+         int red = y * vr + 4 * block->base_colors[0][0] + 2;
+         int green = y * vg + 4 * block->base_colors[0][1] + 2;
+         int blue = y * vb + 4 * block->base_colors[0][2] + 2;
+
+         for (x = 0; x < 4; x++) {
+            dst[rc] = etc2_clamp(red >> 2);
+            dst[1] = etc2_clamp(green >> 2);
+            dst[bc] = etc2_clamp(blue >> 2);
+            dst[3] = 255;
+            red += hr;
+            green += hg;
+            blue += hb;
+            dst += 4;
+         }
+      }
+      return;
+   }
+
+   if (block->is_t_mode || block->is_h_mode) {
+      for (i = 0; i < 4; i++) {
+         palette[i][rc] = block->paint_colors[i][0];
+         palette[i][1] = block->paint_colors[i][1];
+         palette[i][bc] = block->paint_colors[i][2];
+         palette[i][3] = 255;
+      }
+   }
+   else {
+      /* individual/differential mode: a four color palette per subblock */
+      int blk;
+      for (blk = 0; blk < 2; blk++) {
+         for (i = 0; i < 4; i++) {
+            const int modifier = block->modifier_tables[blk][i];
+            uint8_t *col = palette[blk * 4 + i];
+            col[rc] = etc2_clamp(block->base_colors[blk][0] + modifier);
+            col[1] = etc2_clamp(block->base_colors[blk][1] + modifier);
+            col[bc] = etc2_clamp(block->base_colors[blk][2] + modifier);
+            col[3] = 255;
+         }
+      }
+   }
+
+   if (punchthrough_alpha && !block->opaque) {
+      /* pixel index 2 decodes to transparent black */
+      memset(palette[2], 0, 4);
+      memset(palette[6], 0, 4);
+   }
+
+   for (y = 0; y < 4; y++) {
+      uint8_t *dst = dst_row + y * dst_stride;
+      for (x = 0; x < 4; x++) {
+         const int bit = y + x * 4;
+         int idx = ((block->pixel_indices[0] >> (15 + bit)) & 0x2) |
+                   ((block->pixel_indices[0] >>      (bit)) & 0x1);
+
+         if ((block->is_ind_mode || block->is_diff_mode) &&
+             (block->flipped ? y >= 2 : x >= 2))
+            idx += 4;
+
+         memcpy(dst, palette[idx], 4);
+         dst += 4;
+      }
+   }
+}
+
+static void
+etc2_alpha8_decode_block(const struct etc2_block *block,
+                         uint8_t *dst_row,
+                         unsigned dst_stride)
+{
+   uint8_t palette[8];
+   int x, y, i;
+
+   for (i = 0; i < 8; i++)
+      palette[i] = etc2_clamp(block->base_codeword +
+                              etc2_modifier_tables[block->table_index][i] *
+                              block->multiplier);
+
+   for (y = 0; y < 4; y++) {
+      uint8_t *dst = dst_row + y * dst_stride;
+      for (x = 0; x < 4; x++) {
+         dst[3] = palette[etc2_get_pixel_index(block, x, y)];
+         dst += 4;
+      }
+   }
+}
+
+static void
+etc2_r11_decode_block(const struct etc2_block *block,
+                      uint8_t *dst_row,
+                      unsigned dst_stride,
+                      unsigned pixel_size)
+{
+   GLushort palette[8];
+   int x, y, i;
+
+   for (i = 0; i < 8; i++) {
+      const int modifier = etc2_modifier_tables[block->table_index][i];
+      GLushort color;
+
+      if (block->multiplier != 0)
+         color = etc2_clamp2(((block->base_codeword << 3) | 0x4) +
+                             ((modifier * block->multiplier) << 3));
+      else
+         color = etc2_clamp2(((block->base_codeword << 3) | 0x4) + modifier);
+
+      palette[i] = (color << 5) | (color >> 6);
+   }
+
+   for (y = 0; y < 4; y++) {
+      uint8_t *dst = dst_row + y * dst_stride;
+      for (x = 0; x < 4; x++) {
+         ((GLushort *)dst)[0] = palette[etc2_get_pixel_index(block, x, y)];
+         dst += pixel_size;
+      }
+   }
+}
+
+static void
+etc2_signed_r11_decode_block(const struct etc2_block *block,
+                             uint8_t *dst_row,
+                             unsigned dst_stride,
+                             unsigned pixel_size)
+{
+   GLbyte base_codeword = (GLbyte) block->base_codeword;
+   GLshort palette[8];
+   int x, y, i;
+
+   if (base_codeword == -128)
+      base_codeword = -127;
+
+   for (i = 0; i < 8; i++) {
+      const int modifier = etc2_modifier_tables[block->table_index][i];
+      GLshort color;
+
+      if (block->multiplier != 0)
+         color = etc2_clamp3((base_codeword << 3) +
+                             ((modifier * block->multiplier) << 3));
+      else
+         color = etc2_clamp3((base_codeword << 3) + modifier);
+
+      if (color >= 0)
+         color = (color << 5) | (color >> 5);
+      else {
+         color = -color;
+         color = (color << 5) | (color >> 5);
+         color = -color;
+      }
+      palette[i] = color;
+   }
+
+   for (y = 0; y < 4; y++) {
+      uint8_t *dst = dst_row + y * dst_stride;
+      for (x = 0; x < 4; x++) {
+         ((GLshort *)dst)[0] = palette[etc2_get_pixel_index(block, x, y)];
+         dst += pixel_size;
+      }
+   }
+}
+
 static void
 etc2_unpack_rgb8(uint8_t *dst_row,
                  unsigned dst_stride,
@@ -695,13 +891,22 @@ etc2_unpack_rgb8(uint8_t *dst_row,
          etc2_rgb8_parse_block(&block, src,
                                false /* punchthrough_alpha */);
 
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     false /* punchthrough_alpha */);
-               dst[3] = 255;
-               dst += comps;
+         if (w == bw && h == bh) {
+            etc2_rgb8_decode_block(&block,
+                                   false /* punchthrough_alpha */,
+                                   false /* bgra */,
+                                   dst_row + y * dst_stride + x * comps,
+                                   dst_stride);
+         }
+         else {
+            for (j = 0; j < h; j++) {
+               uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
+               for (i = 0; i < w; i++) {
+                  etc2_rgb8_fetch_texel(&block, i, j, dst,
+                                        false /* punchthrough_alpha */);
+                  dst[3] = 255;
+                  dst += comps;
+               }
             }
          }
 
@@ -734,19 +939,28 @@ etc2_unpack_srgb8(uint8_t *dst_row,
          etc2_rgb8_parse_block(&block, src,
                                false /* punchthrough_alpha */);
 
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     false /* punchthrough_alpha */);
-               /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = 255;
-
-               dst += comps;
+         if (w == bw && h == bh) {
+            /* decode straight to MESA_FORMAT_B8G8R8A8_SRGB */
+            etc2_rgb8_decode_block(&block,
+                                   false /* punchthrough_alpha */,
+                                   true /* bgra */,
+                                   dst_row + y * dst_stride + x * comps,
+                                   dst_stride);
+         }
+         else {
+            for (j = 0; j < h; j++) {
+               uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
+               for (i = 0; i < w; i++) {
+                  etc2_rgb8_fetch_texel(&block, i, j, dst,
+                                        false /* punchthrough_alpha */);
+                  /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
+                  tmp = dst[0];
+                  dst[0] = dst[2];
+                  dst[2] = tmp;
+                  dst[3] = 255;
+
+                  dst += comps;
+               }
             }
          }
          src += bs;
@@ -780,11 +994,21 @@ etc2_unpack_rgba8(uint8_t *dst_row,
          const unsigned w = MIN2(bw, width - x);
          etc2_rgba8_parse_block(&block, src);
 
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgba8_fetch_texel(&block, i, j, dst);
-               dst += comps;
+         if (w == bw && h == bh) {
+            uint8_t *dst = dst_row + y * dst_stride + x * comps;
+            etc2_rgb8_decode_block(&block,
+                                   false /* punchthrough_alpha */,
+                                   false /* bgra */,
+                                   dst, dst_stride);
+            etc2_alpha8_decode_block(&block, dst, dst_stride);
+         }
+         else {
+            for (j = 0; j < h; j++) {
+               uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
+               for (i = 0; i < w; i++) {
+                  etc2_rgba8_fetch_texel(&block, i, j, dst);
+                  dst += comps;
+               }
             }
          }
          src += bs;
@@ -819,18 +1043,29 @@ etc2_unpack_srgb8_alpha8(uint8_t *dst_row,
          const unsigned w = MIN2(bw, width - x);
          etc2_rgba8_parse_block(&block, src);
 
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgba8_fetch_texel(&block, i, j, dst);
-
-               /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = dst[3];
-
-               dst += comps;
+         if (w == bw && h == bh) {
+            /* decode straight to MESA_FORMAT_B8G8R8A8_SRGB */
+            uint8_t *dst = dst_row + y * dst_stride + x * comps;
+            etc2_rgb8_decode_block(&block,
+                                   false /* punchthrough_alpha */,
+                                   true /* bgra */,
+                                   dst, dst_stride);
+            etc2_alpha8_decode_block(&block, dst, dst_stride);
+         }
+         else {
+            for (j = 0; j < h; j++) {
+               uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
+               for (i = 0; i < w; i++) {
+                  etc2_rgba8_fetch_texel(&block, i, j, dst);
+
+                  /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
+                  tmp = dst[0];
+                  dst[0] = dst[2];
+                  dst[2] = tmp;
+                  dst[3] = dst[3];
+
+                  dst += comps;
+               }
             }
          }
          src += bs;
@@ -863,11 +1098,20 @@ etc2_unpack_r11(uint8_t *dst_row,
          const unsigned w = MIN2(bw, width - x);
          etc2_r11_parse_block(&block, src);
 
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
+         if (w == bw && h == bh) {
+            etc2_r11_decode_block(&block,
+                                  dst_row + y * dst_stride +
+                                  x * comps * comp_size,
+                                  dst_stride, comps * comp_size);
+         }
+         else {
+            for (j = 0; j < h; j++) {
+               uint8_t *dst = dst_row + (y + j) * dst_stride +
+                              x * comps * comp_size;
+               for (i = 0; i < w; i++) {
+                  etc2_r11_fetch_texel(&block, i, j, dst);
+                  dst += comps * comp_size;
+               }
             }
          }
          src += bs;
@@ -898,6 +1142,21 @@ etc2_unpack_rg11(uint8_t *dst_row,
 
       for (x = 0; x < width; x+= bw) {
          const unsigned w = MIN2(bw, width - x);
+         if (w == bw && h == bh) {
+            uint8_t *dst = dst_row + y * dst_stride + x * comps * comp_size;
+
+            /* red component */
+            etc2_r11_parse_block(&block, src);
+            etc2_r11_decode_block(&block, dst, dst_stride,
+                                  comps * comp_size);
+            /* green component */
+            etc2_r11_parse_block(&block, src + 8);
+            etc2_r11_decode_block(&block, dst + comp_size, dst_stride,
+                                  comps * comp_size);
+            src += bs;
+            continue;
+         }
+
          /* red component */
          etc2_r11_parse_block(&block, src);
 
@@ -950,12 +1209,20 @@ etc2_unpack_signed_r11(uint8_t *dst_row,
          const unsigned w = MIN2(bw, width - x);
          etc2_r11_parse_block(&block, src);
 
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_signed_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
+         if (w == bw && h == bh) {
+            etc2_signed_r11_decode_block(&block,
+                                         dst_row + y * dst_stride +
+                                         x * comps * comp_size,
+                                         dst_stride, comps * comp_size);
+         }
+         else {
+            for (j = 0; j < h; j++) {
+               uint8_t *dst = dst_row + (y + j) * dst_stride +
+                              x * comps * comp_size;
+               for (i = 0; i < w; i++) {
+                  etc2_signed_r11_fetch_texel(&block, i, j, dst);
+                  dst += comps * comp_size;
+               }
             }
          }
          src += bs;
@@ -986,6 +1253,21 @@ etc2_unpack_signed_rg11(uint8_t *dst_row,
 
       for (x = 0; x < width; x+= bw) {
          const unsigned w = MIN2(bw, width - x);
+         if (w == bw && h == bh) {
+            uint8_t *dst = dst_row + y * dst_stride + x * comps * comp_size;
+
+            /* red component */
+            etc2_r11_parse_block(&block, src);
+            etc2_signed_r11_decode_block(&block, dst, dst_stride,
+                                         comps * comp_size);
+            /* green component */
+            etc2_r11_parse_block(&block, src + 8);
+            etc2_signed_r11_decode_block(&block, dst + comp_size, dst_stride,
+                                         comps * comp_size);
+            src += bs;
+            continue;
+         }
+
          /* red component */
          etc2_r11_parse_block(&block, src);
 
@@ -1035,12 +1317,22 @@ etc2_unpack_rgb8_punchthrough_alpha1(uint8_t *dst_row,
          const unsigned w = MIN2(bw, width - x);
          etc2_rgb8_parse_block(&block, src,
                                true /* punchthrough_alpha */);
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     true /* punchthrough_alpha */);
-               dst += comps;
+
+         if (w == bw && h == bh) {
+            etc2_rgb8_decode_block(&block,
+                                   true /* punchthrough_alpha */,
+                                   false /* bgra */,
+                                   dst_row + y * dst_stride + x * comps,
+                                   dst_stride);
+         }
+         else {
+            for (j = 0; j < h; j++) {
+               uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
+               for (i = 0; i < w; i++) {
+                  etc2_rgb8_fetch_texel(&block, i, j, dst,
+                                        true /* punchthrough_alpha */);
+                  dst += comps;
+               }
             }
          }
 
@@ -1072,18 +1364,29 @@ etc2_unpack_srgb8_punchthrough_alpha1(uint8_t *dst_row,
          const unsigned w = MIN2(bw, width - x);
          etc2_rgb8_parse_block(&block, src,
                                true /* punchthrough_alpha */);
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     true /* punchthrough_alpha */);
-               /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = dst[3];
-
-               dst += comps;
+
+         if (w == bw && h == bh) {
+            /* decode straight to MESA_FORMAT_B8G8R8A8_SRGB */
+            etc2_rgb8_decode_block(&block,
+                                   true /* punchthrough_alpha */,
+                                   true /* bgra */,
+                                   dst_row + y * dst_stride + x * comps,
+                                   dst_stride);
+         }
+         else {
+            for (j = 0; j < h; j++) {
+               uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
+               for (i = 0; i < w; i++) {
+                  etc2_rgb8_fetch_texel(&block, i, j, dst,
+                                        true /* punchthrough_alpha */);
+                  /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
+                  tmp = dst[0];
+                  dst[0] = dst[2];
+                  dst[2] = tmp;
+                  dst[3] = dst[3];
+
+                  dst += comps;
+               }
             }
          }
 
@@ -1250,6 +1553,85 @@ _mesa_unpack_etc2_format(uint8_t *dst_row,
 }
 
 
+/**
+ * Transcode ETC2 texture data to DXT1/DXT5 so that hardware without
+ * native ETC2 support can keep a compressed representation in memory
+ * instead of expanding to RGBA8888.  The block footprints match (8
+ * bytes for RGB8 and punchthrough, 16 bytes for RGBA8), so the
+ * destination image is laid out exactly like the source.  Transcoding
+ * is lossy -- each block is decoded and re-fit to DXT endpoints --
+ * which is the usual tradeoff against a 4x memory and bandwidth
+ * expansion.  The R11/RG11 formats have no S3TC equivalent and must
+ * not be passed here.
+ *
+ * \param src_width in pixels
+ * \param src_height in pixels
+ * \param dst_stride in bytes per row of blocks
+ */
+void
+_mesa_transcode_etc2_to_dxt(uint8_t *dst_row,
+                            unsigned dst_stride,
+                            const uint8_t *src_row,
+                            unsigned src_stride,
+                            unsigned src_width,
+                            unsigned src_height,
+                            mesa_format format)
+{
+   /* Decode and re-encode a strip of blocks at a time through a small
+    * buffer so the intermediate pixels stay in cache.
+    */
+   const unsigned tile = 64;
+   mesa_format decode_format;
+   GLenum dxt_format;
+   unsigned bs;
+   uint8_t rgba[4 * 64 * 4];
+   unsigned x, y;
+
+   switch (format) {
+   case MESA_FORMAT_ETC2_RGB8:
+   case MESA_FORMAT_ETC2_SRGB8:
+      /* The color space doesn't matter for re-fitting the endpoints;
+       * decode the raw values in RGBA order.
+       */
+      decode_format = MESA_FORMAT_ETC2_RGB8;
+      dxt_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      bs = 8;
+      break;
+   case MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1:
+   case MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1:
+      decode_format = MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1;
+      dxt_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+      bs = 8;
+      break;
+   case MESA_FORMAT_ETC2_RGBA8_EAC:
+   case MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC:
+      decode_format = MESA_FORMAT_ETC2_RGBA8_EAC;
+      dxt_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      bs = 16;
+      break;
+   default:
+      unreachable("unexpected format in _mesa_transcode_etc2_to_dxt");
+   }
+
+   for (y = 0; y < src_height; y += 4) {
+      const unsigned h = MIN2(4, src_height - y);
+
+      for (x = 0; x < src_width; x += tile) {
+         const unsigned w = MIN2(tile, src_width - x);
+
+         _mesa_unpack_etc2_format(rgba, w * 4,
+                                  src_row + (y / 4) * src_stride +
+                                  (x / 4) * bs,
+                                  src_stride, w, h, decode_format);
+         _mesa_tx_compress_dxtn(4, w, h, rgba, dxt_format,
+                                dst_row + (y / 4) * dst_stride +
+                                (x / 4) * bs,
+                                dst_stride);
+      }
+   }
+}
+
+
 
 static void
 fetch_etc1_rgb8(const GLubyte *map,
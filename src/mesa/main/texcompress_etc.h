@@ -79,6 +79,15 @@ _mesa_unpack_etc2_format(uint8_t *dst_row,
                          unsigned src_height,
                          mesa_format format);
 
+void
+_mesa_transcode_etc2_to_dxt(uint8_t *dst_row,
+                            unsigned dst_stride,
+                            const uint8_t *src_row,
+                            unsigned src_stride,
+                            unsigned src_width,
+                            unsigned src_height,
+                            mesa_format format);
+
 compressed_fetch_func
 _mesa_get_etc_fetch_func(mesa_format format);
 
@@ -43,45 +43,11 @@
 #include "texcompress_rgtc.h"
 #include "texstore.h"
 
-static void extractsrc_u( GLubyte srcpixels[4][4], const GLubyte *srcaddr,
-			  GLint srcRowStride, GLint numxpixels, GLint numypixels, GLint comps)
-{
-   GLubyte i, j;
-   const GLubyte *curaddr;
-   for (j = 0; j < numypixels; j++) {
-      curaddr = srcaddr + j * srcRowStride * comps;
-      for (i = 0; i < numxpixels; i++) {
-	 srcpixels[j][i] = *curaddr;
-	 curaddr += comps;
-      }
-   }
-}
-
-static void extractsrc_s( GLbyte srcpixels[4][4], const GLfloat *srcaddr,
-			  GLint srcRowStride, GLint numxpixels, GLint numypixels, GLint comps)
-{
-   GLubyte i, j;
-   const GLfloat *curaddr;
-   for (j = 0; j < numypixels; j++) {
-      curaddr = srcaddr + j * srcRowStride * comps;
-      for (i = 0; i < numxpixels; i++) {
-	 srcpixels[j][i] = FLOAT_TO_BYTE_TEX(*curaddr);
-	 curaddr += comps;
-      }
-   }
-}
-
-
 GLboolean
 _mesa_texstore_red_rgtc1(TEXSTORE_PARAMS)
 {
    GLubyte *dst;
    const GLubyte *tempImage = NULL;
-   int i, j;
-   int numxpixels, numypixels;
-   const GLubyte *srcaddr;
-   GLubyte srcpixels[4][4];
-   GLubyte *blkaddr;
    GLint dstRowDiff, redRowStride;
    GLubyte *tempImageSlices[1];
 
@@ -103,22 +69,11 @@ _mesa_texstore_red_rgtc1(TEXSTORE_PARAMS)
 
    dst = dstSlices[0];
 
-   blkaddr = dst;
    dstRowDiff = dstRowStride >= (srcWidth * 2) ? dstRowStride - (((srcWidth + 3) & ~3) * 2) : 0;
-   for (j = 0; j < srcHeight; j+=4) {
-      if (srcHeight > j + 3) numypixels = 4;
-      else numypixels = srcHeight - j;
-      srcaddr = tempImage + j * srcWidth;
-      for (i = 0; i < srcWidth; i += 4) {
-	 if (srcWidth > i + 3) numxpixels = 4;
-	 else numxpixels = srcWidth - i;
-	 extractsrc_u(srcpixels, srcaddr, srcWidth, numxpixels, numypixels, 1);
-	 util_format_unsigned_encode_rgtc_ubyte(blkaddr, srcpixels, numxpixels, numypixels);
-	 srcaddr += numxpixels;
-	 blkaddr += 8;
-      }
-      blkaddr += dstRowDiff;
-   }
+   util_format_unsigned_compress_rgtc_ubyte(dst,
+                                            ((srcWidth + 3) & ~3) * 2 + dstRowDiff, 8,
+                                            tempImage, srcWidth,
+                                            srcWidth, srcHeight, 1);
 
    free((void *) tempImage);
 
@@ -130,11 +85,8 @@ _mesa_texstore_signed_red_rgtc1(TEXSTORE_PARAMS)
 {
    GLbyte *dst;
    const GLfloat *tempImage = NULL;
-   int i, j;
-   int numxpixels, numypixels;
-   const GLfloat *srcaddr;
-   GLbyte srcpixels[4][4];
-   GLbyte *blkaddr;
+   GLbyte *tempByteImage;
+   int i;
    GLint dstRowDiff, redRowStride;
    GLfloat *tempImageSlices[1];
 
@@ -154,25 +106,23 @@ _mesa_texstore_signed_red_rgtc1(TEXSTORE_PARAMS)
                   srcFormat, srcType, srcAddr,
                   srcPacking);
 
+   tempByteImage = malloc(srcWidth * srcHeight * sizeof(GLbyte));
+   if (!tempByteImage) {
+      free((void *) tempImage);
+      return GL_FALSE; /* out of memory */
+   }
+   for (i = 0; i < srcWidth * srcHeight; i++)
+      tempByteImage[i] = FLOAT_TO_BYTE_TEX(tempImage[i]);
+
    dst = (GLbyte *) dstSlices[0];
 
-   blkaddr = dst;
    dstRowDiff = dstRowStride >= (srcWidth * 2) ? dstRowStride - (((srcWidth + 3) & ~3) * 2) : 0;
-   for (j = 0; j < srcHeight; j+=4) {
-      if (srcHeight > j + 3) numypixels = 4;
-      else numypixels = srcHeight - j;
-      srcaddr = tempImage + j * srcWidth;
-      for (i = 0; i < srcWidth; i += 4) {
-	 if (srcWidth > i + 3) numxpixels = 4;
-	 else numxpixels = srcWidth - i;
-	 extractsrc_s(srcpixels, srcaddr, srcWidth, numxpixels, numypixels, 1);
-	 util_format_signed_encode_rgtc_ubyte(blkaddr, srcpixels, numxpixels, numypixels);
-	 srcaddr += numxpixels;
-	 blkaddr += 8;
-      }
-      blkaddr += dstRowDiff;
-   }
+   util_format_signed_compress_rgtc_ubyte(dst,
+                                          ((srcWidth + 3) & ~3) * 2 + dstRowDiff, 8,
+                                          tempByteImage, srcWidth,
+                                          srcWidth, srcHeight, 1);
 
+   free(tempByteImage);
    free((void *) tempImage);
 
    return GL_TRUE;
@@ -183,11 +133,6 @@ _mesa_texstore_rg_rgtc2(TEXSTORE_PARAMS)
 {
    GLubyte *dst;
    const GLubyte *tempImage = NULL;
-   int i, j;
-   int numxpixels, numypixels;
-   const GLubyte *srcaddr;
-   GLubyte srcpixels[4][4];
-   GLubyte *blkaddr;
    GLint dstRowDiff, rgRowStride;
    mesa_format tempFormat;
    GLubyte *tempImageSlices[1];
@@ -217,28 +162,15 @@ _mesa_texstore_rg_rgtc2(TEXSTORE_PARAMS)
 
    dst = dstSlices[0];
 
-   blkaddr = dst;
    dstRowDiff = dstRowStride >= (srcWidth * 4) ? dstRowStride - (((srcWidth + 3) & ~3) * 4) : 0;
-   for (j = 0; j < srcHeight; j+=4) {
-      if (srcHeight > j + 3) numypixels = 4;
-      else numypixels = srcHeight - j;
-      srcaddr = tempImage + j * srcWidth * 2;
-      for (i = 0; i < srcWidth; i += 4) {
-	 if (srcWidth > i + 3) numxpixels = 4;
-	 else numxpixels = srcWidth - i;
-	 extractsrc_u(srcpixels, srcaddr, srcWidth, numxpixels, numypixels, 2);
-	 util_format_unsigned_encode_rgtc_ubyte(blkaddr, srcpixels, numxpixels, numypixels);
-
-	 blkaddr += 8;
-	 extractsrc_u(srcpixels, (GLubyte *)srcaddr + 1, srcWidth, numxpixels, numypixels, 2);
-	 util_format_unsigned_encode_rgtc_ubyte(blkaddr, srcpixels, numxpixels, numypixels);
-
-	 blkaddr += 8;
-
-	 srcaddr += numxpixels * 2;
-      }
-      blkaddr += dstRowDiff;
-   }
+   util_format_unsigned_compress_rgtc_ubyte(dst,
+                                            ((srcWidth + 3) & ~3) * 4 + dstRowDiff, 16,
+                                            tempImage, srcWidth,
+                                            srcWidth, srcHeight, 2);
+   util_format_unsigned_compress_rgtc_ubyte(dst + 8,
+                                            ((srcWidth + 3) & ~3) * 4 + dstRowDiff, 16,
+                                            tempImage + 1, srcWidth,
+                                            srcWidth, srcHeight, 2);
 
    free((void *) tempImage);
 
@@ -250,11 +182,8 @@ _mesa_texstore_signed_rg_rgtc2(TEXSTORE_PARAMS)
 {
    GLbyte *dst;
    const GLfloat *tempImage = NULL;
-   int i, j;
-   int numxpixels, numypixels;
-   const GLfloat *srcaddr;
-   GLbyte srcpixels[4][4];
-   GLbyte *blkaddr;
+   GLbyte *tempByteImage;
+   int i;
    GLint dstRowDiff, rgRowStride;
    mesa_format tempFormat;
    GLfloat *tempImageSlices[1];
@@ -280,32 +209,27 @@ _mesa_texstore_signed_rg_rgtc2(TEXSTORE_PARAMS)
                   srcFormat, srcType, srcAddr,
                   srcPacking);
 
+   tempByteImage = malloc(srcWidth * srcHeight * 2 * sizeof(GLbyte));
+   if (!tempByteImage) {
+      free((void *) tempImage);
+      return GL_FALSE; /* out of memory */
+   }
+   for (i = 0; i < srcWidth * srcHeight * 2; i++)
+      tempByteImage[i] = FLOAT_TO_BYTE_TEX(tempImage[i]);
+
    dst = (GLbyte *) dstSlices[0];
 
-   blkaddr = dst;
    dstRowDiff = dstRowStride >= (srcWidth * 4) ? dstRowStride - (((srcWidth + 3) & ~3) * 4) : 0;
-   for (j = 0; j < srcHeight; j += 4) {
-      if (srcHeight > j + 3) numypixels = 4;
-      else numypixels = srcHeight - j;
-      srcaddr = tempImage + j * srcWidth * 2;
-      for (i = 0; i < srcWidth; i += 4) {
-	 if (srcWidth > i + 3) numxpixels = 4;
-	 else numxpixels = srcWidth - i;
-
-	 extractsrc_s(srcpixels, srcaddr, srcWidth, numxpixels, numypixels, 2);
-	 util_format_signed_encode_rgtc_ubyte(blkaddr, srcpixels, numxpixels, numypixels);
-	 blkaddr += 8;
-
-	 extractsrc_s(srcpixels, srcaddr + 1, srcWidth, numxpixels, numypixels, 2);
-	 util_format_signed_encode_rgtc_ubyte(blkaddr, srcpixels, numxpixels, numypixels);
-	 blkaddr += 8;
-
-	 srcaddr += numxpixels * 2;
-
-      }
-      blkaddr += dstRowDiff;
-   }
-
+   util_format_signed_compress_rgtc_ubyte(dst,
+                                          ((srcWidth + 3) & ~3) * 4 + dstRowDiff, 16,
+                                          tempByteImage, srcWidth,
+                                          srcWidth, srcHeight, 2);
+   util_format_signed_compress_rgtc_ubyte(dst + 8,
+                                          ((srcWidth + 3) & ~3) * 4 + dstRowDiff, 16,
+                                          tempByteImage + 1, srcWidth,
+                                          srcWidth, srcHeight, 2);
+
+   free(tempByteImage);
    free((void *) tempImage);
 
    return GL_TRUE;
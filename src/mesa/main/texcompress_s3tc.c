@@ -57,13 +57,6 @@ static dxtFetchTexelFuncExt fetch_ext_rgba_dxt1 = NULL;
 static dxtFetchTexelFuncExt fetch_ext_rgba_dxt3 = NULL;
 static dxtFetchTexelFuncExt fetch_ext_rgba_dxt5 = NULL;
 
-typedef void (*dxtCompressTexFuncExt)(GLint srccomps, GLint width,
-                                      GLint height, const GLubyte *srcPixData,
-                                      GLenum destformat, GLubyte *dest,
-                                      GLint dstRowStride);
-
-static dxtCompressTexFuncExt ext_tx_compress_dxtn = NULL;
-
 static void *dxtlibhandle = NULL;
 
 
@@ -76,7 +69,7 @@ _mesa_init_texture_s3tc( struct gl_context *ctx )
       dxtlibhandle = _mesa_dlopen(DXTN_LIBNAME, 0);
       if (!dxtlibhandle) {
 	 _mesa_warning(ctx, "couldn't open " DXTN_LIBNAME ", software DXTn "
-	    "compression/decompression unavailable");
+	    "decompression unavailable");
       }
       else {
          /* the fetch functions are not per context! Might be problematic... */
@@ -88,22 +81,18 @@ _mesa_init_texture_s3tc( struct gl_context *ctx )
             _mesa_dlsym(dxtlibhandle, "fetch_2d_texel_rgba_dxt3");
          fetch_ext_rgba_dxt5 = (dxtFetchTexelFuncExt)
             _mesa_dlsym(dxtlibhandle, "fetch_2d_texel_rgba_dxt5");
-         ext_tx_compress_dxtn = (dxtCompressTexFuncExt)
-            _mesa_dlsym(dxtlibhandle, "tx_compress_dxtn");
 
          if (!fetch_ext_rgb_dxt1 ||
              !fetch_ext_rgba_dxt1 ||
              !fetch_ext_rgba_dxt3 ||
-             !fetch_ext_rgba_dxt5 ||
-             !ext_tx_compress_dxtn) {
+             !fetch_ext_rgba_dxt5) {
 	    _mesa_warning(ctx, "couldn't reference all symbols in "
-	       DXTN_LIBNAME ", software DXTn compression/decompression "
+	       DXTN_LIBNAME ", software DXTn decompression "
 	       "unavailable");
             fetch_ext_rgb_dxt1 = NULL;
             fetch_ext_rgba_dxt1 = NULL;
             fetch_ext_rgba_dxt3 = NULL;
             fetch_ext_rgba_dxt5 = NULL;
-            ext_tx_compress_dxtn = NULL;
             _mesa_dlclose(dxtlibhandle);
             dxtlibhandle = NULL;
          }
@@ -114,6 +103,467 @@ _mesa_init_texture_s3tc( struct gl_context *ctx )
    }
 }
 
+
+/*
+ * Internal DXTn block encoder.
+ *
+ * Color endpoints start as the extreme pixels along the block's
+ * bounding-box diagonal and are then improved with two least-squares
+ * refinement rounds against the chosen indices; DXT5 alpha is a plain
+ * range fit.  That's the usual real-time encoder tradeoff: within a
+ * fraction of a dB of a full cluster fit at a fraction of the cost.
+ */
+
+
+/**
+ * Fetch a 4x4 block of RGBA texels, replicating the edge texels for
+ * blocks that hang off the right/bottom of the image.
+ */
+static void
+extract_block(const GLubyte *src, GLint comps, GLint width, GLint height,
+              GLint x, GLint y, GLubyte px[16][4])
+{
+   GLint i, j;
+
+   if (comps == 4 && x + 4 <= width && y + 4 <= height) {
+      /* interior block: four straight row copies */
+      for (j = 0; j < 4; j++)
+         memcpy(px[j * 4], src + ((y + j) * width + x) * 4, 16);
+      return;
+   }
+
+   for (j = 0; j < 4; j++) {
+      const GLint sy = MIN2(y + j, height - 1);
+      for (i = 0; i < 4; i++) {
+         const GLint sx = MIN2(x + i, width - 1);
+         const GLubyte *s = src + (sy * width + sx) * comps;
+         GLubyte *d = px[j * 4 + i];
+         d[0] = s[0];
+         d[1] = s[1];
+         d[2] = s[2];
+         d[3] = comps == 4 ? s[3] : 255;
+      }
+   }
+}
+
+
+static GLushort
+pack_color_565(const GLubyte col[3])
+{
+   return (GLushort)((((col[0] * 31 + 127) / 255) << 11) |
+                     (((col[1] * 63 + 127) / 255) << 5) |
+                      ((col[2] * 31 + 127) / 255));
+}
+
+
+static void
+unpack_color_565(GLushort c, GLubyte col[3])
+{
+   const GLuint r = (c >> 11) & 0x1f;
+   const GLuint g = (c >> 5) & 0x3f;
+   const GLuint b = c & 0x1f;
+
+   col[0] = (GLubyte)((r << 3) | (r >> 2));
+   col[1] = (GLubyte)((g << 2) | (g >> 4));
+   col[2] = (GLubyte)((b << 3) | (b >> 2));
+}
+
+
+static void
+eval_palette_565(GLushort c0, GLushort c1, GLboolean four_colors,
+                 GLubyte palette[4][3])
+{
+   GLuint ch;
+
+   unpack_color_565(c0, palette[0]);
+   unpack_color_565(c1, palette[1]);
+
+   for (ch = 0; ch < 3; ch++) {
+      if (four_colors) {
+         palette[2][ch] = (GLubyte)((2 * palette[0][ch] + palette[1][ch] + 1) / 3);
+         palette[3][ch] = (GLubyte)((palette[0][ch] + 2 * palette[1][ch] + 1) / 3);
+      }
+      else {
+         palette[2][ch] = (GLubyte)((palette[0][ch] + palette[1][ch] + 1) / 2);
+         palette[3][ch] = 0;
+      }
+   }
+}
+
+
+/**
+ * Pick the closest palette entry for every texel.  The palette entries
+ * are collinear by construction, so projecting each texel onto the
+ * endpoint axis and comparing against the midpoints between entries
+ * picks the same entry as a full distance search without the 4-way
+ * compare.  Texels below the DXT1 alpha threshold are forced to
+ * index 3 (transparent).
+ */
+static GLuint
+match_color_block(const GLubyte px[16][4], const GLubyte palette[4][3],
+                  GLuint num_colors, GLboolean transparent_alpha)
+{
+   /* palette entries ordered along the c0 -> c1 axis */
+   static const GLubyte order4[4] = { 0, 2, 3, 1 };
+   static const GLubyte order3[3] = { 0, 2, 1 };
+   const GLubyte *order = num_colors == 4 ? order4 : order3;
+   GLint dir[3], mid[3];
+   GLuint indices = 0;
+   GLuint i, j;
+
+   for (j = 0; j < 3; j++)
+      dir[j] = palette[1][j] - palette[0][j];
+
+   /* midpoints between consecutive entries, as dot products */
+   for (j = 0; j + 1 < num_colors; j++) {
+      const GLubyte *a = palette[order[j]];
+      const GLubyte *b = palette[order[j + 1]];
+      mid[j] = ((a[0] + b[0]) * dir[0] +
+                (a[1] + b[1]) * dir[1] +
+                (a[2] + b[2]) * dir[2] + 1) / 2;
+   }
+
+   for (i = 0; i < 16; i++) {
+      GLint dot;
+
+      if (transparent_alpha && px[i][3] < 128) {
+         indices |= 3u << (i * 2);
+         continue;
+      }
+
+      dot = px[i][0] * dir[0] + px[i][1] * dir[1] + px[i][2] * dir[2];
+      for (j = 0; j + 1 < num_colors; j++) {
+         if (dot < mid[j])
+            break;
+      }
+      indices |= (GLuint)order[j] << (i * 2);
+   }
+
+   return indices;
+}
+
+
+/**
+ * Solve for the endpoint pair that minimizes the squared error of the
+ * current index assignment.  Returns GL_FALSE when the system is
+ * singular (all texels on one endpoint), in which case the previous
+ * endpoints stand.
+ */
+static GLboolean
+refine_color_endpoints(const GLubyte px[16][4], GLuint indices,
+                       GLboolean four_colors, GLboolean transparent_alpha,
+                       GLushort *c0, GLushort *c1)
+{
+   /* numerator of the second endpoint's interpolation weight, over
+    * scale (3 for the 4-color palette, 2 for the 3-color one)
+    */
+   static const GLint weight4[4] = { 0, 3, 1, 2 };
+   static const GLint weight3[4] = { 0, 2, 1, 0 };
+   const GLint *weight = four_colors ? weight4 : weight3;
+   const GLint scale = four_colors ? 3 : 2;
+   GLint i11 = 0, i12 = 0, i22 = 0;
+   GLint j1[3] = { 0, 0, 0 };
+   GLint j2[3] = { 0, 0, 0 };
+   GLubyte end0[3], end1[3];
+   GLfloat det;
+   GLuint i, ch;
+
+   for (i = 0; i < 16; i++) {
+      const GLuint idx = (indices >> (i * 2)) & 3;
+      GLint w, u;
+
+      if (transparent_alpha && idx == 3)
+         continue;
+
+      w = weight[idx];
+      u = scale - w;
+      i11 += u * u;
+      i12 += u * w;
+      i22 += w * w;
+      for (ch = 0; ch < 3; ch++) {
+         j1[ch] += u * px[i][ch];
+         j2[ch] += w * px[i][ch];
+      }
+   }
+
+   det = (GLfloat)(i11 * i22 - i12 * i12);
+   if (det == 0.0F)
+      return GL_FALSE;
+   det = scale / det;
+
+   for (ch = 0; ch < 3; ch++) {
+      const GLfloat e0 = (i22 * j1[ch] - i12 * j2[ch]) * det;
+      const GLfloat e1 = (i11 * j2[ch] - i12 * j1[ch]) * det;
+      end0[ch] = (GLubyte)(CLAMP(e0, 0.0F, 255.0F) + 0.5F);
+      end1[ch] = (GLubyte)(CLAMP(e1, 0.0F, 255.0F) + 0.5F);
+   }
+
+   *c0 = pack_color_565(end0);
+   *c1 = pack_color_565(end1);
+   return GL_TRUE;
+}
+
+
+static void
+write_color_block(GLushort c0, GLushort c1, GLuint indices, GLubyte *dst)
+{
+   dst[0] = (GLubyte)(c0 & 0xff);
+   dst[1] = (GLubyte)(c0 >> 8);
+   dst[2] = (GLubyte)(c1 & 0xff);
+   dst[3] = (GLubyte)(c1 >> 8);
+   dst[4] = (GLubyte)(indices & 0xff);
+   dst[5] = (GLubyte)((indices >> 8) & 0xff);
+   dst[6] = (GLubyte)((indices >> 16) & 0xff);
+   dst[7] = (GLubyte)(indices >> 24);
+}
+
+
+/**
+ * Encode one 4x4 color block.
+ *
+ * \param allow_transparency  DXT1 RGBA: texels with alpha < 0.5 use the
+ *                            transparent 3-color mode.
+ * \param always_four         DXT3/5: the decoder always uses the 4-color
+ *                            palette regardless of endpoint order.
+ */
+static void
+encode_color_block(const GLubyte px[16][4], GLboolean allow_transparency,
+                   GLboolean always_four, GLubyte *dst)
+{
+   GLubyte mincol[3], maxcol[3];
+   GLubyte palette[4][3];
+   GLint axis[3];
+   GLboolean transparent_alpha = GL_FALSE;
+   GLboolean four, decode_four;
+   GLuint nopaque = 0;
+   GLuint i, ch, pass;
+   GLushort c0, c1;
+   GLuint indices;
+
+   if (allow_transparency) {
+      for (i = 0; i < 16; i++) {
+         if (px[i][3] < 128)
+            transparent_alpha = GL_TRUE;
+      }
+   }
+   four = always_four || !transparent_alpha;
+
+   mincol[0] = mincol[1] = mincol[2] = 255;
+   maxcol[0] = maxcol[1] = maxcol[2] = 0;
+   for (i = 0; i < 16; i++) {
+      if (transparent_alpha && px[i][3] < 128)
+         continue;
+      nopaque++;
+      for (ch = 0; ch < 3; ch++) {
+         mincol[ch] = MIN2(mincol[ch], px[i][ch]);
+         maxcol[ch] = MAX2(maxcol[ch], px[i][ch]);
+      }
+   }
+
+   if (!nopaque) {
+      /* fully transparent block */
+      write_color_block(0, 0, 0xffffffff, dst);
+      return;
+   }
+
+   for (ch = 0; ch < 3; ch++)
+      axis[ch] = maxcol[ch] - mincol[ch];
+
+   if (!axis[0] && !axis[1] && !axis[2]) {
+      /* solid color: equal endpoints decode the same in either mode */
+      c0 = c1 = pack_color_565(mincol);
+      indices = 0;
+      if (transparent_alpha) {
+         for (i = 0; i < 16; i++) {
+            if (px[i][3] < 128)
+               indices |= 3u << (i * 2);
+         }
+      }
+      write_color_block(c0, c1, indices, dst);
+      return;
+   }
+
+   /* initial endpoints: extremes along the bounding-box diagonal */
+   {
+      GLint mindot = 0x7fffffff, maxdot = -1;
+      GLuint mini = 0, maxi = 0;
+
+      for (i = 0; i < 16; i++) {
+         GLint dot;
+         if (transparent_alpha && px[i][3] < 128)
+            continue;
+         dot = px[i][0] * axis[0] + px[i][1] * axis[1] + px[i][2] * axis[2];
+         if (dot < mindot) {
+            mindot = dot;
+            mini = i;
+         }
+         if (dot > maxdot) {
+            maxdot = dot;
+            maxi = i;
+         }
+      }
+      c0 = pack_color_565(px[maxi]);
+      c1 = pack_color_565(px[mini]);
+   }
+
+   {
+      GLushort mc0 = 0, mc1 = 0;    /* endpoints the indices were matched to */
+
+      for (pass = 0; pass < 2; pass++) {
+         GLushort r0, r1;
+
+         if (four ? c0 < c1 : c0 > c1) {
+            const GLushort tmp = c0;
+            c0 = c1;
+            c1 = tmp;
+         }
+         eval_palette_565(c0, c1, four, palette);
+         indices = match_color_block(px, palette, four ? 4 : 3,
+                                     transparent_alpha);
+         mc0 = c0;
+         mc1 = c1;
+
+         r0 = c0;
+         r1 = c1;
+         if (!refine_color_endpoints(px, indices, four, transparent_alpha,
+                                     &r0, &r1))
+            break;
+         if (r0 == c0 && r1 == c1)
+            break;                  /* converged */
+         c0 = r0;
+         c1 = r1;
+      }
+
+      if (four ? c0 < c1 : c0 > c1) {
+         const GLushort tmp = c0;
+         c0 = c1;
+         c1 = tmp;
+      }
+
+      /* Recompute the indices for the palette the decoder will actually
+       * use: equal endpoints put a DXT1 block in 3-color mode whatever
+       * we intended.
+       */
+      decode_four = always_four || c0 > c1;
+      if (c0 != mc0 || c1 != mc1 || decode_four != four) {
+         eval_palette_565(c0, c1, decode_four, palette);
+         indices = match_color_block(px, palette, decode_four ? 4 : 3,
+                                     transparent_alpha);
+      }
+   }
+
+   write_color_block(c0, c1, indices, dst);
+}
+
+
+/**
+ * Encode the 4-bit explicit alpha block of a DXT3 block.
+ */
+static void
+encode_alpha4_block(const GLubyte px[16][4], GLubyte *dst)
+{
+   GLuint i;
+
+   for (i = 0; i < 8; i++) {
+      const GLuint a0 = (px[2 * i + 0][3] * 15 + 128) / 255;
+      const GLuint a1 = (px[2 * i + 1][3] * 15 + 128) / 255;
+      dst[i] = (GLubyte)(a0 | (a1 << 4));
+   }
+}
+
+
+/**
+ * Encode the interpolated alpha block of a DXT5 block with a range fit:
+ * endpoints are the block's alpha extremes and every texel snaps to the
+ * nearest of the 8 evenly spaced steps.
+ */
+static void
+encode_alpha8_block(const GLubyte px[16][4], GLubyte *dst)
+{
+   GLubyte amin = 255, amax = 0;
+   GLuint range, bit;
+   GLuint i;
+
+   for (i = 0; i < 16; i++) {
+      amin = MIN2(amin, px[i][3]);
+      amax = MAX2(amax, px[i][3]);
+   }
+
+   dst[0] = amax;
+   dst[1] = amin;
+   memset(dst + 2, 0, 6);
+
+   range = amax - amin;
+   if (range == 0)
+      return;                       /* all indices stay 0 (= amax) */
+
+   /* fixed-point reciprocal instead of a divide per texel; the scaled
+    * numerator is at most 255 * 7 + 127, so the truncation error never
+    * moves an endpoint value off its exact step
+    */
+   {
+      const GLuint inv = (1u << 20) / range;
+
+      bit = 0;
+      for (i = 0; i < 16; i++) {
+         /* s = 0 hits amin, s = 7 hits amax */
+         const GLuint s =
+            (((px[i][3] - amin) * 7 + range / 2) * inv) >> 20;
+         const GLuint idx = s == 0 ? 1 : (s == 7 ? 0 : 8 - s);
+
+         dst[2 + (bit >> 3)] |= (GLubyte)(idx << (bit & 7));
+         if ((bit & 7) > 5)
+            dst[3 + (bit >> 3)] |= (GLubyte)(idx >> (8 - (bit & 7)));
+         bit += 3;
+      }
+   }
+}
+
+
+/**
+ * Compress an RGB or RGBA image into DXT1/3/5 blocks.  Same contract as
+ * the old libtxc_dxtn tx_compress_dxtn entry point: tightly packed
+ * source rows, \p dstRowStride in bytes per row of blocks.
+ */
+void
+_mesa_tx_compress_dxtn(GLint srccomps, GLint width, GLint height,
+                       const GLubyte *srcPixData, GLenum destFormat,
+                       GLubyte *dest, GLint dstRowStride)
+{
+   GLubyte px[16][4];
+   GLint x, y;
+
+   for (y = 0; y < height; y += 4) {
+      GLubyte *blkaddr = dest + (y / 4) * dstRowStride;
+      for (x = 0; x < width; x += 4) {
+         extract_block(srcPixData, srccomps, width, height, x, y, px);
+         switch (destFormat) {
+         case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            encode_color_block(px, GL_FALSE, GL_FALSE, blkaddr);
+            blkaddr += 8;
+            break;
+         case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            encode_color_block(px, GL_TRUE, GL_FALSE, blkaddr);
+            blkaddr += 8;
+            break;
+         case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+            encode_alpha4_block(px, blkaddr);
+            encode_color_block(px, GL_FALSE, GL_TRUE, blkaddr + 8);
+            blkaddr += 16;
+            break;
+         case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            encode_alpha8_block(px, blkaddr);
+            encode_color_block(px, GL_FALSE, GL_TRUE, blkaddr + 8);
+            blkaddr += 16;
+            break;
+         default:
+            unreachable("unexpected format in _mesa_tx_compress_dxtn");
+         }
+      }
+   }
+}
+
+
 /**
  * Store user's image in rgb_dxt1 format.
  */
@@ -156,14 +606,9 @@ _mesa_texstore_rgb_dxt1(TEXSTORE_PARAMS)
 
    dst = dstSlices[0];
 
-   if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(3, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
-                              dst, dstRowStride);
-   }
-   else {
-      _mesa_warning(ctx, "external dxt library not available: texstore_rgb_dxt1");
-   }
+   _mesa_tx_compress_dxtn(3, srcWidth, srcHeight, pixels,
+                    GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                    dst, dstRowStride);
 
    free((void *) tempImage);
 
@@ -214,14 +659,9 @@ _mesa_texstore_rgba_dxt1(TEXSTORE_PARAMS)
 
    dst = dstSlices[0];
 
-   if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(4, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
-                              dst, dstRowStride);
-   }
-   else {
-      _mesa_warning(ctx, "external dxt library not available: texstore_rgba_dxt1");
-   }
+   _mesa_tx_compress_dxtn(4, srcWidth, srcHeight, pixels,
+                    GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
+                    dst, dstRowStride);
 
    free((void*) tempImage);
 
@@ -271,14 +711,9 @@ _mesa_texstore_rgba_dxt3(TEXSTORE_PARAMS)
 
    dst = dstSlices[0];
 
-   if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(4, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
-                              dst, dstRowStride);
-   }
-   else {
-      _mesa_warning(ctx, "external dxt library not available: texstore_rgba_dxt3");
-   }
+   _mesa_tx_compress_dxtn(4, srcWidth, srcHeight, pixels,
+                    GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
+                    dst, dstRowStride);
 
    free((void *) tempImage);
 
@@ -328,14 +763,9 @@ _mesa_texstore_rgba_dxt5(TEXSTORE_PARAMS)
 
    dst = dstSlices[0];
 
-   if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(4, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
-                              dst, dstRowStride);
-   }
-   else {
-      _mesa_warning(ctx, "external dxt library not available: texstore_rgba_dxt5");
-   }
+   _mesa_tx_compress_dxtn(4, srcWidth, srcHeight, pixels,
+                    GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+                    dst, dstRowStride);
 
    free((void *) tempImage);
 
@@ -44,6 +44,11 @@ extern GLboolean
 _mesa_texstore_rgba_dxt5(TEXSTORE_PARAMS);
 
 
+extern void
+_mesa_tx_compress_dxtn(GLint srccomps, GLint width, GLint height,
+                       const GLubyte *srcPixData, GLenum destFormat,
+                       GLubyte *dest, GLint dstRowStride);
+
 extern void
 _mesa_init_texture_s3tc(struct gl_context *ctx);
 
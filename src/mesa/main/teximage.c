@@ -783,6 +783,9 @@ clear_teximage_fields(struct gl_texture_image *img)
    img->TexFormat = MESA_FORMAT_NONE;
    img->NumSamples = 0;
    img->FixedSampleLocations = GL_TRUE;
+
+   /* Clearing an image may change the parent object's completeness */
+   img->TexObject->_CompletenessValid = GL_FALSE;
 }
 
 
@@ -909,6 +912,9 @@ init_teximage_fields_ms(struct gl_context *ctx,
    img->TexFormat = format;
    img->NumSamples = numSamples;
    img->FixedSampleLocations = fixedSampleLocations;
+
+   /* (Re)defining an image may change the parent object's completeness */
+   img->TexObject->_CompletenessValid = GL_FALSE;
 }
 
 
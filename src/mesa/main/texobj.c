@@ -43,6 +43,7 @@
 #include "texstate.h"
 #include "mtypes.h"
 #include "program/prog_instruction.h"
+#include "util/u_atomic.h"
 
 
 
@@ -465,6 +466,7 @@ _mesa_copy_texture_object( struct gl_texture_object *dest,
    dest->GenerateMipmap = src->GenerateMipmap;
    dest->_BaseComplete = src->_BaseComplete;
    dest->_MipmapComplete = src->_MipmapComplete;
+   dest->_CompletenessValid = src->_CompletenessValid;
    COPY_4V(dest->Swizzle, src->Swizzle);
    dest->_Swizzle = src->_Swizzle;
    dest->_IsHalfFloat = src->_IsHalfFloat;
@@ -654,9 +656,13 @@ _mesa_test_texobj_completeness( const struct gl_context *ctx,
    const struct gl_texture_image *baseImage;
    GLint maxLevels = 0;
 
-   /* We'll set these to FALSE if tests fail below */
+   /* We'll set these to FALSE if tests fail below.  The results stay valid
+    * until an image or a completeness-affecting parameter changes; sampler
+    * state is checked separately in _mesa_is_texture_complete().
+    */
    t->_BaseComplete = GL_TRUE;
    t->_MipmapComplete = GL_TRUE;
+   t->_CompletenessValid = GL_TRUE;
 
    if (t->Target == GL_TEXTURE_BUFFER) {
       /* Buffer textures are always considered complete.  The obvious case where
@@ -934,6 +940,7 @@ _mesa_dirty_texobj(struct gl_context *ctx, struct gl_texture_object *texObj)
 {
    texObj->_BaseComplete = GL_FALSE;
    texObj->_MipmapComplete = GL_FALSE;
+   texObj->_CompletenessValid = GL_FALSE;
    ctx->NewState |= _NEW_TEXTURE;
 }
 
@@ -1621,17 +1628,14 @@ bind_texture(struct gl_context *ctx,
    assert(targetIndex < NUM_TEXTURE_TARGETS);
 
    /* Check if this texture is only used by this context and is already bound.
-    * If so, just return.
+    * If so, just return.  The ref count is only ever 1 when no other context
+    * shares this state, so reading it without the mutex is safe here: any
+    * transition away from 1 requires a MakeCurrent in another thread, which
+    * the application must order against this bind anyway.
     */
-   {
-      bool early_out;
-      mtx_lock(&ctx->Shared->Mutex);
-      early_out = ((ctx->Shared->RefCount == 1)
-                   && (texObj == texUnit->CurrentTex[targetIndex]));
-      mtx_unlock(&ctx->Shared->Mutex);
-      if (early_out) {
-         return;
-      }
+   if (p_atomic_read(&ctx->Shared->RefCount) == 1
+       && texObj == texUnit->CurrentTex[targetIndex]) {
+      return;
    }
 
    /* flush before changing binding */
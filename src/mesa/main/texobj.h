@@ -158,6 +158,20 @@ extern void
 _mesa_test_texobj_completeness( const struct gl_context *ctx,
                                 struct gl_texture_object *obj );
 
+/**
+ * Recompute the cached _BaseComplete/_MipmapComplete flags, but only if an
+ * image or a completeness-affecting texture parameter changed since they
+ * were last computed.  Sampler state doesn't invalidate the cache, so
+ * re-validating a bound texture against new sampler state is O(1).
+ */
+static inline void
+_mesa_update_texobj_completeness(const struct gl_context *ctx,
+                                 struct gl_texture_object *texObj)
+{
+   if (!texObj->_CompletenessValid)
+      _mesa_test_texobj_completeness(ctx, texObj);
+}
+
 extern GLboolean
 _mesa_cube_level_complete(const struct gl_texture_object *texObj,
                           const GLint level);
@@ -539,10 +539,7 @@ update_single_program_texture(struct gl_context *ctx, struct gl_program *prog,
       texUnit->Sampler : &texObj->Sampler;
 
    if (likely(texObj)) {
-      if (_mesa_is_texture_complete(texObj, sampler))
-         return texObj;
-
-      _mesa_test_texobj_completeness(ctx, texObj);
+      _mesa_update_texobj_completeness(ctx, texObj);
       if (_mesa_is_texture_complete(texObj, sampler))
          return texObj;
    }
@@ -655,9 +652,7 @@ update_ff_texture_state(struct gl_context *ctx,
             struct gl_sampler_object *sampler = texUnit->Sampler ?
                texUnit->Sampler : &texObj->Sampler;
 
-            if (!_mesa_is_texture_complete(texObj, sampler)) {
-               _mesa_test_texobj_completeness(ctx, texObj);
-            }
+            _mesa_update_texobj_completeness(ctx, texObj);
             if (_mesa_is_texture_complete(texObj, sampler)) {
                _mesa_reference_texobj(&texUnit->_Current, texObj);
                break;
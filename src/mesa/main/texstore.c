@@ -51,6 +51,8 @@
  */
 
 
+#include "c11/threads.h"
+
 #include "glheader.h"
 #include "bufferobj.h"
 #include "format_pack.h"
@@ -669,6 +671,105 @@ texstore_compressed(TEXSTORE_PARAMS)
                            srcFormat, srcType, srcAddr, srcPacking);
 }
 
+/**
+ * Minimum size (in texels) of a slice for splitting the format conversion
+ * across several threads.  Below this the thread creation overhead costs
+ * more than the parallelism saves.
+ */
+#define TEXSTORE_PARALLEL_THRESHOLD (1024 * 1024)
+
+/** Max number of threads used for one conversion, including the caller */
+#define TEXSTORE_MAX_THREADS 4
+
+
+struct convert_rows_args
+{
+   void *dst;
+   uint32_t dstFormat;
+   size_t dstRowStride;
+   void *src;
+   uint32_t srcFormat;
+   size_t srcRowStride;
+   size_t width;
+   size_t height;
+   uint8_t *rebaseSwizzle;
+};
+
+
+static int
+convert_rows_func(void *data)
+{
+   const struct convert_rows_args *args = data;
+
+   _mesa_format_convert(args->dst, args->dstFormat, args->dstRowStride,
+                        args->src, args->srcFormat, args->srcRowStride,
+                        args->width, args->height, args->rebaseSwizzle);
+   return 0;
+}
+
+
+/**
+ * Convert a 2D image from srcFormat to dstFormat as _mesa_format_convert
+ * does, but split the work by row ranges across up to TEXSTORE_MAX_THREADS
+ * threads when the image is large enough for that to pay off.  The
+ * conversion functions work row by row, so disjoint row ranges can be
+ * converted independently.
+ */
+static void
+convert_image(void *dst, uint32_t dstFormat, size_t dstRowStride,
+              void *src, uint32_t srcFormat, size_t srcRowStride,
+              size_t width, size_t height, uint8_t *rebaseSwizzle)
+{
+   struct convert_rows_args args[TEXSTORE_MAX_THREADS];
+   thrd_t threads[TEXSTORE_MAX_THREADS];
+   bool created[TEXSTORE_MAX_THREADS];
+   size_t first_row, rows_per_job;
+   unsigned i;
+
+   if (width * height < TEXSTORE_PARALLEL_THRESHOLD ||
+       height < TEXSTORE_MAX_THREADS) {
+      _mesa_format_convert(dst, dstFormat, dstRowStride,
+                           src, srcFormat, srcRowStride,
+                           width, height, rebaseSwizzle);
+      return;
+   }
+
+   rows_per_job = height / TEXSTORE_MAX_THREADS;
+   first_row = 0;
+   for (i = 0; i < TEXSTORE_MAX_THREADS; i++) {
+      args[i].dst = (uint8_t *) dst + first_row * dstRowStride;
+      args[i].dstFormat = dstFormat;
+      args[i].dstRowStride = dstRowStride;
+      args[i].src = (uint8_t *) src + first_row * srcRowStride;
+      args[i].srcFormat = srcFormat;
+      args[i].srcRowStride = srcRowStride;
+      args[i].width = width;
+      /* the last range picks up the remainder rows */
+      args[i].height = (i == TEXSTORE_MAX_THREADS - 1) ?
+         height - first_row : rows_per_job;
+      args[i].rebaseSwizzle = rebaseSwizzle;
+      first_row += rows_per_job;
+   }
+
+   for (i = 1; i < TEXSTORE_MAX_THREADS; i++) {
+      created[i] = thrd_create(&threads[i], convert_rows_func,
+                               &args[i]) == thrd_success;
+      if (!created[i]) {
+         /* couldn't create the thread: just do its share here */
+         convert_rows_func(&args[i]);
+      }
+   }
+
+   /* the calling thread converts the first row range itself */
+   convert_rows_func(&args[0]);
+
+   for (i = 1; i < TEXSTORE_MAX_THREADS; i++) {
+      if (created[i])
+         thrd_join(threads[i], NULL);
+   }
+}
+
+
 static GLboolean
 texstore_rgba(TEXSTORE_PARAMS)
 {
@@ -771,9 +872,9 @@ texstore_rgba(TEXSTORE_PARAMS)
       src = (GLubyte *) srcAddr;
       dst = (GLubyte *) tempRGBA;
       for (img = 0; img < srcDepth; img++) {
-         _mesa_format_convert(dst, RGBA32_FLOAT, 4 * srcWidth * sizeof(float),
-                              src, srcMesaFormat, srcRowStride,
-                              srcWidth, srcHeight, NULL);
+         convert_image(dst, RGBA32_FLOAT, 4 * srcWidth * sizeof(float),
+                       src, srcMesaFormat, srcRowStride,
+                       srcWidth, srcHeight, NULL);
          src += srcHeight * srcRowStride;
          dst += srcHeight * 4 * srcWidth * sizeof(float);
       }
@@ -806,10 +907,10 @@ texstore_rgba(TEXSTORE_PARAMS)
    }
 
    for (img = 0; img < srcDepth; img++) {
-      _mesa_format_convert(dstSlices[img], dstFormat, dstRowStride,
-                           src, srcMesaFormat, srcRowStride,
-                           srcWidth, srcHeight,
-                           needRebase ? rebaseSwizzle : NULL);
+      convert_image(dstSlices[img], dstFormat, dstRowStride,
+                    src, srcMesaFormat, srcRowStride,
+                    srcWidth, srcHeight,
+                    needRebase ? rebaseSwizzle : NULL);
       src += srcHeight * srcRowStride;
    }
 
@@ -841,7 +942,7 @@ _mesa_texstore_needs_transfer_ops(struct gl_context *ctx,
        * Pixel transfer ops (scale, bias, table lookup) do not apply
        * to integer formats.
        */
-      dstType = _mesa_get_format_datatype(dstFormat);
+      dstType = _mesa_get_format_fast_info(dstFormat)->DataType;
 
       return dstType != GL_INT && dstType != GL_UNSIGNED_INT &&
              ctx->_ImageTransferState;
@@ -860,7 +961,7 @@ _mesa_texstore_can_use_memcpy(struct gl_context *ctx,
    }
 
    /* The base internal format and the base Mesa format must match. */
-   if (baseInternalFormat != _mesa_get_format_base_format(dstFormat)) {
+   if (baseInternalFormat != _mesa_get_format_fast_info(dstFormat)->BaseFormat) {
       return GL_FALSE;
    }
 
@@ -31,6 +31,7 @@
 #include "main/shaderapi.h"
 #include "main/shaderobj.h"
 #include "main/uniforms.h"
+#include "program/prog_parameter.h"
 #include "compiler/glsl/ir.h"
 #include "compiler/glsl/ir_uniform.h"
 #include "compiler/glsl/glsl_parser_extras.h"
@@ -614,6 +615,17 @@ _mesa_propagate_uniforms_to_driver_storage(struct gl_uniform_storage *uni,
 	 assert(!"Should not get here.");
 	 break;
       }
+
+      if (store->params) {
+	 /* Tell the parameter list which vec4 slots changed so consumers
+	  * can skip or bound their constant re-upload.
+	  */
+	 const unsigned first = store->param_index
+	    + (array_index * store->element_stride) / 16;
+	 const unsigned slots = (count * store->element_stride + 15) / 16;
+
+	 _mesa_parameter_list_mark_dirty(store->params, first, slots);
+      }
    }
 }
 
@@ -151,6 +151,7 @@ vertex_attrib_binding(struct gl_context *ctx,
       array->VertexBinding = bindingIndex;
 
       vao->NewArrays |= array_bit;
+      _mesa_vao_state_changed(ctx, vao);
    }
 }
 
@@ -185,6 +186,7 @@ _mesa_bind_vertex_buffer(struct gl_context *ctx,
          vao->VertexAttribBufferMask |= binding->_BoundArrays;
 
       vao->NewArrays |= binding->_BoundArrays;
+      _mesa_vao_state_changed(ctx, vao);
    }
 }
 
@@ -206,6 +208,7 @@ vertex_binding_divisor(struct gl_context *ctx,
       FLUSH_VERTICES(ctx, _NEW_ARRAY);
       binding->InstanceDivisor = divisor;
       vao->NewArrays |= binding->_BoundArrays;
+      _mesa_vao_state_changed(ctx, vao);
    }
 }
 
@@ -300,6 +303,7 @@ _mesa_update_array_format(struct gl_context *ctx,
    array->_ElementSize = elementSize;
 
    vao->NewArrays |= VERT_BIT(attrib);
+   _mesa_vao_state_changed(ctx, vao);
    ctx->NewState |= _NEW_ARRAY;
 }
 
@@ -793,6 +797,7 @@ _mesa_enable_vertex_array_attrib(struct gl_context *ctx,
       vao->VertexAttrib[attrib].Enabled = GL_TRUE;
       vao->_Enabled |= VERT_BIT(attrib);
       vao->NewArrays |= VERT_BIT(attrib);
+      _mesa_vao_state_changed(ctx, vao);
    }
 }
 
@@ -860,6 +865,7 @@ disable_vertex_array_attrib(struct gl_context *ctx,
       vao->VertexAttrib[VERT_ATTRIB_GENERIC(index)].Enabled = GL_FALSE;
       vao->_Enabled &= ~VERT_BIT_GENERIC(index);
       vao->NewArrays |= VERT_BIT_GENERIC(index);
+      _mesa_vao_state_changed(ctx, vao);
    }
 }
 
@@ -2562,7 +2562,8 @@ _mesa_associate_uniform_storage(struct gl_context *ctx,
 					     dmul * columns,
 					     dmul,
 					     format,
-					     &params->ParameterValues[i]);
+					     &params->ParameterValues[i],
+					     params, i);
 
 	 /* After attaching the driver's storage to the uniform, propagate any
 	  * data from the linker's backing store.  This will cause values from
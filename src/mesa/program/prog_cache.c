@@ -34,6 +34,13 @@
 #include "program/program.h"
 
 
+/**
+ * Once the cache holds this many programs, inserting a new one evicts
+ * the least recently used one instead of growing the table.
+ */
+#define MAX_CACHE_ITEMS 1024
+
+
 struct cache_item
 {
    GLuint hash;
@@ -41,12 +48,18 @@ struct cache_item
    void *key;
    struct gl_program *program;
    struct cache_item *next;
+   /** Doubly-linked LRU list, most recently used first */
+   struct cache_item *lru_prev, *lru_next;
 };
 
 struct gl_program_cache
 {
    struct cache_item **items;
-   struct cache_item *last;
+   struct cache_item *last;     /**< one-entry cache of the last hit */
+   struct cache_item *lru_head; /**< most recently used item */
+   struct cache_item *lru_tail; /**< least recently used item */
+   GLuint last_hash;            /**< hash computed by the last search */
+   GLuint last_keysize;
    GLuint size, n_items;
 };
 
@@ -76,6 +89,88 @@ hash_key(const void *key, GLuint key_size)
 }
 
 
+/**
+ * Unlink an item from the LRU list.
+ */
+static void
+lru_remove(struct gl_program_cache *cache, struct cache_item *c)
+{
+   if (c->lru_prev)
+      c->lru_prev->lru_next = c->lru_next;
+   else
+      cache->lru_head = c->lru_next;
+
+   if (c->lru_next)
+      c->lru_next->lru_prev = c->lru_prev;
+   else
+      cache->lru_tail = c->lru_prev;
+}
+
+
+/**
+ * Put an item (not currently in the LRU list) at the head of the list.
+ */
+static void
+lru_push(struct gl_program_cache *cache, struct cache_item *c)
+{
+   c->lru_prev = NULL;
+   c->lru_next = cache->lru_head;
+   if (cache->lru_head)
+      cache->lru_head->lru_prev = c;
+   else
+      cache->lru_tail = c;
+   cache->lru_head = c;
+}
+
+
+/**
+ * Mark an item as most recently used.
+ */
+static void
+lru_touch(struct gl_program_cache *cache, struct cache_item *c)
+{
+   if (cache->lru_head != c) {
+      lru_remove(cache, c);
+      lru_push(cache, c);
+   }
+}
+
+
+/**
+ * Drop the least recently used program to make room for a new one.
+ */
+static void
+evict_lru_item(struct gl_context *ctx, struct gl_program_cache *cache,
+               GLboolean shader)
+{
+   struct cache_item *c = cache->lru_tail;
+   struct cache_item **prev;
+
+   assert(c);
+
+   /* unlink from the hash chain */
+   prev = &cache->items[c->hash % cache->size];
+   while (*prev != c)
+      prev = &(*prev)->next;
+   *prev = c->next;
+
+   lru_remove(cache, c);
+   if (cache->last == c)
+      cache->last = NULL;
+
+   free(c->key);
+   if (shader) {
+      _mesa_reference_shader_program(ctx,
+                                     (struct gl_shader_program **)&c->program,
+                                     NULL);
+   } else {
+      _mesa_reference_program(ctx, &c->program, NULL);
+   }
+   free(c);
+   cache->n_items--;
+}
+
+
 /**
  * Rebuild/expand the hash table to accommodate more entries
  */
@@ -130,7 +225,7 @@ clear_cache(struct gl_context *ctx, struct gl_program_cache *cache,
       cache->items[i] = NULL;
    }
 
-
+   cache->lru_head = cache->lru_tail = NULL;
    cache->n_items = 0;
 }
 
@@ -178,18 +273,26 @@ _mesa_search_program_cache(struct gl_program_cache *cache,
    if (cache->last &&
        cache->last->keysize == keysize &&
        memcmp(cache->last->key, key, keysize) == 0) {
+      lru_touch(cache, cache->last);
       return cache->last->program;
    }
    else {
       const GLuint hash = hash_key(key, keysize);
       struct cache_item *c;
 
+      /* remember the hash so a following insert of this key needn't
+       * hash it again
+       */
+      cache->last_hash = hash;
+      cache->last_keysize = keysize;
+
       for (c = cache->items[hash % cache->size]; c; c = c->next) {
          if (c->hash == hash &&
              c->keysize == keysize &&
              memcmp(c->key, key, keysize) == 0) {
 
             cache->last = c;
+            lru_touch(cache, c);
             return c->program;
          }
       }
@@ -199,13 +302,37 @@ _mesa_search_program_cache(struct gl_program_cache *cache,
 }
 
 
+/**
+ * Get the hash for a key, reusing the hash computed by the immediately
+ * preceding search for that key when possible.
+ */
+static GLuint
+get_key_hash(struct gl_program_cache *cache, const void *key, GLuint keysize)
+{
+   GLuint hash;
+
+   if (cache->last_keysize == keysize) {
+      hash = cache->last_hash;
+      assert(hash == hash_key(key, keysize));
+   }
+   else {
+      hash = hash_key(key, keysize);
+   }
+
+   /* only valid for the one insert following the search */
+   cache->last_keysize = 0;
+
+   return hash;
+}
+
+
 void
 _mesa_program_cache_insert(struct gl_context *ctx,
                            struct gl_program_cache *cache,
                            const void *key, GLuint keysize,
                            struct gl_program *program)
 {
-   const GLuint hash = hash_key(key, keysize);
+   const GLuint hash = get_key_hash(cache, key, keysize);
    struct cache_item *c = CALLOC_STRUCT(cache_item);
 
    c->hash = hash;
@@ -216,16 +343,15 @@ _mesa_program_cache_insert(struct gl_context *ctx,
 
    c->program = program;  /* no refcount change */
 
-   if (cache->n_items > cache->size * 1.5) {
-      if (cache->size < 1000)
-	 rehash(cache);
-      else 
-	 clear_cache(ctx, cache, GL_FALSE);
-   }
+   if (cache->n_items >= MAX_CACHE_ITEMS)
+      evict_lru_item(ctx, cache, GL_FALSE);
+   else if (cache->n_items > cache->size * 1.5)
+      rehash(cache);
 
    cache->n_items++;
    c->next = cache->items[hash % cache->size];
    cache->items[hash % cache->size] = c;
+   lru_push(cache, c);
 }
 
 void
@@ -234,7 +360,7 @@ _mesa_shader_cache_insert(struct gl_context *ctx,
 			  const void *key, GLuint keysize,
 			  struct gl_shader_program *program)
 {
-   const GLuint hash = hash_key(key, keysize);
+   const GLuint hash = get_key_hash(cache, key, keysize);
    struct cache_item *c = CALLOC_STRUCT(cache_item);
 
    c->hash = hash;
@@ -245,14 +371,13 @@ _mesa_shader_cache_insert(struct gl_context *ctx,
 
    c->program = (struct gl_program *)program;  /* no refcount change */
 
-   if (cache->n_items > cache->size * 1.5) {
-      if (cache->size < 1000)
-	 rehash(cache);
-      else
-	 clear_cache(ctx, cache, GL_TRUE);
-   }
+   if (cache->n_items >= MAX_CACHE_ITEMS)
+      evict_lru_item(ctx, cache, GL_TRUE);
+   else if (cache->n_items > cache->size * 1.5)
+      rehash(cache);
 
    cache->n_items++;
    c->next = cache->items[hash % cache->size];
    cache->items[hash % cache->size] = c;
+   lru_push(cache, c);
 }
@@ -35,6 +35,36 @@
 #include "prog_instruction.h"
 #include "prog_parameter.h"
 #include "prog_statevars.h"
+#include "util/u_atomic.h"
+
+
+/**
+ * Note that values in the given range of the list have changed: widen the
+ * dirty range and give the list a fresh generation number.
+ *
+ * The counter is global so that a generation number saved from one list can
+ * never accidentally match the generation of a different list which was
+ * later allocated at the same address.
+ */
+void
+_mesa_parameter_list_mark_dirty(struct gl_program_parameter_list *paramList,
+                                GLuint first, GLuint count)
+{
+   static uint64_t generation_counter;
+
+   if (paramList->DirtyStart == paramList->DirtyEnd) {
+      paramList->DirtyStart = first;
+      paramList->DirtyEnd = first + count;
+   }
+   else {
+      if (first < paramList->DirtyStart)
+         paramList->DirtyStart = first;
+      if (first + count > paramList->DirtyEnd)
+         paramList->DirtyEnd = first + count;
+   }
+
+   paramList->Generation = p_atomic_inc_return(&generation_counter);
+}
 
 
 /**
@@ -287,6 +317,8 @@ _mesa_add_parameter(struct gl_program_parameter_list *paramList,
       size -= 4;
    }
 
+   _mesa_parameter_list_mark_dirty(paramList, oldNum, sz4);
+
    if (state) {
       for (i = 0; i < STATE_LENGTH; i++)
          paramList->Parameters[oldNum].StateIndexes[i] = state[i];
@@ -335,6 +367,7 @@ _mesa_add_typed_unnamed_constant(struct gl_program_parameter_list *paramList,
             GLuint swz = p->Size; /* 1, 2 or 3 for Y, Z, W */
             pVal[p->Size] = values[0];
             p->Size++;
+            _mesa_parameter_list_mark_dirty(paramList, pos, 1);
             *swizzleOut = MAKE_SWIZZLE4(swz, swz, swz, swz);
             return pos;
          }
@@ -88,6 +88,27 @@ struct gl_program_parameter_list
    gl_constant_value (*ParameterValues)[4]; /**< Array [Size] of constant[4] */
    GLbitfield StateFlags; /**< _NEW_* flags indicating which state changes
                                might invalidate ParameterValues[] */
+
+   /**
+    * Bumped to a globally unique value whenever values in the list change.
+    * A consumer which remembers the generation it last uploaded can tell
+    * with one comparison whether anything needs re-uploading.
+    */
+   GLuint64 Generation;
+
+   /**
+    * \name Dirty value range
+    *
+    * First and one-past-last ParameterValues[] slots written since the
+    * range was last cleared.  Only meaningful to a consumer which is the
+    * sole reader of the list (e.g. a driver keeping the constants in a
+    * persistent buffer and patching changed slices); shared consumers
+    * should compare \c Generation instead.
+    */
+   /*@{*/
+   GLuint DirtyStart;
+   GLuint DirtyEnd;
+   /*@}*/
 };
 
 
@@ -100,6 +121,16 @@ _mesa_new_parameter_list_sized(unsigned size);
 extern void
 _mesa_free_parameter_list(struct gl_program_parameter_list *paramList);
 
+extern void
+_mesa_parameter_list_mark_dirty(struct gl_program_parameter_list *paramList,
+                                GLuint first, GLuint count);
+
+static inline void
+_mesa_parameter_list_clear_dirty(struct gl_program_parameter_list *paramList)
+{
+   paramList->DirtyStart = paramList->DirtyEnd = 0;
+}
+
 extern void
 _mesa_reserve_parameter_storage(struct gl_program_parameter_list *paramList,
                                 unsigned reserve_slots);
@@ -1069,9 +1069,21 @@ _mesa_load_state_parameters(struct gl_context *ctx,
 
    for (i = 0; i < paramList->NumParameters; i++) {
       if (paramList->Parameters[i].Type == PROGRAM_STATE_VAR) {
+         gl_constant_value value[4];
+
+         /* Fetch into a copy of the current value so that components the
+          * state var doesn't write still compare equal, and only touch the
+          * list when something really changed: consumers watch the list's
+          * generation to skip re-uploading unchanged constants.
+          */
+         memcpy(value, paramList->ParameterValues[i], sizeof(value));
          _mesa_fetch_state(ctx,
 			   paramList->Parameters[i].StateIndexes,
-                           &paramList->ParameterValues[i][0].f);
+                           &value[0].f);
+         if (memcmp(value, paramList->ParameterValues[i], sizeof(value))) {
+            memcpy(paramList->ParameterValues[i], value, sizeof(value));
+            _mesa_parameter_list_mark_dirty(paramList, i, 1);
+         }
       }
    }
 }
@@ -23,7 +23,7 @@
 
 #include "main/imports.h"
 #include "symbol_table.h"
-#include "hash_table.h"
+#include "util/hash_table.h"
 
 struct symbol {
     /**
@@ -98,7 +98,14 @@ struct scope_level {
  *
  */
 struct _mesa_symbol_table {
-    /** Hash table containing all symbols in the symbol table. */
+    /**
+     * Hash table containing all symbols in the symbol table.
+     *
+     * This is an open-addressing table mapping interned symbol names
+     * (\c symbol_header::name) to their \c symbol_header.  Each unique name
+     * is stored exactly once, so the per-name symbol chains can compare
+     * header pointers instead of strings.
+     */
     struct hash_table *ht;
 
     /** Top of scope stack. */
@@ -186,7 +193,48 @@ _mesa_symbol_table_push_scope(struct _mesa_symbol_table *table)
 static struct symbol_header *
 find_symbol(struct _mesa_symbol_table *table, const char *name)
 {
-    return (struct symbol_header *) hash_table_find(table->ht, name);
+    struct hash_entry *const entry =
+       _mesa_hash_table_search(table->ht, name);
+
+    return entry != NULL ? (struct symbol_header *) entry->data : NULL;
+}
+
+
+/**
+ * Find the header for \p name, creating and interning it if it does not
+ * exist yet.  The name is hashed only once for both the lookup and the
+ * insertion.  Returns \c NULL on allocation failure.
+ */
+static struct symbol_header *
+find_or_create_symbol_header(struct _mesa_symbol_table *table,
+                             const char *name)
+{
+    const uint32_t hash = _mesa_hash_string(name);
+    struct hash_entry *const entry =
+       _mesa_hash_table_search_pre_hashed(table->ht, hash, name);
+    struct symbol_header *hdr;
+
+    if (entry != NULL)
+       return (struct symbol_header *) entry->data;
+
+    hdr = calloc(1, sizeof(*hdr));
+    if (hdr == NULL) {
+       _mesa_error_no_memory(__func__);
+       return NULL;
+    }
+
+    hdr->name = strdup(name);
+    if (hdr->name == NULL) {
+       free(hdr);
+       _mesa_error_no_memory(__func__);
+       return NULL;
+    }
+
+    _mesa_hash_table_insert_pre_hashed(table->ht, hash, hdr->name, hdr);
+    hdr->next = table->hdr;
+    table->hdr = hdr;
+
+    return hdr;
 }
 
 
@@ -253,28 +301,9 @@ _mesa_symbol_table_add_symbol(struct _mesa_symbol_table *table,
 
     check_symbol_table(table);
 
-    hdr = find_symbol(table, name);
-
-    check_symbol_table(table);
-
-    if (hdr == NULL) {
-       hdr = calloc(1, sizeof(*hdr));
-       if (hdr == NULL) {
-          _mesa_error_no_memory(__func__);
-          return -1;
-       }
-
-       hdr->name = strdup(name);
-       if (hdr->name == NULL) {
-          free(hdr);
-          _mesa_error_no_memory(__func__);
-          return -1;
-       }
-
-       hash_table_insert(table->ht, hdr, hdr->name);
-       hdr->next = table->hdr;
-       table->hdr = hdr;
-    }
+    hdr = find_or_create_symbol_header(table, name);
+    if (hdr == NULL)
+       return -1;
 
     check_symbol_table(table);
 
@@ -325,23 +354,9 @@ _mesa_symbol_table_add_global_symbol(struct _mesa_symbol_table *table,
 
     check_symbol_table(table);
 
-    hdr = find_symbol(table, name);
-
-    check_symbol_table(table);
-
-    if (hdr == NULL) {
-        hdr = calloc(1, sizeof(*hdr));
-        if (hdr == NULL) {
-           _mesa_error_no_memory(__func__);
-           return -1;
-        }
-
-        hdr->name = strdup(name);
-
-        hash_table_insert(table->ht, hdr, hdr->name);
-        hdr->next = table->hdr;
-        table->hdr = hdr;
-    }
+    hdr = find_or_create_symbol_header(table, name);
+    if (hdr == NULL)
+       return -1;
 
     check_symbol_table(table);
 
@@ -404,8 +419,8 @@ _mesa_symbol_table_ctor(void)
     struct _mesa_symbol_table *table = calloc(1, sizeof(*table));
 
     if (table != NULL) {
-       table->ht = hash_table_ctor(32, hash_table_string_hash,
-				   hash_table_string_compare);
+       table->ht = _mesa_hash_table_create(NULL, _mesa_key_hash_string,
+                                           _mesa_key_string_equal);
 
        _mesa_symbol_table_push_scope(table);
     }
@@ -430,6 +445,6 @@ _mesa_symbol_table_dtor(struct _mesa_symbol_table *table)
        free(hdr);
    }
 
-   hash_table_dtor(table->ht);
+   _mesa_hash_table_destroy(table->ht, NULL);
    free(table);
 }
@@ -31,6 +31,8 @@
 #include "main/context.h"
 
 #include "pipe/p_defines.h"
+#include "util/u_math.h"
+#include "util/u_startup_profile.h"
 #include "st_context.h"
 #include "st_atom.h"
 #include "st_program.h"
@@ -114,9 +116,52 @@ static const struct st_tracked_state *compute_atoms[] =
 };
 
 
+/*
+ * For each dirty bit, a bitmask of the atoms (by index in the atom
+ * lists above) whose dirty state contains that bit.  This lets
+ * st_validate_state() visit only the atoms matching the currently
+ * dirty state instead of testing the whole list on every draw.
+ */
+static uint64_t render_atoms_per_mesa_bit[32];
+static uint64_t render_atoms_per_st_bit[64];
+static uint64_t compute_atoms_per_mesa_bit[32];
+static uint64_t compute_atoms_per_st_bit[64];
+
+
+static void
+init_atom_bitmasks(const struct st_tracked_state **atoms, GLuint num_atoms,
+                   uint64_t *per_mesa_bit, uint64_t *per_st_bit)
+{
+   GLuint i, bit;
+
+   assert(num_atoms <= 64);
+
+   for (bit = 0; bit < 32; bit++)
+      per_mesa_bit[bit] = 0;
+   for (bit = 0; bit < 64; bit++)
+      per_st_bit[bit] = 0;
+
+   for (i = 0; i < num_atoms; i++) {
+      GLbitfield mesa = atoms[i]->dirty.mesa;
+      uint64_t stf = atoms[i]->dirty.st;
+
+      while (mesa)
+         per_mesa_bit[u_bit_scan(&mesa)] |= 1ull << i;
+      while (stf)
+         per_st_bit[u_bit_scan64(&stf)] |= 1ull << i;
+   }
+}
+
+
 void st_init_atoms( struct st_context *st )
 {
-   /* no-op */
+   /* The tables only depend on the static atom lists, so recomputing
+    * them for every context just writes the same values again.
+    */
+   init_atom_bitmasks(render_atoms, ARRAY_SIZE(render_atoms),
+                      render_atoms_per_mesa_bit, render_atoms_per_st_bit);
+   init_atom_bitmasks(compute_atoms, ARRAY_SIZE(compute_atoms),
+                      compute_atoms_per_mesa_bit, compute_atoms_per_st_bit);
 }
 
 
@@ -201,22 +246,37 @@ static void check_attrib_edgeflag(struct st_context *st)
 
 void st_validate_state( struct st_context *st, enum st_pipeline pipeline )
 {
+   /* The first validation does all the deferred first-draw work, so it's
+    * a startup phase of its own.
+    */
+   static boolean first_validation = TRUE;
+   int64_t profile_start = 0;
    const struct st_tracked_state **atoms;
    struct st_state_flags *state;
+   const uint64_t *atoms_per_mesa_bit, *atoms_per_st_bit;
    GLuint num_atoms;
    GLuint i;
 
+   if (unlikely(first_validation)) {
+      first_validation = FALSE;
+      profile_start = u_startup_profile_begin();
+   }
+
    /* Get pipeline state. */
    switch (pipeline) {
     case ST_PIPELINE_RENDER:
       atoms     = render_atoms;
       num_atoms = ARRAY_SIZE(render_atoms);
       state     = &st->dirty;
+      atoms_per_mesa_bit = render_atoms_per_mesa_bit;
+      atoms_per_st_bit   = render_atoms_per_st_bit;
       break;
    case ST_PIPELINE_COMPUTE:
       atoms     = compute_atoms;
       num_atoms = ARRAY_SIZE(compute_atoms);
       state     = &st->dirty_cp;
+      atoms_per_mesa_bit = compute_atoms_per_mesa_bit;
+      atoms_per_st_bit   = compute_atoms_per_st_bit;
       break;
    default:
       unreachable("Invalid pipeline specified");
@@ -235,8 +295,10 @@ void st_validate_state( struct st_context *st, enum st_pipeline pipeline )
       st_manager_validate_framebuffers(st);
    }
 
-   if (state->st == 0 && state->mesa == 0)
+   if (state->st == 0 && state->mesa == 0) {
+      u_startup_profile_end("st_validate_state_first", profile_start);
       return;
+   }
 
    /*printf("%s %x/%x\n", __func__, state->mesa, state->st);*/
 
@@ -284,11 +346,25 @@ void st_validate_state( struct st_context *st, enum st_pipeline pipeline )
 
    }
    else {
-      for (i = 0; i < num_atoms; i++) {
-	 if (check_state(state, &atoms[i]->dirty))
-	    atoms[i]->update( st );
+      uint64_t pending = 0;
+      GLbitfield mesa = state->mesa;
+      uint64_t stf = state->st;
+
+      while (mesa)
+         pending |= atoms_per_mesa_bit[u_bit_scan(&mesa)];
+      while (stf)
+         pending |= atoms_per_st_bit[u_bit_scan64(&stf)];
+
+      /* An atom's index is its bit position, so scanning from the low
+       * bit up updates the atoms in their original list order.
+       */
+      while (pending) {
+         i = u_bit_scan64(&pending);
+         atoms[i]->update( st );
       }
    }
 
    memset(state, 0, sizeof(*state));
+
+   u_startup_profile_end("st_validate_state_first", profile_start);
 }
@@ -427,7 +427,8 @@ static void init_velement_lowered(struct st_context *st,
  * Set up for drawing interleaved arrays that all live in one VBO
  * or all live in user space.
  * \param vbuffer  returns vertex buffer info
- * \param velements  returns vertex element info
+ * \param velements  returns vertex element info, or NULL to only set up
+ *                   the vertex buffer (the caller has cached elements)
  */
 static boolean
 setup_interleaved_attribs(struct st_context *st,
@@ -481,32 +482,34 @@ setup_interleaved_attribs(struct st_context *st,
    /* are the arrays in user space? */
    usingVBO = _mesa_is_bufferobj(bufobj);
 
-   attr_idx = 0;
-   for (attr = 0; attr < vpv->num_inputs; attr++) {
-      const struct gl_client_array *array;
-      unsigned src_offset;
-      unsigned src_format;
+   if (velements) {
+      attr_idx = 0;
+      for (attr = 0; attr < vpv->num_inputs; attr++) {
+         const struct gl_client_array *array;
+         unsigned src_offset;
+         unsigned src_format;
 
-      array = get_client_array(vp, arrays, attr);
-      if (!array)
-         continue;
+         array = get_client_array(vp, arrays, attr);
+         if (!array)
+            continue;
 
-      src_offset = (unsigned) (array->Ptr - low_addr);
-      assert(array->_ElementSize ==
-             _mesa_bytes_per_vertex_attrib(array->Size, array->Type));
+         src_offset = (unsigned) (array->Ptr - low_addr);
+         assert(array->_ElementSize ==
+                _mesa_bytes_per_vertex_attrib(array->Size, array->Type));
 
-      src_format = st_pipe_vertex_format(array->Type,
-                                         array->Size,
-                                         array->Format,
-                                         array->Normalized,
-                                         array->Integer);
+         src_format = st_pipe_vertex_format(array->Type,
+                                            array->Size,
+                                            array->Format,
+                                            array->Normalized,
+                                            array->Integer);
 
-      init_velement_lowered(st, velements, src_offset, src_format,
-                            array->InstanceDivisor, 0,
-                            array->Size, array->Doubles, &attr_idx);
-   }
+         init_velement_lowered(st, velements, src_offset, src_format,
+                               array->InstanceDivisor, 0,
+                               array->Size, array->Doubles, &attr_idx);
+      }
 
-   *num_velements = attr_idx;
+      *num_velements = attr_idx;
+   }
 
    /*
     * Return the vbuffer info and setup user-space attrib info, if needed.
@@ -545,7 +548,8 @@ setup_interleaved_attribs(struct st_context *st,
  * Set up a separate pipe_vertex_buffer and pipe_vertex_element for each
  * vertex attribute.
  * \param vbuffer  returns vertex buffer info
- * \param velements  returns vertex element info
+ * \param velements  returns vertex element info, or NULL to only set up
+ *                   the vertex buffers (the caller has cached elements)
  */
 static boolean
 setup_non_interleaved_attribs(struct st_context *st,
@@ -617,31 +621,35 @@ setup_non_interleaved_attribs(struct st_context *st,
       /* common-case setup */
       vbuffer[attr].stride = stride; /* in bytes */
 
-      src_format = st_pipe_vertex_format(array->Type,
-                                         array->Size,
-                                         array->Format,
-                                         array->Normalized,
-                                         array->Integer);
-
-      init_velement_lowered(st, velements, 0, src_format,
-                            array->InstanceDivisor, attr,
-                            array->Size, array->Doubles, &attr_idx);
+      if (velements) {
+         src_format = st_pipe_vertex_format(array->Type,
+                                            array->Size,
+                                            array->Format,
+                                            array->Normalized,
+                                            array->Integer);
 
+         init_velement_lowered(st, velements, 0, src_format,
+                               array->InstanceDivisor, attr,
+                               array->Size, array->Doubles, &attr_idx);
+      }
    }
 
-   *num_velements = attr_idx;
+   if (velements)
+      *num_velements = attr_idx;
    return TRUE;
 }
 
 static void update_array(struct st_context *st)
 {
    struct gl_context *ctx = st->ctx;
+   const struct gl_vertex_array_object *vao = ctx->Array.VAO;
    const struct gl_client_array **arrays = ctx->Array._DrawArrays;
    const struct st_vertex_program *vp;
    const struct st_vp_variant *vpv;
    struct pipe_vertex_buffer vbuffer[PIPE_MAX_SHADER_INPUTS];
    struct pipe_vertex_element velements[PIPE_MAX_ATTRIBS];
    unsigned num_vbuffers, num_velements;
+   GLboolean interleaved, cache_hit;
 
    st->vertex_array_out_of_memory = FALSE;
 
@@ -653,13 +661,35 @@ static void update_array(struct st_context *st)
    vp = st->vp;
    vpv = st->vp_variant;
 
-   memset(velements, 0, sizeof(struct pipe_vertex_element) * vpv->num_inputs);
+   /* The vertex elements derived below only depend on the state covered
+    * by the cache key.  If nothing changed, skip the derivation and just
+    * rebuild the buffer bindings, which may point at new buffer storage
+    * (e.g. after glBufferData).
+    */
+   cache_hit = st->velems_cache.valid &&
+               st->velems_cache.vao == vao &&
+               st->velems_cache.vao_serial == vao->StateSerial &&
+               st->velems_cache.vpv == vpv &&
+               st->velems_cache.arrays == arrays &&
+               ctx->Array.DrawMethod == DRAW_ARRAYS;
+
+   if (cache_hit) {
+      interleaved = st->velems_cache.interleaved;
+      num_velements = st->velems_cache.num_velements;
+   }
+   else {
+      interleaved = is_interleaved_arrays(vp, vpv, arrays);
+      memset(velements, 0,
+             sizeof(struct pipe_vertex_element) * vpv->num_inputs);
+   }
 
    /*
     * Setup the vbuffer[] and velements[] arrays.
     */
-   if (is_interleaved_arrays(vp, vpv, arrays)) {
-      if (!setup_interleaved_attribs(st, vp, vpv, arrays, vbuffer, velements, &num_velements)) {
+   if (interleaved) {
+      if (!setup_interleaved_attribs(st, vp, vpv, arrays, vbuffer,
+                                     cache_hit ? NULL : velements,
+                                     cache_hit ? NULL : &num_velements)) {
          st->vertex_array_out_of_memory = TRUE;
          return;
       }
@@ -670,7 +700,8 @@ static void update_array(struct st_context *st)
    }
    else {
       if (!setup_non_interleaved_attribs(st, vp, vpv, arrays, vbuffer,
-                                         velements, &num_velements)) {
+                                         cache_hit ? NULL : velements,
+                                         cache_hit ? NULL : &num_velements)) {
          st->vertex_array_out_of_memory = TRUE;
          return;
       }
@@ -678,6 +709,34 @@ static void update_array(struct st_context *st)
       num_vbuffers = vpv->num_inputs;
    }
 
+   if (!cache_hit) {
+      /* Remember the new layout if it only depends on VAO state.
+       * User-space arrays and current-value fallbacks have per-draw
+       * pointers and formats which the cache key cannot see, and the
+       * vbo module's begin/end and display list paths use their own
+       * arrays which change behind the bound VAO's back.
+       */
+      GLboolean cacheable = ctx->Array.DrawMethod == DRAW_ARRAYS;
+      unsigned i;
+
+      for (i = 0; i < num_vbuffers && cacheable; i++) {
+         if (vbuffer[i].user_buffer)
+            cacheable = GL_FALSE;
+      }
+
+      st->velems_cache.valid = cacheable;
+      if (cacheable) {
+         st->velems_cache.interleaved = interleaved;
+         st->velems_cache.vao = vao;
+         st->velems_cache.vao_serial = vao->StateSerial;
+         st->velems_cache.vpv = vpv;
+         st->velems_cache.arrays = arrays;
+         st->velems_cache.num_velements = num_velements;
+         memcpy(st->velems_cache.velements, velements,
+                sizeof(struct pipe_vertex_element) * num_velements);
+      }
+   }
+
    cso_set_vertex_buffers(st->cso_context, 0, num_vbuffers, vbuffer);
    if (st->last_num_vbuffers > num_vbuffers) {
       /* Unbind remaining buffers, if any. */
@@ -685,7 +744,9 @@ static void update_array(struct st_context *st)
                              st->last_num_vbuffers - num_vbuffers, NULL);
    }
    st->last_num_vbuffers = num_vbuffers;
-   cso_set_vertex_elements(st->cso_context, num_velements, velements);
+   cso_set_vertex_elements(st->cso_context, num_velements,
+                           cache_hit ? st->velems_cache.velements
+                                     : velements);
 }
 
 
@@ -70,12 +70,17 @@ void st_upload_constants( struct st_context *st,
       unsigned c;
 
       for (c = 0; c < MAX_NUM_FRAGMENT_CONSTANTS_ATI; c++) {
+         const GLfloat *value;
+
          if (ati_fs->LocalConstDef & (1 << c))
-            memcpy(params->ParameterValues[c],
-                   ati_fs->Constants[c], sizeof(GLfloat) * 4);
+            value = ati_fs->Constants[c];
          else
-            memcpy(params->ParameterValues[c],
-                   st->ctx->ATIFragmentShader.GlobalConstants[c], sizeof(GLfloat) * 4);
+            value = st->ctx->ATIFragmentShader.GlobalConstants[c];
+
+         if (memcmp(params->ParameterValues[c], value, sizeof(GLfloat) * 4)) {
+            memcpy(params->ParameterValues[c], value, sizeof(GLfloat) * 4);
+            _mesa_parameter_list_mark_dirty(params, c, 1);
+         }
       }
    }
 
@@ -83,6 +88,7 @@ void st_upload_constants( struct st_context *st,
    if (params && params->NumParameters) {
       struct pipe_constant_buffer cb;
       const uint paramBytes = params->NumParameters * sizeof(GLfloat) * 4;
+      struct st_constant_state *cst = &st->state.constants[shader_type];
 
       /* Update the constants which come from fixed-function state, such as
        * transformation matrices, fog factors, etc.  The rest of the values in
@@ -92,6 +98,19 @@ void st_upload_constants( struct st_context *st,
       if (params->StateFlags)
          _mesa_load_state_parameters(st->ctx, params);
 
+      /* If the same parameter list still holds the values that were last
+       * uploaded, keep the current binding.  The generation only moves
+       * when values in the list are really changed, so this catches
+       * untouched uniforms as well as state parameters which were
+       * recomputed to the same values; the uploader never rewrites a
+       * range it handed out earlier, so the bound range still contains
+       * exactly this data.
+       */
+      if (cst->ptr == params->ParameterValues &&
+          cst->size == paramBytes &&
+          cst->generation == params->Generation)
+         return;
+
       /* We always need to get a new buffer, to keep the drivers simple and
        * avoid gratuitous rendering synchronization.
        * Let's use a user buffer to avoid an unnecessary copy.
@@ -120,8 +139,9 @@ void st_upload_constants( struct st_context *st,
       cso_set_constant_buffer(st->cso_context, shader_type, 0, &cb);
       pipe_resource_reference(&cb.buffer, NULL);
 
-      st->state.constants[shader_type].ptr = params->ParameterValues;
-      st->state.constants[shader_type].size = paramBytes;
+      cst->ptr = params->ParameterValues;
+      cst->size = paramBytes;
+      cst->generation = params->Generation;
    }
    else if (st->state.constants[shader_type].ptr) {
       /* Unbind. */
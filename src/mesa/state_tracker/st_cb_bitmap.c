@@ -53,8 +53,10 @@
 #include "util/u_inlines.h"
 #include "util/u_simple_shaders.h"
 #include "util/u_upload_mgr.h"
+#include "util/u_hash.h"
 #include "program/prog_instruction.h"
 #include "cso_cache/cso_context.h"
+#include "cso_cache/cso_hash.h"
 
 
 /**
@@ -71,36 +73,54 @@
 
 
 /**
- * The bitmap cache attempts to accumulate multiple glBitmap calls in a
- * buffer which is then rendered en mass upon a flush, state change, etc.
- * A wide, short buffer is used to target the common case of a series
- * of glBitmap calls being used to draw text.
+ * The bitmap cache collects the images of incoming glBitmap calls in a
+ * persistent texture atlas, keyed by a hash of the bitmap contents, so
+ * apps which draw the same glyphs over and over (text, markers) upload
+ * each image only once.  The quads referencing the atlas are batched up
+ * and rendered en mass upon a flush, state change, etc.
  */
 static GLboolean UseBitmapCache = GL_TRUE;
 
 
-#define BITMAP_CACHE_WIDTH  512
-#define BITMAP_CACHE_HEIGHT 32
+#define BITMAP_ATLAS_SIZE      512
+#define BITMAP_ATLAS_MAX_GLYPH 128
 
-struct bitmap_cache
+struct bitmap_glyph
 {
-   /** Window pos to render the cached image */
-   GLint xpos, ypos;
-   /** Bounds of region used in window coords */
-   GLint xmin, ymin, xmax, ymax;
+   /** Position in the atlas texture */
+   ushort x, y;
+   ushort width, height;
 
-   GLfloat color[4];
+   /** Unpacked width*height image, kept so the atlas texture can be
+    * rebuilt (an "on" bit is 0x0, an "off" bit is 0xff, as below).
+    */
+   ubyte *bits;
+};
 
-   /** Bitmap's Z position */
-   GLfloat zpos;
+struct bitmap_quad
+{
+   /** Window coords of the quad and texel coords of its glyph */
+   float x0, y0, x1, y1;
+   float s0, t0, s1, t1;
+};
+
+struct bitmap_cache
+{
+   /** bitmap_glyphs, keyed by a hash of the bitmap contents */
+   struct cso_hash *glyphs;
 
+   /** The atlas texture; rebuilt at flush time when glyphs were added */
    struct pipe_resource *texture;
-   struct pipe_transfer *trans;
+   GLboolean dirty;
 
-   GLboolean empty;
+   /** Shelf-packing position for the next glyph */
+   ushort pack_x, pack_y, row_height;
 
-   /** An I8 texture image: */
-   ubyte *buffer;
+   /** Pending quads, all drawn with one color/Z upon flush */
+   struct bitmap_quad *quads;
+   unsigned num_quads, max_quads;
+   GLfloat color[4];
+   GLfloat zpos;
 };
 
 
@@ -351,72 +371,179 @@ draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
 }
 
 
-static void
-reset_cache(struct st_context *st)
+/**
+ * Unpack a bitmap image into a tightly packed glyph image, expanding
+ * bits into texels as in unpack_bitmap() above.
+ * \return  malloc'd image or NULL
+ */
+static ubyte *
+unpack_glyph(struct gl_context *ctx, GLsizei width, GLsizei height,
+             const struct gl_pixelstore_attrib *unpack,
+             const GLubyte *bitmap)
 {
-   struct bitmap_cache *cache = st->bitmap.cache;
+   struct st_context *st = st_context(ctx);
+   ubyte *bits;
 
-   /*memset(cache->buffer, 0xff, sizeof(cache->buffer));*/
-   cache->empty = GL_TRUE;
+   bits = malloc(width * height);
+   if (!bits)
+      return NULL;
 
-   cache->xmin = 1000000;
-   cache->xmax = -1000000;
-   cache->ymin = 1000000;
-   cache->ymax = -1000000;
+   /* PBO source... */
+   bitmap = _mesa_map_pbo_source(ctx, unpack, bitmap);
+   if (!bitmap) {
+      free(bits);
+      return NULL;
+   }
 
-   assert(!cache->texture);
+   memset(bits, 0xff, width * height);
+   unpack_bitmap(st, 0, 0, width, height, unpack, bitmap, bits, width);
 
-   /* allocate a new texture */
-   cache->texture = st_texture_create(st, st->internal_target,
-                                      st->bitmap.tex_format, 0,
-                                      BITMAP_CACHE_WIDTH, BITMAP_CACHE_HEIGHT,
-                                      1, 1, 0,
-				      PIPE_BIND_SAMPLER_VIEW);
+   _mesa_unmap_pbo_source(ctx, unpack);
+
+   return bits;
 }
 
 
-/** Print bitmap image to stdout (debug) */
+/**
+ * Free all glyphs and reset the packing position, so that the atlas
+ * starts over empty.  Any pending quads must have been flushed already.
+ */
 static void
-print_cache(const struct bitmap_cache *cache)
+evict_glyphs(struct st_context *st)
 {
-   int i, j, k;
-
-   for (i = 0; i < BITMAP_CACHE_HEIGHT; i++) {
-      k = BITMAP_CACHE_WIDTH * (BITMAP_CACHE_HEIGHT - i - 1);
-      for (j = 0; j < BITMAP_CACHE_WIDTH; j++) {
-         if (cache->buffer[k])
-            printf("X");
-         else
-            printf(" ");
-         k++;
+   struct bitmap_cache *cache = st->bitmap.cache;
+   struct cso_hash_iter iter = cso_hash_first_node(cache->glyphs);
+
+   while (!cso_hash_iter_is_null(iter)) {
+      struct bitmap_glyph *g = (struct bitmap_glyph *) cso_hash_iter_data(iter);
+      iter = cso_hash_erase(cache->glyphs, iter);
+      free(g->bits);
+      free(g);
+   }
+
+   cache->pack_x = 0;
+   cache->pack_y = 0;
+   cache->row_height = 0;
+   cache->dirty = GL_TRUE;
+}
+
+
+/**
+ * Look up a glyph with the given image in the atlas, adding it if it
+ * isn't there yet.  Takes ownership of 'bits'.
+ * \return  the glyph, or NULL on out-of-memory
+ */
+static struct bitmap_glyph *
+find_or_insert_glyph(struct st_context *st, GLsizei width, GLsizei height,
+                     ubyte *bits)
+{
+   struct bitmap_cache *cache = st->bitmap.cache;
+   const unsigned key = util_hash_crc32(bits, width * height);
+   struct bitmap_glyph *g;
+   struct cso_hash_iter iter;
+
+   iter = cso_hash_find(cache->glyphs, key);
+   while (!cso_hash_iter_is_null(iter) && cso_hash_iter_key(iter) == key) {
+      g = (struct bitmap_glyph *) cso_hash_iter_data(iter);
+      if (g->width == width && g->height == height &&
+          memcmp(g->bits, bits, width * height) == 0) {
+         free(bits);
+         return g;
       }
-      printf("\n");
+      iter = cso_hash_iter_next(iter);
+   }
+
+   /* shelf-pack the new glyph into the atlas */
+   if (cache->pack_x + width > BITMAP_ATLAS_SIZE) {
+      /* advance to the next row */
+      cache->pack_y += cache->row_height;
+      cache->pack_x = 0;
+      cache->row_height = 0;
+   }
+   if (cache->pack_y + height > BITMAP_ATLAS_SIZE) {
+      /* The atlas is full.  Draw the pending quads, which reference the
+       * current glyph positions, then start over with an empty atlas.
+       */
+      st_flush_bitmap_cache(st);
+      evict_glyphs(st);
    }
+
+   g = ST_CALLOC_STRUCT(bitmap_glyph);
+   if (!g) {
+      free(bits);
+      return NULL;
+   }
+
+   g->x = cache->pack_x;
+   g->y = cache->pack_y;
+   g->width = width;
+   g->height = height;
+   g->bits = bits;
+
+   cache->pack_x += width;
+   cache->row_height = MAX2(cache->row_height, height);
+
+   cso_hash_insert(cache->glyphs, key, g);
+   cache->dirty = GL_TRUE;
+
+   return g;
 }
 
 
 /**
- * Create gallium pipe_transfer object for the bitmap cache.
+ * (Re)create the atlas texture and write all glyph images into it.
+ * We always create a new texture rather than writing to the old one so
+ * that we never modify texels which earlier, still in-flight draws may
+ * be reading from.
  */
 static void
-create_cache_trans(struct st_context *st)
+update_atlas_texture(struct st_context *st)
 {
    struct pipe_context *pipe = st->pipe;
    struct bitmap_cache *cache = st->bitmap.cache;
+   struct pipe_transfer *transfer;
+   struct cso_hash_iter iter;
+   ubyte *dest;
+
+   pipe_resource_reference(&cache->texture, NULL);
 
-   if (cache->trans)
+   cache->texture = st_texture_create(st, st->internal_target,
+                                      st->bitmap.tex_format, 0,
+                                      BITMAP_ATLAS_SIZE, BITMAP_ATLAS_SIZE,
+                                      1, 1, 0,
+                                      PIPE_BIND_SAMPLER_VIEW);
+   if (!cache->texture)
       return;
 
-   /* Map the texture transfer.
-    * Subsequent glBitmap calls will write into the texture image.
-    */
-   cache->buffer = pipe_transfer_map(pipe, cache->texture, 0, 0,
-                                     PIPE_TRANSFER_WRITE, 0, 0,
-                                     BITMAP_CACHE_WIDTH,
-                                     BITMAP_CACHE_HEIGHT, &cache->trans);
+   dest = pipe_transfer_map(pipe, cache->texture, 0, 0,
+                            PIPE_TRANSFER_WRITE, 0, 0,
+                            BITMAP_ATLAS_SIZE, BITMAP_ATLAS_SIZE, &transfer);
+   if (!dest) {
+      pipe_resource_reference(&cache->texture, NULL);
+      return;
+   }
 
    /* init image to all 0xff */
-   memset(cache->buffer, 0xff, cache->trans->stride * BITMAP_CACHE_HEIGHT);
+   memset(dest, 0xff, transfer->stride * BITMAP_ATLAS_SIZE);
+
+   iter = cso_hash_first_node(cache->glyphs);
+   while (!cso_hash_iter_is_null(iter)) {
+      const struct bitmap_glyph *g =
+         (const struct bitmap_glyph *) cso_hash_iter_data(iter);
+      ubyte *gdest = dest + g->y * transfer->stride + g->x;
+      uint i;
+
+      for (i = 0; i < g->height; i++) {
+         memcpy(gdest, g->bits + i * g->width, g->width);
+         gdest += transfer->stride;
+      }
+
+      iter = cso_hash_iter_next(iter);
+   }
+
+   pipe_transfer_unmap(pipe, transfer);
+
+   cache->dirty = GL_FALSE;
 }
 
 
@@ -427,48 +554,127 @@ void
 st_flush_bitmap_cache(struct st_context *st)
 {
    struct bitmap_cache *cache = st->bitmap.cache;
+   struct gl_context *ctx = st->ctx;
+   struct pipe_sampler_view *sv;
+   struct st_util_vertex *verts;
+   struct pipe_vertex_buffer vb = {0};
+   float clip_x_scale, clip_y_scale, coord_scale, z;
+   unsigned num_verts, i;
 
-   if (cache && !cache->empty) {
-      struct pipe_context *pipe = st->pipe;
-      struct pipe_sampler_view *sv;
+   if (!cache || !cache->num_quads)
+      return;
 
-      assert(cache->xmin <= cache->xmax);
+   if (cache->dirty)
+      update_atlas_texture(st);
 
-      if (0)
-         printf("flush bitmap, size %d x %d  at %d, %d\n",
-                cache->xmax - cache->xmin,
-                cache->ymax - cache->ymin,
-                cache->xpos, cache->ypos);
+   sv = cache->texture
+      ? st_create_texture_sampler_view(st->pipe, cache->texture) : NULL;
+   if (!sv) {
+      cache->num_quads = 0;
+      return;
+   }
 
-      /* The texture transfer has been mapped until now.
-       * So unmap and release the texture transfer before drawing.
-       */
-      if (cache->trans && cache->buffer) {
-         if (0)
-            print_cache(cache);
-         pipe_transfer_unmap(pipe, cache->trans);
-         cache->buffer = NULL;
-         cache->trans = NULL;
-      }
+   setup_render_state(ctx, sv, cache->color, false);
 
-      sv = st_create_texture_sampler_view(st->pipe, cache->texture);
-      if (sv) {
-         draw_bitmap_quad(st->ctx,
-                          cache->xpos,
-                          cache->ypos,
-                          cache->zpos,
-                          BITMAP_CACHE_WIDTH, BITMAP_CACHE_HEIGHT,
-                          sv,
-                          cache->color);
+   clip_x_scale = 2.0f / st->state.framebuffer.width;
+   clip_y_scale = 2.0f / st->state.framebuffer.height;
 
-         pipe_sampler_view_reference(&sv, NULL);
+   /* the bitmap sampler uses normalized coords for 2D targets */
+   coord_scale = st->internal_target == PIPE_TEXTURE_2D
+      ? 1.0f / BITMAP_ATLAS_SIZE : 1.0f;
+
+   /* convert Z from [0,1] to [-1,-1] to match viewport Z scale/bias */
+   z = cache->zpos * 2.0f - 1.0f;
+
+   num_verts = cache->num_quads * 4;
+
+   vb.stride = sizeof(struct st_util_vertex);
+
+   u_upload_alloc(st->uploader, 0,
+                  num_verts * sizeof(struct st_util_vertex), 4,
+                  &vb.buffer_offset, &vb.buffer, (void **) &verts);
+
+   if (verts) {
+      /* build quads vertex data */
+      for (i = 0; i < cache->num_quads; i++) {
+         const struct bitmap_quad *q = &cache->quads[i];
+         const float clip_x0 = q->x0 * clip_x_scale - 1.0f;
+         const float clip_y0 = q->y0 * clip_y_scale - 1.0f;
+         const float clip_x1 = q->x1 * clip_x_scale - 1.0f;
+         const float clip_y1 = q->y1 * clip_y_scale - 1.0f;
+         const float s0 = q->s0 * coord_scale;
+         const float t0 = q->t0 * coord_scale;
+         const float s1 = q->s1 * coord_scale;
+         const float t1 = q->t1 * coord_scale;
+
+         /* lower-left corner */
+         verts->x = clip_x0;
+         verts->y = clip_y0;
+         verts->z = z;
+         verts->r = cache->color[0];
+         verts->g = cache->color[1];
+         verts->b = cache->color[2];
+         verts->a = cache->color[3];
+         verts->s = s0;
+         verts->t = t0;
+         verts++;
+
+         /* lower-right corner */
+         verts->x = clip_x1;
+         verts->y = clip_y0;
+         verts->z = z;
+         verts->r = cache->color[0];
+         verts->g = cache->color[1];
+         verts->b = cache->color[2];
+         verts->a = cache->color[3];
+         verts->s = s1;
+         verts->t = t0;
+         verts++;
+
+         /* upper-right corner */
+         verts->x = clip_x1;
+         verts->y = clip_y1;
+         verts->z = z;
+         verts->r = cache->color[0];
+         verts->g = cache->color[1];
+         verts->b = cache->color[2];
+         verts->a = cache->color[3];
+         verts->s = s1;
+         verts->t = t1;
+         verts++;
+
+         /* upper-left corner */
+         verts->x = clip_x0;
+         verts->y = clip_y1;
+         verts->z = z;
+         verts->r = cache->color[0];
+         verts->g = cache->color[1];
+         verts->b = cache->color[2];
+         verts->a = cache->color[3];
+         verts->s = s0;
+         verts->t = t1;
+         verts++;
       }
 
-      /* release/free the texture */
-      pipe_resource_reference(&cache->texture, NULL);
+      u_upload_unmap(st->uploader);
+
+      cso_set_vertex_buffers(st->cso_context,
+                             cso_get_aux_vertex_buffer_slot(st->cso_context),
+                             1, &vb);
 
-      reset_cache(st);
+      cso_draw_arrays(st->cso_context, PIPE_PRIM_QUADS, 0, num_verts);
    }
+
+   restore_render_state(ctx);
+
+   pipe_resource_reference(&vb.buffer, NULL);
+
+   pipe_sampler_view_reference(&sv, NULL);
+
+   /* We uploaded modified constants, need to invalidate them. */
+   st->dirty.mesa |= _NEW_PROGRAM_CONSTANTS;
+
+   cache->num_quads = 0;
 }
 
 
@@ -484,64 +690,57 @@ accum_bitmap(struct gl_context *ctx,
 {
    struct st_context *st = ctx->st;
    struct bitmap_cache *cache = st->bitmap.cache;
-   int px = -999, py = -999;
    const GLfloat z = ctx->Current.RasterPos[2];
+   struct bitmap_glyph *g;
+   struct bitmap_quad *q;
+   ubyte *bits;
 
-   if (width > BITMAP_CACHE_WIDTH ||
-       height > BITMAP_CACHE_HEIGHT)
+   if (width > BITMAP_ATLAS_MAX_GLYPH ||
+       height > BITMAP_ATLAS_MAX_GLYPH)
       return GL_FALSE; /* too big to cache */
 
-   if (!cache->empty) {
-      px = x - cache->xpos;  /* pos in buffer */
-      py = y - cache->ypos;
-      if (px < 0 || px + width > BITMAP_CACHE_WIDTH ||
-          py < 0 || py + height > BITMAP_CACHE_HEIGHT ||
-          !TEST_EQ_4V(ctx->Current.RasterColor, cache->color) ||
-          ((fabs(z - cache->zpos) > Z_EPSILON))) {
-         /* This bitmap would extend beyond cache bounds, or the bitmap
-          * color is changing
-          * so flush and continue.
-          */
-         st_flush_bitmap_cache(st);
-      }
+   if (cache->num_quads &&
+       (!TEST_EQ_4V(ctx->Current.RasterColor, cache->color) ||
+        fabs(z - cache->zpos) > Z_EPSILON)) {
+      /* The bitmap color or Z is changing, so draw what we have so far.
+       * Note the FS may fetch the color from a constant, so one batch
+       * can only use a single color.
+       */
+      st_flush_bitmap_cache(st);
    }
 
-   if (cache->empty) {
-      /* Initialize.  Center bitmap vertically in the buffer. */
-      px = 0;
-      py = (BITMAP_CACHE_HEIGHT - height) / 2;
-      cache->xpos = x;
-      cache->ypos = y - py;
+   bits = unpack_glyph(ctx, width, height, unpack, bitmap);
+   if (!bits)
+      return GL_FALSE;
+
+   g = find_or_insert_glyph(st, width, height, bits);
+   if (!g)
+      return GL_FALSE;
+
+   if (cache->num_quads == 0) {
       cache->zpos = z;
-      cache->empty = GL_FALSE;
       COPY_4FV(cache->color, ctx->Current.RasterColor);
    }
 
-   assert(px != -999);
-   assert(py != -999);
-
-   if (x < cache->xmin)
-      cache->xmin = x;
-   if (y < cache->ymin)
-      cache->ymin = y;
-   if (x + width > cache->xmax)
-      cache->xmax = x + width;
-   if (y + height > cache->ymax)
-      cache->ymax = y + height;
-
-   /* create the transfer if needed */
-   create_cache_trans(st);
-
-   /* PBO source... */
-   bitmap = _mesa_map_pbo_source(ctx, unpack, bitmap);
-   if (!bitmap) {
-      return FALSE;
+   if (cache->num_quads >= cache->max_quads) {
+      const unsigned new_max = cache->max_quads ? cache->max_quads * 2 : 64;
+      struct bitmap_quad *quads =
+         realloc(cache->quads, new_max * sizeof(*quads));
+      if (!quads)
+         return GL_FALSE;
+      cache->quads = quads;
+      cache->max_quads = new_max;
    }
 
-   unpack_bitmap(st, px, py, width, height, unpack, bitmap,
-                 cache->buffer, BITMAP_CACHE_WIDTH);
-
-   _mesa_unmap_pbo_source(ctx, unpack);
+   q = &cache->quads[cache->num_quads++];
+   q->x0 = (float) x;
+   q->y0 = (float) y;
+   q->x1 = (float) (x + width);
+   q->y1 = (float) (y + height);
+   q->s0 = (float) g->x;
+   q->t0 = (float) g->y;
+   q->s1 = (float) (g->x + g->width);
+   q->t1 = (float) (g->y + g->height);
 
    return GL_TRUE; /* accumulated */
 }
@@ -564,6 +763,7 @@ init_bitmap_state(struct st_context *st)
 
    /* alloc bitmap cache object */
    st->bitmap.cache = ST_CALLOC_STRUCT(bitmap_cache);
+   st->bitmap.cache->glyphs = cso_hash_create();
 
    /* init sampler state once */
    memset(&st->bitmap.sampler, 0, sizeof(st->bitmap.sampler));
@@ -617,8 +817,6 @@ init_bitmap_state(struct st_context *st)
                                                           semantic_indexes,
                                                           FALSE);
    }
-
-   reset_cache(st);
 }
 
 
@@ -652,6 +850,9 @@ st_Bitmap(struct gl_context *ctx, GLint x, GLint y,
    if (UseBitmapCache && accum_bitmap(ctx, x, y, width, height, unpack, bitmap))
       return;
 
+   /* draw any cached quads first, so overlapping bitmaps land in order */
+   st_flush_bitmap_cache(st);
+
    pt = make_bitmap_texture(ctx, width, height, unpack, bitmap);
    if (pt) {
       struct pipe_sampler_view *sv =
@@ -818,7 +1019,6 @@ st_init_bitmap_functions(struct dd_function_table *functions)
 void
 st_destroy_bitmap(struct st_context *st)
 {
-   struct pipe_context *pipe = st->pipe;
    struct bitmap_cache *cache = st->bitmap.cache;
 
    if (st->bitmap.vs) {
@@ -827,11 +1027,11 @@ st_destroy_bitmap(struct st_context *st)
    }
 
    if (cache) {
-      if (cache->trans && cache->buffer) {
-         pipe_transfer_unmap(pipe, cache->trans);
-      }
-      pipe_resource_reference(&st->bitmap.cache->texture, NULL);
-      free(st->bitmap.cache);
+      evict_glyphs(st);
+      cso_hash_delete(cache->glyphs);
+      pipe_resource_reference(&cache->texture, NULL);
+      free(cache->quads);
+      free(cache);
       st->bitmap.cache = NULL;
    }
 }
@@ -82,6 +82,7 @@ st_bufferobj_free(struct gl_context *ctx, struct gl_buffer_object *obj)
 
    if (st_obj->buffer)
       pipe_resource_reference(&st_obj->buffer, NULL);
+   pipe_resource_reference(&st_obj->spare, NULL);
 
    _mesa_delete_buffer_object(ctx, obj);
 }
@@ -100,6 +101,7 @@ st_bufferobj_subdata(struct gl_context *ctx,
 		     GLsizeiptrARB size,
 		     const void * data, struct gl_buffer_object *obj)
 {
+   struct st_context *st = st_context(ctx);
    struct st_buffer_object *st_obj = st_buffer_object(obj);
 
    /* we may be called from VBO code, so double-check params here */
@@ -123,13 +125,65 @@ st_bufferobj_subdata(struct gl_context *ctx,
       return;
    }
 
+   /* If the whole buffer is overwritten, swap in fresh storage so the
+    * write never synchronizes against previous draws still reading the
+    * old contents (buffer renaming).  Drivers with
+    * PIPE_CAP_INVALIDATE_BUFFER already rename internally on the
+    * discard flags which pipe_buffer_write() passes, so leave those
+    * alone.  Restrict this to plain vertex/index buffers: for those the
+    * stale pipe_resource pointers left in the cso/driver state are
+    * refreshed by the dirty flag below resp. per draw, like after the
+    * reallocation in st_bufferobj_data().
+    */
+   if (offset == 0 && size == obj->Size &&
+       !st->has_invalidate_buffer &&
+       !obj->Immutable &&
+       st_obj->bind != 0 &&
+       !(st_obj->bind & ~(PIPE_BIND_VERTEX_BUFFER | PIPE_BIND_INDEX_BUFFER)) &&
+       !_mesa_check_disallowed_mapping(obj) &&
+       !obj->Mappings[MAP_INTERNAL].Pointer) {
+      struct pipe_resource *fresh = NULL;
+
+      /* The retired storage from the previous rename is the reuse pool:
+       * by now the GPU has typically caught up with it, while the
+       * current storage is the one the last draws still reference.
+       */
+      if (st_obj->spare) {
+         fresh = st_obj->spare;
+         st_obj->spare = NULL;
+      }
+      else {
+         struct pipe_resource buffer;
+
+         memset(&buffer, 0, sizeof buffer);
+         buffer.target = PIPE_BUFFER;
+         buffer.format = PIPE_FORMAT_R8_UNORM;
+         buffer.bind = st_obj->bind;
+         buffer.usage = st_obj->pipe_usage;
+         buffer.flags = st_obj->pipe_flags;
+         buffer.width0 = size;
+         buffer.height0 = 1;
+         buffer.depth0 = 1;
+         buffer.array_size = 1;
+
+         fresh = st->pipe->screen->resource_create(st->pipe->screen, &buffer);
+      }
+
+      if (fresh) {
+         st_obj->spare = st_obj->buffer;
+         st_obj->buffer = fresh;
+         st->dirty.st |= ST_NEW_VERTEX_ARRAYS;
+      }
+      /* else: keep the old buffer and take the synchronization below */
+   }
+
    /* Now that transfers are per-context, we don't have to figure out
     * flushing here.  Usually drivers won't need to flush in this case
     * even if the buffer is currently referenced by hardware - they
     * just queue the upload as dma rather than mapping the underlying
     * buffer directly.
     */
-   pipe_buffer_write(st_context(ctx)->pipe,
+   pipe_buffer_write(st->pipe,
 		     st_obj->buffer,
 		     offset, size, data);
 }
@@ -295,6 +349,12 @@ st_bufferobj_data(struct gl_context *ctx,
 
    pipe_resource_reference( &st_obj->buffer, NULL );
 
+   /* the spare matches the old size and flags, don't reuse it */
+   pipe_resource_reference( &st_obj->spare, NULL );
+   st_obj->bind = bind;
+   st_obj->pipe_usage = pipe_usage;
+   st_obj->pipe_flags = pipe_flags;
+
    if (ST_DEBUG & DEBUG_BUFFER) {
       debug_printf("Create buffer size %" PRId64 " bind 0x%x\n",
                    (int64_t) size, bind);
@@ -45,6 +45,14 @@ struct st_buffer_object
    struct gl_buffer_object Base;
    struct pipe_resource *buffer;     /* GPU storage */
    struct pipe_transfer *transfer[MAP_COUNT];
+
+   /* How "buffer" was created, so an identical one can be swapped in
+    * when a full overwrite would otherwise stall on GPU use.
+    */
+   unsigned bind;                    /* PIPE_BIND_x */
+   unsigned pipe_usage;              /* PIPE_USAGE_x */
+   unsigned pipe_flags;              /* PIPE_RESOURCE_FLAG_x */
+   struct pipe_resource *spare;      /* retired storage kept for renaming */
 };
 
 
@@ -235,7 +235,6 @@ st_program_string_notify( struct gl_context *ctx,
                                            struct gl_program *prog )
 {
    struct st_context *st = st_context(ctx);
-   gl_shader_stage stage = _mesa_program_enum_to_shader_stage(target);
 
    if (target == GL_FRAGMENT_PROGRAM_ARB) {
       struct st_fragment_program *stfp = (struct st_fragment_program *) prog;
@@ -320,9 +319,13 @@ st_program_string_notify( struct gl_context *ctx,
          st->dirty.st |= ST_NEW_FRAGMENT_PROGRAM;
    }
 
-   if (ST_DEBUG & DEBUG_PRECOMPILE ||
-       st->shader_has_one_variant[stage])
-      st_precompile_shader_variant(st, prog);
+   /* Build the default variant right away instead of waiting for the
+    * first draw.  The variant key is zeroed, which is what the vast
+    * majority of draws use; drivers which compile their shaders on a
+    * worker thread return from the CSO creation immediately, so the
+    * compile overlaps whatever the app does between link and draw.
+    */
+   st_precompile_shader_variant(st, prog);
 
    return GL_TRUE;
 }
@@ -67,6 +67,7 @@
 #include "util/u_surface.h"
 #include "util/u_sampler.h"
 #include "util/u_math.h"
+#include "util/u_memcpy.h"
 #include "util/u_box.h"
 #include "util/u_simple_shaders.h"
 #include "cso_cache/cso_context.h"
@@ -175,9 +176,12 @@ st_FreeTextureImageBuffer(struct gl_context *ctx,
                           struct gl_texture_image *texImage)
 {
    struct st_texture_image *stImage = st_texture_image(texImage);
+   struct st_texture_object *stObj = st_texture_object(texImage->TexObject);
 
    DBG("%s\n", __func__);
 
+   stObj->serial++;
+
    if (stImage->pt) {
       pipe_resource_reference(&stImage->pt, NULL);
    }
@@ -271,6 +275,15 @@ st_UnmapTextureImage(struct gl_context *ctx,
                                     itransfer->temp_stride,
                                     transfer->box.width, transfer->box.height);
       }
+      else if (util_format_is_s3tc(transfer->resource->format)) {
+         /* Keep a compressed representation: transcode to DXT. */
+         _mesa_transcode_etc2_to_dxt(itransfer->map, transfer->stride,
+                                     itransfer->temp_data,
+                                     itransfer->temp_stride,
+                                     transfer->box.width,
+                                     transfer->box.height,
+                                     texImage->TexFormat);
+      }
       else {
          _mesa_unpack_etc2_format(itransfer->map, transfer->stride,
                                   itransfer->temp_data, itransfer->temp_stride,
@@ -548,6 +561,8 @@ st_AllocTextureImageBuffer(struct gl_context *ctx,
 
    assert(!stImage->pt); /* xxx this might be wrong */
 
+   stObj->serial++;
+
    /* Look if the parent texture object has space for this image */
    if (stObj->pt &&
        level <= stObj->pt->last_level &&
@@ -1874,7 +1889,9 @@ st_TexSubImage(struct gl_context *ctx, GLuint dims,
    /* Upload pixels (just memcpy). */
    {
       const uint bytesPerRow = width * util_format_get_blocksize(src_format);
-      GLuint row, slice;
+      const GLint srcRowStride =
+         _mesa_image_row_stride(unpack, width, format, type);
+      GLuint slice;
 
       for (slice = 0; slice < (unsigned) depth; slice++) {
          if (gl_target == GL_TEXTURE_1D_ARRAY) {
@@ -1887,15 +1904,12 @@ st_TexSubImage(struct gl_context *ctx, GLuint dims,
             memcpy(map, src, bytesPerRow);
          }
          else {
-            ubyte *slice_map = map;
-
-            for (row = 0; row < (unsigned) height; row++) {
-               void *src = _mesa_image_address(dims, unpack, pixels,
-                                                 width, height, format,
-                                                 type, slice, row, 0);
-               memcpy(slice_map, src, bytesPerRow);
-               slice_map += transfer->stride;
-            }
+            const void *src = _mesa_image_address(dims, unpack, pixels,
+                                                    width, height, format,
+                                                    type, slice, 0, 0);
+            util_memcpy_rect(map, transfer->stride,
+                             (const uint8_t *) src, srcRowStride,
+                             bytesPerRow, height);
          }
          map += transfer->layer_stride;
       }
@@ -2177,9 +2191,10 @@ st_GetTexSubImage(struct gl_context * ctx,
       goto fallback;
    }
 
-   /* XXX Fallback to _mesa_GetTexImage_sw for depth-stencil formats
-    * due to an incomplete stencil blit implementation in some drivers. */
-   if (format == GL_DEPTH_STENCIL || format == GL_STENCIL_INDEX) {
+   /* Blitting the stencil component requires shader stencil export; on
+    * drivers without it, fall back to _mesa_GetTexImage_sw. */
+   if ((format == GL_DEPTH_STENCIL || format == GL_STENCIL_INDEX) &&
+       !st->has_stencil_export) {
       goto fallback;
    }
 
@@ -2219,7 +2234,8 @@ st_GetTexSubImage(struct gl_context * ctx,
       goto fallback;
    }
 
-   if (format == GL_DEPTH_COMPONENT || format == GL_DEPTH_STENCIL)
+   if (format == GL_DEPTH_COMPONENT || format == GL_DEPTH_STENCIL ||
+       format == GL_STENCIL_INDEX)
       bind |= PIPE_BIND_DEPTH_STENCIL;
    else
       bind |= PIPE_BIND_RENDER_TARGET;
@@ -2349,7 +2365,9 @@ st_GetTexSubImage(struct gl_context * ctx,
                                             ctx->Pack.SwapBytes, NULL)) {
       /* memcpy */
       const uint bytesPerRow = width * util_format_get_blocksize(dst_format);
-      GLuint row, slice;
+      const GLint dstRowStride =
+         _mesa_image_row_stride(&ctx->Pack, width, format, type);
+      GLuint slice;
 
       for (slice = 0; slice < depth; slice++) {
          if (gl_target == GL_TEXTURE_1D_ARRAY) {
@@ -2362,15 +2380,12 @@ st_GetTexSubImage(struct gl_context * ctx,
             memcpy(dest, map, bytesPerRow);
          }
          else {
-            ubyte *slice_map = map;
-
-            for (row = 0; row < height; row++) {
-               void *dest = _mesa_image_address3d(&ctx->Pack, pixels,
-                                                    width, height, format,
-                                                    type, slice, row, 0);
-               memcpy(dest, slice_map, bytesPerRow);
-               slice_map += tex_xfer->stride;
-            }
+            void *dest = _mesa_image_address3d(&ctx->Pack, pixels,
+                                                 width, height, format,
+                                                 type, slice, 0, 0);
+            util_memcpy_rect((uint8_t *) dest, dstRowStride,
+                             map, tex_xfer->stride,
+                             bytesPerRow, height);
          }
          map += tex_xfer->layer_stride;
       }
@@ -2820,6 +2835,18 @@ st_finalize_texture(struct gl_context *ctx,
 
    }
 
+   /* If no image buffers were added or freed since the last time we got
+    * here, the gallium texture is still consistent with the Mesa texture
+    * and walking all the images below would find nothing to do.  The
+    * last_level check catches sampler state changes which require more
+    * mipmap levels than the texture currently has.
+    */
+   if (stObj->validated_serial == stObj->serial &&
+       stObj->pt &&
+       !stObj->surface_based &&
+       stObj->pt->last_level >= stObj->lastLevel)
+      return GL_TRUE;
+
    firstImage = st_texture_image_const(_mesa_base_tex_image(&stObj->base));
    assert(firstImage);
 
@@ -2942,6 +2969,8 @@ st_finalize_texture(struct gl_context *ctx,
       }
    }
 
+   stObj->validated_serial = stObj->serial;
+
    return GL_TRUE;
 }
 
@@ -2968,6 +2997,8 @@ st_AllocTextureStorage(struct gl_context *ctx,
 
    assert(levels > 0);
 
+   stObj->serial++;
+
    /* Save the level=0 dimensions */
    stObj->width0 = width;
    stObj->height0 = height;
@@ -67,11 +67,13 @@
 #include "st_atom.h"
 #include "st_draw.h"
 #include "st_extensions.h"
+#include "st_frame_stats.h"
 #include "st_gen_mipmap.h"
 #include "st_program.h"
 #include "st_vdpau.h"
 #include "st_texture.h"
 #include "pipe/p_context.h"
+#include "util/u_gpu_markers.h"
 #include "util/u_inlines.h"
 #include "util/u_upload_mgr.h"
 #include "cso_cache/cso_context.h"
@@ -171,18 +173,22 @@ st_destroy_context_priv(struct st_context *st)
       }
    }
 
+   /* indexbuf_uploader and constbuf_uploader alias uploader */
    u_upload_destroy(st->uploader);
-   if (st->indexbuf_uploader) {
-      u_upload_destroy(st->indexbuf_uploader);
-   }
-   if (st->constbuf_uploader) {
-      u_upload_destroy(st->constbuf_uploader);
-   }
 
    /* free glDrawPixels cache data */
    free(st->drawpix_cache.image);
    pipe_resource_reference(&st->drawpix_cache.texture, NULL);
 
+   if (util_queue_is_initialized(&st->compile_queue))
+      util_queue_destroy(&st->compile_queue);
+
+   if (st->gpu_markers)
+      util_gpu_markers_destroy(st->gpu_markers);
+
+   if (st->frame_stats)
+      st_frame_stats_destroy(st->frame_stats);
+
    cso_destroy_context(st->cso_context);
    free( st );
 }
@@ -215,25 +221,53 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
    st->dirty_cp.mesa = ~0;
    st->dirty_cp.st = ~0;
 
-   /* Create upload manager for vertex data for glBitmap, glDrawPixels,
-    * glClear, etc.
+   /* Create the upload manager used to stream vertex data for glBitmap,
+    * glDrawPixels, glClear, etc. as well as index and constant data when
+    * the driver cannot take user pointers for those.  All of them share
+    * one ring so that the steady state keeps a single (persistently
+    * mapped, where supported) buffer warm instead of cycling through
+    * three smaller ones.
     */
-   st->uploader = u_upload_create(st->pipe, 65536, PIPE_BIND_VERTEX_BUFFER,
-                                  PIPE_USAGE_STREAM);
+   {
+      unsigned bind = PIPE_BIND_VERTEX_BUFFER;
 
-   if (!screen->get_param(screen, PIPE_CAP_USER_INDEX_BUFFERS)) {
-      st->indexbuf_uploader = u_upload_create(st->pipe, 128 * 1024,
-                                              PIPE_BIND_INDEX_BUFFER,
-                                              PIPE_USAGE_STREAM);
-   }
+      if (!screen->get_param(screen, PIPE_CAP_USER_INDEX_BUFFERS))
+         bind |= PIPE_BIND_INDEX_BUFFER;
+      if (!screen->get_param(screen, PIPE_CAP_USER_CONSTANT_BUFFERS))
+         bind |= PIPE_BIND_CONSTANT_BUFFER;
 
-   if (!screen->get_param(screen, PIPE_CAP_USER_CONSTANT_BUFFERS))
-      st->constbuf_uploader = u_upload_create(pipe, 128 * 1024,
-                                              PIPE_BIND_CONSTANT_BUFFER,
-                                              PIPE_USAGE_STREAM);
+      st->uploader = u_upload_create(st->pipe, 256 * 1024, bind,
+                                     PIPE_USAGE_STREAM);
+
+      /* The aliases stay NULL when the driver takes user pointers
+       * directly; the upload call sites check them for that.
+       */
+      if (bind & PIPE_BIND_INDEX_BUFFER)
+         st->indexbuf_uploader = st->uploader;
+      if (bind & PIPE_BIND_CONSTANT_BUFFER)
+         st->constbuf_uploader = st->uploader;
+   }
 
    st->cso_context = cso_create_context(pipe);
 
+   /* Attribute GPU time to GL_KHR_debug group markers; NULL when the
+    * driver has no timestamp queries.
+    */
+   if (debug_get_bool_option("GALLIUM_GPU_MARKERS", FALSE))
+      st->gpu_markers = util_gpu_markers_create(pipe);
+
+   /* Frame bracketing with pipeline-statistics queries for bottleneck
+    * triage; NULL when the driver lacks the queries.
+    */
+   if (debug_get_bool_option("ST_FRAME_STATS", FALSE))
+      st->frame_stats = st_frame_stats_create(st);
+
+   /* A small thread pool for parallelizing the per-stage work at link time.
+    * If thread creation fails, st_link_shader just runs everything on the
+    * application thread.
+    */
+   util_queue_init(&st->compile_queue, "stcomp", MESA_SHADER_STAGES, 4, 0);
+
    st_init_atoms( st );
    st_init_clear(st);
    st_init_draw( st );
@@ -293,6 +327,17 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
    st->has_etc2 = screen->is_format_supported(screen, PIPE_FORMAT_ETC2_RGB8,
                                               PIPE_TEXTURE_2D, 0,
                                               PIPE_BIND_SAMPLER_VIEW);
+   /* If ETC2 has to be emulated, keep a compressed representation by
+    * transcoding to DXT rather than decompressing to RGBA8888 where the
+    * hardware allows it.
+    */
+   st->transcode_etc = !st->has_etc2 &&
+      screen->is_format_supported(screen, PIPE_FORMAT_DXT1_SRGBA,
+                                  PIPE_TEXTURE_2D, 0,
+                                  PIPE_BIND_SAMPLER_VIEW) &&
+      screen->is_format_supported(screen, PIPE_FORMAT_DXT5_SRGBA,
+                                  PIPE_TEXTURE_2D, 0,
+                                  PIPE_BIND_SAMPLER_VIEW);
    st->prefer_blit_based_texture_transfer = screen->get_param(screen,
                               PIPE_CAP_PREFER_BLIT_BASED_TEXTURE_TRANSFER);
    st->force_persample_in_shader =
@@ -312,6 +357,8 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
       screen->get_param(screen, PIPE_CAP_TGSI_PACK_HALF_FLOAT);
    st->has_multi_draw_indirect =
       screen->get_param(screen, PIPE_CAP_MULTI_DRAW_INDIRECT);
+   st->has_invalidate_buffer =
+      screen->get_param(screen, PIPE_CAP_INVALIDATE_BUFFER);
 
    /* GL limits and extensions */
    st_init_limits(st->pipe->screen, &ctx->Const, &ctx->Extensions);
@@ -356,20 +403,6 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
          ctx->Const.ShaderCompilerOptions[i].EmitNoIndirectSampler = true;
    }
 
-   /* Set which shader types can be compiled at link time. */
-   st->shader_has_one_variant[MESA_SHADER_VERTEX] =
-         st->has_shareable_shaders &&
-         !st->clamp_vert_color_in_shader;
-
-   st->shader_has_one_variant[MESA_SHADER_FRAGMENT] =
-         st->has_shareable_shaders &&
-         !st->clamp_frag_color_in_shader &&
-         !st->force_persample_in_shader;
-
-   st->shader_has_one_variant[MESA_SHADER_TESS_CTRL] = st->has_shareable_shaders;
-   st->shader_has_one_variant[MESA_SHADER_TESS_EVAL] = st->has_shareable_shaders;
-   st->shader_has_one_variant[MESA_SHADER_GEOMETRY] = st->has_shareable_shaders;
-
    _mesa_compute_version(ctx);
 
    if (ctx->Version == 0) {
@@ -492,6 +525,24 @@ st_emit_string_marker(struct gl_context *ctx, const GLchar *string, GLsizei len)
    st->pipe->emit_string_marker(st->pipe, string, len);
 }
 
+static void
+st_push_debug_group(struct gl_context *ctx, const GLchar *message, GLsizei len)
+{
+   struct st_context *st = ctx->st;
+
+   if (st->gpu_markers)
+      util_gpu_markers_push(st->gpu_markers, message);
+}
+
+static void
+st_pop_debug_group(struct gl_context *ctx)
+{
+   struct st_context *st = ctx->st;
+
+   if (st->gpu_markers)
+      util_gpu_markers_pop(st->gpu_markers);
+}
+
 void st_init_driver_functions(struct pipe_screen *screen,
                               struct dd_function_table *functions)
 {
@@ -533,6 +584,9 @@ void st_init_driver_functions(struct pipe_screen *screen,
    if (screen->get_param(screen, PIPE_CAP_STRING_MARKER))
       functions->EmitStringMarker = st_emit_string_marker;
 
+   functions->PushDebugGroup = st_push_debug_group;
+   functions->PopDebugGroup = st_pop_debug_group;
+
    functions->Enable = st_Enable;
    functions->UpdateState = st_invalidate_state;
    functions->QueryMemoryInfo = st_query_memory_info;
@@ -32,6 +32,7 @@
 #include "pipe/p_state.h"
 #include "state_tracker/st_api.h"
 #include "main/fbobject.h"
+#include "util/u_queue.h"
 
 
 #ifdef __cplusplus
@@ -46,8 +47,11 @@ struct draw_stage;
 struct gen_mipmap_state;
 struct st_context;
 struct st_fragment_program;
+struct st_frame_stats;
 struct st_perf_monitor_group;
+struct st_vp_variant;
 struct u_upload_mgr;
+struct util_gpu_markers;
 
 
 /* gap  */
@@ -106,8 +110,21 @@ struct st_context
 
    struct pipe_context *pipe;
 
+   /* indexbuf_uploader and constbuf_uploader either alias uploader or are
+    * NULL when the driver takes user pointers for that data directly.
+    */
    struct u_upload_mgr *uploader, *indexbuf_uploader, *constbuf_uploader;
 
+   /* GPU time attribution for GL_KHR_debug groups, NULL unless enabled
+    * with GALLIUM_GPU_MARKERS=1
+    */
+   struct util_gpu_markers *gpu_markers;
+
+   /* Per-frame bottleneck classification, NULL unless enabled with
+    * ST_FRAME_STATS=1
+    */
+   struct st_frame_stats *frame_stats;
+
    struct draw_context *draw;  /**< For selection/feedback/rastpos only */
    struct draw_stage *feedback_stage;  /**< For GL_FEEDBACK rendermode */
    struct draw_stage *selection_stage;  /**< For GL_SELECT rendermode */
@@ -119,18 +136,14 @@ struct st_context
    boolean has_shader_model3;
    boolean has_etc1;
    boolean has_etc2;
+   /** emulate ETC2 by transcoding to DXT instead of decompressing */
+   boolean transcode_etc;
    boolean prefer_blit_based_texture_transfer;
    boolean force_persample_in_shader;
    boolean has_shareable_shaders;
    boolean has_half_float_packing;
    boolean has_multi_draw_indirect;
-
-   /**
-    * If a shader can be created when we get its source.
-    * This means it has only 1 variant, not counting glBitmap and
-    * glDrawPixels.
-    */
-   boolean shader_has_one_variant[MESA_SHADER_STAGES];
+   boolean has_invalidate_buffer;
 
    boolean needs_texcoord_semantic;
    boolean apply_texture_swizzle_to_border_color;
@@ -154,9 +167,14 @@ struct st_context
       struct pipe_sampler_view *sampler_views[PIPE_SHADER_TYPES][PIPE_MAX_SAMPLERS];
       GLuint num_sampler_views[PIPE_SHADER_TYPES];
       struct pipe_clip_state clip;
-      struct {
+      struct st_constant_state {
          void *ptr;
          unsigned size;
+         /* parameter list generation most recently uploaded, so that a
+          * no-op re-validation can keep the current binding instead of
+          * uploading the same data again
+          */
+         uint64_t generation;
       } constants[PIPE_SHADER_TYPES];
       struct pipe_framebuffer_state framebuffer;
       struct pipe_scissor_state scissor[PIPE_MAX_VIEWPORTS];
@@ -260,11 +278,33 @@ struct st_context
    /* The number of vertex buffers from the last call of validate_arrays. */
    unsigned last_num_vbuffers;
 
+   /**
+    * Vertex elements derived from the last-seen array state, so that
+    * re-validating unchanged arrays only has to rebuild the vertex
+    * buffer bindings.  See update_array() in st_atom_array.c.
+    */
+   struct {
+      GLboolean valid;
+      GLboolean interleaved;
+      const struct gl_vertex_array_object *vao;
+      GLuint vao_serial;
+      const struct st_vp_variant *vpv;
+      const struct gl_client_array **arrays;
+      unsigned num_velements;
+      struct pipe_vertex_element velements[PIPE_MAX_ATTRIBS];
+   } velems_cache;
+
    int32_t draw_stamp;
    int32_t read_stamp;
 
    struct st_config_options options;
 
+   /* Thread pool for going wide across the shader stages at link time.
+    * May be uninitialized if thread creation failed, in which case
+    * everything runs on the application thread.
+    */
+   struct util_queue compile_queue;
+
    struct st_perf_monitor_group *perfmon;
 };
 
@@ -56,8 +56,8 @@ static const struct debug_named_value st_debug_flags[] = {
    { "draw",     DEBUG_DRAW, NULL },
    { "buffer",   DEBUG_BUFFER, NULL },
    { "wf",       DEBUG_WIREFRAME, NULL },
-   { "precompile",  DEBUG_PRECOMPILE, NULL },
    { "gremedy",  DEBUG_GREMEDY, "Enable GREMEDY debug extensions" },
+   { "compstats",DEBUG_COMPSTATS, "Print shader compile statistics" },
    DEBUG_NAMED_VALUE_END
 };
 
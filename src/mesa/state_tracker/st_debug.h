@@ -49,8 +49,8 @@ st_print_current(void);
 #define DEBUG_DRAW      0x100
 #define DEBUG_BUFFER    0x200
 #define DEBUG_WIREFRAME 0x400
-#define DEBUG_PRECOMPILE   0x800
 #define DEBUG_GREMEDY   0x1000
+#define DEBUG_COMPSTATS 0x2000
 
 #ifdef DEBUG
 extern int ST_DEBUG;
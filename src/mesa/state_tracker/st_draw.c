@@ -143,6 +143,35 @@ translate_prim(const struct gl_context *ctx, unsigned prim)
 }
 
 
+/**
+ * Check if two primitives from the same draw call can be drawn as one
+ * merged range.  Only list-type primitives covering back-to-back ranges
+ * and agreeing on all per-primitive draw parameters qualify:
+ * concatenating such ranges changes neither how vertices group into
+ * primitives nor the order they are drawn in.
+ */
+static boolean
+can_merge_prims(const struct _mesa_prim *a, const struct _mesa_prim *b)
+{
+   const struct u_prim_vertex_count *vc = u_prim_vertex_count(a->mode);
+
+   /* Lists are the prims where every primitive consumes incr == min
+    * fresh vertices; strips/loops/fans would get re-joined across the
+    * seam.  Merging must also happen at a primitive boundary, or the
+    * leftover vertices of 'a' would regroup with the start of 'b'.
+    */
+   if (!vc || vc->incr == 0 || vc->incr != vc->min || a->count % vc->incr)
+      return FALSE;
+
+   return b->mode == a->mode &&
+          b->start == a->start + a->count &&
+          b->basevertex == a->basevertex &&
+          a->num_instances == 1 &&
+          b->num_instances == 1 &&
+          b->base_instance == a->base_instance;
+}
+
+
 /**
  * This function gets plugged into the VBO module and is called when
  * we have something to render.
@@ -164,6 +193,7 @@ st_draw_vbo(struct gl_context *ctx,
    struct pipe_index_buffer ibuffer = {0};
    struct pipe_draw_info info;
    const struct gl_client_array **arrays = ctx->Array._DrawArrays;
+   boolean uses_draw_id;
    unsigned i;
 
    /* Mesa core state should have been validated already */
@@ -217,6 +247,12 @@ st_draw_vbo(struct gl_context *ctx,
 
    assert(!indirect);
 
+   /* gl_DrawIDARB is a vertex shader input, so only the vertex program
+    * can keep ranges with different draw ids from being merged below.
+    */
+   uses_draw_id = (ctx->VertexProgram._Current->Base.SystemValuesRead &
+                   (1 << SYSTEM_VALUE_DRAW_ID)) != 0;
+
    /* do actual drawing */
    for (i = 0; i < nr_prims; i++) {
       info.mode = translate_prim(ctx, prims[i].mode);
@@ -227,6 +263,23 @@ st_draw_vbo(struct gl_context *ctx,
       info.vertices_per_patch = ctx->TessCtrlProgram.patch_vertices;
       info.index_bias = prims[i].basevertex;
       info.drawid = prims[i].draw_id;
+
+      /* Merge any following back-to-back ranges into this draw; display
+       * lists and MultiDraw* commonly produce long runs of these, and
+       * the per-draw overhead in the driver easily dwarfs this test.
+       * With primitive restart the ranges cannot be merged, as a range
+       * ending on a partial primitive after a restart index would steal
+       * vertices from the start of the next range.
+       */
+      if (!info.primitive_restart && !info.count_from_stream_output) {
+         while (i + 1 < nr_prims &&
+                can_merge_prims(&prims[i], &prims[i + 1]) &&
+                (!uses_draw_id || prims[i + 1].draw_id == prims[i].draw_id)) {
+            info.count += prims[i + 1].count;
+            i++;
+         }
+      }
+
       if (!ib) {
          info.min_index = info.start;
          info.max_index = info.start + info.count - 1;
@@ -442,17 +442,26 @@ st_mesa_format_to_pipe_format(struct st_context *st, mesa_format mesaFormat)
    case MESA_FORMAT_X8R8G8B8_SRGB:
       return PIPE_FORMAT_XRGB8888_SRGB;
 
-   /* ETC2 formats are emulated as uncompressed ones.
+   /* ETC2 formats are emulated as uncompressed ones, or transcoded to
+    * DXT when the hardware supports S3TC.
     * The destination formats mustn't be changed, because they are also
-    * destination formats of the unpack/decompression function. */
+    * destination formats of the unpack/decompression/transcode function. */
    case MESA_FORMAT_ETC2_RGB8:
-      return st->has_etc2 ? PIPE_FORMAT_ETC2_RGB8 : PIPE_FORMAT_R8G8B8A8_UNORM;
+      return st->has_etc2 ? PIPE_FORMAT_ETC2_RGB8 :
+             st->transcode_etc ? PIPE_FORMAT_DXT1_RGB :
+             PIPE_FORMAT_R8G8B8A8_UNORM;
    case MESA_FORMAT_ETC2_SRGB8:
-      return st->has_etc2 ? PIPE_FORMAT_ETC2_SRGB8 : PIPE_FORMAT_B8G8R8A8_SRGB;
+      return st->has_etc2 ? PIPE_FORMAT_ETC2_SRGB8 :
+             st->transcode_etc ? PIPE_FORMAT_DXT1_SRGB :
+             PIPE_FORMAT_B8G8R8A8_SRGB;
    case MESA_FORMAT_ETC2_RGBA8_EAC:
-      return st->has_etc2 ? PIPE_FORMAT_ETC2_RGBA8 : PIPE_FORMAT_R8G8B8A8_UNORM;
+      return st->has_etc2 ? PIPE_FORMAT_ETC2_RGBA8 :
+             st->transcode_etc ? PIPE_FORMAT_DXT5_RGBA :
+             PIPE_FORMAT_R8G8B8A8_UNORM;
    case MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC:
-      return st->has_etc2 ? PIPE_FORMAT_ETC2_SRGBA8 : PIPE_FORMAT_B8G8R8A8_SRGB;
+      return st->has_etc2 ? PIPE_FORMAT_ETC2_SRGBA8 :
+             st->transcode_etc ? PIPE_FORMAT_DXT5_SRGBA :
+             PIPE_FORMAT_B8G8R8A8_SRGB;
    case MESA_FORMAT_ETC2_R11_EAC:
       return st->has_etc2 ? PIPE_FORMAT_ETC2_R11_UNORM : PIPE_FORMAT_R16_UNORM;
    case MESA_FORMAT_ETC2_RG11_EAC:
@@ -462,9 +471,13 @@ st_mesa_format_to_pipe_format(struct st_context *st, mesa_format mesaFormat)
    case MESA_FORMAT_ETC2_SIGNED_RG11_EAC:
       return st->has_etc2 ? PIPE_FORMAT_ETC2_RG11_SNORM : PIPE_FORMAT_R16G16_SNORM;
    case MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1:
-      return st->has_etc2 ? PIPE_FORMAT_ETC2_RGB8A1 : PIPE_FORMAT_R8G8B8A8_UNORM;
+      return st->has_etc2 ? PIPE_FORMAT_ETC2_RGB8A1 :
+             st->transcode_etc ? PIPE_FORMAT_DXT1_RGBA :
+             PIPE_FORMAT_R8G8B8A8_UNORM;
    case MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1:
-      return st->has_etc2 ? PIPE_FORMAT_ETC2_SRGB8A1 : PIPE_FORMAT_B8G8R8A8_SRGB;
+      return st->has_etc2 ? PIPE_FORMAT_ETC2_SRGB8A1 :
+             st->transcode_etc ? PIPE_FORMAT_DXT1_SRGBA :
+             PIPE_FORMAT_B8G8R8A8_SRGB;
 
    case MESA_FORMAT_RGBA_ASTC_4x4:
       return PIPE_FORMAT_ASTC_4x4;
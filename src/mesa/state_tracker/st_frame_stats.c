@@ -0,0 +1,248 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * \file st_frame_stats.c
+ *
+ * Per-frame bottleneck triage, enabled with ST_FRAME_STATS=1.
+ *
+ * Every frame is bracketed with a PIPE_QUERY_PIPELINE_STATISTICS query and
+ * a pair of timestamps.  Once the queries of a frame complete (a few frames
+ * later, so the pipeline is never serialized) the frame is classified with
+ * a deliberately blunt heuristic:
+ *
+ *  - cpu-bound:    the CPU spent noticeably longer on the frame than the
+ *                  GPU did, so the GPU is starved;
+ *  - fill-bound:   GPU-bound with many more fragment than vertex-pipeline
+ *                  invocations;
+ *  - vertex-bound: GPU-bound otherwise.
+ *
+ * One ST-FRAME-STATS line per frame goes to stderr, carrying the raw
+ * counters alongside the verdict so the classification can be second-
+ * guessed after the fact.  This is triage, not profiling — it points at
+ * which tool to reach for next.
+ */
+
+#include <inttypes.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "os/os_time.h"
+#include "util/u_memory.h"
+
+#include "st_context.h"
+#include "st_frame_stats.h"
+
+/* Frames in flight before we give up bracketing and skip one; deeper than
+ * any sane swapchain.
+ */
+#define ST_FRAME_STATS_RING 8
+
+struct st_frame_stats_slot
+{
+   struct pipe_query *stats;
+   struct pipe_query *ts_begin;
+   struct pipe_query *ts_end;
+   int64_t cpu_time_us;  /**< CPU time spent between the two end_frames */
+   unsigned frame;
+   boolean in_flight;
+};
+
+struct st_frame_stats
+{
+   struct pipe_context *pipe;
+
+   struct st_frame_stats_slot ring[ST_FRAME_STATS_RING];
+   unsigned head, tail;  /**< monotonic, in units of frames */
+
+   unsigned frame;            /**< current frame number */
+   boolean bracketed;         /**< is the current frame bracketed? */
+   int64_t frame_start_us;    /**< CPU time at the last end_frame */
+};
+
+/**
+ * Open the query bracket for the upcoming frame.  Fails quietly when the
+ * ring is full of unretired frames; that frame just goes unreported.
+ */
+static void
+frame_stats_begin(struct st_frame_stats *fs)
+{
+   struct st_frame_stats_slot *slot = &fs->ring[fs->head % ST_FRAME_STATS_RING];
+   struct pipe_context *pipe = fs->pipe;
+
+   fs->bracketed = FALSE;
+
+   if (slot->in_flight)
+      return;
+
+   if (!slot->stats) {
+      slot->stats = pipe->create_query(pipe, PIPE_QUERY_PIPELINE_STATISTICS, 0);
+      if (!slot->stats)
+         return;
+   }
+   if (!slot->ts_begin)
+      slot->ts_begin = pipe->create_query(pipe, PIPE_QUERY_TIMESTAMP, 0);
+   if (!slot->ts_end)
+      slot->ts_end = pipe->create_query(pipe, PIPE_QUERY_TIMESTAMP, 0);
+   if (!slot->ts_begin || !slot->ts_end)
+      return;
+
+   pipe->end_query(pipe, slot->ts_begin);
+   pipe->begin_query(pipe, slot->stats);
+   fs->bracketed = TRUE;
+}
+
+static const char *
+classify(int64_t cpu_us, uint64_t gpu_ns,
+         const struct pipe_query_data_pipeline_statistics *stats)
+{
+   /* All vertex-pipeline work: vertex, tessellation and geometry shading. */
+   const uint64_t vertex_work = stats->vs_invocations +
+                                stats->hs_invocations +
+                                stats->ds_invocations +
+                                stats->gs_invocations;
+
+   if ((uint64_t)cpu_us * 1000 > gpu_ns + gpu_ns / 4)
+      return "cpu-bound";
+
+   if (stats->ps_invocations > vertex_work * 8)
+      return "fill-bound";
+
+   return "vertex-bound";
+}
+
+/**
+ * Log every frame whose queries have completed, oldest first.  Stops at
+ * the first frame that is still in the pipeline.
+ */
+static void
+frame_stats_harvest(struct st_frame_stats *fs)
+{
+   struct pipe_context *pipe = fs->pipe;
+
+   while (fs->tail != fs->head) {
+      struct st_frame_stats_slot *slot =
+         &fs->ring[fs->tail % ST_FRAME_STATS_RING];
+      union pipe_query_result stats, ts_begin, ts_end;
+      uint64_t gpu_ns;
+
+      if (!slot->in_flight) {
+         /* This frame never got bracketed; nothing to report. */
+         fs->tail++;
+         continue;
+      }
+
+      if (!pipe->get_query_result(pipe, slot->stats, FALSE, &stats) ||
+          !pipe->get_query_result(pipe, slot->ts_begin, FALSE, &ts_begin) ||
+          !pipe->get_query_result(pipe, slot->ts_end, FALSE, &ts_end))
+         break;
+
+      gpu_ns = ts_end.u64 - ts_begin.u64;
+
+      fprintf(stderr, "ST-FRAME-STATS: frame=%u cpu_ms=%.2f gpu_ms=%.2f"
+              " verts=%" PRIu64 " prims=%" PRIu64 " vs=%" PRIu64
+              " ps=%" PRIu64 " class=%s\n",
+              slot->frame,
+              slot->cpu_time_us / 1000.0,
+              gpu_ns / 1000000.0,
+              stats.pipeline_statistics.ia_vertices,
+              stats.pipeline_statistics.c_primitives,
+              stats.pipeline_statistics.vs_invocations,
+              stats.pipeline_statistics.ps_invocations,
+              classify(slot->cpu_time_us, gpu_ns,
+                       &stats.pipeline_statistics));
+
+      slot->in_flight = FALSE;
+      fs->tail++;
+   }
+}
+
+struct st_frame_stats *
+st_frame_stats_create(struct st_context *st)
+{
+   struct pipe_screen *screen = st->pipe->screen;
+   struct st_frame_stats *fs;
+
+   if (!screen->get_param(screen, PIPE_CAP_QUERY_TIMESTAMP) ||
+       !screen->get_param(screen, PIPE_CAP_QUERY_PIPELINE_STATISTICS))
+      return NULL;
+
+   fs = CALLOC_STRUCT(st_frame_stats);
+   if (!fs)
+      return NULL;
+
+   fs->pipe = st->pipe;
+   fs->frame_start_us = os_time_get();
+   frame_stats_begin(fs);
+   return fs;
+}
+
+void
+st_frame_stats_destroy(struct st_frame_stats *fs)
+{
+   struct pipe_context *pipe = fs->pipe;
+   unsigned i;
+
+   if (fs->bracketed)
+      pipe->end_query(pipe, fs->ring[fs->head % ST_FRAME_STATS_RING].stats);
+
+   for (i = 0; i < ST_FRAME_STATS_RING; i++) {
+      struct st_frame_stats_slot *slot = &fs->ring[i];
+
+      if (slot->stats)
+         pipe->destroy_query(pipe, slot->stats);
+      if (slot->ts_begin)
+         pipe->destroy_query(pipe, slot->ts_begin);
+      if (slot->ts_end)
+         pipe->destroy_query(pipe, slot->ts_end);
+   }
+   FREE(fs);
+}
+
+void
+st_frame_stats_end_frame(struct st_frame_stats *fs)
+{
+   struct pipe_context *pipe = fs->pipe;
+   struct st_frame_stats_slot *slot = &fs->ring[fs->head % ST_FRAME_STATS_RING];
+   int64_t now = os_time_get();
+
+   if (fs->bracketed) {
+      pipe->end_query(pipe, slot->stats);
+      pipe->end_query(pipe, slot->ts_end);
+      slot->cpu_time_us = now - fs->frame_start_us;
+      slot->frame = fs->frame;
+      slot->in_flight = TRUE;
+   }
+
+   fs->frame++;
+   fs->frame_start_us = now;
+   fs->head++;
+
+   frame_stats_harvest(fs);
+   frame_stats_begin(fs);
+}
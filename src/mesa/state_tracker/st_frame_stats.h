@@ -0,0 +1,51 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#ifndef ST_FRAME_STATS_H
+#define ST_FRAME_STATS_H
+
+struct st_context;
+struct st_frame_stats;
+
+/**
+ * Create the frame-analysis state, or return NULL if the driver lacks
+ * timestamp and pipeline-statistics queries.
+ */
+struct st_frame_stats *
+st_frame_stats_create(struct st_context *st);
+
+void
+st_frame_stats_destroy(struct st_frame_stats *fs);
+
+/**
+ * Mark the end of a frame: rotate the query bracket and log the analysis
+ * of any frame whose queries have completed.  Never waits on the GPU.
+ */
+void
+st_frame_stats_end_frame(struct st_frame_stats *fs);
+
+#endif /* ST_FRAME_STATS_H */
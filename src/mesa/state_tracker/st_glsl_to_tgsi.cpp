@@ -47,14 +47,21 @@
 #include "pipe/p_screen.h"
 #include "tgsi/tgsi_ureg.h"
 #include "tgsi/tgsi_info.h"
+#include "os/os_time.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
+#include "st_debug.h"
 #include "st_program.h"
 #include "st_mesa_to_tgsi.h"
 #include "st_format.h"
 #include "st_glsl_types.h"
 #include "st_nir.h"
 
+#ifdef PIPE_OS_UNIX
+#include <inttypes.h>
+#include <sys/resource.h>
+#endif
+
 
 #define PROGRAM_ANY_CONST ((1 << PROGRAM_STATE_VAR) |    \
                            (1 << PROGRAM_CONSTANT) |     \
@@ -6014,6 +6021,15 @@ st_translate_program(
    assert(numInputs <= ARRAY_SIZE(t->inputs));
    assert(numOutputs <= ARRAY_SIZE(t->outputs));
 
+   /* Size the ureg token arrays from the IR counts, so emission doesn't go
+    * through repeated copy-on-grow cycles: ~10 tokens covers a worst-case
+    * instruction (opcode plus a two-token dst and four two-token srcs),
+    * immediates are five tokens each, and the slack absorbs declarations.
+    */
+   ureg_set_size_estimate(ureg,
+                          program->instructions.length() * 10 +
+                          program->num_immediates * 5 + 256);
+
    t = CALLOC_STRUCT(st_translate);
    if (!t) {
       ret = PIPE_ERROR_OUT_OF_MEMORY;
@@ -6451,6 +6467,11 @@ get_mesa_program_tgsi(struct gl_context *ctx,
          &ctx->Const.ShaderCompilerOptions[_mesa_shader_enum_to_shader_stage(shader->Type)];
    struct pipe_screen *pscreen = ctx->st->pipe->screen;
    unsigned ptarget = st_shader_stage_to_ptarget(shader->Stage);
+   int64_t stats_start = 0;
+   unsigned stats_instrs_before = 0;
+
+   if (ST_DEBUG & DEBUG_COMPSTATS)
+      stats_start = os_time_get();
 
    validate_ir_tree(shader->ir);
 
@@ -6540,6 +6561,9 @@ get_mesa_program_tgsi(struct gl_context *ctx,
    }
 #endif
 
+   if (ST_DEBUG & DEBUG_COMPSTATS)
+      stats_instrs_before = v->instructions.length();
+
    /* Perform optimizations on the instructions in the glsl_to_tgsi_visitor. */
    v->simplify_cmp();
 
@@ -6646,6 +6670,23 @@ get_mesa_program_tgsi(struct gl_context *ctx,
       return NULL;
    }
 
+#ifdef PIPE_OS_UNIX
+   if (ST_DEBUG & DEBUG_COMPSTATS) {
+      struct rusage ru;
+
+      /* ralloc does no accounting, report the process' high-water mark as
+       * the memory figure.
+       */
+      getrusage(RUSAGE_SELF, &ru);
+
+      fprintf(stderr, "ST-COMPILE-STATS: stage=%s time_us=%" PRIi64
+              " instrs_before=%u instrs_after=%u maxrss_kb=%ld\n",
+              _mesa_shader_stage_to_string(shader->Stage),
+              os_time_get() - stats_start, stats_instrs_before,
+              v->instructions.length(), ru.ru_maxrss);
+   }
+#endif
+
    return prog;
 }
 
@@ -6739,6 +6780,105 @@ st_dump_program_for_shader_db(struct gl_context *ctx,
    }
 }
 
+struct st_link_stage_job {
+   struct gl_context *ctx;
+   struct gl_shader *shader;
+   bool have_dround;
+   bool have_dfrexp;
+   bool have_gather_offsets;
+   struct util_queue_fence fence;
+};
+
+/**
+ * Lower and optimize the IR of a single linked shader stage.  This only
+ * reads constant context state and only writes the stage's own IR, so the
+ * stages can be processed in parallel on the compile queue.
+ */
+static void
+st_link_stage_execute(void *data, int thread_index)
+{
+   struct st_link_stage_job *job = (struct st_link_stage_job *) data;
+   struct gl_context *ctx = job->ctx;
+   exec_list *ir = job->shader->ir;
+   gl_shader_stage stage =
+      _mesa_shader_enum_to_shader_stage(job->shader->Type);
+   const struct gl_shader_compiler_options *options =
+         &ctx->Const.ShaderCompilerOptions[stage];
+   bool progress;
+
+   /* If there are forms of indirect addressing that the driver
+    * cannot handle, perform the lowering pass.
+    */
+   if (options->EmitNoIndirectInput || options->EmitNoIndirectOutput ||
+       options->EmitNoIndirectTemp || options->EmitNoIndirectUniform) {
+      lower_variable_index_to_cond_assign(job->shader->Stage, ir,
+                                          options->EmitNoIndirectInput,
+                                          options->EmitNoIndirectOutput,
+                                          options->EmitNoIndirectTemp,
+                                          options->EmitNoIndirectUniform);
+   }
+
+   if (ctx->Extensions.ARB_shading_language_packing) {
+      unsigned lower_inst = LOWER_PACK_SNORM_2x16 |
+                            LOWER_UNPACK_SNORM_2x16 |
+                            LOWER_PACK_UNORM_2x16 |
+                            LOWER_UNPACK_UNORM_2x16 |
+                            LOWER_PACK_SNORM_4x8 |
+                            LOWER_UNPACK_SNORM_4x8 |
+                            LOWER_UNPACK_UNORM_4x8 |
+                            LOWER_PACK_UNORM_4x8;
+
+      if (ctx->Extensions.ARB_gpu_shader5)
+         lower_inst |= LOWER_PACK_USE_BFI |
+                       LOWER_PACK_USE_BFE;
+      if (!ctx->st->has_half_float_packing)
+         lower_inst |= LOWER_PACK_HALF_2x16 |
+                       LOWER_UNPACK_HALF_2x16;
+
+      lower_packing_builtins(ir, lower_inst);
+   }
+
+   if (!job->have_gather_offsets)
+      lower_offset_arrays(ir);
+   do_mat_op_to_vec(ir);
+   lower_instructions(ir,
+                      MOD_TO_FLOOR |
+                      DIV_TO_MUL_RCP |
+                      EXP_TO_EXP2 |
+                      LOG_TO_LOG2 |
+                      LDEXP_TO_ARITH |
+                      (job->have_dfrexp ? 0 : DFREXP_DLDEXP_TO_ARITH) |
+                      CARRY_TO_ARITH |
+                      BORROW_TO_ARITH |
+                      (job->have_dround ? 0 : DOPS_TO_DFRAC) |
+                      (options->EmitNoPow ? POW_TO_EXP2 : 0) |
+                      (!ctx->Const.NativeIntegers ? INT_DIV_TO_MUL_RCP : 0) |
+                      (options->EmitNoSat ? SAT_TO_CLAMP : 0));
+
+   do_vec_index_to_cond_assign(ir);
+   lower_vector_insert(ir, true);
+   lower_quadop_vector(ir, false);
+   lower_noise(ir);
+   if (options->MaxIfDepth == 0) {
+      lower_discard(ir);
+   }
+
+   do {
+      progress = false;
+
+      progress = do_lower_jumps(ir, true, true, options->EmitNoMainReturn, options->EmitNoCont, options->EmitNoLoops) || progress;
+
+      progress = do_common_optimization(ir, true, true, options,
+                                        ctx->Const.NativeIntegers)
+        || progress;
+
+      progress = lower_if_to_cond_assign(ir, options->MaxIfDepth) || progress;
+
+   } while (progress);
+
+   validate_ir_tree(ir);
+}
+
 /**
  * Link a shader.
  * Called via ctx->Driver.LinkShader()
@@ -6749,94 +6889,44 @@ GLboolean
 st_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
 {
    struct pipe_screen *pscreen = ctx->st->pipe->screen;
+   struct st_link_stage_job jobs[MESA_SHADER_STAGES];
    assert(prog->LinkStatus);
 
+   /* Push the per-stage lowering and optimization onto the compile queue
+    * so it runs in parallel across the stages.  The screen capabilities
+    * are queried up front to keep the jobs off the pipe_screen.
+    */
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
       if (prog->_LinkedShaders[i] == NULL)
          continue;
 
-      bool progress;
-      exec_list *ir = prog->_LinkedShaders[i]->ir;
       gl_shader_stage stage = _mesa_shader_enum_to_shader_stage(prog->_LinkedShaders[i]->Type);
-      const struct gl_shader_compiler_options *options =
-            &ctx->Const.ShaderCompilerOptions[stage];
       unsigned ptarget = st_shader_stage_to_ptarget(stage);
-      bool have_dround = pscreen->get_shader_param(pscreen, ptarget,
-                                                   PIPE_SHADER_CAP_TGSI_DROUND_SUPPORTED);
-      bool have_dfrexp = pscreen->get_shader_param(pscreen, ptarget,
-                                                   PIPE_SHADER_CAP_TGSI_DFRACEXP_DLDEXP_SUPPORTED);
 
-      /* If there are forms of indirect addressing that the driver
-       * cannot handle, perform the lowering pass.
-       */
-      if (options->EmitNoIndirectInput || options->EmitNoIndirectOutput ||
-          options->EmitNoIndirectTemp || options->EmitNoIndirectUniform) {
-         lower_variable_index_to_cond_assign(prog->_LinkedShaders[i]->Stage, ir,
-                                             options->EmitNoIndirectInput,
-                                             options->EmitNoIndirectOutput,
-                                             options->EmitNoIndirectTemp,
-                                             options->EmitNoIndirectUniform);
-      }
-
-      if (ctx->Extensions.ARB_shading_language_packing) {
-         unsigned lower_inst = LOWER_PACK_SNORM_2x16 |
-                               LOWER_UNPACK_SNORM_2x16 |
-                               LOWER_PACK_UNORM_2x16 |
-                               LOWER_UNPACK_UNORM_2x16 |
-                               LOWER_PACK_SNORM_4x8 |
-                               LOWER_UNPACK_SNORM_4x8 |
-                               LOWER_UNPACK_UNORM_4x8 |
-                               LOWER_PACK_UNORM_4x8;
-
-         if (ctx->Extensions.ARB_gpu_shader5)
-            lower_inst |= LOWER_PACK_USE_BFI |
-                          LOWER_PACK_USE_BFE;
-         if (!ctx->st->has_half_float_packing)
-            lower_inst |= LOWER_PACK_HALF_2x16 |
-                          LOWER_UNPACK_HALF_2x16;
-
-         lower_packing_builtins(ir, lower_inst);
-      }
-
-      if (!pscreen->get_param(pscreen, PIPE_CAP_TEXTURE_GATHER_OFFSETS))
-         lower_offset_arrays(ir);
-      do_mat_op_to_vec(ir);
-      lower_instructions(ir,
-                         MOD_TO_FLOOR |
-                         DIV_TO_MUL_RCP |
-                         EXP_TO_EXP2 |
-                         LOG_TO_LOG2 |
-                         LDEXP_TO_ARITH |
-                         (have_dfrexp ? 0 : DFREXP_DLDEXP_TO_ARITH) |
-                         CARRY_TO_ARITH |
-                         BORROW_TO_ARITH |
-                         (have_dround ? 0 : DOPS_TO_DFRAC) |
-                         (options->EmitNoPow ? POW_TO_EXP2 : 0) |
-                         (!ctx->Const.NativeIntegers ? INT_DIV_TO_MUL_RCP : 0) |
-                         (options->EmitNoSat ? SAT_TO_CLAMP : 0));
-
-      do_vec_index_to_cond_assign(ir);
-      lower_vector_insert(ir, true);
-      lower_quadop_vector(ir, false);
-      lower_noise(ir);
-      if (options->MaxIfDepth == 0) {
-         lower_discard(ir);
+      jobs[i].ctx = ctx;
+      jobs[i].shader = prog->_LinkedShaders[i];
+      jobs[i].have_dround = pscreen->get_shader_param(pscreen, ptarget,
+                                                      PIPE_SHADER_CAP_TGSI_DROUND_SUPPORTED);
+      jobs[i].have_dfrexp = pscreen->get_shader_param(pscreen, ptarget,
+                                                      PIPE_SHADER_CAP_TGSI_DFRACEXP_DLDEXP_SUPPORTED);
+      jobs[i].have_gather_offsets =
+         pscreen->get_param(pscreen, PIPE_CAP_TEXTURE_GATHER_OFFSETS);
+
+      util_queue_fence_init(&jobs[i].fence);
+      if (util_queue_is_initialized(&ctx->st->compile_queue)) {
+         util_queue_add_job(&ctx->st->compile_queue, &jobs[i],
+                            &jobs[i].fence, st_link_stage_execute, NULL);
+      } else {
+         st_link_stage_execute(&jobs[i], -1);
       }
+   }
 
-      do {
-         progress = false;
-
-         progress = do_lower_jumps(ir, true, true, options->EmitNoMainReturn, options->EmitNoCont, options->EmitNoLoops) || progress;
-
-         progress = do_common_optimization(ir, true, true, options,
-                                           ctx->Const.NativeIntegers)
-           || progress;
-
-         progress = lower_if_to_cond_assign(ir, options->MaxIfDepth) || progress;
-
-      } while (progress);
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] == NULL)
+         continue;
 
-      validate_ir_tree(ir);
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
    }
 
    build_program_resource_list(ctx, prog);
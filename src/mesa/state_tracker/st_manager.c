@@ -45,6 +45,7 @@
 #include "st_format.h"
 #include "st_cb_fbo.h"
 #include "st_cb_flush.h"
+#include "st_frame_stats.h"
 #include "st_manager.h"
 
 #include "state_tracker/st_gl_api.h"
@@ -52,9 +53,11 @@
 #include "pipe/p_context.h"
 #include "pipe/p_screen.h"
 #include "util/u_format.h"
+#include "util/u_gpu_markers.h"
 #include "util/u_pointer.h"
 #include "util/u_inlines.h"
 #include "util/u_atomic.h"
+#include "util/u_startup_profile.h"
 #include "util/u_surface.h"
 
 /**
@@ -504,6 +507,11 @@ st_context_flush(struct st_context_iface *stctxi, unsigned flags,
    }
 
    st_flush(st, fence, pipe_flags);
+
+   if ((flags & ST_FLUSH_END_OF_FRAME) && st->gpu_markers)
+      util_gpu_markers_end_frame(st->gpu_markers);
+   if ((flags & ST_FLUSH_END_OF_FRAME) && st->frame_stats)
+      st_frame_stats_end_frame(st->frame_stats);
    if (flags & ST_FLUSH_FRONT)
       st_manager_flush_frontbuffer(st);
 }
@@ -631,6 +639,7 @@ st_api_create_context(struct st_api *stapi, struct st_manager *smapi,
                       enum st_context_error *error,
                       struct st_context_iface *shared_stctxi)
 {
+   int64_t profile_start = u_startup_profile_begin();
    struct st_context *shared_ctx = (struct st_context *) shared_stctxi;
    struct st_context *st;
    struct pipe_context *pipe;
@@ -719,6 +728,7 @@ st_api_create_context(struct st_api *stapi, struct st_manager *smapi,
    st->iface.pipe = st->pipe;
 
    *error = ST_CONTEXT_SUCCESS;
+   u_startup_profile_end("st_api_create_context", profile_start);
    return &st->iface;
 }
 
@@ -77,6 +77,10 @@ delete_vp_variant(struct st_context *st, struct st_vp_variant *vpv)
    if (((vpv->tgsi.type == PIPE_SHADER_IR_TGSI)) && vpv->tgsi.tokens)
       ureg_free_tokens(vpv->tgsi.tokens);
 
+   /* the vertex element cache is keyed on the variant pointer */
+   if (st->velems_cache.vpv == vpv)
+      st->velems_cache.valid = GL_FALSE;
+
    free( vpv );
 }
 
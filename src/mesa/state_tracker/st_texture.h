@@ -98,6 +98,16 @@ struct st_texture_object
     */
    struct pipe_sampler_view **sampler_views;
 
+   /* Bumped whenever an image buffer or the texture's storage is
+    * (re)allocated or freed, so that st_finalize_texture() can skip its
+    * walk over all images when nothing has changed since it last
+    * validated this texture.
+    */
+   GLuint serial;
+
+   /* The value of 'serial' when the texture was last finalized */
+   GLuint validated_serial;
+
    /* True if this texture comes from the window system. Such a texture
     * cannot be reallocated and the format can only be changed with a sampler
     * view or a surface.
@@ -159,8 +159,21 @@ struct swrast_texture_image
    /** Malloc'd texture memory */
    GLubyte *Buffer;
 
+   /**
+    * If true, Buffer holds the texels in Morton (Z-order) rather than
+    * linear order and FetchTexel is a coordinate-remapping wrapper around
+    * FetchTexelLinear.  Only ever set for swrast-allocated buffers.
+    */
+   GLboolean Morton;
+
+   /** Temporary linear copy of Buffer while mapped (Morton layout only) */
+   GLubyte *MapBuffer;
+
    FetchTexelFunc FetchTexel;
 
+   /** The linear-layout fetcher wrapped by the Morton remapping */
+   FetchTexelFunc FetchTexelLinear;
+
    /** For fetching texels from compressed textures */
    compressed_fetch_func FetchCompressedTexel;
 };
@@ -181,6 +194,38 @@ swrast_texture_image_const(const struct gl_texture_image *img)
 }
 
 
+/** Spread the low 16 bits of x so that bit i lands in bit 2i */
+static inline GLuint
+_swrast_part1by1(GLuint x)
+{
+   x &= 0x0000ffff;
+   x = (x | (x << 8)) & 0x00ff00ff;
+   x = (x | (x << 4)) & 0x0f0f0f0f;
+   x = (x | (x << 2)) & 0x33333333;
+   x = (x | (x << 1)) & 0x55555555;
+   return x;
+}
+
+/**
+ * Texel index of (i,j) in a Morton-layout image of 2^wlog2 x 2^hlog2
+ * texels.  The low min(wlog2,hlog2) bits of the two coordinates are
+ * interleaved; the remaining high bits of the longer dimension sit above
+ * them, so a non-square image is simply a row (or column) of square
+ * Morton tiles.
+ */
+static inline GLuint
+_swrast_morton_offset(GLuint i, GLuint j, GLuint wlog2, GLuint hlog2)
+{
+   const GLuint shared = wlog2 < hlog2 ? wlog2 : hlog2;
+   const GLuint mask = (1u << shared) - 1;
+
+   /* only the longer dimension has bits above 'shared' */
+   return _swrast_part1by1(i & mask)
+      | _swrast_part1by1(j & mask) << 1
+      | ((i | j) >> shared) << (2 * shared);
+}
+
+
 /**
  * Subclass of gl_renderbuffer with extra fields needed for software
  * rendering.
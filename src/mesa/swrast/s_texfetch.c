@@ -82,6 +82,28 @@ fetch_compressed(const struct swrast_texture_image *swImage,
 }
 
 
+/**
+ * Fetch a texel from a Morton-layout image by remapping the coordinates
+ * and calling the regular linear fetcher.  For a power-of-two image the
+ * linear 2D fetchers address texel (i,j) at byte (j * Width + i) *
+ * texelBytes, so splitting the Morton index back into fake (i,j)
+ * coordinates makes them read byte offset morton * texelBytes.
+ */
+static void
+fetch_morton(const struct swrast_texture_image *swImage,
+             GLint i, GLint j, GLint k, GLfloat *texel)
+{
+   if (swImage->Morton) {
+      const GLuint wlog2 = swImage->Base.WidthLog2;
+      const GLuint m = _swrast_morton_offset(i, j, wlog2,
+                                             swImage->Base.HeightLog2);
+      i = m & ((1 << wlog2) - 1);
+      j = m >> wlog2;
+   }
+   swImage->FetchTexelLinear(swImage, i, j, k, texel);
+}
+
+
 
 /**
  * Null texel fetch function.
@@ -505,6 +527,11 @@ set_fetch_functions(const struct gl_sampler_object *samp,
       assert(!"Bad dims in set_fetch_functions()");
    }
 
+   if (texImage->Morton) {
+      texImage->FetchTexelLinear = texImage->FetchTexel;
+      texImage->FetchTexel = fetch_morton;
+   }
+
    texImage->FetchCompressedTexel = _mesa_get_compressed_fetch_func(format);
 
    assert(texImage->FetchTexel);
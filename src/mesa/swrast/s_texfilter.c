@@ -1510,7 +1510,8 @@ sample_lambda_2d(struct gl_context *ctx,
       && (tImg->Border == 0)
       && (_mesa_format_row_stride(tImg->TexFormat, tImg->Width) ==
           swImg->RowStride)
-      && swImg->_IsPowerOfTwo;
+      && swImg->_IsPowerOfTwo
+      && !swImg->Morton;
 
    assert(lambda != NULL);
    compute_min_mag_ranges(samp, n, lambda,
@@ -3761,6 +3762,7 @@ _swrast_choose_texture_sample_func( struct gl_context *ctx,
             if (sampler->WrapS == GL_REPEAT &&
                 sampler->WrapT == GL_REPEAT &&
                 swImg->_IsPowerOfTwo &&
+                !swImg->Morton &&
                 img->Border == 0) {
                if (img->TexFormat == MESA_FORMAT_BGR_UNORM8)
                   func = &opt_sample_rgb_2d;
@@ -52,6 +52,9 @@ update_wrapper(struct gl_context *ctx, struct gl_renderbuffer_attachment *att)
    /* Want to store linear values, not sRGB */
    rb->Format = _mesa_get_srgb_format_linear(format);
 
+   /* Span rendering addresses the buffer linearly; undo any Morton layout */
+   _swrast_linearize_texture_image(rb->TexImage);
+
    srb->Buffer = swImage->ImageSlices[zOffset];
 }
 
@@ -80,6 +80,106 @@ _swrast_teximage_slice_height(struct gl_texture_image *texImage)
       return texImage->Height;
 }
 
+/**
+ * Should swrast-allocated textures use the Morton (Z-order) layout?
+ * Minified sampling of large linear images strides across whole rows, so
+ * the swizzled layout can be a sizeable win for texture-bound software
+ * rendering.  Off by default since mapping Morton images needs a copy.
+ */
+static GLboolean
+use_morton_layout(void)
+{
+   static GLboolean tested = GL_FALSE;
+   static GLboolean enable = GL_FALSE;
+
+   if (!tested) {
+      enable = getenv("SWRAST_MORTON_TEXTURES") != NULL;
+      tested = GL_TRUE;
+   }
+   return enable;
+}
+
+
+/**
+ * Can this image be stored in Morton layout?  Only uncompressed pow2 2D
+ * images: the remapped fetch relies on the linear fetchers addressing
+ * texel (i,j) at byte (j * Width + i) * texelBytes, and the YCbCr
+ * fetchers read horizontal texel pairs.
+ */
+static GLboolean
+can_use_morton_layout(const struct gl_texture_image *texImage)
+{
+   return use_morton_layout() &&
+          texImage->TexObject->Target == GL_TEXTURE_2D &&
+          texImage->Border == 0 &&
+          texImage->Depth == 1 &&
+          _mesa_is_pow_two(texImage->Width) &&
+          _mesa_is_pow_two(texImage->Height) &&
+          !_mesa_is_format_compressed(texImage->TexFormat) &&
+          texImage->TexFormat != MESA_FORMAT_YCBCR &&
+          texImage->TexFormat != MESA_FORMAT_YCBCR_REV;
+}
+
+
+/**
+ * Copy a texture slice between the linear and Morton layouts.
+ */
+static void
+morton_convert_slice(const struct gl_texture_image *texImage,
+                     GLubyte *dst, const GLubyte *src, GLboolean to_morton)
+{
+   const GLuint texelBytes = _mesa_get_format_bytes(texImage->TexFormat);
+   const GLuint wlog2 = texImage->WidthLog2;
+   const GLuint hlog2 = texImage->HeightLog2;
+   GLuint i, j;
+
+   for (j = 0; j < texImage->Height; j++) {
+      for (i = 0; i < texImage->Width; i++) {
+         const GLuint lin = ((j << wlog2) + i) * texelBytes;
+         const GLuint mor =
+            _swrast_morton_offset(i, j, wlog2, hlog2) * texelBytes;
+
+         if (to_morton)
+            memcpy(dst + mor, src + lin, texelBytes);
+         else
+            memcpy(dst + lin, src + mor, texelBytes);
+      }
+   }
+}
+
+
+/**
+ * Convert a Morton-layout image back to linear order in place.  Called
+ * when the image becomes a render target, since span rendering writes
+ * through the linear RowStride/ImageSlices addressing.
+ */
+void
+_swrast_linearize_texture_image(struct gl_texture_image *texImage)
+{
+   struct swrast_texture_image *swImage = swrast_texture_image(texImage);
+   GLuint bytes;
+   GLubyte *linear;
+
+   if (!swImage->Morton)
+      return;
+
+   assert(!swImage->MapBuffer);
+
+   bytes = _mesa_format_image_size(texImage->TexFormat, texImage->Width,
+                                   texImage->Height, 1);
+   linear = malloc(bytes);
+   if (linear) {
+      morton_convert_slice(texImage, linear, swImage->Buffer, GL_FALSE);
+      memcpy(swImage->Buffer, linear, bytes);
+      free(linear);
+   }
+   /* on malloc failure the texels stay scrambled, but the addressing is
+    * at least consistent from here on
+    */
+   swImage->Morton = GL_FALSE;
+}
+
+
 /**
  * Called via ctx->Driver.AllocTextureImageBuffer()
  */
@@ -111,6 +211,11 @@ _swrast_alloc_texture_image_buffer(struct gl_context *ctx,
       swImg->ImageSlices[i] = swImg->Buffer + bytesPerSlice * i;
    }
 
+   /* A pow2 image has no row padding, so the Morton layout is a pure
+    * permutation of the same allocation.
+    */
+   swImg->Morton = can_use_morton_layout(texImage);
+
    return GL_TRUE;
 }
 
@@ -167,6 +272,10 @@ _swrast_free_texture_image_buffer(struct gl_context *ctx,
 
    _mesa_align_free(swImage->Buffer);
    swImage->Buffer = NULL;
+   swImage->Morton = GL_FALSE;
+
+   free(swImage->MapBuffer);
+   swImage->MapBuffer = NULL;
 
    free(swImage->ImageSlices);
    swImage->ImageSlices = NULL;
@@ -241,7 +350,23 @@ _swrast_map_teximage(struct gl_context *ctx,
    assert(swImage->Buffer);
    assert(swImage->Buffer == swImage->ImageSlices[0]);
 
-   map = swImage->ImageSlices[slice];
+   if (swImage->Morton) {
+      /* Hand out a temporary linear view; unmap copies it back. */
+      if (!swImage->MapBuffer) {
+         swImage->MapBuffer = malloc(stride * texImage->Height);
+         if (!swImage->MapBuffer) {
+            *mapOut = NULL;
+            *rowStrideOut = 0;
+            return;
+         }
+         morton_convert_slice(texImage, swImage->MapBuffer, swImage->Buffer,
+                              GL_FALSE);
+      }
+      map = swImage->MapBuffer;
+   }
+   else {
+      map = swImage->ImageSlices[slice];
+   }
 
    /* apply x/y offset to map address */
    map += stride * (y / bh) + texelSize * (x / bw);
@@ -255,7 +380,14 @@ _swrast_unmap_teximage(struct gl_context *ctx,
                        struct gl_texture_image *texImage,
                        GLuint slice)
 {
-   /* nop */
+   struct swrast_texture_image *swImage = swrast_texture_image(texImage);
+
+   if (swImage->MapBuffer) {
+      morton_convert_slice(texImage, swImage->Buffer, swImage->MapBuffer,
+                           GL_TRUE);
+      free(swImage->MapBuffer);
+      swImage->MapBuffer = NULL;
+   }
 }
 
 
@@ -1077,6 +1077,7 @@ _swrast_choose_triangle( struct gl_context *ctx )
              && samp->WrapT == GL_REPEAT
              && texObj2D->_Swizzle == SWIZZLE_NOOP
              && swImg->_IsPowerOfTwo
+             && !swImg->Morton
              && texImg->Border == 0
              && (_mesa_format_row_stride(format, texImg->Width) ==
                  swImg->RowStride)
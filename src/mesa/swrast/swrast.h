@@ -242,6 +242,9 @@ _swrast_unmap_teximage(struct gl_context *ctx,
 		       struct gl_texture_image *texImage,
 		       GLuint slice);
 
+extern void
+_swrast_linearize_texture_image(struct gl_texture_image *texImage);
+
 /* Tell the software rasterizer about core state changes.
  */
 extern void
@@ -119,6 +119,12 @@ convert_half_to_float(const struct gl_client_array *input,
 {
    GLuint i, j;
 
+   if (input->StrideB == sz * sizeof(GLhalfARB)) {
+      /* Tightly packed, so the whole block is one flat array. */
+      _mesa_half_to_float_array(fptr, (const GLhalfARB *) ptr, count * sz);
+      return;
+   }
+
    for (i = 0; i < count; i++) {
       GLhalfARB *in = (GLhalfARB *)ptr;
 
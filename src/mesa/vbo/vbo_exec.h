@@ -97,6 +97,9 @@ struct vbo_exec_context
       GLuint   buffer_used;             /* in bytes */
       fi_type vertex[VBO_ATTRIB_MAX*4]; /* current vertex */
 
+      /** Copy routine specialized for the current vertex_size */
+      void (*copy_vertex)(fi_type *dst, const fi_type *src, GLuint n);
+
       GLuint vert_count;   /**< Number of vertices currently in buffer */
       GLuint max_vert;     /**< Max number of vertices allowed in buffer */
       struct vbo_exec_copied_vtx copied;
@@ -59,6 +59,82 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 static void reset_attrfv( struct vbo_exec_context *exec );
 
 
+/**
+ * The copy of the vertex into the vertex store runs once for every
+ * immediate mode vertex, so rather than a generic word-by-word loop we
+ * go through a function pointer specialized for the current vertex
+ * size, re-selected only when an attribute changes size.  The
+ * fixed-size variants compile down to straight-line (vector) moves.
+ */
+#define COPY_VERTEX_N(NR)                                               \
+static void                                                             \
+copy_vertex_##NR(fi_type *dst, const fi_type *src, GLuint n)            \
+{                                                                       \
+   (void) n;                                                            \
+   memcpy(dst, src, NR * sizeof(fi_type));                              \
+}
+
+COPY_VERTEX_N(1)
+COPY_VERTEX_N(2)
+COPY_VERTEX_N(3)
+COPY_VERTEX_N(4)
+COPY_VERTEX_N(5)
+COPY_VERTEX_N(6)
+COPY_VERTEX_N(7)
+COPY_VERTEX_N(8)
+COPY_VERTEX_N(9)
+COPY_VERTEX_N(10)
+COPY_VERTEX_N(11)
+COPY_VERTEX_N(12)
+COPY_VERTEX_N(13)
+COPY_VERTEX_N(14)
+COPY_VERTEX_N(15)
+COPY_VERTEX_N(16)
+
+#undef COPY_VERTEX_N
+
+static void
+copy_vertex_generic(fi_type *dst, const fi_type *src, GLuint n)
+{
+   memcpy(dst, src, n * sizeof(fi_type));
+}
+
+static void (* const copy_vertex_funcs[])(fi_type *, const fi_type *,
+                                          GLuint) = {
+   copy_vertex_generic,   /* never called: vertex_size == 0 */
+   copy_vertex_1,
+   copy_vertex_2,
+   copy_vertex_3,
+   copy_vertex_4,
+   copy_vertex_5,
+   copy_vertex_6,
+   copy_vertex_7,
+   copy_vertex_8,
+   copy_vertex_9,
+   copy_vertex_10,
+   copy_vertex_11,
+   copy_vertex_12,
+   copy_vertex_13,
+   copy_vertex_14,
+   copy_vertex_15,
+   copy_vertex_16
+};
+
+
+/**
+ * Select the vertex store copy routine matching the current vertex
+ * size.  Must be called whenever exec->vtx.vertex_size changes.
+ */
+static void
+vbo_exec_select_copy_func( struct vbo_exec_context *exec )
+{
+   if (exec->vtx.vertex_size < ARRAY_SIZE(copy_vertex_funcs))
+      exec->vtx.copy_vertex = copy_vertex_funcs[exec->vtx.vertex_size];
+   else
+      exec->vtx.copy_vertex = copy_vertex_generic;
+}
+
+
 /**
  * Close off the last primitive, execute the buffer, restart the
  * primitive.  This is called when we fill a vertex buffer before
@@ -308,6 +384,7 @@ vbo_exec_wrap_upgrade_vertex(struct vbo_exec_context *exec,
     */
    exec->vtx.attrsz[attr] = newSize;
    exec->vtx.vertex_size += newSize - oldSize;
+   vbo_exec_select_copy_func( exec );
    exec->vtx.max_vert = vbo_compute_max_verts(exec);
    exec->vtx.vert_count = 0;
    exec->vtx.buffer_ptr = exec->vtx.buffer_map;
@@ -479,8 +556,6 @@ do {									\
 									\
    if ((A) == 0) {							\
       /* This is a glVertex call */					\
-      GLuint i;								\
-									\
       if (unlikely((ctx->Driver.NeedFlush & FLUSH_UPDATE_CURRENT) == 0)) { \
          vbo_exec_begin_vertices(ctx);                                  \
       }                                                                 \
@@ -490,9 +565,9 @@ do {									\
       }                                                                 \
       assert(exec->vtx.buffer_ptr);                                     \
                                                                         \
-      /* copy 32-bit words */                                           \
-      for (i = 0; i < exec->vtx.vertex_size; i++)			\
-	 exec->vtx.buffer_ptr[i] = exec->vtx.vertex[i];			\
+      /* copy the accumulated vertex into the vertex store */           \
+      exec->vtx.copy_vertex(exec->vtx.buffer_ptr, exec->vtx.vertex,     \
+                            exec->vtx.vertex_size);                     \
 									\
       exec->vtx.buffer_ptr += exec->vtx.vertex_size;			\
 									\
@@ -1187,6 +1262,7 @@ void vbo_exec_vtx_init( struct vbo_exec_context *exec )
    }
 
    exec->vtx.vertex_size = 0;
+   vbo_exec_select_copy_func( exec );
 
    exec->begin_vertices_flags = FLUSH_UPDATE_CURRENT;
 }
@@ -1282,8 +1358,9 @@ static void reset_attrfv( struct vbo_exec_context *exec )
    }
 
    exec->vtx.vertex_size = 0;
+   vbo_exec_select_copy_func( exec );
 }
-      
+
 
 void GLAPIENTRY
 _es_Color4f(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
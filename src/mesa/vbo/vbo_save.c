@@ -98,6 +98,8 @@ void vbo_save_destroy( struct gl_context *ctx )
    for (i = 0; i < VBO_ATTRIB_MAX; i++) {
       _mesa_reference_buffer_object(ctx, &save->arrays[i].BufferObj, NULL);
    }
+
+   _mesa_reference_buffer_object(ctx, &save->bound.bufferobj, NULL);
 }
 
 
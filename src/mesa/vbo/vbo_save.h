@@ -126,6 +126,23 @@ struct vbo_save_context {
    struct gl_client_array arrays[VBO_ATTRIB_MAX];
    const struct gl_client_array *inputs[VBO_ATTRIB_MAX];
 
+   /**
+    * Identity of the vertex list whose arrays are currently installed
+    * in arrays[]/inputs[] above, so that replaying a list with the same
+    * data and input mapping can skip rebuilding them.  See
+    * vbo_bind_vertex_list().
+    */
+   struct {
+      struct gl_buffer_object *bufferobj;
+      GLuint buffer_offset;
+      GLuint vertex_size;
+      GLubyte attrsz[VBO_ATTRIB_MAX];
+      GLenum attrtype[VBO_ATTRIB_MAX];
+      GLuint program_mode;
+      GLboolean attrib0_aliased;
+      GLbitfield64 varying_inputs;
+   } bound;
+
    GLubyte attrsz[VBO_ATTRIB_MAX];  /**< 1, 2, 3 or 4 */
    GLenum attrtype[VBO_ATTRIB_MAX];  /**< GL_FLOAT, GL_INT, etc */
    GLubyte active_sz[VBO_ATTRIB_MAX];  /**< 1, 2, 3 or 4 */
@@ -134,19 +134,50 @@ static void vbo_bind_vertex_list(struct gl_context *ctx,
    struct vbo_save_context *save = &vbo->save;
    struct gl_client_array *arrays = save->arrays;
    GLuint buffer_offset = node->buffer_offset;
+   const GLuint program_mode = get_program_mode(ctx);
+   GLboolean attrib0_aliased = GL_FALSE;
    const GLuint *map;
    GLuint attr;
    GLubyte node_attrsz[VBO_ATTRIB_MAX];  /* copy of node->attrsz[] */
    GLenum node_attrtype[VBO_ATTRIB_MAX];  /* copy of node->attrtype[] */
    GLbitfield64 varying_inputs = 0x0;
 
+   /* check if VERT_ATTRIB_POS is not read but VERT_BIT_GENERIC0 is read.
+    * In that case we effectively need to route the data from
+    * glVertexAttrib(0, val) calls to feed into the GENERIC0 input.
+    */
+   if (program_mode == VP_ARB &&
+       (ctx->VertexProgram._Current->Base.InputsRead & VERT_BIT_POS) == 0 &&
+       (ctx->VertexProgram._Current->Base.InputsRead & VERT_BIT_GENERIC0)) {
+      attrib0_aliased = GL_TRUE;
+   }
+
+   /* If this is the same vertex data and input mapping as the last list
+    * bound, arrays[]/inputs[] are already set up for it, so the work
+    * below (including a buffer rebind per attribute) can be skipped.
+    * The buffer object reference held by arrays[] guarantees the
+    * pointer compared here cannot belong to a recycled allocation.
+    */
+   if (save->bound.bufferobj == node->vertex_store->bufferobj &&
+       save->bound.buffer_offset == node->buffer_offset &&
+       save->bound.vertex_size == node->vertex_size &&
+       save->bound.program_mode == program_mode &&
+       save->bound.attrib0_aliased == attrib0_aliased &&
+       memcmp(save->bound.attrsz, node->attrsz,
+              sizeof(node->attrsz)) == 0 &&
+       memcmp(save->bound.attrtype, node->attrtype,
+              sizeof(node->attrtype)) == 0) {
+      _mesa_set_varying_vp_inputs( ctx, save->bound.varying_inputs );
+      return;
+   }
+
    memcpy(node_attrsz, node->attrsz, sizeof(node->attrsz));
    memcpy(node_attrtype, node->attrtype, sizeof(node->attrtype));
 
    /* Install the default (ie Current) attributes first, then overlay
     * all active ones.
     */
-   switch (get_program_mode(ctx)) {
+   switch (program_mode) {
    case VP_NONE:
       for (attr = 0; attr < VERT_ATTRIB_FF_MAX; attr++) {
          save->inputs[attr] = &vbo->currval[VBO_ATTRIB_POS+attr];
@@ -167,12 +198,7 @@ static void vbo_bind_vertex_list(struct gl_context *ctx,
       }
       map = vbo->map_vp_arb;
 
-      /* check if VERT_ATTRIB_POS is not read but VERT_BIT_GENERIC0 is read.
-       * In that case we effectively need to route the data from
-       * glVertexAttrib(0, val) calls to feed into the GENERIC0 input.
-       */
-      if ((ctx->VertexProgram._Current->Base.InputsRead & VERT_BIT_POS) == 0 &&
-          (ctx->VertexProgram._Current->Base.InputsRead & VERT_BIT_GENERIC0)) {
+      if (attrib0_aliased) {
          save->inputs[VERT_ATTRIB_GENERIC0] = save->inputs[0];
          node_attrsz[VERT_ATTRIB_GENERIC0] = node_attrsz[0];
          node_attrtype[VERT_ATTRIB_GENERIC0] = node_attrtype[0];
@@ -213,6 +239,17 @@ static void vbo_bind_vertex_list(struct gl_context *ctx,
 
    _mesa_set_varying_vp_inputs( ctx, varying_inputs );
    ctx->NewDriverState |= ctx->DriverFlags.NewArray;
+
+   /* Remember what was bound so an identical replay can skip all this */
+   _mesa_reference_buffer_object(ctx, &save->bound.bufferobj,
+                                 node->vertex_store->bufferobj);
+   save->bound.buffer_offset = node->buffer_offset;
+   save->bound.vertex_size = node->vertex_size;
+   memcpy(save->bound.attrsz, node->attrsz, sizeof(save->bound.attrsz));
+   memcpy(save->bound.attrtype, node->attrtype, sizeof(save->bound.attrtype));
+   save->bound.program_mode = program_mode;
+   save->bound.attrib0_aliased = attrib0_aliased;
+   save->bound.varying_inputs = varying_inputs;
 }
 
 
@@ -96,6 +96,140 @@ __bitset_ffs(const BITSET_WORD *x, int n)
 
 #define BITSET_FFS(x) __bitset_ffs(x, ARRAY_SIZE(x))
 
+/* Bulk operations on dynamically-sized bitsets, given as a word count.
+ *
+ * These are the inner loops of dataflow iteration: union, intersection,
+ * equality and union-with-change-detection each touch every word of the
+ * set, so when the compiler is targeting AVX2 or SSE2 they process a
+ * vector register's worth of words at a time.  The bitsets are usually
+ * heap-allocated, so no particular alignment is assumed.
+ */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BITSET_SIMD_WORDS (sizeof(__m256i) / sizeof(BITSET_WORD))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define BITSET_SIMD_WORDS (sizeof(__m128i) / sizeof(BITSET_WORD))
+#endif
+
+/* dst |= src */
+static inline void
+__bitset_or(BITSET_WORD *dst, const BITSET_WORD *src, unsigned n)
+{
+   unsigned i = 0;
+
+#if defined(__AVX2__)
+   for (; i + BITSET_SIMD_WORDS <= n; i += BITSET_SIMD_WORDS) {
+      __m256i d = _mm256_loadu_si256((__m256i *)(dst + i));
+      __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+      _mm256_storeu_si256((__m256i *)(dst + i), _mm256_or_si256(d, s));
+   }
+#elif defined(__SSE2__)
+   for (; i + BITSET_SIMD_WORDS <= n; i += BITSET_SIMD_WORDS) {
+      __m128i d = _mm_loadu_si128((__m128i *)(dst + i));
+      __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+      _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(d, s));
+   }
+#endif
+
+   for (; i < n; i++)
+      dst[i] |= src[i];
+}
+
+/* dst |= src, returning whether any bit was newly set in dst.  This is
+ * the convergence test of a union-based dataflow fixed point.
+ */
+static inline bool
+__bitset_or_changed(BITSET_WORD *dst, const BITSET_WORD *src, unsigned n)
+{
+   unsigned i = 0;
+   BITSET_WORD progress = 0;
+
+#if defined(__AVX2__)
+   __m256i acc = _mm256_setzero_si256();
+   for (; i + BITSET_SIMD_WORDS <= n; i += BITSET_SIMD_WORDS) {
+      __m256i d = _mm256_loadu_si256((__m256i *)(dst + i));
+      __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+      acc = _mm256_or_si256(acc, _mm256_andnot_si256(d, s));
+      _mm256_storeu_si256((__m256i *)(dst + i), _mm256_or_si256(d, s));
+   }
+   progress |= !_mm256_testz_si256(acc, acc);
+#elif defined(__SSE2__)
+   __m128i acc = _mm_setzero_si128();
+   for (; i + BITSET_SIMD_WORDS <= n; i += BITSET_SIMD_WORDS) {
+      __m128i d = _mm_loadu_si128((__m128i *)(dst + i));
+      __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+      acc = _mm_or_si128(acc, _mm_andnot_si128(d, s));
+      _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(d, s));
+   }
+   progress |= _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128()))
+               != 0xffff;
+#endif
+
+   for (; i < n; i++) {
+      progress |= src[i] & ~dst[i];
+      dst[i] |= src[i];
+   }
+
+   return progress != 0;
+}
+
+/* dst &= src */
+static inline void
+__bitset_and(BITSET_WORD *dst, const BITSET_WORD *src, unsigned n)
+{
+   unsigned i = 0;
+
+#if defined(__AVX2__)
+   for (; i + BITSET_SIMD_WORDS <= n; i += BITSET_SIMD_WORDS) {
+      __m256i d = _mm256_loadu_si256((__m256i *)(dst + i));
+      __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+      _mm256_storeu_si256((__m256i *)(dst + i), _mm256_and_si256(d, s));
+   }
+#elif defined(__SSE2__)
+   for (; i + BITSET_SIMD_WORDS <= n; i += BITSET_SIMD_WORDS) {
+      __m128i d = _mm_loadu_si128((__m128i *)(dst + i));
+      __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+      _mm_storeu_si128((__m128i *)(dst + i), _mm_and_si128(d, s));
+   }
+#endif
+
+   for (; i < n; i++)
+      dst[i] &= src[i];
+}
+
+static inline bool
+__bitset_equal(const BITSET_WORD *a, const BITSET_WORD *b, unsigned n)
+{
+   unsigned i = 0;
+   BITSET_WORD diff = 0;
+
+#if defined(__AVX2__)
+   __m256i acc = _mm256_setzero_si256();
+   for (; i + BITSET_SIMD_WORDS <= n; i += BITSET_SIMD_WORDS) {
+      __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+      __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+      acc = _mm256_or_si256(acc, _mm256_xor_si256(va, vb));
+   }
+   diff |= !_mm256_testz_si256(acc, acc);
+#elif defined(__SSE2__)
+   __m128i acc = _mm_setzero_si128();
+   for (; i + BITSET_SIMD_WORDS <= n; i += BITSET_SIMD_WORDS) {
+      __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+      __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+      acc = _mm_or_si128(acc, _mm_xor_si128(va, vb));
+   }
+   diff |= _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128()))
+           != 0xffff;
+#endif
+
+   for (; i < n; i++)
+      diff |= a[i] ^ b[i];
+
+   return diff == 0;
+}
+
 static inline unsigned
 __bitset_next_set(unsigned i, BITSET_WORD *tmp,
                   const BITSET_WORD *set, unsigned size)
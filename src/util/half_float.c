@@ -27,6 +27,13 @@
 #include "half_float.h"
 #include "rounding.h"
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && \
+    (__GNUC__ >= 5 || defined(__clang__))
+#define USE_F16C_KERNELS 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 typedef union { float f; int32_t i; uint32_t u; } fi_type;
 
 /**
@@ -175,3 +182,117 @@ _mesa_half_to_float(uint16_t val)
    result = fi.f;
    return result;
 }
+
+
+#ifdef USE_F16C_KERNELS
+
+static uint64_t
+xgetbv(void)
+{
+   uint32_t eax, edx;
+
+   __asm __volatile (
+     ".byte 0x0f, 0x01, 0xd0" /* xgetbv isn't supported on gcc < 4.4 */
+     : "=a"(eax),
+       "=d"(edx)
+     : "c"(0)
+   );
+
+   return ((uint64_t)edx << 32) | eax;
+}
+
+static int
+cpu_has_f16c(void)
+{
+   /* Racing threads all compute the same value, so no locking is needed. */
+   static int cached = -1;
+
+   if (cached < 0) {
+      uint32_t eax, ebx, ecx, edx;
+
+      cached = __get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+               (ecx >> 29) & 1 &&        /* F16C */
+               (ecx >> 28) & 1 &&        /* AVX */
+               (ecx >> 27) & 1 &&        /* OSXSAVE */
+               (xgetbv() & 6) == 6;      /* OS saves XMM & YMM */
+   }
+
+   return cached;
+}
+
+/* VCVTPS2PH rounds to nearest even like _mesa_float_to_half() and handles
+ * subnormal halves the same way; only NaN payloads can differ, which no
+ * caller depends on.
+ */
+static void __attribute__((target("avx,f16c")))
+float_to_half_array_f16c(uint16_t *dst, const float *src, unsigned count)
+{
+   unsigned i = 0;
+
+   for (; i + 8 <= count; i += 8) {
+      const __m256 f = _mm256_loadu_ps(src + i);
+      _mm_storeu_si128((__m128i *) (dst + i),
+                       _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT |
+                                          _MM_FROUND_NO_EXC));
+   }
+
+   for (; i < count; i++)
+      dst[i] = _cvtss_sh(src[i], _MM_FROUND_TO_NEAREST_INT |
+                                 _MM_FROUND_NO_EXC);
+}
+
+static void __attribute__((target("avx,f16c")))
+half_to_float_array_f16c(float *dst, const uint16_t *src, unsigned count)
+{
+   unsigned i = 0;
+
+   for (; i + 8 <= count; i += 8) {
+      const __m128i h = _mm_loadu_si128((const __m128i *) (src + i));
+      _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+   }
+
+   for (; i < count; i++)
+      dst[i] = _cvtsh_ss(src[i]);
+}
+
+#endif /* USE_F16C_KERNELS */
+
+
+/**
+ * Convert an array of floats to half floats, using F16C when available.
+ */
+void
+_mesa_float_to_half_array(uint16_t *dst, const float *src, unsigned count)
+{
+   unsigned i;
+
+#ifdef USE_F16C_KERNELS
+   if (cpu_has_f16c()) {
+      float_to_half_array_f16c(dst, src, count);
+      return;
+   }
+#endif
+
+   for (i = 0; i < count; i++)
+      dst[i] = _mesa_float_to_half(src[i]);
+}
+
+
+/**
+ * Convert an array of half floats to floats, using F16C when available.
+ */
+void
+_mesa_half_to_float_array(float *dst, const uint16_t *src, unsigned count)
+{
+   unsigned i;
+
+#ifdef USE_F16C_KERNELS
+   if (cpu_has_f16c()) {
+      half_to_float_array_f16c(dst, src, count);
+      return;
+   }
+#endif
+
+   for (i = 0; i < count; i++)
+      dst[i] = _mesa_half_to_float(src[i]);
+}
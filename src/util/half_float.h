@@ -34,6 +34,11 @@ extern "C" {
 uint16_t _mesa_float_to_half(float val);
 float _mesa_half_to_float(uint16_t val);
 
+void _mesa_float_to_half_array(uint16_t *dst, const float *src,
+                               unsigned count);
+void _mesa_half_to_float_array(float *dst, const uint16_t *src,
+                               unsigned count);
+
 #ifdef __cplusplus
 } /* extern C */
 #endif
@@ -51,46 +51,69 @@
 static const uint32_t deleted_key_value;
 
 /**
- * From Knuth -- a good choice for hash/rehash values is p, p-2 where
- * p and p-2 are both prime.  These tables are sized to have an extra 10%
- * free to avoid exponential performance degradation as the hash table fills
+ * Power-of-two table sizes, indexed with a Fibonacci fold of the hash (see
+ * key_hash_to_index() below), so that computing a bucket is a multiply and
+ * a shift instead of the integer divisions the old prime-size tables
+ * needed on every probe.  The tables keep a quarter of their slots free to
+ * avoid exponential performance degradation as they fill.
  */
 static const struct {
-   uint32_t max_entries, size, rehash;
+   uint32_t max_entries, size, size_log2;
 } hash_sizes[] = {
-   { 2,			5,		3	  },
-   { 4,			7,		5	  },
-   { 8,			13,		11	  },
-   { 16,		19,		17	  },
-   { 32,		43,		41        },
-   { 64,		73,		71        },
-   { 128,		151,		149       },
-   { 256,		283,		281       },
-   { 512,		571,		569       },
-   { 1024,		1153,		1151      },
-   { 2048,		2269,		2267      },
-   { 4096,		4519,		4517      },
-   { 8192,		9013,		9011      },
-   { 16384,		18043,		18041     },
-   { 32768,		36109,		36107     },
-   { 65536,		72091,		72089     },
-   { 131072,		144409,		144407    },
-   { 262144,		288361,		288359    },
-   { 524288,		576883,		576881    },
-   { 1048576,		1153459,	1153457   },
-   { 2097152,		2307163,	2307161   },
-   { 4194304,		4613893,	4613891   },
-   { 8388608,		9227641,	9227639   },
-   { 16777216,		18455029,	18455027  },
-   { 33554432,		36911011,	36911009  },
-   { 67108864,		73819861,	73819859  },
-   { 134217728,		147639589,	147639587 },
-   { 268435456,		295279081,	295279079 },
-   { 536870912,		590559793,	590559791 },
-   { 1073741824,	1181116273,	1181116271},
-   { 2147483648ul,	2362232233ul,	2362232231ul}
+   { 12,		16,		4  },
+   { 24,		32,		5  },
+   { 48,		64,		6  },
+   { 96,		128,		7  },
+   { 192,		256,		8  },
+   { 384,		512,		9  },
+   { 768,		1024,		10 },
+   { 1536,		2048,		11 },
+   { 3072,		4096,		12 },
+   { 6144,		8192,		13 },
+   { 12288,		16384,		14 },
+   { 24576,		32768,		15 },
+   { 49152,		65536,		16 },
+   { 98304,		131072,		17 },
+   { 196608,		262144,		18 },
+   { 393216,		524288,		19 },
+   { 786432,		1048576,	20 },
+   { 1572864,		2097152,	21 },
+   { 3145728,		4194304,	22 },
+   { 6291456,		8388608,	23 },
+   { 12582912,		16777216,	24 },
+   { 25165824,		33554432,	25 },
+   { 50331648,		67108864,	26 },
+   { 100663296,		134217728,	27 },
+   { 201326592,		268435456,	28 },
+   { 402653184,		536870912,	29 },
+   { 805306368,		1073741824,	30 },
+   { 1610612736u,	2147483648u,	31 }
 };
 
+/* hash_sizes index whose size matches the inline small_table. */
+#define SMALL_SIZE_INDEX 0
+
+/**
+ * An odd probe step is coprime with the power-of-two table size, so the
+ * probe sequence below visits every slot before returning to the start.
+ */
+static inline uint32_t
+key_hash_to_double_hash(const struct hash_table *ht, uint32_t hash)
+{
+   return (hash & (ht->size - 1)) | 1;
+}
+
+static inline uint32_t
+key_hash_to_index(const struct hash_table *ht, uint32_t hash)
+{
+   /* Fibonacci hashing: multiplying by 2^32 divided by the golden ratio
+    * mixes the low bits of the hash upward, and the top size_log2 bits
+    * then index the table.  This both spreads out nearby hash values and
+    * makes bucket selection cheap for any power-of-two size.
+    */
+   return (hash * 0x9e3779b9u) >> (32 - ht->size_log2);
+}
+
 static int
 entry_is_free(const struct hash_entry *entry)
 {
@@ -121,25 +144,36 @@ _mesa_hash_table_create(void *mem_ctx,
    if (ht == NULL)
       return NULL;
 
-   ht->size_index = 0;
+   assert(hash_sizes[SMALL_SIZE_INDEX].size == HASH_TABLE_SMALL_SIZE);
+
+   ht->size_index = SMALL_SIZE_INDEX;
    ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
+   ht->size_log2 = hash_sizes[ht->size_index].size_log2;
    ht->max_entries = hash_sizes[ht->size_index].max_entries;
    ht->key_hash_function = key_hash_function;
    ht->key_equals_function = key_equals_function;
-   ht->table = rzalloc_array(ht, struct hash_entry, ht->size);
+   ht->table = ht->small_table;
+   memset(ht->small_table, 0, sizeof(ht->small_table));
    ht->entries = 0;
    ht->deleted_entries = 0;
    ht->deleted_key = &deleted_key_value;
 
-   if (ht->table == NULL) {
-      ralloc_free(ht);
-      return NULL;
-   }
-
    return ht;
 }
 
+/**
+ * Creates a hash table keyed on the pointer value itself.
+ *
+ * This is by far the most common kind of table in the compilers, so the
+ * wrapper keeps the callers short.
+ */
+struct hash_table *
+_mesa_pointer_hash_table_create(void *mem_ctx)
+{
+   return _mesa_hash_table_create(mem_ctx, _mesa_hash_pointer,
+                                  _mesa_key_pointer_equal);
+}
+
 /**
  * Frees the given hash table.
  *
@@ -208,12 +242,11 @@ _mesa_hash_table_set_deleted_key(struct hash_table *ht, const void *deleted_key)
 static struct hash_entry *
 hash_table_search(struct hash_table *ht, uint32_t hash, const void *key)
 {
-   uint32_t start_hash_address = hash % ht->size;
+   uint32_t start_hash_address = key_hash_to_index(ht, hash);
    uint32_t hash_address = start_hash_address;
+   uint32_t double_hash = key_hash_to_double_hash(ht, hash);
 
    do {
-      uint32_t double_hash;
-
       struct hash_entry *entry = ht->table + hash_address;
 
       if (entry_is_free(entry)) {
@@ -224,9 +257,7 @@ hash_table_search(struct hash_table *ht, uint32_t hash, const void *key)
          }
       }
 
-      double_hash = 1 + hash % ht->rehash;
-
-      hash_address = (hash_address + double_hash) % ht->size;
+      hash_address = (hash_address + double_hash) & (ht->size - 1);
    } while (hash_address != start_hash_address);
 
    return NULL;
@@ -276,7 +307,7 @@ _mesa_hash_table_rehash(struct hash_table *ht, unsigned new_size_index)
    ht->table = table;
    ht->size_index = new_size_index;
    ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
+   ht->size_log2 = hash_sizes[ht->size_index].size_log2;
    ht->max_entries = hash_sizes[ht->size_index].max_entries;
    ht->entries = 0;
    ht->deleted_entries = 0;
@@ -285,14 +316,15 @@ _mesa_hash_table_rehash(struct hash_table *ht, unsigned new_size_index)
       hash_table_insert(ht, entry->hash, entry->key, entry->data);
    }
 
-   ralloc_free(old_ht.table);
+   if (old_ht.table != ht->small_table)
+      ralloc_free(old_ht.table);
 }
 
 static struct hash_entry *
 hash_table_insert(struct hash_table *ht, uint32_t hash,
                   const void *key, void *data)
 {
-   uint32_t start_hash_address, hash_address;
+   uint32_t start_hash_address, hash_address, double_hash;
    struct hash_entry *available_entry = NULL;
 
    if (ht->entries >= ht->max_entries) {
@@ -301,11 +333,11 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
       _mesa_hash_table_rehash(ht, ht->size_index);
    }
 
-   start_hash_address = hash % ht->size;
+   start_hash_address = key_hash_to_index(ht, hash);
    hash_address = start_hash_address;
+   double_hash = key_hash_to_double_hash(ht, hash);
    do {
       struct hash_entry *entry = ht->table + hash_address;
-      uint32_t double_hash;
 
       if (!entry_is_present(ht, entry)) {
          /* Stash the first available entry we find */
@@ -334,10 +366,7 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
          return entry;
       }
 
-
-      double_hash = 1 + hash % ht->rehash;
-
-      hash_address = (hash_address + double_hash) % ht->size;
+      hash_address = (hash_address + double_hash) & (ht->size - 1);
    } while (hash_address != start_hash_address);
 
    if (available_entry) {
@@ -500,3 +529,179 @@ _mesa_key_pointer_equal(const void *a, const void *b)
 {
    return a == b;
 }
+
+/**
+ * Hash table wrapper which supports 64-bit keys.
+ *
+ * On 64-bit builds the key is simply stuffed into the key pointer.  On
+ * 32-bit builds the keys are boxed in small ralloc'd allocations that live
+ * as long as the table.  In both cases keys 0 and 1 would collide with the
+ * free and deleted entry markers of the underlying table, so data for
+ * those two keys is stored on the side.
+ */
+
+struct hash_table_u64 {
+   struct hash_table *table;
+   void *freed_key_data;
+   void *deleted_key_data;
+};
+
+struct hash_key_u64 {
+   uint64_t value;
+};
+
+#define FREED_KEY_VALUE 0
+#define DELETED_KEY_VALUE 1
+
+static void *
+uint_key(unsigned id)
+{
+   return (void *)(uintptr_t) id;
+}
+
+static uint32_t
+key_u64_hash(const void *key)
+{
+   return _mesa_hash_data(key, sizeof(uint64_t));
+}
+
+static bool
+key_u64_equals(const void *a, const void *b)
+{
+   const struct hash_key_u64 *aa = a;
+   const struct hash_key_u64 *bb = b;
+
+   return aa->value == bb->value;
+}
+
+struct hash_table_u64 *
+_mesa_hash_table_u64_create(void *mem_ctx)
+{
+   struct hash_table_u64 *ht;
+
+   ht = rzalloc(mem_ctx, struct hash_table_u64);
+   if (!ht)
+      return NULL;
+
+   if (sizeof(void *) == 8) {
+      ht->table = _mesa_pointer_hash_table_create(ht);
+   } else {
+      ht->table = _mesa_hash_table_create(ht, key_u64_hash,
+                                          key_u64_equals);
+   }
+
+   if (!ht->table) {
+      ralloc_free(ht);
+      return NULL;
+   }
+
+   _mesa_hash_table_set_deleted_key(ht->table, uint_key(DELETED_KEY_VALUE));
+
+   return ht;
+}
+
+void
+_mesa_hash_table_u64_destroy(struct hash_table_u64 *ht,
+                             void (*delete_function)(struct hash_entry *entry))
+{
+   if (!ht)
+      return;
+
+   if (delete_function) {
+      struct hash_entry *entry;
+
+      hash_table_foreach(ht->table, entry) {
+         delete_function(entry);
+      }
+   }
+
+   /* The boxed keys on 32-bit builds are ralloc'd off the table, so this
+    * frees them as well.
+    */
+   ralloc_free(ht);
+}
+
+void
+_mesa_hash_table_u64_insert(struct hash_table_u64 *ht, uint64_t key,
+                            void *data)
+{
+   if (key == FREED_KEY_VALUE) {
+      ht->freed_key_data = data;
+      return;
+   }
+
+   if (key == DELETED_KEY_VALUE) {
+      ht->deleted_key_data = data;
+      return;
+   }
+
+   if (sizeof(void *) == 8) {
+      _mesa_hash_table_insert(ht->table, (void *)(uintptr_t) key, data);
+   } else {
+      struct hash_key_u64 *_key = ralloc(ht->table, struct hash_key_u64);
+
+      if (!_key)
+         return;
+      _key->value = key;
+
+      _mesa_hash_table_insert(ht->table, _key, data);
+   }
+}
+
+static struct hash_entry *
+hash_table_u64_search(struct hash_table_u64 *ht, uint64_t key)
+{
+   if (sizeof(void *) == 8) {
+      return _mesa_hash_table_search(ht->table, (void *)(uintptr_t) key);
+   } else {
+      struct hash_key_u64 _key = { .value = key };
+      return _mesa_hash_table_search(ht->table, &_key);
+   }
+}
+
+void *
+_mesa_hash_table_u64_search(struct hash_table_u64 *ht, uint64_t key)
+{
+   struct hash_entry *entry;
+
+   if (key == FREED_KEY_VALUE)
+      return ht->freed_key_data;
+
+   if (key == DELETED_KEY_VALUE)
+      return ht->deleted_key_data;
+
+   entry = hash_table_u64_search(ht, key);
+   if (!entry)
+      return NULL;
+
+   return entry->data;
+}
+
+void
+_mesa_hash_table_u64_remove(struct hash_table_u64 *ht, uint64_t key)
+{
+   struct hash_entry *entry;
+
+   if (key == FREED_KEY_VALUE) {
+      ht->freed_key_data = NULL;
+      return;
+   }
+
+   if (key == DELETED_KEY_VALUE) {
+      ht->deleted_key_data = NULL;
+      return;
+   }
+
+   entry = hash_table_u64_search(ht, key);
+   if (!entry)
+      return;
+
+   if (sizeof(void *) == 8) {
+      _mesa_hash_table_remove(ht->table, entry);
+   } else {
+      struct hash_key_u64 *_key = (struct hash_key_u64 *)entry->key;
+
+      _mesa_hash_table_remove(ht->table, entry);
+      ralloc_free(_key);
+   }
+}
@@ -44,17 +44,28 @@ struct hash_entry {
    void *data;
 };
 
+/**
+ * Number of table slots stored inline in the hash table itself.
+ *
+ * New tables point \c table at this inline storage, so creating a table
+ * costs a single allocation and small tables (up to 12 entries with this
+ * size) never allocate a separate entry array.  The array is promoted to a
+ * heap allocation by the first rehash that outgrows it.
+ */
+#define HASH_TABLE_SMALL_SIZE 16
+
 struct hash_table {
    struct hash_entry *table;
    uint32_t (*key_hash_function)(const void *key);
    bool (*key_equals_function)(const void *a, const void *b);
    const void *deleted_key;
    uint32_t size;
-   uint32_t rehash;
+   uint32_t size_log2;
    uint32_t max_entries;
    uint32_t size_index;
    uint32_t entries;
    uint32_t deleted_entries;
+   struct hash_entry small_table[HASH_TABLE_SMALL_SIZE];
 };
 
 struct hash_table *
@@ -62,6 +73,8 @@ _mesa_hash_table_create(void *mem_ctx,
                         uint32_t (*key_hash_function)(const void *key),
                         bool (*key_equals_function)(const void *a,
                                                     const void *b));
+struct hash_table *
+_mesa_pointer_hash_table_create(void *mem_ctx);
 void _mesa_hash_table_destroy(struct hash_table *ht,
                               void (*delete_function)(struct hash_entry *entry));
 void _mesa_hash_table_clear(struct hash_table *ht,
@@ -105,7 +118,13 @@ static inline uint32_t _mesa_key_hash_string(const void *key)
 
 static inline uint32_t _mesa_hash_pointer(const void *pointer)
 {
-   return _mesa_hash_data(&pointer, sizeof(pointer));
+   /* Pointer keys are hashed on almost every compiler hot path, so this
+    * wants to be cheap.  Folding a few shifted copies discards the
+    * always-zero alignment bits and mixes in the high bits; the table's
+    * Fibonacci indexing takes care of the rest of the scrambling.
+    */
+   uintptr_t num = (uintptr_t) pointer;
+   return (uint32_t) ((num >> 2) ^ (num >> 6) ^ (num >> 10) ^ (num >> 14));
 }
 
 enum {
@@ -139,6 +158,25 @@ _mesa_fnv32_1a_accumulate_block(uint32_t hash, const void *data, size_t size)
         entry != NULL;                                  \
         entry = _mesa_hash_table_next_entry(ht, entry))
 
+/**
+ * Hash table keyed on 64-bit values, for things like sampler and variant
+ * keys that don't fit in a pointer on 32-bit builds.  Keys 0 and 1 are
+ * valid; the wrapper keeps them out of the underlying table, where they
+ * would collide with the free and deleted markers.
+ */
+struct hash_table_u64 *
+_mesa_hash_table_u64_create(void *mem_ctx);
+void
+_mesa_hash_table_u64_destroy(struct hash_table_u64 *ht,
+                             void (*delete_function)(struct hash_entry *entry));
+void
+_mesa_hash_table_u64_insert(struct hash_table_u64 *ht, uint64_t key,
+                            void *data);
+void *
+_mesa_hash_table_u64_search(struct hash_table_u64 *ht, uint64_t key);
+void
+_mesa_hash_table_u64_remove(struct hash_table_u64 *ht, uint64_t key);
+
 #ifdef __cplusplus
 } /* extern C */
 #endif
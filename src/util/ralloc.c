@@ -51,6 +51,8 @@ _CRTIMP int _vscprintf(const char *format, va_list argptr);
 
 #define CANARY 0x5A1106
 
+struct ralloc_pool;
+
 struct ralloc_header
 {
 #ifdef DEBUG
@@ -68,12 +70,65 @@ struct ralloc_header
    struct ralloc_header *next;
 
    void (*destructor)(void *);
+
+   /* The pool this node was created under, or NULL.  Small allocations
+    * parented to this node are carved from it instead of malloc'd.
+    */
+   struct ralloc_pool *pool;
+
+   /* True if this block was carved out of a pool slab rather than obtained
+    * from malloc, and therefore must not be passed to free().
+    */
+   bool embedded;
+
+   /* Payload size of an embedded block, so that resize() can migrate it out
+    * of its slab.  Unused (and stale) once \c embedded is false.
+    */
+   uint32_t embedded_size;
 };
 
 typedef struct ralloc_header ralloc_header;
 
+#define RALLOC_POOL_SLAB_SIZE (16 * 1024)
+
+/* Slab allocations above this size fall back to a plain malloc'd node, so a
+ * single large array can't waste most of a fresh slab and can be reralloc'd
+ * without abandoning slab space.
+ */
+#define RALLOC_POOL_MAX_ALLOC 2048
+
+struct ralloc_pool_slab {
+   struct ralloc_pool_slab *next;
+};
+
+/* Bytes reserved at the start of each slab for the next link, padded so
+ * that node payloads (prefix plus a multiple of 16 plus the node header)
+ * stay 16-byte aligned like malloc's.
+ */
+#define RALLOC_POOL_SLAB_PREFIX                                       \
+   (((sizeof(struct ralloc_pool_slab) + sizeof(ralloc_header) + 15) & \
+     ~(size_t)15) - sizeof(ralloc_header))
+
+struct ralloc_pool
+{
+   /* Every slab allocated for the pool, the one allocations are currently
+    * carved from first.  Slabs are plain calloc blocks owned by the pool;
+    * they are all freed at once when the pool context itself is freed,
+    * after every node living in them has been torn down.
+    */
+   struct ralloc_pool_slab *slabs;
+
+   /* Offset of the first free byte in the current slab. */
+   size_t offset;
+
+   /* Total usable size of the current slab. */
+   size_t size;
+};
+
 static void unlink_block(ralloc_header *info);
 static void unsafe_free(ralloc_header *info);
+static void *pool_carve(struct ralloc_pool *pool, ralloc_header *parent,
+                        size_t size);
 
 static ralloc_header *
 get_header(const void *ptr)
@@ -122,16 +177,28 @@ ralloc_size(const void *ctx, size_t size)
 void *
 rzalloc_size(const void *ctx, size_t size)
 {
-   void *block = calloc(1, size + sizeof(ralloc_header));
+   void *block;
    ralloc_header *info;
    ralloc_header *parent;
 
+   parent = ctx != NULL ? get_header(ctx) : NULL;
+
+   /* Inside a pool subtree, carve small nodes out of the pool's slabs
+    * instead of doing a malloc per node; they are reclaimed wholesale when
+    * the pool goes away.
+    */
+   if (parent != NULL && parent->pool != NULL &&
+       size <= RALLOC_POOL_MAX_ALLOC)
+      return pool_carve(parent->pool, parent, size);
+
+   block = calloc(1, size + sizeof(ralloc_header));
    if (unlikely(block == NULL))
       return NULL;
    info = (ralloc_header *) block;
-   parent = ctx != NULL ? get_header(ctx) : NULL;
 
    add_child(parent, info);
+   if (parent != NULL)
+      info->pool = parent->pool;
 
 #ifdef DEBUG
    info->canary = CANARY;
@@ -147,10 +214,26 @@ resize(void *ptr, size_t size)
    ralloc_header *child, *old, *info;
 
    old = get_header(ptr);
-   info = realloc(old, size + sizeof(ralloc_header));
 
-   if (info == NULL)
-      return NULL;
+   if (unlikely(old->embedded)) {
+      /* Blocks embedded in a pool slab can't grow in place.  Migrate the
+       * node to its own malloc block; the slab space it occupied is
+       * reclaimed along with the rest of the pool.
+       */
+      size_t copy = size < old->embedded_size ? size : old->embedded_size;
+
+      info = calloc(1, size + sizeof(ralloc_header));
+      if (info == NULL)
+         return NULL;
+
+      memcpy(info, old, sizeof(ralloc_header) + copy);
+      info->embedded = false;
+   } else {
+      info = realloc(old, size + sizeof(ralloc_header));
+
+      if (info == NULL)
+         return NULL;
+   }
 
    /* Update parent and sibling's links to the reallocated node. */
    if (info != old && info->parent != NULL) {
@@ -255,7 +338,24 @@ unsafe_free(ralloc_header *info)
    if (info->destructor != NULL)
       info->destructor(PTR_FROM_HEADER(info));
 
-   free(info);
+   /* If this node is a pool context, every node living in its slabs has
+    * just been torn down above, so the slabs can now be released in one
+    * quick pass instead of a free() per node.
+    */
+   if (unlikely(info->pool != NULL &&
+                (void *) info->pool == PTR_FROM_HEADER(info))) {
+      struct ralloc_pool_slab *slab = info->pool->slabs;
+
+      while (slab != NULL) {
+         struct ralloc_pool_slab *next = slab->next;
+         free(slab);
+         slab = next;
+      }
+   }
+
+   /* Pool-embedded blocks are reclaimed when their pool's slabs are. */
+   if (!info->embedded)
+      free(info);
 }
 
 void
@@ -301,6 +401,70 @@ ralloc_adopt(const void *new_ctx, void *old_ctx)
    old_info->child = NULL;
 }
 
+static void *
+pool_carve(struct ralloc_pool *pool, ralloc_header *parent, size_t size)
+{
+   ralloc_header *info;
+
+   /* Keep every returned pointer 16-byte aligned, like malloc would. */
+   size_t total = (size + sizeof(ralloc_header) + 15) & ~(size_t)15;
+
+   if (unlikely(pool->slabs == NULL || total > pool->size - pool->offset)) {
+      size_t slab_size = RALLOC_POOL_SLAB_SIZE;
+      struct ralloc_pool_slab *slab;
+
+      if (unlikely(total > slab_size))
+         slab_size = total;
+
+      slab = calloc(1, RALLOC_POOL_SLAB_PREFIX + slab_size);
+      if (unlikely(slab == NULL))
+         return NULL;
+
+      slab->next = pool->slabs;
+      pool->slabs = slab;
+      pool->offset = 0;
+      pool->size = slab_size;
+   }
+
+   info = (ralloc_header *) ((char *) pool->slabs +
+                             RALLOC_POOL_SLAB_PREFIX + pool->offset);
+   pool->offset += total;
+
+   /* The slab is zeroed, so all that needs filling in is the linkage.  The
+    * pool pointer is inherited so that allocations parented to this one are
+    * carved from the same slabs; teardown stays correct because the slabs
+    * outlive every node in the pool subtree (they are only released once
+    * the pool context itself is reached in unsafe_free()).
+    */
+   add_child(parent, info);
+   info->pool = pool;
+   info->embedded = true;
+   info->embedded_size = size;
+#ifdef DEBUG
+   info->canary = CANARY;
+#endif
+
+   return PTR_FROM_HEADER(info);
+}
+
+void *
+ralloc_pool_context(const void *ctx)
+{
+   struct ralloc_pool *pool = rzalloc(ctx, struct ralloc_pool);
+
+   if (likely(pool != NULL))
+      get_header(pool)->pool = pool;
+   return pool;
+}
+
+void *
+rzalloc_pool_size(void *pool_ctx, size_t size)
+{
+   struct ralloc_pool *pool = pool_ctx;
+
+   return pool_carve(pool, get_header(pool_ctx), size);
+}
+
 void *
 ralloc_parent(const void *ptr)
 {
@@ -518,3 +682,190 @@ ralloc_vasprintf_rewrite_tail(char **str, size_t *start, const char *fmt,
    *start += new_length;
    return true;
 }
+
+/***************************************************************************
+ * Linear allocator for short-lived allocations.
+ ***************************************************************************
+ *
+ * The allocator consists of a parent node (2K buffer), which requires
+ * a ralloc parent, and child nodes (allocations). Child nodes can't be freed
+ * directly, because the linear allocator doesn't allocate and free nodes
+ * separately. Instead, the parent is freed, which frees all children.
+ *
+ * The allocator uses a fixed-sized buffer with a monotonically increasing
+ * offset after each allocation. If the buffer is all used, another buffer
+ * is allocated, using the linear parent node as ralloc parent.
+ *
+ * The linear parent node is always the first buffer and keeps track of all
+ * other buffers.
+ */
+
+#define MIN_LINEAR_BUFSIZE 2048
+#define SUBALLOC_ALIGNMENT sizeof(uintptr_t)
+#define SUBALLOC_ALIGN(size) \
+   (((size) + SUBALLOC_ALIGNMENT - 1) & ~(SUBALLOC_ALIGNMENT - 1))
+#define LMAGIC 0x87b9c7d3
+
+#define LINEAR_PARENT_TO_HEADER(parent) \
+   ((linear_header *)((char *)(parent) - sizeof(linear_header)))
+
+struct linear_header {
+   unsigned magic;   /* for debugging */
+   unsigned offset;  /* points to the first unused byte in the buffer */
+   unsigned size;    /* size of the buffer */
+   void *ralloc_parent;          /* new buffers will use this */
+   struct linear_header *next;   /* next buffer if we have more */
+   struct linear_header *latest; /* the only buffer that has free space */
+};
+
+typedef struct linear_header linear_header;
+
+/* Allocate the linear buffer with its header. */
+static linear_header *
+create_linear_node(void *ralloc_ctx, unsigned min_size)
+{
+   linear_header *node;
+
+   min_size += sizeof(linear_header);
+
+   if (likely(min_size < MIN_LINEAR_BUFSIZE))
+      min_size = MIN_LINEAR_BUFSIZE;
+
+   node = ralloc_size(ralloc_ctx, min_size);
+   if (unlikely(!node))
+      return NULL;
+
+   node->magic = LMAGIC;
+   node->offset = sizeof(linear_header);
+   node->size = min_size;
+   node->ralloc_parent = ralloc_ctx;
+   node->next = NULL;
+   node->latest = node;
+   return node;
+}
+
+void *
+linear_alloc_child(void *parent, unsigned size)
+{
+   linear_header *first = parent;
+   linear_header *latest = first->latest;
+   linear_header *new_node;
+   unsigned full_size;
+   void *ptr;
+
+   assert(first->magic == LMAGIC);
+   assert(!latest->next);
+
+   size = SUBALLOC_ALIGN(size);
+   full_size = latest->offset + size;
+
+   if (unlikely(full_size > latest->size)) {
+      /* allocate a new node */
+      new_node = create_linear_node(latest->ralloc_parent, size);
+      if (unlikely(!new_node))
+         return NULL;
+
+      first->latest = new_node;
+      latest->next = new_node;
+      latest = new_node;
+      full_size = latest->offset + size;
+   }
+
+   ptr = (char*)latest + latest->offset;
+   latest->offset = full_size;
+   return ptr;
+}
+
+void *
+linear_alloc_parent(void *ralloc_ctx, unsigned size)
+{
+   linear_header *node;
+
+   if (unlikely(!ralloc_ctx))
+      return NULL;
+
+   size = SUBALLOC_ALIGN(size);
+
+   node = create_linear_node(ralloc_ctx, size);
+   if (unlikely(!node))
+      return NULL;
+
+   node->offset += size;
+   return (char*)node + sizeof(linear_header);
+}
+
+void *
+linear_zalloc_child(void *parent, unsigned size)
+{
+   void *ptr = linear_alloc_child(parent, size);
+
+   if (likely(ptr))
+      memset(ptr, 0, size);
+   return ptr;
+}
+
+void *
+linear_zalloc_parent(void *parent, unsigned size)
+{
+   void *ptr = linear_alloc_parent(parent, size);
+
+   if (likely(ptr))
+      memset(ptr, 0, size);
+   return ptr;
+}
+
+void
+linear_free_parent(void *ptr)
+{
+   linear_header *node;
+
+   if (unlikely(!ptr))
+      return;
+
+   node = LINEAR_PARENT_TO_HEADER(ptr);
+   assert(node->magic == LMAGIC);
+
+   while (node) {
+      void *ptr = node;
+
+      node = node->next;
+      ralloc_free(ptr);
+   }
+}
+
+void
+ralloc_steal_linear_parent(void *new_ralloc_ctx, void *ptr)
+{
+   linear_header *node;
+
+   if (unlikely(!ptr))
+      return;
+
+   node = LINEAR_PARENT_TO_HEADER(ptr);
+   assert(node->magic == LMAGIC);
+
+   while (node) {
+      ralloc_steal(new_ralloc_ctx, node);
+      node->ralloc_parent = new_ralloc_ctx;
+      node = node->next;
+   }
+}
+
+char *
+linear_strdup(void *parent, const char *str)
+{
+   unsigned n;
+   char *ptr;
+
+   if (unlikely(!str))
+      return NULL;
+
+   n = strlen(str);
+   ptr = linear_alloc_child(parent, n + 1);
+   if (unlikely(!ptr))
+      return NULL;
+
+   memcpy(ptr, str, n);
+   ptr[n] = '\0';
+   return ptr;
+}
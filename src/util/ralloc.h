@@ -107,6 +107,31 @@ void *ralloc_size(const void *ctx, size_t size) MALLOCLIKE;
  */
 void *rzalloc_size(const void *ctx, size_t size) MALLOCLIKE;
 
+/**
+ * Allocate a pool that memory can be bump-allocated from.
+ *
+ * A pool is an ordinary ralloc context, so it is freed along with its parent
+ * context (or explicitly with ralloc_free), taking all of its slabs with it.
+ * Small allocations made anywhere in the subtree below a pool are carved out
+ * of its slabs instead of malloc'd one node at a time, and the slabs are
+ * handed back to the heap in a single pass when the pool is freed.
+ */
+void *ralloc_pool_context(const void *ctx);
+
+/**
+ * Allocate zero-initialized memory carved out of a pool slab.
+ *
+ * The returned memory is a full-fledged ralloc allocation parented to the
+ * pool: it can be used as a context for further allocations (which are then
+ * carved from the same slabs) and freed individually, which releases its
+ * children but not the slab space it occupies - that is only reclaimed when
+ * the pool is.  Consecutive allocations are contiguous in memory.  Resizing
+ * a carved allocation migrates it to its own malloc block.  Note that since
+ * the storage belongs to the pool, a pool allocation must never be stolen to
+ * a context that outlives the pool.
+ */
+void *rzalloc_pool_size(void *pool_ctx, size_t size) MALLOCLIKE;
+
 /**
  * Resize a piece of ralloc-managed memory, preserving data.
  *
@@ -407,6 +432,71 @@ bool ralloc_asprintf_append (char **str, const char *fmt, ...)
 bool ralloc_vasprintf_append(char **str, const char *fmt, va_list args);
 /// @}
 
+/**
+ * \defgroup linear Linear (bump-pointer) allocator
+ *
+ * This is a fast allocator for objects that share the lifetime of a common
+ * ralloc parent and are never freed individually, such as the AST built by
+ * the GLSL parser.  Allocations are carved out of large buffers with a simple
+ * pointer bump, so there is no per-node header and no per-node free-list
+ * bookkeeping.  The buffers are themselves ralloc children of the given
+ * ralloc context, which means the whole linear context goes away
+ * automatically when that context is freed.
+ *
+ * Restrictions compared to ralloc:
+ * - Individual allocations cannot be resized or freed; only the whole
+ *   linear parent can be freed (explicitly with linear_free_parent, or
+ *   implicitly via the ralloc context).
+ * - No destructors are run, so only trivially-destructible objects may be
+ *   allocated from a linear context.
+ *
+ * \@{
+ */
+
+/**
+ * Create a new linear parent from \p ralloc_ctx and allocate \p size bytes
+ * from it.  \p size may be 0 to just create the parent.
+ *
+ * The returned pointer doubles as the handle passed to linear_alloc_child.
+ */
+void *linear_alloc_parent(void *ralloc_ctx, unsigned size);
+
+/**
+ * Allocate \p size bytes from the linear parent \p parent.
+ */
+void *linear_alloc_child(void *parent, unsigned size);
+
+/**
+ * Same as linear_alloc_parent, but the memory is zeroed.
+ */
+void *linear_zalloc_parent(void *ralloc_ctx, unsigned size);
+
+/**
+ * Same as linear_alloc_child, but the memory is zeroed.
+ */
+void *linear_zalloc_child(void *parent, unsigned size);
+
+/**
+ * Free the linear parent \p ptr and everything allocated from it.
+ *
+ * This is optional; the memory is also released when the ralloc context the
+ * parent was created from is freed.
+ */
+void linear_free_parent(void *ptr);
+
+/**
+ * Reparent the buffers of the linear parent \p ptr to \p new_ralloc_ctx,
+ * like ralloc_steal.
+ */
+void ralloc_steal_linear_parent(void *new_ralloc_ctx, void *ptr);
+
+/**
+ * Duplicate \p str into memory allocated from the linear parent \p parent.
+ */
+char *linear_strdup(void *parent, const char *str);
+
+/// @}
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
@@ -448,5 +538,35 @@ public:                                                                  \
       ralloc_free(p);                                                    \
    }
 
+/**
+ * Declare C++ new and delete operators which use the linear allocator.
+ *
+ * Objects allocated this way are freed only with their linear parent, so
+ * the class must be trivially destructible and operator delete is a no-op.
+ */
+#define DECLARE_LINEAR_ALLOC_CXX_OPERATORS_TEMPLATE(TYPE, ALLOC_FUNC)    \
+public:                                                                  \
+   static void* operator new(size_t size, void *mem_ctx)                 \
+   {                                                                     \
+      assert(HAS_TRIVIAL_DESTRUCTOR(TYPE));                              \
+      void *p = ALLOC_FUNC(mem_ctx, size);                               \
+      assert(p != NULL);                                                 \
+      return p;                                                          \
+   }                                                                     \
+                                                                         \
+   static void operator delete(void *p)                                  \
+   {                                                                     \
+      /* Linear allocations cannot be freed individually; the memory is  \
+       * released when the linear parent is freed.                       \
+       */                                                                \
+      (void) p;                                                          \
+   }
+
+#define DECLARE_LINEAR_ALLOC_CXX_OPERATORS(TYPE) \
+   DECLARE_LINEAR_ALLOC_CXX_OPERATORS_TEMPLATE(TYPE, linear_alloc_child)
+
+#define DECLARE_LINEAR_ZALLOC_CXX_OPERATORS(TYPE) \
+   DECLARE_LINEAR_ALLOC_CXX_OPERATORS_TEMPLATE(TYPE, linear_zalloc_child)
+
 
 #endif
@@ -292,9 +292,7 @@ ra_make_reg_conflicts_transitive(struct ra_regs *regs, unsigned int r)
 
    BITSET_FOREACH_SET(c, tmp, reg->conflicts, regs->count) {
       struct ra_reg *other = &regs->regs[c];
-      unsigned i;
-      for (i = 0; i < BITSET_WORDS(regs->count); i++)
-         other->conflicts[i] |= reg->conflicts[i];
+      __bitset_or(other->conflicts, reg->conflicts, BITSET_WORDS(regs->count));
    }
 }
 
@@ -457,6 +455,44 @@ ra_add_node_interference(struct ra_graph *g,
    }
 }
 
+/**
+ * Adds an interference between node n and every node whose bit is set in
+ * row, which covers the first count nodes of the graph.
+ *
+ * This is equivalent to calling ra_add_node_interference() once per set
+ * bit, but skips edges that are already present a whole word at a time.
+ * That matters for callers that mark many nodes as interfering with
+ * largely overlapping sets, such as the payload and MRF setup in the
+ * i965 backend.
+ */
+void
+ra_add_node_interference_row(struct ra_graph *g, unsigned int n,
+                             const BITSET_WORD *row, unsigned int count)
+{
+   unsigned int w;
+
+   assert(count <= g->count);
+
+   for (w = 0; w < BITSET_WORDS(count); w++) {
+      /* The self edge is always present in the adjacency bits, so it gets
+       * filtered out here along with the other existing edges.
+       */
+      BITSET_WORD new_bits = row[w] & ~g->nodes[n].adjacency[w];
+
+      while (new_bits) {
+         unsigned int n2 = w * BITSET_WORDBITS + (ffs(new_bits) - 1);
+
+         if (n2 >= count)
+            break;
+
+         new_bits &= new_bits - 1;
+
+         ra_add_node_adjacency(g, n, n2);
+         ra_add_node_adjacency(g, n2, n);
+      }
+   }
+}
+
 static bool
 pq_test(struct ra_graph *g, unsigned int n)
 {
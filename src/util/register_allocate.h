@@ -27,6 +27,7 @@
 
 #include <stdbool.h>
 
+#include "util/bitset.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -74,6 +75,8 @@ struct ra_graph *ra_alloc_interference_graph(struct ra_regs *regs,
 void ra_set_node_class(struct ra_graph *g, unsigned int n, unsigned int c);
 void ra_add_node_interference(struct ra_graph *g,
 			      unsigned int n1, unsigned int n2);
+void ra_add_node_interference_row(struct ra_graph *g, unsigned int n,
+				  const BITSET_WORD *row, unsigned int count);
 /** @} */
 
 /** @{ Graph-coloring register allocation */
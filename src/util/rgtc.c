@@ -28,12 +28,103 @@
  */
 
 #include <inttypes.h>
+#include <string.h>
 #include "macros.h"
+#include "u_queue.h"
 
 #include "rgtc.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define RGTC_DEBUG 0
 
+/* Whole images are split into bands of block rows and handed to a small
+ * process-wide queue.  The queue is created on first use and shared by all
+ * callers; if thread creation fails everything runs on the calling thread.
+ */
+#define RGTC_COMPRESS_MAX_JOBS 8
+#define RGTC_COMPRESS_NUM_THREADS 4
+/* below this many pixels the job setup outweighs the win */
+#define RGTC_COMPRESS_THREAD_THRESHOLD (128 * 1024)
+
+struct rgtc_compress_job {
+   void *dst;
+   const void *src;
+   unsigned dstRowStride;
+   unsigned dstBlockSize;
+   unsigned srcRowStride;
+   unsigned width;
+   unsigned y0, y1;
+   unsigned comps;
+   struct util_queue_fence fence;
+};
+
+static struct util_queue rgtc_compress_queue;
+static once_flag rgtc_compress_queue_once = ONCE_FLAG_INIT;
+
+static void
+rgtc_compress_queue_create(void)
+{
+   (void) util_queue_init(&rgtc_compress_queue, "rgtc_cmp",
+                          RGTC_COMPRESS_MAX_JOBS,
+                          RGTC_COMPRESS_NUM_THREADS, 0);
+}
+
+static void
+rgtc_parallel_compress(void *dst, unsigned dstRowStride, unsigned dstBlockSize,
+                       const void *src, unsigned srcRowStride,
+                       unsigned width, unsigned height, unsigned comps,
+                       util_queue_execute_func compress_rows)
+{
+   struct rgtc_compress_job jobs[RGTC_COMPRESS_MAX_JOBS];
+   unsigned block_rows = DIV_ROUND_UP(height, 4);
+   unsigned num_jobs = 1;
+   unsigned rows_per_job, i;
+
+   if ((uint64_t)width * height >= RGTC_COMPRESS_THREAD_THRESHOLD) {
+      call_once(&rgtc_compress_queue_once, rgtc_compress_queue_create);
+      if (util_queue_is_initialized(&rgtc_compress_queue)) {
+         num_jobs = rgtc_compress_queue.num_threads + 1;
+         if (num_jobs > block_rows)
+            num_jobs = block_rows;
+         if (num_jobs > RGTC_COMPRESS_MAX_JOBS)
+            num_jobs = RGTC_COMPRESS_MAX_JOBS;
+      }
+   }
+
+   rows_per_job = DIV_ROUND_UP(block_rows, num_jobs);
+
+   for (i = 0; i < num_jobs; i++) {
+      jobs[i].dst = dst;
+      jobs[i].src = src;
+      jobs[i].dstRowStride = dstRowStride;
+      jobs[i].dstBlockSize = dstBlockSize;
+      jobs[i].srcRowStride = srcRowStride;
+      jobs[i].width = width;
+      jobs[i].y0 = i * rows_per_job * 4;
+      jobs[i].y1 = (i + 1) * rows_per_job * 4;
+      if (jobs[i].y1 > height)
+         jobs[i].y1 = height;
+      jobs[i].comps = comps;
+   }
+
+   for (i = 1; i < num_jobs; i++) {
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(&rgtc_compress_queue, &jobs[i], &jobs[i].fence,
+                         compress_rows, NULL);
+   }
+
+   /* the calling thread compresses the first band itself */
+   compress_rows(&jobs[0], -1);
+
+   for (i = 1; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
+
 #define TAG(x) util_format_unsigned_##x
 
 #define TYPE unsigned char
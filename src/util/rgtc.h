@@ -36,4 +36,20 @@ void util_format_unsigned_encode_rgtc_ubyte(unsigned char *blkaddr, unsigned cha
 
 void util_format_signed_encode_rgtc_ubyte(signed char *blkaddr, signed char srccolors[4][4],
                                             int numxpixels, int numypixels);
+
+/* Compress a whole (channel of an) image.  dstRowStride is the distance in
+ * bytes between rows of blocks, dstBlockSize the distance between adjacent
+ * blocks (8 for RGTC1, 16 for the interleaved RGTC2 layout), srcRowStride is
+ * in pixels and comps the distance between adjacent source pixels.  Large
+ * images are split into bands and compressed by a shared worker queue.
+ */
+void util_format_unsigned_compress_rgtc_ubyte(unsigned char *dst, unsigned dstRowStride,
+                                              unsigned dstBlockSize,
+                                              const unsigned char *src, unsigned srcRowStride,
+                                              unsigned width, unsigned height, unsigned comps);
+
+void util_format_signed_compress_rgtc_ubyte(signed char *dst, unsigned dstRowStride,
+                                            unsigned dstBlockSize,
+                                            const signed char *src, unsigned srcRowStride,
+                                            unsigned width, unsigned height, unsigned comps);
 #endif /* _RGTC_H */
@@ -33,6 +33,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "macros.h"
@@ -84,6 +85,9 @@ static const struct {
    { 2147483648ul, 2362232233ul, 2362232231ul }
 };
 
+/* hash_sizes index whose size matches the inline small_table. */
+#define SMALL_SIZE_INDEX 2
+
 static int
 entry_is_free(struct set_entry *entry)
 {
@@ -114,21 +118,19 @@ _mesa_set_create(void *mem_ctx,
    if (ht == NULL)
       return NULL;
 
-   ht->size_index = 0;
+   assert(hash_sizes[SMALL_SIZE_INDEX].size == SET_SMALL_SIZE);
+
+   ht->size_index = SMALL_SIZE_INDEX;
    ht->size = hash_sizes[ht->size_index].size;
    ht->rehash = hash_sizes[ht->size_index].rehash;
    ht->max_entries = hash_sizes[ht->size_index].max_entries;
    ht->key_hash_function = key_hash_function;
    ht->key_equals_function = key_equals_function;
-   ht->table = rzalloc_array(ht, struct set_entry, ht->size);
+   ht->table = ht->small_table;
+   memset(ht->small_table, 0, sizeof(ht->small_table));
    ht->entries = 0;
    ht->deleted_entries = 0;
 
-   if (ht->table == NULL) {
-      ralloc_free(ht);
-      return NULL;
-   }
-
    return ht;
 }
 
@@ -151,7 +153,8 @@ _mesa_set_destroy(struct set *ht, void (*delete_function)(struct set_entry *entr
          delete_function(entry);
       }
    }
-   ralloc_free(ht->table);
+   if (ht->table != ht->small_table)
+      ralloc_free(ht->table);
    ralloc_free(ht);
 }
 
@@ -238,7 +241,8 @@ set_rehash(struct set *ht, unsigned new_size_index)
       }
    }
 
-   ralloc_free(old_ht.table);
+   if (old_ht.table != ht->small_table)
+      ralloc_free(old_ht.table);
 }
 
 /**
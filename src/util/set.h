@@ -40,6 +40,16 @@ struct set_entry {
    const void *key;
 };
 
+/**
+ * Number of table slots stored inline in the set itself.
+ *
+ * New sets point \c table at this inline storage, so creating a set costs a
+ * single allocation and small sets (up to 8 entries with this size) never
+ * allocate a separate table.  The table is promoted to a heap allocation by
+ * the first rehash that outgrows it.
+ */
+#define SET_SMALL_SIZE 13
+
 struct set {
    void *mem_ctx;
    struct set_entry *table;
@@ -51,6 +61,7 @@ struct set {
    uint32_t size_index;
    uint32_t entries;
    uint32_t deleted_entries;
+   struct set_entry small_table[SET_SMALL_SIZE];
 };
 
 struct set *
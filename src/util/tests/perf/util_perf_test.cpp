@@ -0,0 +1,271 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file util_perf_test.cpp
+ *
+ * Microbenchmarks for the util data structures the compilers lean on:
+ * hash_table, set, ralloc and bitset.  The workloads are shaped like what
+ * NIR and the backends actually do — pointer keys taken from ralloc'd
+ * nodes, tables the size of a big shader, insert/remove churn from
+ * iterated passes — so that a data-structure change can be measured
+ * instead of guessed at.
+ *
+ * Each case prints a ns/op figure on stdout.  The assertions only sanity
+ * check the workload; the numbers are the point.  This is built by
+ * `make check` but deliberately not run as part of the test suite — run
+ * ./util-perf by hand (ideally pinned to a core) when comparing changes.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "hash_table.h"
+#include "set.h"
+#include "ralloc.h"
+#include "bitset.h"
+
+/* Roughly the instruction count of a large shader: big enough to exceed
+ * the caches, small enough that a full benchmark run stays in the
+ * milliseconds.
+ */
+#define NUM_NODES 4096
+
+/* Repeat count used to stretch each measurement over enough operations
+ * that gettimeofday() resolution doesn't matter.
+ */
+#define NUM_ROUNDS 256
+
+static int64_t
+get_time_us(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000ll + tv.tv_usec;
+}
+
+static void
+report(const char *name, int64_t us, int64_t ops)
+{
+   printf("  %-36s %8.2f ns/op\n", name, us * 1000.0 / ops);
+}
+
+/* Consume a value the optimizer must not discard. */
+static volatile uintptr_t sink;
+
+/**
+ * Hand out node addresses with the distribution a compiler pass sees:
+ * mostly-sequential small ralloc'd objects of a few different sizes, not
+ * a neat array stride.
+ */
+static void **
+alloc_nodes(void *ctx, unsigned count)
+{
+   void **nodes = ralloc_array(ctx, void *, count);
+   for (unsigned i = 0; i < count; i++)
+      nodes[i] = ralloc_size(ctx, 32 + (i % 4) * 16);
+   return nodes;
+}
+
+TEST(hash_table_perf, pointer_insert)
+{
+   void *ctx = ralloc_context(NULL);
+   void **nodes = alloc_nodes(ctx, NUM_NODES);
+   int64_t start = get_time_us();
+
+   for (unsigned r = 0; r < NUM_ROUNDS; r++) {
+      struct hash_table *ht = _mesa_pointer_hash_table_create(NULL);
+      for (unsigned i = 0; i < NUM_NODES; i++)
+         _mesa_hash_table_insert(ht, nodes[i], nodes[i]);
+      ASSERT_EQ(_mesa_hash_table_num_entries(ht), NUM_NODES);
+      _mesa_hash_table_destroy(ht, NULL);
+   }
+
+   report("hash_table pointer insert", get_time_us() - start,
+          (int64_t)NUM_ROUNDS * NUM_NODES);
+   ralloc_free(ctx);
+}
+
+TEST(hash_table_perf, pointer_search)
+{
+   void *ctx = ralloc_context(NULL);
+   void **nodes = alloc_nodes(ctx, NUM_NODES);
+   struct hash_table *ht = _mesa_pointer_hash_table_create(NULL);
+
+   for (unsigned i = 0; i < NUM_NODES; i++)
+      _mesa_hash_table_insert(ht, nodes[i], nodes[i]);
+
+   /* Walk the keys in an order unrelated to insertion order, with one
+    * miss per eight lookups — about the hit rate of a remap table.
+    */
+   int64_t start = get_time_us();
+   for (unsigned r = 0; r < NUM_ROUNDS; r++) {
+      for (unsigned i = 0; i < NUM_NODES; i++) {
+         const void *key = (i % 8) == 7 ? nodes
+                                        : nodes[(i * 7919) % NUM_NODES];
+         struct hash_entry *entry = _mesa_hash_table_search(ht, key);
+         sink = (uintptr_t)entry;
+      }
+   }
+
+   report("hash_table pointer search", get_time_us() - start,
+          (int64_t)NUM_ROUNDS * NUM_NODES);
+   _mesa_hash_table_destroy(ht, NULL);
+   ralloc_free(ctx);
+}
+
+TEST(hash_table_perf, churn)
+{
+   void *ctx = ralloc_context(NULL);
+   void **nodes = alloc_nodes(ctx, NUM_NODES);
+   struct hash_table *ht = _mesa_pointer_hash_table_create(NULL);
+   int64_t start = get_time_us();
+
+   /* A sliding window of live entries, the way a value-numbering table
+    * behaves across iterated passes: every insert eventually pairs with
+    * a remove, so deleted-entry handling dominates.
+    */
+   for (unsigned r = 0; r < NUM_ROUNDS; r++) {
+      for (unsigned i = 0; i < NUM_NODES; i++) {
+         _mesa_hash_table_insert(ht, nodes[i], nodes[i]);
+         if (i >= 64) {
+            struct hash_entry *entry =
+               _mesa_hash_table_search(ht, nodes[i - 64]);
+            ASSERT_TRUE(entry != NULL);
+            _mesa_hash_table_remove(ht, entry);
+         }
+      }
+      _mesa_hash_table_clear(ht, NULL);
+   }
+
+   report("hash_table insert/remove churn", get_time_us() - start,
+          (int64_t)NUM_ROUNDS * NUM_NODES);
+   _mesa_hash_table_destroy(ht, NULL);
+   ralloc_free(ctx);
+}
+
+TEST(set_perf, visited_set)
+{
+   void *ctx = ralloc_context(NULL);
+   void **nodes = alloc_nodes(ctx, NUM_NODES);
+   int64_t start = get_time_us();
+
+   /* The visited-set pattern from use-def walks: every node is tested
+    * before it is added, so half the searches miss.
+    */
+   for (unsigned r = 0; r < NUM_ROUNDS; r++) {
+      struct set *set = _mesa_set_create(NULL, _mesa_hash_pointer,
+                                         _mesa_key_pointer_equal);
+      for (unsigned i = 0; i < NUM_NODES; i++) {
+         if (!_mesa_set_search(set, nodes[i]))
+            _mesa_set_add(set, nodes[i]);
+      }
+      for (unsigned i = 0; i < NUM_NODES; i++)
+         sink = (uintptr_t)_mesa_set_search(set, nodes[i]);
+      _mesa_set_destroy(set, NULL);
+   }
+
+   report("set visited-set add+search", get_time_us() - start,
+          (int64_t)NUM_ROUNDS * NUM_NODES * 2);
+   ralloc_free(ctx);
+}
+
+TEST(ralloc_perf, shader_lifetime)
+{
+   int64_t start = get_time_us();
+
+   /* One shader compile's allocation profile: thousands of small nodes
+    * parented to a single context, torn down all at once.
+    */
+   for (unsigned r = 0; r < NUM_ROUNDS; r++) {
+      void *ctx = ralloc_context(NULL);
+      for (unsigned i = 0; i < NUM_NODES; i++)
+         sink = (uintptr_t)ralloc_size(ctx, 32 + (i % 4) * 16);
+      ralloc_free(ctx);
+   }
+
+   report("ralloc small-node alloc+teardown", get_time_us() - start,
+          (int64_t)NUM_ROUNDS * NUM_NODES);
+}
+
+TEST(ralloc_perf, steal_reparent)
+{
+   int64_t start = get_time_us();
+
+   /* Clone-and-steal, as done when lowering passes rewrite a shader. */
+   for (unsigned r = 0; r < NUM_ROUNDS; r++) {
+      void *parent = ralloc_context(NULL);
+      void *scratch = ralloc_context(NULL);
+      for (unsigned i = 0; i < NUM_NODES; i++) {
+         void *node = ralloc_size(scratch, 48);
+         ralloc_steal(parent, node);
+      }
+      ralloc_free(scratch);
+      ralloc_free(parent);
+   }
+
+   report("ralloc steal to new parent", get_time_us() - start,
+          (int64_t)NUM_ROUNDS * NUM_NODES);
+}
+
+#define NUM_BLOCKS 64
+#define NUM_DEFS 1024
+
+TEST(bitset_perf, liveness_dataflow)
+{
+   static BITSET_DECLARE(live_in[NUM_BLOCKS], NUM_DEFS);
+   static BITSET_DECLARE(live_out[NUM_BLOCKS], NUM_DEFS);
+   unsigned set_bits = 0;
+
+   for (unsigned b = 0; b < NUM_BLOCKS; b++) {
+      BITSET_ZERO(live_in[b]);
+      BITSET_ZERO(live_out[b]);
+      for (unsigned i = b; i < NUM_DEFS; i += NUM_BLOCKS)
+         BITSET_SET(live_in[b], i);
+   }
+
+   int64_t start = get_time_us();
+
+   /* The inner loop of a liveness solve: union each block's successor
+    * sets into live_out, then test individual bits the way a register
+    * allocator probes interference.
+    */
+   for (unsigned r = 0; r < NUM_ROUNDS * 16; r++) {
+      for (unsigned b = 0; b < NUM_BLOCKS; b++) {
+         const unsigned succ = (b + 1) % NUM_BLOCKS;
+         for (unsigned w = 0; w < BITSET_WORDS(NUM_DEFS); w++)
+            live_out[b][w] |= live_in[succ][w];
+      }
+      set_bits = 0;
+      for (unsigned i = 0; i < NUM_DEFS; i++)
+         set_bits += BITSET_TEST(live_out[0], i) != 0;
+      sink = set_bits;
+   }
+
+   ASSERT_EQ(set_bits, NUM_DEFS / NUM_BLOCKS);
+   report("bitset dataflow union+test", get_time_us() - start,
+          (int64_t)NUM_ROUNDS * 16 * NUM_BLOCKS * BITSET_WORDS(NUM_DEFS));
+}
@@ -73,6 +73,91 @@ static void TAG(write_rgtc_encoded_channel)(TYPE *blkaddr,
    *blkaddr++ = (alphaenc[13] >> 1) | (alphaenc[14] << 2) | (alphaenc[15] << 5);
 }
 
+#ifdef __SSE2__
+/* SSE2 fast paths for full 4x4 blocks.  The helpers are kept out of line:
+ * gcc miscompiles the scalar index stores in the partial-block path when the
+ * vector code is inlined next to them.
+ */
+
+/* Min/max scan over all 16 texels at once.  XOR-biasing moves the values
+ * into the unsigned domain for both instantiations, so T_MIN maps to 0x00
+ * and T_MAX to 0xff; texels at the extremes are masked to the identity of
+ * the min/max reduction, which also makes an all-extremes block fall back to
+ * the T_MAX/T_MIN init values just like the scalar loop.
+ */
+static ATTRIBUTE_NOINLINE void
+TAG(encode_minmax_sse2)(TYPE srccolors[4][4], TYPE alphabase[2],
+                        int *alphaabsmin, int *alphaabsmax)
+{
+   const __m128i ubias = _mm_set1_epi8((char)(T_MIN == 0 ? 0x00 : 0x80));
+   const __m128i ublock =
+      _mm_xor_si128(_mm_loadu_si128((const __m128i *)srccolors), ubias);
+   const __m128i is_min = _mm_cmpeq_epi8(ublock, _mm_setzero_si128());
+   const __m128i is_max = _mm_cmpeq_epi8(ublock, _mm_set1_epi8((char)0xff));
+   __m128i lo = _mm_or_si128(ublock, is_min);
+   __m128i hi = _mm_andnot_si128(is_max, ublock);
+
+   lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 8));
+   hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 8));
+   lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4));
+   hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+   lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 2));
+   hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 2));
+   lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 1));
+   hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 1));
+
+   *alphaabsmin = _mm_movemask_epi8(is_min) != 0;
+   *alphaabsmax = _mm_movemask_epi8(is_max) != 0;
+   alphabase[0] = (TYPE)((_mm_cvtsi128_si32(lo) & 0xff) ^
+                         (T_MIN == 0 ? 0x00 : 0x80));
+   alphabase[1] = (TYPE)((_mm_cvtsi128_si32(hi) & 0xff) ^
+                         (T_MIN == 0 ? 0x00 : 0x80));
+}
+
+/* Encoding-1 index selection for a full block: counting how many cut values
+ * each texel exceeds gives the same code as the scalar compare cascade (the
+ * cuts are monotonically decreasing): 7 cuts exceeded is code 0, none is
+ * code 1, anything in between is code 8 - count.  The compares run on all 16
+ * texels at once, XOR-biased into the signed domain for _mm_cmpgt_epi8.
+ */
+static ATTRIBUTE_NOINLINE unsigned int
+TAG(encode_enc1_sse2)(TYPE srccolors[4][4],
+                      const TYPE acutValues[7],
+                      const TYPE alphause[2],
+                      TYPE alphaenc[16])
+{
+   const __m128i sbias = _mm_set1_epi8((char)(T_MIN == 0 ? 0x80 : 0x00));
+   const __m128i sblock =
+      _mm_xor_si128(_mm_loadu_si128((const __m128i *)srccolors), sbias);
+   __m128i count = _mm_setzero_si128();
+   unsigned char counts[16];
+   unsigned int error = 0;
+   int palette[8];
+   int k;
+
+   for (k = 0; k < 7; k++) {
+      const __m128i cut =
+         _mm_set1_epi8((char)((unsigned char)acutValues[k] ^
+                              (T_MIN == 0 ? 0x80 : 0x00)));
+      count = _mm_sub_epi8(count, _mm_cmpgt_epi8(sblock, cut));
+   }
+   _mm_storeu_si128((__m128i *)counts, count);
+
+   palette[0] = alphause[1];
+   palette[1] = alphause[0];
+   for (k = 2; k < 8; k++)
+      palette[k] = (alphause[1] * (8 - k) + alphause[0] * (k - 1)) / 7;
+
+   for (k = 0; k < 16; k++) {
+      int code = counts[k] == 7 ? 0 : counts[k] == 0 ? 1 : 8 - counts[k];
+      int dist = srccolors[k / 4][k % 4] - palette[code];
+      alphaenc[k] = code;
+      error += dist * dist;
+   }
+   return error;
+}
+#endif
+
 void TAG(encode_rgtc_ubyte)(TYPE *blkaddr, TYPE srccolors[4][4],
                             int numxpixels, int numypixels)
 {
@@ -84,8 +169,25 @@ void TAG(encode_rgtc_ubyte)(TYPE *blkaddr, TYPE srccolors[4][4],
    int alphaabsmin = 0, alphaabsmax = 0;
    short alphadist;
 
+   /* For partial blocks the encoding loops below leave the indices of the
+    * texels outside the block unwritten, but the packing shifts their high
+    * bits into neighbouring texels' codes, so they must not contain stack
+    * garbage.
+    */
+   if (numxpixels < 4 || numypixels < 4) {
+      memset(alphaenc1, 0, sizeof(alphaenc1));
+      memset(alphaenc2, 0, sizeof(alphaenc2));
+      memset(alphaenc3, 0, sizeof(alphaenc3));
+   }
+
    /* find lowest and highest alpha value in block, alphabase[0] lowest, alphabase[1] highest */
    alphabase[0] = T_MAX; alphabase[1] = T_MIN;
+#ifdef __SSE2__
+   if (numxpixels == 4 && numypixels == 4)
+      TAG(encode_minmax_sse2)(srccolors, alphabase,
+                              &alphaabsmin, &alphaabsmax);
+   else
+#endif
    for (j = 0; j < numypixels; j++) {
       for (i = 0; i < numxpixels; i++) {
 	 if (srccolors[j][i] == T_MIN)
@@ -136,6 +238,12 @@ void TAG(encode_rgtc_ubyte)(TYPE *blkaddr, TYPE srccolors[4][4],
       acutValues[aindex] = (alphause[0] * (2*aindex + 1) + alphause[1] * (14 - (2*aindex + 1))) / 14;
    }
 
+#ifdef __SSE2__
+   if (numxpixels == 4 && numypixels == 4)
+      alphablockerror1 = TAG(encode_enc1_sse2)(srccolors, acutValues,
+                                               alphause, alphaenc1);
+   else
+#endif
    for (j = 0; j < numypixels; j++) {
       for (i = 0; i < numxpixels; i++) {
          /* maybe it's overkill to have the most complicated calculation just for the error
@@ -416,3 +524,40 @@ void TAG(encode_rgtc_ubyte)(TYPE *blkaddr, TYPE srccolors[4][4],
       TAG(write_rgtc_encoded_channel)( blkaddr, (TYPE)alphatest[0], (TYPE)alphatest[1], alphaenc3 );
    }
 }
+
+static void TAG(compress_rgtc_rows)(void *data, int thread_index)
+{
+   const struct rgtc_compress_job *job = data;
+   unsigned x, y, xi, yi;
+
+   for (y = job->y0; y < job->y1; y += 4) {
+      TYPE *blkaddr = (TYPE *)((unsigned char *)job->dst +
+                               (y / 4) * job->dstRowStride);
+      const unsigned numypixels = job->y1 - y < 4 ? job->y1 - y : 4;
+
+      for (x = 0; x < job->width; x += 4) {
+         const unsigned numxpixels = job->width - x < 4 ? job->width - x : 4;
+         const TYPE *srcaddr = (const TYPE *)job->src +
+                               (y * job->srcRowStride + x) * job->comps;
+         TYPE srcpixels[4][4];
+
+         for (yi = 0; yi < numypixels; yi++) {
+            for (xi = 0; xi < numxpixels; xi++) {
+               srcpixels[yi][xi] =
+                  srcaddr[(yi * job->srcRowStride + xi) * job->comps];
+            }
+         }
+         TAG(encode_rgtc_ubyte)(blkaddr, srcpixels, numxpixels, numypixels);
+         blkaddr += job->dstBlockSize;
+      }
+   }
+}
+
+void TAG(compress_rgtc_ubyte)(TYPE *dst, unsigned dstRowStride,
+                              unsigned dstBlockSize,
+                              const TYPE *src, unsigned srcRowStride,
+                              unsigned width, unsigned height, unsigned comps)
+{
+   rgtc_parallel_compress(dst, dstRowStride, dstBlockSize, src, srcRowStride,
+                          width, height, comps, TAG(compress_rgtc_rows));
+}
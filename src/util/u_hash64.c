@@ -0,0 +1,186 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "u_hash64.h"
+
+/* XXH64 primes */
+#define PRIME64_1 11400714785074694791ULL
+#define PRIME64_2 14029467366897019727ULL
+#define PRIME64_3 1609587929392839161ULL
+#define PRIME64_4 9650029242287828579ULL
+#define PRIME64_5 2870177450012600261ULL
+
+static inline uint64_t
+rotl64(uint64_t x, unsigned r)
+{
+   return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+read64(const uint8_t *p)
+{
+   uint64_t v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static inline uint32_t
+read32(const uint8_t *p)
+{
+   uint32_t v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static inline uint64_t
+hash64_round(uint64_t acc, uint64_t input)
+{
+   acc += input * PRIME64_2;
+   acc = rotl64(acc, 31);
+   acc *= PRIME64_1;
+   return acc;
+}
+
+static inline uint64_t
+hash64_merge_round(uint64_t acc, uint64_t val)
+{
+   val = hash64_round(0, val);
+   acc ^= val;
+   acc = acc * PRIME64_1 + PRIME64_4;
+   return acc;
+}
+
+void
+util_hash64_init(struct util_hash64_state *state, uint64_t seed)
+{
+   state->v1 = seed + PRIME64_1 + PRIME64_2;
+   state->v2 = seed + PRIME64_2;
+   state->v3 = seed;
+   state->v4 = seed - PRIME64_1;
+   state->total_len = 0;
+   state->buffered = 0;
+   state->seed = seed;
+}
+
+/* Consume one aligned 32-byte stripe. */
+static void
+hash64_stripe(struct util_hash64_state *state, const uint8_t *p)
+{
+   state->v1 = hash64_round(state->v1, read64(p + 0));
+   state->v2 = hash64_round(state->v2, read64(p + 8));
+   state->v3 = hash64_round(state->v3, read64(p + 16));
+   state->v4 = hash64_round(state->v4, read64(p + 24));
+}
+
+void
+util_hash64_update(struct util_hash64_state *state,
+                   const void *data, size_t size)
+{
+   const uint8_t *p = data;
+   const uint8_t *end = p + size;
+
+   state->total_len += size;
+
+   if (state->buffered + size < sizeof(state->buffer)) {
+      /* Not enough for a full stripe yet. */
+      memcpy(state->buffer + state->buffered, p, size);
+      state->buffered += size;
+      return;
+   }
+
+   if (state->buffered) {
+      unsigned fill = sizeof(state->buffer) - state->buffered;
+      memcpy(state->buffer + state->buffered, p, fill);
+      hash64_stripe(state, state->buffer);
+      state->buffered = 0;
+      p += fill;
+   }
+
+   while (p + sizeof(state->buffer) <= end) {
+      hash64_stripe(state, p);
+      p += sizeof(state->buffer);
+   }
+
+   state->buffered = end - p;
+   memcpy(state->buffer, p, state->buffered);
+}
+
+uint64_t
+util_hash64_final(struct util_hash64_state *state)
+{
+   const uint8_t *p = state->buffer;
+   const uint8_t *end = p + state->buffered;
+   uint64_t h;
+
+   if (state->total_len >= sizeof(state->buffer)) {
+      h = rotl64(state->v1, 1) + rotl64(state->v2, 7) +
+          rotl64(state->v3, 12) + rotl64(state->v4, 18);
+      h = hash64_merge_round(h, state->v1);
+      h = hash64_merge_round(h, state->v2);
+      h = hash64_merge_round(h, state->v3);
+      h = hash64_merge_round(h, state->v4);
+   } else {
+      h = state->seed + PRIME64_5;
+   }
+
+   h += state->total_len;
+
+   while (p + 8 <= end) {
+      h ^= hash64_round(0, read64(p));
+      h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+      p += 8;
+   }
+
+   if (p + 4 <= end) {
+      h ^= (uint64_t)read32(p) * PRIME64_1;
+      h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+      p += 4;
+   }
+
+   while (p < end) {
+      h ^= (*p) * PRIME64_5;
+      h = rotl64(h, 11) * PRIME64_1;
+      p++;
+   }
+
+   /* final avalanche */
+   h ^= h >> 33;
+   h *= PRIME64_2;
+   h ^= h >> 29;
+   h *= PRIME64_3;
+   h ^= h >> 32;
+   return h;
+}
+
+uint64_t
+util_hash64(const void *data, size_t size, uint64_t seed)
+{
+   struct util_hash64_state state;
+
+   util_hash64_init(&state, seed);
+   util_hash64_update(&state, data, size);
+   return util_hash64_final(&state);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file u_hash64.h
+ *
+ * Fast non-cryptographic 64-bit hash, implementing the XXH64 algorithm by
+ * Yann Collet.  Unlike mesa-sha1, this is meant for in-memory cache keys
+ * and deduplication, where collisions merely cost an extra full compare;
+ * it hashes large blobs an order of magnitude faster than SHA-1.
+ *
+ * Both a one-shot and a streaming interface are provided, so callers can
+ * hash data that isn't contiguous in memory without assembling it first.
+ */
+
+#ifndef U_HASH64_H
+#define U_HASH64_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct util_hash64_state {
+   uint64_t v1, v2, v3, v4;
+   uint64_t total_len;
+   uint8_t buffer[32];
+   unsigned buffered;
+   uint64_t seed;
+};
+
+void util_hash64_init(struct util_hash64_state *state, uint64_t seed);
+void util_hash64_update(struct util_hash64_state *state,
+                        const void *data, size_t size);
+uint64_t util_hash64_final(struct util_hash64_state *state);
+
+uint64_t util_hash64(const void *data, size_t size, uint64_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_HASH64_H */
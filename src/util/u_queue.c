@@ -0,0 +1,328 @@
+/*
+ * Copyright © 2016 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+#include "u_queue.h"
+#include "u_atomic.h"
+
+#if UTIL_FUTEX_SUPPORTED
+
+/* The only writers are the queue (0 -> 1 on reset, non-zero -> 0 on
+ * signal) and sleeping waiters (1 -> 2), so plain compare-and-swaps are
+ * enough to keep the three states consistent.
+ */
+static void
+util_queue_fence_signal(struct util_queue_fence *fence)
+{
+   uint32_t val = p_atomic_cmpxchg(&fence->val, 1, 0);
+
+   assert(val == 1 || val == 2);
+
+   if (val == 2) {
+      p_atomic_cmpxchg(&fence->val, 2, 0);
+      futex_wake(&fence->val, INT_MAX);
+   }
+}
+
+static void
+util_queue_fence_reset(struct util_queue_fence *fence)
+{
+   uint32_t val = p_atomic_cmpxchg(&fence->val, 0, 1);
+   assert(val == 0);
+   (void) val;
+}
+
+void
+util_queue_fence_wait(struct util_queue_fence *fence)
+{
+   while (1) {
+      uint32_t val = fence->val;
+
+      switch (val) {
+      case 0:
+         return;
+      case 1:
+         /* Announce that somebody is about to sleep on the fence. */
+         val = p_atomic_cmpxchg(&fence->val, 1, 2);
+         if (val == 0)
+            return;
+         break;
+      }
+
+      /* The kernel rechecks the value, so a concurrent signal just makes
+       * this return immediately.
+       */
+      futex_wait(&fence->val, 2);
+   }
+}
+
+#else /* !UTIL_FUTEX_SUPPORTED */
+
+static void
+util_queue_fence_signal(struct util_queue_fence *fence)
+{
+   mtx_lock(&fence->mutex);
+   fence->signalled = true;
+   cnd_broadcast(&fence->cond);
+   mtx_unlock(&fence->mutex);
+}
+
+static void
+util_queue_fence_reset(struct util_queue_fence *fence)
+{
+   assert(fence->signalled);
+   fence->signalled = false;
+}
+
+void
+util_queue_fence_wait(struct util_queue_fence *fence)
+{
+   mtx_lock(&fence->mutex);
+   while (!fence->signalled)
+      cnd_wait(&fence->cond, &fence->mutex);
+   mtx_unlock(&fence->mutex);
+}
+
+void
+util_queue_fence_init(struct util_queue_fence *fence)
+{
+   memset(fence, 0, sizeof(*fence));
+   (void) mtx_init(&fence->mutex, mtx_plain);
+   cnd_init(&fence->cond);
+   fence->signalled = true;
+}
+
+void
+util_queue_fence_destroy(struct util_queue_fence *fence)
+{
+   assert(fence->signalled);
+   cnd_destroy(&fence->cond);
+   mtx_destroy(&fence->mutex);
+}
+
+#endif /* !UTIL_FUTEX_SUPPORTED */
+
+struct thread_input {
+   struct util_queue *queue;
+   int thread_index;
+};
+
+static int
+util_queue_thread_func(void *input)
+{
+   struct util_queue *queue = ((struct thread_input *)input)->queue;
+   int thread_index = ((struct thread_input *)input)->thread_index;
+
+   free(input);
+
+#if defined(__linux__)
+   if (queue->flags & UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY) {
+      /* The nice() value is per-thread on Linux, so SCHED_IDLE only
+       * affects the workers.
+       */
+      struct sched_param sched_param = {0};
+      pthread_setschedparam(pthread_self(), SCHED_IDLE, &sched_param);
+   }
+
+   if (queue->flags & UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY) {
+      /* Don't inherit the parent thread's affinity mask. */
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      for (unsigned i = 0; i < CPU_SETSIZE; i++)
+         CPU_SET(i, &cpuset);
+      pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+   }
+#endif
+
+   while (1) {
+      struct util_queue_job job;
+
+      mtx_lock(&queue->lock);
+      assert(queue->num_queued >= 0 && queue->num_queued <= queue->max_jobs);
+
+      /* wait if the queue is empty */
+      while (!queue->kill_threads && queue->num_queued == 0)
+         cnd_wait(&queue->has_queued_cond, &queue->lock);
+
+      if (queue->kill_threads) {
+         mtx_unlock(&queue->lock);
+         break;
+      }
+
+      job = queue->jobs[queue->read_idx];
+      memset(&queue->jobs[queue->read_idx], 0, sizeof(struct util_queue_job));
+      queue->read_idx = (queue->read_idx + 1) % queue->max_jobs;
+
+      queue->num_queued--;
+      cnd_signal(&queue->has_space_cond);
+      mtx_unlock(&queue->lock);
+
+      if (job.job) {
+         job.execute(job.job, thread_index);
+         util_queue_fence_signal(job.fence);
+         if (job.cleanup)
+            job.cleanup(job.job, thread_index);
+      }
+   }
+
+   /* signal remaining jobs before terminating */
+   mtx_lock(&queue->lock);
+   while (queue->num_queued) {
+      util_queue_fence_signal(queue->jobs[queue->read_idx].fence);
+      queue->read_idx = (queue->read_idx + 1) % queue->max_jobs;
+      queue->num_queued--;
+   }
+   mtx_unlock(&queue->lock);
+   return 0;
+}
+
+bool
+util_queue_init(struct util_queue *queue,
+                const char *name,
+                unsigned max_jobs,
+                unsigned num_threads,
+                unsigned flags)
+{
+   unsigned i;
+
+   memset(queue, 0, sizeof(*queue));
+   queue->name = name;
+   queue->flags = flags;
+   queue->max_jobs = max_jobs;
+
+   queue->jobs = (struct util_queue_job *)
+                 calloc(max_jobs, sizeof(struct util_queue_job));
+   if (!queue->jobs)
+      goto fail;
+
+   (void) mtx_init(&queue->lock, mtx_plain);
+   cnd_init(&queue->has_queued_cond);
+   cnd_init(&queue->has_space_cond);
+
+   queue->threads = (thrd_t *) calloc(num_threads, sizeof(thrd_t));
+   if (!queue->threads)
+      goto fail;
+
+   /* start threads */
+   for (i = 0; i < num_threads; i++) {
+      struct thread_input *input =
+         (struct thread_input *) malloc(sizeof(struct thread_input));
+      if (!input)
+         break;
+      input->queue = queue;
+      input->thread_index = i;
+
+      if (thrd_create(&queue->threads[i], util_queue_thread_func,
+                      input) != thrd_success) {
+         free(input);
+         break;
+      }
+   }
+   queue->num_threads = i;
+
+   if (queue->num_threads == 0)
+      goto fail;
+
+   return true;
+
+fail:
+   free(queue->threads);
+   if (queue->jobs) {
+      cnd_destroy(&queue->has_space_cond);
+      cnd_destroy(&queue->has_queued_cond);
+      mtx_destroy(&queue->lock);
+      free(queue->jobs);
+   }
+   /* also util_queue_is_initialized can be used to check for success */
+   memset(queue, 0, sizeof(*queue));
+   return false;
+}
+
+static void
+util_queue_killall_and_wait(struct util_queue *queue)
+{
+   unsigned i;
+
+   /* Signal all threads to terminate. */
+   mtx_lock(&queue->lock);
+   queue->kill_threads = true;
+   cnd_broadcast(&queue->has_queued_cond);
+   mtx_unlock(&queue->lock);
+
+   for (i = 0; i < queue->num_threads; i++)
+      thrd_join(queue->threads[i], NULL);
+}
+
+void
+util_queue_destroy(struct util_queue *queue)
+{
+   util_queue_killall_and_wait(queue);
+
+   cnd_destroy(&queue->has_space_cond);
+   cnd_destroy(&queue->has_queued_cond);
+   mtx_destroy(&queue->lock);
+   free(queue->jobs);
+   free(queue->threads);
+   memset(queue, 0, sizeof(*queue));
+}
+
+void
+util_queue_add_job(struct util_queue *queue,
+                   void *job,
+                   struct util_queue_fence *fence,
+                   util_queue_execute_func execute,
+                   util_queue_execute_func cleanup)
+{
+   struct util_queue_job *ptr;
+
+   util_queue_fence_reset(fence);
+
+   mtx_lock(&queue->lock);
+   assert(!queue->kill_threads);
+   assert(queue->num_queued >= 0 && queue->num_queued <= queue->max_jobs);
+
+   /* if the queue is full, wait until there is space */
+   while (queue->num_queued == queue->max_jobs)
+      cnd_wait(&queue->has_space_cond, &queue->lock);
+
+   ptr = &queue->jobs[queue->write_idx];
+   assert(ptr->job == NULL);
+   ptr->job = job;
+   ptr->fence = fence;
+   ptr->execute = execute;
+   ptr->cleanup = cleanup;
+   queue->write_idx = (queue->write_idx + 1) % queue->max_jobs;
+
+   queue->num_queued++;
+   cnd_signal(&queue->has_queued_cond);
+   mtx_unlock(&queue->lock);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2016 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file u_queue.h
+ *
+ * Job queue with execution in a separate thread.
+ *
+ * Jobs can be added from any thread.  After that, the wait call can be used
+ * to wait for the completion of a job.
+ */
+
+#ifndef U_QUEUE_H
+#define U_QUEUE_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "c11/threads.h"
+#include "util/futex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Run the worker threads at the lowest scheduling priority, so that
+ * background work (shader compilation, ...) doesn't steal time from the
+ * application's own threads.
+ */
+#define UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY     (1 << 0)
+
+/* Reset the worker threads' CPU affinity to all cores.  Some games pin
+ * their threads to specific cores and the workers would inherit that mask,
+ * ending up fighting over a single core.
+ */
+#define UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY (1 << 1)
+
+struct util_queue;
+
+typedef void (*util_queue_execute_func)(void *job, int thread_index);
+
+#if UTIL_FUTEX_SUPPORTED
+/* The fence is a single futex word with three states: 0 = signalled,
+ * 1 = unsignalled, 2 = unsignalled with waiters sleeping in the kernel.
+ * Signalling an uncontended fence is a single atomic; no kernel calls,
+ * no mutex or condition variable to initialize and destroy.
+ */
+struct util_queue_fence {
+   uint32_t val;
+};
+
+static inline void
+util_queue_fence_init(struct util_queue_fence *fence)
+{
+   fence->val = 0;
+}
+
+static inline void
+util_queue_fence_destroy(struct util_queue_fence *fence)
+{
+   assert(fence->val == 0);
+   (void) fence;
+}
+
+static inline bool
+util_queue_fence_is_signalled(struct util_queue_fence *fence)
+{
+   return fence->val == 0;
+}
+#else
+struct util_queue_fence {
+   mtx_t mutex;
+   cnd_t cond;
+   bool signalled;
+};
+
+void util_queue_fence_init(struct util_queue_fence *fence);
+void util_queue_fence_destroy(struct util_queue_fence *fence);
+
+static inline bool
+util_queue_fence_is_signalled(struct util_queue_fence *fence)
+{
+   return fence->signalled;
+}
+#endif
+
+struct util_queue_job {
+   void *job;
+   struct util_queue_fence *fence;
+   util_queue_execute_func execute;
+   util_queue_execute_func cleanup;
+};
+
+/* Put this into your context. */
+struct util_queue {
+   const char *name;
+   mtx_t lock;
+   cnd_t has_queued_cond;
+   cnd_t has_space_cond;
+   thrd_t *threads;
+   unsigned num_threads;
+   unsigned flags;
+   bool kill_threads;
+   int max_jobs;
+   int write_idx, read_idx; /* ring buffer pointers */
+   int num_queued;
+   struct util_queue_job *jobs;
+};
+
+bool util_queue_init(struct util_queue *queue,
+                     const char *name,
+                     unsigned max_jobs,
+                     unsigned num_threads,
+                     unsigned flags);
+void util_queue_destroy(struct util_queue *queue);
+
+/* optional cleanup callback is called after fence is signalled: */
+void util_queue_add_job(struct util_queue *queue,
+                        void *job,
+                        struct util_queue_fence *fence,
+                        util_queue_execute_func execute,
+                        util_queue_execute_func cleanup);
+
+void util_queue_fence_wait(struct util_queue_fence *fence);
+
+/* util_queue_init can fail (e.g. on thread creation); callers are expected
+ * to fall back to executing jobs directly in that case.
+ */
+static inline bool
+util_queue_is_initialized(struct util_queue *queue)
+{
+   return queue->threads != NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file u_startup_profile.h
+ *
+ * Cold-start phase timing, enabled with MESA_STARTUP_PROFILE=1.
+ *
+ * Startup spans several libraries (the loader lives in libGL/libEGL, the
+ * screen and context init in the driver), so instead of collecting phases
+ * in one table this stamps each phase to stderr with wall-clock
+ * timestamps; the lines from all libraries interleave into one
+ * chronological report:
+ *
+ *    MESA-STARTUP: phase=loader_get_driver_for_fd start_us=... dur_us=...
+ *
+ * Header-only so the loader can use it without growing a library
+ * dependency.  Everything no-ops unless the environment variable is set.
+ */
+
+#ifndef U_STARTUP_PROFILE_H
+#define U_STARTUP_PROFILE_H
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline int
+u_startup_profile_enabled(void)
+{
+   static int enabled = -1;
+
+   if (enabled < 0) {
+      const char *env = getenv("MESA_STARTUP_PROFILE");
+      enabled = env != NULL && atoi(env) != 0;
+   }
+
+   return enabled;
+}
+
+/**
+ * Current wall-clock time in microseconds since the epoch.  Absolute so
+ * that phases reported from different libraries sort into one timeline.
+ */
+static inline int64_t
+u_startup_profile_now(void)
+{
+#ifndef _WIN32
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000ll + tv.tv_usec;
+#else
+   return 0;
+#endif
+}
+
+/**
+ * Mark the start of a phase.  Returns 0 (and makes the matching _end a
+ * no-op) when profiling is disabled.
+ */
+static inline int64_t
+u_startup_profile_begin(void)
+{
+   if (!u_startup_profile_enabled())
+      return 0;
+
+   return u_startup_profile_now();
+}
+
+static inline void
+u_startup_profile_end(const char *phase, int64_t start)
+{
+   if (start == 0)
+      return;
+
+   fprintf(stderr, "MESA-STARTUP: phase=%s start_us=%" PRId64
+           " dur_us=%" PRId64 "\n",
+           phase, start, u_startup_profile_now() - start);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_STARTUP_PROFILE_H */